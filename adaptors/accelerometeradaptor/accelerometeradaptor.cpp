@@ -41,7 +41,7 @@
 AccelerometerAdaptor::AccelerometerAdaptor(const QString& id) :
     InputDevAdaptor(id, 1)
 {
-    accelerometerBuffer_ = new DeviceAdaptorRingBuffer<OrientationData>(1);
+    accelerometerBuffer_ = new DeviceAdaptorRingBuffer<OrientationData>(bufferCapacity(64));
     setAdaptedSensor("accelerometer", "Internal accelerometer coordinates", accelerometerBuffer_);
     setDescription("Input device accelerometer adaptor (lis302d)");
 }
@@ -78,6 +78,11 @@ void AccelerometerAdaptor::interpretSync(int src, struct input_event *ev)
     commitOutput(ev);
 }
 
+void AccelerometerAdaptor::wakeUpReaders()
+{
+    accelerometerBuffer_->wakeUpReaders();
+}
+
 void AccelerometerAdaptor::commitOutput(struct input_event *ev)
 {
     AccelerationData* d = accelerometerBuffer_->nextSlot();
@@ -90,30 +95,35 @@ void AccelerometerAdaptor::commitOutput(struct input_event *ev)
     sensordLogT() << "Accelerometer reading: " << d->x_ << ", " << d->y_ << ", " << d->z_;
 
     accelerometerBuffer_->commit();
-    accelerometerBuffer_->wakeUpReaders();
 }
 
 unsigned int AccelerometerAdaptor::evaluateIntervalRequests(int& sessionId) const
 {
-    if (m_intervalMap.size() == 0)
+    if (!hasIntervalRequests())
     {
         sessionId = -1;
         return defaultInterval();
     }
 
     // Get the smallest positive request, 0 is reserved for HW wakeup
-    QMap<int, unsigned int>::const_iterator it = m_intervalMap.constBegin();
-    unsigned int highestValue = it.value();
-    int winningSessionId = it.key();
-
-    for (++it; it != m_intervalMap.constEnd(); ++it)
+    unsigned int value = fastestIntervalRequest(sessionId, 1);
+    if (sessionId < 0)
     {
-        if (((it.value() < highestValue) && (it.value() > 0)) || highestValue == 0) {
-            highestValue = it.value();
-            winningSessionId = it.key();
-        }
+        fastestIntervalRequest(sessionId);
+        return defaultInterval();
     }
+    return value;
+}
 
-    sessionId = winningSessionId;
-    return highestValue > 0 ? highestValue : defaultInterval();
+bool AccelerometerAdaptor::setMotionWakeup(bool enabled)
+{
+    QString path = Config::configuration()->value<QString>(name() + "/motion_wakeup_file", "");
+    if (path.isEmpty())
+        return false;
+
+    QByteArray value = enabled ?
+        Config::configuration()->value<QByteArray>(name() + "/motion_wakeup_enable", "1") :
+        Config::configuration()->value<QByteArray>(name() + "/motion_wakeup_disable", "0");
+    sensordLogD() << "Setting motion wakeup of " << name() << " to " << enabled;
+    return writeToFile(path.toLocal8Bit(), value + "\n");
 }
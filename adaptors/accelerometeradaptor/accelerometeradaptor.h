@@ -69,6 +69,14 @@ protected:
      */
     virtual unsigned int evaluateIntervalRequests(int& sessionId) const;
 
+    /**
+     * Program the motion threshold interrupt of the driver. The sysfs
+     * attribute and the values written to it are given with
+     * <tt>motion_wakeup_file</tt>, <tt>motion_wakeup_enable</tt> and
+     * <tt>motion_wakeup_disable</tt> in the adaptor configuration group.
+     */
+    virtual bool setMotionWakeup(bool enabled);
+
 private:
     DeviceAdaptorRingBuffer<AccelerationData>* accelerometerBuffer_;
     AccelerationData orientationValue_;
@@ -76,6 +84,7 @@ private:
     void interpretEvent(int src, struct input_event *ev);
     void commitOutput(struct input_event *ev);
     void interpretSync(int src, struct input_event *ev);
+    void wakeUpReaders();
 };
 
 #endif
@@ -16,7 +16,8 @@ SUBDIRS = alsadaptor \
           proximityadaptor-evdev \
           proximityadaptor-ascii \
           mrstaccelerometer \
-          gyroscopeadaptor
+          gyroscopeadaptor \
+          replayadaptor
 SUDBIRS += oemtabletmagnetometeradaptor
 SUBDIRS += pegatronaccelerometeradaptor 
 SUBDIRS += oemtabletalsadaptor-ascii
@@ -33,6 +34,9 @@ contains(CONFIG,hybris) {
     SUBDIRS += hybrismagnetometeradaptor
     SUBDIRS += hybrisproximityadaptor
     SUBDIRS += hybrisorientationadaptor
+    SUBDIRS += hybrisstepcounteradaptor
+    SUBDIRS += hybrisrotationvectoradaptor
+    SUBDIRS += replayadaptor
 }
 
 
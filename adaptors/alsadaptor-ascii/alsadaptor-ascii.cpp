@@ -37,25 +37,34 @@
 
 #include "logging.h"
 #include "config.h"
+#include "capabilitycache.h"
 #include "alsadaptor-ascii.h"
 #include "datatypes/utils.h"
 #include <stdlib.h>
 #include <linux/types.h>
 #include <string.h>
 
-ALSAdaptorAscii::ALSAdaptorAscii(const QString& id) : SysfsAdaptor(id, SysfsAdaptor::IntervalMode)
+ALSAdaptorAscii::ALSAdaptorAscii(const QString& id) : SysfsAdaptor(id, SysfsAdaptor::IntervalMode, false)
 {
     memset(buf, 0x0, 16);
-    alsBuffer_ = new DeviceAdaptorRingBuffer<TimedUnsigned>(1);
+    alsBuffer_ = new DeviceAdaptorRingBuffer<TimedUnsigned>(bufferCapacity(1));
     setAdaptedSensor("als", "Internal ambient light sensor lux values", alsBuffer_);
     setDescription("Ambient light");
 
     // Get range from a file, if the path is found in configuration
     QString rangeFilePath_ = Config::configuration()->value("als/range_file_path",QVariant("")).toString();
     if (rangeFilePath_ != "") {
+        // The range file belongs to the driver, so the value read on an
+        // earlier boot of the same kernel is still valid.
+        CapabilityCache& cache = CapabilityCache::instance();
+        QVariant cached = cache.value("als", CapabilityCache::kernelVersion(), rangeFilePath_);
         QFile sysFile(rangeFilePath_);
 
-        if (!(sysFile.open(QIODevice::ReadOnly))) {
+        if (cached.isValid()) {
+            int range = cached.toInt();
+            introduceAvailableDataRange(DataRange(0, range, 1));
+            sensordLogT() << "Ambient light range (cached): " << range;
+        } else if (!(sysFile.open(QIODevice::ReadOnly))) {
             sensordLogW() << "Unable to config ALS range from sysfs";
         } else {
             sysFile.readLine(buf, sizeof(buf));
@@ -63,6 +72,7 @@ ALSAdaptorAscii::ALSAdaptorAscii(const QString& id) : SysfsAdaptor(id, SysfsAdap
 
             introduceAvailableDataRange(DataRange(0, range, 1));
             sensordLogT() << "Ambient light range: " << range;
+            cache.setValue("als", CapabilityCache::kernelVersion(), rangeFilePath_, range);
         }
     }
         powerStatePath = Config::configuration()->value("als/powerstate_path").toByteArray();
@@ -77,20 +87,20 @@ ALSAdaptorAscii::~ALSAdaptorAscii()
 void ALSAdaptorAscii::processSample(int pathId, int fd) {
     Q_UNUSED(pathId);
 
-    if (read(fd, buf, sizeof(buf)) <= 0) {
-        sensordLogW() << "read():" << strerror(errno);
+    int value;
+    if (readValues(fd, &value, 1) != 1) {
+        sensordLogW() << "Failed to read ambient light value";
         return;
     }
-    buf[sizeof(buf)-1] = '\0';
 
-    sensordLogT() << "Ambient light value: " << buf;
+    sensordLogT() << "Ambient light value: " << value;
 
-    __u16 idata = atoi(buf);
+    __u16 idata = value;
 
     TimedUnsigned* lux = alsBuffer_->nextSlot();
 
     lux->value_ = idata;
-    lux->timestamp_ = Utils::getTimeStamp();
+    lux->timestamp_ = Utils::getCoarseTimeStamp();
 
     alsBuffer_->commit();
     alsBuffer_->wakeUpReaders();
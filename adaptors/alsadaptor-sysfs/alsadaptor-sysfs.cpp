@@ -39,7 +39,7 @@
 ALSAdaptorSysfs::ALSAdaptorSysfs(const QString& id) :
     SysfsAdaptor(id, SysfsAdaptor::IntervalMode, true)
 {
-    alsBuffer_ = new DeviceAdaptorRingBuffer<TimedUnsigned>(1);
+    alsBuffer_ = new DeviceAdaptorRingBuffer<TimedUnsigned>(bufferCapacity(1));
     setAdaptedSensor("als", "Internal ambient light sensor lux values", alsBuffer_);
 }
 
@@ -70,7 +70,7 @@ void ALSAdaptorSysfs::processSample(int pathId, int fd)
     TimedUnsigned* lux = alsBuffer_->nextSlot();
     lux->value_ = idata;
 
-    lux->timestamp_ = Utils::getTimeStamp();
+    lux->timestamp_ = Utils::getCoarseTimeStamp();
 
     alsBuffer_->commit();
     alsBuffer_->wakeUpReaders();
@@ -53,50 +53,29 @@ struct bh1770glc_als {
 
 ALSAdaptor::ALSAdaptor(const QString& id):
     SysfsAdaptor(id, SysfsAdaptor::SelectMode, false),
-#ifdef SENSORFW_MCE_WATCHER
-    alsEnabled(false),
-#endif
     deviceType_(DeviceUnknown)
 {
-    alsBuffer_ = new DeviceAdaptorRingBuffer<TimedUnsigned>(1);
+    alsBuffer_ = new DeviceAdaptorRingBuffer<TimedUnsigned>(bufferCapacity(1));
     setAdaptedSensor("als", "Internal ambient light sensor lux values", alsBuffer_);
     setDescription("Ambient light");
     deviceType_ = (DeviceType)Config::configuration()->value<int>("als/driver_type", DeviceUnknown);
     powerStatePath_ = Config::configuration()->value("als/powerstate_path").toByteArray();
-
-#ifdef SENSORFW_MCE_WATCHER
-    dbusIfc = new QDBusInterface(MCE_SERVICE, MCE_REQUEST_PATH, MCE_REQUEST_IF,
-                                 QDBusConnection::systemBus(), this);
-#endif
 }
 
 ALSAdaptor::~ALSAdaptor()
 {
-#ifdef SENSORFW_MCE_WATCHER
-    delete dbusIfc;
-#endif
     delete alsBuffer_;
 }
 
 #ifdef SENSORFW_MCE_WATCHER
 void ALSAdaptor::enableALS()
 {
-    if(!alsEnabled)
-    {
-        sensordLogT() << "Requesting MCE to enable ALS";
-        dbusIfc->call(QDBus::NoBlock, "req_als_enable");
-        alsEnabled = true;
-    }
+    MceDispatcher::instance().setRequested("als", true, "req_als_enable", "req_als_disable");
 }
 
 void ALSAdaptor::disableALS()
 {
-    if(alsEnabled)
-    {
-        sensordLogT() << "Requesting MCE to disable ALS";
-        dbusIfc->call(QDBus::NoBlock, "req_als_disable");
-        alsEnabled = false;
-    }
+    MceDispatcher::instance().setRequested("als", false, "req_als_enable", "req_als_disable");
 }
 #endif
 
@@ -171,7 +150,7 @@ void ALSAdaptor::processSample(int pathId, int fd)
 
         TimedUnsigned* lux = alsBuffer_->nextSlot();
         lux->value_ = als_data.lux;
-        lux->timestamp_ = Utils::getTimeStamp();
+        lux->timestamp_ = Utils::getCoarseTimeStamp();
     }
     else if (deviceType_ == RM696)
     {
@@ -188,7 +167,7 @@ void ALSAdaptor::processSample(int pathId, int fd)
 
         TimedUnsigned* lux = alsBuffer_->nextSlot();
         lux->value_ = als_data.lux;
-        lux->timestamp_ = Utils::getTimeStamp();
+        lux->timestamp_ = Utils::getCoarseTimeStamp();
     }
     else if (deviceType_ == NCDK)
     {
@@ -208,7 +187,7 @@ void ALSAdaptor::processSample(int pathId, int fd)
         }
         TimedUnsigned* lux = alsBuffer_->nextSlot();
         lux->value_ = fValue * 10;
-        lux->timestamp_ = Utils::getTimeStamp();
+        lux->timestamp_ = Utils::getCoarseTimeStamp();
         sensordLogT() << "Ambient light value: " << lux->value_;
     }
     else
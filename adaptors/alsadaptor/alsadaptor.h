@@ -35,11 +35,11 @@
 #include "deviceadaptorringbuffer.h"
 #include "datatypes/timedunsigned.h"
 #include <QTime>
-#include <QDBusInterface>
 
 #ifdef SENSORFW_MCE_WATCHER
     #include <mce/mode-names.h>
     #include <mce/dbus-names.h>
+    #include "mcedispatcher.h"
 #endif
 
 /**
@@ -80,6 +80,13 @@ public:
 
     virtual void stopSensor();
 
+#ifdef SENSORFW_MCE_WATCHER
+    /**
+     * MCE is told about the sensor over D-Bus from the main thread.
+     */
+    virtual bool startsConcurrently() const { return false; }
+#endif
+
     virtual bool standby();
 
     virtual bool resume();
@@ -100,9 +107,6 @@ private:
 #ifdef SENSORFW_MCE_WATCHER
     void enableALS();
     void disableALS();
-
-    QDBusInterface *dbusIfc;
-    bool alsEnabled;
 #endif
 
     DeviceAdaptorRingBuffer<TimedUnsigned>* alsBuffer_;
@@ -26,6 +26,7 @@
    </p>
 */
 #include <errno.h>
+#include <math.h>
 
 #include "logging.h"
 #include "config.h"
@@ -35,12 +36,27 @@
 
 
 GyroscopeAdaptor::GyroscopeAdaptor(const QString& id) :
-        SysfsAdaptor(id, SysfsAdaptor::SelectMode)
+        SysfsAdaptor(id, SysfsAdaptor::SelectMode),
+        scale_(1.0)
 {
-    gyroscopeBuffer_ = new DeviceAdaptorRingBuffer<TimedXyzData>(1);
+    gyroscopeBuffer_ = new DeviceAdaptorRingBuffer<TimedXyzData>(bufferCapacity(1));
     setAdaptedSensor("gyroscope", "l3g4200dh", gyroscopeBuffer_);
     setDescription("Sysfs Gyroscope adaptor (l3g4200dh)");   
     dataRatePath_ = Config::configuration()->value("gyroscope/path_datarate").toByteArray();
+
+    // IIO buffer delivers all axes in one frame and can share a trigger
+    // with the accelerometer.
+    QString iioDevice = Config::configuration()->value("gyroscope/iio_device").toString();
+    if (!iioDevice.isEmpty()) {
+        if (addIioDevice(iioDevice, QStringList() << "in_anglvel_x" << "in_anglvel_y" << "in_anglvel_z")) {
+            // Scale is in rad/s per count, samples are in mdps.
+            bool ok;
+            double scale = readFromFile((iioDevice + "/in_anglvel_scale").toLocal8Bit()).trimmed().toDouble(&ok);
+            scale_ = ok && scale > 0 ? scale * 180000.0 / M_PI : 1.0;
+        } else {
+            sensordLogW() << "iio_device: " << iioDevice << " not usable, falling back to sysfs";
+        }
+    }
 }
 
 GyroscopeAdaptor::~GyroscopeAdaptor()
@@ -69,9 +85,27 @@ void GyroscopeAdaptor::processSample(int pathId, int fd)
     gyroscopeBuffer_->wakeUpReaders();
 }
 
+void GyroscopeAdaptor::processScanFrames(int pathId, const char* frames, int count)
+{
+    Q_UNUSED(pathId);
+
+    const IioScanLayout& layout = scanLayout();
+
+    for (int i = 0; i < count; ++i) {
+        const char* frame = frames + i * layout.frameSize();
+        TimedXyzData* pos = gyroscopeBuffer_->nextSlot();
+        pos->timestamp_ = scanFrameTimeStamp(frames, i, count);
+        pos->x_ = qRound(layout.value(frame, 0) * scale_);
+        pos->y_ = qRound(layout.value(frame, 1) * scale_);
+        pos->z_ = qRound(layout.value(frame, 2) * scale_);
+        gyroscopeBuffer_->commit();
+    }
+    gyroscopeBuffer_->wakeUpReaders();
+}
+
 bool GyroscopeAdaptor::setInterval(const unsigned int value, const int sessionId)
 {
-    if (mode() == SysfsAdaptor::IntervalMode)
+    if (mode() != SysfsAdaptor::SelectMode)
         return SysfsAdaptor::setInterval(value, sessionId);
 
     int rate = value==0?100:1000/value;
@@ -82,7 +116,7 @@ bool GyroscopeAdaptor::setInterval(const unsigned int value, const int sessionId
 
 unsigned int GyroscopeAdaptor::interval() const
 {
-    if (mode() == SysfsAdaptor::IntervalMode)
+    if (mode() != SysfsAdaptor::SelectMode)
         return SysfsAdaptor::interval();
     QByteArray byteArray = readFromFile(dataRatePath_);
     return byteArray.size() > 0 ? byteArray.toInt() : 0;
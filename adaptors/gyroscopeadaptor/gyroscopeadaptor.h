@@ -39,6 +39,9 @@
  * Driver interface is located in @e /sys/class/i2c-adapter/?????? .
  * <ul><li>@e angular_rate filehandle provides measurement values.</li></ul>
  * No other filehandles are currently in use by this adaptor.
+ *
+ * With <tt>gyroscope/iio_device</tt> the buffer of an IIO device is read
+ * instead, which can share a trigger with other adaptors.
  */
 class GyroscopeAdaptor : public SysfsAdaptor
 {
@@ -84,8 +87,11 @@ private:
      */
     void processSample(int pathId, int fd);
 
+    void processScanFrames(int pathId, const char* frames, int count);
+
     DeviceAdaptorRingBuffer<TimedXyzData>* gyroscopeBuffer_;
     QByteArray dataRatePath_;
+    double scale_; /**< IIO counts to mdps */
 };
 
 #endif
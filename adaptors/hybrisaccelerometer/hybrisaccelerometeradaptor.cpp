@@ -26,8 +26,9 @@
 HybrisAccelerometerAdaptor::HybrisAccelerometerAdaptor(const QString& id) :
     HybrisAdaptor(id,SENSOR_TYPE_ACCELEROMETER)
 {
-    buffer = new DeviceAdaptorRingBuffer<AccelerationData>(1);
+    buffer = new DeviceAdaptorRingBuffer<AccelerationData>(bufferCapacity(128));
     setAdaptedSensor("accelerometer", "Internal accelerometer coordinates", buffer);
+    floatBuffer = new DeviceAdaptorRingBuffer<AccelerationFloatData>(bufferCapacity(128));
 
     setDescription("Hybris accelerometer");
 //    setDefaultInterval(50);
@@ -36,6 +37,14 @@ HybrisAccelerometerAdaptor::HybrisAccelerometerAdaptor(const QString& id) :
 HybrisAccelerometerAdaptor::~HybrisAccelerometerAdaptor()
 {
     delete buffer;
+    delete floatBuffer;
+}
+
+RingBufferBase* HybrisAccelerometerAdaptor::findBuffer(const QString& name) const
+{
+    if (name == "accelerometerfloat")
+        return floatBuffer;
+    return HybrisAdaptor::findBuffer(name);
 }
 
 bool HybrisAccelerometerAdaptor::startSensor()
@@ -56,16 +65,37 @@ void HybrisAccelerometerAdaptor::stopSensor()
 void HybrisAccelerometerAdaptor::processSample(const sensors_event_t& data)
 {
 
-    AccelerationData *d = buffer->nextSlot();
-    d->timestamp_ = quint64(data.timestamp * .001);
+    AccelerationData *d = buffer->stageSlot();
+    d->timestamp_ = Utils::getTimeStamp(data.timestamp);
     // sensorfw wants milli-G'
     d->x_ = -(data.data[0] / 9.80665 * 1000);
     d->y_ = -(data.data[1] / 9.80665 * 1000);
     d->z_ = -(data.data[2] / 9.80665 * 1000);
 //  qt's sensorfw plugin expects G == 9.81286, but it should be
     //9.80665
-    buffer->commit();
+
+    // The HAL already reports m/s^2 as floats, pass them on unscaled
+    // when somebody listens.
+    if (floatBuffer->hasDemand()) {
+        AccelerationFloatData *f = floatBuffer->stageSlot();
+        f->timestamp_ = d->timestamp_;
+        f->x_ = -data.data[0];
+        f->y_ = -data.data[1];
+        f->z_ = -data.data[2];
+    }
+}
+
+void HybrisAccelerometerAdaptor::wakeUpReaders()
+{
+    buffer->commitStaged();
     buffer->wakeUpReaders();
+    floatBuffer->commitStaged();
+    floatBuffer->wakeUpReaders();
+}
+
+bool HybrisAccelerometerAdaptor::setMotionWakeup(bool enabled)
+{
+    return HybrisManager::instance()->setMotionWakeup(this, enabled);
 }
 
 //void HybrisAccelerometerAdaptor::init()
@@ -42,12 +42,22 @@ public:
     bool startSensor();
     void stopSensor();
 
+    /**
+     * Besides the milli-G buffer <tt>accelerometer</tt> the adaptor
+     * offers <tt>accelerometerfloat</tt>, which carries the samples in
+     * m/s^2 as the HAL reports them.
+     */
+    RingBufferBase* findBuffer(const QString& name) const;
+
 protected:
     void processSample(const sensors_event_t& data);
+    void wakeUpReaders();
+    bool setMotionWakeup(bool enabled);
   //  void init();
 
 private:
     DeviceAdaptorRingBuffer<AccelerationData>* buffer;
+    DeviceAdaptorRingBuffer<AccelerationFloatData>* floatBuffer;
     int sensorType;
 
 };
@@ -26,7 +26,7 @@
 HybrisAlsAdaptor::HybrisAlsAdaptor(const QString& id) :
     HybrisAdaptor(id,SENSOR_TYPE_LIGHT)
 {
-    buffer = new DeviceAdaptorRingBuffer<TimedUnsigned>(1);
+    buffer = new DeviceAdaptorRingBuffer<TimedUnsigned>(bufferCapacity(128));
     setAdaptedSensor("als", "Internal ambient light sensor lux values", buffer);
    // setDefaultInterval(50);
     setDescription("Hybris als");
@@ -54,11 +54,14 @@ void HybrisAlsAdaptor::stopSensor()
 
 void HybrisAlsAdaptor::processSample(const sensors_event_t& data)
 {
-    TimedUnsigned *d = buffer->nextSlot();
-    d->timestamp_ = quint64(data.timestamp * .0001);
+    TimedUnsigned *d = buffer->stageSlot();
+    d->timestamp_ = Utils::getTimeStamp(data.timestamp);
     d->value_ = data.light;
+}
 
-    buffer->commit();
+void HybrisAlsAdaptor::wakeUpReaders()
+{
+    buffer->commitStaged();
     buffer->wakeUpReaders();
 }
 
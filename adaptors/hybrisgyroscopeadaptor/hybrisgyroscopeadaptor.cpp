@@ -28,7 +28,7 @@
 HybrisGyroscopeAdaptor::HybrisGyroscopeAdaptor(const QString& id) :
     HybrisAdaptor(id,SENSOR_TYPE_GYROSCOPE)
 {
-    buffer = new DeviceAdaptorRingBuffer<TimedXyzData>(128);
+    buffer = new DeviceAdaptorRingBuffer<TimedXyzData>(bufferCapacity(128));
     setAdaptedSensor("gyroscopeadaptor", "Internal gyroscope coordinates", buffer);
 
     setDescription("Hybris gyroscope");
@@ -58,13 +58,16 @@ void HybrisGyroscopeAdaptor::stopSensor()
 
 void HybrisGyroscopeAdaptor::processSample(const sensors_event_t& data)
 {
-    TimedXyzData *d = buffer->nextSlot();
-    d->timestamp_ = quint64(data.timestamp * .001);
+    TimedXyzData *d = buffer->stageSlot();
+    d->timestamp_ = Utils::getTimeStamp(data.timestamp);
     d->x_ = (data.acceleration.x) * 57295.7795;
     d->y_ = (data.acceleration.y) * 57295.7795;
     d->z_ = (data.acceleration.z) * 57295.7795;
+}
 
-    buffer->commit();
+void HybrisGyroscopeAdaptor::wakeUpReaders()
+{
+    buffer->commitStaged();
     buffer->wakeUpReaders();
 }
 
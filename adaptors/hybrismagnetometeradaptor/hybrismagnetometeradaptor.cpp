@@ -27,7 +27,7 @@
 HybrisMagnetometerAdaptor::HybrisMagnetometerAdaptor(const QString& id) :
     HybrisAdaptor(id,SENSOR_TYPE_MAGNETIC_FIELD)
 {
-    buffer = new DeviceAdaptorRingBuffer<TimedXyzData>(1);
+    buffer = new DeviceAdaptorRingBuffer<TimedXyzData>(bufferCapacity(128));
     setAdaptedSensor("magnetometer", "Internal magnetometer coordinates", buffer);
 
     setDescription("Hybris magnetometer");
@@ -56,14 +56,17 @@ void HybrisMagnetometerAdaptor::stopSensor()
 
 void HybrisMagnetometerAdaptor::processSample(const sensors_event_t& data)
 {
-    TimedXyzData *d = buffer->nextSlot();
-    d->timestamp_ = quint64(data.timestamp * .0001);
+    TimedXyzData *d = buffer->stageSlot();
+    d->timestamp_ = Utils::getTimeStamp(data.timestamp);
     //uT to nT
     d->x_ = (data.acceleration.x * 1000);
     d->y_ = (data.acceleration.y * 1000);
     d->z_ = (data.acceleration.z * 1000);
+}
 
-    buffer->commit();
+void HybrisMagnetometerAdaptor::wakeUpReaders()
+{
+    buffer->commitStaged();
     buffer->wakeUpReaders();
 }
 
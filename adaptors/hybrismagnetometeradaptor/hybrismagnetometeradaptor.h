@@ -45,6 +45,7 @@ public:
 
 protected:
     void processSample(const sensors_event_t& data);
+    void wakeUpReaders();
     void init();
 
 private:
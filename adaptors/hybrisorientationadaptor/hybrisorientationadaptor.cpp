@@ -43,10 +43,11 @@
 HybrisOrientationAdaptor::HybrisOrientationAdaptor(const QString& id) :
     HybrisAdaptor(id,SENSOR_TYPE_ORIENTATION)
 {
-    buffer = new DeviceAdaptorRingBuffer<TimedXyzData>(1);
-    setAdaptedSensor("accelerometer", "Internal orientation coordinates", buffer);
+    buffer = new DeviceAdaptorRingBuffer<TimedXyzData>(bufferCapacity(128));
+    setAdaptedSensor("orientation", "Internal orientation coordinates", buffer);
 
     setDescription("Hybris orientation");
+    setValid(HybrisManager::instance()->hasSensor(SENSOR_TYPE_ORIENTATION));
 //    setDefaultInterval(50);
 }
 
@@ -72,8 +73,8 @@ void HybrisOrientationAdaptor::stopSensor()
 
 void HybrisOrientationAdaptor::processSample(const sensors_event_t& data)
 {
-    TimedXyzData *d = buffer->nextSlot();
-    d->timestamp_ = quint64(data.timestamp * .001);
+    TimedXyzData *d = buffer->stageSlot();
+    d->timestamp_ = Utils::getTimeStamp(data.timestamp);
     // sensorfw wants milli-G'
     d->x_ = data.data[0] * 1000; //azimuth
     d->y_ = data.data[1] * 1000; //pitch
@@ -81,7 +82,11 @@ void HybrisOrientationAdaptor::processSample(const sensors_event_t& data)
 
 //  qt's sensorfw plugin expects G == 9.81286, but it should be
     //9.80665
-    buffer->commit();
+}
+
+void HybrisOrientationAdaptor::wakeUpReaders()
+{
+    buffer->commitStaged();
     buffer->wakeUpReaders();
 }
 
@@ -43,6 +43,7 @@ public:
 
 protected:
     void processSample(const sensors_event_t& data);
+    void wakeUpReaders();
     void init();
 
 private:
@@ -27,7 +27,7 @@
 HybrisProximityAdaptor::HybrisProximityAdaptor(const QString& id) :
     HybrisAdaptor(id,SENSOR_TYPE_PROXIMITY)
 {
-    buffer = new DeviceAdaptorRingBuffer<ProximityData>(128);
+    buffer = new DeviceAdaptorRingBuffer<ProximityData>(bufferCapacity(128));
     setAdaptedSensor("proximity", "Internal proximity coordinates", buffer);
 
     setDescription("Hybris proximity");
@@ -55,16 +55,19 @@ void HybrisProximityAdaptor::stopSensor()
 
 void HybrisProximityAdaptor::processSample(const sensors_event_t& data)
 {
-    ProximityData *d = buffer->nextSlot();
-    d->timestamp_ = quint64(data.timestamp * .0001);
+    ProximityData *d = buffer->stageSlot();
+    d->timestamp_ = Utils::getTimeStamp(data.timestamp);
     bool near = false;
     if (data.distance < maxRange) {
         near = true;
     }
     d->withinProximity_ = near;
     d->value_ = data.distance;
+}
 
-    buffer->commit();
+void HybrisProximityAdaptor::wakeUpReaders()
+{
+    buffer->commitStaged();
     buffer->wakeUpReaders();
 }
 
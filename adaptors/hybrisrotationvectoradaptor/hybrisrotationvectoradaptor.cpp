@@ -0,0 +1,90 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Jolla Ltd
+** Contact: lorn.potter@jollamobile.com
+**
+**
+** $QT_BEGIN_LICENSE:LGPL$
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "hybrisrotationvectoradaptor.h"
+#include "logging.h"
+#include "datatypes/utils.h"
+#include <android/hardware/sensors.h>
+#include <math.h>
+
+#ifndef SENSOR_TYPE_GAME_ROTATION_VECTOR
+#define SENSOR_TYPE_GAME_ROTATION_VECTOR (15)
+#endif
+
+static int rotationVectorType(const QString& id)
+{
+    return id == "gamerotationvectoradaptor" ? SENSOR_TYPE_GAME_ROTATION_VECTOR : SENSOR_TYPE_ROTATION_VECTOR;
+}
+
+HybrisRotationVectorAdaptor::HybrisRotationVectorAdaptor(const QString& id) :
+    HybrisAdaptor(id, rotationVectorType(id))
+{
+    buffer = new DeviceAdaptorRingBuffer<TimedQuaternionData>(bufferCapacity(128));
+    setAdaptedSensor("quaternion", "Attitude computed by the sensor hub", buffer);
+    setDescription("Hybris rotation vector");
+    introduceAvailableDataRange(DataRange(-1, 1, 0));
+    setValid(HybrisManager::instance()->hasSensor(sensorType));
+}
+
+HybrisRotationVectorAdaptor::~HybrisRotationVectorAdaptor()
+{
+    delete buffer;
+}
+
+bool HybrisRotationVectorAdaptor::startSensor()
+{
+    if (!(HybrisAdaptor::startSensor()))
+        return false;
+
+    sensordLogD() << "Hybris HybrisRotationVectorAdaptor start\n";
+    return true;
+}
+
+void HybrisRotationVectorAdaptor::stopSensor()
+{
+    HybrisAdaptor::stopSensor();
+    sensordLogD() << "Hybris HybrisRotationVectorAdaptor stop\n";
+}
+
+void HybrisRotationVectorAdaptor::processSample(const sensors_event_t& data)
+{
+    float x = data.data[0];
+    float y = data.data[1];
+    float z = data.data[2];
+    // Older HALs leave out the scalar part, it follows from unit length.
+    float w = data.data[3];
+    if (w == 0) {
+        float ww = 1 - (x * x + y * y + z * z);
+        w = ww > 0 ? sqrtf(ww) : 0;
+    }
+
+    TimedQuaternionData *d = buffer->stageSlot();
+    *d = TimedQuaternionData(Utils::getTimeStamp(data.timestamp), w, x, y, z);
+}
+
+void HybrisRotationVectorAdaptor::wakeUpReaders()
+{
+    buffer->commitStaged();
+    buffer->wakeUpReaders();
+}
+
+void HybrisRotationVectorAdaptor::init()
+{
+}
@@ -0,0 +1,62 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Jolla Ltd
+** Contact: lorn.potter@jollamobile.com
+**
+**
+** $QT_BEGIN_LICENSE:LGPL$
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef HYBRISROTATIONVECTORADAPTOR_H
+#define HYBRISROTATIONVECTORADAPTOR_H
+#include "hybrisadaptor.h"
+
+#include <QString>
+#include "deviceadaptorringbuffer.h"
+#include "datatypes/quaterniondata.h"
+
+/**
+ * @brief Adaptor for the rotation vector sensors of the Android sensor
+ * HAL.
+ *
+ * Registered as \c rotationvectoradaptor for the rotation vector, fused
+ * by the sensor hub from accelerometer, gyroscope and magnetometer, and
+ * as \c gamerotationvectoradaptor for the game rotation vector, which
+ * leaves out the magnetometer. Provides \em quaternion, the rotation
+ * from device to world coordinates as a unit quaternion. The adaptor is
+ * not valid when the HAL does not have the sensor.
+ */
+class HybrisRotationVectorAdaptor : public HybrisAdaptor
+{
+    Q_OBJECT
+
+public:
+    static DeviceAdaptor* factoryMethod(const QString& id) {
+        return new HybrisRotationVectorAdaptor(id);
+    }
+    HybrisRotationVectorAdaptor(const QString& id);
+    ~HybrisRotationVectorAdaptor();
+
+    bool startSensor();
+    void stopSensor();
+
+protected:
+    void processSample(const sensors_event_t& data);
+    void wakeUpReaders();
+    void init();
+
+private:
+    DeviceAdaptorRingBuffer<TimedQuaternionData>* buffer;
+};
+#endif
@@ -0,0 +1,85 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Jolla Ltd
+** Contact: lorn.potter@jollamobile.com
+**
+**
+** $QT_BEGIN_LICENSE:LGPL$
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "hybrisstepcounteradaptor.h"
+#include "logging.h"
+#include "config.h"
+#include "datatypes/utils.h"
+#include <android/hardware/sensors.h>
+
+#ifndef SENSOR_TYPE_STEP_COUNTER
+// Headers from before the step counter, the HAL cannot report one.
+#define SENSOR_TYPE_STEP_COUNTER (19)
+#define HYBRIS_NO_STEP_COUNTER
+#endif
+
+HybrisStepCounterAdaptor::HybrisStepCounterAdaptor(const QString& id) :
+    HybrisAdaptor(id, SENSOR_TYPE_STEP_COUNTER)
+{
+    buffer = new DeviceAdaptorRingBuffer<TimedUnsigned>(bufferCapacity(16));
+    setAdaptedSensor("stepcounter", "Steps counted by the sensor hub", buffer);
+    setDescription("Hybris step counter");
+    reportLatency_ = Config::configuration()->value<unsigned int>("stepcounter/report_latency", 10000);
+    setValid(HybrisManager::instance()->hasSensor(SENSOR_TYPE_STEP_COUNTER));
+}
+
+HybrisStepCounterAdaptor::~HybrisStepCounterAdaptor()
+{
+    delete buffer;
+}
+
+bool HybrisStepCounterAdaptor::startSensor()
+{
+    if (!(HybrisAdaptor::startSensor()))
+        return false;
+
+    // Steps are not urgent, let the hub hold them while we sleep.
+    if (reportLatency_)
+        setBufferInterval(reportLatency_);
+    sensordLogD() << "Hybris HybrisStepCounterAdaptor start\n";
+    return true;
+}
+
+void HybrisStepCounterAdaptor::stopSensor()
+{
+    HybrisAdaptor::stopSensor();
+    sensordLogD() << "Hybris HybrisStepCounterAdaptor stop\n";
+}
+
+void HybrisStepCounterAdaptor::processSample(const sensors_event_t& data)
+{
+#ifndef HYBRIS_NO_STEP_COUNTER
+    TimedUnsigned *d = buffer->stageSlot();
+    d->timestamp_ = Utils::getTimeStamp(data.timestamp);
+    d->value_ = (unsigned int)data.u64.step_counter;
+#else
+    Q_UNUSED(data);
+#endif
+}
+
+void HybrisStepCounterAdaptor::wakeUpReaders()
+{
+    buffer->commitStaged();
+    buffer->wakeUpReaders();
+}
+
+void HybrisStepCounterAdaptor::init()
+{
+}
@@ -0,0 +1,61 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Jolla Ltd
+** Contact: lorn.potter@jollamobile.com
+**
+**
+** $QT_BEGIN_LICENSE:LGPL$
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef HYBRISSTEPCOUNTERADAPTOR_H
+#define HYBRISSTEPCOUNTERADAPTOR_H
+#include "hybrisadaptor.h"
+
+#include <QString>
+#include "deviceadaptorringbuffer.h"
+#include "datatypes/timedunsigned.h"
+
+/**
+ * @brief Adaptor for the step counter of the Android sensor HAL.
+ *
+ * Provides \em stepcounter, cumulative steps counted by the sensor hub
+ * since the counter was last activated after boot. The hub counts
+ * while the application processor sleeps and only reports changes,
+ * which are batched for <tt>stepcounter/report_latency</tt> ms. The
+ * adaptor is not valid when the HAL has no step counter.
+ */
+class HybrisStepCounterAdaptor : public HybrisAdaptor
+{
+    Q_OBJECT
+
+public:
+    static DeviceAdaptor* factoryMethod(const QString& id) {
+        return new HybrisStepCounterAdaptor(id);
+    }
+    HybrisStepCounterAdaptor(const QString& id);
+    ~HybrisStepCounterAdaptor();
+
+    bool startSensor();
+    void stopSensor();
+
+protected:
+    void processSample(const sensors_event_t& data);
+    void wakeUpReaders();
+    void init();
+
+private:
+    DeviceAdaptorRingBuffer<TimedUnsigned>* buffer;
+    unsigned int reportLatency_; /**< requested batching latency in ms */
+};
+#endif
@@ -39,7 +39,7 @@
 KeyboardSliderAdaptor::KeyboardSliderAdaptor(const QString& id) :
     InputDevAdaptor(id, 1), newKbEventRecorded_(false), currentState_(KeyboardSliderStateUnknown)
 {
-    kbstateBuffer_ = new DeviceAdaptorRingBuffer<KeyboardSliderState>(1);
+    kbstateBuffer_ = new DeviceAdaptorRingBuffer<KeyboardSliderState>(bufferCapacity(64));
     setAdaptedSensor("keyboardslider", "Device keyboard slider state", kbstateBuffer_);
     setDescription("Keyboard slider events (via input device)");
 }
@@ -86,6 +86,11 @@ void KeyboardSliderAdaptor::interpretSync(int src, struct input_event *ev)
     commitOutput();
 }
 
+void KeyboardSliderAdaptor::wakeUpReaders()
+{
+    kbstateBuffer_->wakeUpReaders();
+}
+
 void KeyboardSliderAdaptor::commitOutput()
 {
     sensordLogD() << "KB Slider state change detected: " << currentState_;
@@ -95,7 +100,6 @@ void KeyboardSliderAdaptor::commitOutput()
     *state = currentState_;
 
     kbstateBuffer_->commit();
-    kbstateBuffer_->wakeUpReaders();
 }
 
 unsigned int KeyboardSliderAdaptor::interval() const
@@ -77,6 +77,7 @@ private:
     void interpretEvent(int src, struct input_event *ev);
     void commitOutput();
     void interpretSync(int src, struct input_event *ev);
+    void wakeUpReaders();
 };
 
 #endif
@@ -39,10 +39,9 @@
 #include "datatypes/utils.h"
 
 MagnetometerAdaptorAscii::MagnetometerAdaptorAscii(const QString& id) :
-    SysfsAdaptor(id, SysfsAdaptor::IntervalMode)
+    SysfsAdaptor(id, SysfsAdaptor::IntervalMode, false)
 {
-    memset(buf, 0x0, 32);
-    magnetBuffer_ = new DeviceAdaptorRingBuffer<TimedXyzData>(1);
+    magnetBuffer_ = new DeviceAdaptorRingBuffer<TimedXyzData>(bufferCapacity(1));
     setAdaptedSensor("magnetometer", "ak8974 ascii", magnetBuffer_);
 }
 
@@ -53,21 +52,19 @@ MagnetometerAdaptorAscii::~MagnetometerAdaptorAscii()
 
 void MagnetometerAdaptorAscii::processSample(int, int fd)
 {
-    unsigned short x, y, z;
+    int values[3];
 
-    lseek(fd, 0, SEEK_SET);
-    if (read(fd, buf, sizeof(buf)) <= 0) {
-        sensordLogW() << "read(): " << strerror(errno);
+    if (readValues(fd, values, 3, 16) != 3) {
+        sensordLogW() << "Failed to read magnetometer values";
         return;
     }
-    sensordLogT() << "Magnetometer output value: " << buf;
-
-    sscanf(buf, "%hx:%hx:%hx\n", &x, &y, &z);
+    sensordLogT() << "Magnetometer output value: " << values[0] << ", " << values[1] << ", " << values[2];
 
+    // Values are 16 bit two's complement in hex.
     TimedXyzData* pos = magnetBuffer_->nextSlot();
-    pos->x_ = (short)x;
-    pos->y_ = (short)y;
-    pos->z_ = (short)z;
+    pos->x_ = (short)values[0];
+    pos->y_ = (short)values[1];
+    pos->z_ = (short)values[2];
     pos->timestamp_ = Utils::getTimeStamp();
 
     magnetBuffer_->commit();
@@ -51,7 +51,6 @@ protected:
 
 private:
     void processSample(int pathId, int fd);
-    char buf[32];
 
     DeviceAdaptorRingBuffer<TimedXyzData>* magnetBuffer_;
 };
@@ -36,7 +36,7 @@ MagnetometerAdaptorNCDK::MagnetometerAdaptorNCDK(const QString& id) :
     intervalCompensation_ = Config::configuration()->value<int>("magnetometer/interval_compensation", 0);
     powerStateFilePath_ = Config::configuration()->value<QByteArray>("magnetometer/path_power_state", "");
     sensAdjFilePath_ = Config::configuration()->value<QByteArray>("magnetometer/path_sens_adjust", "");
-    magnetometerBuffer_ = new DeviceAdaptorRingBuffer<TimedXyzData>(128);
+    magnetometerBuffer_ = new DeviceAdaptorRingBuffer<TimedXyzData>(bufferCapacity(128));
     setAdaptedSensor("magnetometer", "Internal magnetometer coordinates", magnetometerBuffer_);
     setDescription("Magnetometer adaptor (ak8975) for NCDK");
 
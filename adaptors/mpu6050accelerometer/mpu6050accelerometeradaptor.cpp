@@ -36,35 +36,37 @@
 #define CORRECTION_FACTOR (165.8 / EARTH_GRAVITY)
 
 Mpu6050AccelAdaptor::Mpu6050AccelAdaptor (const QString& id) :
-    SysfsAdaptor (id, SysfsAdaptor::IntervalMode)
+    SysfsAdaptor (id, SysfsAdaptor::IntervalMode, false)
 {
     struct stat st;
 
-    QString xAxisPath = Config::configuration()->value("accelerometer/x_axis_path").toString ();
-    if ( lstat (xAxisPath.toLatin1().constData(), &st) < 0 ) {
-        sensordLogW () << "x_axis_path: " << xAxisPath << " not found";
-        return;
-    }
-    addPath(xAxisPath, X_AXIS);
+    buffer = new DeviceAdaptorRingBuffer<OrientationData>(bufferCapacity(128));
+    setAdaptedSensor("accelerometer", "MPU6050 accelerometer", buffer);
 
-    QString yAxisPath = Config::configuration()->value("accelerometer/y_axis_path").toString ();
-    if ( lstat (yAxisPath.toLatin1().constData(), &st) < 0 ) {
-        sensordLogW () << "y_axis_path: " << yAxisPath << " not found";
-        return;
-    }
-    addPath(yAxisPath, Y_AXIS);
+    setDescription("MPU 6050 accelerometer");
 
-    QString zAxisPath = Config::configuration()->value("accelerometer/z_axis_path").toString ();
-    if ( lstat (zAxisPath.toLatin1().constData(), &st) < 0 ) {
-        sensordLogW () << "z_axis_path: " << zAxisPath << " not found";
-        return;
+    // Prefer the IIO buffer, it delivers all three axes in one frame.
+    QString iioDevice = Config::configuration()->value("accelerometer/iio_device").toString ();
+    if ( !iioDevice.isEmpty() ) {
+        if ( addIioDevice(iioDevice, QStringList() << "in_accel_x" << "in_accel_y" << "in_accel_z") )
+            return;
+        sensordLogW () << "iio_device: " << iioDevice << " not usable, falling back to sysfs files";
     }
-    addPath(zAxisPath, Z_AXIS);
 
-    buffer = new DeviceAdaptorRingBuffer<OrientationData>(128);
-    setAdaptedSensor("accelerometer", "MPU6050 accelerometer", buffer);
+    // Read the axis files together so each sample is committed whole.
+    QStringList axisPaths;
+    const char* axes[] = { "x", "y", "z" };
+    for ( int i = 0; i < 3; ++i ) {
+        QString key = QString("accelerometer/%1_axis_path").arg(axes[i]);
+        QString path = Config::configuration()->value(key).toString ();
+        if ( lstat (path.toLatin1().constData(), &st) < 0 ) {
+            sensordLogW () << key << ": " << path << " not found";
+            return;
+        }
+        axisPaths << path;
+    }
+    addPathGroup(axisPaths, XYZ_AXES);
 
-    setDescription("MPU 6050 accelerometer");
 //    introduceAvailableDataRange(DataRange(-16384, 16384, 1));
 //    introduceAvailableInterval(DataRange(10, 586, 0));
 //    setDefaultInterval(100);
@@ -88,42 +90,48 @@ void Mpu6050AccelAdaptor::stopSensor () {
 }
 
 void Mpu6050AccelAdaptor::processSample (int pathId, int fd) {
-    char buf[32];
-    int val;
+    Q_UNUSED(fd);
+    // Axes are added as a group and read in processPathGroup().
+    sensordLogW() << "Wrong pathId: " << pathId;
+}
 
-    if ( pathId < X_AXIS || pathId > Z_AXIS ) {
-        sensordLogW() << "Wrong pathId: " << pathId;
-        return;
-    }
+void Mpu6050AccelAdaptor::processPathGroup (int groupId, const int* fds, int count) {
+    int val[3];
 
-    lseek (fd, 0, SEEK_SET);
-    if (read (fd, buf, sizeof(buf)) < 0) {
-        sensordLogW() << "Read failed";
+    if ( groupId != XYZ_AXES || count != 3 ) {
+        sensordLogW() << "Wrong path group: " << groupId;
         return;
     }
 
-    if (sscanf (buf, "%d", &val) == 0 ) {
-        sensordLogW() << "Wrong data format: " << buf;
-        return;
+    for (int i = 0; i < 3; ++i) {
+        if (readValues (fds[i], &val[i], 1) != 1) {
+            sensordLogW() << "Failed to read axis " << i;
+            return;
+        }
     }
 
-    switch (pathId) {
-        case X_AXIS:
-            currentData = buffer->nextSlot();                
-            currentData->timestamp_ = Utils::getTimeStamp();
-            currentData->x_ = qRound(val / CORRECTION_FACTOR);
-            break;
-        case Y_AXIS:
-            currentData->y_ = qRound(val / CORRECTION_FACTOR);
-            break;
-        case Z_AXIS:
-            currentData->z_ = qRound(val / CORRECTION_FACTOR);
-            buffer->commit();
-            buffer->wakeUpReaders();
-            break;
-        default:
-            sensordLogW() << "Invalid pathId: " << pathId;
-            break;
-    }
+    OrientationData* d = buffer->nextSlot();
+    d->timestamp_ = Utils::getTimeStamp();
+    d->x_ = qRound(val[0] / CORRECTION_FACTOR);
+    d->y_ = qRound(val[1] / CORRECTION_FACTOR);
+    d->z_ = qRound(val[2] / CORRECTION_FACTOR);
+    buffer->commit();
+    buffer->wakeUpReaders();
 }
 
+void Mpu6050AccelAdaptor::processScanFrames (int pathId, const char* frames, int count) {
+    Q_UNUSED(pathId);
+
+    const IioScanLayout& layout = scanLayout();
+
+    for (int i = 0; i < count; ++i) {
+        const char* frame = frames + i * layout.frameSize();
+        OrientationData* d = buffer->nextSlot();
+        d->timestamp_ = scanFrameTimeStamp(frames, i, count);
+        d->x_ = qRound(layout.value(frame, 0) / CORRECTION_FACTOR);
+        d->y_ = qRound(layout.value(frame, 1) / CORRECTION_FACTOR);
+        d->z_ = qRound(layout.value(frame, 2) / CORRECTION_FACTOR);
+        buffer->commit();
+    }
+    buffer->wakeUpReaders();
+}
@@ -28,9 +28,7 @@
 #include "datatypes/orientationdata.h"
 #include <QTime>
 
-#define X_AXIS 1
-#define Y_AXIS 2
-#define Z_AXIS 3
+#define XYZ_AXES 1
 
 class Mpu6050AccelAdaptor : public SysfsAdaptor {
     Q_OBJECT
@@ -47,9 +45,10 @@ class Mpu6050AccelAdaptor : public SysfsAdaptor {
 
     protected:
         void processSample (int pathId, int fd);
+        void processPathGroup (int groupId, const int* fds, int count);
+        void processScanFrames (int pathId, const char* frames, int count);
 
     private:
         DeviceAdaptorRingBuffer<OrientationData>* buffer;
-        OrientationData *currentData;
 };
 #endif
@@ -34,7 +34,7 @@
 MRSTAccelAdaptor::MRSTAccelAdaptor (const QString& id) :
     SysfsAdaptor (id, SysfsAdaptor::IntervalMode)
 {
-    buffer = new DeviceAdaptorRingBuffer<OrientationData>(1);
+    buffer = new DeviceAdaptorRingBuffer<OrientationData>(bufferCapacity(1));
     setAdaptedSensor("accelerometer", "MRST accelerometer", buffer);
     setDescription("MRST accelerometer");
 }
@@ -21,7 +21,7 @@ OaktrailAccelAdaptor::OaktrailAccelAdaptor (const QString& id) :
 
     devId = 0;
     addPath (devPath, devId);
-    buffer = new DeviceAdaptorRingBuffer<OrientationData>(128);
+    buffer = new DeviceAdaptorRingBuffer<OrientationData>(bufferCapacity(128));
     setAdaptedSensor("accelerometer", "Oaktrail accelerometer", buffer);
 
     setDescription("Oaktrail accelerometer");
@@ -36,7 +36,7 @@ OEMTabletALSAdaptorAscii::OEMTabletALSAdaptorAscii(const QString& id) : SysfsAda
     }
 
     addPath(devPath);
-    alsBuffer_ = new DeviceAdaptorRingBuffer<TimedUnsigned>(16);
+    alsBuffer_ = new DeviceAdaptorRingBuffer<TimedUnsigned>(bufferCapacity(16));
     setAdaptedSensor("als", "Internal ambient light sensor lux values", alsBuffer_);
 
     setDescription("Ambient light");
@@ -66,7 +66,7 @@ void OEMTabletALSAdaptorAscii::processSample(int pathId, int fd) {
     TimedUnsigned* lux = alsBuffer_->nextSlot();
 
     lux->value_ = idata;
-    lux->timestamp_ = Utils::getTimeStamp();
+    lux->timestamp_ = Utils::getCoarseTimeStamp();
 
     alsBuffer_->commit();
     alsBuffer_->wakeUpReaders();
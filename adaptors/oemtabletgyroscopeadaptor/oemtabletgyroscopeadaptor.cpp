@@ -9,7 +9,7 @@
 OEMTabletGyroscopeAdaptor::OEMTabletGyroscopeAdaptor(const QString& id) :
     SysfsAdaptor(id, SysfsAdaptor::IntervalMode)
 {
-    gyroscopeBuffer_ = new DeviceAdaptorRingBuffer<TimedXyzData>(32);
+    gyroscopeBuffer_ = new DeviceAdaptorRingBuffer<TimedXyzData>(bufferCapacity(32));
 
     setAdaptedSensor("gyroscope", "mpu3050", gyroscopeBuffer_);
 
@@ -15,7 +15,7 @@ OemtabletMagnetometerAdaptor::OemtabletMagnetometerAdaptor(const QString& id) :
         return;
     }
     addPath(SYSFS_MAGNET_PATH, devId);
-    magnetBuffer_ = new DeviceAdaptorRingBuffer<TimedXyzData>(16);
+    magnetBuffer_ = new DeviceAdaptorRingBuffer<TimedXyzData>(bufferCapacity(16));
     addAdaptedSensor("magnetometer", "ak8974 ascii", magnetBuffer_);
 
     setDescription("OEM tablet magnetometer");
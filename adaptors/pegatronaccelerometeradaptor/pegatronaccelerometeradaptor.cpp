@@ -26,7 +26,7 @@ PegatronAccelerometerAdaptor::PegatronAccelerometerAdaptor(const QString& id) :
         sensordLogW() << "Input device not found.";
     }
 
-    accelerometerBuffer_ = new DeviceAdaptorRingBuffer<OrientationData>(128);
+    accelerometerBuffer_ = new DeviceAdaptorRingBuffer<OrientationData>(bufferCapacity(128));
     setAdaptedSensor("accelerometer", "Internal accelerometer coordinates", accelerometerBuffer_);
 
     // Set Metadata
@@ -70,6 +70,11 @@ void PegatronAccelerometerAdaptor::interpretSync(int src, struct input_event *ev
     commitOutput(ev);
 }
 
+void PegatronAccelerometerAdaptor::wakeUpReaders()
+{
+    accelerometerBuffer_->wakeUpReaders();
+}
+
 void PegatronAccelerometerAdaptor::commitOutput(struct input_event *ev)
 {
     OrientationData* d = accelerometerBuffer_->nextSlot();
@@ -80,34 +85,22 @@ void PegatronAccelerometerAdaptor::commitOutput(struct input_event *ev)
     d->z_ = orientationValue_.z_;
 
     accelerometerBuffer_->commit();
-    accelerometerBuffer_->wakeUpReaders();
 }
 
 unsigned int PegatronAccelerometerAdaptor::evaluateIntervalRequests(int& sessionId) const
 {
-    unsigned int highestValue = 0;
-    int winningSessionId = -1;
-
-    if (m_intervalMap.size() == 0)
+    if (!hasIntervalRequests())
     {
-        sessionId = winningSessionId;
+        sessionId = -1;
         return defaultInterval();
     }
 
     // Get the smallest positive request, 0 is reserved for HW wakeup
-    QMap<int, unsigned int>::const_iterator it;
-    it = m_intervalMap.begin();
-    highestValue = it.value();
-    winningSessionId = it.key();
-
-    for (++it; it != m_intervalMap.constEnd(); ++it)
+    unsigned int value = fastestIntervalRequest(sessionId, 1);
+    if (sessionId < 0)
     {
-        if ((it.value() < highestValue) && (it.value() > 0)) {
-            highestValue = it.value();
-            winningSessionId = it.key();
-        }
+        fastestIntervalRequest(sessionId);
+        return defaultInterval();
     }
-
-    sessionId = winningSessionId;
-    return highestValue > 0 ? highestValue : defaultInterval();
+    return value;
 }
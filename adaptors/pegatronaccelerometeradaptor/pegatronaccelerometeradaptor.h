@@ -40,6 +40,7 @@ private:
     void interpretEvent(int src, struct input_event *ev);
     void commitOutput(struct input_event *ev);
     void interpretSync(int src, struct input_event *ev);
+    void wakeUpReaders();
 };
 
 #endif
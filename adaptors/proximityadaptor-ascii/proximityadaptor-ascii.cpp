@@ -41,7 +41,7 @@
 ProximityAdaptorAscii::ProximityAdaptorAscii(const QString& id) :
     SysfsAdaptor(id, SysfsAdaptor::IntervalMode)
 {
-    proximityBuffer_ = new DeviceAdaptorRingBuffer<ProximityData>(1);
+    proximityBuffer_ = new DeviceAdaptorRingBuffer<ProximityData>(bufferCapacity(1));
     setAdaptedSensor("proximity", "apds9802ps ascii", proximityBuffer_);
 }
 
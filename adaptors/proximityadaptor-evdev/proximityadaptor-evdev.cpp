@@ -41,9 +41,10 @@
 
 ProximityAdaptorEvdev::ProximityAdaptorEvdev(const QString& id) :
     InputDevAdaptor(id, 1),
-    currentState_(ProximityStateUnknown)
+    currentState_(ProximityStateUnknown),
+    committedState_(ProximityStateUnknown)
 {
-    proximityBuffer_ = new DeviceAdaptorRingBuffer<ProximityData>(1);
+    proximityBuffer_ = new DeviceAdaptorRingBuffer<ProximityData>(bufferCapacity(64));
     setAdaptedSensor("proximity", "Proximity state", proximityBuffer_);
 }
 
@@ -87,11 +88,21 @@ void ProximityAdaptorEvdev::interpretSync(int src, struct input_event *ev)
     commitOutput(ev);
 }
 
-void ProximityAdaptorEvdev::commitOutput(struct input_event *ev)
+void ProximityAdaptorEvdev::wakeUpReaders()
 {
-    static ProximityState oldState = ProximityStateUnknown;
+    proximityBuffer_->wakeUpReaders();
+}
 
-    if (currentState_ != oldState) {
+bool ProximityAdaptorEvdev::readInitialState(int pathId, int fd)
+{
+    // New users get the state even when it has not changed.
+    committedState_ = ProximityStateUnknown;
+    return InputDevAdaptor::readInitialState(pathId, fd);
+}
+
+void ProximityAdaptorEvdev::commitOutput(struct input_event *ev)
+{
+    if (currentState_ != committedState_) {
         sensordLogD() << "Proximity state change detected: " << currentState_;
 
         ProximityData *proximityData = proximityBuffer_->nextSlot();
@@ -99,9 +110,8 @@ void ProximityAdaptorEvdev::commitOutput(struct input_event *ev)
         proximityData->timestamp_ = Utils::getTimeStamp(&(ev->time));
         proximityData->withinProximity_ = currentState_;
 
-        oldState = currentState_;
+        committedState_ = currentState_;
 
         proximityBuffer_->commit();
-        proximityBuffer_->wakeUpReaders();
     }
 }
@@ -72,10 +72,13 @@ private:
 
     DeviceAdaptorRingBuffer<ProximityData>*   proximityBuffer_;
     ProximityState                            currentState_;
+    ProximityState                            committedState_;
 
     void interpretEvent(int src, struct input_event *ev);
     void commitOutput(struct input_event *ev);
     void interpretSync(int src, struct input_event *ev);
+    void wakeUpReaders();
+    bool readInitialState(int pathId, int fd);
 };
 
 #endif
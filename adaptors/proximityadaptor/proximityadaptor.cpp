@@ -53,21 +53,16 @@ ProximityAdaptor::ProximityAdaptor(const QString& id) :
     SysfsAdaptor(id, SysfsAdaptor::SelectMode, false)
 {
 
-#ifdef SENSORFW_MCE_WATCHER
-    dbusIfc_ = new QDBusInterface(MCE_SERVICE, MCE_REQUEST_PATH, MCE_REQUEST_IF,
-                                                 QDBusConnection::systemBus(), this);
-#endif
-
     deviceType_ = (DeviceType)Config::configuration()->value<int>("proximity/driver_type", 0);
     threshold_ = Config::configuration()->value<int>("proximity/threshold", 35);
     powerStatePath_ = Config::configuration()->value("proximity/powerstate_path").toByteArray();
     if (deviceType_ == RM696)
     {
 #ifdef SENSORFW_MCE_WATCHER
-        dbusIfc_->call(QDBus::NoBlock, "req_proximity_sensor_enable");
+        MceDispatcher::instance().setRequested("proximity", true, "req_proximity_sensor_enable", "req_proximity_sensor_disable");
 #endif
     }
-    proximityBuffer_ = new DeviceAdaptorRingBuffer<ProximityData>(1);
+    proximityBuffer_ = new DeviceAdaptorRingBuffer<ProximityData>(bufferCapacity(1));
     setAdaptedSensor("proximity", "Proximity state", proximityBuffer_);
     setDescription("Proximity sensor readings (Dipro sensor)");
 }
@@ -75,11 +70,8 @@ ProximityAdaptor::ProximityAdaptor(const QString& id) :
 ProximityAdaptor::~ProximityAdaptor()
 {
 #ifdef SENSORFW_MCE_WATCHER
-    if(dbusIfc_)
-    {
-        dbusIfc_->call(QDBus::NoBlock, "req_proximity_sensor_disable");
-        delete dbusIfc_;
-    }
+    if (deviceType_ == RM696)
+        MceDispatcher::instance().setRequested("proximity", false, "req_proximity_sensor_enable", "req_proximity_sensor_disable");
 #endif
     delete proximityBuffer_;
 }
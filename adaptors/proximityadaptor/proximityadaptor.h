@@ -29,7 +29,6 @@
 #ifndef PROXIMITYADAPTOR_H
 #define PROXIMITYADAPTOR_H
 
-#include <QDBusInterface>
 #include "sysfsadaptor.h"
 #include "deviceadaptorringbuffer.h"
 #include "datatypes/orientationdata.h"
@@ -37,6 +36,7 @@
 #ifdef SENSORFW_MCE_WATCHER
 #include <mce/mode-names.h>
 #include <mce/dbus-names.h>
+#include "mcedispatcher.h"
 #endif
 
 /**
@@ -96,10 +96,6 @@ private:
     ProximityAdaptor::DeviceType deviceType_;
     QByteArray powerStatePath_;
 
-#ifdef SENSORFW_MCE_WATCHER
-    QDBusInterface *dbusIfc_;
-#endif
-
 };
 
 #endif
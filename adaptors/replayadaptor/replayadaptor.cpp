@@ -0,0 +1,210 @@
+/**
+   @file replayadaptor.cpp
+   @brief ReplayAdaptor
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+*/
+
+
+#include "replayadaptor.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include "config.h"
+#include "logging.h"
+#include "datatypes/utils.h"
+
+/**
+ * Largest number of samples pushed per wakeup of the readers.
+ */
+static const unsigned int REPLAY_MAX_BATCH = 64;
+
+ReplayAdaptorThread::ReplayAdaptorThread(ReplayAdaptor* parent) :
+    running(false),
+    parent_(parent)
+{
+}
+
+void ReplayAdaptorThread::run()
+{
+    parent_->replay();
+}
+
+ReplayAdaptor::ReplayAdaptor(const QString& id, const QString& sensorName, quint32 type, int sampleSize) :
+    DeviceAdaptor(id),
+    thread_(new ReplayAdaptorThread(this)),
+    sensorName_(sensorName),
+    type_(type),
+    sampleSize_(sampleSize),
+    map_(NULL),
+    mapSize_(0),
+    samples_(NULL),
+    count_(0),
+    speed_(1.0),
+    loop_(false)
+{
+}
+
+ReplayAdaptor::~ReplayAdaptor()
+{
+    stopAdaptor();
+    delete thread_;
+}
+
+QString ReplayAdaptor::sensorName(const QString& id)
+{
+    return id.endsWith("adaptor") ? id.left(id.length() - 7) : id;
+}
+
+bool ReplayAdaptor::startAdaptor()
+{
+    QString path = Config::configuration()->value<QString>(sensorName_ + "/replay_file", "");
+    if (path.isEmpty()) {
+        sensordLogW() << id() << ": no " << sensorName_ << "/replay_file configured";
+        return false;
+    }
+
+    int fd = open(path.toLocal8Bit().constData(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        sensordLogW() << id() << ": failed to open " << path << ": " << strerror(errno);
+        return false;
+    }
+    struct stat st;
+    void* map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(SampleRecordingHeader))
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        sensordLogW() << id() << ": failed to map " << path;
+        return false;
+    }
+
+    const SampleRecordingHeader* header = (const SampleRecordingHeader*)map;
+    if (header->magic != SAMPLE_RECORDING_MAGIC ||
+        header->version != SAMPLE_RECORDING_VERSION ||
+        header->type != type_ ||
+        header->sampleSize != (quint32)sampleSize_ ||
+        header->count == 0 ||
+        header->count > (st.st_size - sizeof(SampleRecordingHeader)) / sampleSize_) {
+        sensordLogW() << id() << ": " << path << " is not a valid trace for " << sensorName_;
+        munmap(map, st.st_size);
+        return false;
+    }
+
+    map_ = (char*)map;
+    mapSize_ = st.st_size;
+    samples_ = map_ + sizeof(SampleRecordingHeader);
+    count_ = header->count;
+    madvise(map_, mapSize_, MADV_SEQUENTIAL);
+    sensordLogD() << id() << ": replaying " << count_ << " samples from " << path;
+    return true;
+}
+
+void ReplayAdaptor::stopAdaptor()
+{
+    if (!map_)
+        return;
+    munmap(map_, mapSize_);
+    map_ = NULL;
+    mapSize_ = 0;
+    samples_ = NULL;
+    count_ = 0;
+}
+
+bool ReplayAdaptor::startSensor()
+{
+    if (!map_ || thread_->isRunning())
+        return false;
+
+    Config* config = Config::configuration();
+    speed_ = qMax(0.0, config->value<double>(sensorName_ + "/replay_speed", 1.0));
+    loop_ = config->value<bool>(sensorName_ + "/replay_loop", false);
+
+    thread_->running = true;
+    thread_->start();
+    return true;
+}
+
+void ReplayAdaptor::stopSensor()
+{
+    thread_->running = false;
+    thread_->wait();
+}
+
+void ReplayAdaptor::init()
+{
+}
+
+quint64 ReplayAdaptor::traceTime(quint64 index) const
+{
+    // Every sample type starts with the TimedData timestamp.
+    quint64 timestamp;
+    memcpy(&timestamp, samples_ + sampleSize_ * index, sizeof(timestamp));
+    return timestamp;
+}
+
+void ReplayAdaptor::replay()
+{
+    quint64 first = traceTime(0);
+    quint64 duration = traceTime(count_ - 1) - first;
+    // A looped trace continues one average interval after its last sample.
+    quint64 period = duration + (count_ > 1 ? duration / (count_ - 1) : 1000);
+    quint64 start = Utils::getTimeStamp();
+    quint64 pass = 0;
+    quint64 pos = 0;
+    quint64 timestamps[REPLAY_MAX_BATCH];
+
+    while (thread_->running) {
+        unsigned int n = 0;
+        quint64 now = Utils::getTimeStamp();
+        while (n < REPLAY_MAX_BATCH && pos + n < count_) {
+            quint64 elapsed = traceTime(pos + n) - first + pass * period;
+            quint64 due = start + (speed_ > 0 ? (quint64)(elapsed / speed_) : elapsed);
+            if (speed_ > 0 && due > now) {
+                if (n)
+                    break;
+                struct timespec deadline;
+                deadline.tv_sec = due / 1000000;
+                deadline.tv_nsec = (due % 1000000) * 1000;
+                clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+                if (!thread_->running)
+                    return;
+                now = Utils::getTimeStamp();
+                continue;
+            }
+            timestamps[n++] = due;
+        }
+
+        writeSamples(samples_ + sampleSize_ * pos, n, timestamps);
+        wakeUpReaders();
+
+        pos += n;
+        if (pos == count_) {
+            if (!loop_) {
+                sensordLogD() << id() << ": end of trace";
+                return;
+            }
+            pos = 0;
+            ++pass;
+        }
+    }
+}
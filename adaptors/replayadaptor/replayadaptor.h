@@ -0,0 +1,210 @@
+/**
+   @file replayadaptor.h
+   @brief ReplayAdaptor
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+*/
+
+
+#ifndef REPLAYADAPTOR_H
+#define REPLAYADAPTOR_H
+
+#include <QThread>
+#include <string.h>
+#include "deviceadaptor.h"
+#include "deviceadaptorringbuffer.h"
+#include "samplerecording.h"
+#include "datatypes/timedunsigned.h"
+#include "datatypes/genericdata.h"
+#include "datatypes/orientationdata.h"
+
+class ReplayAdaptor;
+
+/**
+ * Thread replaying the trace.
+ */
+class ReplayAdaptorThread : public QThread
+{
+public:
+    ReplayAdaptorThread(ReplayAdaptor* parent);
+    void run();
+    volatile bool running;
+
+private:
+    ReplayAdaptor* parent_;
+};
+
+/**
+ * @brief Adaptor replaying a recorded trace file
+ *
+ * The trace (see SampleRecordingHeader) is memory mapped when the adaptor
+ * is created and replayed from the beginning every time the sensor is
+ * started. Replay is configured in the group of the adapted sensor,
+ * e.g. for <tt>accelerometeradaptor</tt>:
+ *
+ * <pre>
+ * [plugins]
+ * accelerometeradaptor = replayadaptor
+ *
+ * [accelerometer]
+ * replay_file = /home/user/walking.trace
+ * replay_speed = 1.0
+ * replay_loop = true
+ * </pre>
+ *
+ * - \c replay_speed 1.0 replays in real time, 2.0 twice as fast and
+ *   0 as fast as possible.
+ * - \c replay_loop restarts from the beginning after the last sample.
+ *
+ * Sample timestamps are rebased to the time the replay started, the
+ * spacing of the samples in the trace is divided by the speed. When
+ * replaying as fast as possible the original spacing is kept, so the
+ * chains see the same data in every run.
+ *
+ * Traces are written by the recording mode of sensord, see
+ * SensorManager::startRecording().
+ */
+class ReplayAdaptor : public DeviceAdaptor
+{
+    Q_OBJECT
+public:
+    bool startAdaptor();
+    void stopAdaptor();
+
+    bool startSensor();
+    void stopSensor();
+
+    void init();
+
+protected:
+    /**
+     * Constructor.
+     *
+     * @param id adaptor ID.
+     * @param sensorName name of the adapted sensor, also the
+     *                   configuration group.
+     * @param type SampleRecordingTypeId of the samples.
+     * @param sampleSize size of a sample.
+     */
+    ReplayAdaptor(const QString& id, const QString& sensorName, quint32 type, int sampleSize);
+
+    /**
+     * Destructor.
+     */
+    ~ReplayAdaptor();
+
+    /**
+     * Copy samples from the trace into the output buffer with new
+     * timestamps.
+     *
+     * @param samples first sample in the trace.
+     * @param count number of samples.
+     * @param timestamps replay timestamps of the samples.
+     */
+    virtual void writeSamples(const char* samples, unsigned int count, const quint64* timestamps) = 0;
+
+    /**
+     * Wake up readers of the output buffer.
+     */
+    virtual void wakeUpReaders() = 0;
+
+    /**
+     * Name of the adapted sensor for given adaptor ID.
+     *
+     * @param id adaptor ID, e.g. accelerometeradaptor.
+     * @return sensor name, e.g. accelerometer.
+     */
+    static QString sensorName(const QString& id);
+
+private:
+    friend class ReplayAdaptorThread;
+
+    /**
+     * Replay the trace until stopped or the end of a trace which is not
+     * looped.
+     */
+    void replay();
+
+    /**
+     * Timestamp of a sample in the trace.
+     *
+     * @param index sample index.
+     * @return timestamp in microseconds.
+     */
+    quint64 traceTime(quint64 index) const;
+
+    ReplayAdaptorThread* thread_;     /**< replay thread */
+    QString              sensorName_; /**< adapted sensor name */
+    quint32              type_;       /**< expected sample type */
+    int                  sampleSize_; /**< expected sample size */
+    char*                map_;        /**< mapped trace or NULL */
+    size_t               mapSize_;    /**< size of the mapping */
+    const char*          samples_;    /**< first sample */
+    quint64              count_;      /**< number of samples */
+    double               speed_;      /**< replay speed, 0 for unthrottled */
+    bool                 loop_;       /**< restart after the last sample */
+};
+
+/**
+ * @brief Replay adaptor for given sample type
+ */
+template <class TYPE>
+class ReplayTypedAdaptor : public ReplayAdaptor
+{
+public:
+    static DeviceAdaptor* factoryMethod(const QString& id)
+    {
+        return new ReplayTypedAdaptor<TYPE>(id);
+    }
+
+protected:
+    ReplayTypedAdaptor(const QString& id) :
+        ReplayAdaptor(id, sensorName(id), SampleRecordingType<TYPE>::TYPE_ID, sizeof(TYPE))
+    {
+        buffer_ = new DeviceAdaptorRingBuffer<TYPE>(1024);
+        setAdaptedSensor(sensorName(id), "Replayed " + sensorName(id) + " trace", buffer_);
+        setDescription("Replay of a recorded trace");
+    }
+
+    ~ReplayTypedAdaptor()
+    {
+        stopSensor();
+        delete buffer_;
+    }
+
+    void writeSamples(const char* samples, unsigned int count, const quint64* timestamps)
+    {
+        for (unsigned int i = 0; i < count; ++i) {
+            TYPE* data = buffer_->nextSlot();
+            memcpy((void*)data, samples + sizeof(TYPE) * i, sizeof(TYPE));
+            data->timestamp_ = timestamps[i];
+            buffer_->commit();
+        }
+    }
+
+    void wakeUpReaders()
+    {
+        buffer_->wakeUpReaders();
+    }
+
+private:
+    DeviceAdaptorRingBuffer<TYPE>* buffer_;
+};
+
+#endif // REPLAYADAPTOR_H
@@ -0,0 +1,44 @@
+/**
+   @file replayadaptorplugin.cpp
+   @brief Plugin for ReplayAdaptor
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+*/
+
+
+#include "replayadaptorplugin.h"
+#include "replayadaptor.h"
+#include "sensormanager.h"
+#include "logging.h"
+
+void ReplayAdaptorPlugin::Register(class Loader&)
+{
+    sensordLogD() << "registering replayadaptor";
+    SensorManager& sm = SensorManager::instance();
+    // Only the adaptors mapped to this plugin in [plugins] are requested.
+    sm.registerDeviceAdaptor<ReplayTypedAdaptor<TimedUnsigned> >("alsadaptor");
+    sm.registerDeviceAdaptor<ReplayTypedAdaptor<AccelerationData> >("accelerometeradaptor");
+    sm.registerDeviceAdaptor<ReplayTypedAdaptor<TimedXyzData> >("magnetometeradaptor");
+    sm.registerDeviceAdaptor<ReplayTypedAdaptor<TimedXyzData> >("gyroscopeadaptor");
+    sm.registerDeviceAdaptor<ReplayTypedAdaptor<ProximityData> >("proximityadaptor");
+}
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+Q_EXPORT_PLUGIN2(replayadaptor, ReplayAdaptorPlugin)
+#endif
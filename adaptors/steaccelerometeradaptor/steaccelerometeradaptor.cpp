@@ -16,7 +16,7 @@
 SteAccelAdaptor::SteAccelAdaptor(const QString& id) :
     SysfsAdaptor(id, SysfsAdaptor::IntervalMode)
 {
-    buffer = new DeviceAdaptorRingBuffer<OrientationData>(128);
+    buffer = new DeviceAdaptorRingBuffer<OrientationData>(bufferCapacity(128));
     setAdaptedSensor("accelerometer", "ste accelerometer", buffer);
     introduceAvailableInterval(DataRange(50, 1000, 0));
 
@@ -36,7 +36,7 @@
 TapAdaptor::TapAdaptor(const QString& id) :
     InputDevAdaptor(id, 1)
 {
-    tapBuffer_ = new DeviceAdaptorRingBuffer<TapData>(1);
+    tapBuffer_ = new DeviceAdaptorRingBuffer<TapData>(bufferCapacity(64));
     setAdaptedSensor("tap", "Internal accelerometer tap events", tapBuffer_);
     setDescription("Device tap events (lis302d)");
 }
@@ -82,6 +82,11 @@ void TapAdaptor::interpretSync(int src, struct input_event *ev)
     Q_UNUSED(ev);
 }
 
+void TapAdaptor::wakeUpReaders()
+{
+    tapBuffer_->wakeUpReaders();
+}
+
 void TapAdaptor::commitOutput(const TapData& data)
 {
     TapData* d = tapBuffer_->nextSlot();
@@ -91,7 +96,6 @@ void TapAdaptor::commitOutput(const TapData& data)
     d->type_ = data.type_;
 
     tapBuffer_->commit();
-    tapBuffer_->wakeUpReaders();
 }
 
 bool TapAdaptor::setInterval(const unsigned int, const int)
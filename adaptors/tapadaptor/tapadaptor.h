@@ -66,6 +66,7 @@ private:
 
     void interpretEvent(int src, struct input_event *ev);
     void interpretSync(int src, struct input_event *ev);
+    void wakeUpReaders();
     void commitOutput(const TapData& data);
 };
 
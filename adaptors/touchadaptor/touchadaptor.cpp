@@ -28,6 +28,7 @@
 
 #include "touchadaptor.h"
 #include "datatypes/utils.h"
+#include "inputdevicecache.h"
 #include <errno.h>
 #include <fcntl.h>
 #include <linux/input.h>
@@ -36,7 +37,9 @@ const int TouchAdaptor::HARD_MAX_TOUCH_POINTS = 5;
 
 TouchAdaptor::TouchAdaptor(const QString& id) : InputDevAdaptor(id, HARD_MAX_TOUCH_POINTS)
 {
-    outputBuffer_ = new DeviceAdaptorRingBuffer<TouchData>(1);
+    // Room for a few complete frames, so a lagging reader does not lose
+    // contacts of a frame.
+    outputBuffer_ = new DeviceAdaptorRingBuffer<TouchData>(bufferCapacity(MAX_SLOTS * 32));
     setAdaptedSensor("touch", "Touch screen input", outputBuffer_);
     setDescription("Touch screen events");
 }
@@ -50,44 +53,25 @@ bool TouchAdaptor::checkInputDevice(QString path, QString matchString)
 {
     Q_UNUSED(matchString);
 
-    int fd;
-    char deviceName[256];
-    unsigned char evtype_bitmask[20+1];
-
-    fd = open(path.toLocal8Bit().constData(), O_RDONLY);
-    if (fd == -1) {
+    InputDeviceCache::Device device;
+    if (!InputDeviceCache::instance().device(path, device)) {
         return false;
     }
 
-    ioctl(fd, EVIOCGNAME(sizeof(deviceName)), deviceName);
-
-    if (ioctl(fd, EVIOCGBIT(0, sizeof(evtype_bitmask)), evtype_bitmask) < 0) {
-        sensordLogW() << __PRETTY_FUNCTION__ << deviceName << "EVIOCGBIT error";
-        close(fd);
+    if (!device.hasEventType(EV_ABS)) {
         return false;
     }
 
-#define test_bit(bit, array)    (array[bit/8] & (1<<(bit%8)))
-
-    if (!test_bit(EV_ABS, evtype_bitmask)) {
-        close(fd);
+    if (!device.hasAbsAxis(ABS_X) || !device.hasAbsAxis(ABS_Y)) {
+        sensordLogW() << __PRETTY_FUNCTION__ << device.name << "Testbit ABS_X or ABS_Y failed.";
         return false;
     }
 
-    if (ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(evtype_bitmask)), evtype_bitmask) < 0) {
-        sensordLogW() << __PRETTY_FUNCTION__ << deviceName << "EVIOGBIT EV_ABS error.";
-        close(fd);
-        return false;
-    }
-
-    if (!test_bit(ABS_X, evtype_bitmask) || !test_bit(ABS_Y, evtype_bitmask)) {
-        sensordLogW() << __PRETTY_FUNCTION__ << deviceName << "Testbit ABS_X or ABS_Y failed.";
-        close(fd);
+    int fd = open(path.toLocal8Bit().constData(), O_RDONLY);
+    if (fd == -1) {
         return false;
     }
 
-#undef test_bit
-
     // Final range is defined by the last found event handle.
     // Make separate for each input device if necessary.
     struct input_absinfo info;
@@ -106,6 +90,15 @@ bool TouchAdaptor::checkInputDevice(QString path, QString matchString)
 
 void TouchAdaptor::interpretEvent(int src, struct input_event *ev)
 {
+    if (src < 0 || src >= HARD_MAX_TOUCH_POINTS || slotStates_[src].dropping) {
+        return;
+    }
+
+    if (ev->type == EV_ABS && ev->code >= ABS_MT_SLOT) {
+        interpretMultiTouchEvent(src, ev);
+        return;
+    }
+
     switch (ev->type) {
 
         case EV_SYN:
@@ -146,9 +139,98 @@ void TouchAdaptor::interpretEvent(int src, struct input_event *ev)
     }
 }
 
+void TouchAdaptor::interpretMultiTouchEvent(int src, struct input_event *ev)
+{
+    SlotState& state = slotStates_[src];
+    state.multiTouch = true;
+
+    if (ev->code == ABS_MT_SLOT) {
+        state.slot = ev->value;
+        return;
+    }
+    if (state.slot < 0 || state.slot >= MAX_SLOTS) {
+        return;
+    }
+
+    TouchValues& contact = state.contacts[state.slot];
+    switch (ev->code) {
+        case ABS_MT_TRACKING_ID:
+            contact.fingerState = (ev->value < 0) ? TouchData::FingerStateNotPresent : TouchData::FingerStateAccurate;
+            break;
+        case ABS_MT_POSITION_X:
+            contact.x = ev->value;
+            break;
+        case ABS_MT_POSITION_Y:
+            contact.y = ev->value;
+            break;
+        case ABS_MT_PRESSURE:
+            contact.z = ev->value;
+            break;
+        case ABS_MT_TOUCH_MAJOR:
+            contact.volume = ev->value;
+            break;
+        case ABS_MT_WIDTH_MAJOR:
+            contact.toolWidth = ev->value;
+            break;
+        default:
+            return;
+    }
+    contact.changed = true;
+}
+
 void TouchAdaptor::interpretSync(int src, struct input_event *ev)
 {
-    commitOutput(src, ev);
+    if (src < 0 || src >= HARD_MAX_TOUCH_POINTS) {
+        return;
+    }
+
+    SlotState& state = slotStates_[src];
+    if (ev->code == SYN_DROPPED) {
+        // Events up to the next report are incomplete.
+        state.dropping = true;
+        return;
+    }
+    if (ev->code != SYN_REPORT) {
+        return;
+    }
+    if (state.dropping) {
+        state.dropping = false;
+        return;
+    }
+
+    if (state.multiTouch) {
+        commitFrame(src, ev);
+    } else {
+        commitOutput(src, ev);
+    }
+}
+
+void TouchAdaptor::commitFrame(int src, struct input_event *ev)
+{
+    quint64 timestamp = Utils::getTimeStamp(&(ev->time));
+
+    for (int i = 0; i < MAX_SLOTS; ++i) {
+        TouchValues& contact = slotStates_[src].contacts[i];
+        if (contact.fingerState == TouchData::FingerStateNotPresent && !contact.changed) {
+            continue;
+        }
+
+        TouchData* d = outputBuffer_->nextSlot();
+        d->timestamp_ = timestamp;
+        d->x_ = contact.x;
+        d->y_ = contact.y;
+        d->z_ = contact.z;
+        d->object_ = i;
+        d->state_ = contact.fingerState;
+        outputBuffer_->commit();
+
+        contact.changed = false;
+    }
+}
+
+void TouchAdaptor::wakeUpReaders()
+{
+    outputBuffer_->wakeUpReaders();
 }
 
 void TouchAdaptor::commitOutput(int src, struct input_event *ev)
@@ -163,5 +245,4 @@ void TouchAdaptor::commitOutput(int src, struct input_event *ev)
     d->state_ = touchValues_[src].fingerState;
 
     outputBuffer_->commit();
-    outputBuffer_->wakeUpReaders();
 }
@@ -36,7 +36,11 @@
 /**
  * @brief Adaptor for device touchscreen.
  *
- * Provides input data from touchscreen input device.
+ * Provides input data from touchscreen input device. Devices using the
+ * multi-touch protocol B are tracked per slot; on each SYN_REPORT every
+ * active contact, and contacts lifted since the previous report, are
+ * committed with the same timestamp, \c object_ being the slot. Older
+ * single touch devices commit one sample per report.
  */
 class TouchAdaptor : public InputDevAdaptor
 {
@@ -63,16 +67,36 @@ private:
 
     static const int HARD_MAX_TOUCH_POINTS;
 
+    /**
+     * Number of multi-touch slots tracked per device.
+     */
+    static const int MAX_SLOTS = 10;
+
     /**
      * Holds values read from the driver.
      */
     struct TouchValues {
+        TouchValues() : x(0), y(0), z(0), volume(0), toolWidth(0), fingerState(TouchData::FingerStateNotPresent), changed(false) {}
+
         int x;
         int y;
         int z;
         int volume;
         int toolWidth;
         TouchData::FingerState fingerState;
+        bool changed;       /**< has contact changed since last report */
+    };
+
+    /**
+     * Multi-touch state of an input device.
+     */
+    struct SlotState {
+        SlotState() : slot(0), multiTouch(false), dropping(false) {}
+
+        int slot;           /**< slot the following events refer to */
+        bool multiTouch;    /**< has device sent protocol B events */
+        bool dropping;      /**< discarding events after SYN_DROPPED */
+        TouchValues contacts[MAX_SLOTS]; /**< contacts by slot */
     };
 
     /**
@@ -106,10 +130,26 @@ private:
      */
     void commitOutput(int src, struct input_event *ev);
 
+    /**
+     * Interpret a multi-touch protocol B event.
+     * @param src Event source.
+     * @param ev  Read event.
+     */
+    void interpretMultiTouchEvent(int src, struct input_event *ev);
+
+    /**
+     * Commit all active and lifted contacts of a device as one frame.
+     * @param src Event source.
+     * @param ev  Sync event.
+     */
+    void commitFrame(int src, struct input_event *ev);
+
     void interpretSync(int src, struct input_event *ev);
+    void wakeUpReaders();
 
     DeviceAdaptorRingBuffer<TouchData>* outputBuffer_;
     TouchValues touchValues_[5];
+    SlotState slotStates_[5];
     RangeInfo rangeInfo_;
 };
 
@@ -0,0 +1,25 @@
+TEMPLATE = lib
+TARGET = sensorfw-c
+
+# Native clients must not need Qt, the library only uses libdbus.
+CONFIG -= qt
+CONFIG += link_pkgconfig
+PKGCONFIG += dbus-1
+
+# Protocol headers are installed too, for clients speaking it directly.
+HEADERS += sensorfw-c.h \
+    ../include/sessionprotocol.h \
+    ../include/sessionframe.h \
+    ../include/sharedring.h
+
+SOURCES += sensorfw-c.cpp
+
+SENSORFW_INCLUDEPATHS = .. \
+    ../include
+DEPENDPATH += $$SENSORFW_INCLUDEPATHS
+INCLUDEPATH += $$SENSORFW_INCLUDEPATHS
+
+include(../common-install.pri)
+publicheaders.files = $$HEADERS
+target.path = $$SHAREDLIBPATH
+INSTALLS += target
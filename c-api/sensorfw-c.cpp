@@ -0,0 +1,814 @@
+/**
+   @file sensorfw-c.cpp
+   @brief C-API for sensor framework
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "sensorfw-c.h"
+#include "sessionprotocol.h"
+
+#include <dbus/dbus.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+static const char* SERVICE_NAME = "com.nokia.SensorService";
+static const char* OBJECT_PATH = "/SensorManager";
+static const char* MANAGER_INTERFACE = "local.SensorManager";
+
+/** How long to wait for D-Bus replies in milliseconds */
+static const int CALL_TIMEOUT = 5000;
+/** How long to wait for the handshake on the data socket in milliseconds */
+static const int HANDSHAKE_TIMEOUT = 1000;
+
+namespace {
+
+struct Session
+{
+    Session() :
+        id(-1), fd(-1), sampleSize(0), running(false),
+        ringSize(0), ringDropped(0),
+        callback(NULL), userData(NULL),
+        dropped(0),
+        error(SENSORFW_NO_ERROR)
+    {
+    }
+
+    int id;
+    std::string sensor;               /**< sensor name without parameters */
+    std::string path;                 /**< D-Bus object path of the sensor */
+    int fd;                           /**< data socket */
+    unsigned int sampleSize;          /**< size of a single sample */
+    bool running;                     /**< has sensor been started */
+
+    SharedRingReader ring;            /**< shared memory ring, if used */
+    size_t ringSize;                  /**< size of the ring mapping */
+    unsigned int ringDropped;         /**< drop count of sensord already accounted */
+
+    sensorfw_callback_t callback;     /**< batch callback */
+    void* userData;                   /**< passed to callback */
+
+    std::vector<char> input;          /**< bytes of incomplete frames */
+    std::vector<char> samples;        /**< complete samples not yet delivered */
+    SessionSequence sequence;         /**< sequence numbers of received frames */
+    unsigned int dropped;             /**< samples lost since last batch */
+
+    std::string description;          /**< storage for description */
+    int error;                        /**< last error code */
+    std::string errorString;          /**< last error description */
+};
+
+}
+
+static pthread_mutex_t sessionsMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::map<int, Session*> sessions;
+static Session globalErrors;
+
+/**
+ * Keeps the session table locked for the lifetime of the object and
+ * looks up the session, if given.
+ */
+class SessionLocker
+{
+public:
+    SessionLocker(int sessionId = -1) : session_(NULL)
+    {
+        pthread_mutex_lock(&sessionsMutex);
+        std::map<int, Session*>::iterator it = sessions.find(sessionId);
+        if (it != sessions.end())
+            session_ = it->second;
+        else if (sessionId != -1)
+            setError(&globalErrors, SENSORFW_INVALID_SESSION, "Invalid session ID");
+    }
+
+    ~SessionLocker()
+    {
+        pthread_mutex_unlock(&sessionsMutex);
+    }
+
+    Session* session() const { return session_; }
+
+    static void setError(Session* session, int code, const std::string& message)
+    {
+        session->error = code;
+        session->errorString = message;
+    }
+
+private:
+    Session* session_;
+};
+
+static void setError(Session* session, int code, const std::string& message)
+{
+    SessionLocker::setError(session ? session : &globalErrors, code, message);
+}
+
+static std::string errnoString(const char* what)
+{
+    return std::string(what) + ": " + strerror(errno);
+}
+
+static std::string cleanId(const char* sensorName)
+{
+    std::string id(sensorName ? sensorName : "");
+    size_t pos = id.find(';');
+    return pos == std::string::npos ? id : id.substr(0, pos);
+}
+
+/* D-Bus */
+
+static DBusConnection* bus(Session* session)
+{
+    static DBusConnection* connection = NULL;
+    if (!connection)
+    {
+        DBusError error;
+        dbus_error_init(&error);
+        connection = dbus_bus_get(DBUS_BUS_SYSTEM, &error);
+        if (!connection)
+        {
+            setError(session, SENSORFW_DBUS_ERROR, error.message ? error.message : "Failed to connect to system bus");
+            dbus_error_free(&error);
+            return NULL;
+        }
+        dbus_connection_set_exit_on_disconnect(connection, FALSE);
+    }
+    return connection;
+}
+
+/**
+ * Call a method and wait for the reply. Arguments are given like for
+ * dbus_message_append_args(), terminated with DBUS_TYPE_INVALID.
+ *
+ * @return reply to be unreferenced by caller, NULL on failure.
+ */
+static DBusMessage* call(Session* session, const char* path, const char* interface, const char* method, int firstType, ...)
+{
+    DBusConnection* connection = bus(session);
+    if (!connection)
+        return NULL;
+
+    DBusMessage* message = dbus_message_new_method_call(SERVICE_NAME, path, interface, method);
+    if (!message)
+    {
+        setError(session, SENSORFW_DBUS_ERROR, "Out of memory");
+        return NULL;
+    }
+
+    va_list args;
+    va_start(args, firstType);
+    dbus_bool_t appended = dbus_message_append_args_valist(message, firstType, args);
+    va_end(args);
+    if (!appended)
+    {
+        dbus_message_unref(message);
+        setError(session, SENSORFW_DBUS_ERROR, "Failed to append arguments");
+        return NULL;
+    }
+
+    DBusError error;
+    dbus_error_init(&error);
+    DBusMessage* reply = dbus_connection_send_with_reply_and_block(connection, message, CALL_TIMEOUT, &error);
+    dbus_message_unref(message);
+    if (!reply)
+    {
+        setError(session, SENSORFW_DBUS_ERROR, std::string(method) + ": " + (error.message ? error.message : "no reply"));
+        dbus_error_free(&error);
+    }
+    return reply;
+}
+
+/**
+ * Read the first argument of a reply, unwrapping a variant.
+ */
+static bool replyValue(Session* session, DBusMessage* reply, int type, void* value)
+{
+    if (!reply)
+        return false;
+
+    DBusMessageIter iter;
+    DBusMessageIter variant;
+    DBusMessageIter* arg = &iter;
+    bool ok = dbus_message_iter_init(reply, &iter);
+    if (ok && dbus_message_iter_get_arg_type(&iter) == DBUS_TYPE_VARIANT)
+    {
+        dbus_message_iter_recurse(&iter, &variant);
+        arg = &variant;
+    }
+    ok = ok && dbus_message_iter_get_arg_type(arg) == type;
+    if (ok)
+        dbus_message_iter_get_basic(arg, value);
+    else
+        setError(session, SENSORFW_DBUS_ERROR, "Unexpected reply type");
+    dbus_message_unref(reply);
+    return ok;
+}
+
+/**
+ * Call a sensor method which returns nothing.
+ */
+static bool callVoid(Session* session, const char* method, int firstType, ...)
+{
+    // Sensor interface names differ per sensor, QtDBus finds the method
+    // without one.
+    DBusConnection* connection = bus(session);
+    if (!connection)
+        return false;
+    DBusMessage* message = dbus_message_new_method_call(SERVICE_NAME, session->path.c_str(), NULL, method);
+    if (!message)
+        return false;
+
+    va_list args;
+    va_start(args, firstType);
+    dbus_bool_t appended = dbus_message_append_args_valist(message, firstType, args);
+    va_end(args);
+
+    DBusError error;
+    dbus_error_init(&error);
+    DBusMessage* reply = appended ? dbus_connection_send_with_reply_and_block(connection, message, CALL_TIMEOUT, &error) : NULL;
+    dbus_message_unref(message);
+    if (!reply)
+    {
+        setError(session, SENSORFW_DBUS_ERROR, std::string(method) + ": " + (error.message ? error.message : "failed"));
+        dbus_error_free(&error);
+        return false;
+    }
+    dbus_message_unref(reply);
+    return true;
+}
+
+static bool property(Session* session, const char* name, int type, void* value)
+{
+    const char* interface = "";
+    DBusMessage* reply = call(session, session->path.c_str(), DBUS_INTERFACE_PROPERTIES, "Get",
+                              DBUS_TYPE_STRING, &interface,
+                              DBUS_TYPE_STRING, &name,
+                              DBUS_TYPE_INVALID);
+    return replyValue(session, reply, type, value);
+}
+
+/* Data connection */
+
+static bool waitReadable(int fd)
+{
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    return poll(&pfd, 1, HANDSHAKE_TIMEOUT) > 0;
+}
+
+static bool receiveSharedRing(Session* session)
+{
+    if (!waitReadable(session->fd))
+        return false;
+
+    char reply = 0;
+    struct iovec iov;
+    iov.iov_base = &reply;
+    iov.iov_len = 1;
+    char control[CMSG_SPACE(sizeof(int))];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (recvmsg(session->fd, &msg, MSG_CMSG_CLOEXEC) != 1)
+        return false;
+
+    int fd = -1;
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+        memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    if (reply != SHARED_RING_ACCEPTED || fd < 0)
+    {
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+
+    struct stat st;
+    void* mem = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(SharedRingHeader))
+        mem = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED)
+        return false;
+
+    if (!session->ring.attach((const SharedRingHeader*)mem, st.st_size))
+    {
+        munmap(mem, st.st_size);
+        return false;
+    }
+
+    session->ringSize = st.st_size;
+    session->ringDropped = session->ring.dropCount();
+    return true;
+}
+
+static bool connectData(Session* session, bool sharedMemory)
+{
+    session->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (session->fd < 0)
+    {
+        setError(session, SENSORFW_SOCKET_ERROR, errnoString("socket"));
+        return false;
+    }
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, SESSION_SOCKET_PATH, sizeof(address.sun_path) - 1);
+    if (connect(session->fd, (struct sockaddr*)&address, sizeof(address)) < 0)
+    {
+        setError(session, SENSORFW_SOCKET_ERROR, errnoString("connect"));
+        return false;
+    }
+
+    // sensord greets every connection with a single byte.
+    char tag = 0;
+    if (!waitReadable(session->fd) || recv(session->fd, &tag, 1, 0) != 1)
+    {
+        setError(session, SENSORFW_SOCKET_ERROR, "No greeting from sensord");
+        return false;
+    }
+
+    SessionRequest request;
+    size_t length = sessionRequestEncode(session->id, sharedMemory, request);
+    if (send(session->fd, &request, length, MSG_NOSIGNAL) != (ssize_t)length)
+    {
+        setError(session, SENSORFW_SOCKET_ERROR, errnoString("send"));
+        return false;
+    }
+    // Without the ring the session simply stays on the socket.
+    if (sharedMemory)
+        receiveSharedRing(session);
+
+    int flags = fcntl(session->fd, F_GETFL);
+    fcntl(session->fd, F_SETFL, flags | O_NONBLOCK);
+    return true;
+}
+
+static void disconnectData(Session* session)
+{
+    if (session->fd >= 0)
+        close(session->fd);
+    session->fd = -1;
+    if (session->ring.ring())
+        munmap((void*)session->ring.ring(), session->ringSize);
+    session->ring.detach();
+    session->sequence.reset();
+}
+
+/**
+ * Read whatever has arrived on the socket without blocking.
+ */
+static bool receive(Session* session)
+{
+    char chunk[4096];
+    for (;;)
+    {
+        ssize_t bytes = recv(session->fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+        if (bytes > 0)
+        {
+            // With shared memory the socket only carries doorbells.
+            if (!session->ring.ring())
+                session->input.insert(session->input.end(), chunk, chunk + bytes);
+            continue;
+        }
+        if (bytes == 0)
+        {
+            setError(session, SENSORFW_SOCKET_ERROR, "Connection closed by sensord");
+            return false;
+        }
+        if (errno == EINTR)
+            continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return true;
+        setError(session, SENSORFW_SOCKET_ERROR, errnoString("recv"));
+        return false;
+    }
+}
+
+/**
+ * Move complete frames from the input to the sample queue.
+ */
+static bool parseFrames(Session* session)
+{
+    size_t offset = 0;
+    bool ok = true;
+    while (offset < session->input.size())
+    {
+        SessionFrameView frame;
+        SessionFrameView::Status status = frame.parse(&session->input[offset], session->input.size() - offset, session->sampleSize);
+        if (status == SessionFrameView::Incomplete)
+            break;
+        if (status == SessionFrameView::Invalid)
+        {
+            setError(session, SENSORFW_PROTOCOL_ERROR, "Corrupted frame, flushing input");
+            offset = session->input.size();
+            ok = false;
+            break;
+        }
+
+        session->dropped += session->sequence.accept(frame.sequence(), frame.count());
+        if (frame.count())
+        {
+            size_t used = session->samples.size();
+            session->samples.resize(used + frame.sampleBytes());
+            frame.decode(&session->samples[used]);
+        }
+        offset += frame.totalSize();
+    }
+    session->input.erase(session->input.begin(), session->input.begin() + offset);
+    return ok;
+}
+
+/**
+ * Copy samples published in the shared memory ring to the sample queue.
+ */
+static bool readRing(Session* session)
+{
+    SharedRingReader& ring = session->ring;
+    unsigned int size = session->sampleSize;
+
+    unsigned int droppedBySensord = ring.dropCount();
+    session->dropped += droppedBySensord - session->ringDropped;
+    session->ringDropped = droppedBySensord;
+
+    unsigned int available = ring.available();
+    if (!available)
+        return true;
+    bool sizeOk = size == ring.ring()->elementSize;
+
+    size_t old = session->samples.size();
+    session->samples.resize(old + (size_t)available * size);
+    unsigned int count = ring.read(&session->samples[old], size, available, session->dropped);
+    session->samples.resize(old + (size_t)count * size);
+    if (!sizeOk)
+    {
+        setError(session, SENSORFW_SAMPLE_SIZE_ERROR, "Sample size does not match shared memory ring");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Collect everything which has arrived into the sample queue.
+ */
+static bool collect(Session* session)
+{
+    if (session->fd < 0)
+    {
+        setError(session, SENSORFW_SOCKET_ERROR, "Not connected");
+        return false;
+    }
+    if (!session->sampleSize)
+    {
+        setError(session, SENSORFW_SAMPLE_SIZE_ERROR, "Sample size not set");
+        return false;
+    }
+    bool ok = receive(session);
+    if (session->ring.ring())
+        return readRing(session) && ok;
+    return parseFrames(session) && ok;
+}
+
+static unsigned long long sampleTimestamp(const char* sample, unsigned int size)
+{
+    unsigned long long timestamp = 0;
+    if (size >= sizeof(timestamp))
+        memcpy(&timestamp, sample, sizeof(timestamp));
+    return timestamp;
+}
+
+static void fillBatch(Session* session, const char* samples, unsigned int count, sensorfw_batch_t* batch)
+{
+    batch->samples = samples;
+    batch->count = count;
+    batch->sample_size = session->sampleSize;
+    batch->first_timestamp = count ? sampleTimestamp(samples, session->sampleSize) : 0;
+    batch->last_timestamp = count ? sampleTimestamp(samples + (size_t)(count - 1) * session->sampleSize, session->sampleSize) : 0;
+    batch->dropped = session->dropped;
+    session->dropped = 0;
+}
+
+/* API */
+
+bool sensorfw_init(const char* sensor_name)
+{
+    SessionLocker locker;
+    std::string id = cleanId(sensor_name);
+    const char* name = id.c_str();
+    DBusMessage* reply = call(NULL, OBJECT_PATH, MANAGER_INTERFACE, "loadPlugin",
+                              DBUS_TYPE_STRING, &name,
+                              DBUS_TYPE_INVALID);
+    dbus_bool_t loaded = FALSE;
+    return replyValue(NULL, reply, DBUS_TYPE_BOOLEAN, &loaded) && loaded;
+}
+
+int sensorfw_open_session(const char* sensor_name)
+{
+    return sensorfw_open_session_with_flags(sensor_name, 0);
+}
+
+int sensorfw_open_session_with_flags(const char* sensor_name, int flags)
+{
+    SessionLocker locker;
+    const char* name = sensor_name ? sensor_name : "";
+    dbus_int64_t pid = getpid();
+    DBusMessage* reply = call(NULL, OBJECT_PATH, MANAGER_INTERFACE, "requestSensor",
+                              DBUS_TYPE_STRING, &name,
+                              DBUS_TYPE_INT64, &pid,
+                              DBUS_TYPE_INVALID);
+    dbus_int32_t sessionId = -1;
+    if (!replyValue(NULL, reply, DBUS_TYPE_INT32, &sessionId) || sessionId < 0)
+    {
+        if (sessionId < 0)
+            setError(NULL, SENSORFW_DBUS_ERROR, "Sensor not granted");
+        return -1;
+    }
+
+    Session* session = new Session;
+    session->id = sessionId;
+    session->sensor = cleanId(sensor_name);
+    session->path = std::string(OBJECT_PATH) + "/" + session->sensor;
+    if (!connectData(session, flags & SENSORFW_SHARED_MEMORY))
+    {
+        globalErrors.error = session->error;
+        globalErrors.errorString = session->errorString;
+        disconnectData(session);
+        const char* id = session->sensor.c_str();
+        reply = call(NULL, OBJECT_PATH, MANAGER_INTERFACE, "releaseSensor",
+                     DBUS_TYPE_STRING, &id,
+                     DBUS_TYPE_INT32, &sessionId,
+                     DBUS_TYPE_INT64, &pid,
+                     DBUS_TYPE_INVALID);
+        if (reply)
+            dbus_message_unref(reply);
+        delete session;
+        return -1;
+    }
+
+    sessions[sessionId] = session;
+    return sessionId;
+}
+
+bool sensorfw_close_session(int sessionId)
+{
+    SessionLocker locker(sessionId);
+    Session* session = locker.session();
+    if (!session)
+        return false;
+
+    sessions.erase(sessionId);
+    disconnectData(session);
+
+    const char* id = session->sensor.c_str();
+    dbus_int32_t sid = sessionId;
+    dbus_int64_t pid = getpid();
+    DBusMessage* reply = call(NULL, OBJECT_PATH, MANAGER_INTERFACE, "releaseSensor",
+                              DBUS_TYPE_STRING, &id,
+                              DBUS_TYPE_INT32, &sid,
+                              DBUS_TYPE_INT64, &pid,
+                              DBUS_TYPE_INVALID);
+    delete session;
+    dbus_bool_t released = FALSE;
+    return replyValue(NULL, reply, DBUS_TYPE_BOOLEAN, &released) && released;
+}
+
+bool sensorfw_set_sample_size(int sessionId, unsigned int size)
+{
+    SessionLocker locker(sessionId);
+    Session* session = locker.session();
+    if (!session)
+        return false;
+    if (size < sizeof(unsigned long long) || size > SHARED_RING_SLOT_SIZE)
+    {
+        setError(session, SENSORFW_SAMPLE_SIZE_ERROR, "Invalid sample size");
+        return false;
+    }
+    if (size != session->sampleSize)
+    {
+        session->samples.clear();
+        session->sampleSize = size;
+    }
+    return true;
+}
+
+bool sensorfw_start_sensor(int sessionId)
+{
+    SessionLocker locker(sessionId);
+    Session* session = locker.session();
+    if (!session)
+        return false;
+    dbus_int32_t sid = sessionId;
+    if (!callVoid(session, "start", DBUS_TYPE_INT32, &sid, DBUS_TYPE_INVALID))
+        return false;
+    session->running = true;
+    return true;
+}
+
+bool sensorfw_stop_sensor(int sessionId)
+{
+    SessionLocker locker(sessionId);
+    Session* session = locker.session();
+    if (!session)
+        return false;
+    dbus_int32_t sid = sessionId;
+    if (!callVoid(session, "stop", DBUS_TYPE_INT32, &sid, DBUS_TYPE_INVALID))
+        return false;
+    session->running = false;
+    return true;
+}
+
+bool sensorfw_running(int sessionId)
+{
+    SessionLocker locker(sessionId);
+    return locker.session() && locker.session()->running;
+}
+
+int sensorfw_get_interval(int sessionId)
+{
+    SessionLocker locker(sessionId);
+    Session* session = locker.session();
+    dbus_uint32_t interval = 0;
+    if (!session || !property(session, "interval", DBUS_TYPE_UINT32, &interval))
+        return -1;
+    return interval;
+}
+
+bool sensorfw_set_interval(int sessionId, int interval)
+{
+    SessionLocker locker(sessionId);
+    Session* session = locker.session();
+    if (!session)
+        return false;
+    dbus_int32_t sid = sessionId;
+    dbus_int32_t value = interval;
+    return callVoid(session, "setInterval", DBUS_TYPE_INT32, &sid, DBUS_TYPE_INT32, &value, DBUS_TYPE_INVALID);
+}
+
+bool sensorfw_set_buffering(int sessionId, unsigned int size, unsigned int interval)
+{
+    SessionLocker locker(sessionId);
+    Session* session = locker.session();
+    if (!session)
+        return false;
+    dbus_int32_t sid = sessionId;
+    dbus_uint32_t bufferSize = size;
+    dbus_uint32_t bufferInterval = interval;
+    return callVoid(session, "setBufferInterval", DBUS_TYPE_INT32, &sid, DBUS_TYPE_UINT32, &bufferInterval, DBUS_TYPE_INVALID) &&
+           callVoid(session, "setBufferSize", DBUS_TYPE_INT32, &sid, DBUS_TYPE_UINT32, &bufferSize, DBUS_TYPE_INVALID);
+}
+
+bool sensorfw_get_standby_override(int sessionId)
+{
+    SessionLocker locker(sessionId);
+    Session* session = locker.session();
+    dbus_bool_t value = FALSE;
+    return session && property(session, "standbyOverride", DBUS_TYPE_BOOLEAN, &value) && value;
+}
+
+bool sensorfw_set_standby_override(int sessionId, bool override)
+{
+    SessionLocker locker(sessionId);
+    Session* session = locker.session();
+    if (!session)
+        return false;
+    dbus_int32_t sid = sessionId;
+    dbus_bool_t value = override;
+    DBusMessage* reply = call(session, session->path.c_str(), NULL, "setStandbyOverride",
+                              DBUS_TYPE_INT32, &sid,
+                              DBUS_TYPE_BOOLEAN, &value,
+                              DBUS_TYPE_INVALID);
+    dbus_bool_t accepted = FALSE;
+    return replyValue(session, reply, DBUS_TYPE_BOOLEAN, &accepted) && accepted;
+}
+
+bool sensorfw_get_description(int sessionId, char** description)
+{
+    SessionLocker locker(sessionId);
+    Session* session = locker.session();
+    const char* value = NULL;
+    if (!session || !property(session, "description", DBUS_TYPE_STRING, &value))
+        return false;
+    session->description = value ? value : "";
+    if (description)
+        *description = (char*)session->description.c_str();
+    return true;
+}
+
+bool sensorfw_register_callback(int sessionId, sensorfw_callback_t cb_func, void* user_data)
+{
+    SessionLocker locker(sessionId);
+    Session* session = locker.session();
+    if (!session)
+        return false;
+    session->callback = cb_func;
+    session->userData = user_data;
+    return true;
+}
+
+int sensorfw_get_fd(int sessionId)
+{
+    SessionLocker locker(sessionId);
+    return locker.session() ? locker.session()->fd : -1;
+}
+
+int sensorfw_dispatch(int sessionId)
+{
+    sensorfw_callback_t callback;
+    void* userData;
+    std::vector<char> samples;
+    sensorfw_batch_t batch;
+    {
+        SessionLocker locker(sessionId);
+        Session* session = locker.session();
+        if (!session)
+            return -1;
+        if (!collect(session) && session->samples.empty())
+            return -1;
+        if (!session->callback || session->samples.empty())
+            return 0;
+
+        // Callback may call back into the API, so run it unlocked.
+        callback = session->callback;
+        userData = session->userData;
+        samples.swap(session->samples);
+        fillBatch(session, &samples[0], samples.size() / session->sampleSize, &batch);
+    }
+    callback(sessionId, &batch, userData);
+    return batch.count;
+}
+
+int sensorfw_read_batch(int sessionId, void* buffer, unsigned int max_count, sensorfw_batch_t* batch)
+{
+    SessionLocker locker(sessionId);
+    Session* session = locker.session();
+    if (!session)
+        return -1;
+    if (!collect(session) && session->samples.empty())
+        return -1;
+
+    unsigned int count = session->samples.size() / session->sampleSize;
+    if (count > max_count)
+        count = max_count;
+    size_t bytes = (size_t)count * session->sampleSize;
+    if (bytes)
+    {
+        memcpy(buffer, &session->samples[0], bytes);
+        session->samples.erase(session->samples.begin(), session->samples.begin() + bytes);
+    }
+    if (batch)
+        fillBatch(session, (const char*)buffer, count, batch);
+    return count;
+}
+
+bool sensorfw_prepare_for_calibration(int sessionId)
+{
+    SessionLocker locker(sessionId);
+    Session* session = locker.session();
+    return session && callVoid(session, "reset", DBUS_TYPE_INVALID);
+}
+
+int sensorfw_last_error(int sessionId, char** error_string)
+{
+    SessionLocker locker;
+    std::map<int, Session*>::iterator it = sessions.find(sessionId);
+    Session* session = (it != sessions.end()) ? it->second : &globalErrors;
+    if (error_string)
+        *error_string = (char*)session->errorString.c_str();
+    return session->error;
+}
@@ -1,13 +1,15 @@
 /**
    @file sensorfw-c.h
-   @brief C-API for sensor framework. <b>NOTE THAT THIS HAS NOT BEEN IMPLEMENTED YET<b>
+   @brief C-API for sensor framework.
+
+   Sessions are controlled over D-Bus with libdbus and samples are read
+   from the sensord data socket directly, so clients do not need Qt.
+   Calls for a session must not be made from several threads at once.
 
     @todo
     <ul>
     <li>Querying and setting values for Data range</li>
     <li>Querying possible values for Interval and Data range</li>
-    <li>Control / Listen separation?</li>
-    <li>Generic type for callbacks, or callback must know what to expect?</li>
     </ul>
 
    <p>
@@ -34,6 +36,15 @@
 #ifndef SENSORFW_CAPI
 #define SENSORFW_CAPI
 
+#include <stddef.h>
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /**
  * @brief Structure containing interval information for sensor.
  *
@@ -54,14 +65,57 @@ typedef struct {
     int accuracy; ///< Minimal detected change
 } sensorfw_range_t;
 
+/**
+ * @brief Batch of samples delivered to a callback or read with
+ * sensorfw_read_batch.
+ *
+ * Samples are stored back to back, each \c sample_size bytes. Every sample
+ * starts with its timestamp, an unsigned 64 bit monotonic time in
+ * microseconds, followed by the sensor specific fields.
+ */
+typedef struct {
+    const void* samples;                 ///< First sample
+    unsigned int count;                  ///< Number of samples
+    unsigned int sample_size;            ///< Size of a single sample in bytes
+    unsigned long long first_timestamp;  ///< Timestamp of the first sample
+    unsigned long long last_timestamp;   ///< Timestamp of the last sample
+    unsigned int dropped;                ///< Samples lost since the previous batch
+} sensorfw_batch_t;
+
+/**
+ * @brief Callback receiving batches of samples.
+ *
+ * The batch and its samples are only valid during the call.
+ */
+typedef void (*sensorfw_callback_t)(int session_id, const sensorfw_batch_t* batch, void* user_data);
+
+/**
+ * @brief Flags for sensorfw_open_session_with_flags.
+ */
+typedef enum {
+    SENSORFW_SHARED_MEMORY = 0x1 ///< Request shared memory transport, falls back to the socket
+} sensorfw_session_flags_t;
+
+/**
+ * @brief Error codes returned by sensorfw_last_error.
+ */
+typedef enum {
+    SENSORFW_NO_ERROR = 0,       ///< No error
+    SENSORFW_INVALID_SESSION,    ///< Unknown session ID
+    SENSORFW_DBUS_ERROR,         ///< D-Bus call failed or was refused
+    SENSORFW_SOCKET_ERROR,       ///< Data socket failed or was closed
+    SENSORFW_SAMPLE_SIZE_ERROR,  ///< Sample size not set or does not match the data
+    SENSORFW_PROTOCOL_ERROR      ///< Unexpected data from sensord
+} sensorfw_error_t;
+
 /**
  * @brief Initialises the sensor for operation.
  *
  * This function must be run before attempting to request a session for a sensor.
  * Plugin loading, type registration etc. will be done by this function.
- * @param sensor_name Name of the sensor to initialise.
+ * @param sensor_name Name of the sensor to initialise, for example
+ *        \c accelerometersensor.
  * @return \c true on success, \c false on failure
- * @todo Provide information on sensor names
  */
 bool sensorfw_init(const char* sensor_name);
 
@@ -69,12 +123,22 @@ bool sensorfw_init(const char* sensor_name);
  * @brief Opens a session for a sensor.
  *
  * This call provides the client with a session ID, through which the client can
- * interact with the sensor.
+ * interact with the sensor. The data connection is established as well.
  * @param sensor_name Name of the sensor we wish to open.
  * @return session ID for the sensor. \c -1 on failure.
  */
 int sensorfw_open_session(const char* sensor_name);
 
+/**
+ * @brief Opens a session for a sensor with given flags.
+ *
+ * See sensorfw_open_session.
+ * @param sensor_name Name of the sensor we wish to open.
+ * @param flags Combination of #sensorfw_session_flags_t.
+ * @return session ID for the sensor. \c -1 on failure.
+ */
+int sensorfw_open_session_with_flags(const char* sensor_name, int flags);
+
 /**
  * @brief Closes a sensor session.
  *
@@ -85,6 +149,19 @@ int sensorfw_open_session(const char* sensor_name);
  */
 bool sensorfw_close_session(int sessionId);
 
+/**
+ * @brief Sets the size of the samples of the session.
+ *
+ * Frames on the data socket carry a sample count but not the sample size,
+ * so it has to be set before data is read. It is the size of the sensor
+ * specific sample structure including padding, for example 24 bytes for
+ * accelerometer samples (timestamp and three 32 bit axes).
+ * @param sessionId Session ID to run this request on.
+ * @param size Size of a single sample in bytes.
+ * @return \c true on success, \c false on failure or invalid session ID.
+ */
+bool sensorfw_set_sample_size(int sessionId, unsigned int size);
+
 /**
  * @brief Starts sensor dataflow.
  * @param sessionId Session ID to run this request on.
@@ -114,7 +191,7 @@ bool sensorfw_running(int sessionId);
  * constant, or might depend on user interaction (i.e. no samples if environment
  * is not changing)
  * @param sessionId Session ID to run this request on.
- * @return Milliseconds between samples.
+ * @return Milliseconds between samples, \c -1 on failure.
  */
 int sensorfw_get_interval(int sessionId);
 
@@ -129,6 +206,19 @@ int sensorfw_get_interval(int sessionId);
  */
 bool sensorfw_set_interval(int sessionId, int interval);
 
+/**
+ * @brief Sets buffering of the session in sensord.
+ *
+ * Samples are collected in sensord into frames of \c size samples, or
+ * whatever has arrived when \c interval milliseconds have passed, so that
+ * the client wakes up once per frame instead of once per sample.
+ * @param sessionId Session ID to run this request on.
+ * @param size Number of samples per frame. \c 0 or \c 1 disables buffering.
+ * @param interval Maximum time to wait for a full frame in milliseconds.
+ * @return \c true on success, \c false on failure or invalid session ID.
+ */
+bool sensorfw_set_buffering(int sessionId, unsigned int size, unsigned int interval);
+
 /**
  * @brief Tells whether sensor has the standby override property set.
  *
@@ -166,13 +256,49 @@ bool sensorfw_get_description(int sessionId, char** description);
 /**
  * @brief Registers a callback function to handle sensor output.
  *
- * @todo Description of callback requirements.
+ * The callback is called from sensorfw_dispatch with all samples which
+ * have arrived since the previous call, never from a thread of its own.
  *
  * @param sessionId Session ID to run this request on.
- * @param cb_func Pointer to function to use as callback.
+ * @param cb_func Pointer to function to use as callback, \c NULL to remove.
+ * @param user_data Passed to the callback as is.
  * @return \c true on success, \c false on failure or invalid session ID.
  */
-bool sensorfw_register_callback(int sessionId, void (*cb_func)(void *data));
+bool sensorfw_register_callback(int sessionId, sensorfw_callback_t cb_func, void* user_data);
+
+/**
+ * @brief Returns a file descriptor to wait on.
+ *
+ * The descriptor becomes readable when data for the session arrives and
+ * can be added to poll(), epoll or a foreign event loop. When it is
+ * readable call sensorfw_dispatch or sensorfw_read_batch. The descriptor
+ * is owned by the session and must not be read or closed by the client.
+ * @param sessionId Session ID to run this request on.
+ * @return file descriptor, \c -1 on failure or invalid session ID.
+ */
+int sensorfw_get_fd(int sessionId);
+
+/**
+ * @brief Reads available data and passes it to the registered callback.
+ *
+ * Never blocks.
+ * @param sessionId Session ID to run this request on.
+ * @return number of samples delivered, \c -1 on failure or invalid session ID.
+ */
+int sensorfw_dispatch(int sessionId);
+
+/**
+ * @brief Reads available samples into a buffer without a callback.
+ *
+ * Never blocks. Samples which do not fit are kept for the next call.
+ * @param sessionId Session ID to run this request on.
+ * @param buffer Location for at most \c max_count samples.
+ * @param max_count Capacity of the buffer in samples.
+ * @param batch If given, filled with the count, timestamps and drops of
+ *        the samples read. Its \c samples points to \c buffer.
+ * @return number of samples read, \c -1 on failure or invalid session ID.
+ */
+int sensorfw_read_batch(int sessionId, void* buffer, unsigned int max_count, sensorfw_batch_t* batch);
 
 /**
  * @brief Prepares the sensor for calibration.
@@ -191,9 +317,12 @@ bool sensorfw_prepare_for_calibration(int sessionId);
  * @param sessionId Session ID to run this request on.
  * @param error_string If given, will be set to verbal description of the error.
  *        Can be referenced until the next error occurs.
- * @return Numerical code for the error that occurred
- * @todo Provide enums for error numbers.
+ * @return Numerical code for the error that occurred, #sensorfw_error_t.
  */
 int sensorfw_last_error(int sessionId, char** error_string);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif // SENSORFW_CAPI
@@ -34,7 +34,8 @@
 #include "config.h"
 #include "logging.h"
 
-#include "coordinatealignfilter.h"
+#include "accelerometerchainfilter.h"
+#include "accelerometerfloatfilter.h"
 
 AccelerometerChain::AccelerometerChain(const QString& id) :
     AbstractChain(id)
@@ -48,7 +49,7 @@ AccelerometerChain::AccelerometerChain(const QString& id) :
     Q_ASSERT( accelerometerAdaptor_ );
     setValid(accelerometerAdaptor_->isValid());
 
-    accelerometerReader_ = new BufferReader<AccelerationData>(1);
+    accelerometerReader_ = new BufferReader<AccelerationData>(32);
 
     // Get the transformation matrix from config file
     QString aconvString = Config::configuration()->value<QString>("accelerometer/transformation_matrix", "");
@@ -60,26 +61,66 @@ AccelerometerChain::AccelerometerChain(const QString& id) :
         }
     }
 
-    accCoordinateAlignFilter_ = sm.instantiateFilter("coordinatealignfilter");
-    Q_ASSERT(accCoordinateAlignFilter_);
-    ((CoordinateAlignFilter*)accCoordinateAlignFilter_)->setMatrix(TMatrix(aconv_));
+    offset_[0] = offset_[1] = offset_[2] = 0;
+    QString offsetString = Config::configuration()->value<QString>("accelerometer/calibration_offset", "");
+    if (offsetString.size() > 0)
+    {
+        if (!setOffsetFromString(offsetString))
+        {
+            sensordLogW() << "Failed to parse 'calibration_offset' configuration key. Calibration is not applied";
+        }
+    }
+
+    accelerometerFilter_ = sm.instantiateFilter("accelerometerchainfilter");
+    Q_ASSERT(accelerometerFilter_);
+    AccelerometerChainFilter* filter = (AccelerometerChainFilter*)accelerometerFilter_;
+    filter->setMatrix(aconv_);
+    filter->setOffset(offset_[0], offset_[1], offset_[2]);
+    filter->setSmoothing(Config::configuration()->value<qreal>("accelerometer/smoothing_factor", 0.0));
 
-    outputBuffer_ = new RingBuffer<AccelerationData>(1);
+    outputBuffer_ = new RingBuffer<AccelerationData>(32);
     nameOutputBuffer("accelerometer", outputBuffer_);
 
+    // Adaptors with float hardware offer the samples unscaled too.
+    floatReader_ = 0;
+    floatFilter_ = 0;
+    floatOutputBuffer_ = 0;
+    if (accelerometerAdaptor_->findBuffer("accelerometerfloat")) {
+        floatReader_ = new BufferReader<AccelerationFloatData>(32);
+        floatFilter_ = sm.instantiateFilter("accelerometerfloatfilter");
+        Q_ASSERT(floatFilter_);
+        AccelerometerFloatFilter* ffilter = (AccelerometerFloatFilter*)floatFilter_;
+        ffilter->setMatrix(aconv_);
+        ffilter->setOffset(offset_[0], offset_[1], offset_[2]);
+        ffilter->setSmoothing(Config::configuration()->value<qreal>("accelerometer/smoothing_factor", 0.0));
+        floatOutputBuffer_ = new RingBuffer<AccelerationFloatData>(32);
+        nameOutputBuffer("accelerometerfloat", floatOutputBuffer_);
+    }
+
     // Create buffers for filter chain
-    filterBin_ = new Bin;
+    filterBin_ = Bin::create(id);
 
     filterBin_->add(accelerometerReader_, "accelerometer");
-    filterBin_->add(accCoordinateAlignFilter_, "acccoordinatealigner");
+    filterBin_->add(accelerometerFilter_, "accelerometerfilter");
     filterBin_->add(outputBuffer_, "buffer");
 
     // Join filterchain buffers
-    filterBin_->join("accelerometer", "source", "acccoordinatealigner", "sink");
-    filterBin_->join("acccoordinatealigner", "source", "buffer", "sink");
+    filterBin_->join("accelerometer", "source", "accelerometerfilter", "sink");
+    filterBin_->join("accelerometerfilter", "source", "buffer", "sink");
+
+    if (floatReader_) {
+        filterBin_->add(floatReader_, "accelerometerfloat");
+        filterBin_->add(floatFilter_, "floatfilter");
+        filterBin_->add(floatOutputBuffer_, "floatbuffer");
+        filterBin_->join("accelerometerfloat", "source", "floatfilter", "sink");
+        filterBin_->join("floatfilter", "source", "floatbuffer", "sink");
+    }
+    filterBin_->freeze();
 
     // Join datasources to the chain
     connectToSource(accelerometerAdaptor_, "accelerometer", accelerometerReader_);
+    if (floatReader_)
+        connectToSource(accelerometerAdaptor_, "accelerometerfloat", floatReader_);
 
     setDescription("Coordinate transformations");
     setRangeSource(accelerometerAdaptor_);
@@ -92,12 +133,17 @@ AccelerometerChain::~AccelerometerChain()
     SensorManager& sm = SensorManager::instance();
 
     disconnectFromSource(accelerometerAdaptor_, "accelerometer", accelerometerReader_);
+    if (floatReader_)
+        disconnectFromSource(accelerometerAdaptor_, "accelerometerfloat", floatReader_);
 
     sm.releaseDeviceAdaptor("accelerometeradaptor");
 
     delete accelerometerReader_;
-    delete accCoordinateAlignFilter_;
+    delete accelerometerFilter_;
     delete outputBuffer_;
+    delete floatReader_;
+    delete floatFilter_;
+    delete floatOutputBuffer_;
     delete filterBin_;
 }
 
@@ -105,8 +151,11 @@ bool AccelerometerChain::start()
 {
     if (AbstractSensorChannel::start()) {
         sensordLogD() << "Starting AccelerometerChain";
+        ((AccelerometerChainFilter*)accelerometerFilter_)->reset();
+        if (floatFilter_)
+            ((AccelerometerFloatFilter*)floatFilter_)->reset();
         filterBin_->start();
-        accelerometerAdaptor_->startSensor();
+        accelerometerAdaptor_->acquireSensor();
     }
     return true;
 }
@@ -115,7 +164,7 @@ bool AccelerometerChain::stop()
 {
     if (AbstractSensorChannel::stop()) {
         sensordLogD() << "Stopping AccelerometerChain";
-        accelerometerAdaptor_->stopSensor();
+        accelerometerAdaptor_->releaseSensor();
         filterBin_->stop();
     }
     return true;
@@ -136,3 +185,23 @@ bool AccelerometerChain::setMatrixFromString(const QString& str)
 
     return true;
 }
+
+bool AccelerometerChain::setOffsetFromString(const QString& str)
+{
+    QStringList strList = str.split(',');
+    if (strList.size() != 3) {
+        sensordLogW() << "Invalid calibration offset. Expected 3 values, got" << strList.size();
+        return false;
+    }
+
+    for (int i = 0; i < 3; ++i)
+    {
+        bool ok = false;
+        int value = strList.at(i).trimmed().toInt(&ok);
+        if (!ok)
+            return false;
+        offset_[i] = value;
+    }
+
+    return true;
+}
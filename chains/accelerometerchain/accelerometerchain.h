@@ -29,7 +29,6 @@
 
 #include "abstractsensor.h"
 #include "abstractchain.h"
-#include "coordinatealignfilter.h"
 #include "deviceadaptor.h"
 
 class Bin;
@@ -40,6 +39,9 @@ class FilterBase;
  * @brief Accelerometerchain providies raw accelerometer coordinates
  *        aligned to Nokia Standard Coordinate system.
  *
+ * Calibration offset, alignment and smoothing are applied in one
+ * filter pass, see #AccelerometerChainFilter.
+ *
  * <b>Output buffers:</b>
  * <ul><li>\em accelerometer</li></ul>
  *
@@ -71,14 +73,20 @@ protected:
 private:
 
     bool setMatrixFromString(const QString& str);
+    bool setOffsetFromString(const QString& str);
 
     double                           aconv_[3][3];
+    int                              offset_[3];
     Bin*                             filterBin_;
 
     DeviceAdaptor*                   accelerometerAdaptor_;
     BufferReader<AccelerationData>*  accelerometerReader_;
-    FilterBase*                      accCoordinateAlignFilter_;
+    FilterBase*                      accelerometerFilter_;
     RingBuffer<AccelerationData>*    outputBuffer_;
+
+    BufferReader<AccelerationFloatData>* floatReader_;       /**< NULL without float adaptor */
+    FilterBase*                          floatFilter_;
+    RingBuffer<AccelerationFloatData>*   floatOutputBuffer_;
 };
 
 #endif // ACCELEROMETERCHAIN_H
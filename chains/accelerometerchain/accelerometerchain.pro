@@ -1,11 +1,13 @@
 TARGET       = accelerometerchain
 
 HEADERS += accelerometerchain.h   \
-           accelerometerchainplugin.h
+           accelerometerchainplugin.h \
+           accelerometerchainfilter.h \
+           accelerometerfloatfilter.h
 
 SOURCES += accelerometerchain.cpp   \
-           accelerometerchainplugin.cpp
-
-INCLUDEPATH += ../../filters/coordinatealignfilter
+           accelerometerchainplugin.cpp \
+           accelerometerchainfilter.cpp \
+           accelerometerfloatfilter.cpp
 
 include( ../chain-config.pri )
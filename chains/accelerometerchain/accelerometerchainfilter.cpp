@@ -0,0 +1,112 @@
+/**
+   @file accelerometerchainfilter.cpp
+   @brief AccelerometerChainFilter
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "accelerometerchainfilter.h"
+
+AccelerometerChainFilter::AccelerometerChainFilter() :
+    Filter<AccelerationData, AccelerometerChainFilter, AccelerationData>(this, &AccelerometerChainFilter::filter),
+    axisSwap_(false),
+    smoothing_(false),
+    averageValid_(false)
+{
+    const double identity[3][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+    setMatrix(identity);
+    setOffset(0, 0, 0);
+    setSmoothing(0);
+}
+
+void AccelerometerChainFilter::setMatrix(const double matrix[3][3])
+{
+    axisSwap_ = true;
+    for (int i = 0; i < 3; ++i) {
+        int nonZero = 0;
+        for (int j = 0; j < 3; ++j) {
+            double value = matrix[i][j];
+            coeff_[i][j] = FilterScalar(value);
+            if (value == 0)
+                continue;
+            if ((value != 1 && value != -1) || ++nonZero > 1) {
+                axisSwap_ = false;
+                continue;
+            }
+            axis_[i] = j;
+            sign_[i] = (int)value;
+        }
+        if (nonZero == 0)
+            axisSwap_ = false;
+    }
+}
+
+void AccelerometerChainFilter::setOffset(int x, int y, int z)
+{
+    offset_[0] = x;
+    offset_[1] = y;
+    offset_[2] = z;
+}
+
+void AccelerometerChainFilter::setSmoothing(qreal factor)
+{
+    smoothing_ = factor > 0 && factor < 1;
+    newWeight_ = FilterScalar((double)factor);
+    oldWeight_ = FilterScalar(1.0 - factor);
+    reset();
+}
+
+void AccelerometerChainFilter::reset()
+{
+    averageValid_ = false;
+}
+
+void AccelerometerChainFilter::filter(unsigned n, const AccelerationData* data)
+{
+    AccelerationData* output = outputSpan(n);
+
+    block_.load(n, data);
+    block_.subtract(offset_[0], offset_[1], offset_[2]);
+    if (axisSwap_)
+        block_.permute(axis_, sign_);
+    else
+        block_.transform(coeff_);
+
+    if (smoothing_ && n) {
+        int* axes[3] = { block_.x(), block_.y(), block_.z() };
+        // Seed with the first sample instead of pulling up from zero.
+        if (!averageValid_) {
+            for (int k = 0; k < 3; ++k)
+                average_[k] = axes[k][0];
+            averageValid_ = true;
+        }
+        // Each output depends on the previous one, so this runs one
+        // axis at a time down the batch.
+        for (int k = 0; k < 3; ++k) {
+            int* values = axes[k];
+            int average = average_[k];
+            for (unsigned i = 0; i < n; ++i)
+                values[i] = average = scalarToInt(newWeight_ * values[i] + oldWeight_ * average);
+            average_[k] = average;
+        }
+    }
+
+    block_.store(output);
+    source_.propagate(n, output);
+}
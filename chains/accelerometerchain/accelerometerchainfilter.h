@@ -0,0 +1,108 @@
+/**
+   @file accelerometerchainfilter.h
+   @brief AccelerometerChainFilter
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef ACCELEROMETERCHAINFILTER_H
+#define ACCELEROMETERCHAINFILTER_H
+
+#include <QObject>
+#include "orientationdata.h"
+#include "filter.h"
+#include "fixedpoint.h"
+#include "xyzblock.h"
+
+/**
+ * @brief Calibration, coordinate alignment and smoothing in one pass.
+ *
+ * Each sample first has the calibration offset of its raw axes removed,
+ * is then transformed with the alignment matrix and finally, when a
+ * smoothing factor is set, averaged the same way as #AvgAccFilter does.
+ * Doing all three in one filter writes every sample once instead of
+ * once per stage. Offset and alignment run over the whole batch at a
+ * time in an #XyzBlock.
+ */
+class AccelerometerChainFilter : public QObject, public Filter<AccelerationData, AccelerometerChainFilter, AccelerationData>
+{
+    Q_OBJECT;
+
+public:
+    /**
+     * Factory method.
+     * @return New AccelerometerChainFilter instance as FilterBase*.
+     */
+    static FilterBase* factoryMethod() {
+        return new AccelerometerChainFilter;
+    }
+
+    /**
+     * Set alignment matrix.
+     *
+     * @param matrix row major 3x3 matrix.
+     */
+    void setMatrix(const double matrix[3][3]);
+
+    /**
+     * Set calibration offsets, subtracted from the raw axes before
+     * alignment.
+     *
+     * @param x offset of x axis.
+     * @param y offset of y axis.
+     * @param z offset of z axis.
+     */
+    void setOffset(int x, int y, int z);
+
+    /**
+     * Set smoothing factor. Zero disables smoothing, otherwise this is
+     * the weight of a new sample against the running average.
+     *
+     * @param factor weight of a new sample, 0 to 1.
+     */
+    void setSmoothing(qreal factor);
+
+    /**
+     * Forget the running average.
+     */
+    void reset();
+
+protected:
+    /**
+     * Constructor.
+     */
+    AccelerometerChainFilter();
+
+private:
+    void filter(unsigned, const AccelerationData*);
+
+    FilterScalar coeff_[3][3];   /**< alignment matrix */
+    bool         axisSwap_;      /**< matrix is a signed permutation */
+    int          axis_[3];       /**< source axis for each output axis */
+    int          sign_[3];       /**< sign for each output axis */
+    int          offset_[3];     /**< calibration offset of raw axes */
+    bool         smoothing_;     /**< is smoothing enabled */
+    bool         averageValid_;  /**< has average been seeded */
+    FilterScalar newWeight_;     /**< weight of the new sample */
+    FilterScalar oldWeight_;     /**< weight of the running average */
+    int          average_[3];    /**< running average */
+    XyzBlock     block_;         /**< batch being filtered */
+};
+
+#endif // ACCELEROMETERCHAINFILTER_H
@@ -26,6 +26,8 @@
 
 #include "accelerometerchainplugin.h"
 #include "accelerometerchain.h"
+#include "accelerometerchainfilter.h"
+#include "accelerometerfloatfilter.h"
 #include "sensormanager.h"
 #include "logging.h"
 
@@ -34,10 +36,12 @@ void AccelerometerChainPlugin::Register(class Loader&)
     sensordLogD() << "registering accelerometerchain";
     SensorManager& sm = SensorManager::instance();
     sm.registerChain<AccelerometerChain>("accelerometerchain");
+    sm.registerFilter<AccelerometerChainFilter>("accelerometerchainfilter");
+    sm.registerFilter<AccelerometerFloatFilter>("accelerometerfloatfilter");
 }
 
 QStringList AccelerometerChainPlugin::Dependencies() {
-    return QString("coordinatealignfilter:accelerometeradaptor").split(":", QString::SkipEmptyParts);
+    return QString("accelerometeradaptor").split(":", QString::SkipEmptyParts);
 }
 
 #if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
@@ -0,0 +1,94 @@
+/**
+   @file accelerometerfloatfilter.cpp
+   @brief AccelerometerFloatFilter
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "accelerometerfloatfilter.h"
+
+AccelerometerFloatFilter::AccelerometerFloatFilter() :
+    Filter<AccelerationFloatData, AccelerometerFloatFilter, AccelerationFloatData>(this, &AccelerometerFloatFilter::filter),
+    smoothing_(false),
+    averageValid_(false)
+{
+    const double identity[3][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+    setMatrix(identity);
+    setOffset(0, 0, 0);
+    setSmoothing(0);
+}
+
+void AccelerometerFloatFilter::setMatrix(const double matrix[3][3])
+{
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j)
+            coeff_[i][j] = matrix[i][j];
+}
+
+void AccelerometerFloatFilter::setOffset(int x, int y, int z)
+{
+    const float scale = 9.80665f / 1000;
+    offset_[0] = x * scale;
+    offset_[1] = y * scale;
+    offset_[2] = z * scale;
+}
+
+void AccelerometerFloatFilter::setSmoothing(qreal factor)
+{
+    smoothing_ = factor > 0 && factor < 1;
+    newWeight_ = factor;
+    reset();
+}
+
+void AccelerometerFloatFilter::reset()
+{
+    averageValid_ = false;
+}
+
+void AccelerometerFloatFilter::filter(unsigned n, const AccelerationFloatData* data)
+{
+    AccelerationFloatData* output = outputSpan(n);
+
+    for (unsigned i = 0; i < n; ++i) {
+        float raw[3] = { data[i].x_ - offset_[0],
+                         data[i].y_ - offset_[1],
+                         data[i].z_ - offset_[2] };
+        float aligned[3];
+        for (int k = 0; k < 3; ++k)
+            aligned[k] = coeff_[k][0] * raw[0] + coeff_[k][1] * raw[1] + coeff_[k][2] * raw[2];
+
+        if (smoothing_) {
+            // Seed with the first sample instead of pulling up from zero.
+            if (!averageValid_) {
+                for (int k = 0; k < 3; ++k)
+                    average_[k] = aligned[k];
+                averageValid_ = true;
+            }
+            for (int k = 0; k < 3; ++k)
+                aligned[k] = average_[k] += newWeight_ * (aligned[k] - average_[k]);
+        }
+
+        output[i].timestamp_ = data[i].timestamp_;
+        output[i].x_ = aligned[0];
+        output[i].y_ = aligned[1];
+        output[i].z_ = aligned[2];
+    }
+
+    source_.propagate(n, output);
+}
@@ -0,0 +1,98 @@
+/**
+   @file accelerometerfloatfilter.h
+   @brief AccelerometerFloatFilter
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef ACCELEROMETERFLOATFILTER_H
+#define ACCELEROMETERFLOATFILTER_H
+
+#include <QObject>
+#include "orientationdata.h"
+#include "filter.h"
+
+/**
+ * @brief Counterpart of #AccelerometerChainFilter for float samples.
+ *
+ * Applies the same calibration, alignment and smoothing to samples in
+ * m/s^2 as the hardware reports them, without rounding to milli-G.
+ */
+class AccelerometerFloatFilter : public QObject, public Filter<AccelerationFloatData, AccelerometerFloatFilter, AccelerationFloatData>
+{
+    Q_OBJECT;
+
+public:
+    /**
+     * Factory method.
+     * @return New AccelerometerFloatFilter instance as FilterBase*.
+     */
+    static FilterBase* factoryMethod() {
+        return new AccelerometerFloatFilter;
+    }
+
+    /**
+     * Set alignment matrix.
+     *
+     * @param matrix row major 3x3 matrix.
+     */
+    void setMatrix(const double matrix[3][3]);
+
+    /**
+     * Set calibration offsets, subtracted from the raw axes before
+     * alignment. Offsets are given in milli-G like for the integer
+     * chain and converted to m/s^2 here.
+     *
+     * @param x offset of x axis.
+     * @param y offset of y axis.
+     * @param z offset of z axis.
+     */
+    void setOffset(int x, int y, int z);
+
+    /**
+     * Set smoothing factor. Zero disables smoothing, otherwise this is
+     * the weight of a new sample against the running average.
+     *
+     * @param factor weight of a new sample, 0 to 1.
+     */
+    void setSmoothing(qreal factor);
+
+    /**
+     * Forget the running average.
+     */
+    void reset();
+
+protected:
+    /**
+     * Constructor.
+     */
+    AccelerometerFloatFilter();
+
+private:
+    void filter(unsigned, const AccelerationFloatData*);
+
+    float coeff_[3][3];   /**< alignment matrix */
+    float offset_[3];     /**< calibration offset of raw axes */
+    bool  smoothing_;     /**< is smoothing enabled */
+    bool  averageValid_;  /**< has average been seeded */
+    float newWeight_;     /**< weight of the new sample */
+    float average_[3];    /**< running average */
+};
+
+#endif // ACCELEROMETERFLOATFILTER_H
@@ -6,4 +6,8 @@ include( ../common-install.pri )
 SUBDIRS  = accelerometerchain \
            orientationchain \
            magcalibrationchain \
-           compasschain
+           compasschain \
+           fusionchain \
+           gyroscopechain \
+           pipelinechain \
+           stepcounterchain
@@ -23,8 +23,10 @@
 #include <QDebug>
 
 #include "compasschain.h"
+#include "headingsmoothfilter.h"
 #include "sensormanager.h"
 #include "bin.h"
+#include "deviceadaptor.h"
 #include "bufferreader.h"
 #include "config.h"
 #include "logging.h"
@@ -33,7 +35,9 @@
 
 
 CompassChain::CompassChain(const QString& id) :
-    AbstractChain(id)
+    AbstractChain(id),
+    idleMagInterval(Config::configuration()->value<unsigned int>("compass/idle_mag_interval", 0)),
+    stable(false)
 {
     qDebug() << Q_FUNC_INFO << id;
 
@@ -70,6 +74,9 @@ CompassChain::CompassChain(const QString& id) :
     avgaccFilter = sm.instantiateFilter("avgaccfilter");
     Q_ASSERT(avgaccFilter);
 
+    headingSmoothFilter = sm.instantiateFilter("headingsmoothfilter");
+    Q_ASSERT(headingSmoothFilter);
+
     trueNorthBuffer = new RingBuffer<CompassData>(1);
     nameOutputBuffer("truenorth", trueNorthBuffer); //
 
@@ -77,7 +84,7 @@ CompassChain::CompassChain(const QString& id) :
     nameOutputBuffer("magneticnorth", magneticNorthBuffer); //
 
     // Create buffers for filter chain
-    filterBin = new Bin;
+    filterBin = Bin::create(id);
 
  //   if (orientAdaptor->isValid())
  //       filterBin->add(orientationdataReader, "orientation");
@@ -86,6 +93,7 @@ CompassChain::CompassChain(const QString& id) :
     filterBin->add(accelerometerReader, "accelerometer");
 
     filterBin->add(compassFilter, "compass");
+    filterBin->add(headingSmoothFilter, "headingsmooth");
     filterBin->add(avgaccFilter, "avgaccelerometer"); //normalize to flat ?
     filterBin->add(downsampleFilter, "downsamplefilter");
     filterBin->add(declinationFilter, "declinationcorrection");
@@ -112,11 +120,14 @@ CompassChain::CompassChain(const QString& id) :
             qDebug() << Q_FUNC_INFO << "downsamplefilter join failed";
   //  }
 
-    if (!filterBin->join("compass", "magnorthangle", "magneticnorth", "sink"))
-        qDebug() << Q_FUNC_INFO << "compass1 join failed";
+    if (!filterBin->join("compass", "magnorthangle", "headingsmooth", "sink"))
+        qDebug() << Q_FUNC_INFO << "compass join failed";
+
+    if (!filterBin->join("headingsmooth", "source", "magneticnorth", "sink"))
+        qDebug() << Q_FUNC_INFO << "headingsmooth1 join failed";
 
-    if (!filterBin->join("compass", "magnorthangle", "declinationcorrection", "sink"))
-        qDebug() << Q_FUNC_INFO << "compass2 join failed";
+    if (!filterBin->join("headingsmooth", "source", "declinationcorrection", "sink"))
+        qDebug() << Q_FUNC_INFO << "headingsmooth2 join failed";
 
     if (!filterBin->join("declinationcorrection", "source", "truenorth", "sink"))
         qDebug() << Q_FUNC_INFO << "declinationfilter join failed";
@@ -134,6 +145,9 @@ CompassChain::CompassChain(const QString& id) :
 //            qDebug() << Q_FUNC_INFO << "orientation connect failed";
 //    }
 
+    if (idleMagInterval)
+        connect(compassFilter, SIGNAL(stabilityChanged(bool)), this, SLOT(setStable(bool)));
+
     setDescription("Compass direction"); //compass north in degrees
     introduceAvailableDataRange(DataRange(0, 359, 1));
     introduceAvailableInterval(DataRange(50,200,0));
@@ -160,6 +174,7 @@ CompassChain::~CompassChain()
     delete magReader;
 //    delete orientationdataReader;
     delete declinationFilter;
+    delete headingSmoothFilter;
     delete trueNorthBuffer;
     delete magneticNorthBuffer;
     delete filterBin;
@@ -169,7 +184,10 @@ bool CompassChain::start()
 {
     if (AbstractSensorChannel::start()) {
         sensordLogD() << "Starting compassChain";
+        static_cast<HeadingSmoothFilter*>(headingSmoothFilter)->reset();
         filterBin->start();
+        // Accelerometer and magnetometer power up together.
+        AdaptorStartBatch batch;
 //        if (orientAdaptor->isValid()) {
      //       orientAdaptor->startSensor();
 //        } else {
@@ -195,6 +213,44 @@ bool CompassChain::stop()
     return true;
 }
 
+void CompassChain::sessionIntervalChanged(int sessionId)
+{
+    AbstractChain::sessionIntervalChanged(sessionId);
+    if (!idleMagInterval)
+        return;
+
+    // The magnetometer gets the default request of the session, remember
+    // it so that it can be restored.
+    unsigned int interval = magChain->getInterval(sessionId);
+    if (!interval) {
+        requestedMagIntervals.remove(sessionId);
+        return;
+    }
+    if (!requestedMagIntervals.contains(sessionId) || !stable)
+        requestedMagIntervals[sessionId] = interval;
+    if (stable)
+        applyMagInterval(sessionId, requestedMagIntervals[sessionId]);
+}
+
+void CompassChain::setStable(bool value)
+{
+    if (stable == value)
+        return;
+    stable = value;
+    sensordLogD() << "Heading " << (value ? "stable" : "moving") << ", " << requestedMagIntervals.size() << " compass sessions " << (value ? "relaxed to " : "restored from ") << idleMagInterval << " ms";
+
+    for (QMap<int, unsigned int>::const_iterator it = requestedMagIntervals.constBegin(); it != requestedMagIntervals.constEnd(); ++it)
+        applyMagInterval(it.key(), it.value());
+}
+
+void CompassChain::applyMagInterval(int sessionId, unsigned int interval)
+{
+    unsigned int value = (stable && interval < idleMagInterval) ? idleMagInterval : interval;
+    if (magChain->getInterval(sessionId) == value)
+        return;
+    magChain->setIntervalRequest(sessionId, value);
+}
+
 bool CompassChain::compassEnabled() const
 {
     return true;
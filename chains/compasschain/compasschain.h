@@ -35,6 +35,17 @@ class Bin;
 template <class TYPE> class BufferReader;
 class FilterBase;
 
+/**
+ * @brief Tilt compensated compass heading from accelerometer and
+ * magnetometer.
+ *
+ * When <tt>compass/idle_mag_interval</tt> is set, the magnetometer
+ * requests of the compass sessions are relaxed to that interval while
+ * the heading and tilt are stable, and restored as soon as they change.
+ * The heading is still computed for every accelerometer sample, so it
+ * is delivered at the session rate, with the magnetometer looked up
+ * according to <tt>compass/sync_mode</tt>.
+ */
 class CompassChain : public AbstractChain
 {
     Q_OBJECT
@@ -64,6 +75,16 @@ protected:
     CompassChain(const QString& id);
     ~CompassChain();
 
+    virtual void sessionIntervalChanged(int sessionId);
+
+private Q_SLOTS:
+    /**
+     * Apply idle or requested magnetometer intervals on stability change.
+     *
+     * @param stable is heading stable.
+     */
+    void setStable(bool stable);
+
 private:
     Bin* filterBin;
 
@@ -84,9 +105,23 @@ private:
     FilterBase *declinationFilter;
     FilterBase *downsampleFilter;
     FilterBase *avgaccFilter;
+    FilterBase *headingSmoothFilter;
 
     RingBuffer<CompassData> *trueNorthBuffer;
     RingBuffer<CompassData> *magneticNorthBuffer;
+
+    /**
+     * Pass magnetometer interval of given session, relaxed to the idle
+     * interval while stable.
+     *
+     * @param sessionId session ID.
+     * @param interval magnetometer interval of the session.
+     */
+    void applyMagInterval(int sessionId, unsigned int interval);
+
+    QMap<int, unsigned int> requestedMagIntervals; /**< magnetometer intervals of sessions */
+    unsigned int idleMagInterval;                  /**< magnetometer interval while stable, 0 if disabled */
+    bool stable;                                   /**< is heading stable */
 };
 
 #endif // COMPASSCHAIN_H
@@ -2,11 +2,13 @@ TARGET       = compasschain
 
 HEADERS += compasschain.h   \
            compasschainplugin.h \
-           compassfilter.h
+           compassfilter.h \
+           headingsmoothfilter.h
 
 SOURCES += compasschain.cpp   \
            compasschainplugin.cpp \
-           compassfilter.cpp
+           compassfilter.cpp \
+           headingsmoothfilter.cpp
 
 #HEADERS += ../../filters/avgaccfilter/avgaccfilter.h
 #SOURCES += ../../filters/avgaccfilter/avgaccfilter.cpp
@@ -15,3 +17,7 @@ INCLUDEPATH += ../../filters/coordinatealignfilter
 #INCLUDEPATH += ../../filters/avgaccfilter
 
 include( ../chain-config.pri )
+
+compassfloat {
+    DEFINES += SENSORFW_COMPASS_FLOAT
+}
@@ -17,46 +17,143 @@
    You should have received a copy of the GNU Lesser General Public
    License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
  */
-#include <QDebug>
 #include "compassfilter.h"
 #include "config.h"
+#include "logging.h"
 
 #include <QtCore/qmath.h>
+#include <math.h>
 
 #define RADIANS_TO_DEGREES 57.2957795
-#define DEGREES_TO_RADIANS 0.017453292
 
 CompassFilter::CompassFilter() :
         magDataSink(this, &CompassFilter::magDataAvailable),
         accelSink(this, &CompassFilter::accelDataAvailable),
         orientDataSink(this, &CompassFilter::orientDataAvailable),
-        factor(1)
+        factor(1),
+        level(0),
+        oldHeading(0),
+        headingValid(false),
+        degrees(0),
+        stableSamples(0),
+        stable(false),
+        stableHeading(0)
 {
     addSink(&magDataSink, "magsink");
     addSink(&accelSink, "accsink");
     addSink(&orientDataSink, "orientsink");
 
     addSource(&magSource, "magnorthangle");
+
+    accelThreshold = Config::configuration()->value<int>("compass/accel_threshold", 0);
+    magThreshold = Config::configuration()->value<int>("compass/mag_threshold", 0);
+    magHistory.setMode(timeAlignModeFromString(Config::configuration()->value<QString>("compass/sync_mode", "nearest")));
+    for (int i = 0; i < 3; ++i) {
+        usedAccel[i] = 0;
+        usedMag[i] = 0;
+        stableAccel[i] = 0;
+    }
+
+    stabilityTracked = Config::configuration()->value<unsigned int>("compass/idle_mag_interval", 0) > 0;
+    idleSamples = Config::configuration()->value<int>("compass/idle_samples", 20);
+    idleHeading = Config::configuration()->value<int>("compass/idle_heading", 2);
+    idleAccel = Config::configuration()->value<int>("compass/idle_accel", 50);
 }
 
-void CompassFilter::magDataAvailable(unsigned, const CalibratedMagneticFieldData *data)
+void CompassFilter::magDataAvailable(unsigned n, const CalibratedMagneticFieldData *data)
 {
-    adjX = data->x_;
-    adjY = data->y_;
-    adjZ = data->z_;
+    if (!n)
+        return;
 
-    magRX = data->rx_;
-    magRY = data->ry_;
-    magRZ = data->rz_;
+    // Magnetometer samples are kept by time, so the heading is computed
+    // with the field at the time of each accelerometer sample.
+    magHistory.add(n, data);
+    level = data[n - 1].level_;
+}
 
-    level = data->level_;
+void CompassFilter::accelDataAvailable(unsigned n, const AccelerationData *data)
+{
+    // Magnetometer samples are still buffered, so the heading is
+    // computed as soon as a consumer appears.
+    if (!magSource.hasDemand() || !n)
+        return;
+
+    if ((unsigned)output.size() < n)
+        output.resize(n);
+
+    for (unsigned i = 0; i < n; ++i) {
+        CalibratedMagneticFieldData mag;
+        magHistory.sample(data[i].timestamp_, mag);
+
+        // Heading is only recomputed when either input has moved more than
+        // the configured thresholds since the last computation.
+        if (!headingValid ||
+            qAbs(mag.rx_ - usedMag[0]) > magThreshold ||
+            qAbs(mag.ry_ - usedMag[1]) > magThreshold ||
+            qAbs(mag.rz_ - usedMag[2]) > magThreshold ||
+            qAbs(data[i].x_ - usedAccel[0]) > accelThreshold ||
+            qAbs(data[i].y_ - usedAccel[1]) > accelThreshold ||
+            qAbs(data[i].z_ - usedAccel[2]) > accelThreshold) {
+
+            // because sensorfw expects x,y axis to be opposite from what this algo expects
+            int offset = 90;
+            degrees = (int)(heading(data[i], mag) + (360 - offset)) % 360;
+
+            usedAccel[0] = data[i].x_;
+            usedAccel[1] = data[i].y_;
+            usedAccel[2] = data[i].z_;
+            usedMag[0] = mag.rx_;
+            usedMag[1] = mag.ry_;
+            usedMag[2] = mag.rz_;
+            headingValid = true;
+        }
+
+        CompassData& compassData = output[i]; //north angle
+        compassData = CompassData();
+        compassData.timestamp_ = data[i].timestamp_;
+        compassData.degrees_ = degrees;
+        compassData.rawDegrees_ = degrees;
+        compassData.level_ = mag.level_;
+
+        if (stabilityTracked)
+            trackStability(data[i], degrees);
+    }
+
+    magSource.propagate(n, output.constData());
 }
 
-void CompassFilter::accelDataAvailable(unsigned, const AccelerationData *data)
+void CompassFilter::trackStability(const AccelerationData& data, int heading)
+{
+    // Limits are measured from the start of the run, so slow drift
+    // ends it as well as a sudden turn.
+    int turn = qAbs(((heading - stableHeading) % 360 + 540) % 360 - 180);
+    bool within = stableSamples > 0 &&
+        turn <= idleHeading &&
+        qAbs(data.x_ - stableAccel[0]) <= idleAccel &&
+        qAbs(data.y_ - stableAccel[1]) <= idleAccel &&
+        qAbs(data.z_ - stableAccel[2]) <= idleAccel;
+
+    if (!within) {
+        stableSamples = 1;
+        stableHeading = heading;
+        stableAccel[0] = data.x_;
+        stableAccel[1] = data.y_;
+        stableAccel[2] = data.z_;
+        if (stable) {
+            stable = false;
+            emit stabilityChanged(false);
+        }
+        return;
+    }
+
+    if (!stable && ++stableSamples >= idleSamples) {
+        stable = true;
+        emit stabilityChanged(true);
+    }
+}
+
+CompassReal CompassFilter::heading(const AccelerationData& data, const CalibratedMagneticFieldData& mag) const
 {
-    qreal x = data->x_ * 0.00980665; // to m/s^2
-    qreal y = data->y_ * 0.00980665;
-    qreal z = data->z_ * 0.00980665;
     ///////////////
     /// \brief this algorithm is from Circuit Cellar Aug 2012
     ///  by Mark Pedley
@@ -65,62 +162,49 @@ void CompassFilter::accelDataAvailable(unsigned, const AccelerationData *data)
     /// Circuit Cellar magazine.
     /// http://circuitcellar.com/
     ///
-    qreal Psi = 0;
-    qreal The = 0;
-    qreal Phi = 0; /* yaw, pitch, roll angles in deg */
-
-    qreal Bx = magRX;
-    qreal By = magRY;
-    qreal Bz = magRZ;
-    qreal Gx = x;
-    qreal Gy = y;
-    qreal Gz = z;
-
-    qreal sinAngle, cosAngle; /* sine and cosine */
-    qreal fBfx;
-    qreal fBfy;
-    qreal fBfz; /* calibrated mag data in uT after tilt correction */
+    /// Roll and pitch are only needed through their sine and cosine,
+    /// which are taken directly from the normalized gravity vector
+    /// instead of computing the angles first. Only the heading itself
+    /// needs an arctangent. Gravity scale cancels out, so raw mG values
+    /// are used.
+    ///
+    CompassReal Gx = data.x_;
+    CompassReal Gy = data.y_;
+    CompassReal Gz = data.z_;
 
     /* subtract off the hard iron interference computed using equation 9*/
-
-    Bx -= adjX;
-    By -= adjY;
-    Bz -= adjZ;
-
-    /* calculate roll angle Phi (-180deg, 180deg) and sin, cos */
-
-    Phi = qAtan2(Gy, Gz) * RADIANS_TO_DEGREES; /* Equation 2 */
-    sinAngle = qSin(Phi * DEGREES_TO_RADIANS);  /* sin(Phi) */
-    cosAngle = qCos(Phi * DEGREES_TO_RADIANS);  /* cos(Phi) */
+    CompassReal Bx = (CompassReal)mag.rx_ - mag.x_;
+    CompassReal By = (CompassReal)mag.ry_ - mag.y_;
+    CompassReal Bz = (CompassReal)mag.rz_ - mag.z_;
+
+    /* roll angle Phi = atan2(Gy, Gz), Equation 2 */
+    CompassReal sinAngle = 0;
+    CompassReal cosAngle = 1;
+    CompassReal norm = sqrt(Gy * Gy + Gz * Gz);
+    if (norm > 0) {
+        sinAngle = Gy / norm;
+        cosAngle = Gz / norm;
+    }
 
     /* de-rotate by roll angle Phi */
-    fBfy = By * cosAngle - Bz * sinAngle; /* Equation 5 y component */
-
+    CompassReal fBfy = By * cosAngle - Bz * sinAngle; /* Equation 5 y component */
     Bz = By * sinAngle + Bz * cosAngle; /*Bz=(By-Vy).sin(Phi)+(Bz-Vz).cos(Phi) */
-    Gz = Gy * sinAngle + Gz * cosAngle; /* Gz=Gy.sin(Phi)+Gz.cos(Phi) */
+    Gz = norm;                          /* Gz=Gy.sin(Phi)+Gz.cos(Phi) */
 
-    /* calculate pitch angle Theta (-90deg, 90deg) and sin, cos*/
-    The = atan(-Gx / Gz) * RADIANS_TO_DEGREES;  /* Equation 3 */
-    sinAngle = qSin(The * DEGREES_TO_RADIANS); /* sin(Theta) */
-    cosAngle = qCos(The * DEGREES_TO_RADIANS); /* cos(Theta) */
+    /* pitch angle Theta = atan(-Gx / Gz), Equation 3, cos(Theta) >= 0 */
+    sinAngle = 0;
+    cosAngle = 1;
+    norm = sqrt(Gx * Gx + Gz * Gz);
+    if (norm > 0) {
+        sinAngle = -Gx / norm;
+        cosAngle = Gz / norm;
+    }
 
     /* de-rotate by pitch angle Theta */
-    fBfx = Bx * cosAngle + Bz * sinAngle; /* Equation 5 x component */
-    fBfz = -Bx * sinAngle + Bz * cosAngle; /* Equation 5 z component */
-
-    /* calculate yaw = ecompass angle psi (-180deg, 180deg) */
-
-    Psi = (qAtan2(-fBfy, fBfx) * RADIANS_TO_DEGREES); /* Equation 7 */
+    CompassReal fBfx = Bx * cosAngle + Bz * sinAngle; /* Equation 5 x component */
 
-
-// because sensorfw expects x,y axis to be opposite from what this algo expects
-int offset = 90;
-    ////////////////////////////////////////
-    CompassData compassData; //north angle
-    compassData.timestamp_ = data->timestamp_;
-    compassData.degrees_ = (int)(Psi + (360 - offset)) % 360;
-    compassData.level_ = level;
-    magSource.propagate(1, &compassData);
+    /* yaw = ecompass angle psi (-180deg, 180deg), Equation 7 */
+    return atan2(-fBfy, fBfx) * (CompassReal)RADIANS_TO_DEGREES;
 }
 
 void CompassFilter::orientDataAvailable(unsigned, const TimedXyzData *data)
@@ -129,7 +213,7 @@ void CompassFilter::orientDataAvailable(unsigned, const TimedXyzData *data)
     compassData.timestamp_ = data->timestamp_;
     compassData.degrees_ = data->x_;
     compassData.level_ = level;
-    qDebug() << Q_FUNC_INFO << compassData.degrees_ * .001;
+    sensordLogT() << "orientation heading " << compassData.degrees_ * .001;
 
 //    magSource.propagate(1, &compassData);
 }
@@ -25,6 +25,18 @@
 #include "ringbuffer.h"
 #include "orientationdata.h"
 #include "filter.h"
+#include "timealigner.h"
+
+/**
+ * Floating point type of the heading computation. Build with
+ * CONFIG+=compassfloat to use single precision, which is considerably
+ * cheaper on ARM cores with a single precision FPU.
+ */
+#ifdef SENSORFW_COMPASS_FLOAT
+typedef float CompassReal;
+#else
+typedef qreal CompassReal;
+#endif
 
 class CompassFilter : public QObject, public FilterBase
 {
@@ -36,6 +48,17 @@ public:
         return new CompassFilter;
     }
 
+Q_SIGNALS:
+    /**
+     * Heading and tilt have stayed within <tt>compass/idle_heading</tt>
+     * degrees and <tt>compass/idle_accel</tt> mG for
+     * <tt>compass/idle_samples</tt> samples, or moved again. Only
+     * tracked when <tt>compass/idle_mag_interval</tt> is set.
+     *
+     * @param stable is the heading stable.
+     */
+    void stabilityChanged(bool stable);
+
 protected:
 
     CompassFilter();
@@ -52,19 +75,47 @@ private:
     void accelDataAvailable(unsigned, const AccelerationData*);
     void orientDataAvailable(unsigned, const TimedXyzData*);
 
-    int factor;
-    CalibratedMagneticFieldData magData;
-
-    qreal magRX;
-    qreal magRY;
-    qreal magRZ;
+    /**
+     * Compute tilt compensated heading from accelerometer and
+     * magnetometer data.
+     *
+     * @param data accelerometer sample.
+     * @param mag magnetometer sample at the time of data.
+     * @return heading in degrees, -180 to 180.
+     */
+    CompassReal heading(const AccelerationData& data, const CalibratedMagneticFieldData& mag) const;
+
+    /**
+     * Update stability tracking with a computed heading.
+     *
+     * @param data accelerometer sample.
+     * @param heading north angle computed for it.
+     */
+    void trackStability(const AccelerationData& data, int heading);
 
-    qreal adjX;
-    qreal adjY;
-    qreal adjZ;
+    int factor;
 
     qreal level;
     qreal oldHeading;
+
+    TimeAligner<CalibratedMagneticFieldData> magHistory; /**< magnetometer samples by time */
+    QVector<CompassData> output; /**< output batch */
+
+    int accelThreshold;   /**< accelerometer change in mG which triggers recomputation */
+    int magThreshold;     /**< magnetometer change which triggers recomputation */
+    bool headingValid;    /**< has heading been computed */
+    int usedAccel[3];     /**< accelerometer values of the last computation */
+    int usedMag[3];       /**< magnetometer values of the last computation */
+    int degrees;          /**< last computed north angle */
+
+    bool stabilityTracked;  /**< is stability tracked */
+    int idleSamples;       /**< samples within limits before stable */
+    int idleHeading;       /**< heading change in degrees still counted as stable */
+    int idleAccel;         /**< accelerometer change in mG still counted as stable */
+    int stableSamples;     /**< consecutive samples within limits */
+    bool stable;           /**< is heading stable */
+    int stableAccel[3];    /**< accelerometer values at the start of the stable run */
+    int stableHeading;     /**< heading at the start of the stable run */
 };
 
 #endif
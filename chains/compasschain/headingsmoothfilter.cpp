@@ -0,0 +1,92 @@
+/**
+   @file headingsmoothfilter.cpp
+   @brief HeadingSmoothFilter
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "headingsmoothfilter.h"
+#include <math.h>
+#include "config.h"
+
+#define DEGREES_TO_RADIANS 0.017453292519943
+#define RADIANS_TO_DEGREES 57.2957795
+
+/**
+ * Gaps longer than this many time constants restart the average from
+ * the next sample, so a stale heading does not linger after standby.
+ */
+static const int MAX_GAP_TIME_CONSTANTS = 5;
+
+HeadingSmoothFilter::HeadingSmoothFilter() :
+    Filter<CompassData, HeadingSmoothFilter, CompassData>(this, &HeadingSmoothFilter::smooth)
+{
+    setTimeConstant(Config::configuration()->value<int>("compass/heading_time_constant", 0));
+    reset();
+}
+
+void HeadingSmoothFilter::setTimeConstant(int ms)
+{
+    timeConstant_ = qMax(0, ms) * 1000.0;
+}
+
+void HeadingSmoothFilter::reset()
+{
+    sin_ = 0;
+    cos_ = 1;
+    previous_ = 0;
+}
+
+void HeadingSmoothFilter::smooth(unsigned n, const CompassData* data)
+{
+    if (!n)
+        return;
+    if (timeConstant_ <= 0) {
+        source_.propagate(n, data);
+        return;
+    }
+
+    CompassData* output = outputSpan(n);
+    for (unsigned i = 0; i < n; ++i) {
+        double angle = data[i].degrees_ * DEGREES_TO_RADIANS;
+        double s = sin(angle);
+        double c = cos(angle);
+        quint64 timestamp = data[i].timestamp_;
+
+        if (!previous_ || timestamp < previous_ ||
+            timestamp - previous_ > MAX_GAP_TIME_CONSTANTS * timeConstant_) {
+            sin_ = s;
+            cos_ = c;
+        } else {
+            double weight = 1 - exp(-(double)(timestamp - previous_) / timeConstant_);
+            sin_ += weight * (s - sin_);
+            cos_ += weight * (c - cos_);
+        }
+        previous_ = timestamp;
+
+        output[i] = data[i];
+        // Opposite headings may cancel out, pass the sample as is then.
+        if (sin_ != 0 || cos_ != 0) {
+            int degrees = qRound(atan2(sin_, cos_) * RADIANS_TO_DEGREES);
+            output[i].degrees_ = (degrees + 360) % 360;
+            output[i].rawDegrees_ = output[i].degrees_;
+        }
+    }
+    source_.propagate(n, output);
+}
@@ -0,0 +1,73 @@
+/**
+   @file headingsmoothfilter.h
+   @brief HeadingSmoothFilter
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef HEADINGSMOOTHFILTER_H
+#define HEADINGSMOOTHFILTER_H
+
+#include "orientationdata.h"
+#include "filter.h"
+
+/**
+ * Smooths compass heading by averaging unit vectors instead of angles,
+ * so headings on both sides of north average to north rather than to
+ * south. Sines and cosines of the headings are accumulated with an
+ * exponential moving average whose weight depends on the time between
+ * samples, which keeps the smoothing the same at any sample rate.
+ *
+ * Configuration, group \c compass:
+ * - \c heading_time_constant time constant of the average in
+ *   milliseconds, default 0 which passes headings through unchanged.
+ */
+class HeadingSmoothFilter : public Filter<CompassData, HeadingSmoothFilter, CompassData>
+{
+public:
+    static FilterBase* factoryMethod()
+    {
+        return new HeadingSmoothFilter;
+    }
+
+    /**
+     * Set time constant of the average.
+     *
+     * @param ms time constant in milliseconds, 0 disables smoothing.
+     */
+    void setTimeConstant(int ms);
+
+    /**
+     * Forget the average. The next sample is passed as is.
+     */
+    void reset();
+
+protected:
+    HeadingSmoothFilter();
+
+private:
+    void smooth(unsigned n, const CompassData* data);
+
+    double  timeConstant_; /**< time constant in microseconds */
+    double  sin_;          /**< average sine of the heading */
+    double  cos_;          /**< average cosine of the heading */
+    quint64 previous_;     /**< timestamp of the previous sample, 0 when reset */
+};
+
+#endif // HEADINGSMOOTHFILTER_H
@@ -0,0 +1,183 @@
+/**
+   @file fusionchain.cpp
+   @brief FusionChain
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "fusionchain.h"
+#include "fusionfilter.h"
+#include "sensormanager.h"
+#include "config.h"
+#include "bin.h"
+#include "bufferreader.h"
+#include "logging.h"
+
+QStringList FusionChain::hardwareAdaptorIds()
+{
+    QStringList ids("rotationvectoradaptor");
+    if (Config::configuration()->value<bool>("fusion/game_rotation_vector", false))
+        ids << "gamerotationvectoradaptor";
+    return ids;
+}
+
+FusionChain::FusionChain(const QString& id) :
+    AbstractChain(id),
+    hardwareAdaptor_(NULL),
+    hardwareReader_(NULL),
+    gyroscopeAdaptor_(NULL),
+    accelerometerChain_(NULL),
+    magChain_(NULL),
+    gyroscopeReader_(NULL),
+    accelerometerReader_(NULL),
+    magReader_(NULL),
+    fusionFilter_(NULL)
+{
+    SensorManager& sm = SensorManager::instance();
+
+    quaternionOutput_ = new RingBuffer<TimedQuaternionData>(1);
+    nameOutputBuffer("quaternion", quaternionOutput_);
+    introduceAvailableDataRange(DataRange(-1, 1, 0));
+
+    // Create buffers for filter chain
+    filterBin_ = Bin::create(id);
+    filterBin_->add(quaternionOutput_, "quaternionbuffer");
+
+    foreach (const QString& adaptorId, hardwareAdaptorIds()) {
+        hardwareAdaptor_ = sm.requestHardwareAdaptor(adaptorId);
+        if (hardwareAdaptor_) {
+            hardwareAdaptorId_ = adaptorId;
+            break;
+        }
+    }
+
+    if (hardwareAdaptor_) {
+        setValid(true);
+        hardwareReader_ = new BufferReader<TimedQuaternionData>(1);
+        filterBin_->add(hardwareReader_, "hardware");
+        filterBin_->join("hardware", "source", "quaternionbuffer", "sink");
+        connectToSource(hardwareAdaptor_, "quaternion", hardwareReader_);
+
+        setDescription("Device attitude quaternion computed by the sensor hub");
+        addStandbyOverrideSource(hardwareAdaptor_);
+        setIntervalSource(hardwareAdaptor_);
+        return;
+    }
+
+    gyroscopeAdaptor_ = sm.requestDeviceAdaptor("gyroscopeadaptor");
+    Q_ASSERT( gyroscopeAdaptor_ );
+
+    accelerometerChain_ = sm.requestChain("accelerometerchain");
+    Q_ASSERT( accelerometerChain_ );
+
+    magChain_ = sm.requestChain("magcalibrationchain");
+    Q_ASSERT( magChain_ );
+
+    setValid(gyroscopeAdaptor_ && gyroscopeAdaptor_->isValid() &&
+             accelerometerChain_ && accelerometerChain_->isValid() &&
+             magChain_ && magChain_->isValid());
+
+    gyroscopeReader_ = new BufferReader<TimedXyzData>(1);
+    accelerometerReader_ = new BufferReader<AccelerationData>(1);
+    magReader_ = new BufferReader<CalibratedMagneticFieldData>(1);
+
+    fusionFilter_ = sm.instantiateFilter("fusionfilter");
+    Q_ASSERT( fusionFilter_ );
+
+    filterBin_->add(gyroscopeReader_, "gyroscope");
+    filterBin_->add(accelerometerReader_, "accelerometer");
+    filterBin_->add(magReader_, "magnetometer");
+    filterBin_->add(fusionFilter_, "fusion");
+
+    // Join filterchain buffers
+    filterBin_->join("gyroscope", "source", "fusion", "gyrosink");
+    filterBin_->join("accelerometer", "source", "fusion", "accsink");
+    filterBin_->join("magnetometer", "source", "fusion", "magsink");
+    filterBin_->join("fusion", "quaternion", "quaternionbuffer", "sink");
+
+    // Join datasources to the chain
+    connectToSource(gyroscopeAdaptor_, "gyroscope", gyroscopeReader_);
+    connectToSource(accelerometerChain_, "accelerometer", accelerometerReader_);
+    connectToSource(magChain_, "calibratedmagnetometerdata", magReader_);
+
+    setDescription("Device attitude quaternion fused from gyroscope, accelerometer and magnetometer");
+    addStandbyOverrideSource(gyroscopeAdaptor_);
+    addStandbyOverrideSource(accelerometerChain_);
+    addStandbyOverrideSource(magChain_);
+    setIntervalSource(gyroscopeAdaptor_);
+}
+
+FusionChain::~FusionChain()
+{
+    SensorManager& sm = SensorManager::instance();
+
+    if (hardwareAdaptor_) {
+        disconnectFromSource(hardwareAdaptor_, "quaternion", hardwareReader_);
+        sm.releaseDeviceAdaptor(hardwareAdaptorId_);
+    } else {
+        disconnectFromSource(gyroscopeAdaptor_, "gyroscope", gyroscopeReader_);
+        disconnectFromSource(accelerometerChain_, "accelerometer", accelerometerReader_);
+        disconnectFromSource(magChain_, "calibratedmagnetometerdata", magReader_);
+
+        sm.releaseDeviceAdaptor("gyroscopeadaptor");
+        sm.releaseChain("accelerometerchain");
+        sm.releaseChain("magcalibrationchain");
+    }
+
+    delete hardwareReader_;
+    delete gyroscopeReader_;
+    delete accelerometerReader_;
+    delete magReader_;
+    delete fusionFilter_;
+    delete quaternionOutput_;
+    delete filterBin_;
+}
+
+bool FusionChain::start()
+{
+    if (AbstractSensorChannel::start()) {
+        sensordLogD() << "Starting FusionChain";
+        filterBin_->start();
+        if (hardwareAdaptor_) {
+            hardwareAdaptor_->acquireSensor();
+        } else {
+            static_cast<FusionFilter*>(fusionFilter_)->reset();
+            gyroscopeAdaptor_->acquireSensor();
+            accelerometerChain_->start();
+            magChain_->start();
+        }
+    }
+    return true;
+}
+
+bool FusionChain::stop()
+{
+    if (AbstractSensorChannel::stop()) {
+        sensordLogD() << "Stopping FusionChain";
+        if (hardwareAdaptor_) {
+            hardwareAdaptor_->releaseSensor();
+        } else {
+            magChain_->stop();
+            accelerometerChain_->stop();
+            gyroscopeAdaptor_->releaseSensor();
+        }
+        filterBin_->stop();
+    }
+    return true;
+}
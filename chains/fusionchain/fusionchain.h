@@ -0,0 +1,107 @@
+/**
+   @file fusionchain.h
+   @brief FusionChain
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef FUSIONCHAIN_H
+#define FUSIONCHAIN_H
+
+#include <QStringList>
+
+#include "abstractsensor.h"
+#include "abstractchain.h"
+#include "deviceadaptor.h"
+#include "bufferreader.h"
+#include "filter.h"
+#include "bin.h"
+#include "datatypes/orientationdata.h"
+#include "datatypes/quaterniondata.h"
+
+class Bin;
+template <class TYPE> class BufferReader;
+class FilterBase;
+
+/**
+ * @brief Fusionchain provides device attitude as a quaternion stream
+ * fused from gyroscope, accelerometer and calibrated magnetometer data
+ * (see FusionFilter).
+ *
+ * Gyroscope sets the output rate, so interval requests are passed to
+ * the gyroscope adaptor. Accelerometer and magnetometer only correct
+ * drift and can run considerably slower.
+ *
+ * When the sensor hub computes the attitude itself, a configured and
+ * valid \c rotationvectoradaptor is used instead and none of the
+ * software path runs. With <tt>fusion/game_rotation_vector</tt> set
+ * \c gamerotationvectoradaptor is also accepted, its heading is not
+ * tied to magnetic north.
+ *
+ * <b>Output buffers:</b>
+ * <ul><li>\em quaternion TimedQuaternionData</li></ul>
+ */
+class FusionChain : public AbstractChain
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Hardware adaptors which may replace the software fusion, see
+     * SensorManager::requestHardwareAdaptor().
+     *
+     * @return adaptor ids in order of preference.
+     */
+    static QStringList hardwareAdaptorIds();
+
+    /**
+     * Factory method for FusionChain.
+     * @return Pointer to new FusionChain instance as AbstractChain*
+     */
+    static AbstractChain* factoryMethod(const QString& id)
+    {
+        FusionChain* sc = new FusionChain(id);
+        return sc;
+    }
+
+public Q_SLOTS:
+    bool start();
+    bool stop();
+
+protected:
+    FusionChain(const QString& id);
+    ~FusionChain();
+
+private:
+    Bin*                                       filterBin_;
+
+    DeviceAdaptor*                             hardwareAdaptor_;
+    QString                                    hardwareAdaptorId_;
+    BufferReader<TimedQuaternionData>*         hardwareReader_;
+    DeviceAdaptor*                             gyroscopeAdaptor_;
+    AbstractChain*                             accelerometerChain_;
+    AbstractChain*                             magChain_;
+    BufferReader<TimedXyzData>*                gyroscopeReader_;
+    BufferReader<AccelerationData>*            accelerometerReader_;
+    BufferReader<CalibratedMagneticFieldData>* magReader_;
+    FilterBase*                                fusionFilter_;
+    RingBuffer<TimedQuaternionData>*           quaternionOutput_;
+};
+
+#endif // FUSIONCHAIN_H
@@ -0,0 +1,11 @@
+TARGET       = fusionchain
+
+HEADERS += fusionchain.h   \
+           fusionchainplugin.h \
+           fusionfilter.h
+
+SOURCES += fusionchain.cpp   \
+           fusionchainplugin.cpp \
+           fusionfilter.cpp
+
+include( ../chain-config.pri )
@@ -0,0 +1,49 @@
+/**
+   @file fusionchainplugin.cpp
+   @brief FusionChainPlugin
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "fusionchainplugin.h"
+#include "fusionchain.h"
+#include "fusionfilter.h"
+#include "sensormanager.h"
+#include "logging.h"
+
+void FusionChainPlugin::Register(class Loader&)
+{
+    sensordLogD() << "registering fusionchain";
+    SensorManager& sm = SensorManager::instance();
+    sm.registerChain<FusionChain>("fusionchain");
+    sm.registerFilter<FusionFilter>("fusionfilter");
+}
+
+QStringList FusionChainPlugin::Dependencies() {
+    QStringList dependencies(QString("gyroscopeadaptor:accelerometerchain:magcalibrationchain").split(":", QString::SkipEmptyParts));
+    foreach (const QString& id, FusionChain::hardwareAdaptorIds()) {
+        if (SensorManager::hasHardwareAdaptor(id))
+            dependencies << id;
+    }
+    return dependencies;
+}
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+Q_EXPORT_PLUGIN2(fusionchain, FusionChainPlugin)
+#endif
@@ -0,0 +1,265 @@
+/**
+   @file fusionfilter.cpp
+   @brief FusionFilter
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "fusionfilter.h"
+#include <math.h>
+#include "config.h"
+
+/**
+ * Gyroscope samples are millidegrees per second.
+ */
+static const float MDPS_TO_RADPS = 0.001f * 3.14159265f / 180.0f;
+
+/**
+ * Longest time step integrated. Longer gaps, for example after standby,
+ * restart integration.
+ */
+static const quint64 MAX_STEP_US = 500000;
+
+/**
+ * Time after the first sample during which initial_beta is used.
+ */
+static const quint64 CONVERGENCE_US = 1000000;
+
+static inline float invSqrt(float x)
+{
+    return 1.0f / sqrtf(x);
+}
+
+FusionFilter::FusionFilter() :
+    gyroSink_(this, &FusionFilter::gyroDataAvailable),
+    accelSink_(this, &FusionFilter::accelDataAvailable),
+    magSink_(this, &FusionFilter::magDataAvailable)
+{
+    addSink(&gyroSink_, "gyrosink");
+    addSink(&accelSink_, "accsink");
+    addSink(&magSink_, "magsink");
+    addSource(&source_, "quaternion");
+
+    beta_ = Config::configuration()->value<float>("fusion/beta", 0.1f);
+    initialBeta_ = Config::configuration()->value<float>("fusion/initial_beta", 2.0f);
+    reset();
+}
+
+void FusionFilter::reset()
+{
+    QMutexLocker locker(&mutex_);
+    for (int i = 0; i < 3; ++i) {
+        accel_[i] = 0;
+        mag_[i] = 0;
+    }
+    hasAccel_ = false;
+    hasMag_ = false;
+    q_[0] = 1;
+    q_[1] = q_[2] = q_[3] = 0;
+    previous_ = 0;
+    started_ = 0;
+}
+
+void FusionFilter::accelDataAvailable(unsigned n, const AccelerationData* data)
+{
+    if (!n)
+        return;
+    const AccelerationData& latest = data[n - 1];
+    QMutexLocker locker(&mutex_);
+    accel_[0] = latest.x_;
+    accel_[1] = latest.y_;
+    accel_[2] = latest.z_;
+    hasAccel_ = true;
+}
+
+void FusionFilter::magDataAvailable(unsigned n, const CalibratedMagneticFieldData* data)
+{
+    if (!n)
+        return;
+    const CalibratedMagneticFieldData& latest = data[n - 1];
+    QMutexLocker locker(&mutex_);
+    mag_[0] = latest.rx_ - latest.x_;
+    mag_[1] = latest.ry_ - latest.y_;
+    mag_[2] = latest.rz_ - latest.z_;
+    hasMag_ = true;
+}
+
+void FusionFilter::gyroDataAvailable(unsigned n, const TimedXyzData* data)
+{
+    for (unsigned i = 0; i < n; ++i) {
+        quint64 timestamp = data[i].timestamp_;
+        TimedQuaternionData quaternion;
+        {
+            QMutexLocker locker(&mutex_);
+            if (!started_)
+                started_ = timestamp;
+            if (previous_ && timestamp > previous_ && timestamp - previous_ <= MAX_STEP_US && hasAccel_) {
+                float dt = (timestamp - previous_) * 0.000001f;
+                float beta = timestamp - started_ < CONVERGENCE_US ? initialBeta_ : beta_;
+                float gx = data[i].x_ * MDPS_TO_RADPS;
+                float gy = data[i].y_ * MDPS_TO_RADPS;
+                float gz = data[i].z_ * MDPS_TO_RADPS;
+                if (hasMag_ && (mag_[0] != 0 || mag_[1] != 0 || mag_[2] != 0))
+                    update(gx, gy, gz, accel_[0], accel_[1], accel_[2], mag_[0], mag_[1], mag_[2], dt, beta);
+                else
+                    updateImu(gx, gy, gz, accel_[0], accel_[1], accel_[2], dt, beta);
+            }
+            previous_ = timestamp;
+            quaternion = TimedQuaternionData(timestamp, q_[0], q_[1], q_[2], q_[3]);
+        }
+        source_.propagate(1, &quaternion);
+    }
+}
+
+void FusionFilter::update(float gx, float gy, float gz, float ax, float ay, float az,
+                          float mx, float my, float mz, float dt, float beta)
+{
+    float q0 = q_[0], q1 = q_[1], q2 = q_[2], q3 = q_[3];
+
+    // Rate of change of quaternion from gyroscope
+    float qDot1 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+    float qDot2 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+    float qDot3 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+    float qDot4 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+    if (ax != 0 || ay != 0 || az != 0) {
+        float recipNorm = invSqrt(ax * ax + ay * ay + az * az);
+        ax *= recipNorm;
+        ay *= recipNorm;
+        az *= recipNorm;
+
+        recipNorm = invSqrt(mx * mx + my * my + mz * mz);
+        mx *= recipNorm;
+        my *= recipNorm;
+        mz *= recipNorm;
+
+        float _2q0mx = 2.0f * q0 * mx;
+        float _2q0my = 2.0f * q0 * my;
+        float _2q0mz = 2.0f * q0 * mz;
+        float _2q1mx = 2.0f * q1 * mx;
+        float _2q0 = 2.0f * q0;
+        float _2q1 = 2.0f * q1;
+        float _2q2 = 2.0f * q2;
+        float _2q3 = 2.0f * q3;
+        float _2q0q2 = 2.0f * q0 * q2;
+        float _2q2q3 = 2.0f * q2 * q3;
+        float q0q0 = q0 * q0;
+        float q0q1 = q0 * q1;
+        float q0q2 = q0 * q2;
+        float q0q3 = q0 * q3;
+        float q1q1 = q1 * q1;
+        float q1q2 = q1 * q2;
+        float q1q3 = q1 * q3;
+        float q2q2 = q2 * q2;
+        float q2q3 = q2 * q3;
+        float q3q3 = q3 * q3;
+
+        // Reference direction of Earth's magnetic field
+        float hx = mx * q0q0 - _2q0my * q3 + _2q0mz * q2 + mx * q1q1 + _2q1 * my * q2 + _2q1 * mz * q3 - mx * q2q2 - mx * q3q3;
+        float hy = _2q0mx * q3 + my * q0q0 - _2q0mz * q1 + _2q1mx * q2 - my * q1q1 + my * q2q2 + _2q2 * mz * q3 - my * q3q3;
+        float _2bx = sqrtf(hx * hx + hy * hy);
+        float _2bz = -_2q0mx * q2 + _2q0my * q1 + mz * q0q0 + _2q1mx * q3 - mz * q1q1 + _2q2 * my * q3 - mz * q2q2 + mz * q3q3;
+        float _4bx = 2.0f * _2bx;
+        float _4bz = 2.0f * _2bz;
+
+        // Gradient descent corrective step
+        float s0 = -_2q2 * (2.0f * q1q3 - _2q0q2 - ax) + _2q1 * (2.0f * q0q1 + _2q2q3 - ay) - _2bz * q2 * (_2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx) + (-_2bx * q3 + _2bz * q1) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my) + _2bx * q2 * (_2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz);
+        float s1 = _2q3 * (2.0f * q1q3 - _2q0q2 - ax) + _2q0 * (2.0f * q0q1 + _2q2q3 - ay) - 4.0f * q1 * (1 - 2.0f * q1q1 - 2.0f * q2q2 - az) + _2bz * q3 * (_2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx) + (_2bx * q2 + _2bz * q0) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my) + (_2bx * q3 - _4bz * q1) * (_2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz);
+        float s2 = -_2q0 * (2.0f * q1q3 - _2q0q2 - ax) + _2q3 * (2.0f * q0q1 + _2q2q3 - ay) - 4.0f * q2 * (1 - 2.0f * q1q1 - 2.0f * q2q2 - az) + (-_4bx * q2 - _2bz * q0) * (_2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx) + (_2bx * q1 + _2bz * q3) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my) + (_2bx * q0 - _4bz * q2) * (_2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz);
+        float s3 = _2q1 * (2.0f * q1q3 - _2q0q2 - ax) + _2q2 * (2.0f * q0q1 + _2q2q3 - ay) + (-_4bx * q3 + _2bz * q1) * (_2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx) + (-_2bx * q0 + _2bz * q2) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my) + _2bx * q1 * (_2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz);
+
+        float norm = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+        if (norm > 0) {
+            recipNorm = invSqrt(norm);
+            qDot1 -= beta * s0 * recipNorm;
+            qDot2 -= beta * s1 * recipNorm;
+            qDot3 -= beta * s2 * recipNorm;
+            qDot4 -= beta * s3 * recipNorm;
+        }
+    }
+
+    q0 += qDot1 * dt;
+    q1 += qDot2 * dt;
+    q2 += qDot3 * dt;
+    q3 += qDot4 * dt;
+
+    float recipNorm = invSqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    q_[0] = q0 * recipNorm;
+    q_[1] = q1 * recipNorm;
+    q_[2] = q2 * recipNorm;
+    q_[3] = q3 * recipNorm;
+}
+
+void FusionFilter::updateImu(float gx, float gy, float gz, float ax, float ay, float az, float dt, float beta)
+{
+    float q0 = q_[0], q1 = q_[1], q2 = q_[2], q3 = q_[3];
+
+    // Rate of change of quaternion from gyroscope
+    float qDot1 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+    float qDot2 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+    float qDot3 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+    float qDot4 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+    if (ax != 0 || ay != 0 || az != 0) {
+        float recipNorm = invSqrt(ax * ax + ay * ay + az * az);
+        ax *= recipNorm;
+        ay *= recipNorm;
+        az *= recipNorm;
+
+        float _2q0 = 2.0f * q0;
+        float _2q1 = 2.0f * q1;
+        float _2q2 = 2.0f * q2;
+        float _2q3 = 2.0f * q3;
+        float _4q0 = 4.0f * q0;
+        float _4q1 = 4.0f * q1;
+        float _4q2 = 4.0f * q2;
+        float _8q1 = 8.0f * q1;
+        float _8q2 = 8.0f * q2;
+        float q0q0 = q0 * q0;
+        float q1q1 = q1 * q1;
+        float q2q2 = q2 * q2;
+        float q3q3 = q3 * q3;
+
+        // Gradient descent corrective step
+        float s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+        float s1 = _4q1 * q3q3 - _2q3 * ax + 4.0f * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+        float s2 = 4.0f * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+        float s3 = 4.0f * q1q1 * q3 - _2q1 * ax + 4.0f * q2q2 * q3 - _2q2 * ay;
+
+        float norm = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+        if (norm > 0) {
+            recipNorm = invSqrt(norm);
+            qDot1 -= beta * s0 * recipNorm;
+            qDot2 -= beta * s1 * recipNorm;
+            qDot3 -= beta * s2 * recipNorm;
+            qDot4 -= beta * s3 * recipNorm;
+        }
+    }
+
+    q0 += qDot1 * dt;
+    q1 += qDot2 * dt;
+    q2 += qDot3 * dt;
+    q3 += qDot4 * dt;
+
+    float recipNorm = invSqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    q_[0] = q0 * recipNorm;
+    q_[1] = q1 * recipNorm;
+    q_[2] = q2 * recipNorm;
+    q_[3] = q3 * recipNorm;
+}
@@ -0,0 +1,115 @@
+/**
+   @file fusionfilter.h
+   @brief FusionFilter
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef FUSIONFILTER_H
+#define FUSIONFILTER_H
+
+#include <QMutex>
+#include "filter.h"
+#include "orientationdata.h"
+#include "quaterniondata.h"
+
+/**
+ * Attitude estimation from gyroscope, accelerometer and calibrated
+ * magnetometer data with the gradient descent filter by Madgwick
+ * ("An efficient orientation filter for inertial and
+ * inertial/magnetic sensor arrays", 2010).
+ *
+ * Gyroscope samples drive the filter: each one is integrated and
+ * corrected towards the latest accelerometer and magnetometer samples,
+ * and produces one TimedQuaternionData. Without magnetometer data only
+ * gravity is used for correction and heading drifts with the gyroscope.
+ * Sinks may be called from different adaptor threads.
+ *
+ * Configuration, group \c fusion:
+ * - \c beta correction gain, default 0.1. Higher values trust the
+ *   accelerometer and magnetometer more and follow them faster.
+ * - \c initial_beta gain used during the first second after start to
+ *   converge quickly from the identity, default 2.0.
+ */
+class FusionFilter : public FilterBase
+{
+public:
+    static FilterBase* factoryMethod()
+    {
+        return new FusionFilter;
+    }
+
+    /**
+     * Forget the current estimate. The next samples converge again
+     * from the identity rotation.
+     */
+    void reset();
+
+protected:
+    FusionFilter();
+
+private:
+    void gyroDataAvailable(unsigned n, const TimedXyzData* data);
+    void accelDataAvailable(unsigned n, const AccelerationData* data);
+    void magDataAvailable(unsigned n, const CalibratedMagneticFieldData* data);
+
+    /**
+     * Filter update with magnetometer correction.
+     *
+     * @param gx angular rate around X in rad/s.
+     * @param gy angular rate around Y in rad/s.
+     * @param gz angular rate around Z in rad/s.
+     * @param ax accelerometer X, any unit.
+     * @param ay accelerometer Y.
+     * @param az accelerometer Z.
+     * @param mx magnetometer X, any unit.
+     * @param my magnetometer Y.
+     * @param mz magnetometer Z.
+     * @param dt time step in seconds.
+     * @param beta correction gain.
+     */
+    void update(float gx, float gy, float gz, float ax, float ay, float az,
+                float mx, float my, float mz, float dt, float beta);
+
+    /**
+     * Filter update without magnetometer.
+     *
+     * @see update()
+     */
+    void updateImu(float gx, float gy, float gz, float ax, float ay, float az, float dt, float beta);
+
+    Sink<FusionFilter, TimedXyzData>                gyroSink_;
+    Sink<FusionFilter, AccelerationData>            accelSink_;
+    Sink<FusionFilter, CalibratedMagneticFieldData> magSink_;
+    Source<TimedQuaternionData>                     source_;
+
+    QMutex  mutex_;        /**< protects the latest accelerometer and magnetometer data */
+    float   accel_[3];     /**< latest accelerometer sample */
+    float   mag_[3];       /**< latest hard iron corrected magnetometer sample */
+    bool    hasAccel_;     /**< has accelerometer data arrived */
+    bool    hasMag_;       /**< has magnetometer data arrived */
+
+    float   q_[4];         /**< current estimate, w x y z */
+    quint64 previous_;     /**< timestamp of the previous gyroscope sample */
+    quint64 started_;      /**< timestamp of the first gyroscope sample */
+    float   beta_;         /**< correction gain */
+    float   initialBeta_;  /**< correction gain while converging */
+};
+
+#endif // FUSIONFILTER_H
@@ -0,0 +1,167 @@
+/**
+   @file gyroscopebiasfilter.cpp
+   @brief GyroscopeBiasFilter
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "gyroscopebiasfilter.h"
+#include <math.h>
+#include "config.h"
+#include "logging.h"
+
+/**
+ * Weight of a new sample in the short term mean and variance used for
+ * stillness detection.
+ */
+static const double VARIANCE_WEIGHT = 0.1;
+
+/**
+ * Longest time step integrated into the delta rotation. Longer gaps,
+ * for example after standby, are skipped.
+ */
+static const quint64 MAX_STEP_US = 500000;
+
+GyroscopeBiasFilter::GyroscopeBiasFilter() :
+    sink_(this, &GyroscopeBiasFilter::interpret)
+{
+    addSink(&sink_, "sink");
+    addSource(&source_, "source");
+    addSource(&deltaSource_, "delta");
+    sink_.setStatistics(&statistics_);
+    source_.setStatistics(&statistics_);
+
+    correct_ = Config::configuration()->value<bool>("gyroscope/bias_correction", true);
+    threshold_ = Config::configuration()->value<double>("gyroscope/stillness_threshold", 1000.0);
+    hysteresis_ = Config::configuration()->value<double>("gyroscope/stillness_hysteresis", 0.1);
+    stillSamples_ = qMax(1, Config::configuration()->value<int>("gyroscope/stillness_samples", 50));
+
+    for (int i = 0; i < 3; ++i)
+        bias_[i] = 0;
+    reset();
+}
+
+void GyroscopeBiasFilter::reset()
+{
+    for (int i = 0; i < 3; ++i) {
+        mean_[i] = 0;
+        variance_[i] = 0;
+        stillSum_[i] = 0;
+        residual_[i] = 0;
+    }
+    hasMean_ = false;
+    still_ = false;
+    stillCount_ = 0;
+    previous_ = 0;
+}
+
+void GyroscopeBiasFilter::update(const TimedXyzData& sample)
+{
+    double rate[3] = { (double)sample.x_, (double)sample.y_, (double)sample.z_ };
+
+    double variance = 0;
+    for (int i = 0; i < 3; ++i) {
+        if (!hasMean_) {
+            mean_[i] = rate[i];
+            continue;
+        }
+        double diff = rate[i] - mean_[i];
+        mean_[i] += VARIANCE_WEIGHT * diff;
+        variance_[i] = (1 - VARIANCE_WEIGHT) * (variance_[i] + VARIANCE_WEIGHT * diff * diff);
+        variance = qMax(variance, variance_[i]);
+    }
+    if (!hasMean_) {
+        // Variance needs at least two samples
+        hasMean_ = true;
+        return;
+    }
+
+    double deviation = sqrt(variance);
+    if (deviation < threshold_ * (1 - hysteresis_)) {
+        still_ = true;
+    } else if (deviation > threshold_ * (1 + hysteresis_)) {
+        still_ = false;
+        stillCount_ = 0;
+        for (int i = 0; i < 3; ++i)
+            stillSum_[i] = 0;
+    }
+    if (!still_)
+        return;
+
+    if (stillCount_ < stillSamples_) {
+        ++stillCount_;
+        for (int i = 0; i < 3; ++i)
+            stillSum_[i] += rate[i];
+        if (stillCount_ == stillSamples_) {
+            for (int i = 0; i < 3; ++i)
+                bias_[i] = stillSum_[i] / stillCount_;
+            sensordLogD() << "Gyroscope bias estimate " << bias_[0] << ", " << bias_[1] << ", " << bias_[2] << " mdps";
+        }
+    } else {
+        for (int i = 0; i < 3; ++i)
+            bias_[i] += (rate[i] - bias_[i]) / stillSamples_;
+    }
+}
+
+void GyroscopeBiasFilter::interpret(unsigned n, const TimedXyzData* data)
+{
+    if (!n)
+        return;
+
+    if ((unsigned)output_.size() < n)
+        output_.resize(n);
+    TimedXyzData* output = output_.data();
+
+    for (unsigned i = 0; i < n; ++i) {
+        update(data[i]);
+        output[i] = TimedXyzData(data[i].timestamp_,
+                                 data[i].x_ - qRound(bias_[0]),
+                                 data[i].y_ - qRound(bias_[1]),
+                                 data[i].z_ - qRound(bias_[2]));
+    }
+
+    if (deltaSource_.hasDemand()) {
+        for (unsigned i = 0; i < n; ++i) {
+            quint64 timestamp = output[i].timestamp_;
+            if (previous_ && timestamp > previous_ && timestamp - previous_ <= MAX_STEP_US) {
+                double dt = (timestamp - previous_) * 0.000001;
+                residual_[0] += output[i].x_ * dt;
+                residual_[1] += output[i].y_ * dt;
+                residual_[2] += output[i].z_ * dt;
+            }
+            previous_ = timestamp;
+        }
+        // Keep the rounding error for the next batch so that deltas
+        // add up to the full rotation.
+        TimedXyzData delta(previous_, qRound(residual_[0]), qRound(residual_[1]), qRound(residual_[2]));
+        residual_[0] -= delta.x_;
+        residual_[1] -= delta.y_;
+        residual_[2] -= delta.z_;
+        deltaSource_.propagate(1, &delta);
+    } else {
+        previous_ = data[n - 1].timestamp_;
+        for (int i = 0; i < 3; ++i)
+            residual_[i] = 0;
+    }
+
+    if (correct_)
+        source_.propagate(n, output);
+    else
+        source_.propagate(n, data);
+}
@@ -0,0 +1,105 @@
+/**
+   @file gyroscopebiasfilter.h
+   @brief GyroscopeBiasFilter
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef GYROSCOPEBIASFILTER_H
+#define GYROSCOPEBIASFILTER_H
+
+#include <QVector>
+#include "filter.h"
+#include "datatypes/genericdata.h"
+
+/**
+ * Removes the zero rate offset from gyroscope samples.
+ *
+ * The offset is learned while the device is still: the per axis
+ * variance of the rates is tracked and compared against a threshold
+ * with hysteresis in the same way as StabilityFilter does it. After
+ * \c stillness_samples consecutive still samples their mean becomes the
+ * bias, and it keeps following the mean for as long as the device stays
+ * still. Motion freezes the estimate.
+ *
+ * Corrected rates are written to \em source. \em delta gets one sample
+ * per batch with the rotation around each axis since the previous batch
+ * in millidegrees, integrated from the corrected rates. Integration is
+ * skipped while nobody reads \em delta.
+ *
+ * Configuration, group \c gyroscope:
+ * - \c bias_correction remove the estimated bias from \em source,
+ *   default true. The delta output is always corrected.
+ * - \c stillness_threshold standard deviation of the rates in mdps
+ *   below which the device is still, default 1000.
+ * - \c stillness_hysteresis relative hysteresis of the threshold,
+ *   default 0.1.
+ * - \c stillness_samples still samples needed for a bias estimate,
+ *   default 50.
+ */
+class GyroscopeBiasFilter : public FilterBase
+{
+public:
+    static FilterBase* factoryMethod()
+    {
+        return new GyroscopeBiasFilter;
+    }
+
+    /**
+     * Forget timing and stillness state. The bias estimate is kept, as
+     * it changes slowly and is valid across restarts.
+     */
+    void reset();
+
+protected:
+    GyroscopeBiasFilter();
+
+private:
+    void interpret(unsigned n, const TimedXyzData* data);
+
+    /**
+     * Update the variance and stillness state and, while still, the
+     * bias estimate.
+     *
+     * @param sample raw gyroscope sample.
+     */
+    void update(const TimedXyzData& sample);
+
+    Sink<GyroscopeBiasFilter, TimedXyzData> sink_;
+    Source<TimedXyzData>                    source_;
+    Source<TimedXyzData>                    deltaSource_;
+    QVector<TimedXyzData>                   output_;      /**< corrected batch */
+
+    double  mean_[3];       /**< short term mean of the rates */
+    double  variance_[3];   /**< short term variance of the rates */
+    bool    hasMean_;       /**< has the first sample arrived */
+    bool    still_;         /**< is the device still */
+    double  stillSum_[3];   /**< sum of the still samples so far */
+    int     stillCount_;    /**< number of consecutive still samples */
+    double  bias_[3];       /**< bias estimate in mdps */
+    double  residual_[3];   /**< delta rotation not yet reported, in mdeg */
+    quint64 previous_;      /**< timestamp of the previous sample */
+
+    bool    correct_;       /**< is bias removed from source */
+    double  threshold_;     /**< stillness threshold in mdps */
+    double  hysteresis_;    /**< relative hysteresis of the threshold */
+    int     stillSamples_;  /**< still samples needed for an estimate */
+};
+
+#endif // GYROSCOPEBIASFILTER_H
@@ -0,0 +1,107 @@
+/**
+   @file gyroscopechain.cpp
+   @brief GyroscopeChain
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "gyroscopechain.h"
+#include "gyroscopebiasfilter.h"
+#include "sensormanager.h"
+#include "bin.h"
+#include "bufferreader.h"
+#include "logging.h"
+
+GyroscopeChain::GyroscopeChain(const QString& id) :
+    AbstractChain(id)
+{
+    SensorManager& sm = SensorManager::instance();
+
+    gyroscopeAdaptor_ = sm.requestDeviceAdaptor("gyroscopeadaptor");
+    Q_ASSERT( gyroscopeAdaptor_ );
+    setValid(gyroscopeAdaptor_ && gyroscopeAdaptor_->isValid());
+
+    gyroscopeReader_ = new BufferReader<TimedXyzData>(32);
+
+    biasFilter_ = sm.instantiateFilter("gyroscopebiasfilter");
+    Q_ASSERT( biasFilter_ );
+
+    outputBuffer_ = new RingBuffer<TimedXyzData>(32);
+    nameOutputBuffer("gyroscope", outputBuffer_);
+    deltaBuffer_ = new RingBuffer<TimedXyzData>(32);
+    nameOutputBuffer("deltarotation", deltaBuffer_);
+
+    // Create buffers for filter chain
+    filterBin_ = Bin::create(id);
+
+    filterBin_->add(gyroscopeReader_, "gyroscope");
+    filterBin_->add(biasFilter_, "biasfilter");
+    filterBin_->add(outputBuffer_, "buffer");
+    filterBin_->add(deltaBuffer_, "deltabuffer");
+
+    // Join filterchain buffers
+    filterBin_->join("gyroscope", "source", "biasfilter", "sink");
+    filterBin_->join("biasfilter", "source", "buffer", "sink");
+    filterBin_->join("biasfilter", "delta", "deltabuffer", "sink");
+    filterBin_->freeze();
+
+    // Join datasources to the chain
+    connectToSource(gyroscopeAdaptor_, "gyroscope", gyroscopeReader_);
+
+    setDescription("Bias corrected angular velocity and rotation deltas");
+    setRangeSource(gyroscopeAdaptor_);
+    addStandbyOverrideSource(gyroscopeAdaptor_);
+    setIntervalSource(gyroscopeAdaptor_);
+}
+
+GyroscopeChain::~GyroscopeChain()
+{
+    SensorManager& sm = SensorManager::instance();
+
+    disconnectFromSource(gyroscopeAdaptor_, "gyroscope", gyroscopeReader_);
+
+    sm.releaseDeviceAdaptor("gyroscopeadaptor");
+
+    delete gyroscopeReader_;
+    delete biasFilter_;
+    delete outputBuffer_;
+    delete deltaBuffer_;
+    delete filterBin_;
+}
+
+bool GyroscopeChain::start()
+{
+    if (AbstractSensorChannel::start()) {
+        sensordLogD() << "Starting GyroscopeChain";
+        static_cast<GyroscopeBiasFilter*>(biasFilter_)->reset();
+        filterBin_->start();
+        gyroscopeAdaptor_->acquireSensor();
+    }
+    return true;
+}
+
+bool GyroscopeChain::stop()
+{
+    if (AbstractSensorChannel::stop()) {
+        sensordLogD() << "Stopping GyroscopeChain";
+        gyroscopeAdaptor_->releaseSensor();
+        filterBin_->stop();
+    }
+    return true;
+}
@@ -0,0 +1,82 @@
+/**
+   @file gyroscopechain.h
+   @brief GyroscopeChain
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef GYROSCOPECHAIN_H
+#define GYROSCOPECHAIN_H
+
+#include "abstractsensor.h"
+#include "abstractchain.h"
+#include "deviceadaptor.h"
+#include "datatypes/genericdata.h"
+
+class Bin;
+template <class TYPE> class BufferReader;
+class FilterBase;
+
+/**
+ * @brief Gyroscopechain provides gyroscope rates with the zero rate
+ * offset removed (see GyroscopeBiasFilter).
+ *
+ * Besides the rates the chain integrates rotation deltas, so clients
+ * reading at a low rate still get the complete rotation between their
+ * reads.
+ *
+ * <b>Output buffers:</b>
+ * <ul><li>\em gyroscope TimedXyzData, bias corrected rates in mdps</li>
+ *     <li>\em deltarotation TimedXyzData, rotation around each axis
+ *         since the previous batch in mdeg</li></ul>
+ */
+class GyroscopeChain : public AbstractChain
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Factory method for GyroscopeChain.
+     * @return Pointer to new GyroscopeChain instance as AbstractChain*
+     */
+    static AbstractChain* factoryMethod(const QString& id)
+    {
+        GyroscopeChain* sc = new GyroscopeChain(id);
+        return sc;
+    }
+
+public Q_SLOTS:
+    bool start();
+    bool stop();
+
+protected:
+    GyroscopeChain(const QString& id);
+    ~GyroscopeChain();
+
+private:
+    Bin*                        filterBin_;
+
+    DeviceAdaptor*              gyroscopeAdaptor_;
+    BufferReader<TimedXyzData>* gyroscopeReader_;
+    FilterBase*                 biasFilter_;
+    RingBuffer<TimedXyzData>*   outputBuffer_;
+    RingBuffer<TimedXyzData>*   deltaBuffer_;
+};
+
+#endif // GYROSCOPECHAIN_H
@@ -0,0 +1,11 @@
+TARGET       = gyroscopechain
+
+HEADERS += gyroscopechain.h   \
+           gyroscopechainplugin.h \
+           gyroscopebiasfilter.h
+
+SOURCES += gyroscopechain.cpp   \
+           gyroscopechainplugin.cpp \
+           gyroscopebiasfilter.cpp
+
+include( ../chain-config.pri )
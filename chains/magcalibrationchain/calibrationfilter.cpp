@@ -18,79 +18,292 @@
    License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <QDebug>
+#include <QDataStream>
+#include <QFile>
+#include <math.h>
+#include <string.h>
 
 #include "calibrationfilter.h"
 #include "config.h"
+#include "logging.h"
+
+/** Initial diagonal of the inverse correlation matrix */
+static const double INITIAL_COVARIANCE = 1e8;
+/** Fitted samples needed before the fit is trusted */
+static const int MIN_SAMPLES = 16;
+/** Smoothing factor of the fit error */
+static const double ERROR_SMOOTHING = 0.05;
+/** Identifies the calibration file and its format version */
+static const quint32 CALIBRATION_MAGIC = 0x4d414731;
 
 CalibrationFilter::CalibrationFilter() :
     Filter<TimedXyzData, CalibrationFilter, CalibratedMagneticFieldData>(this, &CalibrationFilter::magDataAvailable),
-    magDataSink(this, &CalibrationFilter::magDataAvailable),
-    calLevel(0)
+    revision_(0),
+    savedRevision_(0)
+{
+    addSink(&sink_, "magsink");
+    addSource(&source_, "calibratedmagneticfield");
+    addSource(&scaledSource, "scaledmagneticfield");
+
+    lambda_ = Config::configuration()->value<double>("magnetometer/calibration_forgetting", 0.995);
+    minDistance_ = Config::configuration()->value<int>("magnetometer/calibration_min_distance", 8);
+    scale_ = Config::configuration()->value<int>("magnetometer/scale_coefficient", 300);
+    reset();
+}
+
+void CalibrationFilter::reset()
 {
-    addSink(&magDataSink, "magsink");
-    addSource(&magSource, "calibratedmagneticfield");
-// min, max
-    minMaxList.insert(0,qMakePair(0,0));
-    minMaxList.insert(1,qMakePair(0,0));
-    minMaxList.insert(2,qMakePair(0,0));
+    memset(&state_, 0, sizeof(state_));
+    for (int i = 0; i < 4; ++i)
+        state_.p[i][i] = INITIAL_COVARIANCE;
+    state_.error = 1;
+    ++revision_;
 }
 
-#define LISTCOUNT 10
+bool CalibrationFilter::fit(const TimedXyzData& data)
+{
+    State& s = state_;
+    int m[3] = { data.x_, data.y_, data.z_ };
+
+    if (s.count)
+    {
+        long distance = 0;
+        for (int i = 0; i < 3; ++i)
+            distance += (long)(m[i] - s.last[i]) * (m[i] - s.last[i]);
+        if (distance < (long)minDistance_ * minDistance_)
+            return false;
+    }
+
+    double phi[4] = { 2.0 * m[0], 2.0 * m[1], 2.0 * m[2], 1.0 };
+    double y = (double)m[0] * m[0] + (double)m[1] * m[1] + (double)m[2] * m[2];
+
+    double pPhi[4];
+    double denominator = 0;
+    double prediction = 0;
+    double trace = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        pPhi[i] = 0;
+        for (int j = 0; j < 4; ++j)
+            pPhi[i] += s.p[i][j] * phi[j];
+        denominator += phi[i] * pPhi[i];
+        prediction += phi[i] * s.theta[i];
+        trace += s.p[i][i];
+    }
+
+    // Do not forget along directions the samples do not excite, otherwise
+    // the matrix grows without bound while the device turns in a plane.
+    double lambda = trace < 4 * INITIAL_COVARIANCE ? lambda_ : 1.0;
+    denominator += lambda;
+
+    double error = y - prediction;
+    for (int i = 0; i < 4; ++i)
+        s.theta[i] += pPhi[i] / denominator * error;
+    for (int i = 0; i < 4; ++i)
+        for (int j = 0; j < 4; ++j)
+            s.p[i][j] = (s.p[i][j] - pPhi[i] * pPhi[j] / denominator) / lambda;
+
+    for (int i = 0; i < 3; ++i)
+    {
+        if (!s.count || m[i] < s.minimum[i])
+            s.minimum[i] = m[i];
+        if (!s.count || m[i] > s.maximum[i])
+            s.maximum[i] = m[i];
+        s.last[i] = m[i];
+    }
+    ++s.count;
+
+    double r2 = s.theta[3];
+    double d2 = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        r2 += s.theta[i] * s.theta[i];
+        d2 += (m[i] - s.theta[i]) * (m[i] - s.theta[i]);
+    }
+    if (r2 > 0)
+    {
+        double r = sqrt(r2);
+        s.error += (fabs(sqrt(d2) - r) / r - s.error) * ERROR_SMOOTHING;
+    }
+    return true;
+}
+
+int CalibrationFilter::evaluateLevel() const
+{
+    const State& s = state_;
+    if (s.count < MIN_SAMPLES)
+        return 0;
+
+    double r2 = s.theta[3] + s.theta[0] * s.theta[0] + s.theta[1] * s.theta[1] + s.theta[2] * s.theta[2];
+    if (r2 <= 0)
+        return 0;
+    double r = sqrt(r2);
+
+    // Samples have to span the sphere along an axis before its offset is
+    // known, the fit error limits the level further.
+    int covered = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        if (s.maximum[i] - s.minimum[i] > r)
+            ++covered;
+    }
+    int quality = s.error < 0.02 ? 3 : (s.error < 0.05 ? 2 : 1);
+    return qMin(covered, quality);
+}
 
-void CalibrationFilter::magDataAvailable(unsigned, const TimedXyzData *data)
+void CalibrationFilter::magDataAvailable(unsigned n, const TimedXyzData *data)
 {
-    CalibratedMagneticFieldData transformed;
+    CalibratedMagneticFieldData* transformed = outputSpan(n);
 
-    transformed.timestamp_ = data->timestamp_;
+    QMutexLocker locker(&mutex_);
+    for (unsigned i = 0; i < n; ++i) {
+        if (fit(data[i])) {
+            state_.level = evaluateLevel();
+            ++revision_;
+        }
 
-  //  if (calLevel != 3) {
-        //    simple hard iron correction
-        if (minMaxList.at(0).first == 0) {
-            minMaxList.replace(0,qMakePair(data->x_, data->x_));
-            minMaxList.replace(1,qMakePair(data->y_, data->y_));
-            minMaxList.replace(2,qMakePair(data->z_, data->z_));
+        transformed[i].timestamp_ = data[i].timestamp_;
+        transformed[i].level_ = state_.level;
 
+        if (state_.level) {
+            transformed[i].x_ = qRound(state_.theta[0]);
+            transformed[i].y_ = qRound(state_.theta[1]);
+            transformed[i].z_ = qRound(state_.theta[2]);
         } else {
-            minMaxList.replace(0,qMakePair(qMin(minMaxList.at(0).first, data->x_),
-                                           qMax(minMaxList.at(0).second, data->x_)));
-            minMaxList.replace(1,qMakePair(qMin(minMaxList.at(1).first, data->y_),
-                                           qMax(minMaxList.at(1).second, data->y_)));
-            minMaxList.replace(2,qMakePair(qMin(minMaxList.at(2).first, data->z_),
-                                           qMax(minMaxList.at(2).second, data->z_)));
+            transformed[i].x_ = 0;
+            transformed[i].y_ = 0;
+            transformed[i].z_ = 0;
         }
-        qreal newX = (minMaxList.at(0).first + minMaxList.at(0).second) * .5;
-        qreal newY = (minMaxList.at(1).first + minMaxList.at(1).second) * .5;
-        qreal newZ = (minMaxList.at(2).first + minMaxList.at(2).second) * .5;
-
-        calLevel = 0;
-        if (oldX == newX)
-            calLevel += 1;
-        if (oldY == newY)
-            calLevel += 1;
-        if (oldZ == newZ)
-            calLevel += 1;
-
-        oldX = newX;
-        oldY = newY;
-        oldZ = newZ;
-  //  }
-    transformed.level_ = calLevel;
-
-    transformed.x_ = oldX;
-    transformed.y_ = oldY;
-    transformed.z_ = oldZ;
-
-    transformed.rx_ = data->x_;
-    transformed.ry_ = data->y_;
-    transformed.rz_ = data->z_;
-
-    magSource.propagate(1, &transformed);
-    source_.propagate(1, &transformed);
+
+        transformed[i].rx_ = data[i].x_;
+        transformed[i].ry_ = data[i].y_;
+        transformed[i].rz_ = data[i].z_;
+    }
+    locker.unlock();
+
+    if (source_.hasDemand())
+        source_.propagate(n, transformed);
+
+    if (!scaledSource.hasDemand())
+        return;
+    for (unsigned i = 0; i < n; ++i) {
+        transformed[i].x_ *= scale_;
+        transformed[i].y_ *= scale_;
+        transformed[i].z_ *= scale_;
+        transformed[i].rx_ *= scale_;
+        transformed[i].ry_ *= scale_;
+        transformed[i].rz_ *= scale_;
+    }
+    scaledSource.propagate(n, transformed);
 }
 
 void CalibrationFilter::dropCalibration()
 {
-    calLevel = 0;
-    minMaxList.clear();
+    QMutexLocker locker(&mutex_);
+    reset();
+}
+
+int CalibrationFilter::level() const
+{
+    QMutexLocker locker(&mutex_);
+    return state_.level;
+}
+
+bool CalibrationFilter::loadCalibration(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+    quint32 magic = 0;
+    stream >> magic;
+    if (magic != CALIBRATION_MAGIC)
+    {
+        sensordLogW() << "Ignoring magnetometer calibration of unknown format in " << path;
+        return false;
+    }
+
+    State s;
+    for (int i = 0; i < 4; ++i)
+    {
+        stream >> s.theta[i];
+        for (int j = 0; j < 4; ++j)
+            stream >> s.p[i][j];
+    }
+    stream >> s.error;
+    for (int i = 0; i < 3; ++i)
+    {
+        qint32 minimum, maximum, last;
+        stream >> minimum >> maximum >> last;
+        s.minimum[i] = minimum;
+        s.maximum[i] = maximum;
+        s.last[i] = last;
+    }
+    qint32 count;
+    stream >> count;
+    s.count = count;
+    if (stream.status() != QDataStream::Ok)
+    {
+        sensordLogW() << "Failed to read magnetometer calibration from " << path;
+        return false;
+    }
+
+    QMutexLocker locker(&mutex_);
+    state_ = s;
+    state_.level = evaluateLevel();
+    savedRevision_ = ++revision_;
+    sensordLogD() << "Restored magnetometer calibration, level " << state_.level;
+    return true;
+}
+
+bool CalibrationFilter::saveCalibration(const QString& path) const
+{
+    State s;
+    unsigned int revision;
+    {
+        QMutexLocker locker(&mutex_);
+        s = state_;
+        revision = revision_;
+    }
+    if (!s.count || revision == savedRevision_)
+        return true;
+
+    // Write a new file and replace the old one with it, so that an
+    // interrupted write never leaves a truncated calibration behind.
+    QString temporary = path + ".new";
+    QFile file(temporary);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        sensordLogW() << "Failed to open " << temporary << " for writing magnetometer calibration";
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+    stream << CALIBRATION_MAGIC;
+    for (int i = 0; i < 4; ++i)
+    {
+        stream << s.theta[i];
+        for (int j = 0; j < 4; ++j)
+            stream << s.p[i][j];
+    }
+    stream << s.error;
+    for (int i = 0; i < 3; ++i)
+        stream << (qint32)s.minimum[i] << (qint32)s.maximum[i] << (qint32)s.last[i];
+    stream << (qint32)s.count;
+    file.close();
+
+    if (stream.status() != QDataStream::Ok || file.error() != QFile::NoError)
+    {
+        QFile::remove(temporary);
+        return false;
+    }
+    QFile::remove(path);
+    if (!QFile::rename(temporary, path))
+        return false;
+    savedRevision_ = revision;
+    sensordLogD() << "Saved magnetometer calibration to " << path << ", level " << s.level;
+    return true;
 }
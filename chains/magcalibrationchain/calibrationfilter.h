@@ -22,11 +22,32 @@
 #define MAGCALIBRATIONFILTER_H
 
 #include <QObject>
+#include <QMutex>
+#include <QString>
 
 #include "orientationdata.h"
 #include "filter.h"
 
-
+/**
+ * Hard iron calibration of the magnetometer. Samples are fitted to a
+ * sphere with recursive least squares: for field \c m, centre \c c and
+ * radius \c r the model |m|^2 = 2 m.c + (r^2 - |c|^2) is linear in the
+ * four unknowns, so every sample costs a fixed 4x4 update and no sample
+ * history is kept. Only samples which differ enough from the previously
+ * used one are fitted, which keeps a still device from dominating the
+ * fit.
+ *
+ * Output \c x_, \c y_ and \c z_ carry the estimated offset and \c rx_,
+ * \c ry_ and \c rz_ the raw field. Level is 0 until enough samples are
+ * fitted and then grows with the number of axes the samples cover and
+ * with the quality of the fit, up to 3.
+ *
+ * Source \c calibratedmagneticfield gives the output in sensor units.
+ * Source \c scaledmagneticfield gives the same output multiplied by
+ * <tt>magnetometer/scale_coefficient</tt>. The scaled values are
+ * written over the unscaled batch, so scaling costs no extra stage or
+ * copy, and each source is only propagated to when it has demand.
+ */
 class CalibrationFilter : public QObject, public Filter<TimedXyzData, CalibrationFilter, CalibratedMagneticFieldData>
 {
     Q_OBJECT
@@ -36,28 +57,73 @@ public:
     static FilterBase* factoryMethod() {
         return new CalibrationFilter;
     }
+
+    /**
+     * Forget the calibration and start fitting again.
+     */
     void dropCalibration();
 
+    /**
+     * Restore calibration state saved with #saveCalibration().
+     *
+     * @param path file to read.
+     * @return was state restored.
+     */
+    bool loadCalibration(const QString& path);
+
+    /**
+     * Save calibration state so that fitting continues from it after a
+     * restart. Nothing is written before the first sample is fitted or
+     * when the state has not changed since it was last saved or loaded.
+     *
+     * @param path file to write.
+     * @return \c false if writing failed.
+     */
+    bool saveCalibration(const QString& path) const;
+
+    /**
+     * Current calibration level.
+     *
+     * @return level from 0 to 3.
+     */
+    int level() const;
+
 protected:
 
     CalibrationFilter();
 
 private:
 
-    Sink<CalibrationFilter, TimedXyzData> magDataSink;
-
-    Source<CalibratedMagneticFieldData> magSource;
+    /**
+     * Complete state of the fit.
+     */
+    struct State
+    {
+        double theta[4];    /**< centre x, y, z and r^2 - |c|^2 */
+        double p[4][4];     /**< inverse correlation matrix */
+        double error;       /**< smoothed relative radius error */
+        int    minimum[3];  /**< minimum of fitted samples per axis */
+        int    maximum[3];  /**< maximum of fitted samples per axis */
+        int    last[3];     /**< previously fitted sample */
+        int    count;       /**< number of fitted samples */
+        int    level;       /**< calibration level */
+    };
 
     void magDataAvailable(unsigned, const TimedXyzData * );
 
-    CalibratedMagneticFieldData magData;
-    QList <QPair<int,int> > minMaxList;
+    void reset();
+    bool fit(const TimedXyzData& data);
+    int evaluateLevel() const;
 
-    qreal oldX;
-    qreal oldY;
-    qreal oldZ;
+    Source<CalibratedMagneticFieldData> scaledSource;
 
-    qreal calLevel;
+    mutable QMutex mutex_;  /**< guards state_ against save and load */
+    State state_;           /**< fit state */
+    unsigned int revision_; /**< incremented on every change of state_ */
+    mutable unsigned int savedRevision_; /**< revision last saved or loaded */
+    double lambda_;         /**< forgetting factor */
+    int minDistance_;       /**< minimum distance of fitted samples */
+    int scale_;             /**< factor of the scaled output */
 };
 
 #endif
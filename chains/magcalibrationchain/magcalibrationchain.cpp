@@ -30,6 +30,11 @@
 #include "logging.h"
 #include "calibrationfilter.h"
 
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
 //#include "coordinatealignfilter.h"
 #include "datatypes/orientationdata.h"
 // magcalibrationchain requires: magnetometeradaptor, kbslideradaptor
@@ -45,23 +50,23 @@ MagCalibrationChain::MagCalibrationChain(const QString& id) :
     setValid(magAdaptor->isValid());
 
 // Config::configuration()->value<int>("magnetometer/interval_compensation", 16);
-    magReader = new BufferReader<TimedXyzData>(1);
+    magReader = new BufferReader<TimedXyzData>(32);
 
     magCalFilter = sm.instantiateFilter("calibrationfilter");
-    magScaleFilter = sm.instantiateFilter("magnetometerscalefilter");
-
 
-    calibratedMagnetometerData = new RingBuffer<CalibratedMagneticFieldData>(1);
+    calibratedMagnetometerData = new RingBuffer<CalibratedMagneticFieldData>(32);
     nameOutputBuffer("calibratedmagnetometerdata", calibratedMagnetometerData);
+    scaledMagnetometerData = new RingBuffer<CalibratedMagneticFieldData>(32);
+    nameOutputBuffer("scaledmagnetometerdata", scaledMagnetometerData);
 
     // Create buffers for filter chain
-    filterBin = new Bin;
+    filterBin = Bin::create(id);
 //formationsink
     filterBin->add(magReader, "calibratedmagneticfield");
     filterBin->add(magCalFilter, "calibration");
-    filterBin->add(magScaleFilter,"filter");
 
     filterBin->add(calibratedMagnetometerData, "calibratedmagnetometerdata"); //calibration
+    filterBin->add(scaledMagnetometerData, "scaledmagnetometerdata");
 
     // Join filterchain buffers
     if (!filterBin->join("calibratedmagneticfield", "source", "calibration", "magsink"))
@@ -70,6 +75,9 @@ MagCalibrationChain::MagCalibrationChain(const QString& id) :
     if (!filterBin->join("calibration", "calibratedmagneticfield", "calibratedmagnetometerdata", "sink"))
         qDebug() << Q_FUNC_INFO << "calibration join failed";
 
+    if (!filterBin->join("calibration", "scaledmagneticfield", "scaledmagnetometerdata", "sink"))
+        qDebug() << Q_FUNC_INFO << "scaled calibration join failed";
+
 
 //////    ///////
 //    if (!filterBin->join("magnetometeradaptor", "source", "filter", "sink"))
@@ -86,12 +94,30 @@ MagCalibrationChain::MagCalibrationChain(const QString& id) :
     setRangeSource(magAdaptor);
     addStandbyOverrideSource(magAdaptor);
     setIntervalSource(magAdaptor);
+
+    calibrationFile = Config::configuration()->value<QString>("magnetometer/calibration_file", "/var/lib/sensord/magcalibration");
+    if (!calibrationFile.isEmpty())
+    {
+        static_cast<CalibrationFilter *>(magCalFilter)->loadCalibration(calibrationFile);
+
+        // Chains are only deleted with the sensor manager, after the
+        // event loop and configuration are gone. Save when quitting and
+        // periodically, in case sensord is killed instead.
+        connect(QCoreApplication::instance(), SIGNAL(aboutToQuit()), this, SLOT(saveCalibration()));
+        int saveInterval = Config::configuration()->value<int>("magnetometer/calibration_save_interval", 300);
+        if (saveInterval > 0)
+        {
+            saveTimer.setInterval(saveInterval * 1000);
+            connect(&saveTimer, SIGNAL(timeout()), this, SLOT(saveCalibration()));
+        }
+    }
 }
 
 MagCalibrationChain::~MagCalibrationChain()
 {
     SensorManager& sm = SensorManager::instance();
 
+    saveCalibration();
     disconnectFromSource(magAdaptor, "magnetometer", magReader);
 
     sm.releaseDeviceAdaptor("magnetometeradaptor");
@@ -99,6 +125,7 @@ MagCalibrationChain::~MagCalibrationChain()
     delete magReader;
     delete magCalFilter;
     delete calibratedMagnetometerData;
+    delete scaledMagnetometerData;
     delete filterBin;
 }
 
@@ -107,7 +134,9 @@ bool MagCalibrationChain::start()
     if (AbstractSensorChannel::start()) {
         sensordLogD() << "Starting MagCalibrationChain";
         filterBin->start();
-        magAdaptor->startSensor();
+        magAdaptor->acquireSensor();
+        if (saveTimer.interval() > 0)
+            saveTimer.start();
     }
     return true;
 }
@@ -116,8 +145,10 @@ bool MagCalibrationChain::stop()
 {
     if (AbstractSensorChannel::stop()) {
         sensordLogD() << "Stopping MagCalibrationChain";
-        magAdaptor->stopSensor();
+        magAdaptor->releaseSensor();
         filterBin->stop();
+        saveTimer.stop();
+        saveCalibration();
     }
     return true;
 }
@@ -126,5 +157,17 @@ void MagCalibrationChain::resetCalibration()
 {
     CalibrationFilter *filter = static_cast<CalibrationFilter *>(magCalFilter);
     filter->dropCalibration();
+    if (!calibrationFile.isEmpty())
+        QFile::remove(calibrationFile);
     qDebug() << Q_FUNC_INFO;
 }
+
+void MagCalibrationChain::saveCalibration()
+{
+    if (calibrationFile.isEmpty())
+        return;
+    QDir().mkpath(QFileInfo(calibrationFile).absolutePath());
+    CalibrationFilter *filter = static_cast<CalibrationFilter *>(magCalFilter);
+    if (!filter->saveCalibration(calibrationFile))
+        sensordLogW() << "Failed to save magnetometer calibration to " << calibrationFile;
+}
@@ -33,11 +33,14 @@
 #include "orientationdata.h"
 #include "timedunsigned.h"
 
+#include <QTimer>
+
 /*
  * // property
  *
  * //// MagCalibrationChain
  * calibratedmagnetometerdata
+ * scaledmagnetometerdata
  * resetCalibration
  **/
 class Bin;
@@ -67,6 +70,13 @@ public Q_SLOTS:
     bool stop();
     void resetCalibration();
 
+private Q_SLOTS:
+    /**
+     * Save calibration state to <tt>magnetometer/calibration_file</tt>,
+     * if one is configured and the state has changed.
+     */
+    void saveCalibration();
+
 protected:
     MagCalibrationChain(const QString& id);
     ~MagCalibrationChain();
@@ -79,9 +89,12 @@ private:
     BufferReader<TimedXyzData>  *magReader; //pusher/producer
 
     FilterBase* magCalFilter;
-    FilterBase* magScaleFilter;
 
     RingBuffer<CalibratedMagneticFieldData> *calibratedMagnetometerData; //consumer
+    RingBuffer<CalibratedMagneticFieldData> *scaledMagnetometerData; //consumer, scaled
+
+    QString calibrationFile; /**< where calibration is kept across restarts */
+    QTimer saveTimer;        /**< periodic saving of calibration */
 };
 
 #endif // MAGCALIBRATIONCHAIN_H
@@ -27,9 +27,15 @@
 #include "sensormanager.h"
 #include "bin.h"
 #include "bufferreader.h"
+#include "config.h"
 
 OrientationChain::OrientationChain(const QString& id) :
-    AbstractChain(id)
+    AbstractChain(id),
+    idleInterval_(0),
+    burstInterval_(0),
+    motionWakeup_(false),
+    still_(false),
+    burst_(false)
 {
     SensorManager& sm = SensorManager::instance();
 
@@ -51,7 +57,7 @@ OrientationChain::OrientationChain(const QString& id) :
     nameOutputBuffer("orientation", orientationOutput_);
 
     // Create buffers for filter chain
-    filterBin_ = new Bin;
+    filterBin_ = Bin::create(id);
 
     filterBin_->add(accelerometerReader_, "accelerometer");
     filterBin_->add(orientationInterpreterFilter_, "orientationinterpreter");
@@ -72,6 +78,50 @@ OrientationChain::OrientationChain(const QString& id) :
     introduceAvailableDataRange(DataRange(0, 6, 1));
     addStandbyOverrideSource(accelerometerChain_);
     setIntervalSource(accelerometerChain_);
+
+    readConfiguration();
+}
+
+void OrientationChain::readConfiguration()
+{
+    idleInterval_ = Config::configuration()->value<unsigned int>("orientation/idle_interval", 0);
+    burstInterval_ = Config::configuration()->value<unsigned int>("orientation/burst_interval", 0);
+    motionWakeup_ = Config::configuration()->value<bool>("orientation/motion_wakeup", false);
+    QObject* filter = dynamic_cast<QObject*>(orientationInterpreterFilter_);
+    if ((idleInterval_ || motionWakeup_) && filter)
+    {
+        connect(filter, SIGNAL(stillnessChanged(bool)), this, SLOT(setStill(bool)), Qt::UniqueConnection);
+    }
+    if (burstInterval_ && filter)
+    {
+        connect(filter, SIGNAL(burstChanged(bool)), this, SLOT(setBurst(bool)), Qt::UniqueConnection);
+    }
+}
+
+void OrientationChain::configurationChanged(const QStringList& keys)
+{
+    bool changed = false;
+    foreach (const QString& key, keys)
+        changed = changed || key.startsWith("orientation/");
+    if (!changed)
+        return;
+
+    sensordLogD() << "Applying changed orientation configuration";
+    readConfiguration();
+    QObject* filter = dynamic_cast<QObject*>(orientationInterpreterFilter_);
+    if (filter)
+        QMetaObject::invokeMethod(filter, "reloadConfiguration", Qt::DirectConnection);
+
+    // Idle or burst interval may have changed or been disabled while
+    // in effect.
+    for (QMap<int, unsigned int>::const_iterator it = requestedIntervals_.constBegin(); it != requestedIntervals_.constEnd(); ++it)
+    {
+        if (!it.value())
+            continue;
+        unsigned int value = effectiveInterval(it.value());
+        if (accelerometerChain_->getInterval(it.key()) != value)
+            accelerometerChain_->setIntervalRequest(it.key(), value);
+    }
 }
 
 OrientationChain::~OrientationChain()
@@ -105,3 +155,76 @@ bool OrientationChain::stop()
     }
     return true;
 }
+
+void OrientationChain::sessionIntervalChanged(int sessionId)
+{
+    AbstractChain::sessionIntervalChanged(sessionId);
+    if (!idleInterval_ && !motionWakeup_ && !burstInterval_)
+        return;
+
+    // Requests are stored in the accelerometer chain, remember what the
+    // session asked for so that it can be restored.
+    unsigned int interval = accelerometerChain_->getInterval(sessionId);
+    if (interval)
+        requestedIntervals_[sessionId] = interval;
+    else
+        requestedIntervals_.remove(sessionId);
+
+    if (burst_)
+        applyInterval(sessionId, interval);
+
+    if (still_)
+    {
+        applyInterval(sessionId, interval);
+        if (motionWakeup_ && interval)
+            accelerometerChain_->setMotionWakeupRequest(sessionId, true);
+    }
+}
+
+void OrientationChain::setStill(bool still)
+{
+    if (still_ == still)
+        return;
+    still_ = still;
+    sensordLogD() << "Device " << (still ? "still" : "moving") << ", " << requestedIntervals_.size() << " orientation sessions " << (still ? "relaxed to " : "restored from ") << idleInterval_ << " ms";
+
+    for (QMap<int, unsigned int>::const_iterator it = requestedIntervals_.constBegin(); it != requestedIntervals_.constEnd(); ++it)
+    {
+        applyInterval(it.key(), it.value());
+        // Leave wake on motion before restoring the rate, so that the
+        // adaptor streams again as soon as the device moves.
+        if (motionWakeup_)
+            accelerometerChain_->setMotionWakeupRequest(it.key(), still);
+    }
+}
+
+void OrientationChain::setBurst(bool burst)
+{
+    if (burst_ == burst)
+        return;
+    burst_ = burst;
+    sensordLogD() << "Orientation burst " << (burst ? "started at " : "ended, back from ") << burstInterval_ << " ms for " << requestedIntervals_.size() << " sessions";
+
+    for (QMap<int, unsigned int>::const_iterator it = requestedIntervals_.constBegin(); it != requestedIntervals_.constEnd(); ++it)
+        applyInterval(it.key(), it.value());
+}
+
+unsigned int OrientationChain::effectiveInterval(unsigned int interval) const
+{
+    unsigned int value = interval;
+    if (still_ && idleInterval_ && value < idleInterval_)
+        value = idleInterval_;
+    if (burst_ && burstInterval_ && burstInterval_ < value)
+        value = burstInterval_;
+    return value;
+}
+
+void OrientationChain::applyInterval(int sessionId, unsigned int interval)
+{
+    if (!interval || (!idleInterval_ && !burstInterval_))
+        return;
+    unsigned int value = effectiveInterval(interval);
+    if (accelerometerChain_->getInterval(sessionId) == value)
+        return;
+    accelerometerChain_->setIntervalRequest(sessionId, value);
+}
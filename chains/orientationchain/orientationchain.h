@@ -45,6 +45,15 @@ class FilterBase;
  * @brief Orientationchain providies device orientation information
  * using the accelerometer information.
  *
+ * When <tt>orientation/idle_interval</tt> is set, the accelerometer
+ * requests of the sessions are relaxed to that interval while the
+ * device is still, and restored as soon as it moves. When
+ * <tt>orientation/motion_wakeup</tt> is set, the sessions also tell the
+ * accelerometer that they tolerate wake on motion delivery while still.
+ * When <tt>orientation/burst_interval</tt> is set, the requests are
+ * raised to that interval while the interpreter confirms a candidate
+ * rotation, so a low idle rate does not make rotation sluggish.
+ *
  * <b>Output buffers:</b>
  * <ul><li>\em device orientation</li></ul>
  */
@@ -87,7 +96,57 @@ protected:
     OrientationChain(const QString& id);
     ~OrientationChain();
 
+    virtual void sessionIntervalChanged(int sessionId);
+
+    /**
+     * Apply changed <tt>orientation/</tt> settings to the chain and the
+     * orientation interpreter.
+     *
+     * @param keys changed configuration keys.
+     */
+    virtual void configurationChanged(const QStringList& keys);
+
+private Q_SLOTS:
+    /**
+     * Apply idle or requested intervals on stillness change.
+     *
+     * @param still is device still.
+     */
+    void setStill(bool still);
+
+    /**
+     * Apply burst or requested intervals on burst change.
+     *
+     * @param burst is a burst running.
+     */
+    void setBurst(bool burst);
+
 private:
+    /**
+     * Pass interval of given session to accelerometer, relaxed to the
+     * idle interval while still.
+     *
+     * @param sessionId session ID.
+     * @param interval interval requested by the session.
+     */
+    void applyInterval(int sessionId, unsigned int interval);
+
+    /**
+     * Interval to request from the accelerometer for a session, relaxed
+     * to the idle interval while still and raised to the burst interval
+     * during a burst.
+     *
+     * @param interval interval requested by the session.
+     * @return interval to request.
+     */
+    unsigned int effectiveInterval(unsigned int interval) const;
+
+    /**
+     * Read idle interval and motion wakeup settings.
+     */
+    void readConfiguration();
+
+
     static double                    aconv_[3][3];
     Bin*                             filterBin_;
 
@@ -97,6 +156,13 @@ private:
     RingBuffer<PoseData>*            topEdgeOutput_;
     RingBuffer<PoseData>*            faceOutput_;
     RingBuffer<PoseData>*            orientationOutput_;
+
+    QMap<int, unsigned int>          requestedIntervals_; /**< intervals requested by sessions */
+    unsigned int                     idleInterval_;       /**< interval while still, 0 if disabled */
+    unsigned int                     burstInterval_;      /**< interval while confirming a rotation, 0 if disabled */
+    bool                             motionWakeup_;       /**< request wake on motion while still */
+    bool                             still_;              /**< is device still */
+    bool                             burst_;              /**< is a burst running */
 };
 
 #endif // ORIENTATIONCHAIN_H
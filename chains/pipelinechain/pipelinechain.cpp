@@ -0,0 +1,334 @@
+/**
+   @file pipelinechain.cpp
+   @brief PipelineChain
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "pipelinechain.h"
+#include <QObject>
+#include <QMetaObject>
+#include <QMetaProperty>
+#include <QVariant>
+#include "sensormanager.h"
+#include "deviceadaptor.h"
+#include "bin.h"
+#include "bufferreader.h"
+#include "ringbuffer.h"
+#include "config.h"
+#include "logging.h"
+
+#include "genericdata.h"
+#include "orientationdata.h"
+#include "posedata.h"
+#include "quaterniondata.h"
+#include "timedunsigned.h"
+
+namespace {
+
+template <class TYPE>
+RingBufferReaderBase* createReader()
+{
+    return new BufferReader<TYPE>(1);
+}
+
+template <class TYPE>
+RingBufferBase* createBuffer()
+{
+    return new RingBuffer<TYPE>(1);
+}
+
+/**
+ * Sample types which can cross the chain boundary.
+ */
+struct SampleType
+{
+    const char*           name;
+    RingBufferReaderBase* (*reader)();
+    RingBufferBase*       (*buffer)();
+};
+
+const SampleType SAMPLE_TYPES[] = {
+    { "TimedXyzData",                createReader<TimedXyzData>,                createBuffer<TimedXyzData> },
+    { "AccelerationData",            createReader<AccelerationData>,            createBuffer<AccelerationData> },
+    { "CalibratedMagneticFieldData", createReader<CalibratedMagneticFieldData>, createBuffer<CalibratedMagneticFieldData> },
+    { "CompassData",                 createReader<CompassData>,                 createBuffer<CompassData> },
+    { "PoseData",                    createReader<PoseData>,                    createBuffer<PoseData> },
+    { "TimedUnsigned",               createReader<TimedUnsigned>,               createBuffer<TimedUnsigned> },
+    { "TimedQuaternionData",         createReader<TimedQuaternionData>,         createBuffer<TimedQuaternionData> }
+};
+
+const SampleType* sampleType(const QString& name)
+{
+    for (unsigned int i = 0; i < sizeof(SAMPLE_TYPES) / sizeof(SAMPLE_TYPES[0]); ++i) {
+        if (name == SAMPLE_TYPES[i].name)
+            return &SAMPLE_TYPES[i];
+    }
+    return NULL;
+}
+
+QStringList entries(const QString& key)
+{
+    return Config::configuration()->value<QStringList>(key, QStringList());
+}
+
+QStringList fields(const QString& entry)
+{
+    return entry.simplified().split(' ', QString::SkipEmptyParts);
+}
+
+}
+
+QStringList PipelineChain::dependencies(const QString& id)
+{
+    Config* config = Config::configuration();
+    if (config->exists(id + "/dependencies"))
+        return entries(id + "/dependencies");
+
+    QStringList plugins;
+    foreach (const QString& entry, entries(id + "/inputs")) {
+        QStringList f = fields(entry);
+        if (f.size() == 5 && !plugins.contains(f.at(2)))
+            plugins << f.at(2);
+    }
+    foreach (const QString& entry, entries(id + "/filters")) {
+        QStringList f = fields(entry);
+        if (f.size() == 2 && !plugins.contains(f.at(1)))
+            plugins << f.at(1);
+    }
+    return plugins;
+}
+
+PipelineChain::PipelineChain(const QString& id) :
+    AbstractChain(id),
+    filterBin_(Bin::create(id))
+{
+    setDescription(Config::configuration()->value<QString>(id + "/description", "Pipeline " + id));
+    setValid(build());
+
+    if (!inputs_.isEmpty()) {
+        const Input& first = inputs_.first();
+        if (first.adaptor) {
+            setRangeSource(first.adaptor);
+            setIntervalSource(first.adaptor);
+        } else {
+            setRangeSource(first.chain);
+            setIntervalSource(first.chain);
+        }
+    }
+    foreach (const Input& input, inputs_) {
+        if (input.adaptor)
+            addStandbyOverrideSource(input.adaptor);
+        else
+            addStandbyOverrideSource(input.chain);
+    }
+}
+
+bool PipelineChain::build()
+{
+    SensorManager& sm = SensorManager::instance();
+    QString group = id() + "/";
+    QStringList names;
+    bool valid = true;
+
+    foreach (const QString& entry, entries(group + "inputs")) {
+        QStringList f = fields(entry);
+        const SampleType* type = f.size() == 5 ? sampleType(f.at(4)) : NULL;
+        if (!type || (f.at(1) != "adaptor" && f.at(1) != "chain") || names.contains(f.at(0))) {
+            sensordLogW() << id() << ": invalid input '" << entry << "'";
+            valid = false;
+            continue;
+        }
+
+        Input input;
+        input.id = f.at(2);
+        input.buffer = f.at(3);
+        input.adaptor = NULL;
+        input.chain = NULL;
+        if (f.at(1) == "adaptor")
+            input.adaptor = sm.requestDeviceAdaptor(input.id);
+        else
+            input.chain = sm.requestChain(input.id);
+        if (!input.adaptor && !input.chain) {
+            sensordLogW() << id() << ": input '" << input.id << "' not available";
+            valid = false;
+            continue;
+        }
+        valid = valid && (input.adaptor ? input.adaptor->isValid() : input.chain->isValid());
+
+        input.reader = type->reader();
+        inputs_.append(input);
+        names << f.at(0);
+        filterBin_->add(input.reader, f.at(0));
+    }
+
+    foreach (const QString& entry, entries(group + "filters")) {
+        QStringList f = fields(entry);
+        FilterBase* filter = (f.size() == 2 && !names.contains(f.at(0))) ? sm.instantiateFilter(f.at(1)) : NULL;
+        if (!filter) {
+            sensordLogW() << id() << ": invalid filter '" << entry << "'";
+            valid = false;
+            continue;
+        }
+
+        QObject* object = dynamic_cast<QObject*>(filter);
+        if (object) {
+            const QMetaObject* meta = object->metaObject();
+            for (int i = QObject::staticMetaObject.propertyCount(); i < meta->propertyCount(); ++i) {
+                QString key = group + f.at(0) + "." + meta->property(i).name();
+                if (!Config::configuration()->exists(key))
+                    continue;
+                QVariant value = Config::configuration()->value(key);
+                if (value.type() == QVariant::StringList)
+                    value = value.toStringList().join(",");
+                if (!meta->property(i).write(object, value)) {
+                    sensordLogW() << id() << ": failed to set " << key;
+                    valid = false;
+                }
+            }
+        }
+
+        filters_.append(filter);
+        names << f.at(0);
+        filterBin_->add(filter, f.at(0));
+    }
+
+    foreach (const QString& entry, entries(group + "outputs")) {
+        QStringList f = fields(entry);
+        const SampleType* type = f.size() == 2 ? sampleType(f.at(1)) : NULL;
+        if (!type || names.contains(f.at(0))) {
+            sensordLogW() << id() << ": invalid output '" << entry << "'";
+            valid = false;
+            continue;
+        }
+
+        RingBufferBase* buffer = type->buffer();
+        outputs_.append(buffer);
+        names << f.at(0);
+        filterBin_->add(buffer, f.at(0));
+        nameOutputBuffer(f.at(0), buffer);
+    }
+
+    QStringList used;
+    foreach (const QString& entry, entries(group + "joins")) {
+        if (!join(entry, used))
+            valid = false;
+    }
+    foreach (const QString& name, names) {
+        if (!used.contains(name)) {
+            sensordLogW() << id() << ": node '" << name << "' is not connected";
+            valid = false;
+        }
+    }
+    if (outputs_.isEmpty()) {
+        sensordLogW() << id() << ": pipeline has no outputs";
+        valid = false;
+    }
+
+    filterBin_->freeze();
+
+    foreach (const Input& input, inputs_) {
+        NodeBase* source = input.adaptor;
+        if (!source)
+            source = input.chain;
+        if (!connectToSource(source, input.buffer, input.reader)) {
+            sensordLogW() << id() << ": failed to connect to " << input.id << "/" << input.buffer;
+            valid = false;
+        }
+    }
+
+    return valid;
+}
+
+bool PipelineChain::join(const QString& entry, QStringList& used)
+{
+    QStringList f = fields(entry);
+    if (f.size() != 2) {
+        sensordLogW() << id() << ": invalid join '" << entry << "'";
+        return false;
+    }
+
+    QStringList producer = f.at(0).split('.');
+    QStringList consumer = f.at(1).split('.');
+    if (producer.size() > 2 || consumer.size() > 2) {
+        sensordLogW() << id() << ": invalid join '" << entry << "'";
+        return false;
+    }
+
+    QString source = producer.size() == 2 ? producer.at(1) : QString("source");
+    QString sink = consumer.size() == 2 ? consumer.at(1) : QString("sink");
+    if (!filterBin_->join(producer.at(0), source, consumer.at(0), sink)) {
+        sensordLogW() << id() << ": failed to join '" << entry << "'";
+        return false;
+    }
+
+    used << producer.at(0) << consumer.at(0);
+    return true;
+}
+
+PipelineChain::~PipelineChain()
+{
+    SensorManager& sm = SensorManager::instance();
+
+    foreach (const Input& input, inputs_) {
+        if (input.adaptor) {
+            disconnectFromSource(input.adaptor, input.buffer, input.reader);
+            sm.releaseDeviceAdaptor(input.id);
+        } else {
+            disconnectFromSource(input.chain, input.buffer, input.reader);
+            sm.releaseChain(input.id);
+        }
+        delete input.reader;
+    }
+    foreach (FilterBase* filter, filters_)
+        delete filter;
+    foreach (RingBufferBase* buffer, outputs_)
+        delete buffer;
+    delete filterBin_;
+}
+
+bool PipelineChain::start()
+{
+    if (AbstractSensorChannel::start()) {
+        sensordLogD() << "Starting PipelineChain " << id();
+        filterBin_->start();
+        foreach (const Input& input, inputs_) {
+            if (input.adaptor)
+                input.adaptor->acquireSensor();
+            else
+                input.chain->start();
+        }
+    }
+    return true;
+}
+
+bool PipelineChain::stop()
+{
+    if (AbstractSensorChannel::stop()) {
+        sensordLogD() << "Stopping PipelineChain " << id();
+        for (int i = inputs_.size() - 1; i >= 0; --i) {
+            if (inputs_.at(i).adaptor)
+                inputs_.at(i).adaptor->releaseSensor();
+            else
+                inputs_.at(i).chain->stop();
+        }
+        filterBin_->stop();
+    }
+    return true;
+}
@@ -0,0 +1,130 @@
+/**
+   @file pipelinechain.h
+   @brief PipelineChain
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef PIPELINECHAIN_H
+#define PIPELINECHAIN_H
+
+#include <QList>
+#include <QStringList>
+#include "abstractsensor.h"
+#include "abstractchain.h"
+
+class Bin;
+class DeviceAdaptor;
+class FilterBase;
+class RingBufferBase;
+class RingBufferReaderBase;
+
+/**
+ * @brief Chain whose filter graph is described in the configuration.
+ *
+ * The group named after the chain ID describes the graph. List entries
+ * are separated by commas, fields within an entry by spaces:
+ * - \c inputs: "name adaptor|chain id buffer type" entries. Each
+ *   reads the named output buffer of a device adaptor or another chain.
+ * - \c filters: "name filter" entries, instantiated through
+ *   SensorManager::instantiateFilter().
+ * - \c outputs: "name type" entries, each an output buffer of the chain.
+ * - \c joins: "producer[.source] consumer[.sink]" entries. Source
+ *   defaults to \c source and sink to \c sink.
+ * - \c description: chain description.
+ * - \c dependencies: plugins to load first, by default the inputs and
+ *   filters, see PipelineChain::dependencies().
+ * - <tt>name.property</tt>: value set to a property of a filter which
+ *   is also a QObject, for example <tt>align.matrix</tt> of
+ *   CoordinateAlignFilter.
+ *
+ * Types are data type names such as \c TimedXyzData. The graph is
+ * validated and frozen when the chain is created: an unknown node, type
+ * or filter, a failed join or a node left unconnected makes the chain
+ * invalid. Names are not used after construction.
+ *
+ * Interval, range and standby override follow the first input.
+ */
+class PipelineChain : public AbstractChain
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Factory method for PipelineChain.
+     * @return Pointer to new PipelineChain instance as AbstractChain*
+     */
+    static AbstractChain* factoryMethod(const QString& id)
+    {
+        PipelineChain* sc = new PipelineChain(id);
+        return sc;
+    }
+
+    /**
+     * Plugins a pipeline needs.
+     *
+     * @param id chain ID.
+     * @return plugin names.
+     */
+    static QStringList dependencies(const QString& id);
+
+public Q_SLOTS:
+    bool start();
+    bool stop();
+
+protected:
+    PipelineChain(const QString& id);
+    ~PipelineChain();
+
+private:
+    /**
+     * Node reading the output of an adaptor or a chain.
+     */
+    struct Input
+    {
+        QString               id;      /**< adaptor or chain ID */
+        QString               buffer;  /**< output buffer name of the source */
+        DeviceAdaptor*        adaptor; /**< source adaptor, or NULL */
+        AbstractChain*        chain;   /**< source chain, or NULL */
+        RingBufferReaderBase* reader;  /**< reader in the bin */
+    };
+
+    /**
+     * Build the graph from the configuration.
+     *
+     * @return is graph valid.
+     */
+    bool build();
+
+    /**
+     * Join two nodes.
+     *
+     * @param entry join entry.
+     * @param used names of the nodes joined so far.
+     * @return was join succesful.
+     */
+    bool join(const QString& entry, QStringList& used);
+
+    Bin*                   filterBin_;
+    QList<Input>           inputs_;
+    QList<FilterBase*>     filters_;
+    QList<RingBufferBase*> outputs_;
+};
+
+#endif // PIPELINECHAIN_H
@@ -0,0 +1,9 @@
+TARGET       = pipelinechain
+
+HEADERS += pipelinechain.h   \
+           pipelinechainplugin.h
+
+SOURCES += pipelinechain.cpp   \
+           pipelinechainplugin.cpp
+
+include( ../chain-config.pri )
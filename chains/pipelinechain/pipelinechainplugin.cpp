@@ -0,0 +1,52 @@
+/**
+   @file pipelinechainplugin.cpp
+   @brief PipelineChainPlugin
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "pipelinechainplugin.h"
+#include "pipelinechain.h"
+#include "sensormanager.h"
+#include "config.h"
+#include "logging.h"
+
+void PipelineChainPlugin::Register(class Loader&)
+{
+    SensorManager& sm = SensorManager::instance();
+    foreach (const QString& id, Config::configuration()->value<QStringList>("pipelinechain/chains", QStringList())) {
+        sensordLogD() << "registering pipeline chain " << id;
+        sm.registerChain<PipelineChain>(id);
+    }
+}
+
+QStringList PipelineChainPlugin::Dependencies() {
+    QStringList dependencies;
+    foreach (const QString& id, Config::configuration()->value<QStringList>("pipelinechain/chains", QStringList())) {
+        foreach (const QString& dependency, PipelineChain::dependencies(id)) {
+            if (!dependencies.contains(dependency))
+                dependencies << dependency;
+        }
+    }
+    return dependencies;
+}
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+Q_EXPORT_PLUGIN2(pipelinechain, PipelineChainPlugin)
+#endif
@@ -0,0 +1,129 @@
+/**
+   @file stepcounterchain.cpp
+   @brief StepCounterChain
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "stepcounterchain.h"
+#include "stepdetectorfilter.h"
+#include "sensormanager.h"
+#include "config.h"
+#include "bin.h"
+#include "bufferreader.h"
+#include "logging.h"
+
+StepCounterChain::StepCounterChain(const QString& id) :
+    AbstractChain(id),
+    stepCounterAdaptor_(NULL),
+    accelerometerChain_(NULL),
+    stepCounterReader_(NULL),
+    accelerometerReader_(NULL),
+    stepDetector_(NULL)
+{
+    SensorManager& sm = SensorManager::instance();
+
+    stepCounterAdaptor_ = sm.requestHardwareAdaptor("stepcounteradaptor");
+
+    outputBuffer_ = new RingBuffer<TimedUnsigned>(1);
+    nameOutputBuffer("stepcounter", outputBuffer_);
+
+    // Create buffers for filter chain
+    filterBin_ = Bin::create(id);
+    filterBin_->add(outputBuffer_, "buffer");
+
+    if (stepCounterAdaptor_) {
+        setValid(true);
+        stepCounterReader_ = new BufferReader<TimedUnsigned>(1);
+        filterBin_->add(stepCounterReader_, "stepcounter");
+        filterBin_->join("stepcounter", "source", "buffer", "sink");
+        connectToSource(stepCounterAdaptor_, "stepcounter", stepCounterReader_);
+
+        setDescription("Cumulative steps from the hardware step counter");
+        addStandbyOverrideSource(stepCounterAdaptor_);
+        setIntervalSource(stepCounterAdaptor_);
+    } else {
+        accelerometerChain_ = sm.requestChain("accelerometerchain");
+        Q_ASSERT( accelerometerChain_ );
+        setValid(accelerometerChain_ && accelerometerChain_->isValid());
+
+        accelerometerReader_ = new BufferReader<AccelerationData>(1);
+        stepDetector_ = sm.instantiateFilter("stepdetectorfilter");
+        Q_ASSERT( stepDetector_ );
+
+        filterBin_->add(accelerometerReader_, "accelerometer");
+        filterBin_->add(stepDetector_, "stepdetector");
+        filterBin_->join("accelerometer", "source", "stepdetector", "sink");
+        filterBin_->join("stepdetector", "source", "buffer", "sink");
+        connectToSource(accelerometerChain_, "accelerometer", accelerometerReader_);
+
+        setDescription("Cumulative steps detected from accelerometer");
+        addStandbyOverrideSource(accelerometerChain_);
+        setIntervalSource(accelerometerChain_);
+        setDefaultInterval(Config::configuration()->value<unsigned int>("stepcounter/interval", 50));
+    }
+    filterBin_->freeze();
+}
+
+StepCounterChain::~StepCounterChain()
+{
+    SensorManager& sm = SensorManager::instance();
+
+    if (stepCounterAdaptor_) {
+        disconnectFromSource(stepCounterAdaptor_, "stepcounter", stepCounterReader_);
+        sm.releaseDeviceAdaptor("stepcounteradaptor");
+    } else {
+        disconnectFromSource(accelerometerChain_, "accelerometer", accelerometerReader_);
+        sm.releaseChain("accelerometerchain");
+    }
+
+    delete stepCounterReader_;
+    delete accelerometerReader_;
+    delete stepDetector_;
+    delete outputBuffer_;
+    delete filterBin_;
+}
+
+bool StepCounterChain::start()
+{
+    if (AbstractSensorChannel::start()) {
+        sensordLogD() << "Starting StepCounterChain";
+        filterBin_->start();
+        if (stepCounterAdaptor_) {
+            stepCounterAdaptor_->acquireSensor();
+        } else {
+            static_cast<StepDetectorFilter*>(stepDetector_)->reset();
+            accelerometerChain_->start();
+        }
+    }
+    return true;
+}
+
+bool StepCounterChain::stop()
+{
+    if (AbstractSensorChannel::stop()) {
+        sensordLogD() << "Stopping StepCounterChain";
+        if (stepCounterAdaptor_)
+            stepCounterAdaptor_->releaseSensor();
+        else
+            accelerometerChain_->stop();
+        filterBin_->stop();
+    }
+    return true;
+}
@@ -0,0 +1,90 @@
+/**
+   @file stepcounterchain.h
+   @brief StepCounterChain
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef STEPCOUNTERCHAIN_H
+#define STEPCOUNTERCHAIN_H
+
+#include "abstractsensor.h"
+#include "abstractchain.h"
+#include "deviceadaptor.h"
+#include "datatypes/orientationdata.h"
+#include "datatypes/timedunsigned.h"
+
+class Bin;
+template <class TYPE> class BufferReader;
+class FilterBase;
+
+/**
+ * @brief StepCounterChain provides a cumulative step count.
+ *
+ * When a \c stepcounteradaptor is configured and valid, the count comes
+ * from the hardware step counter, which counts while the system sleeps.
+ * Otherwise steps are detected from the accelerometer chain running at
+ * <tt>stepcounter/interval</tt> ms, see StepDetectorFilter. Hardware
+ * counts steps since boot, software since sensord was started.
+ *
+ * <b>Output buffers:</b>
+ * <ul><li>\em stepcounter TimedUnsigned, cumulative steps</li></ul>
+ */
+class StepCounterChain : public AbstractChain
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Factory method for StepCounterChain.
+     * @return Pointer to new StepCounterChain instance as AbstractChain*
+     */
+    static AbstractChain* factoryMethod(const QString& id)
+    {
+        StepCounterChain* sc = new StepCounterChain(id);
+        return sc;
+    }
+
+    /**
+     * Is the count coming from hardware.
+     *
+     * @return is hardware step counter used.
+     */
+    bool isHardware() const { return stepCounterAdaptor_ != NULL; }
+
+public Q_SLOTS:
+    bool start();
+    bool stop();
+
+protected:
+    StepCounterChain(const QString& id);
+    ~StepCounterChain();
+
+private:
+    Bin*                            filterBin_;
+
+    DeviceAdaptor*                  stepCounterAdaptor_;
+    AbstractChain*                  accelerometerChain_;
+    BufferReader<TimedUnsigned>*    stepCounterReader_;
+    BufferReader<AccelerationData>* accelerometerReader_;
+    FilterBase*                     stepDetector_;
+    RingBuffer<TimedUnsigned>*      outputBuffer_;
+};
+
+#endif // STEPCOUNTERCHAIN_H
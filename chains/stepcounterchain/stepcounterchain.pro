@@ -0,0 +1,11 @@
+TARGET       = stepcounterchain
+
+HEADERS += stepcounterchain.h   \
+           stepcounterchainplugin.h \
+           stepdetectorfilter.h
+
+SOURCES += stepcounterchain.cpp   \
+           stepcounterchainplugin.cpp \
+           stepdetectorfilter.cpp
+
+include( ../chain-config.pri )
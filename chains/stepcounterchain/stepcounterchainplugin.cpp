@@ -0,0 +1,48 @@
+/**
+   @file stepcounterchainplugin.cpp
+   @brief StepCounterChainPlugin
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+
+#include "stepcounterchainplugin.h"
+#include "stepcounterchain.h"
+#include "stepdetectorfilter.h"
+#include "sensormanager.h"
+#include "logging.h"
+
+void StepCounterChainPlugin::Register(class Loader&)
+{
+    sensordLogD() << "registering stepcounterchain";
+    SensorManager& sm = SensorManager::instance();
+    sm.registerChain<StepCounterChain>("stepcounterchain");
+    sm.registerFilter<StepDetectorFilter>("stepdetectorfilter");
+}
+
+QStringList StepCounterChainPlugin::Dependencies() {
+    QStringList dependencies("accelerometerchain");
+    if (SensorManager::hasHardwareAdaptor("stepcounteradaptor"))
+        dependencies << "stepcounteradaptor";
+    return dependencies;
+}
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+Q_EXPORT_PLUGIN2(stepcounterchain, StepCounterChainPlugin)
+#endif
@@ -0,0 +1,109 @@
+/**
+   @file stepdetectorfilter.cpp
+   @brief StepDetectorFilter
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "stepdetectorfilter.h"
+#include "config.h"
+#include <math.h>
+
+/** Weight of a new sample in the running mean is 1/MEAN_SMOOTHING. */
+static const int MEAN_SMOOTHING = 16;
+
+static quint64 millis(const char* key, unsigned int defaultValue)
+{
+    return (quint64)Config::configuration()->value<unsigned int>(key, defaultValue) * 1000;
+}
+
+StepDetectorFilter::StepDetectorFilter() :
+    sink_(this, &StepDetectorFilter::interpret),
+    count_(0),
+    reported_(0),
+    lastReport_(0)
+{
+    addSink(&sink_, "sink");
+    addSource(&source_, "source");
+
+    Config* config = Config::configuration();
+    threshold_ = config->value<int>("stepcounter/threshold", 150);
+    minStepInterval_ = millis("stepcounter/min_step_interval", 250);
+    maxStepInterval_ = millis("stepcounter/max_step_interval", 2000);
+    minSteps_ = qMax(1u, config->value<unsigned int>("stepcounter/min_steps", 4));
+    updateInterval_ = millis("stepcounter/update_interval", 10000);
+    reset();
+}
+
+void StepDetectorFilter::reset()
+{
+    hasMean_ = false;
+    armed_ = false;
+    walkSteps_ = 0;
+    lastStep_ = 0;
+}
+
+void StepDetectorFilter::interpret(unsigned n, const AccelerationData* data)
+{
+    for (unsigned i = 0; i < n; ++i) {
+        double x = data[i].x_;
+        double y = data[i].y_;
+        double z = data[i].z_;
+        int magnitude = (int)sqrt(x * x + y * y + z * z);
+        quint64 t = data[i].timestamp_;
+
+        if (!hasMean_) {
+            mean_ = magnitude;
+            hasMean_ = true;
+            continue;
+        }
+        mean_ += (magnitude - mean_) / MEAN_SMOOTHING;
+
+        if (walkSteps_ && t - lastStep_ > maxStepInterval_)
+            walkSteps_ = 0;
+
+        if (magnitude < mean_) {
+            armed_ = true;
+        } else if (armed_ && magnitude - mean_ >= threshold_ &&
+                   (!walkSteps_ || t - lastStep_ >= minStepInterval_)) {
+            armed_ = false;
+            lastStep_ = t;
+            ++walkSteps_;
+            if (walkSteps_ == minSteps_)
+                count_ += walkSteps_;
+            else if (walkSteps_ > minSteps_)
+                ++count_;
+        }
+
+        // While walking updates are held, the last one goes out when
+        // the walk ends.
+        if (!walkSteps_ || t - lastReport_ >= updateInterval_)
+            report(t);
+    }
+}
+
+void StepDetectorFilter::report(quint64 timestamp)
+{
+    if (count_ == reported_)
+        return;
+    TimedUnsigned steps(timestamp, count_);
+    reported_ = count_;
+    lastReport_ = timestamp;
+    source_.propagate(1, &steps);
+}
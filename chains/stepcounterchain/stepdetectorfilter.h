@@ -0,0 +1,90 @@
+/**
+   @file stepdetectorfilter.h
+   @brief StepDetectorFilter
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef STEPDETECTORFILTER_H
+#define STEPDETECTORFILTER_H
+
+#include "filter.h"
+#include "orientationdata.h"
+#include "datatypes/timedunsigned.h"
+
+/**
+ * Software step counter working on a low rate accelerometer stream.
+ *
+ * A step is a peak of the acceleration magnitude more than
+ * \c threshold mG above its running mean, at least
+ * \c min_step_interval ms after the previous one. Steps further apart
+ * than \c max_step_interval ms end a walk. A walk only counts once it
+ * has \c min_steps steps, so single bumps are not taken for steps.
+ *
+ * The cumulative count is propagated when it has changed, at most
+ * every \c update_interval ms while walking and once more when the walk
+ * ends. The count is kept over #reset(). Configuration group is
+ * \c stepcounter.
+ */
+class StepDetectorFilter : public FilterBase
+{
+public:
+    static FilterBase* factoryMethod()
+    {
+        return new StepDetectorFilter;
+    }
+
+    /**
+     * Forget the running mean and the walk in progress.
+     */
+    void reset();
+
+protected:
+    StepDetectorFilter();
+
+private:
+    void interpret(unsigned n, const AccelerationData* data);
+
+    /**
+     * Propagate the count if it has changed.
+     *
+     * @param timestamp time of the latest sample.
+     */
+    void report(quint64 timestamp);
+
+    Sink<StepDetectorFilter, AccelerationData> sink_;
+    Source<TimedUnsigned>                      source_;
+
+    int      threshold_;        /**< peak height over the mean, mG */
+    quint64  minStepInterval_;  /**< microseconds */
+    quint64  maxStepInterval_;  /**< microseconds */
+    unsigned minSteps_;         /**< steps before a walk counts */
+    quint64  updateInterval_;   /**< microseconds between updates */
+
+    bool     hasMean_;          /**< has mean been initialised */
+    int      mean_;             /**< running mean of the magnitude, mG */
+    bool     armed_;            /**< has magnitude been below the mean since last step */
+    quint64  lastStep_;         /**< time of the latest step */
+    unsigned walkSteps_;        /**< steps of the walk in progress */
+    unsigned count_;            /**< cumulative count */
+    unsigned reported_;         /**< count last propagated */
+    quint64  lastReport_;       /**< time of last propagation */
+};
+
+#endif // STEPDETECTORFILTER_H
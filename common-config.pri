@@ -25,10 +25,31 @@ profile {
   QMAKE_LFLAGS += -pg
 }
 
+# Strip test and debug level logging at compile time
+nodebuglog {
+  DEFINES += SENSORD_LOG_MIN_LEVEL=SensordLogWarning
+}
+
+# Filter coefficients in fixed point instead of double
+fixedpoint {
+  DEFINES += SENSORFW_FIXED_POINT
+}
+
 profile-libc {
   QMAKE_LFLAGS += -lc_p
 }
 
+# Link the plugins listed in static-plugins.pri into sensord, with
+# link time optimization across them and the daemon
+static_plugins:equals(QT_MAJOR_VERSION, 5) {
+    include( $$PWD/static-plugins.pri )
+    contains(CONFIG, plugin) {
+        for(entry, SENSORFW_STATIC_PLUGINS) {
+            equals(TARGET, $$section(entry, :, 0, 0)): CONFIG += static ltcg
+        }
+    }
+}
+
 equals(QT_MAJOR_VERSION, 5):{
     TARGET = $$TARGET-qt5
 }
@@ -24,15 +24,28 @@
  */
 
 #include "abstractchain.h"
+#include "chainworker.h"
+#include "config.h"
 
 AbstractChain::AbstractChain(const QString& id, bool deleteBuffers) :
     AbstractSensorChannel(id),
-    deleteBuffers_(deleteBuffers)
+    deleteBuffers_(deleteBuffers),
+    worker_(NULL)
 {
+    Config* config = Config::configuration();
+    if (config && config->value<bool>(id + "/worker_thread", false))
+    {
+        worker_ = new ChainWorker(id);
+        setWorker(worker_);
+        worker_->start();
+    }
 }
 
 AbstractChain::~AbstractChain()
 {
+    // Subclasses have disconnected their readers by now.
+    delete worker_;
+
     if(deleteBuffers_)
     {
         foreach(RingBufferBase* buffer, outputBufferMap_.values())
@@ -32,6 +32,8 @@
 #include "ringbuffer.h"
 #include "abstractsensor.h"
 
+class ChainWorker;
+
 /**
  * AbstractChain is a container for filterchain ending in one or more named buffers.
  * It allows sharing of commmon processing easily, without having to rewrite
@@ -40,6 +42,10 @@
  * Due to the idea that processing should be shared, each chain is a chain
  * from HW to processed data. It is not possible to change inputs, as that
  * would make sharing difficult.
+ *
+ * By default the chain processes data in the thread writing to its
+ * source buffers. With <tt>worker_thread = true</tt> in the group of the
+ * chain ID the chain gets its own thread, see ChainWorker.
  */
 class AbstractChain : public AbstractSensorChannel
 {
@@ -90,6 +96,7 @@ protected:
 private:
     QMap<QString, RingBufferBase*> outputBufferMap_; /**< buffers */
     const bool deleteBuffers_; /**< are buffers deleted automatically */
+    ChainWorker* worker_; /**< processing thread, NULL if not used */
 };
 
 /**
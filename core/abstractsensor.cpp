@@ -33,12 +33,67 @@
 #include "sockethandler.h"
 #include "idutils.h"
 #include "logging.h"
+#include "sampletrace.h"
+#include "sessionframe.h"
+#include "config.h"
+#include <QtAlgorithms>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
 
 AbstractSensorChannel::AbstractSensorChannel(const QString& id) :
     NodeBase(getCleanId(id)),
     errorCode_(SNoError),
-    cnt_(0)
+    cnt_(0),
+    sessionGeneration_(0),
+    historyDuration_(Config::configuration()->value<unsigned int>(id() + "/history_duration", 0)),
+    latestPage_(NULL)
 {
+    if (historyDuration_)
+        history_.setCapacity(Config::configuration()->value<int>(id() + "/history_samples", 256));
+    if (Config::configuration()->value<bool>(id() + "/latest_sample_page", true))
+        createLatestPage();
+}
+
+AbstractSensorChannel::~AbstractSensorChannel()
+{
+    if (latestPage_) {
+        // Clients still mapping the page notice it is no longer updated.
+        __atomic_store_n(&latestPage_->magic, 0, __ATOMIC_RELEASE);
+        munmap(latestPage_, sizeof(LatestSamplePage));
+        shm_unlink((LATEST_SAMPLE_PREFIX + id()).toLocal8Bit().constData());
+    }
+}
+
+void AbstractSensorChannel::createLatestPage()
+{
+    QByteArray name = (LATEST_SAMPLE_PREFIX + id()).toLocal8Bit();
+    // A page left behind by a crashed daemon is reused.
+    int fd = shm_open(name.constData(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        sensordLogW() << "Failed to create latest sample page " << name << ": " << strerror(errno);
+        return;
+    }
+    // shm_open obeys the umask, clients only need to read.
+    fchmod(fd, 0644);
+
+    void* mem = MAP_FAILED;
+    if (ftruncate(fd, sizeof(LatestSamplePage)) == 0)
+        mem = mmap(NULL, sizeof(LatestSamplePage), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        sensordLogW() << "Failed to map latest sample page " << name << ": " << strerror(errno);
+        shm_unlink(name.constData());
+        return;
+    }
+
+    latestPage_ = (LatestSamplePage*)mem;
+    memset(latestPage_, 0, sizeof(LatestSamplePage));
+    latestPage_->magic = LATEST_SAMPLE_MAGIC;
+    latestPage_->version = LATEST_SAMPLE_VERSION;
 }
 
 void AbstractSensorChannel::setError(SensorError errorCode, const QString& errorString)
@@ -52,11 +107,21 @@ void AbstractSensorChannel::setError(SensorError errorCode, const QString& error
 }
 
 bool AbstractSensorChannel::start(int sessionId)
+{
+    return start(sessionId, 0);
+}
+
+bool AbstractSensorChannel::start(int sessionId, unsigned int interval)
 {
     if(!activeSessions_.contains(sessionId))
     {
         activeSessions_.insert(sessionId);
-        requestDefaultInterval(sessionId);
+        if (history_.isEnabled()) {
+            QMutexLocker locker(&deliveryMutex_);
+            historyMarks_.insert(sessionId, history_.recorded());
+        }
+        requestInitialInterval(sessionId, interval);
+        updateSessionRecords();
         return start();
     }
     return false;
@@ -88,154 +153,243 @@ bool AbstractSensorChannel::stop()
 
 bool AbstractSensorChannel::writeToSession(int sessionId, const void* source, int size)
 {
-    if (!(SensorManager::instance().write(sessionId, source, size))) {
-        sensordLogD() << "AbstractSensor failed to write to session " << sessionId;
+    quint64 queued = 0;
+    if (SampleTrace::isEnabled()) {
+        queued = SampleTrace::now();
+        SampleTrace::mark("queued", sessionId, SampleTrace::sampleTime(source, size));
+    }
+    if (!sampleQueue_.push(sessionId, source, size, queued)) {
+        sensordLogD() << "AbstractSensor failed to queue sample for session " << sessionId;
+        queueOverruns_.fetchAndAddRelaxed(1);
+        statistics().addDrops(1);
+        SensorManager::instance().notifySamplesQueued();
         return false;
     }
+    statistics().addInput(1);
+    SensorManager::instance().notifySamplesQueued();
     return true;
 }
 
-bool AbstractSensorChannel::writeToClients(const void* source, int size)
+void AbstractSensorChannel::deliverQueuedSamples()
 {
-    bool ret = true;
-    foreach(int sessionId, activeSessions_) {
-        ret &= writeToSession(sessionId, source, size);
+    SensorManager& sm = SensorManager::instance();
+    int sessionId;
+    const void* data;
+    int size;
+    SessionFrameTrace trace;
+    const SessionFrameTrace* tracePtr = NULL;
+    char packed[SampleQueue::MAX_SAMPLE_SIZE];
+    SessionRecordList records;
+    int generation;
+    // Copy, as the delivery thread may differ from the one rebuilding them.
+    sessionRecords(records, generation);
+    QMutexLocker locker(&deliveryMutex_);
+
+    // The queue is shared by all sessions, so an overrun hits every one of them.
+    int overruns = queueOverruns_.fetchAndStoreRelaxed(0);
+    if (overruns) {
+        sensordLogW() << id() << " sample queue overrun, " << overruns << " samples lost";
+        foreach(const SessionRecord& record, records) {
+            sm.socketHandler().addDropped(record.sessionId, overruns);
+        }
     }
-    return ret;
-}
 
-bool AbstractSensorChannel::downsampleAndPropagate(const TimedXyzData& data, TimedXyzDownsampleBuffer& buffer)
-{
-    bool ret = true;
-    unsigned int currentInterval = getInterval();
-    foreach(int sessionId, activeSessions_)
-    {
-        if(!downsamplingEnabled(sessionId))
-        {
-            ret &= writeToSession(sessionId, (const void *)& data, sizeof(TimedXyzData));
-            continue;
+    unsigned int depth = 0;
+    while (sampleQueue_.peek(sessionId, data, size, &trace.queued)) {
+        ++depth;
+        // Processing time of the channel is the time spent writing to the
+        // sockets. Statistics may be switched on meanwhile, so the state
+        // at the start decides whether this sample is timed.
+        bool timed = NodeStatistics::isEnabled();
+        quint64 start = timed ? NodeStatistics::timestamp() : 0;
+        if (trace.queued) {
+            trace.sampled = SampleTrace::sampleTime(data, size);
+            trace.delivered = SampleTrace::now();
+            SampleTrace::mark("delivered", sessionId, trace.sampled);
+            tracePtr = &trace;
+        } else {
+            tracePtr = NULL;
         }
-        unsigned int sessionInterval = getInterval(sessionId);
-        int bufferSize = (sessionInterval < currentInterval || !currentInterval) ? 1 : sessionInterval / currentInterval;
-
-        QList<TimedXyzData>& samples(buffer[sessionId]);
-        samples.push_back(data);
-
-        for(QList<TimedXyzData>::iterator it = samples.begin(); it != samples.end(); ++it)
-        {
-            if(samples.size() > bufferSize ||
-               data.timestamp_ - it->timestamp_ > 2000000)
-            {
-                it = samples.erase(it);
-                if(it == samples.end())
-                    break;
+        // Sample is packed at most once, for the first session wanting it.
+        int packedSize = -1;
+        const SessionRecord* record = records.constData();
+        if (sessionId == ALL_SESSIONS) {
+            if (history_.isEnabled()) {
+                quint64 timestamp = trace.queued ? trace.sampled : SampleTrace::sampleTime(data, size);
+                history_.record(timestamp ? timestamp : SampleTrace::now(), data, size);
+            }
+            // Sample was queued once for every session not downsampling.
+            for (int i = 0; i < records.size(); ++i) {
+                if (record[i].downsampling)
+                    continue;
+                deliverToSession(record[i], data, size, packed, packedSize, tracePtr);
+            }
+        } else {
+            int i = 0;
+            while (i < records.size() && record[i].sessionId != sessionId)
+                ++i;
+            if (i < records.size()) {
+                deliverToSession(record[i], data, size, packed, packedSize, tracePtr);
+            } else if (!sm.write(sessionId, data, size, tracePtr)) {
+                sensordLogD() << "AbstractSensor failed to write to session " << sessionId;
             }
-            else
-                break;
-        }
-
-        if(samples.size() < bufferSize)
-            continue;
-
-        long x = 0;
-        long y = 0;
-        long z = 0;
-        foreach(const TimedXyzData& data, samples)
-        {
-            x += data.x_;
-            y += data.y_;
-            z += data.z_;
-        }
-        TimedXyzData downsampled(data.timestamp_,
-                                 x / samples.count(),
-                                 y / samples.count(),
-                                 z / samples.count());
-        sensordLogT() << "Downsampled for session " << sessionId << ": " << downsampled.x_ << ", " << downsampled.y_ << ", " << downsampled.z_;
-
-        if (writeToSession(sessionId, (const void*)& downsampled, sizeof(TimedXyzData)))
-        {
-            samples.clear();
-        }
-        else
-        {
-            ret = false;
         }
+        sampleQueue_.pop();
+        statistics().addOutput(1);
+        if (timed)
+            statistics().addProcessingTime(start);
     }
+    if (depth)
+        statistics().addQueueDepth(depth);
+}
+
+/**
+ * Writes history samples of a channel in the delivery thread.
+ */
+class HistoryTask : public SocketHandler::Task
+{
+public:
+    HistoryTask(AbstractSensorChannel* channel, int sessionId, unsigned int duration) :
+        channel(channel), sessionId(sessionId), duration(duration), count(0) {}
+
+    void run() { count = channel->writeHistory(sessionId, duration); }
+
+    AbstractSensorChannel* channel;
+    int                    sessionId;
+    unsigned int           duration;
+    int                    count;
+};
+
+int AbstractSensorChannel::deliverHistory(int sessionId, unsigned int duration)
+{
+    if (!history_.isEnabled() || !duration)
+        return 0;
 
-    return ret;
+    HistoryTask task(this, sessionId, duration);
+    SensorManager::instance().socketHandler().execute(&task);
+    return task.count;
 }
 
-bool AbstractSensorChannel::downsampleAndPropagate(const CalibratedMagneticFieldData& data, MagneticFieldDownsampleBuffer& buffer)
+int AbstractSensorChannel::writeHistory(int sessionId, unsigned int duration)
 {
-    bool ret = true;
-    unsigned int currentInterval = getInterval();
-    foreach(int sessionId, activeSessions_)
-    {
-        if(!downsamplingEnabled(sessionId))
-        {
-            ret &= writeToSession(sessionId, (const void *)& data, sizeof(CalibratedMagneticFieldData));
-            continue;
-        }
-        unsigned int sessionInterval = getInterval(sessionId);
-        int bufferSize = (sessionInterval < currentInterval || !currentInterval) ? 1 : sessionInterval / currentInterval;
-
-        QList<CalibratedMagneticFieldData>& samples(buffer[sessionId]);
-        samples.push_back(data);
-
-        for(QList<CalibratedMagneticFieldData>::iterator it = samples.begin(); it != samples.end(); ++it)
-        {
-            if(samples.size() > bufferSize ||
-               data.timestamp_ - it->timestamp_ > 2000000)
-            {
-                it = samples.erase(it);
-                if(it == samples.end())
-                    break;
-            }
-            else
-                break;
-        }
+    SessionRecordList records;
+    int generation;
+    sessionRecords(records, generation);
+    QMutexLocker locker(&deliveryMutex_);
+    if (!historyMarks_.contains(sessionId))
+        return 0;
+
+    int i = 0;
+    const SessionRecord* record = records.constData();
+    while (i < records.size() && record[i].sessionId != sessionId)
+        ++i;
+    if (i == records.size()) {
+        sensordLogW() << id() << " history requested by inactive session " << sessionId;
+        return 0;
+    }
 
-        if(samples.size() < bufferSize)
-            continue;
-
-        long x = 0;
-        long y = 0;
-        long z = 0;
-        long rx = 0;
-        long ry = 0;
-        long rz = 0;
-        foreach(const CalibratedMagneticFieldData& data, samples)
-        {
-            x += data.x_;
-            y += data.y_;
-            z += data.z_;
-            rx += data.rx_;
-            ry += data.ry_;
-            rz += data.rz_;
-        }
-        CalibratedMagneticFieldData downsampled(data.timestamp_,
-                                                x / samples.count(),
-                                                y / samples.count(),
-                                                z / samples.count(),
-                                                rx / samples.count(),
-                                                ry / samples.count(),
-                                                rz / samples.count(),
-                                                data.level_);
-        sensordLogT() << "Downsampled for session " << sessionId << ": " << downsampled.x_ << ", " << downsampled.y_ << ", " << downsampled.z_ << ", " << downsampled.rx_ << ", " << downsampled.ry_ << ", " << downsampled.rz_;
-
-        if (writeToSession(sessionId, (const void*)& downsampled, sizeof(CalibratedMagneticFieldData)))
-        {
-            samples.clear();
+    quint64 age = (quint64)qMin(duration, historyDuration_) * 1000;
+    quint64 now = SampleTrace::now();
+    int first = history_.find(now > age ? now - age : 0);
+    // Samples recorded after the start have been delivered live already.
+    quint64 oldest = history_.recorded() - history_.size();
+    quint64 mark = historyMarks_.take(sessionId);
+    int end = mark > oldest ? (int)(mark - oldest) : 0;
+
+    // Samples are written within one delivery round, so they leave in
+    // as few frames as the session buffering allows.
+    SocketHandler& socketHandler = SensorManager::instance().socketHandler();
+    socketHandler.beginDelivery();
+    char packed[SampleQueue::MAX_SAMPLE_SIZE];
+    for (int n = first; n < end; ++n) {
+        int size;
+        const void* data = history_.sample(n, size);
+        int packedSize = -1;
+        deliverToSession(record[i], data, size, packed, packedSize, NULL);
+    }
+    socketHandler.flushSessions();
+
+    int count = qMax(end - first, 0);
+    sensordLogD() << id() << " delivered " << count << " history samples to session " << sessionId;
+    return count;
+}
+
+bool AbstractSensorChannel::deliverToSession(const SessionRecord& record, const void* data, int size,
+                                             char* packed, int& packedSize, const SessionFrameTrace* trace)
+{
+    char predicted[SampleQueue::MAX_SAMPLE_SIZE];
+    char predictedPacked[SampleQueue::MAX_SAMPLE_SIZE];
+    int predictedPackedSize = -1;
+    int* sharedPackedSize = &packedSize;
+    if (record.horizon) {
+        int predictedSize = predictSample(data, size, record.horizon, predicted);
+        if (predictedSize > 0) {
+            // Packed copy of the queued sample is shared between
+            // sessions, the predicted one is packed separately.
+            data = predicted;
+            size = predictedSize;
+            packed = predictedPacked;
+            sharedPackedSize = &predictedPackedSize;
         }
+    }
+    if (record.hasPredicate && !predicatePasses(record, data, size))
+        return true;
+    if (record.changeOnly) {
+        QByteArray& last = lastDelivered_[record.sessionId];
+        if (last.size() == size && !sampleChanged(last.constData(), data, size, record.deadband))
+            return true;
+        if (last.size() == size)
+            memcpy(last.data(), data, size);
         else
-        {
-            ret = false;
+            last = QByteArray((const char*)data, size);
+    }
+    if (record.packed) {
+        if (*sharedPackedSize < 0)
+            *sharedPackedSize = packSample(data, size, packed);
+        if (*sharedPackedSize > 0) {
+            data = packed;
+            size = *sharedPackedSize;
         }
+    }
+    if (!SensorManager::instance().write(record.sessionId, data, size, trace)) {
+        sensordLogD() << "AbstractSensor failed to write to session " << record.sessionId;
+        return false;
+    }
+    return true;
+}
 
+bool AbstractSensorChannel::predicatePasses(const SessionRecord& record, const void* data, int size)
+{
+    double axes[3];
+    sampleAxes(data, axes);
+    PredicateState& state = predicateStates_[record.sessionId];
+    bool held = sessionPredicateHolds(record.predicate, sessionPredicateValue(record.predicate, axes), state.held);
+    if (!held) {
+        state.held = false;
+        // The sample ending the condition tells the client about it.
+        bool fired = state.fired;
+        state.fired = false;
+        return fired;
+    }
+
+    quint64 timestamp = SampleTrace::sampleTime(data, size);
+    if (!state.held) {
+        state.held = true;
+        state.since = timestamp;
+    }
+    if (!state.fired && timestamp - state.since >= (quint64)record.predicate.duration * 1000) {
+        sensordLogT() << id() << " predicate of session " << record.sessionId << " fired";
+        state.fired = true;
     }
-    return ret;
+    return state.fired;
 }
 
+bool AbstractSensorChannel::writeToClients(const void* source, int size)
+{
+    if (activeSessions_.isEmpty())
+        return true;
+    return writeToSession(ALL_SESSIONS, source, size);
+}
 
 void AbstractSensorChannel::setDownsamplingEnabled(int sessionId, bool value)
 {
@@ -243,6 +397,7 @@ void AbstractSensorChannel::setDownsamplingEnabled(int sessionId, bool value)
     {
         sensordLogT() << "Downsampling state for session " << sessionId << ": " << value;
         downsampling_[sessionId] = value;
+        updateSessionRecords();
     }
 }
 
@@ -259,10 +414,201 @@ bool AbstractSensorChannel::downsamplingSupported() const
     return false;
 }
 
+bool AbstractSensorChannel::setPackedFormat(int sessionId, bool value)
+{
+    if (value && !packedFormatSupported())
+        return false;
+    sensordLogT() << "Packed format for session " << sessionId << ": " << value;
+    if (value)
+        packedSessions_.insert(sessionId);
+    else
+        packedSessions_.remove(sessionId);
+    updateSessionRecords();
+    return true;
+}
+
+bool AbstractSensorChannel::packedFormat(int sessionId) const
+{
+    return packedSessions_.contains(sessionId);
+}
+
+bool AbstractSensorChannel::packedFormatSupported() const
+{
+    return false;
+}
+
+int AbstractSensorChannel::packSample(const void*, int, void*) const
+{
+    return 0;
+}
+
+void AbstractSensorChannel::setChangeOnly(int sessionId, bool value, unsigned int deadband)
+{
+    sensordLogT() << "Change only delivery for session " << sessionId << ": " << value << ", deadband " << deadband;
+    if (value)
+        changeOnly_[sessionId] = deadband;
+    else
+        changeOnly_.remove(sessionId);
+    {
+        QMutexLocker locker(&deliveryMutex_);
+        lastDelivered_.remove(sessionId);
+    }
+    updateSessionRecords();
+}
+
+bool AbstractSensorChannel::changeOnly(int sessionId) const
+{
+    return changeOnly_.contains(sessionId);
+}
+
+bool AbstractSensorChannel::sampleChanged(const void* previous, const void* current, int size, unsigned int) const
+{
+    int offset = sizeof(TimedData);
+    if (size <= offset)
+        return true;
+    return memcmp((const char*)previous + offset, (const char*)current + offset, size - offset) != 0;
+}
+
+bool AbstractSensorChannel::setPredictionHorizon(int sessionId, unsigned int horizon)
+{
+    if (horizon && !predictionSupported())
+        return false;
+    sensordLogT() << "Prediction horizon for session " << sessionId << ": " << horizon;
+    if (horizon)
+        predictionHorizons_[sessionId] = horizon;
+    else
+        predictionHorizons_.remove(sessionId);
+    updateSessionRecords();
+    return true;
+}
+
+unsigned int AbstractSensorChannel::predictionHorizon(int sessionId) const
+{
+    return predictionHorizons_.value(sessionId, 0);
+}
+
+bool AbstractSensorChannel::setPredicate(int sessionId, const SessionPredicate& predicate)
+{
+    int axes = sessionPredicateAxes(predicate.axis);
+    if (!axes || axes > predicateAxes() ||
+        (predicate.comparison != PREDICATE_ABOVE && predicate.comparison != PREDICATE_BELOW) ||
+        predicate.hysteresis < 0)
+        return false;
+    sensordLogT() << "Predicate for session " << sessionId << ": axis " << predicate.axis
+                  << (predicate.comparison == PREDICATE_ABOVE ? " above " : " below ") << predicate.threshold;
+    predicates_[sessionId] = predicate;
+    {
+        QMutexLocker locker(&deliveryMutex_);
+        predicateStates_.remove(sessionId);
+    }
+    updateSessionRecords();
+    return true;
+}
+
+void AbstractSensorChannel::clearPredicate(int sessionId)
+{
+    if (!predicates_.remove(sessionId))
+        return;
+    {
+        QMutexLocker locker(&deliveryMutex_);
+        predicateStates_.remove(sessionId);
+    }
+    updateSessionRecords();
+}
+
+int AbstractSensorChannel::predicateAxes() const
+{
+    return 0;
+}
+
+void AbstractSensorChannel::sampleAxes(const void*, double*) const
+{
+}
+
+bool AbstractSensorChannel::setPriority(int sessionId, int priority)
+{
+    if (priority < SessionData::RealtimePriority || priority > SessionData::BackgroundPriority)
+        return false;
+    sensordLogT() << "Priority for session " << sessionId << ": " << priority;
+    if (priority == SessionData::InteractivePriority)
+        priorities_.remove(sessionId);
+    else
+        priorities_[sessionId] = priority;
+    SensorManager::instance().socketHandler().setPriority(sessionId, (SessionData::Priority)priority);
+    updateSessionRecords();
+    return true;
+}
+
+bool AbstractSensorChannel::predictionSupported() const
+{
+    return false;
+}
+
+int AbstractSensorChannel::predictSample(const void*, int, unsigned int, void*) const
+{
+    return 0;
+}
+
 void AbstractSensorChannel::removeSession(int sessionId)
 {
     downsampling_.take(sessionId);
+    packedSessions_.remove(sessionId);
+    changeOnly_.remove(sessionId);
+    predictionHorizons_.remove(sessionId);
+    priorities_.remove(sessionId);
+    predicates_.remove(sessionId);
+    {
+        QMutexLocker locker(&deliveryMutex_);
+        lastDelivered_.remove(sessionId);
+        predicateStates_.remove(sessionId);
+        historyMarks_.remove(sessionId);
+    }
     NodeBase::removeSession(sessionId);
+    updateSessionRecords();
+}
+
+void AbstractSensorChannel::sessionIntervalChanged(int sessionId)
+{
+    if (activeSessions_.contains(sessionId))
+        updateSessionRecords();
+}
+
+bool AbstractSensorChannel::higherPriority(const SessionRecord& a, const SessionRecord& b)
+{
+    return a.priority < b.priority;
+}
+
+void AbstractSensorChannel::updateSessionRecords()
+{
+    SessionRecordList records;
+    records.reserve(activeSessions_.size());
+    foreach(int sessionId, activeSessions_)
+    {
+        SessionRecord record;
+        record.sessionId = sessionId;
+        record.interval = getInterval(sessionId);
+        record.downsampling = downsamplingEnabled(sessionId);
+        record.packed = packedSessions_.contains(sessionId);
+        record.changeOnly = changeOnly_.contains(sessionId);
+        record.deadband = changeOnly_.value(sessionId, 0);
+        record.horizon = predictionHorizons_.value(sessionId, 0);
+        record.priority = priorities_.value(sessionId, SessionData::InteractivePriority);
+        record.hasPredicate = predicates_.contains(sessionId);
+        record.predicate = predicates_.value(sessionId);
+        records.append(record);
+    }
+    qStableSort(records.begin(), records.end(), higherPriority);
+
+    QMutexLocker locker(&sessionMutex_);
+    sessionRecords_ = records;
+    ++sessionGeneration_;
+}
+
+void AbstractSensorChannel::sessionRecords(SessionRecordList& records, int& generation) const
+{
+    QMutexLocker locker(&sessionMutex_);
+    records = sessionRecords_;
+    generation = sessionGeneration_;
 }
 
 SensorError AbstractSensorChannel::errorCode() const
@@ -293,7 +639,7 @@ void AbstractSensorChannel::clearError()
 
 void AbstractSensorChannel::signalPropertyChanged(const QString& name)
 {
-    emit propertyChanged(name);
+    notifyPropertyChanged(name);
 }
 
 RingBufferBase* AbstractSensorChannel::findBuffer(const QString&) const
@@ -35,6 +35,10 @@
 #include <QMap>
 #include <QList>
 #include <QSet>
+#include <QHash>
+#include <QByteArray>
+#include <QVector>
+#include <QMutex>
 
 #include "nodebase.h"
 #include "logging.h"
@@ -42,6 +46,14 @@
 #include "datarange.h"
 #include "genericdata.h"
 #include "orientationdata.h"
+#include "samplequeue.h"
+#include "samplehistory.h"
+#include "latestsample.h"
+#include "downsamplewindow.h"
+#include "sessionpredicate.h"
+
+struct SessionFrameTrace;
+struct LatestSamplePage;
 
 /**
  * Base class for sensor type specific nodes. This is used as base class
@@ -61,7 +73,7 @@ public:
     /**
      * Destructor.
      */
-    virtual ~AbstractSensorChannel() {}
+    virtual ~AbstractSensorChannel();
 
     /**
      * Last occured error.
@@ -115,6 +127,111 @@ public:
      */
     virtual bool downsamplingSupported() const;
 
+    /**
+     * Select packed wire format for given session. Takes effect for
+     * samples delivered after the call, so clients should select the
+     * format before starting the session.
+     *
+     * @param sessionId session ID.
+     * @param value use packed format.
+     * @return was the format accepted. Always false if packed format
+     *         is not supported.
+     */
+    bool setPackedFormat(int sessionId, bool value);
+
+    /**
+     * Is packed wire format selected for given session.
+     *
+     * @param sessionId session ID.
+     * @return is packed format selected.
+     */
+    bool packedFormat(int sessionId) const;
+
+    /**
+     * Is packed wire format supported for this object. Subclasses
+     * supporting it also override #packSample().
+     *
+     * @return is packed format supported.
+     */
+    virtual bool packedFormatSupported() const;
+
+    /**
+     * Deliver only changed samples to given session. A sample is
+     * delivered when it differs from the previous one delivered to the
+     * session by more than the deadband, see #sampleChanged(). The first
+     * sample is always delivered.
+     *
+     * @param sessionId session ID.
+     * @param value enable change only delivery.
+     * @param deadband largest change which is not delivered, in the unit
+     *                 of the sensor value.
+     */
+    void setChangeOnly(int sessionId, bool value, unsigned int deadband = 0);
+
+    /**
+     * Is change only delivery enabled for given session.
+     *
+     * @param sessionId session ID.
+     * @return is change only delivery enabled.
+     */
+    bool changeOnly(int sessionId) const;
+
+    /**
+     * Deliver samples to given session extrapolated ahead in time, so
+     * that a client showing them with a known latency gets the value at
+     * the time it is shown instead of running the sensor faster.
+     *
+     * @param sessionId session ID.
+     * @param horizon time to predict ahead in microseconds, 0 disables.
+     * @return was prediction accepted. Always false if prediction is not
+     *         supported.
+     */
+    virtual bool setPredictionHorizon(int sessionId, unsigned int horizon);
+
+    /**
+     * Prediction horizon of given session.
+     *
+     * @param sessionId session ID.
+     * @return horizon in microseconds, 0 when not predicting.
+     */
+    unsigned int predictionHorizon(int sessionId) const;
+
+    /**
+     * Deliver samples to given session only while a condition holds,
+     * see SessionPredicate. Replaces an earlier predicate.
+     *
+     * @param sessionId session ID.
+     * @param predicate condition.
+     * @return was predicate accepted. False if the axis is not known or
+     *         the channel has fewer axes than it needs.
+     */
+    bool setPredicate(int sessionId, const SessionPredicate& predicate);
+
+    /**
+     * Deliver all samples to given session again.
+     *
+     * @param sessionId session ID.
+     */
+    void clearPredicate(int sessionId);
+
+    /**
+     * Set delivery priority class of given session. Sessions are served
+     * in priority order, see SessionData::Priority.
+     *
+     * @param sessionId session ID.
+     * @param priority 0 realtime, 1 interactive (default), 2 background.
+     * @return was priority valid.
+     */
+    bool setPriority(int sessionId, int priority);
+
+    /**
+     * Is prediction supported for this object. Subclasses supporting it
+     * also override #predictSample().
+     *
+     * @return is prediction supported.
+     */
+    virtual bool predictionSupported() const;
+
     virtual void removeSession(int sessionId);
 
     /**
@@ -138,6 +255,17 @@ public:
      */
     bool start(int sessionId);
 
+    /**
+     * Start data flow for given session with a known interval. The
+     * interval is requested instead of the default one, see
+     * NodeBase::requestInitialInterval().
+     *
+     * @param sessionId session ID.
+     * @param interval interval in milliseconds, zero for default.
+     * @return True if sensor was started. False if it is already running.
+     */
+    bool start(int sessionId, unsigned int interval);
+
     /**
      * Stop data flow. Base class implementation is responsible for
      * reference counting. Subclass implementation is responsible of
@@ -158,6 +286,28 @@ public:
      */
     bool stop(int sessionId);
 
+    /**
+     * Write samples queued by #writeToSession() to the sessions. Must be
+     * called from the thread of the SocketHandler, the delivery thread.
+     */
+    void deliverQueuedSamples();
+
+    /**
+     * Write recent samples of the channel to a session. Samples are
+     * recorded only when <tt>&lt;id&gt;/history_duration</tt> is set,
+     * and go through the same packing and change only handling as live
+     * samples. Only samples delivered to other sessions before the
+     * session started are written, so they never overlap with live ones.
+     * The history can be requested once per start. Must be called from
+     * the main thread, samples are written from the delivery thread.
+     *
+     * @param sessionId session ID.
+     * @param duration age of the oldest sample to write, milliseconds.
+     *                 Limited to the configured history duration.
+     * @return number of samples written.
+     */
+    int deliverHistory(int sessionId, unsigned int duration);
+
 Q_SIGNALS:
     /**
      * Signal is emitted for occured errors.
@@ -167,11 +317,26 @@ Q_SIGNALS:
     void errorSignal(int error);
 
 protected:
+    /**
+     * Downsample windows of the sessions, in the same order as the
+     * session records of the channel. Owned by the subclass and only
+     * touched from the thread calling #downsampleAndPropagate().
+     */
+    template <class TYPE>
+    struct DownsampleBuffer
+    {
+        DownsampleBuffer() : generation(-1) {}
+
+        int                              generation; /**< session record generation the windows match */
+        QVector<int>                     sessionIds; /**< session of each window */
+        QVector<DownsampleWindow<TYPE> > windows;    /**< downsample windows */
+    };
+
     /** Sample buffer type for TimedXyzData downsampling. */
-    typedef QMap<int, QList<TimedXyzData> > TimedXyzDownsampleBuffer;
+    typedef DownsampleBuffer<TimedXyzData> TimedXyzDownsampleBuffer;
 
     /** Sample buffer type for CalibratedMagneticFieldData downsampling. */
-    typedef QMap<int, QList<CalibratedMagneticFieldData> > MagneticFieldDownsampleBuffer;
+    typedef DownsampleBuffer<CalibratedMagneticFieldData> MagneticFieldDownsampleBuffer;
 
     /**
      * Constructor.
@@ -194,7 +359,8 @@ protected:
     void clearError();
 
     /**
-     * Write output data to all connected sessions.
+     * Write output data to all connected sessions. The sample is queued
+     * only once and fanned out to the sessions when delivered.
      *
      * @param source Object to write.
      * @param size Size of the object.
@@ -203,25 +369,41 @@ protected:
     bool writeToClients(const void* source, int size);
 
     /**
-     * Downsample and propagate data to all connected sessions.
+     * Downsample and propagate data to all connected sessions. Sessions
+     * with downsampling enabled get one sample per their interval,
+     * combined as described by DownsampleTraits of the type. Other
+     * sessions get the data as is. The data is also stored into the
+     * latest sample page of the channel.
      *
      * @param data Object to handle.
      * @param buffer Data buffer.
+     * @param propagateRaw should data be written to the sessions which
+     *                     are not downsampling.
      * @return was data succesfully handled.
      */
-    bool downsampleAndPropagate(const TimedXyzData& data, TimedXyzDownsampleBuffer& buffer);
+    template <class TYPE>
+    bool downsampleAndPropagate(const TYPE& data, DownsampleBuffer<TYPE>& buffer, bool propagateRaw = true);
 
     /**
-     * Downsample and propagate data to all connected sessions.
+     * Downsample and propagate a batch of objects, see
+     * #downsampleAndPropagate(). Session records are looked up once
+     * and every session is handled for the whole batch in one pass.
      *
-     * @param data Object to handle.
+     * @param data Objects to handle, oldest first.
+     * @param n Number of objects.
      * @param buffer Data buffer.
+     * @param propagateRaw should data be written to the sessions which
+     *                     are not downsampling.
      * @return was data succesfully handled.
      */
-    bool downsampleAndPropagate(const CalibratedMagneticFieldData& data, MagneticFieldDownsampleBuffer& buffer);
+    template <class TYPE>
+    bool downsampleAndPropagate(const TYPE* data, unsigned n, DownsampleBuffer<TYPE>& buffer, bool propagateRaw = true);
+
+    virtual void sessionIntervalChanged(int sessionId);
 
     /**
-     * Signal property change.
+     * Signal property change, coalesced with other changes of the same
+     * event loop iteration.
      *
      * @param name property name.
      */
@@ -229,24 +411,298 @@ protected:
 
     virtual RingBufferBase* findBuffer(const QString& name) const;
 
+    /**
+     * Convert a queued sample to the packed wire format. Called from
+     * the delivery thread when the sample is delivered to sessions which
+     * selected the packed format. Timestamp must stay the first field.
+     *
+     * @param source queued sample.
+     * @param size size of the queued sample.
+     * @param target location for the packed sample, at least
+     *               SampleQueue::MAX_SAMPLE_SIZE bytes.
+     * @return size of the packed sample, or 0 if sample should be
+     *         delivered as is.
+     */
+    virtual int packSample(const void* source, int size, void* target) const;
+
+    /**
+     * Has a sample changed enough to be delivered to a change only
+     * session. Called from the delivery thread. Default implementation
+     * compares everything after the timestamp and ignores the deadband,
+     * channels with padding in their sample type or a meaningful
+     * deadband override this.
+     *
+     * @param previous sample last delivered to the session.
+     * @param current queued sample.
+     * @param size size of the samples.
+     * @param deadband deadband of the session.
+     * @return should sample be delivered.
+     */
+    virtual bool sampleChanged(const void* previous, const void* current, int size, unsigned int deadband) const;
+
+    /**
+     * Extrapolate a queued sample for a predicting session. Called from
+     * the delivery thread before the sample is packed or compared for change
+     * only delivery.
+     *
+     * @param source queued sample.
+     * @param size size of the queued sample.
+     * @param horizon prediction horizon of the session, microseconds.
+     * @param target location for the predicted sample, at least
+     *               SampleQueue::MAX_SAMPLE_SIZE bytes.
+     * @return size of the predicted sample, or 0 if sample should be
+     *         delivered as is.
+     */
+    virtual int predictSample(const void* source, int size, unsigned int horizon, void* target) const;
+
+    /**
+     * Number of axes #sampleAxes() reports. Predicates are supported
+     * by channels with at least one.
+     *
+     * @return number of axes, 0 by default.
+     */
+    virtual int predicateAxes() const;
+
+    /**
+     * Values of a queued sample compared by predicates. Called from the
+     * delivery thread.
+     *
+     * @param source queued sample.
+     * @param axes location for #predicateAxes() values.
+     */
+    virtual void sampleAxes(const void* source, double* axes) const;
+
+    /**
+     * Does any session use prediction.
+     *
+     * @return is prediction used.
+     */
+    bool hasPredictingSessions() const { return !predictionHorizons_.isEmpty(); }
+
+    /**
+     * Sessions which have started the channel.
+     *
+     * @return active session IDs.
+     */
+    const QSet<int>& activeSessions() const { return activeSessions_; }
+
 private:
     /**
-     * Write to given session.
+     * Session ID used for samples queued once for all sessions which
+     * are not downsampling.
+     */
+    static const int ALL_SESSIONS = -1;
+
+    friend class HistoryTask;
+
+    /**
+     * Session state needed for every sample.
+     */
+    struct SessionRecord
+    {
+        int          sessionId;    /**< session ID */
+        unsigned int interval;     /**< interval requested by the session */
+        bool         downsampling; /**< is downsampling enabled */
+        bool         packed;       /**< is packed wire format selected */
+        bool         changeOnly;   /**< is change only delivery enabled */
+        unsigned int deadband;     /**< deadband of change only delivery */
+        unsigned int horizon;      /**< prediction horizon, microseconds */
+        int          priority;     /**< delivery priority class */
+        bool         hasPredicate; /**< is delivery conditional */
+        SessionPredicate predicate; /**< condition of delivery */
+    };
+
+    /**
+     * Predicate state of a session, kept by the delivery thread.
+     */
+    struct PredicateState
+    {
+        PredicateState() : held(false), fired(false), since(0) {}
+
+        bool    held;  /**< did condition hold for the previous sample */
+        bool    fired; /**< has condition held for the duration */
+        quint64 since; /**< when condition started to hold, microseconds */
+    };
+
+    /** Session records in priority order. */
+    typedef QVector<SessionRecord> SessionRecordList;
+
+    /**
+     * Order of session records.
      *
-     * @param sessionId session ID.
+     * @return is a of higher priority class than b.
+     */
+    static bool higherPriority(const SessionRecord& a, const SessionRecord& b);
+
+    /**
+     * Rebuild session records. Called when sessions start or stop or
+     * their interval, downsampling state or wire format changes.
+     */
+    void updateSessionRecords();
+
+    /**
+     * Get current session records. Safe to call from any thread.
+     *
+     * @param records location for the records.
+     * @param generation location for the generation of the records.
+     */
+    void sessionRecords(SessionRecordList& records, int& generation) const;
+
+    /**
+     * Queue data for given session. Data is written to the session
+     * socket later from the delivery thread.
+     *
+     * @param sessionId session ID or #ALL_SESSIONS.
      * @param source source object.
      * @param size size of object to write.
-     * @return was data succesfully written.
+     * @return was data succesfully queued.
      */
     bool writeToSession(int sessionId, const void* source, int size);
 
+    /**
+     * Body of #deliverHistory(), run in the delivery thread.
+     *
+     * @param sessionId session ID.
+     * @param duration age of the oldest sample to write, milliseconds.
+     * @return number of samples written.
+     */
+    int writeHistory(int sessionId, unsigned int duration);
+
+    /**
+     * Write a delivered sample to a session socket, packing it first if
+     * the session selected the packed format.
+     *
+     * @param record session record.
+     * @param data queued sample.
+     * @param size size of the queued sample.
+     * @param packed location for the packed sample.
+     * @param packedSize size of the packed sample, -1 until packed.
+     * @param trace latency trace of the sample, or NULL.
+     * @return was data written.
+     */
+    bool deliverToSession(const SessionRecord& record, const void* data, int size,
+                          char* packed, int& packedSize, const SessionFrameTrace* trace);
+
+    /**
+     * Evaluate predicate of a session for a sample.
+     *
+     * @param record session record with a predicate.
+     * @param data sample.
+     * @param size size of the sample.
+     * @return should sample be delivered.
+     */
+    bool predicatePasses(const SessionRecord& record, const void* data, int size);
+
+    /**
+     * Create the latest sample page of the channel, a POSIX shared
+     * memory object named after the channel which clients map read-only
+     * to get the latest value without a DBus call.
+     */
+    void createLatestPage();
+
     SensorError         errorCode_;       /**< previous occured error code */
     QString             errorString_;     /**< previous occured error description */
     int                 cnt_;             /**< usage reference count */
     QSet<int>           activeSessions_;  /**< active sessions */
     QMap<int, bool>     downsampling_;    /**< downsample state for sessions */
+    QSet<int>           packedSessions_;  /**< sessions using packed wire format */
+    QMap<int, unsigned int> changeOnly_;  /**< deadband of change only sessions */
+    QHash<int, QByteArray> lastDelivered_; /**< last sample of change only sessions */
+    QMap<int, unsigned int> predictionHorizons_; /**< horizon of predicting sessions */
+    QMap<int, int>      priorities_;      /**< priority class of sessions not interactive */
+    QMap<int, SessionPredicate> predicates_; /**< conditions of delivery */
+    QHash<int, PredicateState> predicateStates_; /**< predicate state of sessions */
+    SampleQueue         sampleQueue_;     /**< samples waiting to be written to sessions */
+    QAtomicInt          queueOverruns_;   /**< samples lost because sampleQueue_ was full */
+    SessionRecordList   sessionRecords_;  /**< per-session state, rebuilt on changes */
+    int                 sessionGeneration_; /**< incremented on every rebuild */
+    mutable QMutex      sessionMutex_;    /**< protects sessionRecords_ and sessionGeneration_ */
+    SampleHistory       history_;         /**< recently delivered samples */
+    unsigned int        historyDuration_; /**< age limit of history requests, milliseconds */
+    QMap<int, quint64>  historyMarks_;    /**< history sample count at session start */
+    QMutex              deliveryMutex_;   /**< protects lastDelivered_, predicateStates_, history_ and historyMarks_ */
+    LatestSamplePage*   latestPage_;      /**< latest sample page, or NULL */
 };
 
+template <class TYPE>
+bool AbstractSensorChannel::downsampleAndPropagate(const TYPE& data, DownsampleBuffer<TYPE>& buffer, bool propagateRaw)
+{
+    return downsampleAndPropagate(&data, 1, buffer, propagateRaw);
+}
+
+template <class TYPE>
+bool AbstractSensorChannel::downsampleAndPropagate(const TYPE* data, unsigned n, DownsampleBuffer<TYPE>& buffer, bool propagateRaw)
+{
+    if (!n)
+        return true;
+
+    SessionRecordList records;
+    int generation;
+    sessionRecords(records, generation);
+
+    if (buffer.generation != generation)
+    {
+        // Keep the windows of sessions which are still around.
+        QVector<int> sessionIds(records.size());
+        QVector<DownsampleWindow<TYPE> > windows(records.size());
+        for (int i = 0; i < records.size(); ++i)
+        {
+            sessionIds[i] = records[i].sessionId;
+            int previous = buffer.sessionIds.indexOf(sessionIds[i]);
+            if (previous >= 0)
+                windows[i] = buffer.windows[previous];
+        }
+        buffer.sessionIds = sessionIds;
+        buffer.windows = windows;
+        buffer.generation = generation;
+    }
+
+    if (latestPage_)
+        latestSampleWrite(latestPage_, &data[n - 1], sizeof(TYPE));
+
+    bool ret = true;
+    bool writeRaw = false;
+    unsigned int currentInterval = getInterval();
+    const SessionRecord* record = records.constData();
+    DownsampleWindow<TYPE>* window = buffer.windows.data();
+    for (int i = 0; i < records.size(); ++i)
+    {
+        if (!record[i].downsampling)
+        {
+            writeRaw = true;
+            continue;
+        }
+        unsigned int sessionInterval = record[i].interval;
+        unsigned int bufferSize = (sessionInterval < currentInterval || !currentInterval) ? 1 : sessionInterval / currentInterval;
+
+        window[i].setCapacity(bufferSize);
+        for (unsigned j = 0; j < n; ++j)
+        {
+            window[i].push(data[j]);
+            window[i].dropOlderThan(data[j].timestamp_, 2000000);
+
+            if (!window[i].isFull())
+                continue;
+
+            TYPE downsampled(window[i].result());
+            sensordLogT() << "Downsampled " << window[i].count() << " samples for session " << record[i].sessionId;
+
+            if (writeToSession(record[i].sessionId, (const void*)& downsampled, sizeof(TYPE)))
+                window[i].clear();
+            else
+                ret = false;
+        }
+    }
+
+    if (writeRaw && propagateRaw)
+    {
+        for (unsigned j = 0; j < n; ++j)
+            ret &= writeToSession(ALL_SESSIONS, (const void *)& data[j], sizeof(TYPE));
+    }
+
+    return ret;
+}
+
 /**
  * Factory type for constructing sensor channel.
  */
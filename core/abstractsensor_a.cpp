@@ -28,13 +28,19 @@
 
 #include "abstractsensor_a.h"
 #include "sfwerror.h"
+#include "logging.h"
 #include <sensormanager.h>
 #include <sockethandler.h>
+#include <unistd.h>
 
 AbstractSensorChannelAdaptor::AbstractSensorChannelAdaptor(QObject *parent) :
     QDBusAbstractAdaptor(parent)
 {
     setAutoRelaySignals(false); //disabling signals since no public client API supports the use of these
+    // Clients caching metadata rely on this one, property changes are
+    // relayed in batches instead of one signal per property.
+    connect(parent, SIGNAL(metadataChanged()), this, SIGNAL(metadataChanged()));
+    connect(parent, SIGNAL(propertiesChanged(const QStringList&)), this, SIGNAL(propertiesChanged(const QStringList&)));
 }
 
 bool AbstractSensorChannelAdaptor::isValid() const
@@ -94,6 +100,55 @@ void AbstractSensorChannelAdaptor::start(int sessionId)
     node()->start(sessionId);
 }
 
+bool AbstractSensorChannelAdaptor::openSession(int sessionId, const QVariantMap& config)
+{
+    bool ok = true;
+
+    // Format has to be known before the first sample is written.
+    if (config.contains("packedFormat"))
+        ok = setPackedFormat(sessionId, config.value("packedFormat").toBool()) && ok;
+    if (config.contains("compactFormat"))
+        ok = setCompactFormat(sessionId, config.value("compactFormat").toBool()) && ok;
+    if (config.contains("standbyOverride"))
+        ok = setStandbyOverride(sessionId, config.value("standbyOverride").toBool()) && ok;
+    if (config.contains("downsampling"))
+        setDownsampling(sessionId, config.value("downsampling").toBool());
+    if (config.contains("changeOnly"))
+        setChangeOnly(sessionId, config.value("changeOnly").toBool(), config.value("changeDeadband", 0).toUInt());
+    if (config.contains("predictionHorizon"))
+        ok = setPredictionHorizon(sessionId, config.value("predictionHorizon").toUInt()) && ok;
+    if (config.contains("priority"))
+        ok = setPriority(sessionId, config.value("priority").toInt()) && ok;
+    if (config.contains("predicateAxis"))
+        ok = setPredicate(sessionId, config.value("predicateAxis").toInt(),
+                          config.value("predicateComparison", PREDICATE_ABOVE).toInt(),
+                          config.value("predicateThreshold").toDouble(),
+                          config.value("predicateHysteresis", 0).toDouble(),
+                          config.value("predicateDuration", 0).toUInt()) && ok;
+    if (config.contains("latencyTracing"))
+        setLatencyTracing(sessionId, config.value("latencyTracing").toBool());
+    if (config.contains("bufferSize"))
+        setBufferSize(sessionId, config.value("bufferSize").toUInt());
+    if (config.contains("bufferInterval"))
+        setBufferInterval(sessionId, config.value("bufferInterval").toUInt());
+    if (config.contains("frameClockPeriod"))
+        setFrameClock(sessionId, config.value("frameClockPeriod").toUInt(), config.value("frameClockPhase", 0).toULongLong(),
+                      config.value("frameClockLead", 0).toUInt());
+
+    int interval = config.value("interval", 0).toInt();
+    if (interval < 0) {
+        sensordLogW() << "Invalid interval for session " << sessionId << ": " << interval;
+        interval = 0;
+        ok = false;
+    }
+    node()->start(sessionId, interval);
+    if (interval)
+        SensorManager::instance().socketHandler().setInterval(sessionId, interval);
+    if (config.contains("history"))
+        requestHistory(sessionId, config.value("history").toUInt());
+    return ok;
+}
+
 void AbstractSensorChannelAdaptor::stop(int sessionId)
 {
     node()->stop(sessionId);
@@ -194,9 +249,27 @@ IntegerRangeList AbstractSensorChannelAdaptor::getAvailableBufferSizes() const
     return node()->getAvailableBufferSizes(dummy);
 }
 
+QVariantMap AbstractSensorChannelAdaptor::metadata() const
+{
+    bool hwBuffering = false;
+    IntegerRangeList bufferSizes = node()->getAvailableBufferSizes(hwBuffering);
+    bool dummy;
+
+    QVariantMap map;
+    map.insert("version", node()->metadataVersion());
+    map.insert("description", node()->description());
+    map.insert("type", node()->type());
+    map.insert("hwBuffering", hwBuffering);
+    map.insert("availableDataRanges", qVariantFromValue(node()->getAvailableDataRanges()));
+    map.insert("availableIntervals", qVariantFromValue(node()->getAvailableIntervals()));
+    map.insert("availableBufferIntervals", qVariantFromValue(node()->getAvailableBufferIntervals(dummy)));
+    map.insert("availableBufferSizes", qVariantFromValue(bufferSizes));
+    return map;
+}
+
 AbstractSensorChannel* AbstractSensorChannelAdaptor::node() const
 {
-    return dynamic_cast<AbstractSensorChannel*>(parent());
+    return qobject_cast<AbstractSensorChannel*>(parent());
 }
 
 bool AbstractSensorChannelAdaptor::setDataRangeIndex(int sessionId, int rangeIndex)
@@ -208,3 +281,80 @@ void AbstractSensorChannelAdaptor::setDownsampling(int sessionId, bool value)
 {
     node()->setDownsamplingEnabled(sessionId, value);
 }
+
+bool AbstractSensorChannelAdaptor::setPackedFormat(int sessionId, bool value)
+{
+    return node()->setPackedFormat(sessionId, value);
+}
+
+void AbstractSensorChannelAdaptor::setChangeOnly(int sessionId, bool value, unsigned int deadband)
+{
+    node()->setChangeOnly(sessionId, value, deadband);
+}
+
+bool AbstractSensorChannelAdaptor::setPredicate(int sessionId, int axis, int comparison, double threshold, double hysteresis, unsigned int duration)
+{
+    SessionPredicate predicate;
+    predicate.axis = axis;
+    predicate.comparison = comparison;
+    predicate.threshold = threshold;
+    predicate.hysteresis = hysteresis;
+    predicate.duration = duration;
+    return node()->setPredicate(sessionId, predicate);
+}
+
+void AbstractSensorChannelAdaptor::clearPredicate(int sessionId)
+{
+    node()->clearPredicate(sessionId);
+}
+
+bool AbstractSensorChannelAdaptor::setPredictionHorizon(int sessionId, unsigned int horizon)
+{
+    return node()->setPredictionHorizon(sessionId, horizon);
+}
+
+bool AbstractSensorChannelAdaptor::setPriority(int sessionId, int priority)
+{
+    return node()->setPriority(sessionId, priority);
+}
+
+int AbstractSensorChannelAdaptor::requestHistory(int sessionId, unsigned int duration)
+{
+    return node()->deliverHistory(sessionId, duration);
+}
+
+QDBusUnixFileDescriptor AbstractSensorChannelAdaptor::openDirectChannel(int sessionId, unsigned int interval)
+{
+    int fd = node()->openDirectChannel(sessionId, interval);
+    if (fd == -1)
+        return QDBusUnixFileDescriptor();
+    // Descriptor is duplicated for the reply.
+    QDBusUnixFileDescriptor descriptor(fd);
+    close(fd);
+    return descriptor;
+}
+
+void AbstractSensorChannelAdaptor::closeDirectChannel(int sessionId)
+{
+    node()->closeDirectChannel(sessionId);
+}
+
+void AbstractSensorChannelAdaptor::setLatencyTracing(int sessionId, bool value)
+{
+    SensorManager::instance().socketHandler().setTracing(sessionId, value);
+}
+
+bool AbstractSensorChannelAdaptor::setCompactFormat(int sessionId, bool value)
+{
+    return SensorManager::instance().socketHandler().setCompactFormat(sessionId, value);
+}
+
+void AbstractSensorChannelAdaptor::setFrameClock(int sessionId, unsigned int period, qulonglong phase, unsigned int lead)
+{
+    SensorManager::instance().socketHandler().setFrameClock(sessionId, period, phase, lead);
+}
+
+unsigned int AbstractSensorChannelAdaptor::droppedSamples(int sessionId) const
+{
+    return SensorManager::instance().socketHandler().droppedSamples(sessionId);
+}
@@ -60,6 +60,33 @@ public:
      */
     virtual ~AbstractSensorChannelAdaptor() {}
 
+    /**
+     * Configure and start a session in one go. Everything which does not
+     * affect the sampling rate is applied first, then the session is
+     * started with the requested interval instead of the default one.
+     * When the session is the first one the adaptors are thus started
+     * directly with the final configuration.
+     *
+     * Known keys (all optional): \c interval (int), \c bufferSize (uint),
+     * \c bufferInterval (uint), \c downsampling (bool),
+     * \c standbyOverride (bool), \c packedFormat (bool),
+     * \c compactFormat (bool), \c latencyTracing (bool), \c changeOnly
+     * (bool), \c changeDeadband (uint), \c predictionHorizon (uint),
+     * \c priority (int), \c predicateAxis, \c predicateComparison (int),
+     * \c predicateThreshold, \c predicateHysteresis (double),
+     * \c predicateDuration (uint, see SessionPredicate),
+     * \c frameClockPeriod, \c frameClockPhase and
+     * \c frameClockLead (microseconds, see
+     * SessionData::setFrameClock()) and \c history (uint, milliseconds
+     * of recent samples to write once the session has started). Unknown
+     * keys are ignored.
+     *
+     * @param sessionId session ID.
+     * @param config session configuration.
+     * @return was every setting applied. The session is started anyway.
+     */
+    bool openSession(int sessionId, const QVariantMap& config);
+
 protected:
     /**
      * Constructor.
@@ -136,6 +163,46 @@ public Q_SLOTS: // METHODS
     /** AbstractSensorChannel::setDownsampling(int, bool) */
     void setDownsampling(int sessionId, bool value);
 
+    /** AbstractSensorChannel::setPackedFormat(int, bool) */
+    bool setPackedFormat(int sessionId, bool value);
+
+    /** AbstractSensorChannel::setChangeOnly(int, bool, unsigned int) */
+    void setChangeOnly(int sessionId, bool value, unsigned int deadband);
+
+    /** AbstractSensorChannel::setPredictionHorizon(int, unsigned int) */
+    bool setPredictionHorizon(int sessionId, unsigned int horizon);
+
+    /** AbstractSensorChannel::setPredicate(int, const SessionPredicate&) */
+    bool setPredicate(int sessionId, int axis, int comparison, double threshold, double hysteresis, unsigned int duration);
+
+    /** AbstractSensorChannel::clearPredicate(int) */
+    void clearPredicate(int sessionId);
+
+    /** AbstractSensorChannel::setPriority(int, int) */
+    bool setPriority(int sessionId, int priority);
+
+    /** AbstractSensorChannel::deliverHistory(int, unsigned int) */
+    int requestHistory(int sessionId, unsigned int duration);
+
+    /** NodeBase::openDirectChannel(int, unsigned int)
+     *
+     *  Memory is passed to the client as a file descriptor to map. It is
+     *  invalid if the sensor has no direct channel support.
+     */
+    QDBusUnixFileDescriptor openDirectChannel(int sessionId, unsigned int interval);
+
+    /** NodeBase::closeDirectChannel(int) */
+    void closeDirectChannel(int sessionId);
+
+    /** SocketHandler::setTracing(int, bool) */
+    void setLatencyTracing(int sessionId, bool value);
+
+    /** SocketHandler::setCompactFormat(int, bool) */
+    bool setCompactFormat(int sessionId, bool value);
+
+    /** SocketHandler::setFrameClock(int, unsigned int, quint64, unsigned int) */
+    void setFrameClock(int sessionId, unsigned int period, qulonglong phase, unsigned int lead);
+
     /** AbstractSensorChannel::isValid(int, unsigned int)
      *
      *  Will also configure buffer interval for the data connection.
@@ -172,9 +239,27 @@ public Q_SLOTS: // METHODS
     /** AbstractSensorChannel::hwBuffering() */
     bool hwBuffering() const;
 
+    /** SocketHandler::droppedSamples(int) */
+    unsigned int droppedSamples(int sessionId) const;
+
+    /**
+     * Metadata of the sensor in one call, for clients to cache:
+     * \c version, \c description, \c type, \c hwBuffering,
+     * \c availableDataRanges, \c availableIntervals,
+     * \c availableBufferIntervals and \c availableBufferSizes.
+     * #metadataChanged() is emitted when the version changes.
+     */
+    QVariantMap metadata() const;
+
 Q_SIGNALS:
     /** AbstractSensorChannel::propertyChanged(name) */
     void propertyChanged(const QString& name);
+
+    /** NodeBase::propertiesChanged(names) */
+    void propertiesChanged(const QStringList& names);
+
+    /** NodeBase::metadataChanged() */
+    void metadataChanged();
 };
 
 #endif // ABSTRACTSENSORADAPTOR_H
@@ -27,12 +27,14 @@
  */
 
 #include "bin.h"
+#include "threadedbin.h"
 #include "pusher.h"
 #include "consumer.h"
 #include "filter.h"
 #include "source.h"
 #include "sink.h"
 #include "ringbuffer.h"
+#include "config.h"
 #include "logging.h"
 
 Bin::Bin()
@@ -43,6 +45,18 @@ Bin::~Bin()
 {
 }
 
+Bin* Bin::create(const QString& id)
+{
+    Config* config = Config::configuration();
+    if (config && config->value<bool>(id + "/worker_pool", false) &&
+        !config->value<bool>(id + "/worker_thread", false))
+    {
+        sensordLogD() << "Running " << id << " in the worker pool";
+        return new ThreadedBin;
+    }
+    return new Bin;
+}
+
 void Bin::start()
 {
 }
@@ -148,6 +162,16 @@ bool Bin::unjoin(const QString& producerName,
     return unjoined;
 }
 
+void Bin::freeze()
+{
+    foreach (Pusher* pusher, pushers_) {
+        pusher->freezeSources();
+    }
+    foreach (FilterBase* filter, filters_) {
+        filter->freezeSources();
+    }
+}
+
 SourceBase* Bin::source(const QString& producerName, const QString& sourceName) const
 {
     SourceBase* source = 0;
@@ -195,3 +219,8 @@ Consumer* Bin::consumer(const QString& name) const
 
     return c;
 }
+
+QList<Pusher*> Bin::pushers() const
+{
+    return pushers_.values();
+}
@@ -49,7 +49,7 @@ class RingBuffer;
  * data consumers. Default bin will directly invoke consumers using
  * the current thread without context switches.
  * It is possible to subclass bin for threaded usage where bin instance
- * is run by dedicated thread.
+ * is run by dedicated thread, see ThreadedBin.
  */
 class Bin
 {
@@ -66,6 +66,16 @@ public:
      */
     virtual ~Bin();
 
+    /**
+     * Create bin for given node. With <tt>worker_pool = true</tt> in the
+     * group of the node ID a ThreadedBin is created, unless the node
+     * already has a <tt>worker_thread</tt>.
+     *
+     * @param id node ID.
+     * @return new bin.
+     */
+    static Bin* create(const QString& id);
+
     /**
      * Start bin processing. This should be called after all buffers and
      * readers have been joined.
@@ -129,6 +139,14 @@ public:
                 const QString& consumerName,
                 const QString& sinkName);
 
+    /**
+     * Freeze all dataflow connections of the bin. Call once all joins
+     * are done; after this the connections inside the bin can not be
+     * changed and each source calls its sinks straight from a flat
+     * array in join order.
+     */
+    void freeze();
+
 protected:
     /**
      * Pointer to the producer data source.
@@ -164,6 +182,13 @@ protected:
      */
     Consumer*   consumer(const QString& name) const;
 
+    /**
+     * Pushers added to the bin.
+     *
+     * @return pushers.
+     */
+    QList<Pusher*> pushers() const;
+
 private:
     QHash<QString, Pusher*>     pushers_;   /**< Pushers   */
     QHash<QString, Consumer*>   consumers_; /**< Consumers */
@@ -48,8 +48,7 @@ public:
      * @param chunkSize how many objects reader can process with single call
      */
     BufferReader(unsigned chunkSize) :
-        chunkSize_(chunkSize),
-        chunk_(new TYPE[chunkSize])
+        chunkSize_(chunkSize)
     {
         addSource(&source_, "source");
     }
@@ -59,7 +58,16 @@ public:
      */
     virtual ~BufferReader()
     {
-        delete[] chunk_;
+    }
+
+    /**
+     * Reader has demand when its source has.
+     *
+     * @return is read data used.
+     */
+    bool hasDemand() const
+    {
+        return source_.hasDemand();
     }
 
     /**
@@ -67,16 +75,22 @@ public:
      */
     void pushNewData()
     {
+        // Sinks get spans of the ring storage itself, no copy is made.
+        const TYPE* first;
+        const TYPE* second;
+        unsigned firstCount;
         unsigned n;
-        while ((n = RingBufferReader<TYPE>::read(chunkSize_, chunk_))) {
-            source_.propagate(n, chunk_);
+        while ((n = RingBufferReader<TYPE>::peek(chunkSize_, first, firstCount, second))) {
+            source_.propagate(firstCount, first);
+            if (n > firstCount)
+                source_.propagate(n - firstCount, second);
+            RingBufferReader<TYPE>::commitRead(n);
         }
     }
 
 private:
     Source<TYPE> source_;    /**< Source */
-    unsigned     chunkSize_; /**< How many objects can be buffered */
-    TYPE*        chunk_;     /**< Data storage */
+    unsigned     chunkSize_; /**< How many objects are propagated at most with single call */
 };
 
 #endif
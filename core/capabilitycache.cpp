@@ -0,0 +1,151 @@
+/**
+   @file capabilitycache.cpp
+   @brief CapabilityCache
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "capabilitycache.h"
+#include "config.h"
+#include "logging.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDataStream>
+#include <QMutexLocker>
+#include <sys/utsname.h>
+#include <stdio.h>
+
+static const quint32 CACHE_MAGIC = 0x53465743; // "SFWC"
+static const quint32 CACHE_FORMAT = 1;
+
+CapabilityCache& CapabilityCache::instance()
+{
+    static CapabilityCache cache;
+    return cache;
+}
+
+CapabilityCache::CapabilityCache()
+{
+    path_ = Config::configuration()->value<QString>("global/capability_cache", "");
+    if (isEnabled())
+        load();
+}
+
+QVariant CapabilityCache::value(const QString& section, const QByteArray& validator, const QString& key)
+{
+    QMutexLocker locker(&mutex_);
+    QMap<QString, Section>::const_iterator it = sections_.constFind(section);
+    if (it == sections_.constEnd() || it.value().validator != validator)
+        return QVariant();
+    return it.value().values.value(key);
+}
+
+void CapabilityCache::setValue(const QString& section, const QByteArray& validator, const QString& key, const QVariant& value)
+{
+    if (!isEnabled())
+        return;
+
+    QMutexLocker locker(&mutex_);
+    Section& stored = sections_[section];
+    if (stored.validator != validator) {
+        stored.validator = validator;
+        stored.values.clear();
+    } else if (stored.values.value(key) == value) {
+        return;
+    }
+    stored.values.insert(key, value);
+    save();
+}
+
+QByteArray CapabilityCache::kernelVersion()
+{
+    struct utsname name;
+    if (uname(&name) != 0)
+        return QByteArray();
+    return QByteArray(name.release) + ' ' + name.version;
+}
+
+QByteArray CapabilityCache::fileStamp(const QStringList& paths)
+{
+    QByteArray stamp = kernelVersion();
+    foreach (const QString& path, paths) {
+        QFileInfo info(path);
+        stamp += '\n' + QFile::encodeName(path);
+        if (info.exists())
+            stamp += ' ' + QByteArray::number(info.size()) + ' ' + QByteArray::number((qint64)info.lastModified().toTime_t());
+    }
+    return stamp;
+}
+
+void CapabilityCache::load()
+{
+    QFile file(path_);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_4_6);
+    quint32 magic, format;
+    in >> magic >> format;
+    if (magic != CACHE_MAGIC || format != CACHE_FORMAT) {
+        sensordLogW() << "Ignoring capability cache " << path_ << " of unknown format";
+        return;
+    }
+
+    QMap<QString, Section> sections;
+    quint32 count;
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString name;
+        Section section;
+        in >> name >> section.validator >> section.values;
+        sections.insert(name, section);
+    }
+    if (in.status() != QDataStream::Ok) {
+        sensordLogW() << "Ignoring truncated capability cache " << path_;
+        return;
+    }
+    sections_ = sections;
+    sensordLogD() << "Read " << sections_.size() << " sections from capability cache " << path_;
+}
+
+void CapabilityCache::save()
+{
+    QString tmpPath = path_ + ".new";
+    QDir().mkpath(QFileInfo(path_).absolutePath());
+    QFile file(tmpPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        sensordLogW() << "Cannot write capability cache " << tmpPath << ": " << file.errorString();
+        return;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << CACHE_MAGIC << CACHE_FORMAT << (quint32)sections_.size();
+    for (QMap<QString, Section>::const_iterator it = sections_.constBegin(); it != sections_.constEnd(); ++it)
+        out << it.key() << it.value().validator << it.value().values;
+    file.close();
+
+    if (out.status() != QDataStream::Ok || file.error() != QFile::NoError ||
+        rename(QFile::encodeName(tmpPath).constData(), QFile::encodeName(path_).constData()) != 0) {
+        sensordLogW() << "Cannot write capability cache " << path_;
+        QFile::remove(tmpPath);
+    }
+}
@@ -0,0 +1,134 @@
+/**
+   @file capabilitycache.h
+   @brief CapabilityCache
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef CAPABILITYCACHE_H
+#define CAPABILITYCACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVariant>
+#include <QMap>
+#include <QMutex>
+
+/**
+ * Hardware capabilities probed on an earlier boot. Adaptors store what
+ * they discover, like HAL sensor lists, device files and ranges, and on
+ * the next start use the stored values instead of probing again, so
+ * sensors are registered and metadata answered before the hardware has
+ * been initialized.
+ *
+ * Values are grouped into sections. Each section has a validator, for
+ * example the kernel version, and values are only returned while the
+ * validator matches. Storing with another validator drops the section.
+ *
+ * The cache lives in the small binary file
+ * <tt>global/capability_cache</tt>. The cache is disabled when the path
+ * is empty.
+ */
+class CapabilityCache
+{
+public:
+    /**
+     * Get the cache. The file is read on first use.
+     *
+     * @return cache instance.
+     */
+    static CapabilityCache& instance();
+
+    /**
+     * Is the cache in use.
+     *
+     * @return is a cache file configured.
+     */
+    bool isEnabled() const { return !path_.isEmpty(); }
+
+    /**
+     * Get a cached value.
+     *
+     * @param section section of the value.
+     * @param validator validator the section must have been stored with.
+     * @param key key of the value.
+     * @return value, or invalid QVariant if not cached or the section
+     *         is stale.
+     */
+    QVariant value(const QString& section, const QByteArray& validator, const QString& key);
+
+    /**
+     * Store a value. The file is rewritten when the value changes.
+     *
+     * @param section section of the value.
+     * @param validator validator of the section. Values stored with
+     *                  another validator are dropped.
+     * @param key key of the value.
+     * @param value value to store.
+     */
+    void setValue(const QString& section, const QByteArray& validator, const QString& key, const QVariant& value);
+
+    /**
+     * Validator for values depending on the running kernel.
+     *
+     * @return kernel release and version.
+     */
+    static QByteArray kernelVersion();
+
+    /**
+     * Validator for values depending on given files, for example
+     * the build properties of a HAL. Combines the kernel version with
+     * the size and modification time of each file.
+     *
+     * @param paths files to stamp. Missing files are stamped as such.
+     * @return validator.
+     */
+    static QByteArray fileStamp(const QStringList& paths);
+
+private:
+    CapabilityCache();
+    Q_DISABLE_COPY(CapabilityCache)
+
+    /**
+     * Values of a section and the validator they were stored with.
+     */
+    struct Section
+    {
+        QByteArray  validator; /**< validator of the values */
+        QVariantMap values;    /**< values by key */
+    };
+
+    /**
+     * Read the cache file. Unreadable or foreign files leave the cache
+     * empty.
+     */
+    void load();
+
+    /**
+     * Write the cache file. The file is replaced atomically.
+     */
+    void save();
+
+    QMutex                  mutex_;    /**< protects sections_ */
+    QString                 path_;     /**< cache file, empty if disabled */
+    QMap<QString, Section>  sections_; /**< sections by name */
+};
+
+#endif // CAPABILITYCACHE_H
@@ -0,0 +1,95 @@
+/**
+   @file chainworker.cpp
+   @brief ChainWorker
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "chainworker.h"
+#include "pusher.h"
+#include "logging.h"
+#include "threadscheduling.h"
+
+ChainWorker::ChainWorker(const QString& name) :
+    name_(name),
+    running_(1)
+{
+}
+
+ChainWorker::~ChainWorker()
+{
+    stop();
+    qDeleteAll(readers_);
+}
+
+void ChainWorker::attach(Pusher* reader)
+{
+    QMutexLocker locker(&mutex_);
+    Wakeup* wakeup = new Wakeup(this, reader);
+    readers_.append(wakeup);
+    reader->setReadyCallback(wakeup);
+}
+
+void ChainWorker::detach(Pusher* reader)
+{
+    QMutexLocker locker(&mutex_);
+    for (int i = 0; i < readers_.size(); ++i)
+    {
+        if (readers_.at(i)->reader_ == reader)
+        {
+            reader->resetReadyCallback();
+            delete readers_.takeAt(i);
+            return;
+        }
+    }
+}
+
+void ChainWorker::stop()
+{
+    if (!isRunning())
+        return;
+    running_.fetchAndStoreOrdered(0);
+    wakeups_.release();
+    wait();
+}
+
+void ChainWorker::Wakeup::operator()() const
+{
+    // One pending wakeup covers all data written before it is handled.
+    if (pending_.testAndSetOrdered(0, 1))
+        worker_->wakeups_.release();
+}
+
+void ChainWorker::run()
+{
+    ThreadScheduling::apply(name_);
+    sensordLogD() << "Worker thread of " << name_ << " started";
+
+    while (running_.loadAcquire())
+    {
+        wakeups_.acquire();
+        QMutexLocker locker(&mutex_);
+        foreach (Wakeup* wakeup, readers_)
+        {
+            if (wakeup->pending_.fetchAndStoreOrdered(0))
+                wakeup->reader_->pushNewData();
+        }
+    }
+    sensordLogD() << "Worker thread of " << name_ << " stopped";
+}
@@ -0,0 +1,114 @@
+/**
+   @file chainworker.h
+   @brief ChainWorker
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef CHAINWORKER_H
+#define CHAINWORKER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QSemaphore>
+#include <QAtomicInt>
+#include <QList>
+#include "callback.h"
+
+class Pusher;
+
+/**
+ * Thread processing the buffer readers of a chain. Readers attached to
+ * the worker are not run by the thread writing to their buffer; the
+ * writer only marks the reader pending and wakes the worker, so slow
+ * filters do not delay the adaptor reading the hardware.
+ *
+ * Worker is enabled per chain with <tt>[chain] worker_thread = true</tt>.
+ * Scheduling of the thread is configured in the same group, see
+ * ThreadScheduling.
+ */
+class ChainWorker : public QThread
+{
+public:
+    /**
+     * Constructor.
+     *
+     * @param name configuration group of the thread, also used in log
+     *             messages.
+     */
+    ChainWorker(const QString& name);
+
+    /**
+     * Destructor. Stops the thread.
+     */
+    ~ChainWorker();
+
+    /**
+     * Run reader in this worker. Must be called before the reader is
+     * joined to a buffer.
+     *
+     * @param reader buffer reader.
+     */
+    void attach(Pusher* reader);
+
+    /**
+     * Stop running reader in this worker. Must be called after the
+     * reader has been unjoined from its buffer. When this returns the
+     * worker does not touch the reader any more.
+     *
+     * @param reader buffer reader.
+     */
+    void detach(Pusher* reader);
+
+    /**
+     * Stop the thread and wait for it to finish.
+     */
+    void stop();
+
+protected:
+    /**
+     * Thread main loop.
+     */
+    void run();
+
+private:
+    /**
+     * Wakeup callback given to an attached reader.
+     */
+    class Wakeup : public CallbackBase
+    {
+    public:
+        Wakeup(ChainWorker* worker, Pusher* reader) :
+            worker_(worker), reader_(reader), pending_(0) {}
+
+        void operator()() const;
+
+        ChainWorker*       worker_;  /**< owning worker */
+        Pusher*            reader_;  /**< reader to run */
+        mutable QAtomicInt pending_; /**< has reader been woken up */
+    };
+
+    QString          name_;     /**< configuration group and name for logging */
+    QList<Wakeup*>   readers_;  /**< attached readers */
+    QMutex           mutex_;    /**< protects readers_ and processing */
+    QSemaphore       wakeups_;  /**< released for each wakeup */
+    QAtomicInt       running_;  /**< should thread keep running */
+};
+
+#endif // CHAINWORKER_H
@@ -32,9 +32,18 @@
 #include <QFile>
 #include <QDir>
 #include <QList>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+#include <QCryptographicHash>
+#include <stdio.h>
 
 static Config *static_configuration = 0;
 
+/** Magic number and format version of the compiled configuration. */
+static const quint32 CACHE_MAGIC = 0x53464343;
+static const quint32 CACHE_VERSION = 1;
+
 Config::Config() {
 }
 
@@ -43,12 +52,12 @@ Config::~Config() {
 }
 
 void Config::clearConfig() {
-    foreach(QSettings* setting, settings)
-        delete setting;
-    settings.clear();
+    QMutexLocker locker(&mutex_);
+    values_.clear();
+    groups_.clear();
 }
 
-bool Config::loadConfig(const QString &defConfigPath, const QString &configDPath) {
+bool Config::loadConfig(const QString &defConfigPath, const QString &configDPath, const QString &cachePath) {
     Config *config = NULL;
     bool ret = true;
 
@@ -59,75 +68,230 @@ bool Config::loadConfig(const QString &defConfigPath, const QString &configDPath
         config = new Config();
     }
 
-    if (!config->loadConfigFile(defConfigPath))
-        ret = false;
+    {
+        QMutexLocker locker(&config->mutex_);
+        if (cachePath.isEmpty()) {
+            ret = loadConfigPaths(defConfigPath, configDPath, config->values_, config->groups_);
+        } else {
+            QByteArray stamp = stampFiles(configFiles(defConfigPath, configDPath));
+            if (!readCache(cachePath, stamp, config->values_, config->groups_)) {
+                QHash<QString, QVariant> values;
+                QStringList groups;
+                ret = loadConfigPaths(defConfigPath, configDPath, values, groups);
+                if (ret)
+                    writeCache(cachePath, stamp, values, groups);
+                merge(values, groups, config->values_, config->groups_);
+            }
+        }
+        config->paths_.append(qMakePair(defConfigPath, configDPath));
+        config->cachePaths_.append(cachePath);
+    }
+
+    static_configuration = config;
+
+    return ret;
+}
+
+bool Config::reload(QStringList* changedKeys) {
+    QHash<QString, QVariant> values;
+    QStringList groups;
+    bool ret = true;
+
+    for (int i = 0; i < paths_.size(); ++i) {
+        const QPair<QString, QString>& paths = paths_.at(i);
+        QHash<QString, QVariant> fileValues;
+        QStringList fileGroups;
+        QByteArray stamp = stampFiles(configFiles(paths.first, paths.second));
+        if (!loadConfigPaths(paths.first, paths.second, fileValues, fileGroups)) {
+            ret = false;
+        } else if (!cachePaths_.at(i).isEmpty()) {
+            // Keep the cache in step with the edited files.
+            writeCache(cachePaths_.at(i), stamp, fileValues, fileGroups);
+        }
+        merge(fileValues, fileGroups, values, groups);
+    }
+
+    QMutexLocker locker(&mutex_);
+    if (changedKeys) {
+        changedKeys->clear();
+        for (QHash<QString, QVariant>::const_iterator it = values.begin(); it != values.end(); ++it) {
+            if (!values_.contains(it.key()) || values_.value(it.key()) != it.value())
+                changedKeys->append(it.key());
+        }
+        for (QHash<QString, QVariant>::const_iterator it = values_.begin(); it != values_.end(); ++it) {
+            if (!values.contains(it.key()))
+                changedKeys->append(it.key());
+        }
+    }
+    values_ = values;
+    groups_ = groups;
+    return ret;
+}
+
+bool Config::compileConfig(const QString &defConfigPath, const QString &configDPath, const QString &cachePath) {
+    QHash<QString, QVariant> values;
+    QStringList groups;
+    QByteArray stamp = stampFiles(configFiles(defConfigPath, configDPath));
+    if (!loadConfigPaths(defConfigPath, configDPath, values, groups))
+        return false;
+    return writeCache(cachePath, stamp, values, groups);
+}
+
+QStringList Config::configFiles(const QString &defConfigPath, const QString &configDPath) {
+    QStringList files;
+    files << defConfigPath;
 
     /* Scan config.d dir */
-    QStringList fileList;
     if(!configDPath.isEmpty())
     {
         QDir dir(configDPath, "*.conf", QDir::Name, QDir::Files);
-        fileList = dir.entryList();
-        foreach(const QString& file, fileList)
-        {
-            if (!config->loadConfigFile(dir.absoluteFilePath(file)))
-                ret = false;
-        }
+        foreach(const QString& file, dir.entryList())
+            files << dir.absoluteFilePath(file);
     }
+    return files;
+}
 
-    static_configuration = config;
+QByteArray Config::stampFiles(const QStringList &files) {
+    QByteArray stamp;
+    QDataStream stream(&stamp, QIODevice::WriteOnly);
+    foreach (const QString& file, files) {
+        // Symbolic links like primaryuse.conf are followed, so pointing
+        // one at another profile invalidates the cache too.
+        QFileInfo info(file);
+        stream << file << info.canonicalFilePath() << info.size() << info.lastModified().toMSecsSinceEpoch();
+    }
+    return QCryptographicHash::hash(stamp, QCryptographicHash::Sha1);
+}
+
+bool Config::readCache(const QString &cachePath, const QByteArray &stamp, QHash<QString, QVariant>& values, QStringList& groups) {
+    QFile file(cachePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    uchar* data = file.map(0, file.size());
+    if (!data) {
+        sensordLogW() << "Unable to map configuration cache \"" << cachePath << "\"";
+        return false;
+    }
+
+    QByteArray bytes(QByteArray::fromRawData(reinterpret_cast<const char*>(data), file.size()));
+    QDataStream stream(bytes);
+    stream.setVersion(QDataStream::Qt_4_8);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QByteArray cachedStamp;
+    stream >> magic >> version >> cachedStamp;
+    if (magic != CACHE_MAGIC || version != CACHE_VERSION || cachedStamp != stamp) {
+        sensordLogD() << "Configuration cache \"" << cachePath << "\" is out of date";
+        file.unmap(data);
+        return false;
+    }
+
+    QHash<QString, QVariant> cachedValues;
+    QStringList cachedGroups;
+    stream >> cachedValues >> cachedGroups;
+    bool ok = stream.status() == QDataStream::Ok;
+    file.unmap(data);
+    if (!ok) {
+        sensordLogW() << "Configuration cache \"" << cachePath << "\" is corrupt";
+        return false;
+    }
+
+    merge(cachedValues, cachedGroups, values, groups);
+    sensordLogD() << "Configuration loaded from cache \"" << cachePath << "\"";
+    return true;
+}
+
+bool Config::writeCache(const QString &cachePath, const QByteArray &stamp, const QHash<QString, QVariant>& values, const QStringList& groups) {
+    QString tmpPath = cachePath + ".new";
+    QFile file(tmpPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        sensordLogD() << "Unable to write configuration cache \"" << cachePath << "\"";
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_8);
+    stream << CACHE_MAGIC << CACHE_VERSION << stamp << values << groups;
+    file.close();
+    if (stream.status() != QDataStream::Ok || file.error() != QFile::NoError ||
+        ::rename(QFile::encodeName(tmpPath).constData(), QFile::encodeName(cachePath).constData()) != 0) {
+        sensordLogW() << "Writing configuration cache \"" << cachePath << "\" failed";
+        QFile::remove(tmpPath);
+        return false;
+    }
+    sensordLogD() << "Configuration compiled to \"" << cachePath << "\"";
+    return true;
+}
+
+void Config::merge(const QHash<QString, QVariant>& fromValues, const QStringList& fromGroups, QHash<QString, QVariant>& values, QStringList& groups) {
+    /* Values already in the table have preference. */
+    for (QHash<QString, QVariant>::const_iterator it = fromValues.begin(); it != fromValues.end(); ++it) {
+        if (!values.contains(it.key()))
+            values.insert(it.key(), it.value());
+    }
+    foreach (const QString& group, fromGroups) {
+        if (!groups.contains(group))
+            groups << group;
+    }
+}
 
+bool Config::loadConfigPaths(const QString &defConfigPath, const QString &configDPath, QHash<QString, QVariant>& values, QStringList& groups) {
+    bool ret = true;
+
+    foreach(const QString& file, configFiles(defConfigPath, configDPath))
+    {
+        if (!loadConfigFile(file, values, groups))
+            ret = false;
+    }
     return ret;
 }
 
-bool Config::loadConfigFile(const QString &configFileName) {
+bool Config::loadConfigFile(const QString &configFileName, QHash<QString, QVariant>& values, QStringList& groups) {
     if(!QFile::exists(configFileName))
     {
         sensordLogW() << "File does not exists \"" << configFileName <<  "\"";
         return false;
     }
-    QSettings* setting = new QSettings(configFileName, QSettings::IniFormat);
-    if(setting->status() == QSettings::NoError) {
-        settings.append(setting);
+    QSettings setting(configFileName, QSettings::IniFormat);
+    if(setting.status() == QSettings::NoError) {
+        /* Keys in the first files have preference over the last. */
+        foreach(const QString& key, setting.allKeys()) {
+            if(!values.contains(key))
+                values.insert(key, setting.value(key));
+        }
+        foreach(const QString& group, setting.childGroups()) {
+            if(!groups.contains(group))
+                groups << group;
+        }
         sensordLogD() << "Config file \"" << configFileName << "\" successfully loaded";
         return true;
     }
-    else if(setting->status() == QSettings::AccessError)
+    else if(setting.status() == QSettings::AccessError)
         sensordLogW() << "Unable to open \"" << configFileName <<  "\" configuration file";
-    else if(setting->status() == QSettings::FormatError)
+    else if(setting.status() == QSettings::FormatError)
         sensordLogW() << "Configuration file \"" << configFileName <<  "\" is in wrong format";
     else
-        sensordLogW() << "Configuration file \"" << configFileName <<  "\" parsing failed to unknown error: " << setting->status();
-    delete setting;
+        sensordLogW() << "Configuration file \"" << configFileName <<  "\" parsing failed to unknown error: " << setting.status();
     return false;
 }
 
 QVariant Config::value(const QString &key) const {
-    /* Iterate through configs so that keys in the first files
-     * have preference over the last.
-     */
-    foreach(QSettings* setting, settings) {
-        if(setting->contains(key))
-        {
-            QVariant var = setting->value(key, QVariant());
-            if(var.isValid())
-                sensordLogD() << "Value for key '" << key << "': " << var.toString();
-            return var;
-        }
+    QVariant var;
+    {
+        QMutexLocker locker(&mutex_);
+        QHash<QString, QVariant>::const_iterator it = values_.find(key);
+        if(it == values_.end())
+            return QVariant();
+        var = it.value();
     }
-    return QVariant();
+    if(var.isValid())
+        sensordLogD() << "Value for key '" << key << "': " << var.toString();
+    return var;
 }
 
 QStringList Config::groups() const
 {
-    QStringList groups;
-    foreach(QSettings* setting, settings) {
-        foreach(const QString& group, setting->childGroups()) {
-            if(!groups.contains(group))
-                groups << group;
-        }
-    }
-    return groups;
+    QMutexLocker locker(&mutex_);
+    return groups_;
 }
 
 Config *Config::configuration() {
@@ -30,13 +30,20 @@
 
 #include <QString>
 #include <QVariant>
-#include <QSettings>
-#include <QList>
+#include <QHash>
+#include <QStringList>
+#include <QPair>
+#include <QMutex>
 
 /**
  * Sensord configuration parser. Configuration is read and parsed with
  * the QSettings class. Config is a singleton instance to which configuration
- * is loaded once during startup.
+ * is loaded once during startup. Values of all files are merged into one
+ * table when the files are loaded, so lookups do not touch the files.
+ *
+ * The merged table can be compiled to a binary cache, which is memory
+ * mapped and read back on the next start as long as none of the files
+ * it was made from has changed. That skips parsing the device profiles.
  */
 class Config
 {
@@ -94,8 +101,34 @@ public:
      *
      * @param defConfigPath Path to the config file.
      * @param configDPath Path to the directory with config files.
+     * @param cachePath Path of the compiled configuration. If the cache
+     *                  is up to date with the files it is used instead
+     *                  of them, otherwise it is written after loading.
+     *                  Empty for no cache.
      */
-    static bool loadConfig(const QString &defConfigPath, const QString &configDPath);
+    static bool loadConfig(const QString &defConfigPath, const QString &configDPath, const QString &cachePath = QString());
+
+    /**
+     * Load all configuration files again from the paths given to
+     * #loadConfig() and replace the configuration with their values.
+     * Safe against lookups from other threads.
+     *
+     * @param changedKeys if not NULL, keys which were added, removed or
+     *                    changed are written here.
+     * @return were all files loaded successfully.
+     */
+    bool reload(QStringList* changedKeys = 0);
+
+    /**
+     * Parse configuration files and compile them to a cache read by
+     * #loadConfig().
+     *
+     * @param defConfigPath Path to the config file.
+     * @param configDPath Path to the directory with config files.
+     * @param cachePath Path to write the compiled configuration to.
+     * @return were the files loaded and the cache written.
+     */
+    static bool compileConfig(const QString &defConfigPath, const QString &configDPath, const QString &cachePath);
 
     /**
      * Close singleton instance.
@@ -127,16 +160,84 @@ private:
      * Load configuration file from given path.
      *
      * @param configFileName Configuration file path.
+     * @param values table to merge the values to.
+     * @param groups list to merge the groups to.
      * @return was configuration loaded successfully.
      */
-    bool loadConfigFile(const QString &configFileName);
+    static bool loadConfigFile(const QString &configFileName, QHash<QString, QVariant>& values, QStringList& groups);
+
+    /**
+     * Load configuration file and configuration directory.
+     *
+     * @param defConfigPath Path to the config file.
+     * @param configDPath Path to the directory with config files.
+     * @param values table to merge the values to.
+     * @param groups list to merge the groups to.
+     * @return were all files loaded successfully.
+     */
+    static bool loadConfigPaths(const QString &defConfigPath, const QString &configDPath, QHash<QString, QVariant>& values, QStringList& groups);
+
+    /**
+     * Files loaded from given paths, in load order.
+     *
+     * @param defConfigPath Path to the config file.
+     * @param configDPath Path to the directory with config files.
+     * @return file paths.
+     */
+    static QStringList configFiles(const QString &defConfigPath, const QString &configDPath);
+
+    /**
+     * Identify the contents of configuration files by path, size and
+     * modification time.
+     *
+     * @param files file paths.
+     * @return stamp of the files.
+     */
+    static QByteArray stampFiles(const QStringList &files);
+
+    /**
+     * Read compiled configuration if it is up to date with the files.
+     *
+     * @param cachePath Path of the compiled configuration.
+     * @param stamp Expected stamp of the files.
+     * @param values table to merge the values to.
+     * @param groups list to merge the groups to.
+     * @return was the cache used.
+     */
+    static bool readCache(const QString &cachePath, const QByteArray &stamp, QHash<QString, QVariant>& values, QStringList& groups);
+
+    /**
+     * Write compiled configuration. The file is replaced atomically, so
+     * a concurrent reader sees either the old or the new cache.
+     *
+     * @param cachePath Path of the compiled configuration.
+     * @param stamp Stamp of the files the values come from.
+     * @param values values to write.
+     * @param groups groups to write.
+     * @return was the cache written.
+     */
+    static bool writeCache(const QString &cachePath, const QByteArray &stamp, const QHash<QString, QVariant>& values, const QStringList& groups);
+
+    /**
+     * Merge values and groups to a table.
+     *
+     * @param fromValues values to merge.
+     * @param fromGroups groups to merge.
+     * @param values table to merge the values to.
+     * @param groups list to merge the groups to.
+     */
+    static void merge(const QHash<QString, QVariant>& fromValues, const QStringList& fromGroups, QHash<QString, QVariant>& values, QStringList& groups);
 
     /**
      * Clear configuration.
      */
     void clearConfig();
 
-    QList<QSettings*> settings; /**< parsed QSettings */
+    QHash<QString, QVariant> values_; /**< merged values, first loaded file wins */
+    QStringList              groups_; /**< groups of all files */
+    QList<QPair<QString, QString> > paths_; /**< loaded config file and directory paths */
+    QStringList              cachePaths_; /**< cache paths given with paths_ */
+    mutable QMutex           mutex_;  /**< protects values_ and groups_ during reload */
 };
 
 template<typename T>
@@ -33,13 +33,18 @@ void Consumer::addSink(SinkBase* sink, const QString& name)
     sinks_.insert(name, sink);
 }
 
+bool Consumer::hasDemand() const
+{
+    return true;
+}
+
 SinkBase* Consumer::sink(const QString& name) const
 {
-    QHash<QString, SinkBase*>::const_iterator it = sinks_.find(name);
-    if(it == sinks_.end())
+    SinkBase* sink = sinks_.value(name);
+    if(!sink)
     {
         sensordLogW() << "Failed to locate sink: " << name;
         return NULL;
     }
-    return it.value();
+    return sink;
 }
@@ -29,7 +29,7 @@
 #define CONSUMER_H
 
 #include <QString>
-#include <QHash>
+#include "namedlist.h"
 
 class SinkBase;
 
@@ -39,6 +39,11 @@ class SinkBase;
 class Consumer
 {
 public:
+    /**
+     * Destructor.
+     */
+    virtual ~Consumer() {}
+
     /**
      * Locate sink with given name.
      *
@@ -47,6 +52,14 @@ public:
      */
     SinkBase* sink(const QString& name) const;
 
+    /**
+     * Is anything downstream using the data given to this consumer.
+     * Consumers which end the graph, like clients, always want data.
+     *
+     * @return does consumer have a live downstream.
+     */
+    virtual bool hasDemand() const;
+
 protected:
     /**
      * Add sink with given name.
@@ -56,7 +69,7 @@ protected:
      */
     void addSink(SinkBase* sink, const QString& name);
 
-    QHash<QString, SinkBase*>   sinks_; /**< sinks */
+    NamedList<SinkBase> sinks_; /**< sinks by name */
 };
 
 #endif
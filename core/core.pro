@@ -7,6 +7,9 @@ include( ../common-config.pri )
 
 CONFIG += link_pkgconfig
 
+# shm_open for the latest sample pages
+LIBS += -lrt
+
 SENSORFW_INCLUDEPATHS = .. \
                         ../include \
                         ../filters \
@@ -25,6 +28,7 @@ equals(QT_MAJOR_VERSION, 5):{
 }
 
 SOURCES += sensormanager.cpp \
+    chainworker.cpp \
     sensormanager_a.cpp \
     pusher.cpp \
     ringbuffer.cpp \
@@ -44,10 +48,31 @@ SOURCES += sensormanager.cpp \
     sysfsadaptor.cpp \
     sockethandler.cpp \
     inputdevadaptor.cpp \
+    inputdevicecache.cpp \
     config.cpp \
-    nodebase.cpp
+    nodebase.cpp \
+    samplequeue.cpp \
+    samplehistory.cpp \
+    threadscheduling.cpp \
+    iioscanlayout.cpp \
+    nodestatistics.cpp \
+    sampletrace.cpp \
+    samplerecorder.cpp \
+    cpuboost.cpp \
+    workerpool.cpp \
+    threadedbin.cpp \
+    sessionblockpool.cpp \
+    flushwheel.cpp \
+    realtimememory.cpp \
+    stringpool.cpp \
+    capabilitycache.cpp \
+    flightrecorder.cpp \
+    streambridge.cpp \
+    deferredwork.cpp
 
 HEADERS += sensormanager.h \
+    localsession.h \
+    chainworker.h \
     sensormanager_a.h \
     dataemitter.h \
     pusher.h \
@@ -72,15 +97,52 @@ HEADERS += sensormanager.h \
     sysfsadaptor.h \
     sockethandler.h \
     inputdevadaptor.h \
+    inputdevicecache.h \
     config.h \
-    nodebase.h
+    nodebase.h \
+    samplequeue.h \
+    samplehistory.h \
+    fixedpoint.h \
+    xyzblock.h \
+    threadscheduling.h \
+    downsamplewindow.h \
+    timealigner.h \
+    iioscanlayout.h \
+    nodestatistics.h \
+    sampletrace.h \
+    samplerecording.h \
+    samplerecorder.h \
+    cpuboost.h \
+    workerpool.h \
+    threadedbin.h \
+    sessionblockpool.h \
+    flushwheel.h \
+    realtimememory.h \
+    stringpool.h \
+    namedlist.h \
+    capabilitycache.h \
+    flightrecorder.h \
+    streambridge.h \
+    liveparameter.h \
+    deferredwork.h \
+    sessiontable.h
 
 mce {
-    SOURCES += mcewatcher.cpp
-    HEADERS += mcewatcher.h
+    SOURCES += mcewatcher.cpp \
+               mcedispatcher.cpp
+    HEADERS += mcewatcher.h \
+               mcedispatcher.h
     DEFINES += SENSORFW_MCE_WATCHER
 }
 
+# Batch the session writes of a delivery round with io_uring
+io_uring {
+    SOURCES += uringreactor.cpp
+    HEADERS += uringreactor.h
+    PKGCONFIG += liburing
+    DEFINES += SENSORFW_IO_URING
+}
+
 contains(CONFIG,hybris) {
 } else {
     publicheaders.path  = $${publicheaders.path}/core
@@ -0,0 +1,253 @@
+/**
+   @file cpuboost.cpp
+   @brief CpuBoost
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "cpuboost.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QTimer>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusMessage>
+#include <fcntl.h>
+#include <unistd.h>
+#include "config.h"
+#include "logging.h"
+#include "utils.h"
+
+static const char* const EVENT_NAMES[CpuBoost::EventCount] = {
+    "orientation",
+    "proximity",
+    "tap"
+};
+
+static const char* const METHOD_NAMES[] = {
+    "none",
+    "file",
+    "pmqos",
+    "dbus"
+};
+
+CpuBoost::Hook::Hook() :
+    method(None),
+    duration(0),
+    minInterval(0),
+    last(0),
+    active(false),
+    fd(-1),
+    timer(NULL),
+    requested(0),
+    boosted(0),
+    limited(0),
+    failed(0)
+{
+}
+
+CpuBoost& CpuBoost::instance()
+{
+    static CpuBoost boost;
+    return boost;
+}
+
+CpuBoost::CpuBoost()
+{
+    // Release timers need the event loop of the main thread.
+    if (QCoreApplication::instance())
+        moveToThread(QCoreApplication::instance()->thread());
+
+    for (int i = 0; i < EventCount; ++i) {
+        hooks_[i].timer = new QTimer(this);
+        hooks_[i].timer->setSingleShot(true);
+        hooks_[i].timer->setProperty("event", i);
+        connect(hooks_[i].timer, SIGNAL(timeout()), this, SLOT(releaseTimeout()));
+    }
+    readConfiguration();
+}
+
+CpuBoost::~CpuBoost()
+{
+    for (int i = 0; i < EventCount; ++i) {
+        if (hooks_[i].active)
+            release(hooks_[i]);
+    }
+}
+
+const char* CpuBoost::eventName(Event event)
+{
+    return EVENT_NAMES[event];
+}
+
+void CpuBoost::readConfiguration()
+{
+    Config* config = Config::configuration();
+    for (int i = 0; i < EventCount; ++i) {
+        Hook& hook = hooks_[i];
+        QString prefix = QString("cpuboost/%1_").arg(EVENT_NAMES[i]);
+
+        // Orientation keeps the hook it always had.
+        bool orientation = (i == OrientationChange);
+        QString method = config->value<QString>(prefix + "method", orientation ? "file" : "none");
+        hook.path = config->value<QString>(prefix + "path", orientation ? "/sys/power/pm_optimizer_rotation" : "");
+        hook.value = config->value<QString>(prefix + "value", orientation ? "1" : "").toLatin1();
+        hook.releaseValue = config->value<QString>(prefix + "release_value", "").toLatin1();
+        hook.duration = qMax(0, config->value<int>(prefix + "duration", 0));
+        hook.minInterval = (quint64)qMax(0, config->value<int>(prefix + "min_interval", 0)) * 1000;
+
+        hook.method = None;
+        for (int m = File; m <= DBus; ++m) {
+            if (method == METHOD_NAMES[m])
+                hook.method = (Method)m;
+        }
+        if (hook.method == None && method != METHOD_NAMES[None])
+            sensordLogW() << "Unknown CPU boost method " << method << " for " << EVENT_NAMES[i];
+
+        if (hook.method == File && !QFile::exists(hook.path)) {
+            sensordLogD() << "CPU boost file " << hook.path << " for " << EVENT_NAMES[i] << " does not exist";
+            hook.method = None;
+        }
+        if (hook.method == PmQos) {
+            if (hook.path.isEmpty())
+                hook.path = "/dev/cpu_dma_latency";
+            if (hook.duration <= 0) {
+                sensordLogW() << "CPU boost with pmqos for " << EVENT_NAMES[i] << " needs a duration";
+                hook.method = None;
+            }
+        }
+        if (hook.method == DBus && hook.path.split(' ', QString::SkipEmptyParts).size() != 4) {
+            sensordLogW() << "CPU boost D-Bus call for " << EVENT_NAMES[i] << " is not \"service path interface method\"";
+            hook.method = None;
+        }
+    }
+}
+
+bool CpuBoost::request(Event event)
+{
+    if (event < 0 || event >= EventCount)
+        return false;
+
+    QMutexLocker locker(&mutex_);
+    Hook& hook = hooks_[event];
+    if (hook.method == None)
+        return false;
+
+    ++hook.requested;
+    quint64 now = Utils::getCoarseTimeStamp();
+    if (hook.active) {
+        // Already boosted, keep it for another duration.
+        ++hook.boosted;
+        hook.last = now;
+        QMetaObject::invokeMethod(this, "scheduleRelease", Qt::QueuedConnection, Q_ARG(int, event));
+        return true;
+    }
+    if (hook.last && now - hook.last < hook.minInterval) {
+        ++hook.limited;
+        return false;
+    }
+
+    hook.last = now;
+    if (!apply(hook)) {
+        ++hook.failed;
+        return false;
+    }
+    ++hook.boosted;
+    if (hook.duration > 0 && (hook.method == PmQos || !hook.releaseValue.isEmpty())) {
+        hook.active = true;
+        QMetaObject::invokeMethod(this, "scheduleRelease", Qt::QueuedConnection, Q_ARG(int, event));
+    }
+    return true;
+}
+
+bool CpuBoost::apply(Hook& hook)
+{
+    switch (hook.method) {
+    case File: {
+        QFile file(hook.path);
+        return file.open(QIODevice::WriteOnly) && file.write(hook.value) == hook.value.size();
+    }
+    case PmQos: {
+        // Request holds while the file stays open.
+        hook.fd = ::open(hook.path.toLocal8Bit().constData(), O_WRONLY);
+        if (hook.fd < 0)
+            return false;
+        qint32 latency = hook.value.toInt();
+        if (::write(hook.fd, &latency, sizeof(latency)) != sizeof(latency)) {
+            ::close(hook.fd);
+            hook.fd = -1;
+            return false;
+        }
+        return true;
+    }
+    case DBus: {
+        QStringList call = hook.path.split(' ', QString::SkipEmptyParts);
+        QDBusMessage message = QDBusMessage::createMethodCall(call[0], call[1], call[2], call[3]);
+        if (hook.duration > 0)
+            message << hook.duration;
+        return QDBusConnection::systemBus().send(message);
+    }
+    default:
+        return false;
+    }
+}
+
+void CpuBoost::release(Hook& hook)
+{
+    hook.active = false;
+    if (hook.fd >= 0) {
+        ::close(hook.fd);
+        hook.fd = -1;
+    }
+    if (hook.method == File && !hook.releaseValue.isEmpty()) {
+        QFile file(hook.path);
+        if (!file.open(QIODevice::WriteOnly) || file.write(hook.releaseValue) != hook.releaseValue.size())
+            sensordLogW() << "Failed to release CPU boost: " << hook.path;
+    }
+}
+
+void CpuBoost::scheduleRelease(int event)
+{
+    QMutexLocker locker(&mutex_);
+    Hook& hook = hooks_[event];
+    if (hook.active)
+        hook.timer->start(hook.duration);
+}
+
+void CpuBoost::releaseTimeout()
+{
+    int event = sender()->property("event").toInt();
+    QMutexLocker locker(&mutex_);
+    if (hooks_[event].active)
+        release(hooks_[event]);
+}
+
+QStringList CpuBoost::report() const
+{
+    QStringList lines;
+    QMutexLocker locker(&mutex_);
+    for (int i = 0; i < EventCount; ++i) {
+        const Hook& hook = hooks_[i];
+        if (hook.method == None)
+            continue;
+        lines << QString("cpu boost %1: %2 %3, %4 requested, %5 boosted, %6 rate limited, %7 failed")
+                 .arg(EVENT_NAMES[i]).arg(METHOD_NAMES[hook.method]).arg(hook.path)
+                 .arg(hook.requested).arg(hook.boosted).arg(hook.limited).arg(hook.failed);
+    }
+    return lines;
+}
@@ -0,0 +1,150 @@
+/**
+   @file cpuboost.h
+   @brief CpuBoost
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef CPUBOOST_H
+#define CPUBOOST_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QMutex>
+
+class QTimer;
+
+/**
+ * CPU boost for latency critical sensor events, for example a screen
+ * rotation which starts an animation. Nodes call #request() when such
+ * an event happens and the configured hook of the event gives the CPU
+ * headroom for a while.
+ *
+ * Hooks are configured per event in group \c cpuboost, with keys
+ * named after the event (see #eventName()), for example
+ * \c orientation_method:
+ * - \c method: \c none, \c file writes \c value to the file at
+ *   \c path, for example a cpufreq boost attribute, \c pmqos holds a
+ *   \c value microsecond request on <tt>/dev/cpu_dma_latency</tt> or
+ *   \c path, \c dbus calls \c path given as "service path interface
+ *   method" on the system bus, with the duration as argument if set.
+ * - \c duration: milliseconds the boost is held. For \c file the
+ *   \c release_value is written after it, if set. Requests while the
+ *   boost is held extend it.
+ * - \c min_interval: milliseconds between two boosts; requests in
+ *   between are only counted.
+ *
+ * #request() may be called from any thread. Boosts are released from
+ * the main thread.
+ */
+class CpuBoost : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Latency critical events.
+     */
+    enum Event
+    {
+        OrientationChange = 0, /**< classified orientation changed */
+        ProximityNear,         /**< object came within proximity */
+        Tap,                   /**< tap detected */
+        EventCount
+    };
+
+    /**
+     * Get the instance. Created on first use and moved to the main
+     * thread.
+     *
+     * @return boost instance.
+     */
+    static CpuBoost& instance();
+
+    /**
+     * Boost for given event, if a hook is configured and not rate
+     * limited.
+     *
+     * @param event event.
+     * @return was boost applied or extended.
+     */
+    bool request(Event event);
+
+    /**
+     * Name of given event, used as configuration key prefix.
+     *
+     * @param event event.
+     * @return event name.
+     */
+    static const char* eventName(Event event);
+
+    /**
+     * Hook and counters of every configured event.
+     *
+     * @return one line per event.
+     */
+    QStringList report() const;
+
+private Q_SLOTS:
+    void scheduleRelease(int event);
+    void releaseTimeout();
+
+private:
+    enum Method
+    {
+        None = 0,
+        File,
+        PmQos,
+        DBus
+    };
+
+    struct Hook
+    {
+        Hook();
+
+        Method     method;       /**< how boost is applied */
+        QString    path;         /**< file, device or D-Bus call */
+        QByteArray value;        /**< value written or requested */
+        QByteArray releaseValue; /**< value written on release */
+        int        duration;     /**< boost duration, ms */
+        quint64    minInterval;  /**< minimum time between boosts, us */
+        quint64    last;         /**< time of the last boost, us */
+        bool       active;       /**< is boost held */
+        int        fd;           /**< PM QoS request handle */
+        QTimer*    timer;        /**< release timer */
+        unsigned   requested;    /**< requests */
+        unsigned   boosted;      /**< boosts applied or extended */
+        unsigned   limited;      /**< requests dropped by rate limit */
+        unsigned   failed;       /**< boosts which failed */
+    };
+
+    CpuBoost();
+    ~CpuBoost();
+
+    void readConfiguration();
+    bool apply(Hook& hook);
+    void release(Hook& hook);
+
+    Hook           hooks_[EventCount]; /**< hooks by event */
+    mutable QMutex mutex_;             /**< protects hooks_ */
+};
+
+#endif // CPUBOOST_H
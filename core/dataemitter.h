@@ -29,6 +29,8 @@
 #define DATAEMITTER_H
 
 #include "pusher.h"
+#include "consumer.h"
+#include "sink.h"
 #include "ringbuffer.h"
 
 /**
@@ -44,11 +46,10 @@ public:
     /**
      * Constructor.
      *
-     * @param chunkSize how many objects will be internally buffered.
+     * @param chunkSize how many objects are emitted at most per read.
      */
     DataEmitter(unsigned chunkSize) :
-        chunkSize_(chunkSize),
-        chunk_(new TYPE[chunkSize])
+        chunkSize_(chunkSize)
     {
     }
 
@@ -57,19 +58,23 @@ public:
      */
     virtual ~DataEmitter()
     {
-        delete[] chunk_;
     }
 
     /**
-     * Propagate data by calling emitData.
+     * Propagate data by calling emitData. Objects are emitted straight
+     * from the ring storage.
      */
     void pushNewData()
     {
+        const TYPE* first;
+        const TYPE* second;
+        unsigned firstCount;
         unsigned n;
-        while ((n = RingBufferReader<TYPE>::read(chunkSize_, chunk_))) {
-            for (unsigned i = 0; i < n; ++i) {
-                emitData(chunk_[i]);
-            }
+        while ((n = RingBufferReader<TYPE>::peek(chunkSize_, first, firstCount, second))) {
+            emitBatch(first, firstCount);
+            if (n > firstCount)
+                emitBatch(second, n - firstCount);
+            RingBufferReader<TYPE>::commitRead(n);
         }
     }
 
@@ -79,9 +84,61 @@ protected:
      */
     virtual void emitData(const TYPE& value) = 0;
 
+    /**
+     * Callback for a batch of emitted objects. Calls #emitData() for
+     * each of them by default; channels can override this to handle
+     * the whole batch at once. Up to chunk size objects are passed.
+     *
+     * @param values emitted objects, oldest first.
+     * @param n number of objects.
+     */
+    virtual void emitBatch(const TYPE* values, unsigned n)
+    {
+        for (unsigned i = 0; i < n; ++i) {
+            emitData(values[i]);
+        }
+    }
+
+private:
+    template <class T> friend class EmitterSink;
+
+    unsigned     chunkSize_; /**< How many objects are emitted at most per read */
+};
+
+/**
+ * Consumer which passes data from its sink "sink" straight to the
+ * batch callback of a DataEmitter. Joined as the last node of a
+ * filter bin, it replaces the ring buffer and the marshalling bin a
+ * channel would otherwise need to reach its emit path: the data is
+ * neither stored nor copied on the way and no extra wakeup is made.
+ *
+ * @tparam TYPE datatype being emitted.
+ */
+template <class TYPE>
+class EmitterSink : public Consumer
+{
+public:
+    /**
+     * Constructor.
+     *
+     * @param emitter emitter to pass the data to.
+     */
+    EmitterSink(DataEmitter<TYPE>* emitter) :
+        sink_(this, &EmitterSink::collect),
+        emitter_(emitter)
+    {
+        addSink(&sink_, "sink");
+    }
+
 private:
-    unsigned     chunkSize_; /**< How many objects can be buffered */
-    TYPE*        chunk_;     /**< Buffer */
+    void collect(unsigned n, const TYPE* values)
+    {
+        if (n)
+            emitter_->emitBatch(values, n);
+    }
+
+    Sink<EmitterSink, TYPE> sink_;    /**< data sink */
+    DataEmitter<TYPE>*      emitter_; /**< receiver of the data */
 };
 
 #endif
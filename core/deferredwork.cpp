@@ -0,0 +1,126 @@
+/**
+   @file deferredwork.cpp
+   @brief DeferredWork
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "deferredwork.h"
+#include "pusher.h"
+#include "logging.h"
+#include <QThread>
+#include <QCoreApplication>
+
+DeferredWork& DeferredWork::instance()
+{
+    static DeferredWork queue;
+    return queue;
+}
+
+DeferredWork::DeferredWork() :
+    deadline_(this),
+    scheduled_(0)
+{
+    // May be first used from a delivery thread; the readers it runs
+    // belong to the main thread.
+    if (QCoreApplication::instance())
+        moveToThread(QCoreApplication::instance()->thread());
+    deadline_.setSingleShot(true);
+    connect(&deadline_, SIGNAL(timeout()), this, SLOT(run()));
+}
+
+DeferredWork::~DeferredWork()
+{
+    qDeleteAll(readers_);
+}
+
+void DeferredWork::attach(Pusher* reader, unsigned int latency)
+{
+    QMutexLocker locker(&mutex_);
+    Wakeup* wakeup = new Wakeup(this, reader, latency);
+    readers_.append(wakeup);
+    reader->setReadyCallback(wakeup);
+    sensordLogD() << "Deferring buffer reader by up to " << latency << " ms";
+}
+
+void DeferredWork::detach(Pusher* reader)
+{
+    QMutexLocker locker(&mutex_);
+    for (int i = 0; i < readers_.size(); ++i)
+    {
+        if (readers_.at(i)->reader_ == reader)
+        {
+            reader->resetReadyCallback();
+            delete readers_.takeAt(i);
+            return;
+        }
+    }
+}
+
+void DeferredWork::Wakeup::operator()() const
+{
+    // One pending wakeup covers all data written before it is handled.
+    if (!pending_.testAndSetOrdered(0, 1))
+        return;
+    // Only the first reader pending since the last run arms the timer.
+    if (queue_->scheduled_.testAndSetOrdered(0, 1))
+        QMetaObject::invokeMethod(queue_, "schedule", Qt::QueuedConnection);
+}
+
+void DeferredWork::schedule()
+{
+    if (deadline_.isActive())
+        return;
+
+    unsigned int latency = 0;
+    bool pending = false;
+    {
+        QMutexLocker locker(&mutex_);
+        foreach (Wakeup* wakeup, readers_)
+        {
+            if (wakeup->pending_.loadAcquire() && (!pending || wakeup->latency_ < latency))
+            {
+                latency = wakeup->latency_;
+                pending = true;
+            }
+        }
+    }
+    if (pending)
+        deadline_.start(latency);
+}
+
+void DeferredWork::runIfConvenient()
+{
+    if (scheduled_.loadAcquire() && QThread::currentThread() == thread())
+        run();
+}
+
+void DeferredWork::run()
+{
+    deadline_.stop();
+    // Clear before processing so readers woken meanwhile schedule again.
+    scheduled_.fetchAndStoreOrdered(0);
+
+    QMutexLocker locker(&mutex_);
+    foreach (Wakeup* wakeup, readers_)
+    {
+        if (wakeup->pending_.fetchAndStoreOrdered(0))
+            wakeup->reader_->pushNewData();
+    }
+}
@@ -0,0 +1,130 @@
+/**
+   @file deferredwork.h
+   @brief DeferredWork
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef DEFERREDWORK_H
+#define DEFERREDWORK_H
+
+#include <QObject>
+#include <QMutex>
+#include <QTimer>
+#include <QAtomicInt>
+#include <QList>
+#include "callback.h"
+
+class Pusher;
+
+/**
+ * Queue of buffer readers whose consumers do not need their results
+ * promptly, like the context properties. Readers attached to the queue
+ * are not run by the thread writing to their buffer; the writer only
+ * marks them pending. Their backlog is processed in one go in the main
+ * thread, either right after a delivery round to clients, when the CPU
+ * is awake anyway, or at the latest when the latency given for a
+ * pending reader has passed.
+ *
+ * The buffer must be able to hold the samples written during the
+ * latency, otherwise the reader skips the oldest ones.
+ */
+class DeferredWork : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(DeferredWork)
+
+public:
+    /**
+     * Get the queue. Lives in the main thread.
+     *
+     * @return queue instance.
+     */
+    static DeferredWork& instance();
+
+    /**
+     * Destructor.
+     */
+    ~DeferredWork();
+
+    /**
+     * Defer reader. Must be called in the main thread before the
+     * reader is joined to a buffer.
+     *
+     * @param reader buffer reader.
+     * @param latency longest time in milliseconds the reader may be
+     *                left pending.
+     */
+    void attach(Pusher* reader, unsigned int latency);
+
+    /**
+     * Stop deferring reader. Must be called after the reader has been
+     * unjoined from its buffer. When this returns the queue does not
+     * touch the reader any more.
+     *
+     * @param reader buffer reader.
+     */
+    void detach(Pusher* reader);
+
+    /**
+     * Process pending readers now if called in the main thread and any
+     * reader is pending. Called after delivery rounds; costs an atomic
+     * load when nothing is pending.
+     */
+    void runIfConvenient();
+
+public Q_SLOTS:
+    /**
+     * Process all pending readers.
+     */
+    void run();
+
+private Q_SLOTS:
+    /**
+     * Start the deadline timer for the pending readers.
+     */
+    void schedule();
+
+private:
+    DeferredWork();
+
+    /**
+     * Wakeup callback given to an attached reader.
+     */
+    class Wakeup : public CallbackBase
+    {
+    public:
+        Wakeup(DeferredWork* queue, Pusher* reader, unsigned int latency) :
+            queue_(queue), reader_(reader), latency_(latency), pending_(0) {}
+
+        void operator()() const;
+
+        DeferredWork*      queue_;   /**< owning queue */
+        Pusher*            reader_;  /**< reader to run */
+        unsigned int       latency_; /**< longest deferral in milliseconds */
+        mutable QAtomicInt pending_; /**< has reader been woken up */
+    };
+
+    QList<Wakeup*> readers_;   /**< attached readers */
+    QMutex         mutex_;     /**< protects readers_ and processing */
+    QTimer         deadline_;  /**< runs the queue at the latest deadline */
+    QAtomicInt     scheduled_; /**< is a reader pending since the last run */
+};
+
+#endif // DEFERREDWORK_H
@@ -29,6 +29,11 @@
 
 #include "deviceadaptor.h"
 #include "sensormanager.h"
+#include "ringbuffer.h"
+#include "config.h"
+#include "workerpool.h"
+
+#include <QSemaphore>
 
 AdaptedSensorEntry::AdaptedSensorEntry(const QString& name, const QString& description, RingBufferBase* buffer) :
     name_(name),
@@ -84,10 +89,13 @@ DeviceAdaptor::DeviceAdaptor(const QString& id) :
 //#ifdef SENSORFW_MCE_WATCHER
 //    screenBlanked_(!SensorManager::instance().MCEWatcher()->displayEnabled())
 //#else
-    screenBlanked_(false)
+    screenBlanked_(false),
 //#endif
+    lingering_(false)
 {
     setValid(true);
+    lingerTimer_.setSingleShot(true);
+    connect(&lingerTimer_, SIGNAL(timeout()), this, SLOT(lingerExpired()));
 }
 
 DeviceAdaptor::~DeviceAdaptor()
@@ -95,8 +103,65 @@ DeviceAdaptor::~DeviceAdaptor()
     delete sensor_.second;
 }
 
+bool DeviceAdaptor::acquireSensor()
+{
+    AdaptedSensorEntry* entry = getAdaptedSensor();
+    if (lingering_) {
+        lingering_ = false;
+        lingerTimer_.stop();
+        // Reference of the previous user is handed over.
+        if (entry && entry->isRunning()) {
+            sensordLogD() << "Adaptor '" << id() << "' reused while lingering";
+            return true;
+        }
+    }
+    if (AdaptorStartBatch::defer(this))
+        return true;
+    return startSensor();
+}
+
+void DeviceAdaptor::releaseSensor()
+{
+    if (AdaptorStartBatch::cancel(this))
+        return;
+    AdaptedSensorEntry* entry = getAdaptedSensor();
+    if (!lingering_ && entry && entry->isRunning() && entry->referenceCount() == 1) {
+        unsigned int linger = 0;
+        Config* config = Config::configuration();
+        if (config) {
+            linger = config->value<unsigned int>("global/adaptor_linger", 0);
+            linger = config->value<unsigned int>(id() + "/linger", linger);
+        }
+        if (linger) {
+            sensordLogD() << "Adaptor '" << id() << "' lingering for " << linger << " ms";
+            lingering_ = true;
+            lingerTimer_.start(linger);
+            // Nobody reads the samples, run slow until a user comes back.
+            unsigned int slow = config->value<unsigned int>(id() + "/linger_interval", defaultInterval());
+            if (slow && slow > interval())
+                setInterval(slow, -1);
+            return;
+        }
+    }
+    stopSensor();
+}
+
+void DeviceAdaptor::lingerExpired()
+{
+    if (!lingering_)
+        return;
+    lingering_ = false;
+    AdaptedSensorEntry* entry = getAdaptedSensor();
+    if (entry && entry->isRunning()) {
+        sensordLogD() << "Adaptor '" << id() << "' linger expired, stopping";
+        stopSensor();
+    }
+}
+
 void DeviceAdaptor::setAdaptedSensor(const QString& name, const QString& description, RingBufferBase* buffer)
 {
+    if (buffer)
+        buffer->statistics().setName(id() + "/" + name);
     setAdaptedSensor(name, new AdaptedSensorEntry(name, description, buffer));
 }
 
@@ -105,6 +170,18 @@ void DeviceAdaptor::setAdaptedSensor(const QString& name, AdaptedSensorEntry* ne
     sensor_ = qMakePair(name, newAdaptedSensor);
 }
 
+unsigned int DeviceAdaptor::bufferCapacity(unsigned int minimum) const
+{
+    unsigned int capacity = 64;
+    Config* config = Config::configuration();
+    if (config)
+    {
+        capacity = config->value<unsigned int>("global/adaptor_buffer_capacity", capacity);
+        capacity = config->value<unsigned int>(id() + "/buffer_capacity", capacity);
+    }
+    return qMax(capacity, qMax(minimum, 1u));
+}
+
 AdaptedSensorEntry* DeviceAdaptor::getAdaptedSensor() const
 {
     return sensor_.second;
@@ -139,7 +216,15 @@ bool DeviceAdaptor::setStandbyOverride(bool override)
 
 void DeviceAdaptor::setScreenBlanked(bool status)
 {
+    bool changed = screenBlanked_ != status;
     screenBlanked_ = status;
+    if (changed && deadlineArbitration())
+        reevaluateRequests();
+}
+
+bool DeviceAdaptor::isSessionActive(int sessionId) const
+{
+    return !screenBlanked_ || hasStandbyOverrideRequest(sessionId);
 }
 
 bool DeviceAdaptor::deviceStandbyOverride() const
@@ -165,3 +250,128 @@ bool DeviceAdaptor::resume()
 {
     return false;
 }
+
+/**
+ * Starts an adaptor in a pool thread.
+ */
+class AdaptorStartTask : public WorkerPool::Task
+{
+public:
+    AdaptorStartTask(DeviceAdaptor* adaptor, int count, QSemaphore* done) :
+        adaptor_(adaptor),
+        count_(count),
+        started_(false),
+        done_(done)
+    {
+    }
+
+    void run()
+    {
+        started_ = start(adaptor_, count_);
+        done_->release();
+    }
+
+    /**
+     * Start an adaptor on behalf of several users. Only the first start
+     * powers up the hardware, the others take a reference.
+     *
+     * @param adaptor adaptor to start.
+     * @param count number of users.
+     * @return was the hardware started.
+     */
+    static bool start(DeviceAdaptor* adaptor, int count)
+    {
+        bool started = adaptor->startSensor();
+        for (int i = 1; i < count; ++i)
+            adaptor->startSensor();
+        return started;
+    }
+
+    DeviceAdaptor* adaptor_; /**< adaptor to start */
+    int            count_;   /**< number of queued starts */
+    bool           started_; /**< was the hardware started */
+
+private:
+    QSemaphore*    done_;    /**< released when the task has run */
+};
+
+int AdaptorStartBatch::depth_ = 0;
+QList<QPair<DeviceAdaptor*, int> > AdaptorStartBatch::queue_;
+
+AdaptorStartBatch::AdaptorStartBatch()
+{
+    ++depth_;
+}
+
+AdaptorStartBatch::~AdaptorStartBatch()
+{
+    if (--depth_ == 0)
+        flush();
+}
+
+bool AdaptorStartBatch::defer(DeviceAdaptor* adaptor)
+{
+    if (!depth_)
+        return false;
+    for (int i = 0; i < queue_.size(); ++i) {
+        if (queue_[i].first == adaptor) {
+            ++queue_[i].second;
+            return true;
+        }
+    }
+    queue_.append(qMakePair(adaptor, 1));
+    return true;
+}
+
+bool AdaptorStartBatch::cancel(DeviceAdaptor* adaptor)
+{
+    for (int i = 0; i < queue_.size(); ++i) {
+        if (queue_[i].first == adaptor) {
+            if (--queue_[i].second == 0)
+                queue_.removeAt(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void AdaptorStartBatch::flush()
+{
+    QList<QPair<DeviceAdaptor*, int> > queue = queue_;
+    queue_.clear();
+    if (queue.isEmpty())
+        return;
+
+    bool parallel = queue.size() > 1;
+    Config* config = Config::configuration();
+    if (config)
+        parallel = parallel && config->value<bool>("global/parallel_start", true);
+
+    QSemaphore done;
+    QList<AdaptorStartTask*> tasks;
+    QList<QPair<DeviceAdaptor*, bool> > results;
+    for (int i = 0; i < queue.size(); ++i) {
+        DeviceAdaptor* adaptor = queue[i].first;
+        if (parallel && adaptor->startsConcurrently()) {
+            AdaptorStartTask* task = new AdaptorStartTask(adaptor, queue[i].second, &done);
+            tasks.append(task);
+            WorkerPool::instance().submit(task);
+        }
+    }
+
+    // The rest overlaps with the pool.
+    for (int i = 0; i < queue.size(); ++i) {
+        DeviceAdaptor* adaptor = queue[i].first;
+        if (!parallel || !adaptor->startsConcurrently())
+            results.append(qMakePair(adaptor, AdaptorStartTask::start(adaptor, queue[i].second)));
+    }
+    done.acquire(tasks.size());
+
+    foreach (AdaptorStartTask* task, tasks)
+        results.append(qMakePair(task->adaptor_, task->started_));
+    qDeleteAll(tasks);
+
+    sensordLogD() << "Started " << queue.size() << " adaptors" << (tasks.isEmpty() ? "" : " in parallel");
+    for (int i = 0; i < results.size(); ++i)
+        emit results[i].first->sensorStarted(results[i].second);
+}
@@ -34,6 +34,8 @@
 #include <QString>
 #include <QHash>
 #include <QPair>
+#include <QList>
+#include <QTimer>
 #include "logging.h"
 #include "nodebase.h"
 
@@ -133,7 +135,8 @@ public:
     virtual ~DeviceAdaptor();
 
     /**
-     * Inform adaptor about display state.
+     * Inform adaptor about display state. With deadline arbitration
+     * interval requests are re-evaluated when the state changes.
      *
      * @param display state.
      */
@@ -155,6 +158,30 @@ public:
      */
     virtual void stopSensor() = 0;
 
+    /**
+     * Start sensor on behalf of a user. Same as #startSensor() unless
+     * the sensor is lingering after #releaseSensor(), then the running
+     * hardware is taken over as is.
+     *
+     * While an #AdaptorStartBatch is open the start is only queued and
+     * this returns right away; #sensorStarted() reports the outcome once
+     * the batch has started its adaptors.
+     *
+     * @return was sensor started, or queued for start.
+     */
+    bool acquireSensor();
+
+    /**
+     * Stop sensor on behalf of a user. When the last user goes away and
+     * <tt>linger</tt> is set in the adaptor group, or
+     * <tt>global/adaptor_linger</tt>, the hardware is kept running for
+     * that many milliseconds, so a user coming back right away does not
+     * power cycle the chip. Meanwhile the hardware runs at
+     * <tt>linger_interval</tt>, by default the default interval of the
+     * adaptor. Otherwise same as #stopSensor().
+     */
+    void releaseSensor();
+
     virtual void init() = 0;
 
     /**
@@ -200,17 +227,116 @@ public:
 
     const QString& name() { return sensor_.first; }
 
+    /**
+     * Can #startSensor() run in a pool thread while the main thread
+     * waits for it. Adaptors creating timers or other objects bound to
+     * the calling thread when started must return false.
+     *
+     * @return can the sensor be started off the main thread.
+     */
+    virtual bool startsConcurrently() const { return false; }
+
+Q_SIGNALS:
+    /**
+     * Emitted in the main thread when a start queued by
+     * #acquireSensor() in an #AdaptorStartBatch has been done.
+     *
+     * @param started was sensor started.
+     */
+    void sensorStarted(bool started);
+
 protected:
     void setAdaptedSensor(const QString& name, const QString& description, RingBufferBase* buffer);
 
+    /**
+     * Capacity to create the output buffer with. The ring has to hold
+     * everything written between two wake ups of its readers, which with
+     * chain worker threads or hardware batching is more than one sample.
+     * <tt>[adaptor] buffer_capacity</tt> or, if not set,
+     * <tt>global/adaptor_buffer_capacity</tt> gives the capacity.
+     *
+     * @param minimum smallest capacity the adaptor needs.
+     * @return capacity, at least \c minimum.
+     */
+    virtual unsigned int bufferCapacity(unsigned int minimum) const;
+
     const QPair<QString, AdaptedSensorEntry*>& sensor() const { return sensor_; }
 
+    /**
+     * Sessions which have not requested standby override do not
+     * receive samples while the display is blanked.
+     *
+     * @param sessionId session ID.
+     * @return is session active.
+     */
+    virtual bool isSessionActive(int sessionId) const;
+
+private Q_SLOTS:
+    /**
+     * Stop the sensor once the linger period has passed.
+     */
+    void lingerExpired();
+
 private:
     void setAdaptedSensor(const QString& name, AdaptedSensorEntry* newAdaptedSensor);
 
     QPair<QString, AdaptedSensorEntry*> sensor_;
     bool standbyOverride_;                        /**< standby override state */
     bool screenBlanked_;                          /**< is display blanked */
+    QTimer lingerTimer_;                          /**< delays the stop of the last user */
+    bool lingering_;                              /**< is the last user's reference kept */
+
+    friend class AdaptorStartBatch;
+};
+
+/**
+ * Starts adaptors of a composite channel together. Adaptors acquired
+ * with DeviceAdaptor::acquireSensor() while a batch is open are queued,
+ * and when the outermost batch goes out of scope their blocking power
+ * up and warm up runs in parallel in the WorkerPool. The destructor
+ * returns once every queued adaptor has been started, so the control
+ * flow of the channels does not change, only the wait is shared.
+ *
+ * Adaptors which do not support DeviceAdaptor::startsConcurrently() are
+ * started in the main thread while the others run. Setting
+ * <tt>global/parallel_start</tt> to false starts everything in the main
+ * thread in the order acquired.
+ *
+ * Batches are opened and closed in the main thread only.
+ */
+class AdaptorStartBatch
+{
+    Q_DISABLE_COPY(AdaptorStartBatch)
+
+public:
+    AdaptorStartBatch();
+    ~AdaptorStartBatch();
+
+    /**
+     * Queue start of an adaptor if a batch is open.
+     *
+     * @param adaptor adaptor to start.
+     * @return was the start queued.
+     */
+    static bool defer(DeviceAdaptor* adaptor);
+
+    /**
+     * Drop one queued start of an adaptor, stopped before the batch was
+     * closed.
+     *
+     * @param adaptor adaptor to stop.
+     * @return was a queued start dropped.
+     */
+    static bool cancel(DeviceAdaptor* adaptor);
+
+private:
+    /**
+     * Start the queued adaptors and wait for them.
+     */
+    static void flush();
+
+    static int depth_;                            /**< number of open batches */
+    static QList<QPair<DeviceAdaptor*, int> > queue_; /**< adaptors and their start counts, in acquire order */
 };
 
 /**
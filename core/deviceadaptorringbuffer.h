@@ -30,7 +30,9 @@
 #include "ringbuffer.h"
 
 /**
- * Ring buffer specialization for sensor adaptors.
+ * Ring buffer specialization for sensor adaptors. Committed samples are
+ * timed in the buffer statistics, so the delivered rate of every
+ * adaptor shows up in the node statistics report.
  * @tparam TYPE data type in buffer.
  */
 template <class TYPE>
@@ -46,8 +48,29 @@ public:
         RingBuffer<TYPE>(size)
     {}
 
+    /**
+     * Makes the object written into #nextSlot() visible to readers and
+     * records its arrival for the rate and jitter statistics.
+     */
+    void commit()
+    {
+        RingBuffer<TYPE>::commit();
+        this->statistics().addArrival(1);
+    }
+
+    /**
+     * Makes the objects written into #stageSlot() visible to readers and
+     * records their arrival for the rate and jitter statistics.
+     */
+    void commitStaged()
+    {
+        unsigned n = RingBuffer<TYPE>::commitStaged();
+        if (n)
+            this->statistics().addArrival(n);
+    }
+
     using RingBuffer<TYPE>::nextSlot;
-    using RingBuffer<TYPE>::commit;
+    using RingBuffer<TYPE>::stageSlot;
     using RingBuffer<TYPE>::wakeUpReaders;
 };
 
@@ -0,0 +1,339 @@
+/**
+   @file downsamplewindow.h
+   @brief DownsampleWindow
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef DOWNSAMPLEWINDOW_H
+#define DOWNSAMPLEWINDOW_H
+
+#include <QVector>
+#include "orientationdata.h"
+
+/**
+ * How samples in a downsample window are combined.
+ */
+enum DownsampleMode
+{
+    DownsampleAverage = 0, /**< average of each component */
+    DownsampleLatest,      /**< latest sample */
+    DownsampleMinimum,     /**< minimum of each component */
+    DownsampleMaximum      /**< maximum of each component */
+};
+
+/**
+ * Describes how a sample type is downsampled. Specialize for every type
+ * passed to DownsampleWindow or AbstractSensorChannel::downsampleAndPropagate().
+ * A specialization provides:
+ *
+ * - \c COMPONENTS number of combined components.
+ * - \c MODE default DownsampleMode for the type.
+ * - \c components() to extract the components of a sample.
+ * - \c build() to construct a sample from combined components. The
+ *   latest sample of the window is given for the fields which are not
+ *   combined, like the timestamp.
+ */
+template <class TYPE>
+struct DownsampleTraits;
+
+template <>
+struct DownsampleTraits<TimedXyzData>
+{
+    static const int COMPONENTS = 3;
+    static const DownsampleMode MODE = DownsampleAverage;
+
+    static void components(const TimedXyzData& data, long* values)
+    {
+        values[0] = data.x_;
+        values[1] = data.y_;
+        values[2] = data.z_;
+    }
+
+    static TimedXyzData build(const long* values, const TimedXyzData& latest)
+    {
+        return TimedXyzData(latest.timestamp_, values[0], values[1], values[2]);
+    }
+};
+
+template <>
+struct DownsampleTraits<TimedXyzFloatData>
+{
+    // Fixed point with four decimals, which leaves room for the running
+    // sums of long windows in a 32-bit long.
+    static const int COMPONENTS = 3;
+    static const DownsampleMode MODE = DownsampleAverage;
+
+    static void components(const TimedXyzFloatData& data, long* values)
+    {
+        values[0] = qRound(data.x_ * 10000);
+        values[1] = qRound(data.y_ * 10000);
+        values[2] = qRound(data.z_ * 10000);
+    }
+
+    static TimedXyzFloatData build(const long* values, const TimedXyzFloatData& latest)
+    {
+        return TimedXyzFloatData(latest.timestamp_, values[0] / 10000.0f,
+                                 values[1] / 10000.0f, values[2] / 10000.0f);
+    }
+};
+
+template <>
+struct DownsampleTraits<CalibratedMagneticFieldData>
+{
+    static const int COMPONENTS = 6;
+    static const DownsampleMode MODE = DownsampleAverage;
+
+    static void components(const CalibratedMagneticFieldData& data, long* values)
+    {
+        values[0] = data.x_;
+        values[1] = data.y_;
+        values[2] = data.z_;
+        values[3] = data.rx_;
+        values[4] = data.ry_;
+        values[5] = data.rz_;
+    }
+
+    static CalibratedMagneticFieldData build(const long* values, const CalibratedMagneticFieldData& latest)
+    {
+        return CalibratedMagneticFieldData(latest.timestamp_,
+                                           values[0], values[1], values[2],
+                                           values[3], values[4], values[5],
+                                           latest.level_);
+    }
+};
+
+template <>
+struct DownsampleTraits<TimedUnsigned>
+{
+    static const int COMPONENTS = 1;
+    static const DownsampleMode MODE = DownsampleAverage;
+
+    static void components(const TimedUnsigned& data, long* values)
+    {
+        values[0] = data.value_;
+    }
+
+    static TimedUnsigned build(const long* values, const TimedUnsigned& latest)
+    {
+        return TimedUnsigned(latest.timestamp_, values[0]);
+    }
+};
+
+template <>
+struct DownsampleTraits<CompassData>
+{
+    // Averaging angles does not work across north, so use the latest heading.
+    static const int COMPONENTS = 1;
+    static const DownsampleMode MODE = DownsampleLatest;
+
+    static void components(const CompassData& data, long* values)
+    {
+        values[0] = data.degrees_;
+    }
+
+    static CompassData build(const long* values, const CompassData& latest)
+    {
+        CompassData data(latest);
+        data.degrees_ = values[0];
+        return data;
+    }
+};
+
+/**
+ * Fixed capacity circular window for downsampling. In average mode
+ * running sums are updated as samples enter and leave the window, so
+ * producing the result costs the same regardless of the window size.
+ * Minimum and maximum are computed over the window when the result is
+ * requested. Storage is only reallocated when the capacity changes.
+ */
+template <class TYPE, class TRAITS = DownsampleTraits<TYPE> >
+class DownsampleWindow
+{
+public:
+    /**
+     * Constructor.
+     */
+    DownsampleWindow() :
+        mode_(TRAITS::MODE),
+        head_(0),
+        count_(0)
+    {
+        clear();
+    }
+
+    /**
+     * Downsampling mode.
+     *
+     * @return mode.
+     */
+    DownsampleMode mode() const { return mode_; }
+
+    /**
+     * Set downsampling mode. Window is cleared.
+     *
+     * @param mode new mode.
+     */
+    void setMode(DownsampleMode mode)
+    {
+        mode_ = mode;
+        clear();
+    }
+
+    /**
+     * Set window capacity. Window is cleared if the capacity changes.
+     *
+     * @param capacity new capacity. Zero is treated as one.
+     */
+    void setCapacity(unsigned int capacity)
+    {
+        if (!capacity)
+            capacity = 1;
+        if ((unsigned int)samples_.size() == capacity)
+            return;
+        samples_.resize(capacity);
+        clear();
+    }
+
+    /**
+     * Window capacity.
+     *
+     * @return capacity.
+     */
+    unsigned int capacity() const { return samples_.size(); }
+
+    /**
+     * Number of samples in the window.
+     *
+     * @return sample count.
+     */
+    unsigned int count() const { return count_; }
+
+    /**
+     * Is window full.
+     *
+     * @return is window full.
+     */
+    bool isFull() const { return count_ && count_ >= (unsigned int)samples_.size(); }
+
+    /**
+     * Add sample to the window. If window is full the oldest sample is
+     * dropped.
+     *
+     * @param data sample to add.
+     */
+    void push(const TYPE& data)
+    {
+        if (samples_.isEmpty())
+            setCapacity(1);
+        if (isFull())
+            popOldest();
+        unsigned int index = (head_ + count_) % samples_.size();
+        samples_[index] = data;
+        if (mode_ == DownsampleAverage)
+            accumulate(data, 1);
+        ++count_;
+    }
+
+    /**
+     * Drop samples which are more than maxAge older than the given
+     * timestamp.
+     *
+     * @param timestamp reference timestamp.
+     * @param maxAge maximum age in microseconds.
+     */
+    void dropOlderThan(quint64 timestamp, quint64 maxAge)
+    {
+        while (count_ && timestamp - samples_[head_].timestamp_ > maxAge)
+            popOldest();
+    }
+
+    /**
+     * Combine the samples in the window according to the mode. Window
+     * must not be empty.
+     *
+     * @return downsampled sample, timestamped with the latest sample.
+     */
+    TYPE result() const
+    {
+        const TYPE& latest = samples_[(head_ + count_ - 1) % samples_.size()];
+        long values[TRAITS::COMPONENTS];
+
+        switch (mode_)
+        {
+        case DownsampleLatest:
+            return latest;
+        case DownsampleAverage:
+            for (int i = 0; i < TRAITS::COMPONENTS; ++i)
+                values[i] = sums_[i] / (long)count_;
+            break;
+        case DownsampleMinimum:
+        case DownsampleMaximum:
+            TRAITS::components(samples_[head_], values);
+            for (unsigned int n = 1; n < count_; ++n)
+            {
+                long sample[TRAITS::COMPONENTS];
+                TRAITS::components(samples_[(head_ + n) % samples_.size()], sample);
+                for (int i = 0; i < TRAITS::COMPONENTS; ++i)
+                {
+                    if (mode_ == DownsampleMinimum ? sample[i] < values[i] : sample[i] > values[i])
+                        values[i] = sample[i];
+                }
+            }
+            break;
+        }
+        return TRAITS::build(values, latest);
+    }
+
+    /**
+     * Remove all samples.
+     */
+    void clear()
+    {
+        head_ = 0;
+        count_ = 0;
+        for (int i = 0; i < TRAITS::COMPONENTS; ++i)
+            sums_[i] = 0;
+    }
+
+private:
+    void accumulate(const TYPE& data, long sign)
+    {
+        long values[TRAITS::COMPONENTS];
+        TRAITS::components(data, values);
+        for (int i = 0; i < TRAITS::COMPONENTS; ++i)
+            sums_[i] += sign * values[i];
+    }
+
+    void popOldest()
+    {
+        if (mode_ == DownsampleAverage)
+            accumulate(samples_[head_], -1);
+        head_ = (head_ + 1) % samples_.size();
+        --count_;
+    }
+
+    DownsampleMode mode_;                     /**< how samples are combined */
+    QVector<TYPE>  samples_;                  /**< sample storage */
+    unsigned int   head_;                     /**< index of the oldest sample */
+    unsigned int   count_;                    /**< number of samples */
+    long           sums_[TRAITS::COMPONENTS]; /**< running sums in average mode */
+};
+
+#endif // DOWNSAMPLEWINDOW_H
@@ -30,3 +30,8 @@
 FilterBase::FilterBase()
 {
 }
+
+bool FilterBase::hasDemand() const
+{
+    return hasConsumers();
+}
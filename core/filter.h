@@ -31,23 +31,47 @@
 #include "producer.h"
 #include "sink.h"
 #include "source.h"
+#include "nodestatistics.h"
+#include <QVector>
 
 /**
  * Filter base class.
  */
 class FilterBase : public Consumer, public Producer
 {
+public:
+    /**
+     * Throughput and processing time counters of the filter.
+     *
+     * @return filter statistics.
+     */
+    NodeStatistics& statistics() { return statistics_; }
+
+    /**
+     * Filter output is used when any of its sources has demand.
+     *
+     * @return is filter output used.
+     */
+    bool hasDemand() const;
+
 protected:
     /**
      * Default constructor.
      */
     FilterBase();
+
+    NodeStatistics statistics_; /**< filter statistics */
 };
 
 /**
  * Extendable filter class. Filters data from given source "source"
  * to sink "sink".
  *
+ * Data arrives in batches: the sink callback gets all samples a
+ * producer had available as one span and must consume every one of
+ * them. Results should be collected into #outputSpan() and propagated
+ * with a single call instead of one sample at a time.
+ *
  * @tparam INPUT_TYPE input data type.
  * @tparam DERIVED subclass type.
  * @tparam OUTPUT_TYPE output data type.
@@ -68,11 +92,31 @@ public:
     {
         addSink(&sink_, "sink");
         addSource(&source_, "source");
+        sink_.setStatistics(&statistics_);
+        source_.setStatistics(&statistics_);
     }
 
 protected:
+    /**
+     * Get scratch space for the output of a batch. The buffer is reused
+     * between calls, so nothing is allocated once it has grown to the
+     * largest batch size seen.
+     *
+     * @param n number of output elements needed.
+     * @return buffer for at least n elements.
+     */
+    OUTPUT_TYPE* outputSpan(unsigned n)
+    {
+        if ((unsigned)output_.size() < n)
+            output_.resize(n);
+        return output_.data();
+    }
+
     Sink<DERIVED, INPUT_TYPE> sink_;   /**< data sink.   */
     Source<OUTPUT_TYPE>       source_; /**< data source. */
+
+private:
+    QVector<OUTPUT_TYPE>      output_; /**< output scratch space. */
 };
 
 /**
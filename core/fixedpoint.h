@@ -0,0 +1,94 @@
+/**
+   @file fixedpoint.h
+   @brief FixedPoint
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef FIXEDPOINT_H
+#define FIXEDPOINT_H
+
+#include <QtGlobal>
+
+/**
+ * Fixed point number with \c FRACTION_BITS fractional bits in a 64-bit
+ * integer. It is meant for filter coefficients which multiply integer
+ * samples: products with \c int are exact in the raw value and only the
+ * final conversion back with #toInt() drops the fraction, so coefficient
+ * magnitudes up to 2^(31 - FRACTION_BITS) can be applied to any sample.
+ */
+template <int FRACTION_BITS>
+class FixedPoint
+{
+public:
+    FixedPoint() : raw_(0) {}
+    FixedPoint(int value) : raw_((qint64)value * ONE) {}
+    FixedPoint(double value) : raw_((qint64)(value * ONE + (value < 0 ? -0.5 : 0.5))) {}
+
+    /**
+     * Integer part, truncated toward zero like a floating point to
+     * integer conversion.
+     *
+     * @return integer value.
+     */
+    int toInt() const { return (int)(raw_ >= 0 ? raw_ / ONE : -(-raw_ / ONE)); }
+
+    /**
+     * Value as floating point.
+     *
+     * @return value.
+     */
+    double toReal() const { return (double)raw_ / ONE; }
+
+    friend FixedPoint operator+(FixedPoint a, FixedPoint b) { return fromRaw(a.raw_ + b.raw_); }
+    friend FixedPoint operator-(FixedPoint a, FixedPoint b) { return fromRaw(a.raw_ - b.raw_); }
+    friend FixedPoint operator*(FixedPoint a, int b) { return fromRaw(a.raw_ * b); }
+    friend FixedPoint operator*(int a, FixedPoint b) { return fromRaw(a * b.raw_); }
+    friend bool operator==(FixedPoint a, FixedPoint b) { return a.raw_ == b.raw_; }
+    friend bool operator!=(FixedPoint a, FixedPoint b) { return a.raw_ != b.raw_; }
+
+private:
+    static const qint64 ONE = (qint64)1 << FRACTION_BITS;
+
+    static FixedPoint fromRaw(qint64 raw) { FixedPoint value; value.raw_ = raw; return value; }
+
+    qint64 raw_;
+};
+
+inline int scalarToInt(double value) { return (int)value; }
+inline double scalarToReal(double value) { return value; }
+
+template <int FRACTION_BITS>
+inline int scalarToInt(const FixedPoint<FRACTION_BITS>& value) { return value.toInt(); }
+template <int FRACTION_BITS>
+inline double scalarToReal(const FixedPoint<FRACTION_BITS>& value) { return value.toReal(); }
+
+/**
+ * Scalar type for filter coefficients applied to integer samples.
+ * Building with <tt>CONFIG+=fixedpoint</tt> keeps the accelerometer and
+ * magnetometer filters in integer arithmetic for hardware without a fast
+ * FPU.
+ */
+#ifdef SENSORFW_FIXED_POINT
+typedef FixedPoint<16> FilterScalar;
+#else
+typedef double FilterScalar;
+#endif
+
+#endif // FIXEDPOINT_H
@@ -0,0 +1,197 @@
+/**
+   @file flightrecorder.cpp
+   @brief FlightRecorder
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "flightrecorder.h"
+#include "samplerecorder.h"
+#include "logging.h"
+#include <QFile>
+#include <QVector>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <time.h>
+
+static quint64 clockMicroseconds(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (quint64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+FlightRecorder::FlightRecorder() :
+    header_(NULL),
+    slots_(NULL),
+    mapSize_(0),
+    mask_(0),
+    sampleSize_(0)
+{
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    close();
+}
+
+bool FlightRecorder::open(const QString& path, quint32 type, quint32 sampleSize, quint32 capacity, quint32 interval)
+{
+    close();
+    if (!sampleSize || !capacity)
+        return false;
+
+    quint32 slots = 1;
+    while (slots < capacity)
+        slots <<= 1;
+
+    QByteArray name = QFile::encodeName(path);
+    if (QFile::exists(path) && rename(name.constData(), QFile::encodeName(path + ".prev").constData()) != 0)
+        sensordLogW() << "Failed to keep previous flight recorder " << path << ": " << strerror(errno);
+
+    int fd = ::open(name.constData(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW, 0644);
+    if (fd == -1) {
+        sensordLogW() << "Failed to open flight recorder " << path << ": " << strerror(errno);
+        return false;
+    }
+
+    // Allocate the whole ring up front, a full disk must not fault the
+    // writer later.
+    size_t size = sizeof(FlightRecorderHeader) + (size_t)slots * sampleSize;
+    int error = posix_fallocate(fd, 0, size);
+    void* map = MAP_FAILED;
+    if (error == 0)
+        map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    else
+        errno = error;
+    if (map == MAP_FAILED) {
+        sensordLogW() << "Failed to map flight recorder " << path << ": " << strerror(errno);
+        ::close(fd);
+        unlink(name.constData());
+        return false;
+    }
+    ::close(fd);
+
+    header_ = (FlightRecorderHeader*)map;
+    memset(header_, 0, sizeof(*header_));
+    header_->magic = FLIGHT_RECORDER_MAGIC;
+    header_->version = FLIGHT_RECORDER_VERSION;
+    header_->type = type;
+    header_->sampleSize = sampleSize;
+    header_->capacity = slots;
+    header_->interval = interval;
+    header_->openMonotonic = clockMicroseconds(CLOCK_MONOTONIC);
+    header_->openRealtime = clockMicroseconds(CLOCK_REALTIME);
+    header_->pid = getpid();
+
+    path_ = path;
+    slots_ = (char*)map + sizeof(FlightRecorderHeader);
+    mapSize_ = size;
+    mask_ = slots - 1;
+    sampleSize_ = sampleSize;
+    sensordLogD() << "Flight recorder " << path << " keeps " << slots << " samples";
+    return true;
+}
+
+void FlightRecorder::close()
+{
+    if (header_) {
+        munmap(header_, mapSize_);
+        header_ = NULL;
+    }
+    slots_ = NULL;
+    mapSize_ = 0;
+}
+
+int FlightRecorder::dump(const QString& path) const
+{
+    if (!header_)
+        return -1;
+    return dumpRing(header_, path);
+}
+
+int FlightRecorder::dumpFile(const QString& flightPath, const QString& path)
+{
+    int fd = ::open(QFile::encodeName(flightPath).constData(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+    if (fd == -1)
+        return -1;
+
+    struct stat st;
+    FlightRecorderHeader header;
+    if (fstat(fd, &st) != 0 ||
+        st.st_size < (off_t)sizeof(header) ||
+        pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+        header.magic != FLIGHT_RECORDER_MAGIC ||
+        header.version != FLIGHT_RECORDER_VERSION ||
+        !header.sampleSize || !header.capacity ||
+        (header.capacity & (header.capacity - 1)) ||
+        (quint64)st.st_size < sizeof(header) + (quint64)header.capacity * header.sampleSize) {
+        sensordLogW() << flightPath << " is not a flight recorder file";
+        ::close(fd);
+        return -1;
+    }
+
+    size_t size = sizeof(header) + (size_t)header.capacity * header.sampleSize;
+    void* map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED)
+        return -1;
+    int count = dumpRing((const FlightRecorderHeader*)map, path);
+    munmap(map, size);
+    return count;
+}
+
+int FlightRecorder::dumpRing(const FlightRecorderHeader* header, const QString& path)
+{
+    if (QFile::exists(path)) {
+        sensordLogW() << "Flight recorder dump " << path << " exists";
+        return -1;
+    }
+
+    const char* slots = (const char*)header + sizeof(FlightRecorderHeader);
+    quint64 capacity = header->capacity;
+    quint64 mask = capacity - 1;
+    size_t sampleSize = header->sampleSize;
+
+    quint64 end = __atomic_load_n(&header->writeCount, __ATOMIC_ACQUIRE);
+    quint64 start = end > capacity ? end - capacity : 0;
+    QVector<char> copy((end - start) * sampleSize);
+    for (quint64 n = start; n < end; ++n)
+        memcpy(copy.data() + (n - start) * sampleSize, slots + (n & mask) * sampleSize, sampleSize);
+
+    // Slots the writer has reached in the meantime may hold newer
+    // samples or a torn copy, leave them out.
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    quint64 writeStart = __atomic_load_n(&header->writeStart, __ATOMIC_RELAXED);
+    quint64 valid = writeStart > capacity ? writeStart - capacity : 0;
+    quint64 skip = valid > start ? qMin(valid - start, end - start) : 0;
+
+    SampleRecorder recorder;
+    if (!recorder.open(path, header->type, header->sampleSize, header->interval))
+        return -1;
+    int count = (int)(end - start - skip);
+    if (count && !recorder.append(copy.constData() + skip * sampleSize, count))
+        return -1;
+    recorder.close();
+    return count;
+}
@@ -0,0 +1,177 @@
+/**
+   @file flightrecorder.h
+   @brief FlightRecorder
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+#include <QString>
+#include <string.h>
+
+/**
+ * Magic number at the beginning of a flight recorder file, "SFWF".
+ */
+const quint32 FLIGHT_RECORDER_MAGIC = 0x46574653;
+
+/**
+ * Version of the flight recorder layout.
+ */
+const quint32 FLIGHT_RECORDER_VERSION = 1;
+
+/**
+ * Header of a flight recorder file. A ring of capacity fixed size
+ * sample slots follows the header. Sample n is in slot
+ * n % capacity; the newest sample is writeCount - 1. Before writing
+ * slots the writer announces the samples in writeStart, so a reader can
+ * tell which of the slots it copied were being overwritten.
+ */
+struct FlightRecorderHeader
+{
+    quint32 magic;         /**< FLIGHT_RECORDER_MAGIC */
+    quint32 version;       /**< FLIGHT_RECORDER_VERSION */
+    quint32 type;          /**< SampleRecordingTypeId of the samples */
+    quint32 sampleSize;    /**< size of a single sample in bytes */
+    quint32 capacity;      /**< number of slots, a power of two */
+    quint32 interval;      /**< fastest sample interval in microseconds, 0 if unknown */
+    quint64 writeCount;    /**< samples written since the file was created */
+    quint64 writeStart;    /**< samples written or being written */
+    quint64 openMonotonic; /**< CLOCK_MONOTONIC at creation, microseconds */
+    quint64 openRealtime;  /**< CLOCK_REALTIME at creation, microseconds */
+    qint32  pid;           /**< sensord process which wrote the file */
+    quint32 reserved;      /**< zero */
+};
+
+/**
+ * Always-on recorder of the latest samples of a buffer, meant for
+ * finding out afterwards what the hardware delivered when a problem
+ * was reported. Unlike SampleRecorder it never grows: samples go into a
+ * fixed ring in a memory mapped file, which costs a copy of each sample
+ * and two counter stores per batch. The file is shared, so its contents
+ * survive a crash of sensord. An existing file is moved aside with a
+ * <tt>.prev</tt> suffix when reopened, keeping the samples which led to
+ * the previous exit.
+ *
+ * Only one thread may append at a time. #dump() may run concurrently
+ * with the writer.
+ */
+class FlightRecorder
+{
+public:
+    /**
+     * Constructor.
+     */
+    FlightRecorder();
+
+    /**
+     * Destructor. Closes the file, keeping its contents.
+     */
+    ~FlightRecorder();
+
+    /**
+     * Create flight recorder file.
+     *
+     * @param path recorder file.
+     * @param type SampleRecordingTypeId of the samples.
+     * @param sampleSize size of a single sample in bytes.
+     * @param capacity number of samples kept, rounded up to a power of two.
+     * @param interval fastest sample interval in microseconds, 0 if unknown.
+     * @return was the file created.
+     */
+    bool open(const QString& path, quint32 type, quint32 sampleSize, quint32 capacity, quint32 interval);
+
+    /**
+     * Close the file. Its contents are kept.
+     */
+    void close();
+
+    /**
+     * Is recorder open.
+     *
+     * @return is recorder open.
+     */
+    bool isOpen() const { return header_ != NULL; }
+
+    /**
+     * Path of the recorder file.
+     *
+     * @return path given to #open().
+     */
+    const QString& path() const { return path_; }
+
+    /**
+     * Store samples into the ring.
+     *
+     * @param samples samples to store.
+     * @param count number of samples.
+     */
+    void append(const void* samples, unsigned int count)
+    {
+        const char* in = (const char*)samples;
+        quint64 writeCount = header_->writeCount;
+        __atomic_store_n(&header_->writeStart, writeCount + count, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        for (unsigned int i = 0; i < count; ++i, in += sampleSize_)
+            memcpy(slots_ + ((writeCount + i) & mask_) * sampleSize_, in, sampleSize_);
+        __atomic_store_n(&header_->writeCount, writeCount + count, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * Write the samples currently in the ring into a sample recording
+     * (see SampleRecorder), oldest first.
+     *
+     * @param path recording file, must not exist.
+     * @return number of samples written, -1 on failure.
+     */
+    int dump(const QString& path) const;
+
+    /**
+     * Write the samples of a flight recorder file, for example one left
+     * behind by a previous run, into a sample recording.
+     *
+     * @param flightPath flight recorder file.
+     * @param path recording file, must not exist.
+     * @return number of samples written, -1 on failure.
+     */
+    static int dumpFile(const QString& flightPath, const QString& path);
+
+private:
+    Q_DISABLE_COPY(FlightRecorder)
+
+    /**
+     * Copy samples from a mapped ring into a recording. Samples which
+     * the writer overwrote while they were copied are left out.
+     *
+     * @param header mapped flight recorder file.
+     * @param path recording file.
+     * @return number of samples written, -1 on failure.
+     */
+    static int dumpRing(const FlightRecorderHeader* header, const QString& path);
+
+    QString               path_;       /**< recorder file */
+    FlightRecorderHeader* header_;     /**< mapped file or NULL */
+    char*                 slots_;      /**< first slot */
+    size_t                mapSize_;    /**< size of the mapping */
+    quint64               mask_;       /**< capacity - 1 */
+    size_t                sampleSize_; /**< size of a slot */
+};
+
+#endif // FLIGHTRECORDER_H
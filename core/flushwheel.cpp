@@ -0,0 +1,215 @@
+/**
+   @file flushwheel.cpp
+   @brief FlushWheel
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "flushwheel.h"
+
+FlushWheel::FlushWheel(unsigned int tick, QObject* parent) :
+    QObject(parent),
+    slots_(SLOTS, NULL),
+    tick_(tick ? tick : 1),
+    alignment_(0),
+    count_(0),
+    processed_(0),
+    armed_(0)
+{
+    clock_.start();
+    // Timer follows the wheel to another thread.
+    timer_.setParent(this);
+    timer_.setSingleShot(true);
+    connect(&timer_, SIGNAL(timeout()), this, SLOT(advance()));
+}
+
+FlushWheel::~FlushWheel()
+{
+    for (int i = 0; i < SLOTS; ++i)
+    {
+        while (slots_.at(i))
+            unlink(slots_.at(i));
+    }
+}
+
+quint64 FlushWheel::now() const
+{
+    return (quint64)clock_.elapsed() / tick_;
+}
+
+void FlushWheel::link(Entry* entry)
+{
+    Entry*& head = slots_[entry->expiry_ % SLOTS];
+    entry->prev_ = NULL;
+    entry->next_ = head;
+    if (head)
+        head->prev_ = entry;
+    head = entry;
+    entry->scheduled_ = true;
+    ++count_;
+}
+
+void FlushWheel::unlink(Entry* entry)
+{
+    if (entry->prev_)
+        entry->prev_->next_ = entry->next_;
+    else
+        slots_[entry->expiry_ % SLOTS] = entry->next_;
+    if (entry->next_)
+        entry->next_->prev_ = entry->prev_;
+    entry->prev_ = NULL;
+    entry->next_ = NULL;
+    entry->scheduled_ = false;
+    --count_;
+}
+
+void FlushWheel::setAlignment(unsigned int alignment)
+{
+    alignment_ = (alignment + tick_ - 1) / tick_;
+}
+
+quint64 FlushWheel::coalesce(quint64 earliest, quint64 latest) const
+{
+    if (latest > earliest + SLOTS - 1)
+        latest = earliest + SLOTS - 1;
+
+    // A tick which wakes up anyway is the cheapest.
+    if (armed_ >= earliest && armed_ <= latest)
+        return armed_;
+    for (quint64 tick = earliest; tick <= latest; ++tick)
+    {
+        for (const Entry* entry = slots_.at(tick % SLOTS); entry; entry = entry->next_)
+        {
+            if (entry->expiry_ == tick)
+                return tick;
+        }
+    }
+
+    if (alignment_ > 1)
+    {
+        quint64 aligned = (earliest + alignment_ - 1) / alignment_ * alignment_;
+        if (aligned <= latest)
+            return aligned;
+    }
+    return earliest;
+}
+
+void FlushWheel::schedule(Entry* entry, unsigned int delay, unsigned int slack)
+{
+    if (entry->scheduled_)
+        unlink(entry);
+
+    quint64 current = now();
+    if (processed_ < current && !count_)
+        processed_ = current;
+
+    // Round up so that the deadline is never early.
+    quint64 deadline = (quint64)clock_.elapsed() + delay;
+    quint64 earliest = (deadline + tick_ - 1) / tick_;
+    if (earliest <= processed_)
+        earliest = processed_ + 1;
+    quint64 latest = (deadline + slack) / tick_;
+    entry->expiry_ = latest > earliest ? coalesce(earliest, latest) : earliest;
+    link(entry);
+
+    if (!armed_ || entry->expiry_ < armed_)
+        arm();
+}
+
+void FlushWheel::cancel(Entry* entry)
+{
+    if (!entry->scheduled_)
+        return;
+    unlink(entry);
+    if (!count_)
+    {
+        timer_.stop();
+        armed_ = 0;
+    }
+}
+
+void FlushWheel::advance()
+{
+    armed_ = 0;
+    quint64 current = now();
+
+    // Slots are visited at most once, even after a long stall.
+    quint64 last = current;
+    if (last - processed_ > SLOTS)
+        processed_ = last - SLOTS;
+
+    while (processed_ < last)
+    {
+        ++processed_;
+        Entry* entry = slots_.at(processed_ % SLOTS);
+        while (entry)
+        {
+            Entry* next = entry->next_;
+            if (entry->expiry_ <= current)
+            {
+                unlink(entry);
+                entry->expired();
+                // The callback may have rescheduled or cancelled the
+                // remaining entries of the slot.
+                next = slots_.at(processed_ % SLOTS);
+            }
+            entry = next;
+        }
+    }
+    arm();
+}
+
+void FlushWheel::arm()
+{
+    if (!count_)
+    {
+        timer_.stop();
+        armed_ = 0;
+        return;
+    }
+
+    // Entries within one revolution are found in their own slot.
+    quint64 next = 0;
+    for (quint64 tick = processed_ + 1; tick <= processed_ + SLOTS && !next; ++tick)
+    {
+        for (Entry* entry = slots_.at(tick % SLOTS); entry; entry = entry->next_)
+        {
+            if (entry->expiry_ == tick)
+            {
+                next = tick;
+                break;
+            }
+        }
+    }
+    if (!next)
+    {
+        for (int i = 0; i < SLOTS; ++i)
+        {
+            for (Entry* entry = slots_.at(i); entry; entry = entry->next_)
+            {
+                if (!next || entry->expiry_ < next)
+                    next = entry->expiry_;
+            }
+        }
+    }
+
+    armed_ = next;
+    qint64 delay = (qint64)(next * tick_) - clock_.elapsed();
+    timer_.start(delay > 0 ? (int)delay : 0);
+}
@@ -0,0 +1,178 @@
+/**
+   @file flushwheel.h
+   @brief FlushWheel
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef FLUSHWHEEL_H
+#define FLUSHWHEEL_H
+
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+#include <QElapsedTimer>
+
+/**
+ * Timer wheel driving the delayed writes of all sessions with a single
+ * QTimer. Time is divided into ticks and every deadline is rounded up
+ * to a tick, so deadlines falling into the same tick expire with one
+ * wake-up. Entries are kept in intrusive lists in a ring of slots,
+ * indexed by their expiry tick; deadlines further than one revolution
+ * away share the slots and are skipped until their tick comes. The
+ * timer is only armed for the next tick with an entry, never for empty
+ * ticks.
+ *
+ * Scheduling and cancelling do not allocate, and are only done from
+ * the main thread.
+ */
+class FlushWheel : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(FlushWheel)
+
+public:
+    /**
+     * Entry which can be scheduled to the wheel.
+     */
+    class Entry
+    {
+    public:
+        Entry() : prev_(NULL), next_(NULL), expiry_(0), scheduled_(false) {}
+        virtual ~Entry() {}
+
+        /**
+         * Called from the wheel when the deadline has passed. Entry is no
+         * longer scheduled.
+         */
+        virtual void expired() = 0;
+
+    private:
+        friend class FlushWheel;
+
+        Entry*  prev_;      /**< previous entry in the slot */
+        Entry*  next_;      /**< next entry in the slot */
+        quint64 expiry_;    /**< expiry tick */
+        bool    scheduled_; /**< is entry in the wheel */
+    };
+
+    /**
+     * Constructor.
+     *
+     * @param tick tick length in milliseconds.
+     * @param parent parent object.
+     */
+    FlushWheel(unsigned int tick, QObject* parent = 0);
+
+    /**
+     * Destructor. Scheduled entries are left unscheduled.
+     */
+    ~FlushWheel();
+
+    /**
+     * Schedule entry to expire after given delay. A scheduled entry is
+     * rescheduled. With slack the entry may expire up to slack
+     * milliseconds late: it joins the first tick within the slack which
+     * already has an entry, or else the first tick on the alignment
+     * grid within the slack, so entries of different sessions and
+     * sensors share wake-ups.
+     *
+     * @param entry entry.
+     * @param delay delay in milliseconds.
+     * @param slack allowed extra delay in milliseconds.
+     */
+    void schedule(Entry* entry, unsigned int delay, unsigned int slack = 0);
+
+    /**
+     * Set the alignment grid for slack. Deadlines moved by their slack
+     * land on multiples of the alignment, counted from the creation of
+     * the wheel.
+     *
+     * @param alignment alignment in milliseconds, 0 for none.
+     */
+    void setAlignment(unsigned int alignment);
+
+    /**
+     * Remove entry from the wheel. Does nothing if entry is not
+     * scheduled.
+     *
+     * @param entry entry.
+     */
+    void cancel(Entry* entry);
+
+    /**
+     * Is entry scheduled.
+     *
+     * @param entry entry.
+     * @return is entry waiting for its deadline.
+     */
+    static bool isScheduled(const Entry* entry) { return entry->scheduled_; }
+
+    /**
+     * Tick length.
+     *
+     * @return tick length in milliseconds.
+     */
+    unsigned int tick() const { return tick_; }
+
+private Q_SLOTS:
+    /**
+     * Expire entries whose tick has passed and arm the timer for the
+     * next one.
+     */
+    void advance();
+
+private:
+    /**
+     * Current tick.
+     *
+     * @return ticks since the wheel was created.
+     */
+    quint64 now() const;
+
+    /**
+     * Arm the timer for the earliest scheduled entry, or stop it.
+     */
+    void arm();
+
+    /**
+     * Pick the expiry tick within the slack of a deadline.
+     *
+     * @param earliest first tick the entry may expire at.
+     * @param latest last tick the entry may expire at.
+     * @return expiry tick.
+     */
+    quint64 coalesce(quint64 earliest, quint64 latest) const;
+
+    void link(Entry* entry);
+    void unlink(Entry* entry);
+
+    static const int SLOTS = 256;
+
+    QVector<Entry*> slots_;     /**< first entry of each slot */
+    unsigned int    tick_;      /**< tick length in milliseconds */
+    unsigned int    alignment_; /**< alignment grid in ticks, 0 for none */
+    int             count_;     /**< number of scheduled entries */
+    quint64         processed_; /**< last tick processed */
+    quint64         armed_;     /**< tick the timer is armed for, 0 if not armed */
+    QElapsedTimer   clock_;     /**< monotonic clock */
+    QTimer          timer_;     /**< the wake-up timer */
+};
+
+#endif // FLUSHWHEEL_H
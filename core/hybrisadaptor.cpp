@@ -20,14 +20,33 @@
 
 #include "hybrisadaptor.h"
 #include "deviceadaptor.h"
+#include "threadscheduling.h"
+#include "config.h"
+#include "capabilitycache.h"
 
 #include <QDebug>
 #include <QCoreApplication>
 #include <QTimer>
+#include <QVector>
+#include <QDataStream>
 
 #include <android/hardware/hardware.h>
 #include <android/hardware/sensors.h>
 
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#ifndef ASHMEM_SET_SIZE
+#define ASHMEM_NAME_LEN 256
+#define ASHMEM_SET_NAME _IOW(0x77, 1, char[ASHMEM_NAME_LEN])
+#define ASHMEM_SET_SIZE _IOW(0x77, 3, size_t)
+#endif
+
 #ifndef SENSOR_TYPE_ACCELEROMETER
 #define SENSOR_TYPE_ACCELEROMETER (1)
 #endif
@@ -68,11 +87,17 @@
 #define SENSOR_TYPE_AMBIENT_TEMPERATURE (13)
 #endif
 //#define SENSOR_TYPE_MAGNETIC_FIELD_UNCALIBRATED (14)
-//#define SENSOR_TYPE_GAME_ROTATION_VECTOR (15)
+#ifndef SENSOR_TYPE_GAME_ROTATION_VECTOR
+#define SENSOR_TYPE_GAME_ROTATION_VECTOR (15)
+#endif
 //#define SENSOR_TYPE_GYROSCOPE_UNCALIBRATED (16)
-//#define SENSOR_TYPE_SIGNIFICANT_MOTION (17)
+#ifndef SENSOR_TYPE_SIGNIFICANT_MOTION
+#define SENSOR_TYPE_SIGNIFICANT_MOTION (17)
+#endif
 //#define SENSOR_TYPE_STEP_DETECTOR (18)
-//#define SENSOR_TYPE_STEP_COUNTER (19)
+#ifndef SENSOR_TYPE_STEP_COUNTER
+#define SENSOR_TYPE_STEP_COUNTER (19)
+#endif
 //#define SENSOR_TYPE_GEOMAGNETIC_ROTATION_VECTOR (20)
 
 static QHash<QString,int> HybrisAdaptor_sensorTypes()
@@ -88,19 +113,71 @@ static QHash<QString,int> HybrisAdaptor_sensorTypes()
     types["proximity"] = SENSOR_TYPE_PROXIMITY;
     types["gravity"] = SENSOR_TYPE_GRAVITY;
     types["lacceration"] = SENSOR_TYPE_LINEAR_ACCELERATION;
+    types["rotationvector"] = SENSOR_TYPE_ROTATION_VECTOR;
+    types["gamerotationvector"] = SENSOR_TYPE_GAME_ROTATION_VECTOR;
+    types["stepcounter"] = SENSOR_TYPE_STEP_COUNTER;
     return types;
 }
 
 Q_GLOBAL_STATIC(HybrisManager, hybrisManager)
 
+/**
+ * Opens the HAL in a pool thread while adaptors are set up from the
+ * cached sensor list.
+ */
+class HybrisManager::InitTask : public WorkerPool::Task
+{
+public:
+    InitTask(HybrisManager* manager) : manager_(manager) {}
+
+    void run()
+    {
+        manager_->init();
+        sensors = manager_->halSensors();
+        manager_->halOpened_.release();
+    }
+
+    QVector<HybrisManager::SensorInfo> sensors; /**< sensors listed by the HAL */
+
+private:
+    HybrisManager* manager_;
+};
+
+static QByteArray halValidator()
+{
+    QStringList files = Config::configuration()->value<QStringList>("hybris/capability_files",
+                                                                    QStringList() << "/system/build.prop" << "/vendor/build.prop");
+    return CapabilityCache::fileStamp(files);
+}
+
 HybrisManager::HybrisManager(QObject *parent) :
     QObject(parent),
+    device(NULL),
+    sensorList(NULL),
+    module(NULL),
     adaptorReader(parent),
     sensorsCount(0),
-    sensorsOpened(0)
+    deviceVersion_(0),
+    halReady_(false),
+    initTask_(NULL),
+    sensorsOpened(0),
+    dispatchTable_(0),
+    activeDispatches_(0)
 {
     qDebug() << Q_FUNC_INFO;
+    if (loadCachedSensors()) {
+        // Sensors are known from an earlier boot, open the HAL while
+        // adaptors and channels are set up.
+        initTask_ = new InitTask(this);
+        WorkerPool::instance().submit(initTask_);
+        return;
+    }
     init();
+    setSensors(halSensors());
+    if (device)
+        deviceVersion_ = device->common.version;
+    halReady_ = true;
+    storeCachedSensors();
 }
 
 HybrisManager *HybrisManager::instance()
@@ -126,44 +203,151 @@ void HybrisManager::init()
     }
 
     sensorsCount = module->get_sensors_list(module, &sensorList);
+    qDebug() << Q_FUNC_INFO;
+}
 
-    for (int i = 0 ; i < sensorsCount ; i++) {
-        sensorMap.insert(sensorList[i].type, i);
+QVector<HybrisManager::SensorInfo> HybrisManager::halSensors() const
+{
+    QVector<SensorInfo> sensors(sensorList ? sensorsCount : 0);
+    for (int i = 0; i < sensors.size(); i++) {
+        sensors[i].type = sensorList[i].type;
+        sensors[i].handle = sensorList[i].handle;
+        sensors[i].maxRange = sensorList[i].maxRange;
+        sensors[i].minDelay = sensorList[i].minDelay;
+        sensors[i].resolution = sensorList[i].resolution;
+#ifdef SENSORS_DEVICE_API_VERSION_1_1
+        if (device && device->common.version >= SENSORS_DEVICE_API_VERSION_1_1)
+            sensors[i].fifoMaxEventCount = sensorList[i].fifoMaxEventCount;
+#endif
+#ifdef SENSORS_DEVICE_API_VERSION_1_4
+        if (device && device->common.version >= SENSORS_DEVICE_API_VERSION_1_4)
+            sensors[i].flags = sensorList[i].flags;
+#endif
     }
-    qDebug() << Q_FUNC_INFO;
+    return sensors;
+}
+
+void HybrisManager::setSensors(const QVector<SensorInfo>& sensors)
+{
+    sensorInfo_ = sensors;
+    sensorMap.clear();
+    for (int i = 0 ; i < sensorInfo_.size() ; i++) {
+        sensorMap.insert(sensorInfo_[i].type, i);
+    }
+}
+
+bool HybrisManager::loadCachedSensors()
+{
+    CapabilityCache& cache = CapabilityCache::instance();
+    QByteArray validator = halValidator();
+    QVariant version = cache.value("hybris", validator, "device_version");
+    QByteArray data = cache.value("hybris", validator, "sensors").toByteArray();
+    if (!version.isValid() || data.isEmpty())
+        return false;
+
+    QDataStream in(data);
+    quint32 count;
+    in >> count;
+    QVector<SensorInfo> sensors;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+        SensorInfo info;
+        in >> info.type >> info.handle >> info.maxRange >> info.minDelay
+           >> info.resolution >> info.fifoMaxEventCount >> info.flags;
+        sensors.append(info);
+    }
+    if (in.status() != QDataStream::Ok)
+        return false;
+
+    setSensors(sensors);
+    deviceVersion_ = version.toUInt();
+    qDebug() << Q_FUNC_INFO << "using" << sensors.size() << "cached sensors";
+    return true;
+}
+
+void HybrisManager::storeCachedSensors()
+{
+    if (!device)
+        return;
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out << (quint32)sensorInfo_.size();
+    foreach (const SensorInfo& info, sensorInfo_) {
+        out << info.type << info.handle << info.maxRange << info.minDelay
+            << info.resolution << info.fifoMaxEventCount << info.flags;
+    }
+
+    CapabilityCache& cache = CapabilityCache::instance();
+    QByteArray validator = halValidator();
+    cache.setValue("hybris", validator, "device_version", deviceVersion_);
+    cache.setValue("hybris", validator, "sensors", data);
+}
+
+bool HybrisManager::waitForHal()
+{
+    QMutexLocker locker(&halMutex_);
+    if (!halReady_) {
+        halOpened_.acquire();
+        halReady_ = true;
+
+        QVector<SensorInfo> sensors = initTask_->sensors;
+        delete initTask_;
+        initTask_ = NULL;
+        quint32 version = device ? device->common.version : 0;
+        bool changed = version != deviceVersion_ || sensors.size() != sensorInfo_.size();
+        for (int i = 0; !changed && i < sensors.size(); i++) {
+            changed = memcmp(&sensors[i], &sensorInfo_[i], sizeof(SensorInfo)) != 0;
+        }
+        if (device && changed) {
+            // Adaptors already set up keep the cached values until
+            // sensord is restarted.
+            qWarning() << "HAL sensors differ from the capability cache, updating it";
+            deviceVersion_ = version;
+            setSensors(sensors);
+            storeCachedSensors();
+        }
+    }
+    return device != NULL;
+}
+
+bool HybrisManager::hasSensor(int sensorType) const
+{
+    return sensorMap.contains(sensorType);
 }
 
 int HybrisManager::handleForType(int sensorType)
 {
     if (sensorMap.contains(sensorType))
-        return sensorList[sensorMap[sensorType]].handle;
+        return sensorInfo_[sensorMap[sensorType]].handle;
     return 0;
 }
 
 int HybrisManager::maxRange(int sensorType)
 {
     if (sensorMap.contains(sensorType))
-        return sensorList[sensorMap[sensorType]].maxRange;
+        return sensorInfo_[sensorMap[sensorType]].maxRange;
     return 0;
 }
 
 int HybrisManager::minDelay(int sensorType)
 {
     if (sensorMap.contains(sensorType))
-        return sensorList[sensorMap[sensorType]].minDelay;
+        return sensorInfo_[sensorMap[sensorType]].minDelay;
     return 0;
 }
 
 int HybrisManager::resolution(int sensorType)
 {
     if (sensorMap.contains(sensorType))
-        return sensorList[sensorMap[sensorType]].resolution;
+        return sensorInfo_[sensorMap[sensorType]].resolution;
     return 0;
 }
 
-bool HybrisManager::setDelay(int sensorHandle, int interval)
+bool HybrisManager::setDelay(int sensorHandle, qint64 interval)
 {
     qDebug() << Q_FUNC_INFO;
+    if (!waitForHal())
+        return false;
     int result = device->setDelay(device, sensorHandle, interval);
     if (result < 0) {
         qDebug() << "setDelay() failed" << strerror(-result);
@@ -172,21 +356,83 @@ bool HybrisManager::setDelay(int sensorHandle, int interval)
     return true;
 }
 
+bool HybrisManager::hasBatching() const
+{
+#ifdef SENSORS_DEVICE_API_VERSION_1_0
+    return deviceVersion_ >= SENSORS_DEVICE_API_VERSION_1_0;
+#else
+    return false;
+#endif
+}
+
+int HybrisManager::fifoMaxEventCount(int sensorType)
+{
+#ifdef SENSORS_DEVICE_API_VERSION_1_1
+    if (sensorMap.contains(sensorType) && deviceVersion_ >= SENSORS_DEVICE_API_VERSION_1_1)
+        return sensorInfo_[sensorMap[sensorType]].fifoMaxEventCount;
+#else
+    Q_UNUSED(sensorType);
+#endif
+    return 0;
+}
+
+bool HybrisManager::batch(int sensorHandle, qint64 periodNs, qint64 latencyNs)
+{
+#ifdef SENSORS_DEVICE_API_VERSION_1_0
+    if (hasBatching() && waitForHal()) {
+        sensors_poll_device_1_t* device1 = (sensors_poll_device_1_t*)device;
+        int result = device1->batch(device1, sensorHandle, 0, periodNs, latencyNs);
+        if (result < 0) {
+            qDebug() << "batch() failed" << strerror(-result);
+            return false;
+        }
+        return true;
+    }
+#else
+    Q_UNUSED(sensorHandle);
+    Q_UNUSED(periodNs);
+    Q_UNUSED(latencyNs);
+#endif
+    return false;
+}
+
+bool HybrisManager::flush(int sensorHandle)
+{
+#ifdef SENSORS_DEVICE_API_VERSION_1_1
+    if (waitForHal() && device->common.version >= SENSORS_DEVICE_API_VERSION_1_1) {
+        sensors_poll_device_1_t* device1 = (sensors_poll_device_1_t*)device;
+        int result = device1->flush(device1, sensorHandle);
+        if (result < 0) {
+            qDebug() << "flush() failed" << strerror(-result);
+            return false;
+        }
+        return true;
+    }
+#else
+    Q_UNUSED(sensorHandle);
+#endif
+    return false;
+}
+
 void HybrisManager::startReader(HybrisAdaptor *adaptor)
 {
     qDebug() << Q_FUNC_INFO;
-    if (registeredAdaptors.values().contains(adaptor)) {
+    if (registeredAdaptors.values().contains(adaptor) && waitForHal()) {
         int error = device->activate(device, adaptor->sensorHandle, 1);
         if (error != 0) {
             qDebug() <<Q_FUNC_INFO<< "failed for"<< strerror(-error);
         }
-        if (!adaptorReader.isRunning())
-            adaptorReader.startReader();
+        rebuildDispatchTable();
+        adaptorReader.startReader();
     }
 }
 
 void HybrisManager::stopReader(HybrisAdaptor *adaptor)
 {
+    if (!waitForHal())
+        return;
+    rebuildDispatchTable();
+
     QList <HybrisAdaptor *> list;
     list = registeredAdaptors.values();
     bool okToStop = true;
@@ -195,8 +441,16 @@ void HybrisManager::stopReader(HybrisAdaptor *adaptor)
         if (list.at(i) != adaptor && list.at(i)->isRunning())
             okToStop = false;
     }
+    // Wake on motion only makes sense while the adaptor is running.
+    setMotionWakeup(adaptor, false);
+
     if (okToStop) {
         adaptorReader.stopReader();
+        // Flush completion event wakes the reader out of poll(), so it
+        // does not wait for the next sample that never comes. Without
+        // flush support the thread exits on the next event or is reused
+        // by the next start.
+        flush(adaptor->sensorHandle);
         int error = device->activate(device, adaptor->sensorHandle, 0);
         if (error != 0) {
             qDebug() <<Q_FUNC_INFO<< "failed for"<< strerror(-error);
@@ -206,6 +460,8 @@ void HybrisManager::stopReader(HybrisAdaptor *adaptor)
 
 bool HybrisManager::openSensors()
 {
+    if (!waitForHal())
+        return false;
     if (!sensorsOpened) {
         int errorCode = sensors_open(&module->common, &device);
         if (errorCode != 0) {
@@ -218,6 +474,8 @@ bool HybrisManager::openSensors()
 
 bool HybrisManager::closeSensors()
 {
+    if (!waitForHal())
+        return false;
     if (sensorsOpened) { //TODO
         int errorCode = sensors_close(device);
         if (errorCode != 0) {
@@ -228,23 +486,184 @@ bool HybrisManager::closeSensors()
     return true;
 }
 
-void HybrisManager::processSample(const sensors_event_t& data)
+void HybrisManager::processEvents(const sensors_event_t* events, int count)
 {
+    activeDispatches_.fetchAndAddOrdered(1);
+    const DispatchTable* table = dispatchTable_.loadAcquire();
+    if (table) {
+        const int* first = table->first.constData();
+        HybrisAdaptor* const* adaptors = table->adaptors.constData();
+        int types = table->first.size() - 1;
+
+        for (int i = 0; i < count; i++) {
+            int type = events[i].type;
+            if (type == SENSOR_TYPE_SIGNIFICANT_MOTION) {
+                // One-shot trigger, the HAL has already disarmed it.
+                for (int j = 0; j < table->adaptors.size(); j++) {
+                    if (adaptors[j]->motionWakeupArmed_.testAndSetOrdered(1, 0))
+                        device->activate(device, adaptors[j]->sensorHandle, 1);
+                }
+                continue;
+            }
+            if (type < 0 || type >= types)
+                continue;
+            for (int j = first[type]; j < first[type + 1]; j++) {
+                adaptors[j]->processSample(events[i]);
+                adaptors[j]->pendingWakeup_ = true;
+            }
+        }
 
-    if (registeredAdaptors.contains(data.type)) {
-        QList <HybrisAdaptor *> list;
-        list = registeredAdaptors.values(data.type);
-        for (int i = 0; i < list.count(); i++){
-            if (list.at(i)->isRunning())
-                list.at(i)->processSample(data);
+        for (int j = 0; j < table->adaptors.size(); j++) {
+            if (adaptors[j]->pendingWakeup_) {
+                adaptors[j]->pendingWakeup_ = false;
+                adaptors[j]->wakeUpReaders();
+            }
         }
     }
+    activeDispatches_.fetchAndAddOrdered(-1);
+}
+
+int HybrisManager::directReportLevel(int sensorType)
+{
+#ifdef SENSORS_DEVICE_API_VERSION_1_4
+    if (sensorMap.contains(sensorType) && deviceVersion_ >= SENSORS_DEVICE_API_VERSION_1_4) {
+        const SensorInfo& sensor = sensorInfo_[sensorMap[sensorType]];
+        if (sensor.flags & SENSOR_FLAG_DIRECT_CHANNEL_ASHMEM)
+            return (sensor.flags & SENSOR_FLAG_MASK_DIRECT_REPORT) >> SENSOR_FLAG_SHIFT_DIRECT_REPORT;
+    }
+#else
+    Q_UNUSED(sensorType);
+#endif
+    return 0;
+}
+
+int HybrisManager::registerDirectChannel(int fd, size_t size)
+{
+#ifdef SENSORS_DEVICE_API_VERSION_1_4
+    if (waitForHal() && device->common.version >= SENSORS_DEVICE_API_VERSION_1_4) {
+        sensors_poll_device_1_t* device1 = (sensors_poll_device_1_t*)device;
+        native_handle_t* handle = (native_handle_t*)malloc(sizeof(native_handle_t) + sizeof(int));
+        handle->version = sizeof(native_handle_t);
+        handle->numFds = 1;
+        handle->numInts = 0;
+        handle->data[0] = fd;
+
+        sensors_direct_mem_t mem;
+        mem.type = SENSOR_DIRECT_MEM_TYPE_ASHMEM;
+        mem.format = SENSOR_DIRECT_FMT_SENSORS_EVENT;
+        mem.size = size;
+        mem.handle = handle;
+        int result = device1->register_direct_channel(device1, &mem, 0);
+        free(handle);
+        if (result <= 0) {
+            qDebug() << "register_direct_channel() failed" << strerror(-result);
+            return -1;
+        }
+        return result;
+    }
+#else
+    Q_UNUSED(fd);
+    Q_UNUSED(size);
+#endif
+    return -1;
+}
+
+void HybrisManager::unregisterDirectChannel(int channel)
+{
+#ifdef SENSORS_DEVICE_API_VERSION_1_4
+    if (waitForHal() && device->common.version >= SENSORS_DEVICE_API_VERSION_1_4) {
+        sensors_poll_device_1_t* device1 = (sensors_poll_device_1_t*)device;
+        device1->register_direct_channel(device1, NULL, channel);
+    }
+#else
+    Q_UNUSED(channel);
+#endif
+}
+
+bool HybrisManager::configDirectReport(int handle, int channel, int level)
+{
+#ifdef SENSORS_DEVICE_API_VERSION_1_4
+    if (waitForHal() && device->common.version >= SENSORS_DEVICE_API_VERSION_1_4) {
+        sensors_poll_device_1_t* device1 = (sensors_poll_device_1_t*)device;
+        sensors_direct_cfg_t config;
+        config.rate_level = level;
+        int result = device1->config_direct_report(device1, handle, channel, &config);
+        if (result < 0) {
+            qDebug() << "config_direct_report() failed" << strerror(-result);
+            return false;
+        }
+        return true;
+    }
+#else
+    Q_UNUSED(handle);
+    Q_UNUSED(channel);
+    Q_UNUSED(level);
+#endif
+    return false;
+}
+
+bool HybrisManager::setMotionWakeup(HybrisAdaptor *adaptor, bool enabled)
+{
+    if (!sensorMap.contains(SENSOR_TYPE_SIGNIFICANT_MOTION))
+        return !enabled;
+    if (!waitForHal())
+        return false;
+    int motionHandle = handleForType(SENSOR_TYPE_SIGNIFICANT_MOTION);
+
+    if (enabled) {
+        if (!adaptor->isRunning())
+            return false;
+        int error = device->activate(device, motionHandle, 1);
+        if (error != 0) {
+            qDebug() << Q_FUNC_INFO << "failed for" << strerror(-error);
+            return false;
+        }
+        // Arm before deactivating so that a trigger is never missed.
+        adaptor->motionWakeupArmed_.fetchAndStoreOrdered(1);
+        device->activate(device, adaptor->sensorHandle, 0);
+        return true;
+    }
+
+    // Reader thread clears the flag when it has already reactivated.
+    if (adaptor->motionWakeupArmed_.fetchAndStoreOrdered(0)) {
+        device->activate(device, motionHandle, 0);
+        if (adaptor->isRunning())
+            device->activate(device, adaptor->sensorHandle, 1);
+    }
+    return true;
+}
+
+void HybrisManager::rebuildDispatchTable()
+{
+    DispatchTable* table = new DispatchTable;
+
+    int types = 0;
+    for (QMap<int, HybrisAdaptor *>::const_iterator it = registeredAdaptors.constBegin(); it != registeredAdaptors.constEnd(); ++it) {
+        if (it.value()->isRunning() && it.key() >= types)
+            types = it.key() + 1;
+    }
+
+    // QMap iterates in key order, so adaptors end up grouped by type.
+    table->first.fill(0, types + 1);
+    for (QMap<int, HybrisAdaptor *>::const_iterator it = registeredAdaptors.constBegin(); it != registeredAdaptors.constEnd(); ++it) {
+        if (!it.value()->isRunning())
+            continue;
+        table->adaptors.append(it.value());
+        for (int type = it.key() + 1; type <= types; type++)
+            table->first[type]++;
+    }
+
+    const DispatchTable* old = dispatchTable_.fetchAndStoreOrdered(table);
+    while (activeDispatches_.fetchAndAddOrdered(0))
+        QThread::yieldCurrentThread();
+    delete old;
 }
 
 void HybrisManager::registerAdaptor(HybrisAdaptor *adaptor)
 {
     if (!registeredAdaptors.values().contains(adaptor)) {
         registeredAdaptors.insertMulti(adaptor->sensorType, adaptor);
+        rebuildDispatchTable();
     }
 }
 
@@ -254,7 +673,14 @@ HybrisAdaptor::HybrisAdaptor(const QString& id, int type)
       inStandbyMode_(0),
       running_(0),
       sensorType(type),
-      cachedInterval(50)
+      cachedInterval(50),
+      bufferSize_(0),
+      bufferInterval_(0),
+      appliedInterval_(0),
+      appliedLatency_(0),
+      displayOffLatency_(0),
+      pendingWakeup_(false),
+      motionWakeupArmed_(0)
 {
     if (!HybrisAdaptor_sensorTypes().values().contains(sensorType)) {
         qDebug() << Q_FUNC_INFO <<"no such sensor" << id;
@@ -269,6 +695,8 @@ HybrisAdaptor::HybrisAdaptor(const QString& id, int type)
 
 HybrisAdaptor::~HybrisAdaptor()
 {
+    foreach (int sessionId, directChannels_.keys())
+        destroyDirectChannel(sessionId);
 }
 
 void HybrisAdaptor::init()
@@ -371,13 +799,30 @@ void HybrisAdaptor::stopSensor()
 
 bool HybrisAdaptor::standby()
 {
-    return false;
-}
+    bool hwSupported = false;
+    IntegerRangeList range = getAvailableBufferIntervals(hwSupported);
+    if (!hwSupported || range.isEmpty())
+        return false;
+
+    unsigned int latency = 0;
+    Config* config = Config::configuration();
+    if (config)
+        latency = config->value<unsigned int>("global/display_off_batch_interval", 0);
+    latency = qMin(latency, range.first().second);
+    if (!latency || latency == displayOffLatency_)
+        return false;
 
+    sensordLogD() << "Display off, batching " << name() << " for " << latency << " ms";
+    displayOffLatency_ = latency;
+    return applyBatching();
+}
 
 bool HybrisAdaptor::resume()
 {
-    return false;
+    if (!displayOffLatency_)
+        return false;
+    displayOffLatency_ = 0;
+    return applyBatching();
 }
 
 unsigned int HybrisAdaptor::interval() const
@@ -386,21 +831,185 @@ unsigned int HybrisAdaptor::interval() const
 }
 
 bool HybrisAdaptor::setInterval(const unsigned int value, const int sessionId)
-{                     // 1000000
+{
+    Q_UNUSED(sessionId);
     cachedInterval = value;
+    // The sensor stays active and the reader keeps running, the HAL
+    // switches rate in place, so samples keep flowing across the change.
     bool ok;
-    qreal ns = value * 1000000; // ms to ns
-    ok = hybrisManager()->setDelay(sensorHandle, ns);
+    if (hybrisManager()->hasBatching()) {
+        ok = applyBatching();
+    } else if (value == appliedInterval_) {
+        ok = true;
+    } else {
+        ok = hybrisManager()->setDelay(sensorHandle, (qint64)value * 1000000);
+        if (ok)
+            appliedInterval_ = value;
+    }
     if (!ok) {
         qDebug() << Q_FUNC_INFO << "setInterval not ok";
     }
     return ok;
 }
 
+IntegerRangeList HybrisAdaptor::getAvailableBufferSizes(bool& hwSupported) const
+{
+    int fifoSize = hybrisManager()->fifoMaxEventCount(sensorType);
+    if (hybrisManager()->hasBatching() && fifoSize > 1) {
+        IntegerRangeList list;
+        list.push_back(IntegerRange(1, fifoSize));
+        hwSupported = true;
+        return list;
+    }
+    return DeviceAdaptor::getAvailableBufferSizes(hwSupported);
+}
+
+IntegerRangeList HybrisAdaptor::getAvailableBufferIntervals(bool& hwSupported) const
+{
+    if (hybrisManager()->hasBatching() && hybrisManager()->fifoMaxEventCount(sensorType) > 1) {
+        IntegerRangeList list;
+        list.push_back(IntegerRange(0, 60000));
+        hwSupported = true;
+        return list;
+    }
+    return DeviceAdaptor::getAvailableBufferIntervals(hwSupported);
+}
+
+unsigned int HybrisAdaptor::bufferCapacity(unsigned int minimum) const
+{
+    int fifoSize = hybrisManager()->fifoMaxEventCount(sensorType);
+    return DeviceAdaptor::bufferCapacity(qMax(minimum, (unsigned int)qMax(fifoSize, 0)));
+}
+
+unsigned int HybrisAdaptor::bufferSize() const
+{
+    return bufferSize_;
+}
+
+unsigned int HybrisAdaptor::bufferInterval() const
+{
+    return bufferInterval_;
+}
+
+bool HybrisAdaptor::setBufferSize(unsigned int value)
+{
+    bool hwSupported = false;
+    getAvailableBufferSizes(hwSupported);
+    if (!hwSupported)
+        return false;
+    bufferSize_ = value;
+    return applyBatching();
+}
+
+bool HybrisAdaptor::setBufferInterval(unsigned int value)
+{
+    bool hwSupported = false;
+    getAvailableBufferIntervals(hwSupported);
+    if (!hwSupported)
+        return false;
+    bufferInterval_ = value;
+    return applyBatching();
+}
+
+int HybrisAdaptor::createDirectChannel(int sessionId, unsigned int interval)
+{
+    int maxLevel = hybrisManager()->directReportLevel(sensorType);
+    if (!maxLevel)
+        return -1;
+
+    // Rate levels are nominally 50, 200 and 800 Hz.
+    int level = 3;
+    if (interval >= 20)
+        level = 1;
+    else if (interval >= 5)
+        level = 2;
+    level = qMin(level, maxLevel);
+
+    destroyDirectChannel(sessionId);
+
+    unsigned int events = Config::configuration()->value<unsigned int>(id() + "/direct_channel_events", 1024);
+    size_t size = qMax(1u, events) * sizeof(sensors_event_t);
+    int fd = open("/dev/ashmem", O_RDWR | O_CLOEXEC);
+    if (fd == -1) {
+        sensordLogW() << "Cannot open ashmem for direct channel of " << id() << ": " << strerror(errno);
+        return -1;
+    }
+    char name[ASHMEM_NAME_LEN] = {0,};
+    snprintf(name, sizeof(name), "sensord-direct-%d", sessionId);
+    ioctl(fd, ASHMEM_SET_NAME, name);
+    if (ioctl(fd, ASHMEM_SET_SIZE, size) < 0) {
+        sensordLogW() << "Cannot size direct channel of " << id() << ": " << strerror(errno);
+        close(fd);
+        return -1;
+    }
+
+    DirectChannel channel;
+    channel.fd = fd;
+    channel.handle = hybrisManager()->registerDirectChannel(fd, size);
+    if (channel.handle == -1) {
+        close(fd);
+        return -1;
+    }
+    if (!hybrisManager()->configDirectReport(sensorHandle, channel.handle, level)) {
+        hybrisManager()->unregisterDirectChannel(channel.handle);
+        close(fd);
+        return -1;
+    }
+    directChannels_.insert(sessionId, channel);
+    sensordLogD() << "Direct channel " << channel.handle << " of " << id() << " for session " << sessionId << " at rate level " << level;
+    return dup(fd);
+}
+
+void HybrisAdaptor::destroyDirectChannel(int sessionId)
+{
+    if (!directChannels_.contains(sessionId))
+        return;
+    DirectChannel channel = directChannels_.take(sessionId);
+    hybrisManager()->configDirectReport(sensorHandle, channel.handle, 0);
+    hybrisManager()->unregisterDirectChannel(channel.handle);
+    close(channel.fd);
+}
+
+unsigned int HybrisAdaptor::reportLatency() const
+{
+    unsigned int latency = 0;
+    if (bufferInterval_)
+        latency = bufferInterval_;
+    else if (bufferSize_ > 1)
+        latency = bufferSize_ * cachedInterval;
+    return qMax(latency, displayOffLatency_);
+}
+
+bool HybrisAdaptor::applyBatching()
+{
+    unsigned int latency = reportLatency();
+    // Some HALs restart the sensor and drop their FIFO on every batch(),
+    // so leave an unchanged configuration alone.
+    if (cachedInterval == appliedInterval_ && latency == appliedLatency_)
+        return true;
+
+    sensordLogD() << "Batching " << name() << ": interval " << cachedInterval << " ms, latency " << latency << " ms";
+    bool ok = hybrisManager()->batch(sensorHandle, (qint64)cachedInterval * 1000000, (qint64)latency * 1000000);
+    if (!ok && !latency) {
+        // Sensors without batching support in a 1.x HAL may refuse
+        // batch() but still take the rate the old way.
+        ok = hybrisManager()->setDelay(sensorHandle, (qint64)cachedInterval * 1000000);
+    }
+    // Deliver whatever the hub has buffered when batching is turned off.
+    if (ok && !latency && appliedLatency_ && running_)
+        hybrisManager()->flush(sensorHandle);
+    if (ok) {
+        appliedInterval_ = cachedInterval;
+        appliedLatency_ = latency;
+    }
+    return ok;
+}
+
 void HybrisAdaptor::stopReaderThread()
 {
-    hybrisManager()->stopReader(this);
+    // Clear running state first so the adaptor is left out of dispatching.
     running_ = false;
+    hybrisManager()->stopReader(this);
 }
 
 bool HybrisAdaptor::startReaderThread()
@@ -413,27 +1022,20 @@ bool HybrisAdaptor::startReaderThread()
 
 unsigned int HybrisAdaptor::evaluateIntervalRequests(int& sessionId) const
 {
-    if (m_intervalMap.size() == 0)
+    if (!hasIntervalRequests())
     {
         sessionId = -1;
         return defaultInterval();
     }
 
     // Get the smallest positive request, 0 is reserved for HW wakeup
-    QMap<int, unsigned int>::const_iterator it = m_intervalMap.constBegin();
-    unsigned int highestValue = it.value();
-    int winningSessionId = it.key();
-
-    for (++it; it != m_intervalMap.constEnd(); ++it)
+    unsigned int value = fastestIntervalRequest(sessionId, 1);
+    if (sessionId < 0)
     {
-        if (((it.value() < highestValue) && (it.value() > 0)) || highestValue == 0) {
-            highestValue = it.value();
-            winningSessionId = it.key();
-        }
+        fastestIntervalRequest(sessionId);
+        return defaultInterval();
     }
-
-    sessionId = winningSessionId;
-    return highestValue > 0 ? highestValue : defaultInterval();
+    return value;
 }
 
 /*/////////////////////////////////////////////////////////////////////
@@ -444,7 +1046,8 @@ unsigned int HybrisAdaptor::evaluateIntervalRequests(int& sessionId) const
 
 HybrisAdaptorReader::HybrisAdaptorReader(QObject *parent)
     : QThread(parent),
-    running_(false)
+    running_(false),
+    polling_(false)
 {
 }
 
@@ -453,39 +1056,72 @@ HybrisAdaptorReader::HybrisAdaptorReader(QObject *parent)
 ///
 void HybrisAdaptorReader::stopReader()
 {
+    QMutexLocker locker(&mutex_);
     running_ = false;
 }
 
 void HybrisAdaptorReader::startReader()
 {
+    QMutexLocker locker(&mutex_);
     running_ = true;
+    if (polling_)
+        return;
+
+    // Thread may have decided to exit but not finished yet.
+    locker.unlock();
+    wait();
+    locker.relock();
+    polling_ = true;
     start();
 }
 
+bool HybrisAdaptorReader::keepPolling()
+{
+    QMutexLocker locker(&mutex_);
+    if (!running_)
+        polling_ = false;
+    return polling_;
+}
+
 void HybrisAdaptorReader::run()
 {
-    int err;
-    static const size_t numEvents = 16;
-    sensors_event_t buffer[numEvents];
+    static const unsigned long maxBackoff = 1000;
+    // Large batches from the hub are taken in one call rather than
+    // split over several poll() round trips.
+    int numEvents = qBound(16, Config::configuration()->value<int>("global/hybris_poll_events", 64), 1024);
+    QVector<sensors_event_t> events(numEvents);
+    sensors_event_t* buffer = events.data();
+    unsigned long backoff = 0;
 
-    while (running_) {
+    ThreadScheduling::apply("hybrisreader");
+
+    while (keepPolling()) {
         int numberOfEvents = hybrisManager()->device->poll(hybrisManager()->device, buffer, numEvents);
         if (numberOfEvents < 0) {
-            sensordLogW() << "poll() failed" << strerror(-err);
-            QThread::msleep(1000);
+            sensordLogW() << "poll() failed" << strerror(-numberOfEvents);
+            // Retry at once first, then back off while the HAL keeps failing.
+            if (backoff)
+                QThread::msleep(backoff);
+            backoff = backoff ? qMin(backoff * 2, maxBackoff) : 10;
         } else {
+            backoff = 0;
             bool errorInInput = false;
 
             for (int i = 0; i < numberOfEvents; i++) {
                 const sensors_event_t& data = buffer[i];
 
+#ifdef SENSOR_TYPE_META_DATA
+                // Flush completions carry their own version.
+                if (data.type == SENSOR_TYPE_META_DATA)
+                    continue;
+#endif
                 if (data.version != sizeof(sensors_event_t)) {
                     sensordLogW()<< QString("incorrect event version (version=%1, expected=%2").arg(data.version).arg(sizeof(sensors_event_t));
                     errorInInput = true;
                 }
-                hybrisManager()->processSample(data);
-
             }
+            // Whole poll result is committed, pipeline is woken up once.
+            hybrisManager()->processEvents(buffer, numberOfEvents);
             if (errorInInput)
                 QThread::msleep(50);
         }
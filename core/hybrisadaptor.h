@@ -24,8 +24,14 @@
 #include <QObject>
 #include <QThread>
 #include <QTimer>
+#include <QVector>
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QMutex>
+#include <QSemaphore>
 
 #include "deviceadaptor.h"
+#include "workerpool.h"
 #include <android/hardware/sensors.h>
 
 class HybrisAdaptor;
@@ -40,7 +46,18 @@ public:
     HybrisAdaptorReader(QObject *parent);
 
     void run();
+
+    /**
+     * Let the reader thread exit after its current poll. The thread is
+     * blocked in the HAL until an event arrives, see
+     * HybrisManager::stopReader() for waking it up.
+     */
     void stopReader();
+
+    /**
+     * Start the reader thread, or keep it running if it has not seen a
+     * stop request yet. Waits for a thread which is already exiting.
+     */
     void startReader();
     void setDevice();
 
@@ -48,7 +65,16 @@ public:
     int sensorType;
 
 private:
-    bool running_;
+    /**
+     * Should the thread keep polling. Clears #polling_ when not.
+     *
+     * @return keep polling.
+     */
+    bool keepPolling();
+
+    QMutex mutex_;   /**< protects running_ and polling_ */
+    bool running_;   /**< has reader been requested to run */
+    bool polling_;   /**< has thread not yet decided to exit */
 };
 
 
@@ -63,12 +89,24 @@ public:
     struct sensor_t const* sensorList;
     struct sensors_module_t* module;
 
+    /**
+     * Does the HAL provide a sensor of given type.
+     *
+     * @param sensorType sensor type.
+     * @return is sensor available.
+     */
+    bool hasSensor(int sensorType) const;
+
     int handleForType(int sensorType);
     int maxRange(int sensorType);
     int minDelay(int sensorType);
     int resolution(int sensorType);
 
-    bool setDelay(int handle, int interval);
+    bool setDelay(int handle, qint64 interval);
+    bool hasBatching() const;
+    int fifoMaxEventCount(int sensorType);
+    bool batch(int handle, qint64 periodNs, qint64 latencyNs);
+    bool flush(int handle);
     void startReader(HybrisAdaptor *adaptor);
     void stopReader(HybrisAdaptor *adaptor);
 
@@ -77,15 +115,149 @@ public:
 
     void registerAdaptor(HybrisAdaptor * adaptor);
 
-    void processSample(const sensors_event_t& data);
+    /**
+     * Dispatch events of one poll to the running adaptors and wake up
+     * readers of every adaptor that got samples. Called from the reader
+     * thread.
+     *
+     * @param events polled events.
+     * @param count number of events.
+     */
+    void processEvents(const sensors_event_t* events, int count);
+
+    /**
+     * Replace the sample stream of an adaptor with the significant
+     * motion trigger of the HAL, or return to streaming. When the
+     * trigger fires the adaptor sensor is reactivated from the reader
+     * thread, so samples resume without waiting for the main thread.
+     * @param adaptor running adaptor.
+     * @param enabled arm (\c true) or disarm (\c false) the trigger.
+     * @return was the request carried out. Fails to arm if the HAL has
+     *         no significant motion sensor.
+     */
+    bool setMotionWakeup(HybrisAdaptor *adaptor, bool enabled);
+
+    /**
+     * Highest direct report rate level of a sensor which can write into
+     * ashmem direct channels.
+     *
+     * @param sensorType sensor type.
+     * @return rate level, 0 when direct report is not supported.
+     */
+    int directReportLevel(int sensorType);
+
+    /**
+     * Register ashmem region as a direct channel.
+     *
+     * @param fd ashmem file descriptor.
+     * @param size region size in bytes.
+     * @return channel handle, or -1 on failure.
+     */
+    int registerDirectChannel(int fd, size_t size);
+
+    /**
+     * Unregister direct channel. Reports into it are stopped.
+     *
+     * @param channel channel handle.
+     */
+    void unregisterDirectChannel(int channel);
+
+    /**
+     * Start, change or stop reports of a sensor into a direct channel.
+     *
+     * @param handle sensor handle.
+     * @param channel channel handle.
+     * @param level rate level, 0 stops.
+     * @return was configuration accepted.
+     */
+    bool configDirectReport(int handle, int channel, int level);
+
     HybrisAdaptorReader adaptorReader;
 
 protected:
+    /**
+     * Running adaptors indexed by sensor type. Adaptors for type t are
+     * adaptors[first[t]] .. adaptors[first[t + 1] - 1].
+     */
+    struct DispatchTable
+    {
+        QVector<int>             first;    /**< start index for each type, one extra entry at the end */
+        QVector<HybrisAdaptor *> adaptors; /**< adaptors grouped by type */
+    };
+
+    /**
+     * Rebuild dispatch table from registered adaptors which are running.
+     * Waits until the reader thread is no longer using the old table.
+     */
+    void rebuildDispatchTable();
+
+    /**
+     * Properties of a HAL sensor, as listed by the HAL or read from the
+     * CapabilityCache.
+     */
+    struct SensorInfo
+    {
+        SensorInfo() : type(0), handle(0), maxRange(0), minDelay(0), resolution(0), fifoMaxEventCount(0), flags(0) {}
+
+        int     type;              /**< sensor type */
+        int     handle;            /**< sensor handle */
+        float   maxRange;          /**< maximum range */
+        int     minDelay;          /**< minimum delay in microseconds */
+        float   resolution;        /**< resolution */
+        int     fifoMaxEventCount; /**< batching FIFO size */
+        quint32 flags;             /**< sensor flags */
+    };
+
+    class InitTask;
+
     void init();
+
+    /**
+     * Read the sensor list of the opened HAL.
+     *
+     * @return sensors.
+     */
+    QVector<SensorInfo> halSensors() const;
+
+    /**
+     * Use given sensor list to answer sensor queries.
+     *
+     * @param sensors sensors.
+     */
+    void setSensors(const QVector<SensorInfo>& sensors);
+
+    /**
+     * Read sensor list and device API version from the cache.
+     *
+     * @return were both cached.
+     */
+    bool loadCachedSensors();
+
+    /**
+     * Store the current sensor list and device API version to the cache.
+     */
+    void storeCachedSensors();
+
+    /**
+     * Wait until the HAL opened in the background by #InitTask is
+     * ready. Returns at once when the HAL was opened directly.
+     *
+     * @return is the HAL device open.
+     */
+    bool waitForHal();
+
     int sensorsCount;
+    QVector<SensorInfo> sensorInfo_; //index by sensorMap
     QMap <int, int> sensorMap; //type, index
+    quint32 deviceVersion_;   /**< device API version, cached until the HAL is open */
+    bool halReady_;           /**< has the HAL been opened */
+    QMutex halMutex_;         /**< protects halReady_ */
+    QSemaphore halOpened_;    /**< released by #InitTask */
+    InitTask* initTask_;      /**< background HAL initialization, NULL if none */
     QMap <int, HybrisAdaptor *> registeredAdaptors; //type, obj
     bool sensorsOpened;
+    QAtomicPointer<const DispatchTable> dispatchTable_; /**< table used by the reader thread */
+    QAtomicInt activeDispatches_;                       /**< dispatches using dispatchTable_ */
 };
 
 class HybrisAdaptor : public DeviceAdaptor
@@ -103,10 +275,27 @@ public:
     virtual bool startSensor();
     virtual void stopSensor();
 
+    /**
+     * Display was blanked. With <tt>global/display_off_batch_interval</tt>
+     * set the sensor keeps running but the hub is asked to batch for that
+     * long, so the system can suspend between bursts.
+     *
+     * @return was display-off batching enabled.
+     */
     virtual bool standby();
 
+    /**
+     * Display was unblanked. Requested batching is restored.
+     *
+     * @return was display-off batching disabled.
+     */
     virtual bool resume();
 
+    virtual IntegerRangeList getAvailableBufferSizes(bool& hwSupported) const;
+    virtual IntegerRangeList getAvailableBufferIntervals(bool& hwSupported) const;
+    virtual unsigned int bufferSize() const;
+    virtual unsigned int bufferInterval() const;
+
     qreal maxRange;
     qint32 minDelay;
     qreal resolution;
@@ -117,8 +306,38 @@ public:
     int cachedInterval;
 
 protected:
+    /**
+     * Stage sample into the adaptor buffer. Samples are neither
+     * committed nor readers woken up here; #wakeUpReaders() is called
+     * once after all events of a poll have been processed.
+     *
+     * @param data sensor event.
+     */
     virtual void processSample(const sensors_event_t& data) = 0;
 
+    /**
+     * Commit the samples staged during a poll and wake up readers of
+     * the adaptor buffer.
+     */
+    virtual void wakeUpReaders() = 0;
+
+    virtual bool setBufferSize(unsigned int value);
+    virtual bool setBufferInterval(unsigned int value);
+
+    /**
+     * Create an ashmem region of <tt>direct_channel_events</tt> events
+     * from the adaptor section and let the HAL report into it at the rate
+     * level closest above the requested interval.
+     */
+    virtual int createDirectChannel(int sessionId, unsigned int interval);
+    virtual void destroyDirectChannel(int sessionId);
+
+    /**
+     * Buffer also holds a full hardware FIFO, the HAL may deliver one
+     * in a single poll.
+     */
+    virtual unsigned int bufferCapacity(unsigned int minimum) const;
+
     virtual unsigned int interval() const;
     virtual bool setInterval(const unsigned int value, const int sessionId);
     virtual unsigned int evaluateIntervalRequests(int& sessionId) const;
@@ -127,11 +346,43 @@ private:
     void stopReaderThread();
     bool startReaderThread();
 
+    /**
+     * Maximum report latency derived from buffer size and buffer
+     * interval requests.
+     *
+     * @return latency in milliseconds, 0 when not batching.
+     */
+    unsigned int reportLatency() const;
+
+    /**
+     * Pass current interval and report latency to the HAL.
+     *
+     * @return was configuration accepted.
+     */
+    bool applyBatching();
+
     QList<int> sensorIds;
     unsigned int interval_;
     bool inStandbyMode_;
     bool running_;
     bool shouldBeRunning_;
+    unsigned int bufferSize_;     /**< requested hardware buffer size */
+    unsigned int bufferInterval_; /**< requested hardware buffer interval in ms */
+    unsigned int appliedInterval_; /**< interval last passed to the HAL in ms, 0 if none */
+    unsigned int appliedLatency_; /**< report latency last passed to the HAL in ms */
+    unsigned int displayOffLatency_; /**< report latency while display is off in ms */
+    bool pendingWakeup_;          /**< samples committed since last wake up */
+    QAtomicInt motionWakeupArmed_; /**< sensor deactivated until significant motion */
+
+    /**
+     * Direct channel registered with the HAL.
+     */
+    struct DirectChannel
+    {
+        int fd;     /**< ashmem file descriptor */
+        int handle; /**< HAL channel handle */
+    };
+    QMap<int, DirectChannel> directChannels_; /**< direct channels by session */
 
 };
 
@@ -0,0 +1,182 @@
+/**
+   @file iioscanlayout.cpp
+   @brief IioScanLayout
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "iioscanlayout.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <QDir>
+#include <QFile>
+#include <QMap>
+#include "logging.h"
+
+static QByteArray readAttribute(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    return file.readAll().trimmed();
+}
+
+static bool writeAttribute(const QString& path, const QByteArray& value)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    return file.write(value) == value.size();
+}
+
+IioScanLayout::IioScanLayout() :
+    frameSize_(0)
+{
+}
+
+bool IioScanLayout::load(const QString& devicePath, const QStringList& channels)
+{
+    channels_.clear();
+    timestamp_ = Channel();
+    frameSize_ = 0;
+
+    QString scanDir = devicePath + "/scan_elements/";
+
+    foreach (const QString& channel, channels)
+    {
+        if (!writeAttribute(scanDir + channel + "_en", "1"))
+        {
+            sensordLogW() << "Failed to enable IIO channel " << scanDir + channel;
+            return false;
+        }
+    }
+    if (QFile::exists(scanDir + "in_timestamp_en"))
+        writeAttribute(scanDir + "in_timestamp_en", "1");
+
+    // Other channels may have been left enabled, they take space in the
+    // frame too. Order by scan index.
+    QMap<int, ScanElement> elements;
+    foreach (const QString& file, QDir(scanDir).entryList(QStringList() << "*_en", QDir::Files))
+    {
+        if (readAttribute(scanDir + file) != "1")
+            continue;
+
+        ScanElement element;
+        element.name = file.left(file.length() - 3);
+        bool ok = false;
+        element.index = readAttribute(scanDir + element.name + "_index").toInt(&ok);
+        if (!ok || !parseType(readAttribute(scanDir + element.name + "_type"), element.format))
+        {
+            sensordLogW() << "Failed to read IIO scan element " << scanDir + element.name;
+            return false;
+        }
+        elements.insert(element.index, element);
+    }
+
+    int offset = 0;
+    int alignment = 1;
+    QMap<QString, Channel> formats;
+    for (QMap<int, ScanElement>::iterator it = elements.begin(); it != elements.end(); ++it)
+    {
+        Channel& format = it.value().format;
+        if (offset % format.bytes)
+            offset += format.bytes - offset % format.bytes;
+        format.offset = offset;
+        offset += format.bytes * format.repeat;
+        if (format.bytes > alignment)
+            alignment = format.bytes;
+        formats.insert(it.value().name, format);
+    }
+    if (offset % alignment)
+        offset += alignment - offset % alignment;
+
+    foreach (const QString& channel, channels)
+    {
+        if (!formats.contains(channel))
+        {
+            sensordLogW() << "IIO channel " << channel << " missing from the scan";
+            return false;
+        }
+        channels_.append(formats.value(channel));
+    }
+    if (formats.contains("in_timestamp"))
+        timestamp_ = formats.value("in_timestamp");
+
+    frameSize_ = offset;
+    sensordLogD() << "IIO scan of " << devicePath << ": " << elements.size() << " elements, " << frameSize_ << " bytes per frame";
+    return frameSize_ > 0;
+}
+
+bool IioScanLayout::parseType(const QByteArray& type, Channel& channel)
+{
+    // Format is [be|le]:[s|u]bits/storagebits[Xrepeat]>>shift
+    char endian = 0;
+    char sign = 0;
+    int bits = 0;
+    int storage = 0;
+    if (sscanf(type.constData(), "%ce:%c%d/%d", &endian, &sign, &bits, &storage) != 4)
+        return false;
+    if (storage != 8 && storage != 16 && storage != 32 && storage != 64)
+        return false;
+    if (bits <= 0 || bits > storage)
+        return false;
+
+    channel.bigEndian = (endian == 'b');
+    channel.isSigned = (sign == 's');
+    channel.bits = bits;
+    channel.bytes = storage / 8;
+    channel.repeat = 1;
+    channel.shift = 0;
+
+    int pos = type.indexOf('X');
+    if (pos != -1)
+        channel.repeat = qMax(1, atoi(type.constData() + pos + 1));
+    pos = type.indexOf(">>");
+    if (pos != -1)
+        channel.shift = atoi(type.constData() + pos + 2);
+    return channel.shift >= 0 && channel.shift < storage;
+}
+
+qint64 IioScanLayout::decode(const char* frame, const Channel& channel)
+{
+    const unsigned char* data = (const unsigned char*)frame + channel.offset;
+    quint64 raw = 0;
+    for (int i = 0; i < channel.bytes; ++i)
+        raw |= (quint64)data[channel.bigEndian ? channel.bytes - 1 - i : i] << (8 * i);
+
+    raw >>= channel.shift;
+    if (channel.bits < 64)
+    {
+        quint64 mask = ((quint64)1 << channel.bits) - 1;
+        raw &= mask;
+        if (channel.isSigned && (raw >> (channel.bits - 1)) & 1)
+            raw |= ~mask;
+    }
+    return (qint64)raw;
+}
+
+qint64 IioScanLayout::value(const char* frame, int channel) const
+{
+    return decode(frame, channels_[channel]);
+}
+
+qint64 IioScanLayout::timestamp(const char* frame) const
+{
+    return decode(frame, timestamp_);
+}
@@ -0,0 +1,139 @@
+/**
+   @file iioscanlayout.h
+   @brief IioScanLayout
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef IIOSCANLAYOUT_H
+#define IIOSCANLAYOUT_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * Layout of the binary scan frames read from an IIO character device
+ * (<tt>/dev/iio:deviceN</tt>) in buffered mode. The layout is built from
+ * the <tt>scan_elements</tt> directory of the device: every enabled
+ * channel is stored at its scan index, aligned to its storage size, and
+ * the whole frame is aligned to the largest storage size.
+ */
+class IioScanLayout
+{
+public:
+    /**
+     * Constructor.
+     */
+    IioScanLayout();
+
+    /**
+     * Enable given channels and the timestamp channel, if the device
+     * provides one, and read the resulting frame layout.
+     *
+     * @param devicePath sysfs directory of the device, for example
+     *                   <tt>/sys/bus/iio/devices/iio:device0</tt>.
+     * @param channels channel names without suffix, for example
+     *                 <tt>in_accel_x</tt>. Values are later accessed by
+     *                 their index in this list.
+     * @return was layout read succesfully.
+     */
+    bool load(const QString& devicePath, const QStringList& channels);
+
+    /**
+     * Is layout valid.
+     *
+     * @return is layout valid.
+     */
+    bool isValid() const { return frameSize_ > 0; }
+
+    /**
+     * Size of a single scan frame in bytes.
+     *
+     * @return frame size.
+     */
+    int frameSize() const { return frameSize_; }
+
+    /**
+     * Number of requested channels.
+     *
+     * @return channel count.
+     */
+    int channelCount() const { return channels_.size(); }
+
+    /**
+     * Decode value of a requested channel from a frame.
+     *
+     * @param frame pointer to the beginning of the frame.
+     * @param channel index of the channel in the list given to #load().
+     * @return raw value, sign extended and shifted.
+     */
+    qint64 value(const char* frame, int channel) const;
+
+    /**
+     * Does the frame contain a timestamp.
+     *
+     * @return is timestamp channel enabled.
+     */
+    bool hasTimestamp() const { return timestamp_.bits > 0; }
+
+    /**
+     * Decode timestamp from a frame.
+     *
+     * @param frame pointer to the beginning of the frame.
+     * @return timestamp in nanoseconds, as provided by the driver.
+     */
+    qint64 timestamp(const char* frame) const;
+
+private:
+    /**
+     * Position and format of a channel inside a frame.
+     */
+    struct Channel
+    {
+        Channel() : offset(0), bytes(0), repeat(1), bits(0), shift(0), isSigned(false), bigEndian(false) {}
+
+        int  offset;     /**< byte offset in frame */
+        int  bytes;      /**< storage size in bytes */
+        int  repeat;     /**< number of repeated values */
+        int  bits;       /**< number of valid bits */
+        int  shift;      /**< right shift to apply */
+        bool isSigned;   /**< is value signed */
+        bool bigEndian;  /**< is value stored big endian */
+    };
+
+    /**
+     * Enabled channel and its scan index.
+     */
+    struct ScanElement
+    {
+        int     index;   /**< scan index */
+        QString name;    /**< channel name */
+        Channel format;  /**< channel format */
+    };
+
+    static bool parseType(const QByteArray& type, Channel& channel);
+    static qint64 decode(const char* frame, const Channel& channel);
+
+    QVector<Channel> channels_;  /**< requested channels */
+    Channel          timestamp_; /**< timestamp channel */
+    int              frameSize_; /**< size of a frame */
+};
+
+#endif // IIOSCANLAYOUT_H
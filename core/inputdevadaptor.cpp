@@ -31,8 +31,12 @@
 
 #include "inputdevadaptor.h"
 #include "config.h"
+#include "inputdevicecache.h"
+#include "datatypes/utils.h"
 
 #include <errno.h>
+#include <string.h>
+#include <sys/ioctl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -135,35 +139,71 @@ void InputDevAdaptor::processSample(int pathId, int fd)
                 break;
         }
     }
+
+    // Everything committed from this read is in the buffers, wake up once.
+    if (numEvents > 0)
+        wakeUpReaders();
 }
 
-bool InputDevAdaptor::checkInputDevice(const QString& path, const QString& matchString, bool strictChecks) const
+void InputDevAdaptor::wakeUpReaders()
 {
-    char deviceName[256] = {0,};
-    bool check = true;
+}
 
-    int fd = open(path.toLocal8Bit().constData(), O_RDONLY);
-    if (fd == -1) {
-        return false;
+bool InputDevAdaptor::readInitialState(int pathId, int fd)
+{
+    unsigned long supported[SW_MAX / (8 * sizeof(unsigned long)) + 1];
+    unsigned long state[SW_MAX / (8 * sizeof(unsigned long)) + 1];
+    memset(supported, 0, sizeof(supported));
+    memset(state, 0, sizeof(state));
+    if (ioctl(fd, EVIOCGBIT(EV_SW, sizeof(supported)), supported) == -1 ||
+        ioctl(fd, EVIOCGSW(sizeof(state)), state) == -1) {
+        // Not an evdev node, nothing is read to keep it from blocking.
+        return true;
     }
 
-    if (strictChecks) {
-        int result = ioctl(fd, EVIOCGNAME(sizeof(deviceName)), deviceName);
-        if (result == -1) {
-           sensordLogW() << "Could not read devicename for " << path;
-           check = false;
-        } else
-        if (QString(deviceName).contains(matchString, Qt::CaseInsensitive)) {
-            sensordLogT() << "\"" << matchString << "\"" << " matched in device name: " << deviceName;
-            check = true;
-        } else {
-            check = false;
-        }
+    const unsigned int bits = 8 * sizeof(unsigned long);
+    quint64 now = Utils::getTimeStamp();
+    struct input_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.time.tv_sec = now / 1000000;
+    ev.time.tv_usec = now % 1000000;
+
+    bool any = false;
+    for (int code = 0; code <= SW_MAX; ++code) {
+        if (!(supported[code / bits] & (1UL << (code % bits))))
+            continue;
+        ev.type = EV_SW;
+        ev.code = code;
+        ev.value = (state[code / bits] >> (code % bits)) & 1;
+        interpretEvent(pathId, &ev);
+        any = true;
+    }
+    if (any) {
+        ev.type = EV_SYN;
+        ev.code = SYN_REPORT;
+        ev.value = 0;
+        interpretSync(pathId, &ev);
+        wakeUpReaders();
     }
+    return true;
+}
 
-    close(fd);
+bool InputDevAdaptor::checkInputDevice(const QString& path, const QString& matchString, bool strictChecks) const
+{
+    InputDeviceCache::Device device;
+    if (!InputDeviceCache::instance().device(path, device)) {
+        return false;
+    }
 
-    return check;
+    if (!strictChecks) {
+        return true;
+    }
+
+    if (device.name.contains(matchString, Qt::CaseInsensitive)) {
+        sensordLogT() << "\"" << matchString << "\"" << " matched in device name: " << device.name;
+        return true;
+    }
+    return false;
 }
 
 unsigned int InputDevAdaptor::interval() const
@@ -177,9 +217,11 @@ bool InputDevAdaptor::setInterval(const unsigned int value, const int sessionId)
 
     sensordLogD() << "Setting poll interval for " << deviceString_ << " to " << value;
     QByteArray frequencyString(QString("%1\n").arg(value).toLocal8Bit());
-    if(writeToFile(usedDevicePollFilePath_.toLocal8Bit(), frequencyString))
+    if(writeWhenRunning(usedDevicePollFilePath_.toLocal8Bit(), frequencyString))
     {
         cachedInterval_ = value;
+        // Watermark derived from the buffer interval follows the rate.
+        applyFifoWatermark();
         return true;
     }
     return false;
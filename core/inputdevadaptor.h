@@ -95,9 +95,18 @@ protected:
      */
     virtual void interpretSync(int src, struct input_event *ev) = 0;
 
+    /**
+     * Wake up readers of the output buffers. Called once after all
+     * events from a single read have been interpreted, so subclasses
+     * should only commit in #interpretEvent() and #interpretSync().
+     * Default implementation does nothing.
+     */
+    virtual void wakeUpReaders();
+
     /**
      * Scans through the /dev/input/event* device handles and registers the
-     * ones that pass the test with the #checkInputDevice method.
+     * ones that pass the test with the #checkInputDevice method. Handles
+     * are probed once and shared by all adaptors, see InputDeviceCache.
      *
      * @param typeName device type name
      * @return Number of devices detected.
@@ -106,6 +115,14 @@ protected:
 
     void processSample(int pathId, int fd);
 
+    /**
+     * Current state of the switches of the device, queried with
+     * <tt>EVIOCGSW</tt>, is passed to #interpretEvent() as one EV_SW
+     * event per switch followed by #interpretSync(), as if the device
+     * had just reported it.
+     */
+    virtual bool readInitialState(int pathId, int fd);
+
     virtual unsigned int interval() const;
 
     virtual bool setInterval(const unsigned int value, const int sessionId);
@@ -0,0 +1,242 @@
+/**
+   @file inputdevicecache.cpp
+   @brief InputDeviceCache
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "inputdevicecache.h"
+#include "workerpool.h"
+#include "config.h"
+#include "logging.h"
+#include "capabilitycache.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QSemaphore>
+#include <QVector>
+
+static const int MAX_EVENT_DEV = 16;
+
+/**
+ * Probes a single device in a pool thread.
+ */
+class InputDeviceCache::ProbeTask : public WorkerPool::Task
+{
+public:
+    ProbeTask() : ok(false), done(NULL) {}
+
+    void run()
+    {
+        ok = InputDeviceCache::probeDevice(device.path, device);
+        done->release();
+    }
+
+    Device      device;
+    bool        ok;
+    QSemaphore* done;
+};
+
+InputDeviceCache& InputDeviceCache::instance()
+{
+    static InputDeviceCache cache;
+    return cache;
+}
+
+InputDeviceCache::InputDeviceCache()
+{
+    pattern_ = Config::configuration()->value<QString>("global/device_sys_path", "");
+    if (!pattern_.contains("%1"))
+        return;
+
+    probe(uncached(candidates()));
+
+    QString dir = QFileInfo(pattern_.arg(0)).absolutePath();
+    if (watcher_.addPath(dir))
+        connect(&watcher_, SIGNAL(directoryChanged(const QString&)), this, SLOT(directoryChanged()));
+}
+
+QStringList InputDeviceCache::candidates() const
+{
+    QStringList paths;
+    for (int i = 0; i < MAX_EVENT_DEV; ++i)
+    {
+        QString path = pattern_.arg(i);
+        if (QFile::exists(path))
+            paths << path;
+    }
+    return paths;
+}
+
+QString InputDeviceCache::sysfsName(const QString& path)
+{
+    QFile file("/sys/class/input/" + QFileInfo(path).fileName() + "/device/name");
+    if (!file.open(QIODevice::ReadOnly))
+        return QString();
+    return QString::fromLocal8Bit(file.readLine()).trimmed();
+}
+
+QStringList InputDeviceCache::uncached(const QStringList& paths)
+{
+    CapabilityCache& cache = CapabilityCache::instance();
+    if (!cache.isEnabled())
+        return paths;
+
+    // Event device numbers can change between boots, so a cached device
+    // is only used while sysfs still gives the same name for its handle.
+    // Reading sysfs does not wait for the driver like opening does.
+    QStringList remaining;
+    QMutexLocker locker(&mutex_);
+    foreach (const QString& path, paths)
+    {
+        QVariantList cached = cache.value("inputdevices", CapabilityCache::kernelVersion(), path).toList();
+        QString name = sysfsName(path);
+        if (cached.size() != 3 || name.isEmpty() || cached.at(0).toString().trimmed() != name)
+        {
+            remaining << path;
+            continue;
+        }
+        Device device;
+        device.path = path;
+        device.name = cached.at(0).toString();
+        device.evBits = (unsigned long)cached.at(1).toULongLong();
+        QByteArray absBits = cached.at(2).toByteArray();
+        memcpy(device.absBits, absBits.constData(), qMin((size_t)absBits.size(), sizeof(device.absBits)));
+        probed_.insert(path, true);
+        devices_.insert(path, device);
+        sensordLogT() << "Input device " << device.path << ": " << device.name << " (cached)";
+    }
+    return remaining;
+}
+
+void InputDeviceCache::probe(const QStringList& paths)
+{
+    if (paths.isEmpty())
+        return;
+
+    // Opening a handle can block for a while on slow drivers, so all
+    // handles are probed at once and the wait is for the slowest one.
+    QVector<ProbeTask> tasks(paths.size());
+    QSemaphore done;
+    for (int i = 0; i < paths.size(); ++i)
+    {
+        tasks[i].device.path = paths.at(i);
+        tasks[i].done = &done;
+        WorkerPool::instance().submit(&tasks[i]);
+    }
+    done.acquire(tasks.size());
+
+    QMutexLocker locker(&mutex_);
+    for (int i = 0; i < tasks.size(); ++i)
+    {
+        const Device& device = tasks.at(i).device;
+        probed_.insert(device.path, tasks.at(i).ok);
+        if (tasks.at(i).ok)
+        {
+            devices_.insert(device.path, device);
+            sensordLogT() << "Input device " << device.path << ": " << device.name;
+            QVariantList cached;
+            cached << device.name << (qulonglong)device.evBits
+                   << QByteArray((const char*)device.absBits, sizeof(device.absBits));
+            CapabilityCache::instance().setValue("inputdevices", CapabilityCache::kernelVersion(), device.path, cached);
+        }
+        else
+        {
+            devices_.remove(device.path);
+        }
+    }
+}
+
+bool InputDeviceCache::probeDevice(const QString& path, Device& device)
+{
+    int fd = open(path.toLocal8Bit().constData(), O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    char name[256] = {0,};
+    if (ioctl(fd, EVIOCGNAME(sizeof(name)), name) == -1)
+        sensordLogW() << "Could not read devicename for " << path;
+    device.name = QString(name);
+    if (ioctl(fd, EVIOCGBIT(0, sizeof(device.evBits)), &device.evBits) < 0)
+        device.evBits = 0;
+    if (device.hasEventType(EV_ABS) &&
+        ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(device.absBits)), device.absBits) < 0)
+        memset(device.absBits, 0, sizeof(device.absBits));
+
+    close(fd);
+    return true;
+}
+
+bool InputDeviceCache::device(const QString& path, Device& device)
+{
+    {
+        QMutexLocker locker(&mutex_);
+        if (probed_.contains(path))
+        {
+            if (!probed_.value(path))
+                return false;
+            device = devices_.value(path);
+            return true;
+        }
+    }
+
+    probe(QStringList() << path);
+
+    QMutexLocker locker(&mutex_);
+    if (!probed_.value(path))
+        return false;
+    device = devices_.value(path);
+    return true;
+}
+
+QList<InputDeviceCache::Device> InputDeviceCache::devices()
+{
+    QMutexLocker locker(&mutex_);
+    return devices_.values();
+}
+
+void InputDeviceCache::directoryChanged()
+{
+    QStringList current = candidates();
+    QStringList added;
+    {
+        QMutexLocker locker(&mutex_);
+        QString dir = QFileInfo(pattern_.arg(0)).absolutePath();
+        foreach (const QString& path, probed_.keys())
+        {
+            if (path.startsWith(dir) && !current.contains(path))
+            {
+                probed_.remove(path);
+                devices_.remove(path);
+                sensordLogD() << "Input device removed: " << path;
+            }
+        }
+        foreach (const QString& path, current)
+        {
+            if (!probed_.value(path, false))
+                added << path;
+        }
+    }
+    probe(added);
+}
@@ -0,0 +1,155 @@
+/**
+   @file inputdevicecache.h
+   @brief InputDeviceCache
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef INPUTDEVICECACHE_H
+#define INPUTDEVICECACHE_H
+
+#include <QObject>
+#include <QString>
+#include <QMap>
+#include <QMutex>
+#include <QFileSystemWatcher>
+#include <string.h>
+
+/**
+ * Shared results of probing the input event devices. Devices matching
+ * <tt>global/device_sys_path</tt> are opened and queried once, in
+ * parallel on the WorkerPool, the first time an adaptor asks for them.
+ * Afterwards adaptors look devices up from the cache instead of opening
+ * and probing every handle again. The device directory is watched and
+ * only added or removed handles are probed again. Results are also kept
+ * in the CapabilityCache, so on the next boot handles which still carry
+ * the same device are not opened at all.
+ */
+class InputDeviceCache : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(InputDeviceCache)
+
+public:
+    /**
+     * Probed properties of an input device.
+     */
+    struct Device
+    {
+        Device() : evBits(0) { memset(absBits, 0, sizeof(absBits)); }
+
+        QString       path;        /**< device file */
+        QString       name;        /**< EVIOCGNAME */
+        unsigned long evBits;      /**< EVIOCGBIT(0) */
+        unsigned char absBits[8];  /**< EVIOCGBIT(EV_ABS) */
+
+        /**
+         * Does the device report given event type.
+         *
+         * @param type event type, for example <tt>EV_ABS</tt>.
+         * @return is event type supported.
+         */
+        bool hasEventType(int type) const { return (evBits >> type) & 1; }
+
+        /**
+         * Does the device report given absolute axis.
+         *
+         * @param axis axis, for example <tt>ABS_X</tt>.
+         * @return is axis supported.
+         */
+        bool hasAbsAxis(int axis) const { return axis < 64 && (absBits[axis / 8] >> (axis % 8)) & 1; }
+    };
+
+    /**
+     * Get the cache. Devices are probed on first use.
+     *
+     * @return cache instance.
+     */
+    static InputDeviceCache& instance();
+
+    /**
+     * Look up a device. Paths outside the probed range are probed and
+     * cached on first request.
+     *
+     * @param path device file.
+     * @param device filled with the device properties.
+     * @return could the device be opened.
+     */
+    bool device(const QString& path, Device& device);
+
+    /**
+     * Probed devices in path order.
+     *
+     * @return devices that could be opened.
+     */
+    QList<Device> devices();
+
+private Q_SLOTS:
+    /**
+     * Probe added handles and drop removed ones.
+     */
+    void directoryChanged();
+
+private:
+    InputDeviceCache();
+
+    /**
+     * Probe given paths in parallel and store the results.
+     *
+     * @param paths device files.
+     */
+    void probe(const QStringList& paths);
+
+    /**
+     * Device files matching the configured path pattern which currently
+     * exist.
+     *
+     * @return device files.
+     */
+    QStringList candidates() const;
+
+    /**
+     * Take devices which are in the CapabilityCache and still present
+     * with the same name from given paths.
+     *
+     * @param paths device files.
+     * @return device files which still need probing.
+     */
+    QStringList uncached(const QStringList& paths);
+
+    /**
+     * Name of an event device as given by sysfs.
+     *
+     * @param path device file.
+     * @return device name, empty if unknown.
+     */
+    static QString sysfsName(const QString& path);
+
+    static bool probeDevice(const QString& path, Device& device);
+
+    class ProbeTask;
+
+    QMutex                 mutex_;   /**< protects devices_ */
+    QMap<QString, Device>  devices_; /**< openable devices by path */
+    QMap<QString, bool>    probed_;  /**< probed paths and result */
+    QString                pattern_; /**< global/device_sys_path */
+    QFileSystemWatcher     watcher_; /**< watches the device directory */
+};
+
+#endif // INPUTDEVICECACHE_H
@@ -0,0 +1,166 @@
+/**
+   @file liveparameter.h
+   @brief LiveParameter
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef LIVEPARAMETER_H
+#define LIVEPARAMETER_H
+
+#include <QAtomicPointer>
+#include <QMutex>
+
+/**
+ * Parameter block changed by one thread while another reads it on its
+ * hot path, like filter coefficients set over D-Bus while a chain runs.
+ *
+ * Writers publish a new versioned copy of the block. The reader adopts
+ * the newest copy with #update() at a point where it holds no reference
+ * to the current one, usually at the start of a batch, and reads it
+ * through #current() without locks or atomics. Blocks the reader has
+ * left are handed back and freed by the next #publish(), so the reader
+ * never allocates nor frees. There must be only one reader thread at a
+ * time; writers are serialized.
+ */
+template <class T>
+class LiveParameter
+{
+    Q_DISABLE_COPY(LiveParameter)
+
+public:
+    /**
+     * Constructor.
+     *
+     * @param value initial value, version 0.
+     */
+    explicit LiveParameter(const T& value = T()) :
+        current_(new Block(value, 0)),
+        latest_(value),
+        version_(0)
+    {
+    }
+
+    ~LiveParameter()
+    {
+        delete current_;
+        delete pending_.fetchAndStoreAcquire(0);
+        freeRetired();
+    }
+
+    /**
+     * Publish a new value. The reader sees it after its next #update().
+     *
+     * @param value new value.
+     */
+    void publish(const T& value)
+    {
+        QMutexLocker locker(&mutex_);
+        latest_ = value;
+        freeRetired();
+        // A block still pending was never seen by the reader.
+        delete pending_.fetchAndStoreRelease(new Block(value, ++version_));
+    }
+
+    /**
+     * Last published value. For the writer side, takes a lock.
+     *
+     * @return value.
+     */
+    T value() const
+    {
+        QMutexLocker locker(&mutex_);
+        return latest_;
+    }
+
+    /**
+     * Adopt the newest published value. Called by the reader while it
+     * holds no reference returned by #current().
+     *
+     * @return did the value change.
+     */
+    bool update()
+    {
+        if (!pending_.loadAcquire())
+            return false;
+        Block* block = pending_.fetchAndStoreAcquire(0);
+        if (!block)
+            return false;
+
+        Block* old = current_;
+        current_ = block;
+        Block* head;
+        do {
+            head = retired_.loadAcquire();
+            old->next = head;
+        } while (!retired_.testAndSetRelease(head, old));
+        return true;
+    }
+
+    /**
+     * Value adopted by the last #update(). Reader side only.
+     *
+     * @return value.
+     */
+    const T& current() const { return current_->value; }
+
+    /**
+     * Version of the value adopted by the last #update(), incremented
+     * on each #publish(). Reader side only.
+     *
+     * @return version.
+     */
+    unsigned int version() const { return current_->version; }
+
+private:
+    /**
+     * Published copy of the parameters.
+     */
+    struct Block
+    {
+        Block(const T& v, unsigned int ver) : value(v), version(ver), next(0) {}
+
+        T            value;   /**< parameters */
+        unsigned int version; /**< publish count */
+        Block*       next;    /**< next retired block */
+    };
+
+    /**
+     * Free the blocks the reader has left. Caller must hold #mutex_ or
+     * be the destructor.
+     */
+    void freeRetired()
+    {
+        Block* block = retired_.fetchAndStoreAcquire(0);
+        while (block) {
+            Block* next = block->next;
+            delete block;
+            block = next;
+        }
+    }
+
+    Block*                current_; /**< block used by the reader */
+    QAtomicPointer<Block> pending_; /**< newest block not yet adopted, or NULL */
+    QAtomicPointer<Block> retired_; /**< blocks left by the reader */
+    mutable QMutex        mutex_;   /**< serializes writers */
+    T                     latest_;  /**< last published value */
+    unsigned int          version_; /**< number of publishes */
+};
+
+#endif
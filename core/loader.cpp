@@ -32,12 +32,68 @@
 #include <QStringList>
 #include <QList>
 #include <QCoreApplication>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSettings>
+#include <QSemaphore>
+#include <QFile>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+#include <QJsonObject>
+#endif
 
 #include "logging.h"
 #include "config.h"
+#include "sensormanager.h"
+#include "workerpool.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+/**
+ * Loads a plugin file in a pool thread.
+ */
+class PreloadTask : public WorkerPool::Task
+{
+public:
+    PreloadTask(const QString& name, const QString& path, QSemaphore* done) :
+        name_(name),
+        loader_(new QPluginLoader(path)),
+        done_(done)
+    {
+        loader_->setLoadHints(QLibrary::ExportExternalSymbolsHint);
+    }
+
+    void run()
+    {
+        // dlopen() serializes on a process wide lock. Start reading the
+        // file first so the I/O of all tasks overlaps.
+        int fd = ::open(QFile::encodeName(loader_->fileName()).constData(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+            ::close(fd);
+        }
+        if (loader_->load()) {
+            QObject* object = loader_->instance();
+            if (object)
+                object->moveToThread(QCoreApplication::instance()->thread());
+        }
+        done_->release();
+    }
+
+    QString        name_;   /**< plugin name */
+    QPluginLoader* loader_; /**< loader of the plugin file */
+
+private:
+    QSemaphore*    done_;   /**< released when the task has run */
+};
 
 Loader::Loader()
 {
+    Config* config = Config::configuration();
+    if (config)
+        manifestPath_ = config->value<QString>("global/plugin_manifest", "");
+    if (!manifestPath_.isEmpty())
+        readManifest();
 }
 
 Loader& Loader::instance()
@@ -47,41 +103,57 @@ Loader& Loader::instance()
     return the_loader;
 }
 
-bool Loader::loadPluginFile(const QString& name, QString *errorString, QStringList& newPluginNames, QList<PluginBase*>& newPlugins) const
+QString Loader::pluginPath(const QString& name)
 {
-    sensordLogT() << "Loading plugin:" << name;
-
 #if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
-    QString pluginPath = QString::fromLatin1("/usr/lib/sensord/lib%1.so").arg(name);
+    return QString::fromLatin1("/usr/lib/sensord/lib%1.so").arg(name);
 #else
-    QString pluginPath = QString::fromLatin1("/usr/lib/sensord-qt5/lib%1-qt5.so").arg(name);
+    return QString::fromLatin1("/usr/lib/sensord-qt5/lib%1-qt5.so").arg(name);
 #endif
+}
 
-    QPluginLoader qpl(pluginPath);
-    qpl.setLoadHints(QLibrary::ExportExternalSymbolsHint);
-    if (!qpl.load()) {
-        *errorString = qpl.errorString();
-        sensordLogC() << "plugin loading error: " << *errorString;
-        return false;
-    }
+bool Loader::loadPluginFile(const QString& name, QString *errorString, QStringList& newPluginNames, QList<PluginBase*>& newPlugins, QList<QPluginLoader*>& newLoaders) const
+{
+    sensordLogT() << "Loading plugin:" << name;
 
-    QObject* object = qpl.instance();
-    if (!object) {
-        *errorString = "not able to instanciate";
-        sensordLogC() << "plugin loading error: " << *errorString;
-        return false;
+    // Statically linked plugins have no loader.
+    QPluginLoader* qpl = NULL;
+    PluginBase* plugin = staticPlugin(name);
+    if (!plugin && preloaded_.contains(name)) {
+        qpl = preloaded_.value(name);
+        plugin = qobject_cast<PluginBase*>(qpl->instance());
     }
-
-    PluginBase* plugin = qobject_cast<PluginBase*>(object);
     if (!plugin) {
-        *errorString = "not a Plugin type";
-        sensordLogC() << "plugin loading error: " << *errorString;
-        return false;
+        qpl = new QPluginLoader(pluginPath(name));
+        qpl->setLoadHints(QLibrary::ExportExternalSymbolsHint);
+        if (!qpl->load()) {
+            *errorString = qpl->errorString();
+            sensordLogC() << "plugin loading error: " << *errorString;
+            delete qpl;
+            return false;
+        }
+
+        QObject* object = qpl->instance();
+        if (!object) {
+            *errorString = "not able to instanciate";
+            sensordLogC() << "plugin loading error: " << *errorString;
+            delete qpl;
+            return false;
+        }
+
+        plugin = qobject_cast<PluginBase*>(object);
+        if (!plugin) {
+            *errorString = "not a Plugin type";
+            sensordLogC() << "plugin loading error: " << *errorString;
+            delete qpl;
+            return false;
+        }
     }
 
     // Add plugins to the front of the list so they are initialized in reverse order. This will guarantee that dependencies are initialized first for each plugin.
     newPluginNames.prepend(name);
     newPlugins.prepend(plugin);
+    newLoaders.prepend(qpl);
 
     // Get dependencies
     QStringList requiredPlugins(plugin->Dependencies());
@@ -95,7 +167,7 @@ bool Loader::loadPluginFile(const QString& name, QString *errorString, QStringLi
             sensordLogT() << requiredPlugins.at(i) << " is not yet loaded, trying to load.";
             QString resolvedName = resolveRealPluginName(requiredPlugins.at(i));
             sensordLogT() << requiredPlugins.at(i) << " resolved as " << resolvedName << ". Loading";
-            loaded = loadPluginFile(resolvedName, errorString, newPluginNames, newPlugins);
+            loaded = loadPluginFile(resolvedName, errorString, newPluginNames, newPlugins, newLoaders);
         }
     }
     return loaded;
@@ -103,37 +175,294 @@ bool Loader::loadPluginFile(const QString& name, QString *errorString, QStringLi
 
 bool Loader::loadPlugin(const QString& name, QString* errorString)
 {
-    QString error;
-    bool loaded = false;
-    QStringList newPluginNames;
-    QList<PluginBase*> newPlugins;
-
-    if (loadedPluginNames_.contains(name)) {
+    if (loadedPluginNames_.contains(name) || deferredPluginNames_.contains(name)) {
         sensordLogD() << "Plugin already loaded.";
         return true;
     }
 
-    if (loadPluginFile(name, &error, newPluginNames, newPlugins)) {
+    if (deferrable(name)) {
+        sensordLogD() << "Deferring plugin " << name << " until one of " << manifest_.value(name).provides << " is requested";
+        deferredPluginNames_.append(name);
+        return true;
+    }
+
+    return loadPluginNow(name, errorString);
+}
 
-        // Register newly loaded plugins
-        foreach (PluginBase* base, newPlugins) {
-            base->Register(*this);
+bool Loader::deferrable(const QString& name) const
+{
+    if (manifestPath_.isEmpty())
+        return false;
+    QStringList visited;
+    QMap<QString, ManifestEntry>::const_iterator it = manifest_.find(name);
+    return it != manifest_.end() && !it.value().eager && !it.value().provides.isEmpty() &&
+           manifestCurrent(name, visited);
+}
+
+int Loader::preloadPlugins(const QStringList& names)
+{
+    QStringList wave;
+    foreach (const QString& name, names) {
+        if (!loadedPluginNames_.contains(name) && !deferredPluginNames_.contains(name) && !deferrable(name))
+            wave.append(name);
+    }
+
+    QStringList seen;
+    while (!wave.isEmpty()) {
+        QSemaphore done;
+        QList<PreloadTask*> tasks;
+        foreach (const QString& name, wave) {
+            seen.append(name);
+            if (staticPlugins_.contains(name) || preloaded_.contains(name))
+                continue;
+            PreloadTask* task = new PreloadTask(name, pluginPath(name), &done);
+            tasks.append(task);
+            WorkerPool::instance().submit(task);
+        }
+        done.acquire(tasks.size());
+
+        // Failures are reported when the plugin is loaded for real.
+        foreach (PreloadTask* task, tasks) {
+            if (task->loader_->isLoaded() && qobject_cast<PluginBase*>(task->loader_->instance()))
+                preloaded_.insert(task->name_, task->loader_);
+            else
+                delete task->loader_;
         }
-        loadedPluginNames_.append(newPluginNames);
-        loaded = true;
+        qDeleteAll(tasks);
+
+        // Dependencies of this wave make up the next one.
+        QStringList next;
+        foreach (const QString& name, wave) {
+            PluginBase* plugin = staticPlugin(name);
+            if (!plugin && preloaded_.contains(name))
+                plugin = qobject_cast<PluginBase*>(preloaded_.value(name)->instance());
+            if (!plugin)
+                continue;
+            foreach (const QString& dependency, plugin->Dependencies()) {
+                QString resolved = resolveRealPluginName(dependency);
+                if (!seen.contains(resolved) && !next.contains(resolved) && !loadedPluginNames_.contains(resolved))
+                    next.append(resolved);
+            }
+        }
+        wave = next;
+    }
+    sensordLogD() << "Preloaded " << preloaded_.size() << " plugin files";
 
-        // Init newly loaded plugins
-        foreach (PluginBase* base, newPlugins) {
-            base->Init(*this);
+    int loaded = 0;
+    foreach (const QString& name, names) {
+        QString error;
+        if (loadPlugin(name, &error))
+            ++loaded;
+        else
+            sensordLogW() << "Failed to preload plugin " << name << ": " << error;
+    }
+
+    // Libraries stay loaded, as with failed plugins, but the loaders are not needed.
+    qDeleteAll(preloaded_);
+    preloaded_.clear();
+    return loaded;
+}
+
+bool Loader::loadDeferredPlugin(const QString& id)
+{
+    foreach (const QString& name, deferredPluginNames_) {
+        if (manifest_.value(name).provides.contains(id)) {
+            sensordLogD() << "Loading deferred plugin " << name << " for " << id;
+            QString error;
+            if (!loadPluginNow(name, &error)) {
+                sensordLogW() << "Failed to load deferred plugin " << name << ": " << error;
+                deferredPluginNames_.removeAll(name);
+                return false;
+            }
+            return true;
         }
+    }
+    return false;
+}
+
+bool Loader::loadPluginNow(const QString& name, QString* errorString)
+{
+    QString error;
+    QStringList newPluginNames;
+    QList<PluginBase*> newPlugins;
+    QList<QPluginLoader*> newLoaders;
 
-    } else {
+    bool loaded = loadPluginFile(name, &error, newPluginNames, newPlugins, newLoaders);
+    foreach (const QString& newName, newPluginNames)
+        preloaded_.remove(newName);
+    if (!loaded) {
+        // Libraries stay loaded, as before, but the loaders are not needed.
+        qDeleteAll(newLoaders);
         if(errorString)
             *errorString = error;
-        loaded = false;
+        return false;
+    }
+    for (int i = 0; i < newPluginNames.size(); ++i) {
+        if (newLoaders.at(i))
+            pluginLoaders_.insert(newPluginNames.at(i), newLoaders.at(i));
     }
 
-    return loaded;
+    // Register newly loaded plugins, noting what each one provides.
+    QStringList registered = registeredIds();
+    for (int i = 0; i < newPlugins.size(); ++i) {
+        newPlugins.at(i)->Register(*this);
+        QStringList ids = registeredIds();
+        ManifestEntry& entry = manifest_[newPluginNames.at(i)];
+        entry.dependencies = newPlugins.at(i)->Dependencies();
+        entry.provides.clear();
+        foreach (const QString& id, ids) {
+            if (!registered.contains(id))
+                entry.provides.append(id);
+        }
+        registered = ids;
+    }
+    loadedPluginNames_.append(newPluginNames);
+    foreach (const QString& newName, newPluginNames)
+        deferredPluginNames_.removeAll(newName);
+
+    // Init newly loaded plugins
+    SensorManager& sm = SensorManager::instance();
+    for (int i = 0; i < newPlugins.size(); ++i) {
+        int instances = sm.getInstanceCount();
+        newPlugins.at(i)->Init(*this);
+
+        // Plugins starting sensors when initialized can not wait for a request.
+        ManifestEntry& entry = manifest_[newPluginNames.at(i)];
+        entry.eager = sm.getInstanceCount() != instances;
+        QFileInfo info(pluginPath(newPluginNames.at(i)));
+        entry.modified = info.lastModified().toTime_t();
+        entry.size = info.size();
+    }
+
+    if (!manifestPath_.isEmpty())
+        writeManifest();
+    return true;
+}
+
+int Loader::unloadIdlePlugins()
+{
+    SensorManager& sm = SensorManager::instance();
+    bool chains = false;
+    foreach (const QString& id, sm.getChainTypes())
+        chains = chains || sm.isInstantiated(id);
+
+    // Dependencies are loaded before their users, so unload in reverse.
+    int unloaded = 0;
+    for (int i = loadedPluginNames_.size() - 1; i >= 0; --i) {
+        QString name = loadedPluginNames_.at(i);
+        QMap<QString, ManifestEntry>::const_iterator it = manifest_.find(name);
+        if (it == manifest_.end() || it.value().eager || it.value().provides.isEmpty() || !pluginLoaders_.contains(name))
+            continue;
+
+        bool used = false;
+        foreach (const QString& id, it.value().provides)
+            used = used || sm.isInstantiated(id) || (chains && sm.getFilterTypes().contains(id));
+        // Loaded plugins depending on this one keep it in use.
+        for (int j = i + 1; j < loadedPluginNames_.size() && !used; ++j) {
+            foreach (const QString& dependency, manifest_.value(loadedPluginNames_.at(j)).dependencies)
+                used = used || resolveRealPluginName(dependency) == name;
+        }
+        if (used)
+            continue;
+
+        sensordLogD() << "Unloading idle plugin " << name;
+        foreach (const QString& id, it.value().provides)
+            sm.unregister(id);
+        QPluginLoader* qpl = pluginLoaders_.take(name);
+        if (!qpl->unload())
+            sensordLogW() << "Failed to unload plugin " << name << ": " << qpl->errorString();
+        delete qpl;
+        loadedPluginNames_.removeAt(i);
+        deferredPluginNames_.append(name);
+        ++unloaded;
+    }
+    return unloaded;
+}
+
+void Loader::registerStaticPlugin(const QString& name, const QString& className)
+{
+    staticPlugins_.insert(name, className);
+}
+
+PluginBase* Loader::staticPlugin(const QString& name) const
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    QMap<QString, QString>::const_iterator it = staticPlugins_.find(name);
+    if (it == staticPlugins_.end())
+        return NULL;
+    foreach (const QStaticPlugin& linked, QPluginLoader::staticPlugins()) {
+        if (linked.metaData().value("className").toString() == it.value()) {
+            sensordLogD() << "Using statically linked plugin " << name;
+            return qobject_cast<PluginBase*>(linked.instance());
+        }
+    }
+    sensordLogW() << "Statically linked plugin " << name << " not found";
+#else
+    Q_UNUSED(name);
+#endif
+    return NULL;
+}
+
+bool Loader::manifestCurrent(const QString& name, QStringList& visited) const
+{
+    if (visited.contains(name) || loadedPluginNames_.contains(name))
+        return true;
+    visited.append(name);
+
+    QMap<QString, ManifestEntry>::const_iterator it = manifest_.find(name);
+    if (it == manifest_.end())
+        return false;
+    QFileInfo info(pluginPath(name));
+    if (!info.exists() || (qint64)info.lastModified().toTime_t() != it.value().modified || info.size() != it.value().size)
+        return false;
+
+    foreach (const QString& dependency, it.value().dependencies) {
+        if (!loadedPluginNames_.contains(dependency) &&
+            !manifestCurrent(resolveRealPluginName(dependency), visited))
+            return false;
+    }
+    return true;
+}
+
+void Loader::readManifest()
+{
+    QSettings settings(manifestPath_, QSettings::IniFormat);
+    foreach (const QString& name, settings.childGroups()) {
+        settings.beginGroup(name);
+        ManifestEntry entry;
+        entry.modified = settings.value("modified").toLongLong();
+        entry.size = settings.value("size").toLongLong();
+        entry.eager = settings.value("eager").toBool();
+        entry.dependencies = settings.value("dependencies").toStringList();
+        entry.provides = settings.value("provides").toStringList();
+        manifest_.insert(name, entry);
+        settings.endGroup();
+    }
+    sensordLogD() << "Read manifest of " << manifest_.size() << " plugins from " << manifestPath_;
+}
+
+void Loader::writeManifest() const
+{
+    QSettings settings(manifestPath_, QSettings::IniFormat);
+    settings.clear();
+    for (QMap<QString, ManifestEntry>::const_iterator it = manifest_.begin(); it != manifest_.end(); ++it) {
+        settings.beginGroup(it.key());
+        settings.setValue("modified", it.value().modified);
+        settings.setValue("size", it.value().size);
+        settings.setValue("eager", it.value().eager);
+        settings.setValue("dependencies", it.value().dependencies);
+        settings.setValue("provides", it.value().provides);
+        settings.endGroup();
+    }
+    settings.sync();
+    if (settings.status() != QSettings::NoError)
+        sensordLogW() << "Failed to write plugin manifest " << manifestPath_;
+}
+
+QStringList Loader::registeredIds()
+{
+    SensorManager& sm = SensorManager::instance();
+    return sm.getSensorTypes() + sm.getChainTypes() + sm.getAdaptorTypes() + sm.getFilterTypes();
 }
 
 QString Loader::resolveRealPluginName(const QString& pluginName) const
@@ -30,10 +30,33 @@
 
 #include <QString>
 #include <QStringList>
+#include <QMap>
 #include "plugin.h"
 
+class QPluginLoader;
+
 /**
  * Utility to load plugins. Class uses singleton-pattern.
+ *
+ * Loader keeps a manifest of the plugins it has loaded: dependencies of
+ * each plugin and the sensors, chains and adaptors it registers. When
+ * the manifest of a plugin and its dependencies matches the installed
+ * files, loading the plugin is deferred until one of the IDs it
+ * provides is requested. The manifest is stored in the file configured
+ * with <tt>global/plugin_manifest</tt>; deferring is disabled when the
+ * setting is empty.
+ *
+ * Plugins whose sensors, chains and adaptors are all idle can be
+ * unloaded with #unloadIdlePlugins(). They are deferred again and loaded
+ * back when one of their IDs is requested. *
+ * Plugins linked statically into sensord are announced with
+ * #registerStaticPlugin() and are used instead of a plugin file of the
+ * same name. They are never deferred or unloaded.
+ *
+ * #preloadPlugins() loads a set of plugins at startup. Their files and
+ * the files of their dependencies are loaded concurrently in the
+ * WorkerPool, registering and initializing them is left to the main
+ * thread.
  */
 class Loader
 {
@@ -53,7 +76,60 @@ public:
      */
     bool loadPlugin(const QString& name, QString* errorMessage = 0);
 
+    /**
+     * Load the deferred plugin providing given sensor, chain or adaptor.
+     *
+     * @param id sensor, chain or adaptor ID.
+     * @return was a plugin providing the ID loaded.
+     */
+    bool loadDeferredPlugin(const QString& id);
+
+    /**
+     * Load given plugins as with #loadPlugin(). Plugin files which are
+     * not deferred are first loaded in the WorkerPool, one wave of
+     * independent files at a time, dependencies in the next wave.
+     * Plugins are then registered and initialized in the calling thread
+     * in the given order.
+     *
+     * @param names plugin names.
+     * @return number of plugins loaded successfully.
+     */
+    int preloadPlugins(const QStringList& names);
+
+    /**
+     * Unload plugins which have a manifest entry and none of whose
+     * sensors, chains or adaptors are instantiated. Plugins providing
+     * filters are kept while any chain exists.
+     *
+     * @return number of unloaded plugins.
+     */
+    int unloadIdlePlugins();
+
+    /**
+     * Announce a plugin linked statically into the binary with
+     * Q_IMPORT_PLUGIN. Loading the plugin by name uses the linked
+     * instance instead of a plugin file.
+     *
+     * @param name plugin name.
+     * @param className class name of the plugin.
+     */
+    void registerStaticPlugin(const QString& name, const QString& className);
+
 private:
+    /**
+     * Manifest entry of a plugin.
+     */
+    struct ManifestEntry
+    {
+        ManifestEntry() : modified(0), size(0), eager(false) {}
+
+        qint64      modified;     /**< modification time of the plugin file */
+        qint64      size;         /**< size of the plugin file */
+        bool        eager;        /**< does the plugin start something when initialized */
+        QStringList dependencies; /**< plugins the plugin depends on, unresolved */
+        QStringList provides;     /**< IDs registered by the plugin */
+    };
+
     Loader();
     Loader(const Loader&);
     Loader& operator=(const Loader&);
@@ -65,8 +141,9 @@ private:
      * @param errorString object to write error message if plugin loading fails.
      * @param newPluginNames List of new loaded plugin names.
      * @param newPlugin List of new loaded plugin objects.
+     * @param newLoaders List of loaders of the new plugins.
      */
-    bool loadPluginFile(const QString& name, QString *errorString, QStringList& newPluginNames, QList<PluginBase*>& newPlugins) const;
+    bool loadPluginFile(const QString& name, QString *errorString, QStringList& newPluginNames, QList<PluginBase*>& newPlugins, QList<QPluginLoader*>& newLoaders) const;
 
     /**
      * Resolve plugin name.
@@ -76,7 +153,72 @@ private:
      */
     QString resolveRealPluginName(const QString& pluginName) const;
 
+    /**
+     * Path of the plugin file.
+     *
+     * @param name plugin name.
+     * @return plugin path.
+     */
+    static QString pluginPath(const QString& name);
+
+    /**
+     * Instance of a statically linked plugin.
+     *
+     * @param name plugin name.
+     * @return plugin instance, or NULL if the plugin is not linked in.
+     */
+    PluginBase* staticPlugin(const QString& name) const;
+
+    /**
+     * Does the manifest match the installed plugin and its dependencies.
+     *
+     * @param name plugin name.
+     * @param visited plugins already checked.
+     * @return is manifest entry current.
+     */
+    bool manifestCurrent(const QString& name, QStringList& visited) const;
+
+    /**
+     * Would loading the plugin be deferred.
+     *
+     * @param name plugin name.
+     * @return can plugin wait for its first use.
+     */
+    bool deferrable(const QString& name) const;
+
+    /**
+     * Load plugin and its dependencies now.
+     *
+     * @param name plugin name.
+     * @param errorString object to write error message if plugin loading fails.
+     * @return was plugin loaded.
+     */
+    bool loadPluginNow(const QString& name, QString* errorString);
+
+    /**
+     * Read the manifest file.
+     */
+    void readManifest();
+
+    /**
+     * Write the manifest file.
+     */
+    void writeManifest() const;
+
+    /**
+     * All IDs registered to SensorManager.
+     *
+     * @return registered IDs.
+     */
+    static QStringList registeredIds();
+
     QStringList loadedPluginNames_; /**< list of loaded plugins */
+    QStringList deferredPluginNames_; /**< plugins waiting for their first use */
+    QMap<QString, ManifestEntry> manifest_; /**< manifest of known plugins */
+    QString manifestPath_; /**< manifest file, empty if not used */
+    QMap<QString, QPluginLoader*> pluginLoaders_; /**< loaders of loaded plugins */
+    QMap<QString, QString> staticPlugins_; /**< class names of statically linked plugins */
+    QMap<QString, QPluginLoader*> preloaded_; /**< loaders of preloaded plugin files, not yet registered */
 };
 
 #endif
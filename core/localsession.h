@@ -0,0 +1,54 @@
+/**
+   @file localsession.h
+   @brief LocalSession
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef LOCALSESSION_H
+#define LOCALSESSION_H
+
+/**
+ * Receiver of the samples of a session living in the same process as
+ * the sensor channels, used instead of a socket when sensord is
+ * embedded into an application, see SensorManager::setEmbedded().
+ * Both methods are called from the delivery thread.
+ */
+class LocalSession
+{
+public:
+    virtual ~LocalSession() {}
+
+    /**
+     * Take a sample delivered to the session. Sample has gone through
+     * the same downsampling and change only handling as for sockets.
+     *
+     * @param source sample.
+     * @param size size of the sample.
+     * @return was sample taken.
+     */
+    virtual bool write(const void* source, int size) = 0;
+
+    /**
+     * End of a delivery round which wrote samples to the session.
+     */
+    virtual void flush() = 0;
+};
+
+#endif // LOCALSESSION_H
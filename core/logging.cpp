@@ -32,6 +32,159 @@
 #include <QMutexLocker>
 #include <syslog.h>
 #include <QDateTime>
+#include <QThread>
+#include <QSemaphore>
+#include <QAtomicInt>
+#include <string.h>
+
+/**
+ * Background writer for asynchronous logging. Messages are queued into
+ * a bounded ring of preallocated records, any thread may push and only
+ * the writer thread pops. The ring uses the same per-slot sequence
+ * numbers as SampleQueue. Pushing never blocks; if the ring is full the
+ * message is dropped and counted.
+ */
+class SensordLogWriter : public QThread
+{
+public:
+    SensordLogWriter(unsigned int capacity);
+    ~SensordLogWriter();
+
+    /**
+     * Queue message. Safe to call from any thread.
+     *
+     * @param level log level.
+     * @param data text to be logged. Truncated to the record size.
+     */
+    void push(int level, const char* data);
+
+    /**
+     * Write remaining messages and stop the thread.
+     */
+    void stop();
+
+protected:
+    void run();
+
+private:
+    static const int MAX_TEXT = 500;
+
+    struct Record
+    {
+        QAtomicInt sequence;       /**< slot sequence number */
+        int        level;          /**< log level */
+        qint64     time;           /**< time of the message */
+        char       text[MAX_TEXT]; /**< zero terminated message */
+    };
+
+    bool writeNext();
+
+    Record*      records_;   /**< preallocated records */
+    unsigned int mask_;      /**< capacity - 1 */
+    QAtomicInt   writePos_;  /**< next position to write */
+    unsigned int readPos_;   /**< next position to read */
+    QSemaphore   pending_;   /**< wakes up the writer */
+    QAtomicInt   stopping_;  /**< should writer stop */
+    unsigned int reported_;  /**< dropped messages already reported */
+};
+
+static QAtomicInt droppedCount;
+
+SensordLogWriter::SensordLogWriter(unsigned int capacity) :
+    records_(0),
+    mask_(0),
+    writePos_(0),
+    readPos_(0),
+    stopping_(0),
+    reported_(droppedCount.load())
+{
+    unsigned int size = 1;
+    while (size < capacity)
+        size <<= 1;
+
+    records_ = new Record[size];
+    mask_ = size - 1;
+    for (unsigned int i = 0; i < size; ++i)
+        records_[i].sequence.store(i);
+}
+
+SensordLogWriter::~SensordLogWriter()
+{
+    stop();
+    delete[] records_;
+}
+
+void SensordLogWriter::push(int level, const char* data)
+{
+    unsigned int pos = writePos_.load();
+    Record* record;
+    for (;;)
+    {
+        record = &records_[pos & mask_];
+        int diff = (int)((unsigned int)record->sequence.loadAcquire() - pos);
+        if (diff == 0)
+        {
+            if (writePos_.testAndSetRelaxed(pos, pos + 1))
+                break;
+        }
+        else if (diff < 0)
+        {
+            droppedCount.ref();
+            return;
+        }
+        pos = writePos_.load();
+    }
+
+    record->level = level;
+    record->time = QDateTime::currentMSecsSinceEpoch();
+    strncpy(record->text, data, MAX_TEXT - 1);
+    record->text[MAX_TEXT - 1] = '\0';
+    record->sequence.storeRelease(pos + 1);
+    pending_.release();
+}
+
+bool SensordLogWriter::writeNext()
+{
+    Record& record = records_[readPos_ & mask_];
+    if ((int)((unsigned int)record.sequence.loadAcquire() - (readPos_ + 1)) < 0)
+        return false;
+
+    SensordLogger::writeToTargets(record.level, record.time, record.text);
+    record.sequence.storeRelease(readPos_ + mask_ + 1);
+    ++readPos_;
+    return true;
+}
+
+void SensordLogWriter::stop()
+{
+    if (!isRunning())
+        return;
+    stopping_.store(1);
+    pending_.release();
+    wait();
+}
+
+void SensordLogWriter::run()
+{
+    for (;;)
+    {
+        pending_.acquire(qMax(1, pending_.available()));
+
+        while (writeNext())
+            ;
+
+        unsigned int dropped = droppedCount.load();
+        if (dropped != reported_)
+        {
+            QByteArray text = QByteArray::number(dropped - reported_) + " log messages dropped";
+            SensordLogger::writeToTargets(SensordLogWarning, QDateTime::currentMSecsSinceEpoch(), text.constData());
+            reported_ = dropped;
+        }
+
+        if (stopping_.load())
+            break;
+    }
+}
 
 SensordLogLevel SensordLogger::outputLevel = SensordLogWarning;
 bool SensordLogger::initialized = false;
@@ -39,6 +192,7 @@ int SensordLogger::logTarget = 0;
 QMutex SensordLogger::mutex;
 std::ofstream* SensordLogger::logFile = 0;
 QByteArray SensordLogger::appName = "";
+SensordLogWriter* SensordLogger::writer = 0;
 
 SensordLogger::SensordLogger (const char* func, const char *file, int line, SensordLogLevel level) :
     oss(0),
@@ -53,10 +207,11 @@ SensordLogger::SensordLogger (const char* func, const char *file, int line, Sens
 
 SensordLogger::~SensordLogger()
 {
-    if (!initialized || !isLoggable(currentLevel))
+    if (!oss)
         return;
 
-    printToTarget(oss->str().c_str());
+    if (initialized && isLoggable(currentLevel))
+        printToTarget(oss->str().c_str());
     delete oss;
 }
 
@@ -67,6 +222,7 @@ void SensordLogger::setOutputLevel(SensordLogLevel level)
 
 void SensordLogger::close()
 {
+    setAsynchronous(false);
     if (initialized)
     {
         closelog();
@@ -76,17 +232,44 @@ void SensordLogger::close()
     }
 }
 
+void SensordLogger::setAsynchronous(bool async)
+{
+    if (async && !writer)
+    {
+        writer = new SensordLogWriter(256);
+        writer->start();
+    }
+    else if (!async && writer)
+    {
+        delete writer;
+        writer = 0;
+    }
+}
+
+unsigned int SensordLogger::droppedMessages()
+{
+    return droppedCount.load();
+}
+
 void SensordLogger::printToTarget(const char* data) const
 {
     if (logTarget == 0)
         return;
+    if (writer)
+        writer->push(currentLevel, data);
+    else
+        writeToTargets(currentLevel, QDateTime::currentMSecsSinceEpoch(), data);
+}
+
+void SensordLogger::writeToTargets(int level, qint64 time, const char* data)
+{
     QMutexLocker locker(&mutex);
     std::ostringstream fdLogData;
 
     if (logTarget & STDERR_FILENO ||
         logTarget & STDOUT_FILENO ||
         logTarget & 4) {
-        fdLogData << QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss").toLocal8Bit().data();
+        fdLogData << QDateTime::fromMSecsSinceEpoch(time).toString("yyyy-MM-dd hh:mm:ss").toLocal8Bit().data();
         fdLogData << " [" << appName.constData() << "] ";
         fdLogData << data;
     }
@@ -104,7 +287,7 @@ void SensordLogger::printToTarget(const char* data) const
     }
 
     if (logTarget & 8) {
-        syslog(logPriority(currentLevel), "%s", data);
+        syslog(logPriority(level), "%s", data);
     }
 }
 
@@ -34,6 +34,8 @@
 #include <QStringList>
 #include <QMutex>
 
+class SensordLogWriter;
+
 /**
  * Log levels
  */
@@ -46,6 +48,16 @@ enum SensordLogLevel
     SensordLogN
 };
 
+/**
+ * Lowest log level compiled in. Messages below this level are removed at
+ * compile time, including the evaluation of their arguments. Can be
+ * raised for production builds, for example with
+ * <tt>-DSENSORD_LOG_MIN_LEVEL=SensordLogWarning</tt>.
+ */
+#ifndef SENSORD_LOG_MIN_LEVEL
+#define SENSORD_LOG_MIN_LEVEL SensordLogTest
+#endif
+
 /**
  * Logging utility. All sensorfw logging is done using this class.
  * Set of macro functions exists for convenient usage.
@@ -136,6 +148,18 @@ public:
      */
     static inline SensordLogLevel getOutputLevel() { return outputLevel; }
 
+    /**
+     * Would a message of given level be logged. Used by the logging
+     * macros to skip constructing the logger for disabled levels.
+     *
+     * @param level log level.
+     * @return is level enabled.
+     */
+    static inline bool isEnabled(SensordLogLevel level)
+    {
+        return level >= SENSORD_LOG_MIN_LEVEL && initialized && isLoggable(level);
+    }
+
     /**
      * Initialize logger. This must be called once in the application
      * lifetime before using logger.
@@ -157,6 +181,27 @@ public:
      */
     static void close();
 
+    /**
+     * Write log messages from a background thread. Logging threads
+     * then only copy the formatted message into a lock-free ring and
+     * never block on the log targets. If the ring is full the message
+     * is dropped and counted, see #droppedMessages().
+     *
+     * Must be called after the process has forked, and not while other
+     * threads are logging. Disabling flushes the queued messages.
+     *
+     * @param async use background writer thread.
+     */
+    static void setAsynchronous(bool async);
+
+    /**
+     * Number of messages dropped because the background writer did not
+     * keep up.
+     *
+     * @return dropped message count.
+     */
+    static unsigned int droppedMessages();
+
 private:
     std::ostringstream* oss;             /**< log buffer */
     SensordLogLevel currentLevel;        /**< level for current message */
@@ -167,6 +212,9 @@ private:
     static QMutex mutex;                 /**< logger mutex */
     static int logTarget;                /**< log target */
     static QByteArray appName;           /**< application name */
+    static SensordLogWriter* writer;     /**< background writer, if any */
+
+    friend class SensordLogWriter;
 
     /**
      * Print given data to the configured log targets.
@@ -175,6 +223,16 @@ private:
      */
     void printToTarget(const char* data) const;
 
+    /**
+     * Write message to the configured log targets. Called directly
+     * or from the background writer.
+     *
+     * @param level log level.
+     * @param time time of the message in milliseconds since epoch.
+     * @param data text to be logged.
+     */
+    static void writeToTargets(int level, qint64 time, const char* data);
+
     /**
      * Convert log level into syslog priority.
      *
@@ -203,10 +261,29 @@ private:
     }
 };
 
-#define sensordLogT() (SensordLogger(__PRETTY_FUNCTION__, __FILE__, __LINE__, SensordLogTest))
-#define sensordLogD() (SensordLogger(__PRETTY_FUNCTION__, __FILE__, __LINE__, SensordLogDebug))
-#define sensordLogW() (SensordLogger(__PRETTY_FUNCTION__, __FILE__, __LINE__, SensordLogWarning))
-#define sensordLogC() (SensordLogger(__PRETTY_FUNCTION__, __FILE__, __LINE__, SensordLogCritical))
-#define sensordLog() (SensordLogger(__PRETTY_FUNCTION__, __FILE__, __LINE__, SensordLogTest))
+/**
+ * Turns a logger expression into void, so that it can be used as the
+ * other branch of the conditional in #SENSORD_LOG. The operator binds
+ * weaker than <<, so the whole stream expression is on its right side.
+ */
+class SensordLogVoidify
+{
+public:
+    void operator&(const SensordLogger&) {}
+};
+
+/**
+ * Log with given level. When the level is disabled neither the logger
+ * nor the streamed arguments are evaluated.
+ */
+#define SENSORD_LOG(level) \
+    !SensordLogger::isEnabled(level) ? (void)0 : \
+    SensordLogVoidify() & SensordLogger(__PRETTY_FUNCTION__, __FILE__, __LINE__, level)
+
+#define sensordLogT() SENSORD_LOG(SensordLogTest)
+#define sensordLogD() SENSORD_LOG(SensordLogDebug)
+#define sensordLogW() SENSORD_LOG(SensordLogWarning)
+#define sensordLogC() SENSORD_LOG(SensordLogCritical)
+#define sensordLog() SENSORD_LOG(SensordLogTest)
 
 #endif //LOGGING_H
@@ -0,0 +1,72 @@
+/**
+   @file mcedispatcher.cpp
+   @brief MceDispatcher
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include <mce/dbus-names.h>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include "mcedispatcher.h"
+#include "logging.h"
+
+MceDispatcher& MceDispatcher::instance()
+{
+    static MceDispatcher dispatcher;
+    return dispatcher;
+}
+
+MceDispatcher::MceDispatcher()
+{
+}
+
+void MceDispatcher::request(const QString& method)
+{
+    sensordLogT() << "Requesting MCE: " << method;
+    QDBusMessage message = QDBusMessage::createMethodCall(MCE_SERVICE, MCE_REQUEST_PATH, MCE_REQUEST_IF, method);
+    if (!QDBusConnection::systemBus().callWithCallback(message, this, SLOT(requestDone()), SLOT(requestFailed(QDBusError))))
+        sensordLogW() << "Failed to send MCE request " << method;
+}
+
+void MceDispatcher::setRequested(const QString& key, bool enabled,
+                                 const QString& enableMethod, const QString& disableMethod)
+{
+    QHash<QString, bool>::const_iterator it = requested_.constFind(key);
+    if (it != requested_.constEnd() && it.value() == enabled)
+        return;
+    requested_.insert(key, enabled);
+    request(enabled ? enableMethod : disableMethod);
+}
+
+void MceDispatcher::query(const QString& method, QObject* receiver, const char* slot)
+{
+    QDBusMessage message = QDBusMessage::createMethodCall(MCE_SERVICE, MCE_REQUEST_PATH, MCE_REQUEST_IF, method);
+    if (!QDBusConnection::systemBus().callWithCallback(message, receiver, slot))
+        sensordLogW() << "Failed to send MCE query " << method;
+}
+
+void MceDispatcher::requestDone()
+{
+}
+
+void MceDispatcher::requestFailed(const QDBusError& error)
+{
+    sensordLogW() << "MCE request failed: " << error.message();
+}
@@ -0,0 +1,101 @@
+/**
+   @file mcedispatcher.h
+   @brief MceDispatcher
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef MCEDISPATCHER_H
+#define MCEDISPATCHER_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QDBusError>
+
+/**
+ * Single place for method calls from sensord to MCE. Every call is
+ * asynchronous, so sensor start and display state handling never wait
+ * for an MCE round trip, and no QDBusInterface is created, as creating
+ * one introspects MCE synchronously. Toggle requests are cached and only
+ * sent when the requested state changes.
+ */
+class MceDispatcher : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(MceDispatcher)
+
+public:
+    /**
+     * Get the dispatcher.
+     *
+     * @return dispatcher instance.
+     */
+    static MceDispatcher& instance();
+
+    /**
+     * Send a request to MCE without waiting for the reply.
+     *
+     * @param method request method, for example <tt>req_als_enable</tt>.
+     */
+    void request(const QString& method);
+
+    /**
+     * Keep a toggled MCE request in given state. The enable or disable
+     * method is sent only when the state differs from the one last
+     * requested for the key.
+     *
+     * @param key name of the toggle, for example <tt>als</tt>.
+     * @param enabled requested state.
+     * @param enableMethod method enabling the feature.
+     * @param disableMethod method disabling the feature.
+     */
+    void setRequested(const QString& key, bool enabled,
+                      const QString& enableMethod, const QString& disableMethod);
+
+    /**
+     * Query MCE asynchronously. The reply arguments are delivered to the
+     * given slot, failures are only logged.
+     *
+     * @param method query method, for example <tt>get_display_status</tt>.
+     * @param receiver object receiving the reply.
+     * @param slot slot taking the reply arguments.
+     */
+    void query(const QString& method, QObject* receiver, const char* slot);
+
+private Q_SLOTS:
+    /**
+     * Reply to a request arrived.
+     */
+    void requestDone();
+
+    /**
+     * Request failed.
+     *
+     * @param error error of the call.
+     */
+    void requestFailed(const QDBusError& error);
+
+private:
+    MceDispatcher();
+
+    QHash<QString, bool> requested_; /**< last requested state of toggles */
+};
+
+#endif // MCEDISPATCHER_H
@@ -28,29 +28,23 @@
 #include <mce/mode-names.h>
 #include <mce/dbus-names.h>
 #include "mcewatcher.h"
+#include "mcedispatcher.h"
+#include <QDBusConnection>
 
 MceWatcher::MceWatcher(QObject* parent) : QObject(parent),
-                                          dbusIfc(new QDBusInterface(MCE_SERVICE,
-                                                                     MCE_SIGNAL_PATH,
-                                                                     MCE_SIGNAL_IF,
-                                                                     QDBusConnection::systemBus(),
-                                                                     parent)),
                                           displayState(true),
                                           powerSave(false)
 {
-    dbusIfc->connection().connect(dbusIfc->service(),
-                                  dbusIfc->path(),
-                                  dbusIfc->interface(),
-                                  MCE_PSM_STATE_SIG,
-                                  this,
-                                  SLOT(slotPSMStateChanged(bool)));
+    // Connecting directly does not introspect MCE like QDBusInterface.
+    QDBusConnection bus = QDBusConnection::systemBus();
+    bus.connect(MCE_SERVICE, MCE_SIGNAL_PATH, MCE_SIGNAL_IF, MCE_PSM_STATE_SIG,
+                this, SLOT(slotPSMStateChanged(bool)));
+    bus.connect(MCE_SERVICE, MCE_SIGNAL_PATH, MCE_SIGNAL_IF, MCE_DISPLAY_SIG,
+                this, SLOT(slotDisplayStateChanged(const QString)));
 
-    dbusIfc->connection().connect(dbusIfc->service(),
-                                  dbusIfc->path(),
-                                  dbusIfc->interface(),
-                                  MCE_DISPLAY_SIG,
-                                  this,
-                                  SLOT(slotDisplayStateChanged(const QString)));
+    // Current state arrives later, until then the display is assumed on.
+    MceDispatcher::instance().query(MCE_DISPLAY_STATUS_GET, this, SLOT(slotDisplayStateChanged(const QString)));
+    MceDispatcher::instance().query(MCE_PSM_STATE_GET, this, SLOT(slotPSMStateChanged(bool)));
 }
 
 void MceWatcher::slotDisplayStateChanged(const QString& state)
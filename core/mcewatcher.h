@@ -30,7 +30,6 @@
 #define SENSORD_MCE_WATCHER_H
 
 #include <QObject>
-#include <QDBusInterface>
 #include <QString>
 
 /**
@@ -95,7 +94,6 @@ private slots:
     void slotPSMStateChanged(bool mode);
 
 private:
-    QDBusInterface* dbusIfc; /**< DBus iface to MCE */
     bool displayState;       /**< current display state */
     bool powerSave;          /**< current powersave-mode state */
 
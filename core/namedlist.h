@@ -0,0 +1,114 @@
+/**
+   @file namedlist.h
+   @brief NamedList
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef NAMEDLIST_H
+#define NAMEDLIST_H
+
+#include <QString>
+#include <QVarLengthArray>
+#include "stringpool.h"
+
+/**
+ * Compact list of named pointers, used for the sources and sinks of
+ * nodes. Almost every node has one or two of them, so the first
+ * PREALLOC entries are stored inside the list itself and lookups are
+ * linear. Names are interned with StringPool.
+ */
+template <class TYPE, int PREALLOC = 2>
+class NamedList
+{
+public:
+    /**
+     * Add entry, replacing any entry with the same name.
+     *
+     * @param name entry name.
+     * @param value entry value.
+     */
+    void insert(const QString& name, TYPE* value)
+    {
+        int index = indexOf(name);
+        if (index >= 0) {
+            entries_[index].value = value;
+            return;
+        }
+        Entry entry;
+        entry.name = StringPool::intern(name);
+        entry.value = value;
+        entries_.append(entry);
+    }
+
+    /**
+     * Find entry with given name.
+     *
+     * @param name entry name.
+     * @return value of the entry or NULL if not found.
+     */
+    TYPE* value(const QString& name) const
+    {
+        int index = indexOf(name);
+        return index >= 0 ? entries_[index].value : NULL;
+    }
+
+    /**
+     * Number of entries.
+     *
+     * @return entry count.
+     */
+    int size() const { return entries_.size(); }
+
+    /**
+     * Value of the entry at given index.
+     *
+     * @param index entry index.
+     * @return entry value.
+     */
+    TYPE* at(int index) const { return entries_[index].value; }
+
+    /**
+     * Name of the entry at given index.
+     *
+     * @param index entry index.
+     * @return entry name.
+     */
+    const QString& nameAt(int index) const { return entries_[index].name; }
+
+private:
+    struct Entry
+    {
+        QString name;  /**< interned name */
+        TYPE*   value; /**< value */
+    };
+
+    int indexOf(const QString& name) const
+    {
+        for (int i = 0; i < entries_.size(); ++i) {
+            if (entries_[i].name == name)
+                return i;
+        }
+        return -1;
+    }
+
+    QVarLengthArray<Entry, PREALLOC> entries_; /**< entries in insertion order */
+};
+
+#endif // NAMEDLIST_H
@@ -28,18 +28,67 @@
 #include "logging.h"
 #include "ringbuffer.h"
 #include "config.h"
+#include "chainworker.h"
+#include "stringpool.h"
+#include <limits.h>
+
+/**
+ * Read interval arbitration mode from configuration.
+ *
+ * @return is deadline arbitration configured.
+ */
+static bool configuredDeadlineArbitration()
+{
+    Config* config = Config::configuration();
+    return config && config->value<QString>("global/interval_arbitration", "fastest") == "deadline";
+}
+
+/**
+ * Read interval snapping from configuration.
+ *
+ * @return is interval snapping configured.
+ */
+static bool configuredIntervalSnapping()
+{
+    Config* config = Config::configuration();
+    return config && config->value<bool>("global/interval_snapping", false);
+}
+
+/**
+ * Greatest common divisor.
+ */
+static unsigned int greatestCommonDivisor(unsigned int a, unsigned int b)
+{
+    while (b) {
+        unsigned int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
 
 NodeBase::NodeBase(const QString& id, QObject* parent) :
     QObject(parent),
     m_bufferSize(0),
     m_bufferInterval(0),
+    m_metadataVersion(0),
+    m_standbyRequestCount(0),
+    m_motionWakeupRequestCount(0),
+    m_motionWakeupBlockingCount(0),
+    m_dataRangeSequence(0),
     m_dataRangeSource(NULL),
+    m_motionWakeup(false),
     m_intervalSource(NULL),
     m_hasDefault(false),
     m_defaultInterval(0),
+    m_deadlineArbitration(configuredDeadlineArbitration()),
+    m_intervalSnapping(configuredIntervalSnapping()),
+    m_intervalFloor(0),
+    m_worker(NULL),
     DEFAULT_DATA_RANGE_REQUEST(-1),
-    id_(id),
-    isValid_(false)
+    id_(StringPool::intern(id)),
+    isValid_(false),
+    statistics_(id_)
 {
 }
 
@@ -47,11 +96,53 @@ NodeBase::~NodeBase()
 {
 }
 
+quint64 NodeBase::intervalKey(unsigned int value, int sessionId)
+{
+    // Flip the sign bit so session IDs keep their signed order.
+    return ((quint64)value << 32) | ((quint32)sessionId ^ 0x80000000u);
+}
+
+NodeBase::SessionRequests NodeBase::takeSession(int sessionId)
+{
+    QMap<int, SessionRequests>::iterator it = m_sessions.find(sessionId);
+    if (it == m_sessions.end())
+        return SessionRequests();
+
+    SessionRequests requests = it.value();
+    m_sessions.erase(it);
+    if (requests.standbyOverride)
+        --m_standbyRequestCount;
+    if (requests.motionWakeup)
+        --m_motionWakeupRequestCount;
+    else if (requests.hasInterval || requests.standbyOverride)
+        --m_motionWakeupBlockingCount;
+    return requests;
+}
+
+void NodeBase::storeSession(int sessionId, const SessionRequests& requests)
+{
+    if (requests.isEmpty())
+        return;
+
+    m_sessions.insert(sessionId, requests);
+    if (requests.standbyOverride)
+        ++m_standbyRequestCount;
+    if (requests.motionWakeup)
+        ++m_motionWakeupRequestCount;
+    else if (requests.hasInterval || requests.standbyOverride)
+        ++m_motionWakeupBlockingCount;
+}
+
 const QString& NodeBase::id() const
 {
     return id_;
 }
 
+NodeStatistics& NodeBase::statistics()
+{
+    return statistics_;
+}
+
 bool NodeBase::isValid() const
 {
     return isValid_;
@@ -71,9 +162,41 @@ const QString& NodeBase::description() const
     return m_description;
 }
 
+void NodeBase::notifyPropertyChanged(const QString& name)
+{
+    if (m_changedProperties.contains(name))
+        return;
+    if (m_changedProperties.isEmpty())
+        QMetaObject::invokeMethod(this, "flushPropertyChanges", Qt::QueuedConnection);
+    m_changedProperties.append(name);
+}
+
+void NodeBase::flushPropertyChanges()
+{
+    QStringList names(m_changedProperties);
+    m_changedProperties.clear();
+    foreach (const QString& name, names)
+        emit propertyChanged(name);
+    emit propertiesChanged(names);
+}
+
+unsigned int NodeBase::metadataVersion() const
+{
+    unsigned int version = m_metadataVersion;
+    if (m_dataRangeSource)
+        version += m_dataRangeSource->metadataVersion();
+    if (m_intervalSource)
+        version += m_intervalSource->metadataVersion();
+    return version;
+}
+
 void NodeBase::setDescription(const QString& str)
 {
-    m_description = str;
+    if (m_description == str)
+        return;
+    m_description = StringPool::intern(str);
+    ++m_metadataVersion;
+    emit metadataChanged();
 }
 
 void NodeBase::introduceAvailableDataRange(const DataRange& range)
@@ -82,6 +205,8 @@ void NodeBase::introduceAvailableDataRange(const DataRange& range)
     {
         sensordLogD() << "Introduced new data range: " << range.min << "-" << range.max << ", " << range.resolution;
         m_dataRangeList.append(range);
+        ++m_metadataVersion;
+        emit metadataChanged();
     }
 }
 
@@ -116,7 +241,7 @@ DataRangeRequest NodeBase::getCurrentDataRange() const
         if (m_dataRangeQueue.empty()) {
             return DataRangeRequest(-1, m_dataRangeList.at(0));
         }
-        return m_dataRangeQueue.at(0);
+        return m_dataRangeQueue.constBegin().value();
     } else {
         return m_dataRangeSource->getCurrentDataRange();
     }
@@ -141,24 +266,22 @@ void NodeBase::requestDataRange(int sessionId, const DataRange& range)
                 rangeChanged = true;
             }
         } else {
-            if (m_dataRangeQueue.at(0).id == sessionId && !(m_dataRangeQueue.at(0).range == range)) {
+            const DataRangeRequest& first = m_dataRangeQueue.constBegin().value();
+            if (first.id == sessionId && !(first.range == range)) {
                 rangeChanged = true;
             }
         }
 
-        // If an earlier request exists by same id, replace.
-        bool hadPreviousRequest = false;
-        for (int i = 0; i < m_dataRangeQueue.size() && hadPreviousRequest == false; ++i) {
-            if (m_dataRangeQueue.at(i).id == sessionId) {
-                m_dataRangeQueue[i].range = range;
-                hadPreviousRequest = true;
-            }
-        }
-
-        if (!hadPreviousRequest) {
-            DataRangeRequest request(sessionId, range);
-            m_dataRangeQueue.append(request);
+        // If an earlier request exists by same id, replace. Otherwise
+        // queue it after the others.
+        SessionRequests requests = takeSession(sessionId);
+        if (requests.dataRangeSequence) {
+            m_dataRangeQueue.find(requests.dataRangeSequence).value().range = range;
+        } else {
+            requests.dataRangeSequence = ++m_dataRangeSequence;
+            m_dataRangeQueue.insert(requests.dataRangeSequence, DataRangeRequest(sessionId, range));
         }
+        storeSession(sessionId, requests);
 
         if (rangeChanged)
         {
@@ -167,7 +290,7 @@ void NodeBase::requestDataRange(int sessionId, const DataRange& range)
             {
                 sensordLogW() << "Failed to set DataRange.";
             }
-            emit propertyChanged("datarange");
+            notifyPropertyChanged("datarange");
         }
     } else {
         m_dataRangeSource->requestDataRange(sessionId, range);
@@ -178,25 +301,25 @@ void NodeBase::removeDataRangeRequest(int sessionId)
 {
     if (hasLocalRange())
     {
-        int index = -1;
-        for (int i = 0; i < m_dataRangeQueue.size() && index == -1; ++i) {
-            if (m_dataRangeQueue.at(i).id == sessionId) {
-                index = i;
-            }
-        }
-
-        if (index < 0) {
+        QMap<int, SessionRequests>::const_iterator session = m_sessions.constFind(sessionId);
+        if (session == m_sessions.constEnd() || !session.value().dataRangeSequence) {
             sensordLogD() << "No data range request for id " << sessionId;
             return;
         }
 
-        DataRangeRequest request = m_dataRangeQueue.takeAt(index);
+        SessionRequests requests = takeSession(sessionId);
+        bool wasFirst = requests.dataRangeSequence == m_dataRangeQueue.constBegin().key();
+        QMap<quint64, DataRangeRequest>::iterator queued = m_dataRangeQueue.find(requests.dataRangeSequence);
+        DataRangeRequest request = queued.value();
+        m_dataRangeQueue.erase(queued);
+        requests.dataRangeSequence = 0;
+        storeSession(sessionId, requests);
 
         bool rangeChanged = false;
 
-        if (index == 0)
+        if (wasFirst)
         {
-            if (((m_dataRangeQueue.size() > 0) && !(m_dataRangeQueue.at(0).range == request.range)) ||
+            if (((m_dataRangeQueue.size() > 0) && !(m_dataRangeQueue.constBegin().value().range == request.range)) ||
                 !(m_dataRangeList.at(0) == request.range))
             {
                 rangeChanged = true;
@@ -210,7 +333,7 @@ void NodeBase::removeDataRangeRequest(int sessionId)
             {
                 sensordLogW() << "Failed to set DataRange.";
             }
-            emit propertyChanged("datarange");
+            notifyPropertyChanged("datarange");
         }
     } else {
         m_dataRangeSource->removeDataRangeRequest(sessionId);
@@ -221,6 +344,10 @@ void NodeBase::setRangeSource(NodeBase* node)
 {
     m_dataRangeSource = node;
     connect(m_dataRangeSource, SIGNAL(propertyChanged(const QString&)), this, SIGNAL(propertyChanged(const QString&)));
+    connect(m_dataRangeSource, SIGNAL(propertiesChanged(const QStringList&)), this, SIGNAL(propertiesChanged(const QStringList&)));
+    connect(m_dataRangeSource, SIGNAL(metadataChanged()), this, SIGNAL(metadataChanged()));
+    ++m_metadataVersion;
+    emit metadataChanged();
 }
 
 bool NodeBase::hasLocalRange() const
@@ -275,6 +402,8 @@ void NodeBase::introduceAvailableInterval(const DataRange& interval)
     {
         sensordLogD() << "Introduced new interval: " << interval.min << "-" << interval.max;
         m_intervalList.append(interval);
+        ++m_metadataVersion;
+        emit metadataChanged();
     }
 }
 
@@ -306,12 +435,12 @@ unsigned int NodeBase::getInterval(int sessionId) const
     {
         return m_intervalSource->getInterval(sessionId);
     }
-    QMap<int, unsigned int>::const_iterator it(m_intervalMap.find(sessionId));
-    if(it == m_intervalMap.end())
+    QMap<int, SessionRequests>::const_iterator it(m_sessions.constFind(sessionId));
+    if(it == m_sessions.constEnd() || !it.value().hasInterval)
     {
         return 0;
     }
-    return it.value();
+    return it.value().interval;
 }
 
 bool NodeBase::setIntervalRequest(const int sessionId, const unsigned int value)
@@ -319,7 +448,9 @@ bool NodeBase::setIntervalRequest(const int sessionId, const unsigned int value)
     // Has single defined source, pass the request that way
     if (!hasLocalInterval())
     {
-        return m_intervalSource->setIntervalRequest(sessionId, value);
+        bool ok = m_intervalSource->setIntervalRequest(sessionId, value);
+        sessionIntervalChanged(sessionId);
+        return ok;
     }
 
     // Validate interval request
@@ -330,16 +461,40 @@ bool NodeBase::setIntervalRequest(const int sessionId, const unsigned int value)
     }
 
     // Store the request for the session
-    m_intervalMap[sessionId] = value;
+    SessionRequests requests = takeSession(sessionId);
+    if (requests.hasInterval)
+        m_intervalIndex.remove(intervalKey(requests.interval, sessionId));
+    requests.interval = value;
+    requests.hasInterval = true;
+    m_intervalIndex.insert(intervalKey(value, sessionId), sessionId);
+    storeSession(sessionId, requests);
+
+    updateInterval();
+    if (m_motionWakeupRequestCount)
+    {
+        updateMotionWakeup();
+    }
 
+    sessionIntervalChanged(sessionId);
+    return true;
+}
+
+void NodeBase::updateInterval()
+{
     // Store the current interval
     unsigned int previousInterval = interval();
 
     // Re-evaluate
     int winningSessionId;
     unsigned int winningRequest = evaluateIntervalRequests(winningSessionId);
-
-    if (winningSessionId >= 0) {
+    if (winningSessionId >= 0 && m_intervalSnapping)
+        winningRequest = snapInterval(winningRequest);
+    if (winningSessionId >= 0 && winningRequest < m_intervalFloor)
+        winningRequest = m_intervalFloor;
+
+    // With deadline arbitration sessions come and go without changing
+    // the result, do not reprogram the hardware for nothing.
+    if (winningSessionId >= 0 && !(m_deadlineArbitration && winningRequest == previousInterval)) {
         sensordLogD() << "Setting new interval for node: " << id() << ". Evaluation won by session '" << winningSessionId << "' with request: " << winningRequest;
         setInterval(winningRequest, winningSessionId);
     }
@@ -347,12 +502,107 @@ bool NodeBase::setIntervalRequest(const int sessionId, const unsigned int value)
     // Signal listeners about change
     if (previousInterval != interval())
     {
-        emit propertyChanged("interval");
+        notifyPropertyChanged("interval");
     }
+}
 
+void NodeBase::reevaluateRequests()
+{
+    if (hasLocalInterval())
+    {
+        updateInterval();
+    }
+    if (!m_bufferIntervalMap.isEmpty())
+    {
+        updateBufferInterval();
+    }
+}
+
+QMap<int, unsigned int> NodeBase::activeIntervalRequests() const
+{
+    QMap<int, unsigned int> all;
+    QMap<int, unsigned int> active;
+    for (QMap<int, SessionRequests>::const_iterator it = m_sessions.constBegin(); it != m_sessions.constEnd(); ++it)
+    {
+        if (!it.value().hasInterval)
+            continue;
+        all.insert(it.key(), it.value().interval);
+        if (m_deadlineArbitration && isSessionActive(it.key())) {
+            active.insert(it.key(), it.value().interval);
+        }
+    }
+    return active.isEmpty() ? all : active;
+}
+
+unsigned int NodeBase::fastestIntervalRequest(int& sessionId, unsigned int minimum) const
+{
+    QMap<quint64, int>::const_iterator first = m_intervalIndex.lowerBound(intervalKey(minimum, INT_MIN));
+
+    if (m_deadlineArbitration)
+    {
+        for (QMap<quint64, int>::const_iterator it = first; it != m_intervalIndex.constEnd(); ++it)
+        {
+            if (isSessionActive(it.value())) {
+                sessionId = it.value();
+                return it.key() >> 32;
+            }
+        }
+        // Active sessions with only smaller requests still keep the
+        // inactive ones out of the evaluation.
+        for (QMap<quint64, int>::const_iterator it = m_intervalIndex.constBegin(); it != first; ++it)
+        {
+            if (isSessionActive(it.value())) {
+                sessionId = -1;
+                return 0;
+            }
+        }
+    }
+
+    if (first == m_intervalIndex.constEnd())
+    {
+        sessionId = -1;
+        return 0;
+    }
+    sessionId = first.value();
+    return first.key() >> 32;
+}
+
+unsigned int NodeBase::snapInterval(unsigned int fastest) const
+{
+    unsigned int divisor = 0;
+    QMap<int, unsigned int> requests = activeIntervalRequests();
+    for (QMap<int, unsigned int>::const_iterator it = requests.constBegin(); it != requests.constEnd(); ++it)
+    {
+        if (it.value())
+            divisor = greatestCommonDivisor(divisor, it.value());
+    }
+    if (divisor == 0 || divisor >= fastest)
+        return fastest;
+
+    // Largest supported interval dividing every request, but do not
+    // more than double the rate for exactness.
+    for (unsigned int factor = 1; divisor / factor * 2 >= fastest; ++factor)
+    {
+        if (divisor % factor == 0 && isValidIntervalRequest(divisor / factor)) {
+            sensordLogD() << "Snapped interval of node " << id() << " from " << fastest << " to " << divisor / factor;
+            return divisor / factor;
+        }
+    }
+    return fastest;
+}
+
+bool NodeBase::isSessionActive(int sessionId) const
+{
+    Q_UNUSED(sessionId);
     return true;
 }
 
+bool NodeBase::hasStandbyOverrideRequest(int sessionId) const
+{
+    QMap<int, SessionRequests>::const_iterator it(m_sessions.constFind(sessionId));
+    return it != m_sessions.constEnd() && it.value().standbyOverride;
+}
+
 void NodeBase::addStandbyOverrideSource(NodeBase* node)
 {
     m_standbySourceList.append(node);
@@ -375,23 +625,20 @@ bool NodeBase::standbyOverride() const
 bool NodeBase::setStandbyOverrideRequest(const int sessionId, const bool override)
 {
     sensordLogD() << sessionId << " requested standbyoverride for '" << id() << "' :" << override;
-    // Only store true requests, id is enough, no need for value
-    if (override == false)
-    {
-        m_standbyRequestList.removeAll(sessionId);
-    }
-    else
+    SessionRequests requests = takeSession(sessionId);
+    requests.standbyOverride = override;
+    storeSession(sessionId, requests);
+
+    // Overrides decide which sessions are active during screen blank.
+    if (m_deadlineArbitration)
     {
-        if (!m_standbyRequestList.contains(sessionId))
-        {
-            m_standbyRequestList.append(sessionId);
-        }
+        reevaluateRequests();
     }
 
     // Re-evaluate state for nodes that implement handling locally.
     if (m_standbySourceList.size() == 0)
     {
-        return setStandbyOverride(m_standbyRequestList.size() > 0);
+        return setStandbyOverride(m_standbyRequestCount > 0);
     }
 
     // Pass request to sources
@@ -413,6 +660,92 @@ bool NodeBase::setStandbyOverrideRequest(const int sessionId, const bool overrid
     return returnValue;
 }
 
+bool NodeBase::setMotionWakeupRequest(const int sessionId, const bool tolerate)
+{
+    sensordLogD() << sessionId << " requested motion wakeup for '" << id() << "' :" << tolerate;
+    SessionRequests requests = takeSession(sessionId);
+    requests.motionWakeup = tolerate;
+    storeSession(sessionId, requests);
+
+    // Adaptors decide locally, other nodes pass the request on.
+    if (m_standbySourceList.size() == 0)
+    {
+        return updateMotionWakeup();
+    }
+
+    bool returnValue = true;
+    foreach (NodeBase* node, m_standbySourceList)
+    {
+        returnValue = node->setMotionWakeupRequest(sessionId, tolerate) && returnValue;
+    }
+    return returnValue;
+}
+
+bool NodeBase::motionWakeup() const
+{
+    if (m_standbySourceList.size() == 0)
+    {
+        return m_motionWakeup;
+    }
+
+    bool returnValue = true;
+    foreach (NodeBase* node, m_standbySourceList)
+    {
+        returnValue = returnValue && node->motionWakeup();
+    }
+    return returnValue;
+}
+
+int NodeBase::openDirectChannel(const int sessionId, const unsigned int interval)
+{
+    if (m_standbySourceList.size() == 0)
+    {
+        int fd = createDirectChannel(sessionId, interval);
+        sensordLogD() << sessionId << " direct channel for '" << id() << "' :" << (fd != -1);
+        return fd;
+    }
+    if (m_standbySourceList.size() != 1)
+    {
+        return -1;
+    }
+    return m_standbySourceList.first()->openDirectChannel(sessionId, interval);
+}
+
+void NodeBase::closeDirectChannel(const int sessionId)
+{
+    if (m_standbySourceList.size() == 0)
+    {
+        destroyDirectChannel(sessionId);
+        return;
+    }
+    foreach (NodeBase* node, m_standbySourceList)
+    {
+        node->closeDirectChannel(sessionId);
+    }
+}
+
+bool NodeBase::updateMotionWakeup()
+{
+    bool wanted = m_motionWakeupRequestCount > 0 && m_motionWakeupBlockingCount == 0;
+
+    if (wanted == m_motionWakeup)
+    {
+        return true;
+    }
+    if (!setMotionWakeup(wanted))
+    {
+        if (wanted)
+        {
+            sensordLogD() << "Wake on motion not available for '" << id() << "'";
+            return false;
+        }
+        sensordLogW() << "Failed to leave wake on motion mode for '" << id() << "'";
+    }
+    sensordLogD() << "Wake on motion for '" << id() << "' :" << wanted;
+    m_motionWakeup = wanted;
+    return true;
+}
+
 bool NodeBase::hasLocalInterval() const
 {
     return (m_intervalSource == NULL);
@@ -422,31 +755,46 @@ void NodeBase::setIntervalSource(NodeBase* node)
 {
     m_intervalSource = node;
     connect(m_intervalSource, SIGNAL(propertyChanged(const QString&)), this, SIGNAL(propertyChanged(const QString&)));
+    connect(m_intervalSource, SIGNAL(propertiesChanged(const QStringList&)), this, SIGNAL(propertiesChanged(const QStringList&)));
+    connect(m_intervalSource, SIGNAL(metadataChanged()), this, SIGNAL(metadataChanged()));
+    ++m_metadataVersion;
+    emit metadataChanged();
 }
 
 unsigned int NodeBase::evaluateIntervalRequests(int& sessionId) const
 {
-    if (m_intervalMap.size() == 0)
+    if (!hasIntervalRequests())
     {
         sessionId = -1;
         return defaultInterval();
     }
 
-    // Get the winning request
-    QMap<int, unsigned int>::const_iterator it = m_intervalMap.constBegin();
-    unsigned int highestValue = it.value();
-    int winningSessionId = it.key();
+    return fastestIntervalRequest(sessionId);
+}
 
-    for (++it; it != m_intervalMap.constEnd(); ++it)
+void NodeBase::setIntervalFloor(unsigned int value)
+{
+    if (!hasLocalInterval())
     {
-        if (it.value() < highestValue) {
-            highestValue = it.value();
-            winningSessionId = it.key();
-        }
+        if (m_intervalSource)
+            m_intervalSource->setIntervalFloor(value);
+        return;
+    }
+
+    unsigned int largest = 0;
+    foreach (const DataRange& range, m_intervalList)
+        largest = qMax(largest, (unsigned int)range.max);
+    value = qMin(value, largest);
+    if (value && !isValidIntervalRequest(value))
+    {
+        sensordLogW() << "Interval floor " << value << " not available for node '" << id() << "'";
+        return;
     }
+    if (value == m_intervalFloor)
+        return;
 
-    sessionId = winningSessionId;
-    return highestValue;
+    m_intervalFloor = value;
+    updateInterval();
 }
 
 unsigned int NodeBase::defaultInterval() const
@@ -480,10 +828,30 @@ bool NodeBase::requestDefaultInterval(const int sessionId)
     return true;
 }
 
-void NodeBase::removeIntervalRequest(const int sessionId)
+bool NodeBase::requestInitialInterval(const int sessionId, const unsigned int value)
 {
-    unsigned int previousInterval = interval();
+    if (!value)
+    {
+        return requestDefaultInterval(sessionId);
+    }
 
+    foreach (NodeBase *source, m_sourceList)
+    {
+        if (hasLocalInterval() || source != m_intervalSource)
+            source->requestDefaultInterval(sessionId);
+    }
+
+    if (!hasLocalInterval())
+    {
+        bool ok = m_intervalSource->requestInitialInterval(sessionId, value);
+        sessionIntervalChanged(sessionId);
+        return ok;
+    }
+    return setIntervalRequest(sessionId, value);
+}
+
+void NodeBase::removeIntervalRequest(const int sessionId)
+{
     foreach (NodeBase *source, m_sourceList)
     {
         source->removeIntervalRequest(sessionId);
@@ -492,24 +860,28 @@ void NodeBase::removeIntervalRequest(const int sessionId)
     if (hasLocalInterval())
     {
         // Remove from local list
-        if (m_intervalMap.keys().contains(sessionId))
+        SessionRequests requests = takeSession(sessionId);
+        if (requests.hasInterval)
         {
-            m_intervalMap.remove(sessionId);
+            m_intervalIndex.remove(intervalKey(requests.interval, sessionId));
+            requests.hasInterval = false;
         }
+        storeSession(sessionId, requests);
 
         // Re-evaluate local setting
-        int winningSessionId;
-        unsigned int winningRequest = evaluateIntervalRequests(winningSessionId);
-        if (winningSessionId >= 0) {
-            setInterval(winningRequest, winningSessionId);
-        }
-
-        // Signal listeners if changed.
-        if (previousInterval != interval())
+        updateInterval();
+        if (m_motionWakeupRequestCount)
         {
-            emit propertyChanged("interval");
+            updateMotionWakeup();
         }
     }
+
+    sessionIntervalChanged(sessionId);
+}
+
+void NodeBase::sessionIntervalChanged(int sessionId)
+{
+    Q_UNUSED(sessionId);
 }
 
 bool NodeBase::connectToSource(NodeBase* source, const QString& bufferName, RingBufferReaderBase* reader)
@@ -522,6 +894,9 @@ bool NodeBase::connectToSource(NodeBase* source, const QString& bufferName, Ring
         return false;
     }
 
+    if (m_worker)
+        m_worker->attach(reader);
+
     bool success = rb->join(reader);
 
     if (success)
@@ -529,6 +904,10 @@ bool NodeBase::connectToSource(NodeBase* source, const QString& bufferName, Ring
         // Store a reference to the source
         m_sourceList.append(source);
     }
+    else if (m_worker)
+    {
+        m_worker->detach(reader);
+    }
 
     return success;
 }
@@ -544,6 +923,9 @@ bool NodeBase::disconnectFromSource(NodeBase* source, const QString& bufferName,
 
     bool success = rb->unjoin(reader);
 
+    if (m_worker)
+        m_worker->detach(reader);
+
     if (success)
     {
         // Remove the source reference from storage
@@ -616,19 +998,13 @@ bool NodeBase::clearBufferSize(int sessionId)
 
 bool NodeBase::updateBufferSize()
 {
-    int key = 0;
-    int value = 0;
-    for(QMap<int, unsigned int>::const_iterator it = m_bufferSizeMap.constBegin(); it != m_bufferSizeMap.constEnd(); ++it)
-    {
-        if(it.key() >= key)
-        {
-            key = it.key();
-            value = it.value();
-        }
-    }
+    // Newest session wins, it is the last one in the map.
+    unsigned int value = 0;
+    if(!m_bufferSizeMap.isEmpty())
+        value = (m_bufferSizeMap.constEnd() - 1).value();
     if(setBufferSize(value))
     {
-        emit propertyChanged("buffersize");
+        notifyPropertyChanged("buffersize");
         return true;
     }
     return false;
@@ -652,19 +1028,29 @@ bool NodeBase::clearBufferInterval(int sessionId)
 
 bool NodeBase::updateBufferInterval()
 {
-    int key = 0;
     int value = 0;
-    for(QMap<int, unsigned int>::const_iterator it = m_bufferIntervalMap.constBegin(); it != m_bufferIntervalMap.constEnd(); ++it)
+    bool found = false;
+    if (m_deadlineArbitration)
     {
-        if(it.key() >= key)
+        // Batch as long as the tightest deadline of the active sessions
+        // allows. Zero means no deadline.
+        for (QMap<int, unsigned int>::const_iterator it = m_bufferIntervalMap.constBegin(); it != m_bufferIntervalMap.constEnd(); ++it)
         {
-            key = it.key();
-            value = it.value();
+            if (!isSessionActive(it.key()))
+                continue;
+            found = true;
+            if (it.value() && (value == 0 || (int)it.value() < value))
+                value = it.value();
         }
     }
+    if (!found && !m_bufferIntervalMap.isEmpty())
+    {
+        // Newest session wins, it is the last one in the map.
+        value = (m_bufferIntervalMap.constEnd() - 1).value();
+    }
     if(setBufferInterval(value))
     {
-        emit propertyChanged("bufferinterval");
+        notifyPropertyChanged("bufferinterval");
         return true;
     }
     return false;
@@ -684,13 +1070,25 @@ bool NodeBase::setDataRangeIndex(int sessionId, int rangeIndex)
 
 void NodeBase::removeSession(int sessionId)
 {
+    setMotionWakeupRequest(sessionId, false);
     setStandbyOverrideRequest(sessionId, false);
+    closeDirectChannel(sessionId);
     removeIntervalRequest(sessionId);
     removeDataRangeRequest(sessionId);
     clearBufferSize(sessionId);
     clearBufferInterval(sessionId);
 }
 
+void NodeBase::setWorker(ChainWorker* worker)
+{
+    m_worker = worker;
+}
+
+void NodeBase::configurationChanged(const QStringList& keys)
+{
+    Q_UNUSED(keys);
+}
+
 void NodeBase::setValid(bool valid)
 {
     isValid_ = valid;
@@ -713,6 +1111,24 @@ bool NodeBase::setStandbyOverride(bool override)
     return false;
 }
 
+bool NodeBase::setMotionWakeup(bool enabled)
+{
+    Q_UNUSED(enabled);
+    return false;
+}
+
+int NodeBase::createDirectChannel(int sessionId, unsigned int interval)
+{
+    Q_UNUSED(sessionId);
+    Q_UNUSED(interval);
+    return -1;
+}
+
+void NodeBase::destroyDirectChannel(int sessionId)
+{
+    Q_UNUSED(sessionId);
+}
+
 unsigned int NodeBase::interval() const
 {
     return 0;
@@ -728,12 +1144,27 @@ bool NodeBase::setInterval(unsigned int value, int sessionId)
 
 bool NodeBase::setBufferSize(unsigned int value)
 {
-    Q_UNUSED(value);
-    return false;
+    // Pass the request on to sources which buffer in hardware.
+    bool ok = false;
+    foreach (NodeBase* source, m_sourceList)
+    {
+        bool hwSupported = false;
+        source->getAvailableBufferSizes(hwSupported);
+        if (hwSupported)
+            ok = source->setBufferSize(value) || ok;
+    }
+    return ok;
 }
 
 bool NodeBase::setBufferInterval(unsigned int value)
 {
-    Q_UNUSED(value);
-    return false;
+    bool ok = false;
+    foreach (NodeBase* source, m_sourceList)
+    {
+        bool hwSupported = false;
+        source->getAvailableBufferIntervals(hwSupported);
+        if (hwSupported)
+            ok = source->setBufferInterval(value) || ok;
+    }
+    return ok;
 }
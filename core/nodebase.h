@@ -29,12 +29,16 @@
 
 #include <QObject>
 #include <QString>
+#include <QStringList>
 #include <QList>
+#include <QMap>
 #include "datarange.h"
 #include "logging.h"
+#include "nodestatistics.h"
 
 class RingBufferReaderBase;
 class RingBufferBase;
+class ChainWorker;
 
 /**
  * Base class for all nodes in sensord framework filtering chain.
@@ -72,6 +76,13 @@ public:
      */
     const QString& id() const;
 
+    /**
+     * Throughput and processing time counters of the node.
+     *
+     * @return node statistics.
+     */
+    NodeStatistics& statistics();
+
     /**
      * Is object succesfully initialized.
      *
@@ -87,6 +98,15 @@ public Q_SLOTS:
      */
     const QString& description() const;
 
+    /**
+     * Get version of the node metadata: description, available data
+     * ranges and intervals. The version changes whenever any of them
+     * changes, here or in the nodes they are taken from.
+     *
+     * @return metadata version.
+     */
+    unsigned int metadataVersion() const;
+
     /**
      * Remove a range request.
      *
@@ -164,6 +184,47 @@ public Q_SLOTS:
      */
     bool setStandbyOverrideRequest(int sessionId, bool override);
 
+    /**
+     * Tells whether given session tolerates event driven delivery, where
+     * samples stop while the device is still and resume on motion. The
+     * adaptor enters wake on motion mode only when every session it
+     * serves tolerates it, so any other session keeps it streaming.
+     * Requests are forwarded like standby override requests.
+     *
+     * @param sessionId ID of the session making the request.
+     * @param tolerate Whether session tolerates (\c true) or not (\c false).
+     * @return \c false if wake on motion mode could not be entered.
+     */
+    bool setMotionWakeupRequest(int sessionId, bool tolerate);
+
+    /**
+     * Is the node in wake on motion mode.
+     *
+     * @return is wake on motion mode in use.
+     */
+    bool motionWakeup() const;
+
+    /**
+     * Open a direct channel for session. The hardware writes samples
+     * straight into shared memory which the client maps, bypassing the
+     * pipeline. Adaptors create the channel, other nodes pass the request
+     * on when they have exactly one standby override source, as the
+     * channel carries raw samples of a single hardware sensor.
+     *
+     * @param sessionId ID of the session making the request.
+     * @param interval requested interval in milliseconds.
+     * @return file descriptor of the channel memory, to be closed by the
+     *         caller, or -1 if no direct channel is available.
+     */
+    int openDirectChannel(int sessionId, unsigned int interval);
+
+    /**
+     * Close direct channel of session, if it has one.
+     *
+     * @param sessionId ID of the session.
+     */
+    void closeDirectChannel(int sessionId);
+
     /**
      * Returns list of possible intervals for the sensor. If \c min and
      * \c max value are the same, the value is discrete. If they are
@@ -192,6 +253,31 @@ public Q_SLOTS:
      */
     bool requestDefaultInterval(int sessionId);
 
+    /**
+     * Request interval for a starting session. Sources get the default
+     * request like with #requestDefaultInterval(), but the node itself
+     * and its interval source get the given interval directly, so they
+     * are not first reprogrammed with the default.
+     *
+     * @param sessionId Session ID.
+     * @param value interval value in milliseconds. Zero requests the
+     *              default interval.
+     * @return was request succesful.
+     */
+    bool requestInitialInterval(int sessionId, unsigned int value);
+
+    /**
+     * Set lower bound for the interval of the node, independent of
+     * session requests. While set, the interval used is the larger of
+     * the winning request and the bound, limited to the largest
+     * available interval. Lets a channel slow its source down while
+     * its data carries no news, see ALSSensorChannel. Passed on to the
+     * interval source if the node has no local interval.
+     *
+     * @param value interval in milliseconds, 0 to remove the bound.
+     */
+    void setIntervalFloor(unsigned int value);
+
     /**
      * Returns the default interval value for this node.
      *
@@ -293,6 +379,15 @@ public Q_SLOTS:
      */
     virtual void removeSession(int sessionId);
 
+    /**
+     * Called from the main thread after the configuration has been
+     * reloaded. Nodes caching configuration values reimplement this to
+     * apply the new values. Default implementation does nothing.
+     *
+     * @param keys configuration keys which were added, removed or changed.
+     */
+    virtual void configurationChanged(const QStringList& keys);
+
 Q_SIGNALS:
     /**
      * Property value has changed signal.
@@ -301,7 +396,30 @@ Q_SIGNALS:
      */
     void propertyChanged(const QString& name);
 
+    /**
+     * Properties have changed. Emitted once per event loop iteration
+     * with every property changed during it, after the
+     * #propertyChanged() signals of the same properties.
+     *
+     * @param names property names.
+     */
+    void propertiesChanged(const QStringList& names);
+
+    /**
+     * Node metadata has changed, see #metadataVersion().
+     */
+    void metadataChanged();
+
 protected:
+    /**
+     * Note a property change. Changes are coalesced and signalled with
+     * #propertyChanged() and #propertiesChanged() when control returns
+     * to the event loop.
+     *
+     * @param name property name.
+     */
+    void notifyPropertyChanged(const QString& name);
+
     /**
      * Set object validity state.
      *
@@ -329,6 +447,15 @@ protected:
      */
     bool disconnectFromSource(NodeBase* source, const QString& bufferName, RingBufferReaderBase* reader);
 
+    /**
+     * Run readers connected with #connectToSource() in given worker
+     * thread instead of the thread writing to the source buffer. Must be
+     * set before any reader is connected.
+     *
+     * @param worker worker thread, NULL to run readers directly.
+     */
+    void setWorker(ChainWorker* worker);
+
     /**
      * Validates the metadata setup for the node. To pass, exactly one
      * of the following conditions must be fullfilled for each propagative
@@ -408,6 +535,38 @@ protected:
      */
     void addStandbyOverrideSource(NodeBase* node);
 
+    /**
+     * Enter or leave wake on motion mode. In the mode the hardware only
+     * wakes up the system and produces samples when it detects motion.
+     * This is the base implementation, adaptors which can program such
+     * an interrupt reimplement it.
+     *
+     * @param enabled enter (\c true) or leave (\c false) the mode.
+     * @return was the mode changed. Base implementation returns
+     *         \c false.
+     */
+    virtual bool setMotionWakeup(bool enabled);
+
+    /**
+     * Create a direct channel for session. This is the base
+     * implementation, adaptors whose hardware can write into shared
+     * memory reimplement it.
+     *
+     * @param sessionId ID of the session.
+     * @param interval requested interval in milliseconds.
+     * @return file descriptor of the channel memory, to be closed by the
+     *         caller. Base implementation returns -1.
+     */
+    virtual int createDirectChannel(int sessionId, unsigned int interval);
+
+    /**
+     * Destroy direct channel of session. Base implementation does
+     * nothing.
+     *
+     * @param sessionId ID of the session.
+     */
+    virtual void destroyDirectChannel(int sessionId);
+
     /**
      * Add a new interval to list of locally provided ones
      *
@@ -460,6 +619,78 @@ protected:
      */
     virtual unsigned int evaluateIntervalRequests(int& sessionId) const;
 
+    /**
+     * Called after interval request of given session has been set or
+     * removed through this node.
+     *
+     * @param sessionId session ID.
+     */
+    virtual void sessionIntervalChanged(int sessionId);
+
+    /**
+     * Interval requests which take part in the evaluation. By default
+     * all requests do. With <tt>global/interval_arbitration = deadline</tt>
+     * requests of sessions which are not currently receiving samples
+     * (see #isSessionActive()) are left out, as long as some request
+     * remains, so an idle session does not keep the hardware at its rate.
+     * The map is built on each call; reimplementations of
+     * #evaluateIntervalRequests() should prefer #fastestIntervalRequest().
+     *
+     * @return interval requests by session.
+     */
+    QMap<int, unsigned int> activeIntervalRequests() const;
+
+    /**
+     * Smallest interval request taking part in the evaluation, see
+     * #activeIntervalRequests(). Requests are kept ordered by value, so
+     * sessions are not walked to find the winner.
+     *
+     * @param sessionId set to the session of the request, \c -1 if no
+     *                  request qualifies.
+     * @param minimum smallest request considered. Give 1 to skip zero
+     *                requests.
+     * @return requested interval, 0 if no request qualifies.
+     */
+    unsigned int fastestIntervalRequest(int& sessionId, unsigned int minimum = 0) const;
+
+    /**
+     * Has any session requested an interval from this node.
+     *
+     * @return are there interval requests.
+     */
+    bool hasIntervalRequests() const { return !m_intervalIndex.isEmpty(); }
+
+    /**
+     * Is given session currently receiving samples from this node.
+     * Used by deadline arbitration.
+     *
+     * @param sessionId session ID.
+     * @return is session active. Default implementation returns true.
+     */
+    virtual bool isSessionActive(int sessionId) const;
+
+    /**
+     * Has given session requested standby override from this node.
+     *
+     * @param sessionId session ID.
+     * @return is standby override requested.
+     */
+    bool hasStandbyOverrideRequest(int sessionId) const;
+
+    /**
+     * Is deadline arbitration in use.
+     *
+     * @return is <tt>global/interval_arbitration</tt> set to \c deadline.
+     */
+    bool deadlineArbitration() const { return m_deadlineArbitration; }
+
+    /**
+     * Re-evaluate interval and buffer interval requests, for example when
+     * the set of active sessions has changed. With deadline arbitration
+     * the hardware is only reconfigured when the result changes.
+     */
+    void reevaluateRequests();
+
     /**
      * Node to fetch interval from
      *
@@ -494,7 +725,8 @@ protected:
 
     /**
      * Set buffer size. Nodes subclasses supporting buffering needs to
-     * reimplement this.
+     * reimplement this. Default implementation passes the request to
+     * sources which support hardware buffering.
      *
      * @param value buffer size.
      * @return was buffer size set succesfully.
@@ -503,19 +735,65 @@ protected:
 
     /**
      * Set buffer interval. Nodes subclasses supporting buffering needs to
-     * reimplement this.
+     * reimplement this. Default implementation passes the request to
+     * sources which support hardware buffering.
      *
      * @param value buffer interval.
      * @return was buffer interval set succesfully.
      */
     virtual bool setBufferInterval(unsigned int value);
 
-    QMap<int, unsigned int> m_intervalMap;    /**< active interval requests for sessions */
-
     unsigned int            m_bufferSize;     /** buffer size */
     unsigned int            m_bufferInterval; /** buffer interval */
 
+private Q_SLOTS:
+    /**
+     * Signal the property changes noted since the last call.
+     */
+    void flushPropertyChanges();
+
 private:
+    /**
+     * Requests of a single session to this node. Sessions without any
+     * request are not stored.
+     */
+    struct SessionRequests
+    {
+        SessionRequests() : interval(0), hasInterval(false), standbyOverride(false), motionWakeup(false), dataRangeSequence(0) {}
+
+        bool isEmpty() const { return !hasInterval && !standbyOverride && !motionWakeup && !dataRangeSequence; }
+
+        unsigned int interval;          /**< interval request */
+        bool         hasInterval;       /**< has interval been requested */
+        bool         standbyOverride;   /**< has standby override been requested */
+        bool         motionWakeup;      /**< does session tolerate wake on motion */
+        quint64      dataRangeSequence; /**< key in #m_dataRangeQueue, 0 if none */
+    };
+
+    /**
+     * Remove requests of given session from the table and the request
+     * counters. Pass the result, modified, to #storeSession().
+     *
+     * @param sessionId session ID.
+     * @return requests of the session, empty if none.
+     */
+    SessionRequests takeSession(int sessionId);
+
+    /**
+     * Store requests of given session to the table and the request
+     * counters. Empty requests are dropped.
+     *
+     * @param sessionId session ID.
+     * @param requests requests of the session.
+     */
+    void storeSession(int sessionId, const SessionRequests& requests);
+
+    /**
+     * Key of an interval request in #m_intervalIndex. Keys order by
+     * value, then by session ID.
+     */
+    static quint64 intervalKey(unsigned int value, int sessionId);
+
     /**
      * Returns whether the class defines its own output data range, or
      * whether it uses the values from previous layer.
@@ -547,22 +825,61 @@ private:
      */
     bool updateBufferInterval();
 
+    /**
+     * Re-evaluate interval for the node and apply the result.
+     */
+    void updateInterval();
+
+    /**
+     * Find the largest supported interval which divides every active
+     * interval request, so downsampling sessions get an exact integer
+     * factor. Used when <tt>global/interval_snapping</tt> is enabled.
+     * The rate is at most doubled; if no such interval exists the
+     * winning request is kept.
+     *
+     * @param fastest winning interval request.
+     * @return interval to configure.
+     */
+    unsigned int snapInterval(unsigned int fastest) const;
+
+    /**
+     * Enter wake on motion mode when every known session tolerates it
+     * and leave it otherwise. Sessions are known by their interval and
+     * standby override requests.
+     *
+     * @return \c false if the mode was wanted but could not be entered.
+     */
+    bool updateMotionWakeup();
+
     QString                 m_description; /**< node description */
+    QStringList             m_changedProperties; /**< property changes not yet signalled */
+    unsigned int            m_metadataVersion; /**< changes of local metadata */
+
+    QMap<int, SessionRequests> m_sessions; /**< requests by session */
+    QMap<quint64, int>      m_intervalIndex;  /**< sessions by interval request, see #intervalKey() */
+    int                     m_standbyRequestCount; /**< sessions requesting standby override */
+    int                     m_motionWakeupRequestCount; /**< sessions tolerating wake on motion */
+    int                     m_motionWakeupBlockingCount; /**< known sessions not tolerating wake on motion */
 
     QList<DataRange>        m_dataRangeList; /**< available data ranges */
-    QList<DataRangeRequest> m_dataRangeQueue; /**< data range requests */
+    QMap<quint64, DataRangeRequest> m_dataRangeQueue; /**< data range requests in arrival order */
+    quint64                 m_dataRangeSequence; /**< sequence of the latest data range request */
     NodeBase*               m_dataRangeSource; /**< data range source node */
 
     QList<NodeBase*>        m_standbySourceList; /** standbyoverride source nodes */
-    QList<int>              m_standbyRequestList; /** standbyoverride requests */
+    bool                    m_motionWakeup;   /**< is wake on motion mode in use */
     QList<DataRange>        m_intervalList;   /**< available intervals */
     NodeBase*               m_intervalSource; /**< interval sources */
     bool                    m_hasDefault;     /**< does node have locally set interval */
     unsigned int            m_defaultInterval; /**< locally set interval */
+    bool                    m_deadlineArbitration; /**< are idle sessions left out of arbitration */
+    bool                    m_intervalSnapping; /**< is interval snapped to divide all requests */
+    unsigned int            m_intervalFloor;  /**< lower bound for the interval, 0 if none */
 
     QList<NodeBase*>        m_sourceList; /**< source nodes */
+    ChainWorker*            m_worker;     /**< thread running readers, NULL if none */
 
-    //Oldest session wins for these:
+    //Newest session wins for these:
     QMap<int, unsigned int> m_bufferSizeMap; /**< buffersize requests for sessions. */
     QMap<int, unsigned int> m_bufferIntervalMap; /**< buffer interval requests for sessions. */
 
@@ -570,6 +887,7 @@ private:
 
     QString                 id_; /**< node ID */
     bool                    isValid_; /**< is node correctly initialized */
+    NodeStatistics          statistics_; /**< node statistics */
 };
 
 #endif
@@ -0,0 +1,206 @@
+/**
+   @file nodestatistics.cpp
+   @brief NodeStatistics
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "nodestatistics.h"
+#include <time.h>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+
+QAtomicInt NodeStatistics::enabled_(0);
+
+/**
+ * Registered instances. Function local statics so that nodes created
+ * during static initialization find them constructed.
+ */
+static QList<NodeStatistics*>& registry()
+{
+    static QList<NodeStatistics*> list;
+    return list;
+}
+
+static QMutex& registryMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+/**
+ * Histogram bucket for a time in microseconds.
+ */
+static int bucketOf(quint64 micros)
+{
+    int bucket = 0;
+    while (micros && bucket < NodeStatistics::BUCKETS - 1) {
+        micros >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+/**
+ * Append non-empty histogram buckets to a report line.
+ */
+static QString formatHistogram(const QAtomicInt* histogram)
+{
+    QString str;
+    for (int i = 0; i < NodeStatistics::BUCKETS; ++i) {
+        unsigned int count = histogram[i].load();
+        if (!count)
+            continue;
+        if (i == NodeStatistics::BUCKETS - 1)
+            str.append(QString(" >=%1:%2").arg(1u << (i - 1)).arg(count));
+        else
+            str.append(QString(" <%1:%2").arg(1u << i).arg(count));
+    }
+    return str;
+}
+
+NodeStatistics::NodeStatistics(const QString& name) :
+    name_(name),
+    lastArrival_(0)
+{
+    QMutexLocker locker(&registryMutex());
+    registry().append(this);
+}
+
+NodeStatistics::~NodeStatistics()
+{
+    QMutexLocker locker(&registryMutex());
+    registry().removeOne(this);
+}
+
+void NodeStatistics::setName(const QString& name)
+{
+    QMutexLocker locker(&registryMutex());
+    name_ = name;
+}
+
+void NodeStatistics::addProcessingTime(quint64 start)
+{
+    if (!isEnabled())
+        return;
+
+    histogram_[bucketOf((timestamp() - start) / 1000)].fetchAndAddRelaxed(1);
+}
+
+void NodeStatistics::addArrival(unsigned int n)
+{
+    if (!isEnabled() || !n)
+        return;
+
+    quint64 now = timestamp();
+    quint64 last = lastArrival_;
+    lastArrival_ = now;
+    if (!last || now < last)
+        return;
+
+    // Mean is kept scaled by 8 so that the 1/8 weight of a new interval
+    // does not round away in integer arithmetic.
+    int interval = (int)qMin<quint64>((now - last) / 1000 / n, 0x0fffffff);
+    int scaled = meanInterval_.load();
+    if (!scaled)
+        scaled = interval * 8;
+    else
+        scaled += interval - scaled / 8;
+    meanInterval_.store(scaled);
+
+    jitter_[bucketOf(qAbs(interval - scaled / 8))].fetchAndAddRelaxed(n);
+}
+
+unsigned int NodeStatistics::rate() const
+{
+    int scaled = meanInterval_.load();
+    if (scaled <= 0)
+        return 0;
+    return (unsigned int)(8000000000ULL / (unsigned int)scaled);
+}
+
+void NodeStatistics::reset()
+{
+    samplesIn_.store(0);
+    samplesOut_.store(0);
+    drops_.store(0);
+    queueDepth_.store(0);
+    queuePeak_.store(0);
+    for (int i = 0; i < BUCKETS; ++i) {
+        histogram_[i].store(0);
+        jitter_[i].store(0);
+    }
+    meanInterval_.store(0);
+    lastArrival_ = 0;
+}
+
+QString NodeStatistics::toString() const
+{
+    QString str = QString("%1: in %2, out %3, drops %4")
+        .arg(name_)
+        .arg((unsigned int)samplesIn_.load())
+        .arg((unsigned int)samplesOut_.load())
+        .arg((unsigned int)drops_.load());
+
+    if (queuePeak_.load())
+        str.append(QString(", queue %1 peak %2").arg((unsigned int)queueDepth_.load()).arg((unsigned int)queuePeak_.load()));
+
+    QString times = formatHistogram(histogram_);
+    if (!times.isEmpty())
+        str.append(", time us" + times);
+
+    unsigned int millihertz = rate();
+    if (millihertz) {
+        str.append(QString(", rate %1 Hz, jitter us").arg(millihertz / 1000.0, 0, 'f', 1));
+        str.append(formatHistogram(jitter_));
+    }
+    return str;
+}
+
+void NodeStatistics::setEnabled(bool enabled)
+{
+    if (enabled && !isEnabled()) {
+        QMutexLocker locker(&registryMutex());
+        foreach (NodeStatistics* statistics, registry())
+            statistics->reset();
+    }
+    enabled_.store(enabled ? 1 : 0);
+}
+
+quint64 NodeStatistics::timestamp()
+{
+    timespec stamp;
+    clock_gettime(CLOCK_MONOTONIC, &stamp);
+    return (quint64)stamp.tv_sec * 1000000000 + stamp.tv_nsec;
+}
+
+QStringList NodeStatistics::report()
+{
+    QStringList lines;
+    QMutexLocker locker(&registryMutex());
+    foreach (const NodeStatistics* statistics, registry()) {
+        if (statistics->name_.isEmpty())
+            continue;
+        if (!statistics->samplesIn_.load() && !statistics->samplesOut_.load() && !statistics->drops_.load())
+            continue;
+        lines.append(statistics->toString());
+    }
+    return lines;
+}
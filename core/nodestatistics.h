@@ -0,0 +1,204 @@
+/**
+   @file nodestatistics.h
+   @brief NodeStatistics
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef NODESTATISTICS_H
+#define NODESTATISTICS_H
+
+#include <QString>
+#include <QStringList>
+#include <QAtomicInt>
+
+/**
+ * Optional throughput and timing counters of a node in the processing
+ * chain. Counting is globally disabled by default; when disabled every
+ * update is a single relaxed load. Counters may be updated from any
+ * thread.
+ *
+ * All instances with a name are listed by #report(), so a running
+ * daemon can be profiled through SensorManager without rebuilding.
+ * Adaptor buffers also report the measured sample rate and jitter, to
+ * check that a sensor delivers at the interval it was configured to.
+ */
+class NodeStatistics
+{
+public:
+    /**
+     * Number of processing time histogram buckets. Bucket 0 counts
+     * times below 1 us, bucket i times in [2^(i-1), 2^i) us and the last
+     * bucket everything longer.
+     */
+    static const int BUCKETS = 16;
+
+    /**
+     * Constructor. Registers the instance for #report().
+     *
+     * @param name name shown in the report.
+     */
+    NodeStatistics(const QString& name = QString());
+
+    /**
+     * Destructor.
+     */
+    ~NodeStatistics();
+
+    /**
+     * Set name shown in the report. Instances without a name are not
+     * reported.
+     *
+     * @param name name.
+     */
+    void setName(const QString& name);
+
+    /**
+     * Count incoming samples.
+     *
+     * @param n number of samples.
+     */
+    void addInput(unsigned int n)
+    {
+        if (isEnabled())
+            samplesIn_.fetchAndAddRelaxed(n);
+    }
+
+    /**
+     * Count outgoing samples.
+     *
+     * @param n number of samples.
+     */
+    void addOutput(unsigned int n)
+    {
+        if (isEnabled())
+            samplesOut_.fetchAndAddRelaxed(n);
+    }
+
+    /**
+     * Count dropped samples.
+     *
+     * @param n number of samples.
+     */
+    void addDrops(unsigned int n)
+    {
+        if (isEnabled())
+            drops_.fetchAndAddRelaxed(n);
+    }
+
+    /**
+     * Record how many samples a consumer found queued when it started
+     * draining the queue of the node. The latest and the largest depth
+     * are reported.
+     *
+     * @param depth number of queued samples.
+     */
+    void addQueueDepth(unsigned int depth)
+    {
+        if (isEnabled()) {
+            queueDepth_.store(depth);
+            if ((unsigned int)queuePeak_.load() < depth)
+                queuePeak_.store(depth);
+        }
+    }
+
+    /**
+     * Add processing time into the histogram.
+     *
+     * @param start start time from #timestamp().
+     */
+    void addProcessingTime(quint64 start);
+
+    /**
+     * Record the arrival of samples from a device. Keeps a running
+     * estimate of the sample interval and a histogram of how much each
+     * interval deviates from it, using the same buckets as processing
+     * times. Samples arriving together share the time since the previous
+     * arrival. Must only be called from the thread producing the samples.
+     *
+     * @param n number of samples.
+     */
+    void addArrival(unsigned int n = 1);
+
+    /**
+     * Estimated sample rate from #addArrival().
+     *
+     * @return rate in mHz, 0 when not known.
+     */
+    unsigned int rate() const;
+
+    /**
+     * Reset counters.
+     */
+    void reset();
+
+    /**
+     * Format counters into single line.
+     *
+     * @return counters as text.
+     */
+    QString toString() const;
+
+    /**
+     * Is counting enabled.
+     *
+     * @return is counting enabled.
+     */
+    static bool isEnabled() { return enabled_.load(); }
+
+    /**
+     * Enable or disable counting in all nodes. Counters are reset when
+     * counting is enabled.
+     *
+     * @param enabled should counting be enabled.
+     */
+    static void setEnabled(bool enabled);
+
+    /**
+     * Current CLOCK_MONOTONIC time.
+     *
+     * @return time in nanoseconds.
+     */
+    static quint64 timestamp();
+
+    /**
+     * Counters of all named nodes which have seen samples.
+     *
+     * @return one line per node.
+     */
+    static QStringList report();
+
+private:
+    Q_DISABLE_COPY(NodeStatistics)
+
+    QString    name_;              /**< name in report */
+    QAtomicInt samplesIn_;         /**< incoming samples */
+    QAtomicInt samplesOut_;        /**< outgoing samples */
+    QAtomicInt drops_;             /**< dropped samples */
+    QAtomicInt queueDepth_;        /**< latest queue depth seen by the consumer */
+    QAtomicInt queuePeak_;         /**< largest queue depth seen by the consumer */
+    QAtomicInt histogram_[BUCKETS]; /**< processing times */
+    QAtomicInt meanInterval_;      /**< running mean sample interval, us * 8 */
+    QAtomicInt jitter_[BUCKETS];   /**< deviation of intervals from the mean */
+    quint64    lastArrival_;       /**< time of the previous arrival, ns */
+
+    static QAtomicInt enabled_;    /**< is counting enabled */
+};
+
+#endif // NODESTATISTICS_H
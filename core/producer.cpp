@@ -25,6 +25,7 @@
  */
 
 #include "producer.h"
+#include "source.h"
 
 Producer::~Producer()
 {
@@ -37,5 +38,21 @@ void Producer::addSource(SourceBase* source, const QString& name)
 
 SourceBase* Producer::source(const QString& name)
 {
-    return sources_[name];
+    return sources_.value(name);
+}
+
+bool Producer::hasConsumers() const
+{
+    for (int i = 0; i < sources_.size(); ++i) {
+        if (sources_.at(i)->hasDemand())
+            return true;
+    }
+    return false;
+}
+
+void Producer::freezeSources()
+{
+    for (int i = 0; i < sources_.size(); ++i) {
+        sources_.at(i)->freeze();
+    }
 }
@@ -28,7 +28,7 @@
 #define PRODUCER_H
 
 #include <QString>
-#include <QHash>
+#include "namedlist.h"
 
 class SourceBase;
 
@@ -46,6 +46,18 @@ public:
      */
     SourceBase* source(const QString& name);
 
+    /**
+     * Freeze connections of all sources of the producer.
+     */
+    void freezeSources();
+
+    /**
+     * Does any source of the producer lead to a live consumer.
+     *
+     * @return is output of the producer used.
+     */
+    bool hasConsumers() const;
+
 protected:
     /**
      * Destructor.
@@ -61,7 +73,7 @@ protected:
     void addSource(SourceBase* source, const QString& name);
 
 private:
-    QHash<QString, SourceBase*> sources_; /**< map of sources */
+    NamedList<SourceBase> sources_; /**< sources by name */
 };
 
 #endif
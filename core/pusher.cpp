@@ -39,6 +39,11 @@ void Pusher::setReadyCallback(const CallbackBase* ready)
     ready_ = ready;
 }
 
+void Pusher::resetReadyCallback()
+{
+    setReadyCallback(&signalNewEvent_);
+}
+
 void Pusher::wakeup() const
 {
     if (ready_) {
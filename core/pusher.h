@@ -48,6 +48,11 @@ public:
      */
     void setReadyCallback(const CallbackBase* ready);
 
+    /**
+     * Restore the default callback, which pushes new data directly.
+     */
+    void resetReadyCallback();
+
     /**
      * Invoke callback.
      */
@@ -0,0 +1,113 @@
+/**
+   @file realtimememory.cpp
+   @brief RealtimeMemory
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "realtimememory.h"
+#include "config.h"
+#include "logging.h"
+#include <sys/mman.h>
+#include <malloc.h>
+#include <alloca.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+/** Default heap faulted in up front, kB */
+static const unsigned int DEFAULT_HEAP_RESERVE = 2048;
+/** Default stack prefaulted per thread, kB */
+static const unsigned int DEFAULT_STACK_PREFAULT = 128;
+
+bool RealtimeMemory::enabled_ = false;
+size_t RealtimeMemory::stackPrefault_ = DEFAULT_STACK_PREFAULT * 1024;
+
+bool RealtimeMemory::enable()
+{
+    if (enabled_)
+        return true;
+
+    bool lockOnFault = false;
+    unsigned int heapReserve = DEFAULT_HEAP_RESERVE;
+    if (Config::configuration()) {
+        lockOnFault = Config::configuration()->value<bool>("global/realtime_lock_on_fault", false);
+        heapReserve = Config::configuration()->value<unsigned int>("global/realtime_heap_reserve", heapReserve);
+        stackPrefault_ = Config::configuration()->value<unsigned int>("global/realtime_stack_prefault", DEFAULT_STACK_PREFAULT) * 1024;
+    }
+
+    // Freed memory stays in the heap and large blocks come from it
+    // too, instead of from mappings of their own which would fault in
+    // again on every allocation.
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+
+    int flags = MCL_CURRENT | MCL_FUTURE;
+#ifdef MCL_ONFAULT
+    if (lockOnFault)
+        flags |= MCL_ONFAULT;
+#else
+    if (lockOnFault)
+        sensordLogW() << "[RealtimeMemory]: lock on fault not supported, locking all memory";
+#endif
+    if (mlockall(flags) == -1) {
+        sensordLogW() << "[RealtimeMemory]: mlockall(): " << strerror(errno);
+        return false;
+    }
+
+    if (heapReserve) {
+        // Released right away, but with trimming off the pages stay in
+        // the heap for the buffers allocated later.
+        size_t bytes = (size_t)heapReserve * 1024;
+        char* reserve = (char*)malloc(bytes);
+        if (reserve) {
+            prefault(reserve, bytes);
+            free(reserve);
+        }
+    }
+
+    enabled_ = true;
+    prefaultStack();
+    sensordLogD() << "[RealtimeMemory]: memory locked, " << heapReserve << " kB heap reserved";
+    return true;
+}
+
+bool RealtimeMemory::enabled()
+{
+    return enabled_;
+}
+
+void __attribute__((noinline)) RealtimeMemory::prefaultStack()
+{
+    if (!enabled_ || !stackPrefault_)
+        return;
+    // Stack below this frame is touched once; the allocation is gone
+    // when the function returns, the pages stay.
+    prefault(alloca(stackPrefault_), stackPrefault_);
+}
+
+void RealtimeMemory::prefault(void* memory, size_t bytes)
+{
+    static const long pageSize = sysconf(_SC_PAGESIZE);
+    volatile char* bytePtr = (volatile char*)memory;
+    for (size_t i = 0; i < bytes; i += pageSize)
+        bytePtr[i] = 0;
+    if (bytes)
+        bytePtr[bytes - 1] = 0;
+}
@@ -0,0 +1,80 @@
+/**
+   @file realtimememory.h
+   @brief RealtimeMemory
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef REALTIMEMEMORY_H
+#define REALTIMEMEMORY_H
+
+#include <stddef.h>
+
+/**
+ * Keeps the memory of sensord resident so that the sample path never
+ * takes a page fault. When enabled, freed heap memory is never given
+ * back to the kernel, all memory is locked with mlockall() and a heap
+ * reserve is faulted in, so ring and session buffers allocated later
+ * come from resident pages. Threads prefault their stacks when their
+ * scheduling is applied, see #ThreadScheduling.
+ *
+ * Settings in the \c global group:
+ *
+ * - \c realtime_lock_on_fault lock pages only once touched instead of
+ *   making every mapping resident, including the whole stack of every
+ *   thread. Needs Linux 4.4; the prefaulting then covers the hot path.
+ * - \c realtime_heap_reserve heap faulted in up front, kB.
+ * - \c realtime_stack_prefault stack prefaulted per thread, kB.
+ */
+class RealtimeMemory
+{
+public:
+    /**
+     * Lock the memory of the process and fault in the heap reserve.
+     *
+     * @return was the memory locked.
+     */
+    static bool enable();
+
+    /**
+     * Is the memory of the process locked.
+     *
+     * @return was #enable() successful.
+     */
+    static bool enabled();
+
+    /**
+     * Fault in the stack of the calling thread, if enabled.
+     */
+    static void prefaultStack();
+
+    /**
+     * Touch every page of a memory area.
+     *
+     * @param memory start of the area.
+     * @param bytes size of the area.
+     */
+    static void prefault(void* memory, size_t bytes);
+
+private:
+    static bool   enabled_;      /**< is memory locked */
+    static size_t stackPrefault_; /**< bytes of stack to prefault */
+};
+
+#endif // REALTIMEMEMORY_H
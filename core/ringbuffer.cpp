@@ -31,6 +31,21 @@ RingBufferReaderBase::~RingBufferReaderBase()
 {
 }
 
+RingBufferBase::RingBufferBase() :
+    recorder_(NULL),
+    activeRecords_(0),
+    flight_(NULL),
+    tap_(NULL)
+{
+}
+
+RingBufferBase::~RingBufferBase()
+{
+    stopRecording();
+    delete flight_.fetchAndStoreOrdered(NULL);
+    delete tap_.fetchAndStoreOrdered(NULL);
+}
+
 bool RingBufferBase::join(RingBufferReaderBase* reader)
 {
     return joinTypeChecked(reader);
@@ -40,3 +55,73 @@ bool RingBufferBase::unjoin(RingBufferReaderBase* reader)
 {
     return unjoinTypeChecked(reader);
 }
+
+unsigned RingBufferBase::roundUpToPowerOfTwo(unsigned size)
+{
+    unsigned power = 1;
+    while (power < size)
+        power <<= 1;
+    return power;
+}
+
+bool RingBufferBase::startRecording(const QString& path, unsigned int interval)
+{
+    if (recordingType() == RecordingUnknown) {
+        sensordLogW() << "Buffer data type cannot be recorded";
+        return false;
+    }
+
+    QMutexLocker locker(&recorderMutex_);
+    replaceRecorder(NULL);
+    SampleRecorder* recorder = new SampleRecorder;
+    if (!recorder->open(path, recordingType(), recordingSampleSize(), interval)) {
+        delete recorder;
+        return false;
+    }
+    replaceRecorder(recorder);
+    return true;
+}
+
+void RingBufferBase::stopRecording()
+{
+    QMutexLocker locker(&recorderMutex_);
+    replaceRecorder(NULL);
+}
+
+bool RingBufferBase::startFlightRecorder(const QString& path, unsigned int capacity, unsigned int interval)
+{
+    if (recordingType() == RecordingUnknown || flight_.load())
+        return false;
+
+    FlightRecorder* flight = new FlightRecorder;
+    if (!flight->open(path, recordingType(), recordingSampleSize(), capacity, interval)) {
+        delete flight;
+        return false;
+    }
+    flight_.storeRelease(flight);
+    return true;
+}
+
+StreamTap* RingBufferBase::startStreamTap(unsigned int capacity, unsigned int interval)
+{
+    if (recordingType() == RecordingUnknown || tap_.load())
+        return NULL;
+
+    StreamTap* tap = new StreamTap(recordingType(), recordingSampleSize(), capacity, interval);
+    tap_.storeRelease(tap);
+    return tap;
+}
+
+bool RingBufferBase::isRecording() const
+{
+    SampleRecorder* recorder = recorder_.loadAcquire();
+    return recorder && recorder->isOpen();
+}
+
+void RingBufferBase::replaceRecorder(SampleRecorder* recorder)
+{
+    SampleRecorder* old = recorder_.fetchAndStoreOrdered(recorder);
+    while (activeRecords_.loadAcquire())
+        QThread::yieldCurrentThread();
+    delete old;
+}
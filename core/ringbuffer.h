@@ -33,7 +33,16 @@
 #include "sink.h"
 #include "pusher.h"
 #include "logging.h"
-#include <QSet>
+#include "nodestatistics.h"
+#include "samplerecorder.h"
+#include "flightrecorder.h"
+#include "streambridge.h"
+#include <QList>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QThread>
+#include <algorithm>
 
 template <class TYPE>
 class RingBuffer;
@@ -43,6 +52,22 @@ class RingBuffer;
  */
 class RingBufferReaderBase : public Pusher
 {
+public:
+    /**
+     * Is data read by this reader used. Readers ending the graph, like
+     * sensor channels, always use it.
+     *
+     * @return does reader have a live downstream.
+     */
+    virtual bool hasDemand() const { return true; }
+
+    /**
+     * Key of the data type read, see DataType::key().
+     *
+     * @return type key.
+     */
+    virtual quintptr dataTypeKey() const = 0;
+
 protected:
     /**
      * Destructor
@@ -62,13 +87,29 @@ public:
     /**
      * Constructor.
      */
-    RingBufferReader() : readCount_(0) {}
+    RingBufferReader() : readCount_(0), overruns_(0) {}
 
     /**
      * Destructor
      */
     virtual ~RingBufferReader() {}
 
+    /**
+     * Number of objects this reader has missed because it fell more
+     * than the buffer size behind the writer.
+     *
+     * @return overrun count.
+     */
+    unsigned overruns() const
+    {
+        return overruns_;
+    }
+
+    quintptr dataTypeKey() const
+    {
+        return DataType<TYPE>::key();
+    }
+
 protected:
     /**
      * Read data from buffer.
@@ -82,10 +123,42 @@ protected:
         return buffer_->read(n, values, *this);
     }
 
+    /**
+     * Look at unread objects in place, without copying them. Objects
+     * are returned as up to two contiguous spans, the second one
+     * holding the part that wrapped to the start of the buffer. The
+     * spans stay valid until #commitRead(); the reader position does
+     * not move before that.
+     *
+     * @param n maximum number of objects to look at.
+     * @param first set to the first span.
+     * @param firstCount set to the number of objects in first.
+     * @param second set to the wrapped span, with the remaining objects.
+     * @return how many objects the spans hold.
+     */
+    unsigned peek(unsigned n, const TYPE*& first, unsigned& firstCount, const TYPE*& second)
+    {
+        return buffer_->peek(n, first, firstCount, second, *this);
+    }
+
+    /**
+     * Finish using objects returned by #peek() and move past them.
+     *
+     * @param n number of objects used.
+     * @return how many of them the writer overwrote while they were in
+     *         use. Only a reader in another thread than the writer which
+     *         is a full buffer behind can see this.
+     */
+    unsigned commitRead(unsigned n)
+    {
+        return buffer_->commitRead(n, *this);
+    }
+
 private:
     friend class RingBuffer<TYPE>;
 
     unsigned                readCount_; /**< how many objects have been read */
+    unsigned                overruns_;  /**< how many objects were overwritten before read */
     const RingBuffer<TYPE>* buffer_; /**< buffer associated with this reader */
 };
 
@@ -96,9 +169,14 @@ class RingBufferBase : public Consumer
 {
 public:
     /**
-     * Destructor.
+     * Constructor.
      */
-    virtual ~RingBufferBase() {}
+    RingBufferBase();
+
+    /**
+     * Destructor. Stops recording.
+     */
+    virtual ~RingBufferBase();
 
     /**
      * Connect reader to this buffer.
@@ -116,6 +194,113 @@ public:
      */
     bool unjoin(RingBufferReaderBase* reader);
 
+    /**
+     * Counters of written objects and reader overruns.
+     *
+     * @return buffer statistics.
+     */
+    NodeStatistics& statistics() { return statistics_; }
+
+    /**
+     * Start recording all objects written into the buffer (see
+     * SampleRecorder). Recording in progress is stopped first. Only
+     * buffers of types with a SampleRecordingType can be recorded.
+     *
+     * @param path recording file.
+     * @param interval nominal sample interval in microseconds, 0 if unknown.
+     * @return was recording started.
+     */
+    bool startRecording(const QString& path, unsigned int interval);
+
+    /**
+     * Stop recording. After this returns the writer does not touch the
+     * recording any more.
+     */
+    void stopRecording();
+
+    /**
+     * Is buffer being recorded.
+     *
+     * @return is recording in progress.
+     */
+    bool isRecording() const;
+
+    /**
+     * Start keeping the latest objects written into the buffer in a
+     * flight recorder file (see FlightRecorder). Must be called before
+     * objects are written; the recorder stays until the buffer is
+     * destroyed. Only buffers of types with a SampleRecordingType can be
+     * recorded.
+     *
+     * @param path flight recorder file.
+     * @param capacity number of objects kept.
+     * @param interval fastest sample interval in microseconds, 0 if unknown.
+     * @return was the flight recorder started.
+     */
+    bool startFlightRecorder(const QString& path, unsigned int capacity, unsigned int interval);
+
+    /**
+     * Flight recorder of the buffer.
+     *
+     * @return flight recorder or NULL if none.
+     */
+    const FlightRecorder* flightRecorder() const { return flight_.loadAcquire(); }
+
+    /**
+     * Start staging objects written into the buffer for a StreamBridge.
+     * Must be called before objects are written; the tap stays until
+     * the buffer is destroyed. Only buffers of types with a
+     * SampleRecordingType can be streamed.
+     *
+     * @param capacity number of objects staged.
+     * @param interval fastest sample interval in microseconds, 0 if unknown.
+     * @return tap or NULL if the buffer cannot be streamed.
+     */
+    StreamTap* startStreamTap(unsigned int capacity, unsigned int interval);
+
+    /**
+     * Stream tap of the buffer.
+     *
+     * @return tap or NULL if none.
+     */
+    StreamTap* streamTap() const { return tap_.loadAcquire(); }
+
+protected:
+    mutable NodeStatistics statistics_; /**< buffer statistics, updated by readers too */
+
+    /**
+     * Append written objects to the flight recorder, the stream tap and
+     * the recording, if any. Costs three pointer loads when none is in
+     * use.
+     *
+     * @param values written objects.
+     * @param n number of objects.
+     */
+    void record(const void* values, unsigned n)
+    {
+        FlightRecorder* flight = flight_.load();
+        if (flight)
+            flight->append(values, n);
+        StreamTap* tap = tap_.load();
+        if (tap)
+            tap->append(values, n);
+        if (!recorder_.load())
+            return;
+        activeRecords_.fetchAndAddOrdered(1);
+        SampleRecorder* recorder = recorder_.loadAcquire();
+        if (recorder)
+            recorder->append(values, n);
+        activeRecords_.fetchAndAddOrdered(-1);
+    }
+
+    /**
+     * Round buffer size up to the next power of two.
+     *
+     * @param size requested size.
+     * @return power of two which is at least size.
+     */
+    static unsigned roundUpToPowerOfTwo(unsigned size);
+
 private:
     /**
      * Connect reader to this buffer.
@@ -132,10 +317,52 @@ private:
      * @return was unjoin succesful.
      */
     virtual bool unjoinTypeChecked(RingBufferReaderBase* reader) = 0;
+
+    /**
+     * SampleRecordingTypeId of the buffered objects.
+     *
+     * @return recording type.
+     */
+    virtual quint32 recordingType() const = 0;
+
+    /**
+     * Size of a buffered object.
+     *
+     * @return size in bytes.
+     */
+    virtual unsigned recordingSampleSize() const = 0;
+
+    /**
+     * Publish new recorder and delete the old one once the writer is
+     * not using it any more.
+     *
+     * @param recorder new recorder or NULL.
+     */
+    void replaceRecorder(SampleRecorder* recorder);
+
+    QAtomicPointer<SampleRecorder> recorder_;       /**< active recording or NULL */
+    QAtomicInt                     activeRecords_;  /**< writes appending to recorder_ */
+    QMutex                         recorderMutex_;  /**< serializes recording start and stop */
+    QAtomicPointer<FlightRecorder> flight_;         /**< flight recorder or NULL */
+    QAtomicPointer<StreamTap>      tap_;            /**< stream tap or NULL */
 };
 
 /**
- * Ring buffer implementation.
+ * Ring buffer implementation. Capacity is always a power of two so
+ * that slots can be indexed by masking the running counters, and
+ * reads and writes copy contiguous spans instead of single elements.
+ *
+ * The buffer is single producer, multiple consumer: only one thread
+ * may write, each reader may run in a thread of its own. Writes are
+ * published by storing writeCount_ with release semantics and readers
+ * load it with acquire semantics. Before overwriting slots the writer
+ * announces the range in writeStart_, which lets readers notice slots
+ * that were overwritten while being copied. A reader that falls more
+ * than a buffer size behind skips ahead to the oldest valid slot and
+ * counts the skipped objects as overruns. The set of readers is an immutable
+ * list which join and unjoin replace atomically; the old list is freed
+ * only after no wakeup is using it any more, so readers can be joined
+ * and unjoined from another thread while data is flowing.
  *
  * @tparam TYPE data type in buffer.
  */
@@ -146,14 +373,20 @@ public:
     /**
      * Constructor.
      *
-     * @param size how many elements can be buffered.
+     * @param size how many elements can be buffered. Rounded up to the
+     *             next power of two.
      */
     RingBuffer(unsigned size) :
         sink_(this, &RingBuffer::write),
-        bufferSize_(size),
-        writeCount_()
+        bufferSize_(roundUpToPowerOfTwo(size)),
+        mask_(bufferSize_ - 1),
+        writeCount_(0),
+        writeStart_(0),
+        readers_(new ReaderList),
+        activeWakeups_(0),
+        staged_(0)
     {
-        buffer_ = new TYPE[size];
+        buffer_ = new TYPE[bufferSize_];
         addSink(&sink_, "sink");
     }
 
@@ -163,6 +396,29 @@ public:
     virtual ~RingBuffer()
     {
         delete [] buffer_;
+        delete readers_.load();
+    }
+
+    /**
+     * Buffer has demand while it is recorded or any reader has.
+     *
+     * @return is buffered data used.
+     */
+    bool hasDemand() const
+    {
+        if (isRecording())
+            return true;
+        activeWakeups_.fetchAndAddOrdered(1);
+        const ReaderList* readers = readers_.loadAcquire();
+        bool demand = false;
+        foreach (RingBufferReader<TYPE>* reader, *readers) {
+            if (reader->hasDemand()) {
+                demand = true;
+                break;
+            }
+        }
+        activeWakeups_.fetchAndAddOrdered(-1);
+        return demand;
     }
 
     /**
@@ -177,15 +433,92 @@ public:
                   TYPE*                   values,
                   RingBufferReader<TYPE>& reader) const
     {
-        unsigned itemsRead = 0;
-        while (itemsRead < n && reader.readCount_ != (unsigned)writeCount_) {
+        unsigned writeCount = writeCount_.loadAcquire();
+        unsigned available = writeCount - reader.readCount_;
+        if (available > bufferSize_) {
+            // Reader has been lapped; the oldest valid slot is a full buffer back.
+            reportOverrun(reader, available - bufferSize_);
+            reader.readCount_ = writeCount - bufferSize_;
+            available = bufferSize_;
+        }
+        if (n > available)
+            n = available;
+
+        // At most two contiguous spans: up to the end of the buffer and
+        // the wrapped part from the beginning.
+        unsigned start = reader.readCount_ & mask_;
+        unsigned first = std::min(n, bufferSize_ - start);
+        std::copy(buffer_ + start, buffer_ + start + first, values);
+        std::copy(buffer_, buffer_ + (n - first), values + first);
+
+        // Drop the leading objects whose slots the writer started to
+        // overwrite while they were being copied. Full barrier keeps the
+        // copy above from being reordered past this check.
+        unsigned writeStart = writeStart_.fetchAndAddOrdered(0);
+        if (writeStart - reader.readCount_ > bufferSize_) {
+            unsigned lost = std::min(n, writeStart - reader.readCount_ - bufferSize_);
+            std::copy(values + lost, values + n, values);
+            reportOverrun(reader, lost);
+            reader.readCount_ += lost;
+            n -= lost;
+        }
 
-            *values++ = buffer_[reader.readCount_++ % bufferSize_];
+        reader.readCount_ += n;
+        return n;
+    }
 
-            ++itemsRead;
+    /**
+     * Look at unread objects in place. See RingBufferReader::peek().
+     *
+     * @param n maximum number of objects to look at.
+     * @param first set to the first span.
+     * @param firstCount set to the number of objects in first.
+     * @param second set to the wrapped span.
+     * @param reader buffer reader.
+     * @return how many objects the spans hold.
+     */
+    unsigned peek(unsigned                n,
+                  const TYPE*&            first,
+                  unsigned&               firstCount,
+                  const TYPE*&            second,
+                  RingBufferReader<TYPE>& reader) const
+    {
+        unsigned writeCount = writeCount_.loadAcquire();
+        unsigned available = writeCount - reader.readCount_;
+        if (available > bufferSize_) {
+            reportOverrun(reader, available - bufferSize_);
+            reader.readCount_ = writeCount - bufferSize_;
+            available = bufferSize_;
         }
+        if (n > available)
+            n = available;
+
+        unsigned start = reader.readCount_ & mask_;
+        firstCount = std::min(n, bufferSize_ - start);
+        first = buffer_ + start;
+        second = buffer_;
+        return n;
+    }
 
-        return itemsRead;
+    /**
+     * Move reader past objects returned by #peek().
+     *
+     * @param n number of objects used.
+     * @param reader buffer reader.
+     * @return how many of them were overwritten while in use.
+     */
+    unsigned commitRead(unsigned n, RingBufferReader<TYPE>& reader) const
+    {
+        // Full barrier keeps the use of the spans from being reordered
+        // past this check.
+        unsigned writeStart = writeStart_.fetchAndAddOrdered(0);
+        unsigned lost = 0;
+        if (writeStart - reader.readCount_ > bufferSize_) {
+            lost = std::min(n, writeStart - reader.readCount_ - bufferSize_);
+            reportOverrun(reader, lost);
+        }
+        reader.readCount_ += n;
+        return lost;
     }
 
 protected:
@@ -196,15 +529,60 @@ protected:
      */
     TYPE* nextSlot()
     {
-        return &buffer_[writeCount_ % bufferSize_];
+        unsigned writeCount = writeCount_.load();
+        writeStart_.fetchAndStoreOrdered(writeCount + 1);
+        return &buffer_[writeCount & mask_];
     }
 
     /**
-     * Called for each object written into buffer.
+     * Called for each object written into buffer. Makes the object
+     * written into #nextSlot() visible to readers.
      */
     void commit()
     {
-        ++writeCount_;
+        unsigned writeCount = writeCount_.load();
+        record(&buffer_[writeCount & mask_], 1);
+        writeCount_.storeRelease(writeCount + 1);
+        statistics_.addInput(1);
+    }
+
+    /**
+     * Get next slot for a batch of objects. Slots staged here become
+     * visible to readers together in #commitStaged(), so a writer
+     * producing several objects at once publishes them with a single
+     * release store. Must not be mixed with #nextSlot() and #commit()
+     * within a batch.
+     *
+     * @return next staged slot.
+     */
+    TYPE* stageSlot()
+    {
+        // Never wrap onto slots staged in the same batch.
+        if (staged_ == bufferSize_)
+            commitStaged();
+        unsigned writeCount = writeCount_.load() + staged_;
+        writeStart_.fetchAndStoreOrdered(writeCount + 1);
+        ++staged_;
+        return &buffer_[writeCount & mask_];
+    }
+
+    /**
+     * Make the objects written into #stageSlot() visible to readers.
+     *
+     * @return how many objects were committed.
+     */
+    unsigned commitStaged()
+    {
+        unsigned n = staged_;
+        if (!n)
+            return 0;
+        unsigned writeCount = writeCount_.load();
+        for (unsigned i = 0; i < n; ++i)
+            record(&buffer_[(writeCount + i) & mask_], 1);
+        writeCount_.storeRelease(writeCount + n);
+        statistics_.addInput(n);
+        staged_ = 0;
+        return n;
     }
 
     /**
@@ -212,10 +590,12 @@ protected:
      */
     void wakeUpReaders()
     {
-        RingBufferReader<TYPE>* reader;
-        foreach (reader, readers_) {
+        activeWakeups_.fetchAndAddOrdered(1);
+        const ReaderList* readers = readers_.loadAcquire();
+        foreach (RingBufferReader<TYPE>* reader, *readers) {
             reader->wakeup();
         }
+        activeWakeups_.fetchAndAddOrdered(-1);
     }
 
     /**
@@ -227,11 +607,19 @@ protected:
     void write(unsigned n, const TYPE* values)
     {
         // buffer incoming data
+        statistics_.addInput(n);
+        record(values, n);
+        unsigned writeCount = writeCount_.load();
+        writeStart_.fetchAndStoreOrdered(writeCount + n);
         while (n) {
-            *nextSlot() = *values++;
-            commit();
-            --n;
+            unsigned start = writeCount & mask_;
+            unsigned span = std::min(n, bufferSize_ - start);
+            std::copy(values, values + span, buffer_ + start);
+            writeCount += span;
+            values += span;
+            n -= span;
         }
+        writeCount_.storeRelease(writeCount);
         wakeUpReaders();
     }
 
@@ -244,16 +632,23 @@ protected:
     {
         sensordLogT() << "joining reader to ringbuffer.";
 
-        RingBufferReader<TYPE>* r = dynamic_cast<RingBufferReader<TYPE>*>(reader);
-        if (r == NULL) {
-            sensordLogW() << "Ringbuffer join failed!";
+        if (reader->dataTypeKey() != DataType<TYPE>::key()) {
+            sensordLogW() << "Ringbuffer join failed, reader of another type!";
             return false;
         }
+        RingBufferReader<TYPE>* r = static_cast<RingBufferReader<TYPE>*>(reader);
+
+        QMutexLocker locker(&readersMutex_);
+        const ReaderList* readers = readers_.load();
+        if (readers->contains(r))
+            return true;
 
-        r->readCount_ = writeCount_;
+        r->readCount_ = writeCount_.loadAcquire();
         r->buffer_    = this;
 
-        readers_.insert(r);
+        ReaderList* updated = new ReaderList(*readers);
+        updated->append(r);
+        replaceReaders(updated);
         return true;
     }
 
@@ -264,23 +659,78 @@ protected:
      */
     virtual bool unjoinTypeChecked(RingBufferReaderBase* reader)
     {
-        RingBufferReader<TYPE>* r = dynamic_cast<RingBufferReader<TYPE>*>(reader);
-        if (r == NULL) {
-            sensordLogW() << "Ringbuffer unjoin failed!";
+        if (reader->dataTypeKey() != DataType<TYPE>::key()) {
+            sensordLogW() << "Ringbuffer unjoin failed, reader of another type!";
             return false;
         }
+        RingBufferReader<TYPE>* r = static_cast<RingBufferReader<TYPE>*>(reader);
 
-        readers_.remove(r);
+        QMutexLocker locker(&readersMutex_);
+        const ReaderList* readers = readers_.load();
+        if (!readers->contains(r))
+            return true;
+
+        ReaderList* updated = new ReaderList(*readers);
+        updated->removeAll(r);
+        replaceReaders(updated);
         return true;
     }
 
+private:
+    typedef QList<RingBufferReader<TYPE>*> ReaderList;
+
+    virtual quint32 recordingType() const
+    {
+        return SampleRecordingType<TYPE>::TYPE_ID;
+    }
+
+    virtual unsigned recordingSampleSize() const
+    {
+        return sizeof(TYPE);
+    }
+
+    /**
+     * Account objects a reader missed.
+     *
+     * @param reader buffer reader.
+     * @param count number of missed objects.
+     */
+    void reportOverrun(RingBufferReader<TYPE>& reader, unsigned count) const
+    {
+        if (!count)
+            return;
+        reader.overruns_ += count;
+        statistics_.addDrops(count);
+        sensordLogD() << "Ringbuffer reader overrun, skipped " << count << " objects, " << reader.overruns_ << " in total";
+    }
+
+    /**
+     * Publish new reader list and free the old one once no wakeup is
+     * iterating it. After this returns removed readers are not called
+     * any more. Must not be called from within a wakeup of this buffer.
+     *
+     * @param readers new reader list.
+     */
+    void replaceReaders(const ReaderList* readers)
+    {
+        const ReaderList* old = readers_.fetchAndStoreOrdered(readers);
+        while (activeWakeups_.loadAcquire())
+            QThread::yieldCurrentThread();
+        delete old;
+    }
+
 private:
 
     Sink<RingBuffer, TYPE>        sink_;       /**< data sink */
-    const unsigned                bufferSize_; /**< buffer size */
+    const unsigned                bufferSize_; /**< buffer size, power of two */
+    const unsigned                mask_;       /**< bufferSize_ - 1 */
     TYPE*                         buffer_;     /**< buffer */
-    unsigned int                  writeCount_; /**< how many objects have been written */
-    QSet<RingBufferReader<TYPE>*> readers_;    /**< connected readers */
+    QAtomicInt                    writeCount_; /**< how many objects have been written */
+    mutable QAtomicInt            writeStart_; /**< how many objects have been or are being written */
+    QAtomicPointer<const ReaderList> readers_; /**< connected readers */
+    mutable QAtomicInt            activeWakeups_; /**< wakeups iterating readers_ */
+    QMutex                        readersMutex_; /**< serializes reader list updates */
+    unsigned                      staged_;     /**< objects staged by the writer */
 };
 
 #endif
@@ -0,0 +1,91 @@
+/**
+   @file samplehistory.cpp
+   @brief SampleHistory
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "samplehistory.h"
+#include <string.h>
+
+SampleHistory::SampleHistory() :
+    entries_(NULL),
+    capacity_(0),
+    first_(0),
+    count_(0),
+    recorded_(0)
+{
+}
+
+SampleHistory::~SampleHistory()
+{
+    delete[] entries_;
+}
+
+void SampleHistory::setCapacity(int capacity)
+{
+    delete[] entries_;
+    entries_ = capacity > 0 ? new Entry[capacity] : NULL;
+    capacity_ = qMax(capacity, 0);
+    first_ = 0;
+    count_ = 0;
+    recorded_ = 0;
+}
+
+void SampleHistory::record(quint64 timestamp, const void* data, int size)
+{
+    if (!capacity_ || size < 0 || size > SampleQueue::MAX_SAMPLE_SIZE)
+        return;
+
+    int pos;
+    if (count_ < capacity_) {
+        pos = (first_ + count_) % capacity_;
+        ++count_;
+    } else {
+        pos = first_;
+        first_ = (first_ + 1) % capacity_;
+    }
+    Entry& e = entries_[pos];
+    e.timestamp = timestamp;
+    e.size = size;
+    memcpy(e.data, data, size);
+    ++recorded_;
+}
+
+int SampleHistory::find(quint64 since) const
+{
+    // Samples are recorded in delivery order, which follows timestamps.
+    int low = 0;
+    int high = count_;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (entry(mid).timestamp < since)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+const void* SampleHistory::sample(int index, int& size) const
+{
+    const Entry& e = entry(index);
+    size = e.size;
+    return e.data;
+}
@@ -0,0 +1,126 @@
+/**
+   @file samplehistory.h
+   @brief SampleHistory
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef SAMPLEHISTORY_H
+#define SAMPLEHISTORY_H
+
+#include <QtGlobal>
+#include "samplequeue.h"
+
+/**
+ * Fixed size ring of the most recent samples of a channel. Space for
+ * all samples is allocated once by #setCapacity(), recording a sample
+ * only copies it over the oldest one. Not thread safe, the channel
+ * records and reads the history from the main thread only.
+ */
+class SampleHistory
+{
+public:
+    /**
+     * Constructor. History is disabled until #setCapacity() is called.
+     */
+    SampleHistory();
+
+    /**
+     * Destructor.
+     */
+    ~SampleHistory();
+
+    /**
+     * Set the number of samples kept. Drops the recorded samples.
+     *
+     * @param capacity number of samples, 0 disables the history.
+     */
+    void setCapacity(int capacity);
+
+    /**
+     * Is history recorded.
+     *
+     * @return is capacity non-zero.
+     */
+    bool isEnabled() const { return capacity_ > 0; }
+
+    /**
+     * Record a sample, replacing the oldest one when the history is full.
+     *
+     * @param timestamp sample timestamp, microseconds.
+     * @param data sample.
+     * @param size size of the sample, at most SampleQueue::MAX_SAMPLE_SIZE.
+     */
+    void record(quint64 timestamp, const void* data, int size);
+
+    /**
+     * Number of recorded samples.
+     *
+     * @return sample count.
+     */
+    int size() const { return count_; }
+
+    /**
+     * Number of samples recorded since the capacity was set. The
+     * sample at index \c i is sample number <tt>recorded() - size() + i</tt>.
+     *
+     * @return total sample count.
+     */
+    quint64 recorded() const { return recorded_; }
+
+    /**
+     * Index of the oldest sample not older than given time.
+     *
+     * @param since timestamp, microseconds.
+     * @return index to use with #sample(), #size() if there is none.
+     */
+    int find(quint64 since) const;
+
+    /**
+     * Get a recorded sample.
+     *
+     * @param index sample index, 0 being the oldest.
+     * @param size location for the size of the sample.
+     * @return sample data, valid until the next #record().
+     */
+    const void* sample(int index, int& size) const;
+
+private:
+    Q_DISABLE_COPY(SampleHistory)
+
+    /**
+     * Recorded sample.
+     */
+    struct Entry
+    {
+        quint64 timestamp;                       /**< sample timestamp */
+        int     size;                            /**< size of the sample */
+        char    data[SampleQueue::MAX_SAMPLE_SIZE]; /**< sample */
+    };
+
+    const Entry& entry(int index) const { return entries_[(first_ + index) % capacity_]; }
+
+    Entry* entries_;  /**< ring storage */
+    int    capacity_; /**< number of entries */
+    int    first_;    /**< position of the oldest sample */
+    int    count_;    /**< number of recorded samples */
+    quint64 recorded_; /**< number of samples ever recorded */
+};
+
+#endif // SAMPLEHISTORY_H
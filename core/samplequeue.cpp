@@ -0,0 +1,104 @@
+/**
+   @file samplequeue.cpp
+   @brief SampleQueue
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "samplequeue.h"
+#include <string.h>
+
+SampleQueue::SampleQueue(unsigned int capacity) :
+    slots_(0),
+    mask_(0),
+    writePos_(0),
+    readPos_(0)
+{
+    unsigned int size = 1;
+    while (size < capacity)
+        size <<= 1;
+
+    slots_ = new Slot[size];
+    mask_ = size - 1;
+    for (unsigned int i = 0; i < size; ++i)
+        slots_[i].sequence.store(i);
+}
+
+SampleQueue::~SampleQueue()
+{
+    delete[] slots_;
+}
+
+bool SampleQueue::push(int sessionId, const void* source, int size, quint64 queued)
+{
+    if (size < 0 || size > MAX_SAMPLE_SIZE)
+        return false;
+
+    unsigned int pos = writePos_.load();
+    Slot* slot;
+    for (;;)
+    {
+        slot = &slots_[pos & mask_];
+        int diff = (int)((unsigned int)slot->sequence.loadAcquire() - pos);
+        if (diff == 0)
+        {
+            if (writePos_.testAndSetRelaxed(pos, pos + 1))
+                break;
+        }
+        else if (diff < 0)
+        {
+            // Consumer has not released the slot yet: queue is full.
+            return false;
+        }
+        pos = writePos_.load();
+    }
+
+    slot->sessionId = sessionId;
+    slot->size = size;
+    slot->queued = queued;
+    memcpy(slot->data, source, size);
+    slot->sequence.storeRelease(pos + 1);
+    return true;
+}
+
+bool SampleQueue::peek(int& sessionId, const void*& data, int& size, quint64* queued) const
+{
+    const Slot& slot = slots_[readPos_ & mask_];
+    if ((int)((unsigned int)slot.sequence.loadAcquire() - (readPos_ + 1)) < 0)
+        return false;
+
+    sessionId = slot.sessionId;
+    data = slot.data;
+    size = slot.size;
+    if (queued)
+        *queued = slot.queued;
+    return true;
+}
+
+void SampleQueue::pop()
+{
+    slots_[readPos_ & mask_].sequence.storeRelease(readPos_ + mask_ + 1);
+    ++readPos_;
+}
+
+bool SampleQueue::isEmpty() const
+{
+    const Slot& slot = slots_[readPos_ & mask_];
+    return (int)((unsigned int)slot.sequence.loadAcquire() - (readPos_ + 1)) < 0;
+}
@@ -0,0 +1,114 @@
+/**
+   @file samplequeue.h
+   @brief SampleQueue
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef SAMPLEQUEUE_H
+#define SAMPLEQUEUE_H
+
+#include <QAtomicInt>
+
+/**
+ * Bounded lock-free queue for handing samples over from adaptor threads
+ * to the main thread. All slots are allocated once in the constructor,
+ * so pushing and popping never touches the heap. Any number of threads
+ * may push, but only one thread may pop.
+ */
+class SampleQueue
+{
+public:
+    /**
+     * Largest sample size in bytes which fits into a single slot.
+     */
+    static const int MAX_SAMPLE_SIZE = 64;
+
+    /**
+     * Constructor.
+     *
+     * @param capacity how many samples can be queued. Rounded up to the
+     *                 next power of two.
+     */
+    SampleQueue(unsigned int capacity = 256);
+
+    /**
+     * Destructor.
+     */
+    ~SampleQueue();
+
+    /**
+     * Queue sample for given session. Safe to call from any thread.
+     *
+     * @param sessionId session ID.
+     * @param source location from where to copy the sample.
+     * @param size sample size in bytes.
+     * @param queued time the sample was queued, see SampleTrace.
+     * @return was sample queued. Fails if queue is full or sample is
+     *         larger than #MAX_SAMPLE_SIZE.
+     */
+    bool push(int sessionId, const void* source, int size, quint64 queued = 0);
+
+    /**
+     * Get the oldest queued sample without removing it. Data stays
+     * valid until #pop() is called. Consumer thread only.
+     *
+     * @param sessionId session ID of the sample.
+     * @param data pointer to the sample data.
+     * @param size sample size in bytes.
+     * @param queued if not NULL, receives the time given to #push().
+     * @return was there a sample in the queue.
+     */
+    bool peek(int& sessionId, const void*& data, int& size, quint64* queued = NULL) const;
+
+    /**
+     * Remove the oldest sample. Must be preceded by succesful #peek().
+     * Consumer thread only.
+     */
+    void pop();
+
+    /**
+     * Is queue empty. Consumer thread only.
+     *
+     * @return is queue empty.
+     */
+    bool isEmpty() const;
+
+private:
+    Q_DISABLE_COPY(SampleQueue)
+
+    /**
+     * Single queue slot.
+     */
+    struct Slot
+    {
+        QAtomicInt sequence;              /**< slot sequence number */
+        int        sessionId;             /**< session ID */
+        int        size;                  /**< sample size */
+        quint64    queued;                /**< time sample was queued */
+        char       data[MAX_SAMPLE_SIZE]; /**< sample data */
+    };
+
+    Slot*        slots_;      /**< preallocated slots */
+    unsigned int mask_;       /**< capacity - 1 */
+    QAtomicInt   writePos_;   /**< next position to write */
+    unsigned int readPos_;    /**< next position to read */
+};
+
+#endif // SAMPLEQUEUE_H
@@ -0,0 +1,176 @@
+/**
+   @file samplerecorder.cpp
+   @brief SampleRecorder
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+
+#include "samplerecorder.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include "logging.h"
+
+/**
+ * Amount of file space allocated and mapped at a time.
+ */
+static const size_t RECORDING_CHUNK = 256 * 1024;
+
+SampleRecorder::SampleRecorder() :
+    fd_(-1),
+    header_(NULL),
+    mapSize_(0),
+    used_(0)
+{
+}
+
+SampleRecorder::~SampleRecorder()
+{
+    close();
+}
+
+bool SampleRecorder::open(const QString& path, quint32 type, quint32 sampleSize, quint32 interval)
+{
+    close();
+    if (!sampleSize) {
+        return false;
+    }
+
+    fd_ = ::open(path.toLocal8Bit().constData(), O_RDWR | O_CREAT | O_CLOEXEC | O_NOFOLLOW, 0644);
+    if (fd_ == -1) {
+        sensordLogW() << "Failed to open recording " << path << ": " << strerror(errno);
+        return false;
+    }
+    path_ = path;
+
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        sensordLogW() << "Failed to stat recording " << path << ": " << strerror(errno);
+        close();
+        return false;
+    }
+
+    SampleRecordingHeader existing;
+    bool append = st.st_size > 0;
+    if (append) {
+        if (st.st_size < (off_t)sizeof(existing) ||
+            pread(fd_, &existing, sizeof(existing), 0) != (ssize_t)sizeof(existing) ||
+            existing.magic != SAMPLE_RECORDING_MAGIC ||
+            existing.version != SAMPLE_RECORDING_VERSION ||
+            existing.type != type ||
+            existing.sampleSize != sampleSize ||
+            existing.count > (st.st_size - sizeof(existing)) / sampleSize) {
+            sensordLogW() << path << " exists and is not a compatible recording";
+            close();
+            return false;
+        }
+        used_ = sizeof(existing) + existing.count * sampleSize;
+    } else {
+        used_ = sizeof(existing);
+    }
+
+    if (!reserve(used_)) {
+        // Do not leave allocated space behind in the file.
+        if (ftruncate(fd_, st.st_size) != 0)
+            sensordLogW() << "Failed to truncate recording " << path << ": " << strerror(errno);
+        close();
+        return false;
+    }
+
+    if (!append) {
+        memset(header_, 0, sizeof(*header_));
+        header_->magic = SAMPLE_RECORDING_MAGIC;
+        header_->version = SAMPLE_RECORDING_VERSION;
+        header_->type = type;
+        header_->sampleSize = sampleSize;
+        header_->interval = interval;
+    } else if (header_->interval != interval) {
+        sensordLogD() << "Appending to " << path << " recorded at " << header_->interval << " us interval, now " << interval << " us";
+    }
+    sensordLogD() << "Recording " << path << ", " << header_->count << " samples already recorded";
+    return true;
+}
+
+void SampleRecorder::close()
+{
+    bool mapped = header_ != NULL;
+    if (mapped) {
+        munmap(header_, mapSize_);
+        header_ = NULL;
+    }
+    if (fd_ != -1) {
+        if (mapped && ftruncate(fd_, used_) != 0)
+            sensordLogW() << "Failed to truncate recording " << path_ << ": " << strerror(errno);
+        ::close(fd_);
+        fd_ = -1;
+    }
+    mapSize_ = 0;
+    used_ = 0;
+}
+
+bool SampleRecorder::append(const void* samples, unsigned int count)
+{
+    if (!header_)
+        return false;
+
+    size_t size = (size_t)count * header_->sampleSize;
+    if (used_ + size > mapSize_ && !reserve(used_ + size)) {
+        sensordLogW() << "Recording " << path_ << " stopped after " << header_->count << " samples";
+        close();
+        return false;
+    }
+
+    memcpy((char*)header_ + used_, samples, size);
+    used_ += size;
+    // Samples are in place before they are counted, so a concurrent
+    // reader of the file never sees a partial record.
+    __atomic_store_n(&header_->count, header_->count + count, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool SampleRecorder::reserve(size_t size)
+{
+    size_t mapSize = (size + RECORDING_CHUNK - 1) / RECORDING_CHUNK * RECORDING_CHUNK;
+    if (mapSize <= mapSize_)
+        return true;
+
+    int error = posix_fallocate(fd_, 0, mapSize);
+    if (error) {
+        sensordLogW() << "Failed to allocate space for recording " << path_ << ": " << strerror(error);
+        return false;
+    }
+
+    void* map;
+    if (header_)
+        map = mremap(header_, mapSize_, mapSize, MREMAP_MAYMOVE);
+    else
+        map = mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        sensordLogW() << "Failed to map recording " << path_ << ": " << strerror(errno);
+        return false;
+    }
+
+    header_ = (SampleRecordingHeader*)map;
+    mapSize_ = mapSize;
+    return true;
+}
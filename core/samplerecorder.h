@@ -0,0 +1,113 @@
+/**
+   @file samplerecorder.h
+   @brief SampleRecorder
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+
+#ifndef SAMPLERECORDER_H
+#define SAMPLERECORDER_H
+
+#include <QString>
+#include <stddef.h>
+#include "samplerecording.h"
+
+/**
+ * Writes samples into an append-only recording file (see
+ * SampleRecordingHeader). The file is memory mapped and space is
+ * allocated ahead in large chunks, so appending samples is a memcpy in
+ * the common case and only every chunk costs system calls. Disk space
+ * is allocated before it is mapped, so a full disk ends the recording
+ * instead of faulting the writer.
+ *
+ * Only one thread may append at a time.
+ */
+class SampleRecorder
+{
+public:
+    /**
+     * Constructor.
+     */
+    SampleRecorder();
+
+    /**
+     * Destructor. Closes the recording.
+     */
+    ~SampleRecorder();
+
+    /**
+     * Open recording. An existing recording of the same sample type is
+     * appended to, a new file gets a fresh header. Any other existing
+     * file is refused.
+     *
+     * @param path recording file.
+     * @param type SampleRecordingTypeId of the samples.
+     * @param sampleSize size of a single sample in bytes.
+     * @param interval nominal sample interval in microseconds, 0 if unknown.
+     * @return was the recording opened.
+     */
+    bool open(const QString& path, quint32 type, quint32 sampleSize, quint32 interval);
+
+    /**
+     * Close recording. Space allocated ahead is released.
+     */
+    void close();
+
+    /**
+     * Is recording open.
+     *
+     * @return is recording open.
+     */
+    bool isOpen() const { return header_ != NULL; }
+
+    /**
+     * Append samples to the recording. If space cannot be allocated
+     * the recording is closed.
+     *
+     * @param samples samples to append.
+     * @param count number of samples.
+     * @return were samples appended.
+     */
+    bool append(const void* samples, unsigned int count);
+
+    /**
+     * Path of the recording.
+     *
+     * @return path given to #open().
+     */
+    const QString& path() const { return path_; }
+
+private:
+    /**
+     * Allocate and map file space for at least given size.
+     *
+     * @param size required size in bytes.
+     * @return was space reserved.
+     */
+    bool reserve(size_t size);
+
+    QString                path_;    /**< recording file */
+    int                    fd_;      /**< recording file descriptor */
+    SampleRecordingHeader* header_;  /**< mapped file or NULL */
+    size_t                 mapSize_; /**< size of the mapping */
+    size_t                 used_;    /**< bytes written including the header */
+};
+
+#endif // SAMPLERECORDER_H
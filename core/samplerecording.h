@@ -0,0 +1,121 @@
+/**
+   @file samplerecording.h
+   @brief Recorded sample file format
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+
+#ifndef SAMPLERECORDING_H
+#define SAMPLERECORDING_H
+
+#include <QtGlobal>
+
+class TimedUnsigned;
+class TimedXyzData;
+class ProximityData;
+class CalibratedMagneticFieldData;
+class CompassData;
+class PoseData;
+class TapData;
+class TouchData;
+class TimedQuaternionData;
+
+/**
+ * Magic number at the beginning of a recording, "SFWT".
+ */
+const quint32 SAMPLE_RECORDING_MAGIC = 0x54574653;
+
+/**
+ * Version of the recording layout.
+ */
+const quint32 SAMPLE_RECORDING_VERSION = 1;
+
+/**
+ * Sample type stored in a recording.
+ */
+enum SampleRecordingTypeId
+{
+    RecordingUnknown = 0,            /**< type without a recording id */
+    RecordingTimedUnsigned,          /**< TimedUnsigned, e.g. ALS */
+    RecordingTimedXyzData,           /**< TimedXyzData, e.g. accelerometer */
+    RecordingProximityData,          /**< ProximityData */
+    RecordingCalibratedMagneticData, /**< CalibratedMagneticFieldData */
+    RecordingCompassData,            /**< CompassData */
+    RecordingPoseData,               /**< PoseData */
+    RecordingTapData,                /**< TapData */
+    RecordingTouchData,              /**< TouchData */
+    RecordingQuaternionData          /**< TimedQuaternionData */
+};
+
+/**
+ * Header of a sample recording. Samples follow the header back to back
+ * in fixed size records, as stored in memory by sensord on the
+ * recording architecture, so every sample starts with its
+ * CLOCK_MONOTONIC timestamp in microseconds and the file can be used
+ * directly through a memory mapping. Samples are in timestamp order.
+ * The file is only ever appended to; count is updated after the
+ * samples have been written, so a reader never sees a partial record.
+ */
+struct SampleRecordingHeader
+{
+    quint32 magic;      /**< SAMPLE_RECORDING_MAGIC */
+    quint32 version;    /**< SAMPLE_RECORDING_VERSION */
+    quint32 type;       /**< SampleRecordingTypeId of the samples */
+    quint32 sampleSize; /**< size of a single sample in bytes */
+    quint64 count;      /**< number of samples */
+    quint32 interval;   /**< nominal sample interval in microseconds, 0 if unknown */
+    quint32 reserved;   /**< zero */
+};
+
+/**
+ * Maps sample types to SampleRecordingTypeId. Types without a
+ * specialization cannot be recorded.
+ */
+template <class TYPE>
+struct SampleRecordingType { static const quint32 TYPE_ID = RecordingUnknown; };
+
+template <>
+struct SampleRecordingType<TimedUnsigned> { static const quint32 TYPE_ID = RecordingTimedUnsigned; };
+
+template <>
+struct SampleRecordingType<TimedXyzData> { static const quint32 TYPE_ID = RecordingTimedXyzData; };
+
+template <>
+struct SampleRecordingType<ProximityData> { static const quint32 TYPE_ID = RecordingProximityData; };
+
+template <>
+struct SampleRecordingType<CalibratedMagneticFieldData> { static const quint32 TYPE_ID = RecordingCalibratedMagneticData; };
+
+template <>
+struct SampleRecordingType<CompassData> { static const quint32 TYPE_ID = RecordingCompassData; };
+
+template <>
+struct SampleRecordingType<PoseData> { static const quint32 TYPE_ID = RecordingPoseData; };
+
+template <>
+struct SampleRecordingType<TapData> { static const quint32 TYPE_ID = RecordingTapData; };
+
+template <>
+struct SampleRecordingType<TouchData> { static const quint32 TYPE_ID = RecordingTouchData; };
+
+template <>
+struct SampleRecordingType<TimedQuaternionData> { static const quint32 TYPE_ID = RecordingQuaternionData; };
+
+#endif // SAMPLERECORDING_H
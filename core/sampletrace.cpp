@@ -0,0 +1,92 @@
+/**
+   @file sampletrace.cpp
+   @brief SampleTrace
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "sampletrace.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <errno.h>
+#include "logging.h"
+
+QAtomicInt SampleTrace::users_(0);
+int SampleTrace::markerFd_ = -1;
+
+void SampleTrace::setUser(bool enabled)
+{
+    if (enabled)
+        users_.ref();
+    else
+        users_.deref();
+}
+
+bool SampleTrace::openMarker(const QString& path)
+{
+    if (markerFd_ != -1)
+        return true;
+
+    markerFd_ = open(path.toLocal8Bit().constData(), O_WRONLY | O_CLOEXEC);
+    if (markerFd_ == -1) {
+        sensordLogW() << "Failed to open trace marker " << path << ": " << strerror(errno);
+        return false;
+    }
+    setUser(true);
+    return true;
+}
+
+void SampleTrace::closeMarker()
+{
+    if (markerFd_ == -1)
+        return;
+    setUser(false);
+    close(markerFd_);
+    markerFd_ = -1;
+}
+
+void SampleTrace::mark(const char* stage, int sessionId, quint64 sampled)
+{
+    if (markerFd_ == -1)
+        return;
+
+    char line[96];
+    int length = snprintf(line, sizeof(line), "sensord_sample: stage=%s session=%d sample=%llu\n",
+                          stage, sessionId, (unsigned long long)sampled);
+    if (length > 0)
+        write(markerFd_, line, qMin(length, (int)sizeof(line) - 1));
+}
+
+quint64 SampleTrace::sampleTime(const void* data, int size)
+{
+    quint64 time = 0;
+    if (size >= (int)sizeof(time))
+        memcpy(&time, data, sizeof(time));
+    return time;
+}
+
+quint64 SampleTrace::now()
+{
+    timespec stamp;
+    clock_gettime(CLOCK_MONOTONIC, &stamp);
+    return (quint64)stamp.tv_sec * 1000000 + stamp.tv_nsec / 1000;
+}
@@ -0,0 +1,105 @@
+/**
+   @file sampletrace.h
+   @brief SampleTrace
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef SAMPLETRACE_H
+#define SAMPLETRACE_H
+
+#include <QString>
+#include <QAtomicInt>
+
+/**
+ * Sample latency tracing. Samples are stamped when they are queued for
+ * the main thread, when the main thread takes them from the queue and
+ * when they are written to the session socket. Together with the
+ * timestamp set by the adaptor this gives the time a sample spends in
+ * each stage.
+ *
+ * Stamps are only taken while tracing is enabled: either some session
+ * has requested traced frames (see SessionData::setTracing()) or the
+ * ftrace marker is open, in which case every stage is also written to
+ * <tt>trace_marker</tt> as
+ * <tt>sensord_sample: stage=&lt;stage&gt; session=&lt;id&gt; sample=&lt;timestamp&gt;</tt>.
+ */
+class SampleTrace
+{
+public:
+    /**
+     * Is tracing enabled.
+     *
+     * @return should samples be stamped.
+     */
+    static bool isEnabled() { return users_.load() > 0; }
+
+    /**
+     * Register or unregister a user of the stamps, for example a
+     * session receiving traced frames.
+     *
+     * @param enabled add or remove user.
+     */
+    static void setUser(bool enabled);
+
+    /**
+     * Open ftrace marker file for writing tracepoints.
+     *
+     * @param path path of <tt>trace_marker</tt>.
+     * @return was marker opened.
+     */
+    static bool openMarker(const QString& path);
+
+    /**
+     * Close ftrace marker.
+     */
+    static void closeMarker();
+
+    /**
+     * Write tracepoint for a sample if the marker is open.
+     *
+     * @param stage stage name.
+     * @param sessionId session ID.
+     * @param sampled adaptor timestamp of the sample.
+     */
+    static void mark(const char* stage, int sessionId, quint64 sampled);
+
+    /**
+     * Adaptor timestamp of a sample. All sample types start with
+     * TimedData, so the timestamp is the first field.
+     *
+     * @param data sample.
+     * @param size sample size.
+     * @return timestamp or 0 if the sample is too small.
+     */
+    static quint64 sampleTime(const void* data, int size);
+
+    /**
+     * Current time in the clock used by sample timestamps.
+     *
+     * @return CLOCK_MONOTONIC in microseconds.
+     */
+    static quint64 now();
+
+private:
+    static QAtomicInt users_;     /**< number of stamp users */
+    static int        markerFd_;  /**< trace_marker or -1 */
+};
+
+#endif // SAMPLETRACE_H
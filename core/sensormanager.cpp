@@ -28,34 +28,61 @@
  */
 
 #include "sensormanager_a.h"
+#include "abstractsensor_a.h"
 #include "serviceinfo.h"
 #include "sensormanager.h"
 #include "loader.h"
 #include "idutils.h"
 #include "logging.h"
+#include "config.h"
+#include "ringbuffer.h"
+#include "threadscheduling.h"
 #ifdef SENSORFW_MCE_WATCHER
 #include "mcewatcher.h"
+#include "utils.h"
+#include "cpuboost.h"
+#include "deferredwork.h"
+#include "streambridge.h"
 #endif // SENSORFW_MCE_WATCHER
 #include <QSocketNotifier>
+#include <QThread>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDBusServer>
 #include <errno.h>
 #include "sockethandler.h"
+#include "localsession.h"
+#include "sessionprotocol.h"
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
 
-typedef struct {
-        int id;
-        int size;
-        void* buffer;
-} PipeData;
+/**
+ * Thread delivering samples to the sessions when
+ * <tt>global/delivery_thread</tt> is set.
+ */
+class DeliveryThread : public QThread
+{
+protected:
+    void run()
+    {
+        ThreadScheduling::apply("deliverythread");
+        exec();
+    }
+};
 
 SensorManager* SensorManager::instance_ = NULL;
+bool SensorManager::embedded_ = false;
 int SensorManager::sessionIdCount_ = 0;
 
 SensorInstanceEntry::SensorInstanceEntry(const QString& type) :
     sensor_(0),
-    type_(type)
+    type_(type),
+    idleSince_(0)
 {
 }
 
@@ -66,7 +93,8 @@ SensorInstanceEntry::~SensorInstanceEntry()
 ChainInstanceEntry::ChainInstanceEntry(const QString& type) :
     cnt_(0),
     chain_(0),
-    type_(type)
+    type_(type),
+    idleSince_(0)
 {
 }
 
@@ -77,7 +105,8 @@ ChainInstanceEntry::~ChainInstanceEntry()
 DeviceAdaptorInstanceEntry::DeviceAdaptorInstanceEntry(const QString& type, const QString& id) :
     adaptor_(0),
     cnt_(0),
-    type_(type)
+    type_(type),
+    idleSince_(0)
 {
     propertyMap_ = ParameterParser::getPropertyMap(id);
 }
@@ -101,32 +130,98 @@ SensorManager& SensorManager::instance()
     return *instance_;
 }
 
+void SensorManager::setEmbedded(bool value)
+{
+    if (instance_) {
+        sensordLogW() << "Sensor manager already created, not changing embedded mode";
+        return;
+    }
+    embedded_ = value;
+}
+
+bool SensorManager::embedded()
+{
+    return embedded_;
+}
+
+void SensorManager::setLocalSession(int sessionId, LocalSession* session)
+{
+    QMutexLocker locker(&localSessionMutex_);
+    if (session)
+        localSessions_.insert(sessionId, session);
+    else
+        localSessions_.remove(sessionId);
+}
+
 SensorManager::SensorManager()
     : errorCode_(SmNoError),
-    pipeNotifier_(0)
+    eventFd_(-1),
+    samplesPending_(0),
+    eventNotifier_(0),
+    idleUnloadDelay_(0),
+    idleUnloadPlugins_(false),
+    idleConfigRead_(false),
+    deliveryThread_(0),
+    streamBridge_(0),
+    peerServer_(0)
 {
-    const char* SOCKET_NAME = "/var/run/sensord.sock";
-
     new SensorManagerAdaptor(this);
 
-    socketHandler_ = new SocketHandler(this);
+    idleTimer_.setSingleShot(true);
+    connect(&idleTimer_, SIGNAL(timeout()), this, SLOT(reapIdle()));
+
+    // Objects moved to the delivery thread must not have a parent.
+    bool threaded = Config::configuration() && Config::configuration()->value<bool>("global/delivery_thread", false);
+    socketHandler_ = new SocketHandler(threaded ? NULL : this);
     connect(socketHandler_, SIGNAL(lostSession(int)), this, SLOT(lostClient(int)));
 
-    Q_ASSERT(socketHandler_->listen(SOCKET_NAME));
+    if (embedded_) {
+        sensordLogD() << "Embedded, not listening for session sockets";
+    } else if (!socketHandler_->listen(SESSION_SOCKET_PATH)) {
+        sensordLogC() << "Failed to listen on " << SESSION_SOCKET_PATH;
+    }
+    if (!embedded_ && Config::configuration() && Config::configuration()->value<bool>("global/seqpacket_socket", false)) {
+        if (!socketHandler_->listenSeqPacket(SESSION_SEQPACKET_SOCKET_PATH))
+            sensordLogW() << "Failed to listen on " << SESSION_SEQPACKET_SOCKET_PATH;
+        else if (chmod(SESSION_SEQPACKET_SOCKET_PATH, S_IRWXU|S_IRWXG|S_IRWXO) != 0)
+            sensordLogW() << "Error setting socket permissions! " << SESSION_SEQPACKET_SOCKET_PATH;
+    }
 
-    if (pipe(pipefds_) == -1) {
-        sensordLogC() << "Failed to create pipe: " << strerror(errno);
-        pipefds_[0] = pipefds_[1] = 0;
+    eventFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (eventFd_ == -1) {
+        sensordLogC() << "Failed to create eventfd: " << strerror(errno);
     } else {
-        pipeNotifier_ = new QSocketNotifier(pipefds_[0], QSocketNotifier::Read);
-        connect(pipeNotifier_, SIGNAL(activated(int)), this, SLOT(sensorDataHandler(int)));
+        eventNotifier_ = new QSocketNotifier(eventFd_, QSocketNotifier::Read);
+        // Delivery runs in the thread of the notifier.
+        connect(eventNotifier_, SIGNAL(activated(int)), this, SLOT(sensorDataHandler(int)), Qt::DirectConnection);
+    }
+
+    if (threaded) {
+        deliveryThread_ = new DeliveryThread;
+        socketHandler_->moveToThread(deliveryThread_);
+        if (eventNotifier_)
+            eventNotifier_->moveToThread(deliveryThread_);
+        deliveryThread_->start();
+        sensordLogD() << "Delivering samples in a thread of their own";
     }
 
-    if (chmod(SOCKET_NAME, S_IRWXU|S_IRWXG|S_IRWXO) != 0) {
-        sensordLogW() << "Error setting socket permissions! " << SOCKET_NAME;
+    if (!embedded_ && chmod(SESSION_SOCKET_PATH, S_IRWXU|S_IRWXG|S_IRWXO) != 0) {
+        sensordLogW() << "Error setting socket permissions! " << SESSION_SOCKET_PATH;
     }
 
+    streamBridge_ = StreamBridge::create();
+
+#ifdef SENSORFW_MCE_WATCHER
+    // Display and power save state only matter once a sensor is used.
+    mceWatcher_ = 0;
+#endif //SENSORFW_MCE_WATCHER
+}
+
+void SensorManager::startMceWatcher()
+{
 #ifdef SENSORFW_MCE_WATCHER
+    if (mceWatcher_)
+        return;
 
     mceWatcher_ = new MceWatcher(this);
     connect(mceWatcher_, SIGNAL(displayStateChanged(const bool)),
@@ -134,12 +229,21 @@ SensorManager::SensorManager()
 
     connect(mceWatcher_, SIGNAL(devicePSMStateChanged(const bool)),
             this, SLOT(devicePSMStateChanged(const bool)));
-
 #endif //SENSORFW_MCE_WATCHER
 }
 
 SensorManager::~SensorManager()
 {
+    // Everything below runs in this thread once delivery has stopped.
+    if (deliveryThread_) {
+        deliveryThread_->quit();
+        deliveryThread_->wait();
+    }
+
+    // The bridge reads the buffers of the adaptors deleted below.
+    delete streamBridge_;
+    streamBridge_ = 0;
+
     // stop adaptor threads and acquired resources
     for(QMap<QString, DeviceAdaptorInstanceEntry>::const_iterator it = deviceAdaptorInstanceMap_.begin(); it != deviceAdaptorInstanceMap_.end(); ++it)
     {
@@ -188,9 +292,9 @@ SensorManager::~SensorManager()
     }
 
     delete socketHandler_;
-    delete pipeNotifier_;
-    if (pipefds_[0]) close(pipefds_[0]);
-    if (pipefds_[1]) close(pipefds_[1]);
+    delete eventNotifier_;
+    delete deliveryThread_;
+    if (eventFd_ != -1) close(eventFd_);
 
 #ifdef SENSORFW_MCE_WATCHER
     delete mceWatcher_;
@@ -234,9 +338,109 @@ bool SensorManager::registerService()
         setError(SmCanNotRegisterService, error.message());
         return false;
     }
+
+    // The system bus is kept for discovery, calls may bypass it.
+    if (Config::configuration()->value<bool>("global/dbus_peer", false)) {
+        peerServer_ = new QDBusServer("unix:path=" + PEER_SOCKET_PATH, this);
+        if (!peerServer_->isConnected()) {
+            sensordLogW() << "Failed to listen on " << PEER_SOCKET_PATH << ": " << peerServer_->lastError().message();
+            delete peerServer_;
+            peerServer_ = 0;
+        } else {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
+            // Access is controlled by the socket permissions, as with the data socket.
+            peerServer_->setAnonymousAuthenticationAllowed(true);
+#endif
+            connect(peerServer_, SIGNAL(newConnection(QDBusConnection)), this, SLOT(peerConnected(QDBusConnection)));
+            if (chmod(PEER_SOCKET_PATH.toLocal8Bit().constData(), S_IRWXU|S_IRWXG|S_IRWXO) != 0)
+                sensordLogW() << "Error setting socket permissions! " << PEER_SOCKET_PATH;
+        }
+    }
     return true;
 }
 
+QString SensorManager::peerAddress() const
+{
+    return peerServer_ ? peerServer_->address() : QString();
+}
+
+void SensorManager::peerConnected(const QDBusConnection& connection)
+{
+    QDBusConnection peer(connection);
+    sensordLogD() << "New DBus peer connection " << peer.name();
+
+    peer.registerObject(OBJECT_PATH, this);
+    for (QMap<QString, SensorInstanceEntry>::const_iterator it = sensorInstanceMap_.begin(); it != sensorInstanceMap_.end(); ++it) {
+        if (it.value().sensor_)
+            peer.registerObject(OBJECT_PATH + "/" + it.value().sensor_->id(), it.value().sensor_);
+    }
+    peers();
+    peerConnections_.append(peer);
+}
+
+QList<QDBusConnection> SensorManager::peers()
+{
+    for (QList<QDBusConnection>::iterator it = peerConnections_.begin(); it != peerConnections_.end();) {
+        if (it->isConnected()) {
+            ++it;
+            continue;
+        }
+        QString name = it->name();
+        it = peerConnections_.erase(it);
+        QDBusConnection::disconnectFromPeer(name);
+    }
+    return peerConnections_;
+}
+
+QVariantMap SensorManager::sensorInfo(const QStringList& plugins)
+{
+    foreach (const QString& plugin, plugins)
+        loadPlugin(plugin);
+
+    QVariantMap sensors;
+    for (QMap<QString, SensorInstanceEntry>::iterator it = sensorInstanceMap_.begin(); it != sensorInstanceMap_.end(); ++it)
+    {
+        SensorInstanceEntry& entry = it.value();
+        QVariantMap info;
+        info.insert("type", entry.type_);
+
+        clearError();
+        bool instantiated = entry.sensor_ != NULL;
+        AbstractSensorChannel* sensor = instantiateSensor(it.key(), entry);
+        info.insert("valid", sensor != NULL);
+        if (!sensor)
+        {
+            info.insert("error", errorString());
+            sensors.insert(it.key(), info);
+            continue;
+        }
+        // Nobody holds a session on a sensor instantiated just to be
+        // described.
+        if (!instantiated)
+            markIdle(entry.idleSince_);
+
+        bool hwBuffering = false;
+        info.insert("description", sensor->description());
+        info.insert("running", sensor->running());
+        info.insert("sessions", entry.sessions_.size());
+        info.insert("interval", sensor->getInterval());
+        info.insert("intervals", QVariant::fromValue(sensor->getAvailableIntervals()));
+        info.insert("dataRanges", QVariant::fromValue(sensor->getAvailableDataRanges()));
+        info.insert("currentDataRange", QVariant::fromValue(sensor->getCurrentDataRange().range));
+        info.insert("bufferSizes", QVariant::fromValue(sensor->getAvailableBufferSizes(hwBuffering)));
+        info.insert("bufferIntervals", QVariant::fromValue(sensor->getAvailableBufferIntervals(hwBuffering)));
+        info.insert("hwBuffering", hwBuffering);
+        info.insert("bufferSize", sensor->bufferSize());
+        info.insert("bufferInterval", sensor->bufferInterval());
+        info.insert("standbyOverride", sensor->standbyOverride());
+        sensors.insert(it.key(), info);
+    }
+    clearError();
+
+    sensordLogD() << "Described " << sensors.size() << " sensors";
+    return sensors;
+}
+
 AbstractSensorChannel* SensorManager::addSensor(const QString& id)
 {
     sensordLogD() << "Adding sensor: " << id;
@@ -277,6 +481,8 @@ AbstractSensorChannel* SensorManager::addSensor(const QString& id)
         delete sensorChannel;
         return NULL;
     }
+    foreach (QDBusConnection peer, peers())
+        peer.registerObject(OBJECT_PATH + "/" + sensorChannel->id(), sensorChannel);
     return sensorChannel;
 }
 
@@ -286,6 +492,13 @@ void SensorManager::removeSensor(const QString& id)
 
     QMap<QString, SensorInstanceEntry>::iterator entryIt = sensorInstanceMap_.find(id);
     bus().unregisterObject(OBJECT_PATH + "/" + id);
+    foreach (QDBusConnection peer, peers())
+        peer.unregisterObject(OBJECT_PATH + "/" + id);
+    {
+        // Waits for a delivery round using the sensor to finish.
+        QMutexLocker locker(&deliveryMutex_);
+        deliveryChannels_.removeAll(entryIt.value().sensor_);
+    }
     delete entryIt.value().sensor_;
     entryIt.value().sensor_ = 0;
 }
@@ -304,6 +517,17 @@ bool SensorManager::loadPlugin(const QString& name)
     return result;
 }
 
+bool SensorManager::loadPlugins(const QStringList& names)
+{
+    sensordLogD() << "Preloading plugins: " << names;
+
+    if (Loader::instance().preloadPlugins(names) != names.size()) {
+        setError(SmCanNotRegisterObject, "failed to load all plugins");
+        return false;
+    }
+    return true;
+}
+
 int SensorManager::requestSensor(const QString& id)
 {
     sensordLogD() << "Requesting sensor: " << id;
@@ -312,6 +536,8 @@ int SensorManager::requestSensor(const QString& id)
 
     QString cleanId = getCleanId(id);
     QMap<QString, SensorInstanceEntry>::iterator entryIt = sensorInstanceMap_.find(cleanId);
+    if ( entryIt == sensorInstanceMap_.end() && Loader::instance().loadDeferredPlugin(cleanId) )
+        entryIt = sensorInstanceMap_.find(cleanId);
 
     if ( entryIt == sensorInstanceMap_.end() )
     {
@@ -319,22 +545,35 @@ int SensorManager::requestSensor(const QString& id)
         return INVALID_SESSION;
     }
 
+    startMceWatcher();
+
+    if (!instantiateSensor(id, entryIt.value()))
+        return INVALID_SESSION;
+
     int sessionId = createNewSessionId();
-    if(!entryIt.value().sensor_)
-    {
-        AbstractSensorChannel* sensor = addSensor(id);
-        if ( sensor == NULL )
-        {
-            setError(SmNotInstantiated, tr("sensor has not been instantiated"));
-            return INVALID_SESSION;
-        }
-        entryIt.value().sensor_ = sensor;
-    }
     entryIt.value().sessions_.insert(sessionId);
+    sessionSensorMap_.insert(sessionId, cleanId);
 
     return sessionId;
 }
 
+AbstractSensorChannel* SensorManager::instantiateSensor(const QString& id, SensorInstanceEntry& entry)
+{
+    if (entry.sensor_)
+        return entry.sensor_;
+
+    AbstractSensorChannel* sensor = addSensor(id);
+    if ( sensor == NULL )
+    {
+        setError(SmNotInstantiated, tr("sensor has not been instantiated"));
+        return NULL;
+    }
+    entry.sensor_ = sensor;
+    QMutexLocker locker(&deliveryMutex_);
+    deliveryChannels_.append(sensor);
+    return sensor;
+}
+
 bool SensorManager::releaseSensor(const QString& id, int sessionId)
 {
     sensordLogD() << "Releasing sensor '" << id << "' for session: " << sessionId;
@@ -356,7 +595,8 @@ bool SensorManager::releaseSensor(const QString& id, int sessionId)
     }
 
     /// Remove any property requests by this session
-    entryIt.value().sensor_->removeSession(sessionId);
+    if (entryIt.value().sensor_)
+        entryIt.value().sensor_->removeSession(sessionId);
 
     if (entryIt.value().sessions_.empty())
     {
@@ -368,12 +608,15 @@ bool SensorManager::releaseSensor(const QString& id, int sessionId)
 
     if(entryIt.value().sessions_.remove( sessionId ))
     {
+        sessionSensorMap_.remove(sessionId);
         /** Fix for NB#242237
         if ( entryIt.value().sessions_.empty() )
         {
             removeSensor(id);
         }
         */
+        if ( entryIt.value().sessions_.empty() )
+            markIdle(entryIt.value().idleSince_);
         returnValue = true;
     }
     else
@@ -387,6 +630,33 @@ bool SensorManager::releaseSensor(const QString& id, int sessionId)
     return returnValue;
 }
 
+bool SensorManager::openSession(const QString& id, int sessionId, const QVariantMap& config)
+{
+    sensordLogD() << "Opening session " << sessionId << " of sensor '" << id << "'";
+
+    clearError();
+
+    QMap<QString, SensorInstanceEntry>::iterator entryIt = sensorInstanceMap_.find(getCleanId(id));
+    if (entryIt == sensorInstanceMap_.end())
+    {
+        setError(SmIdNotRegistered, QString(tr("requested sensor id '%1' not registered")).arg(id));
+        return false;
+    }
+    if (!entryIt.value().sensor_ || !entryIt.value().sessions_.contains(sessionId))
+    {
+        setError(SmNotInstantiated, tr("invalid sessionId, no session to open"));
+        return false;
+    }
+
+    AbstractSensorChannelAdaptor* adaptor = entryIt.value().sensor_->findChild<AbstractSensorChannelAdaptor*>();
+    if (!adaptor)
+    {
+        setError(SmNotInstantiated, tr("sensor has no adaptor"));
+        return false;
+    }
+    return adaptor->openSession(sessionId, config);
+}
+
 AbstractChain* SensorManager::requestChain(const QString& id)
 {
     sensordLogD() << "Requesting chain: " << id;
@@ -394,6 +664,8 @@ AbstractChain* SensorManager::requestChain(const QString& id)
 
     AbstractChain* chain = NULL;
     QMap<QString, ChainInstanceEntry>::iterator entryIt = chainInstanceMap_.find(id);
+    if (entryIt == chainInstanceMap_.end() && Loader::instance().loadDeferredPlugin(id))
+        entryIt = chainInstanceMap_.find(id);
     if (entryIt != chainInstanceMap_.end())
     {
         if (entryIt.value().chain_ )
@@ -453,6 +725,8 @@ void SensorManager::releaseChain(const QString& id)
             else
             {
                 sensordLogD() << "Chain '" << id << "' ref count: " << entryIt.value().cnt_;
+                if (entryIt.value().cnt_ == 0)
+                    markIdle(entryIt.value().idleSince_);
             }
         }
         else
@@ -479,6 +753,8 @@ DeviceAdaptor* SensorManager::requestDeviceAdaptor(const QString& id)
 
     DeviceAdaptor* da = NULL;
     QMap<QString, DeviceAdaptorInstanceEntry>::iterator entryIt = deviceAdaptorInstanceMap_.find(id);
+    if ( entryIt == deviceAdaptorInstanceMap_.end() && Loader::instance().loadDeferredPlugin(id) )
+        entryIt = deviceAdaptorInstanceMap_.find(id);
     if ( entryIt != deviceAdaptorInstanceMap_.end() )
     {
         if ( entryIt.value().adaptor_ )
@@ -505,6 +781,8 @@ DeviceAdaptor* SensorManager::requestDeviceAdaptor(const QString& id)
                     entryIt.value().adaptor_ = da;
                     entryIt.value().cnt_++;
                     sensordLogD() << "Instantiated adaptor '" << id << "'. Valid = " << da->isValid();
+                    startFlightRecorder(id, da);
+                    startStream(id, da);
                 }
                 else
                 {
@@ -527,6 +805,25 @@ DeviceAdaptor* SensorManager::requestDeviceAdaptor(const QString& id)
     return da;
 }
 
+bool SensorManager::hasHardwareAdaptor(const QString& id)
+{
+    return Config::configuration()->exists(QString("plugins/%1").arg(id));
+}
+
+DeviceAdaptor* SensorManager::requestHardwareAdaptor(const QString& id)
+{
+    if (!hasHardwareAdaptor(id))
+        return NULL;
+
+    DeviceAdaptor* da = requestDeviceAdaptor(id);
+    if (da && !da->isValid()) {
+        sensordLogD() << "Adaptor '" << id << "' has no hardware, using software";
+        releaseDeviceAdaptor(id);
+        da = NULL;
+    }
+    return da;
+}
+
 void SensorManager::releaseDeviceAdaptor(const QString& id)
 {
     sensordLogD() << "Releasing adaptor: " << id;
@@ -557,6 +854,7 @@ void SensorManager::releaseDeviceAdaptor(const QString& id)
                 delete entryIt.value().adaptor_;
                 entryIt.value().adaptor_ = 0;
                 */
+                markIdle(entryIt.value().idleSince_);
             }
             else
             {
@@ -579,58 +877,96 @@ FilterBase* SensorManager::instantiateFilter(const QString& id)
     sensordLogD() << "Instantiating filter: " << id;
 
     QMap<QString, FilterFactoryMethod>::iterator it = filterFactoryMap_.find(id);
+    if(it == filterFactoryMap_.end() && Loader::instance().loadDeferredPlugin(id))
+        it = filterFactoryMap_.find(id);
     if(it == filterFactoryMap_.end())
     {
         sensordLogW() << "Filter " << id << " not found.";
         return NULL;
     }
-    return it.value()();
+    FilterBase* filter = it.value()();
+    if (filter)
+        filter->statistics().setName(id);
+    return filter;
 }
 
-bool SensorManager::write(int id, const void* source, int size)
+bool SensorManager::write(int id, const void* source, int size, const SessionFrameTrace* trace)
 {
-    void* buffer = malloc(size);
-    if(!buffer) {
-        sensordLogC() << "Malloc failed!";
-        return false;
+    if (embedded_) {
+        QMutexLocker locker(&localSessionMutex_);
+        LocalSession* session = localSessions_.value(id);
+        return session && session->write(source, size);
     }
-    PipeData pipeData;
-    pipeData.id = id;
-    pipeData.size = size;
-    pipeData.buffer = buffer;
+    return socketHandler_->write(id, source, size, trace);
+}
 
-    memcpy(buffer, source, size);
+void SensorManager::notifySamplesQueued()
+{
+    if (!samplesPending_.testAndSetOrdered(0, 1))
+        return;
 
-    if (::write(pipefds_[1], &pipeData, sizeof(pipeData)) < (int)sizeof(pipeData)) {
-        sensordLogW() << "Failed to write all data to pipe.";
-        return false;
+    if (eventfd_write(eventFd_, 1) == -1) {
+        sensordLogW() << "Failed to signal queued samples: " << strerror(errno);
+        samplesPending_.storeRelease(0);
     }
-    return true;
 }
 
 void SensorManager::sensorDataHandler(int)
 {
-    PipeData pipeData;
-    read(pipefds_[0], &pipeData, sizeof(pipeData));
+    eventfd_t value;
+    if (eventfd_read(eventFd_, &value) == -1 && errno != EAGAIN) {
+        sensordLogW() << "Failed to read eventfd: " << strerror(errno);
+    }
+
+    // Clear before draining so producers queueing meanwhile signal again.
+    samplesPending_.storeRelease(0);
 
-    if (!socketHandler_->write(pipeData.id, pipeData.buffer, pipeData.size)) {
-        sensordLogW() << "Failed to write data to socket.";
+    QMutexLocker locker(&deliveryMutex_);
+    socketHandler_->beginDelivery();
+    foreach (AbstractSensorChannel* sensor, deliveryChannels_) {
+        sensor->deliverQueuedSamples();
     }
 
-    free(pipeData.buffer);
+    // Write everything gathered during this round with one call per session.
+    socketHandler_->flushSessions();
+
+    if (embedded_) {
+        QMutexLocker sessionLocker(&localSessionMutex_);
+        foreach (LocalSession* session, localSessions_) {
+            session->flush();
+        }
+    }
+    locker.unlock();
+
+    // The CPU is awake now; catch up with deferred readers too.
+    DeferredWork::instance().runIfConvenient();
+}
+
+void SensorManager::reserveSessionBuffers()
+{
+    int count = 4;
+    unsigned int maxBytes = 16384;
+    if (Config::configuration()) {
+        count = Config::configuration()->value<int>("global/realtime_session_blocks", count);
+        maxBytes = Config::configuration()->value<unsigned int>("global/realtime_session_block_size", maxBytes);
+    }
+    socketHandler_->reserveSessionBlocks(count, maxBytes);
 }
 
 void SensorManager::lostClient(int sessionId)
 {
-    for(QMap<QString, SensorInstanceEntry>::iterator it = sensorInstanceMap_.begin(); it != sensorInstanceMap_.end(); ++it) {
-        if (it.value().sessions_.contains(sessionId)) {
-            sensordLogD() << "[SensorManager]: Lost session " << sessionId << " detected as " << it.key();
+    QHash<int, QString>::const_iterator session = sessionSensorMap_.constFind(sessionId);
+    if (session != sessionSensorMap_.constEnd()) {
+        QString id = session.value();
+        QMap<QString, SensorInstanceEntry>::iterator it = sensorInstanceMap_.find(id);
+        if (it != sensorInstanceMap_.end() && it.value().sessions_.contains(sessionId)) {
+            sensordLogD() << "[SensorManager]: Lost session " << sessionId << " detected as " << id;
 
             sensordLogD() << "[SensorManager]: Stopping sessionId " << sessionId;
             it.value().sensor_->stop(sessionId);
 
             sensordLogD() << "[SensorManager]: Releasing sessionId " << sessionId;
-            releaseSensor(it.key(), sessionId);
+            releaseSensor(id, sessionId);
             return;
         }
     }
@@ -644,7 +980,7 @@ void SensorManager::displayStateChanged(bool displayState)
         /// Emit signal to make background calibration resume from sleep
         emit displayOn();
 #ifdef SENSORFW_MCE_WATCHER
-        if (!mceWatcher_->PSMEnabled())
+        if (!mceWatcher_ || !mceWatcher_->PSMEnabled())
 #endif // SENSORFW_MCE_WATCHER
         {
             emit resumeCalibration();
@@ -652,6 +988,13 @@ void SensorManager::displayStateChanged(bool displayState)
 
     }
 
+    // Sessions still receiving samples with the display off have standby
+    // override. Deliver to them in bursts so the system can sleep between.
+    unsigned int burstInterval = 0;
+    if (!displayState && Config::configuration())
+        burstInterval = Config::configuration()->value<unsigned int>("global/display_off_batch_interval", 0);
+    socketHandler_->setBurstInterval(burstInterval);
+
     foreach (const DeviceAdaptorInstanceEntry& adaptor, deviceAdaptorInstanceMap_) {
         if (adaptor.adaptor_) {
             if (displayState) {
@@ -698,6 +1041,21 @@ void SensorManager::printStatus(QStringList& output) const
         str.append(QString(". %1\n").arg((it.value().sensor_ && it.value().sensor_->running()) ? "Running" : "Stopped"));
         output.append(str);
     }
+
+    if (NodeStatistics::isEnabled()) {
+        output.append("  Node statistics:\n");
+        foreach (const QString& line, NodeStatistics::report()) {
+            output.append(QString("    %1\n").arg(line));
+        }
+    }
+
+    QStringList boosts = CpuBoost::instance().report();
+    if (!boosts.isEmpty()) {
+        output.append("  CPU boost:\n");
+        foreach (const QString& line, boosts) {
+            output.append(QString("    %1\n").arg(line));
+        }
+    }
 }
 
 QString SensorManager::socketToPid(int id) const
@@ -771,11 +1129,412 @@ SocketHandler& SensorManager::socketHandler() const
     return *socketHandler_;
 }
 
+RingBufferBase* SensorManager::findNodeBuffer(const QString& id, const QString& buffer, unsigned int& interval)
+{
+    NodeBase* node = NULL;
+    RingBufferBase* found = NULL;
+
+    QMap<QString, DeviceAdaptorInstanceEntry>::const_iterator adaptorIt = deviceAdaptorInstanceMap_.constFind(id);
+    QMap<QString, ChainInstanceEntry>::const_iterator chainIt = chainInstanceMap_.constFind(id);
+    if (adaptorIt != deviceAdaptorInstanceMap_.constEnd() && adaptorIt.value().adaptor_) {
+        node = adaptorIt.value().adaptor_;
+        found = adaptorIt.value().adaptor_->findBuffer(buffer);
+    } else if (chainIt != chainInstanceMap_.constEnd() && chainIt.value().chain_) {
+        node = chainIt.value().chain_;
+        found = chainIt.value().chain_->findBuffer(buffer);
+    } else {
+        setError(SmNotInstantiated, QString(tr("adaptor or chain '%1' not instantiated").arg(id)));
+        return NULL;
+    }
+
+    if (!found) {
+        setError(SmIdNotRegistered, QString(tr("'%1' has no buffer '%2'").arg(id).arg(buffer)));
+        return NULL;
+    }
+    interval = node->interval() * 1000;
+    return found;
+}
+
+bool SensorManager::startRecording(const QString& id, const QString& buffer, const QString& name)
+{
+    clearError();
+
+    // Recordings are written by sensord, do not let the caller pick
+    // an arbitrary location.
+    if (name.isEmpty() || name.contains('/') || name.startsWith('.')) {
+        sensordLogW() << "Invalid recording name: " << name;
+        return false;
+    }
+    QString directory = Config::configuration()->value<QString>("global/recording_dir", "/var/lib/sensord/recordings");
+    if (directory.isEmpty() || !QDir().mkpath(directory)) {
+        sensordLogW() << "Recording directory " << directory << " not available";
+        return false;
+    }
+
+    unsigned int interval = 0;
+    RingBufferBase* found = findNodeBuffer(id, buffer, interval);
+    if (!found)
+        return false;
+
+    QString path = directory + "/" + name;
+    if (!found->startRecording(path, interval))
+        return false;
+    sensordLogD() << "Recording " << id << "/" << buffer << " into " << path;
+    return true;
+}
+
+bool SensorManager::stopRecording(const QString& id, const QString& buffer)
+{
+    clearError();
+
+    unsigned int interval = 0;
+    RingBufferBase* found = findNodeBuffer(id, buffer, interval);
+    if (!found)
+        return false;
+
+    found->stopRecording();
+    sensordLogD() << "Stopped recording " << id << "/" << buffer;
+    return true;
+}
+
+/**
+ * Fastest interval an adaptor offers.
+ *
+ * @param adaptor adaptor.
+ * @return interval in milliseconds, 0 if unknown.
+ */
+static unsigned int fastestInterval(DeviceAdaptor* adaptor)
+{
+    unsigned int fastest = 0;
+    foreach (const DataRange& range, adaptor->getAvailableIntervals()) {
+        if (range.min > 0 && (!fastest || range.min < fastest))
+            fastest = (unsigned int)range.min;
+    }
+    return fastest;
+}
+
+void SensorManager::startFlightRecorder(const QString& id, DeviceAdaptor* adaptor)
+{
+    QString directory = Config::configuration()->value<QString>("global/flight_recorder_dir", "");
+    AdaptedSensorEntry* sensor = adaptor->sensor().second;
+    if (directory.isEmpty() || !sensor || !sensor->buffer())
+        return;
+    if (!QDir().mkpath(directory)) {
+        sensordLogW() << "Flight recorder directory " << directory << " not available";
+        return;
+    }
+
+    unsigned int fastest = fastestInterval(adaptor);
+    unsigned int seconds = Config::configuration()->value<unsigned int>("global/flight_recorder_seconds", 10);
+    unsigned int capacity = seconds * 1000 / (fastest ? fastest : 10);
+    capacity = qBound(64u, capacity, 65536u);
+
+    QString path = directory + "/" + id + "-" + sensor->name();
+    if (sensor->buffer()->startFlightRecorder(path, capacity, fastest * 1000))
+        sensordLogD() << "Flight recorder of " << id << " in " << path;
+}
+
+void SensorManager::startStream(const QString& id, DeviceAdaptor* adaptor)
+{
+    AdaptedSensorEntry* sensor = adaptor->sensor().second;
+    if (!streamBridge_ || !streamBridge_->isSelected(id) || !sensor || !sensor->buffer())
+        return;
+
+    unsigned int interval = fastestInterval(adaptor) * 1000;
+    StreamTap* tap = sensor->buffer()->startStreamTap(streamBridge_->tapCapacity(interval), interval);
+    if (!tap) {
+        sensordLogW() << "Adaptor " << id << " cannot be streamed";
+        return;
+    }
+    streamBridge_->addStream(id + "/" + sensor->name(), tap);
+    sensordLogD() << "Streaming " << id << "/" << sensor->name();
+}
+
+void SensorManager::stopStream(DeviceAdaptor* adaptor)
+{
+    AdaptedSensorEntry* sensor = adaptor->sensor().second;
+    if (streamBridge_ && sensor && sensor->buffer() && sensor->buffer()->streamTap())
+        streamBridge_->removeStream(sensor->buffer()->streamTap());
+}
+
+QStringList SensorManager::sessionStatistics() const
+{
+    // Lines start with "session <id>:", prefix them with the sensor.
+    QStringList lines = socketHandler_->sessionStatistics();
+    for (int i = 0; i < lines.size(); ++i) {
+        int sessionId = lines.at(i).mid(8, lines.at(i).indexOf(':') - 8).toInt();
+        QHash<int, QString>::const_iterator sensor = sessionSensorMap_.constFind(sessionId);
+        if (sensor != sessionSensorMap_.constEnd())
+            lines[i].prepend(sensor.value() + "/");
+    }
+    return lines;
+}
+
+QStringList SensorManager::streamStatistics() const
+{
+    return streamBridge_ ? streamBridge_->report() : QStringList();
+}
+
+QStringList SensorManager::dumpFlightRecorders()
+{
+    QStringList written;
+    QString directory = Config::configuration()->value<QString>("global/recording_dir", "/var/lib/sensord/recordings");
+    if (directory.isEmpty() || !QDir().mkpath(directory)) {
+        sensordLogW() << "Recording directory " << directory << " not available";
+        return written;
+    }
+    QString prefix = directory + "/flight-" + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + "-";
+
+    for (QMap<QString, DeviceAdaptorInstanceEntry>::const_iterator it = deviceAdaptorInstanceMap_.constBegin(); it != deviceAdaptorInstanceMap_.constEnd(); ++it) {
+        if (!it.value().adaptor_ || !it.value().adaptor_->sensor().second)
+            continue;
+        const FlightRecorder* flight = it.value().adaptor_->sensor().second->buffer()->flightRecorder();
+        if (!flight)
+            continue;
+        QString path = prefix + QFileInfo(flight->path()).fileName();
+        int count = flight->dump(path);
+        if (count >= 0) {
+            sensordLogD() << "Dumped " << count << " samples of " << it.key() << " into " << path;
+            written << path;
+        }
+    }
+
+    QString flightDirectory = Config::configuration()->value<QString>("global/flight_recorder_dir", "");
+    if (!flightDirectory.isEmpty()) {
+        foreach (const QFileInfo& info, QDir(flightDirectory).entryInfoList(QStringList() << "*.prev", QDir::Files)) {
+            QString path = prefix + info.fileName();
+            if (FlightRecorder::dumpFile(info.filePath(), path) >= 0)
+                written << path;
+        }
+    }
+
+    QFile statistics(prefix + "statistics");
+    if (statistics.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        foreach (const QString& line, NodeStatistics::report())
+            statistics.write(line.toLocal8Bit() + "\n");
+        written << statistics.fileName();
+    }
+    return written;
+}
+
 QList<QString> SensorManager::getAdaptorTypes() const
 {
     return deviceAdaptorInstanceMap_.keys();
 }
 
+QList<QString> SensorManager::getSensorTypes() const
+{
+    return sensorInstanceMap_.keys();
+}
+
+QList<QString> SensorManager::getChainTypes() const
+{
+    return chainInstanceMap_.keys();
+}
+
+int SensorManager::getInstanceCount() const
+{
+    int count = 0;
+    foreach (const SensorInstanceEntry& entry, sensorInstanceMap_)
+        count += entry.sensor_ ? 1 : 0;
+    foreach (const ChainInstanceEntry& entry, chainInstanceMap_)
+        count += entry.chain_ ? 1 : 0;
+    foreach (const DeviceAdaptorInstanceEntry& entry, deviceAdaptorInstanceMap_)
+        count += entry.adaptor_ ? 1 : 0;
+    return count;
+}
+
+bool SensorManager::reloadConfiguration()
+{
+    Config* config = Config::configuration();
+    if (!config)
+        return false;
+
+    QStringList changed;
+    bool ok = config->reload(&changed);
+    if (!ok)
+        sensordLogW() << "Some configuration files failed to load";
+    sensordLogD() << "Configuration reloaded, changed keys: " << changed;
+    if (changed.isEmpty())
+        return ok;
+
+    idleConfigRead_ = false;
+    foreach (const SensorInstanceEntry& entry, sensorInstanceMap_)
+    {
+        if (entry.sensor_)
+            entry.sensor_->configurationChanged(changed);
+    }
+    foreach (const ChainInstanceEntry& entry, chainInstanceMap_)
+    {
+        if (entry.chain_)
+            entry.chain_->configurationChanged(changed);
+    }
+    foreach (const DeviceAdaptorInstanceEntry& entry, deviceAdaptorInstanceMap_)
+    {
+        if (entry.adaptor_)
+            entry.adaptor_->configurationChanged(changed);
+    }
+    return ok;
+}
+
+QList<QString> SensorManager::getFilterTypes() const
+{
+    return filterFactoryMap_.keys();
+}
+
+bool SensorManager::isInstantiated(const QString& id) const
+{
+    QMap<QString, SensorInstanceEntry>::const_iterator sensorIt = sensorInstanceMap_.find(id);
+    if (sensorIt != sensorInstanceMap_.end() && sensorIt.value().sensor_)
+        return true;
+    QMap<QString, ChainInstanceEntry>::const_iterator chainIt = chainInstanceMap_.find(id);
+    if (chainIt != chainInstanceMap_.end() && chainIt.value().chain_)
+        return true;
+    QMap<QString, DeviceAdaptorInstanceEntry>::const_iterator adaptorIt = deviceAdaptorInstanceMap_.find(id);
+    return adaptorIt != deviceAdaptorInstanceMap_.end() && adaptorIt.value().adaptor_;
+}
+
+void SensorManager::unregister(const QString& id)
+{
+    if (isInstantiated(id))
+    {
+        sensordLogW() << "Not unregistering instantiated " << id;
+        return;
+    }
+
+    // Factories point into the plugin, so they go with the last ID of their type.
+    if (sensorInstanceMap_.contains(id) && sensorInstanceMap_[id].sessions_.isEmpty())
+    {
+        QString type = sensorInstanceMap_.take(id).type_;
+        bool used = false;
+        foreach (const SensorInstanceEntry& entry, sensorInstanceMap_)
+            used = used || entry.type_ == type;
+        if (!used)
+            sensorFactoryMap_.remove(type);
+    }
+    if (chainInstanceMap_.contains(id) && chainInstanceMap_[id].cnt_ == 0)
+    {
+        QString type = chainInstanceMap_.take(id).type_;
+        bool used = false;
+        foreach (const ChainInstanceEntry& entry, chainInstanceMap_)
+            used = used || entry.type_ == type;
+        if (!used)
+            chainFactoryMap_.remove(type);
+    }
+    if (deviceAdaptorInstanceMap_.contains(id) && deviceAdaptorInstanceMap_[id].cnt_ == 0)
+    {
+        QString type = deviceAdaptorInstanceMap_.take(id).type_;
+        bool used = false;
+        foreach (const DeviceAdaptorInstanceEntry& entry, deviceAdaptorInstanceMap_)
+            used = used || entry.type_ == type;
+        if (!used)
+            deviceAdaptorFactoryMap_.remove(type);
+    }
+    filterFactoryMap_.remove(id);
+}
+
+void SensorManager::markIdle(quint64& idleSince)
+{
+    // SensorManager is created before the configuration is loaded.
+    if (!idleConfigRead_ && Config::configuration())
+    {
+        idleUnloadDelay_ = (quint64)Config::configuration()->value<unsigned int>("global/idle_unload_delay", 0) * 1000000;
+        idleUnloadPlugins_ = Config::configuration()->value<bool>("global/idle_unload_plugins", false);
+        idleConfigRead_ = true;
+    }
+
+    idleSince = Utils::getCoarseTimeStamp();
+    if (idleUnloadDelay_ && !idleTimer_.isActive())
+        idleTimer_.start(idleUnloadDelay_ / 1000);
+}
+
+bool SensorManager::reapIdleOnce(quint64 now, quint64 passStart)
+{
+    bool reaped = false;
+
+    for (QMap<QString, SensorInstanceEntry>::iterator it = sensorInstanceMap_.begin(); it != sensorInstanceMap_.end(); ++it)
+    {
+        SensorInstanceEntry& entry = it.value();
+        if (entry.sensor_ && entry.sessions_.isEmpty() &&
+            (now - entry.idleSince_ >= idleUnloadDelay_ || entry.idleSince_ >= passStart))
+        {
+            sensordLogD() << "Sensor '" << it.key() << "' idle, deleting it.";
+            removeSensor(it.key());
+            reaped = true;
+        }
+    }
+
+    for (QMap<QString, ChainInstanceEntry>::iterator it = chainInstanceMap_.begin(); it != chainInstanceMap_.end(); ++it)
+    {
+        ChainInstanceEntry& entry = it.value();
+        if (entry.chain_ && entry.cnt_ == 0 &&
+            (now - entry.idleSince_ >= idleUnloadDelay_ || entry.idleSince_ >= passStart))
+        {
+            sensordLogD() << "Chain '" << it.key() << "' idle, deleting it.";
+            AbstractChain* chain = entry.chain_;
+            entry.chain_ = 0;
+            delete chain;
+            reaped = true;
+        }
+    }
+
+    for (QMap<QString, DeviceAdaptorInstanceEntry>::iterator it = deviceAdaptorInstanceMap_.begin(); it != deviceAdaptorInstanceMap_.end(); ++it)
+    {
+        DeviceAdaptorInstanceEntry& entry = it.value();
+        if (entry.adaptor_ && entry.cnt_ == 0 &&
+            (now - entry.idleSince_ >= idleUnloadDelay_ || entry.idleSince_ >= passStart))
+        {
+            sensordLogD() << "Adaptor '" << it.key() << "' idle, deleting it.";
+            DeviceAdaptor* adaptor = entry.adaptor_;
+            entry.adaptor_ = 0;
+            stopStream(adaptor);
+            delete adaptor;
+            reaped = true;
+        }
+    }
+    return reaped;
+}
+
+void SensorManager::reapIdle()
+{
+    if (!idleUnloadDelay_)
+        return;
+
+    // Deleting a sensor releases its chains and adaptors, which are then
+    // deleted in the same go instead of after another grace period.
+    quint64 passStart = Utils::getCoarseTimeStamp();
+    bool reaped = false;
+    while (reapIdleOnce(Utils::getCoarseTimeStamp(), passStart))
+        reaped = true;
+
+    if (reaped && idleUnloadPlugins_)
+        Loader::instance().unloadIdlePlugins();
+
+    // Wait for the next instance to expire.
+    quint64 now = Utils::getCoarseTimeStamp();
+    quint64 next = 0;
+    foreach (const SensorInstanceEntry& entry, sensorInstanceMap_)
+    {
+        if (entry.sensor_ && entry.sessions_.isEmpty() && (!next || entry.idleSince_ < next))
+            next = entry.idleSince_;
+    }
+    foreach (const ChainInstanceEntry& entry, chainInstanceMap_)
+    {
+        if (entry.chain_ && entry.cnt_ == 0 && (!next || entry.idleSince_ < next))
+            next = entry.idleSince_;
+    }
+    foreach (const DeviceAdaptorInstanceEntry& entry, deviceAdaptorInstanceMap_)
+    {
+        if (entry.adaptor_ && entry.cnt_ == 0 && (!next || entry.idleSince_ < next))
+            next = entry.idleSince_;
+    }
+    if (next)
+    {
+        quint64 elapsed = now - next;
+        idleTimer_.start(elapsed < idleUnloadDelay_ ? (idleUnloadDelay_ - elapsed) / 1000 + 1 : 0);
+    }
+}
+
 int SensorManager::getAdaptorCount(const QString& type) const
 {
     QMap<QString, DeviceAdaptorInstanceEntry>::const_iterator it = deviceAdaptorInstanceMap_.find(type);
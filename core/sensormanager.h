@@ -30,6 +30,11 @@
 #ifndef SENSORMANAGER_H
 #define SENSORMANAGER_H
 
+#include <QVariantMap>
+#include <QTimer>
+#include <QHash>
+#include <QMutex>
+#include <QDBusConnection>
 #include "abstractsensor.h"
 #include "abstractchain.h"
 #include "deviceadaptor.h"
@@ -45,8 +50,13 @@
 class MceWatcher;
 #endif
 
+class QDBusServer;
 class QSocketNotifier;
+class QThread;
 class SocketHandler;
+class StreamBridge;
+class LocalSession;
+struct SessionFrameTrace;
 
 /**
  * Sensor instance entry. Contains list of connected sessions.
@@ -69,6 +79,7 @@ public:
     QSet<int>               sessions_; /**< connected sessions. */
     AbstractSensorChannel*  sensor_;   /**< sensor channel */
     QString                 type_;     /**< type */
+    quint64                 idleSince_; /**< when last session was released */
 };
 
 /**
@@ -92,6 +103,7 @@ public:
     int                     cnt_;   /**< Reference count */
     AbstractChain*          chain_; /**< Chain pointer  */
     QString                 type_;  /**< Type */
+    quint64                 idleSince_; /**< when last reference was released */
 };
 
 /**
@@ -117,6 +129,7 @@ public:
     DeviceAdaptor*          adaptor_;     /**< Adaptor pointer */
     int                     cnt_;         /**< Reference count */
     QString                 type_;        /**< Type */
+    quint64                 idleSince_;   /**< when last reference was released */
 };
 
 /**
@@ -132,6 +145,15 @@ class SensorManager : public QObject
     Q_PROPERTY(QString errorString READ errorString)
 
 public:
+    /**
+     * Fill the pool of session buffers with resident blocks, so that
+     * sessions set up later do not allocate or fault on the sample
+     * path. Block count and size are read from
+     * <tt>global/realtime_session_blocks</tt> and
+     * <tt>global/realtime_session_block_size</tt>.
+     */
+    void reserveSessionBuffers();
+
     /**
      * Append current status into given StringList.
      *
@@ -167,6 +189,32 @@ public:
      */
     static SensorManager& instance();
 
+    /**
+     * Run embedded into an application instead of as the daemon. The
+     * session sockets are not created and samples are written to the
+     * local sessions, see #setLocalSession(). Must be called before
+     * the first #instance() call.
+     *
+     * @param value run embedded.
+     */
+    static void setEmbedded(bool value);
+
+    /**
+     * Is sensor manager embedded into an application.
+     *
+     * @return is embedded.
+     */
+    static bool embedded();
+
+    /**
+     * Deliver samples of a session to an in-process receiver instead
+     * of a socket. Only used when embedded.
+     *
+     * @param sessionId session ID.
+     * @param session receiver, or NULL to remove it. Not owned.
+     */
+    void setLocalSession(int sessionId, LocalSession* session);
+
     /**
      * Register DBus service.
      *
@@ -174,6 +222,15 @@ public:
      */
     bool registerService();
 
+    /**
+     * Address of the peer-to-peer DBus server. Clients connecting there
+     * find the same objects as on the system bus, without the bus
+     * daemon relaying every call.
+     *
+     * @return server address, empty if not listening.
+     */
+    QString peerAddress() const;
+
     /**
      * Register given sensor type.
      *
@@ -222,6 +279,27 @@ public:
      */
     DeviceAdaptor* requestDeviceAdaptor(const QString& id);
 
+    /**
+     * Request adaptor for a hardware computed sensor, such as the step
+     * counter or rotation vector of a sensor hub. The adaptor is only
+     * used when the device configuration maps it in <tt>[plugins]</tt>
+     * and it is valid, otherwise the caller falls back to computing
+     * the same output in software. Release with #releaseDeviceAdaptor().
+     *
+     * @param id adaptor ID.
+     * @return adaptor, or NULL when there is no hardware for it.
+     */
+    DeviceAdaptor* requestHardwareAdaptor(const QString& id);
+
+    /**
+     * Is a hardware adaptor mapped in <tt>[plugins]</tt>. Plugins list
+     * such adaptors in their dependencies only when this holds.
+     *
+     * @param id adaptor ID.
+     * @return is adaptor configured.
+     */
+    static bool hasHardwareAdaptor(const QString& id);
+
     /**
      * Release adaptor.
      *
@@ -256,13 +334,23 @@ public:
 #endif
 
     /**
-     * Write sensor data for given session.
+     * Write sensor data for given session. Must be called from the
+     * main thread. Sensor channels running in adaptor threads queue
+     * their samples and call #notifySamplesQueued() instead.
      *
      * @param id Session ID.
      * @param source Source from where to write.
      * @param size How many bytes to write.
+     * @param trace stage timestamps of the sample, if tracing.
+     */
+    bool write(int id, const void* source, int size, const SessionFrameTrace* trace = NULL);
+
+    /**
+     * Wake up the main thread to deliver queued sensor samples. Safe to
+     * call from any thread. Only the first call after the previous
+     * delivery round costs a syscall.
      */
-    bool write(int id, const void* source, int size);
+    void notifySamplesQueued();
 
     /**
      * Load plugin.
@@ -272,6 +360,14 @@ public:
      */
     bool loadPlugin(const QString& name);
 
+    /**
+     * Load plugins, loading their files concurrently.
+     *
+     * @param names plugin names.
+     * @return were all plugins loaded succesfully.
+     */
+    bool loadPlugins(const QStringList& names);
+
     /**
      * Request sensor.
      *
@@ -288,6 +384,59 @@ public:
      */
     bool releaseSensor(const QString& id, int sessionId);
 
+    /**
+     * Configure and start a requested session in one call, see
+     * AbstractSensorChannelAdaptor::openSession(). The data connection
+     * of the session should be established first, so that the socket
+     * side settings are applied too.
+     *
+     * @param id Sensor ID.
+     * @param sessionId Session ID.
+     * @param config session configuration.
+     * @return was every setting applied.
+     */
+    bool openSession(const QString& id, int sessionId, const QVariantMap& config);
+
+    /**
+     * Describe every registered sensor in one reply, instead of a
+     * loadPlugin() per sensor and a call per property. Sensors not
+     * instantiated yet are instantiated without a session and are then
+     * idle like released ones.
+     *
+     * Each sensor is described by a map with \c type, \c valid and,
+     * for valid sensors, \c description, \c running, \c sessions,
+     * \c interval, \c intervals, \c dataRanges, \c currentDataRange,
+     * \c bufferSizes, \c bufferIntervals, \c hwBuffering,
+     * \c bufferSize, \c bufferInterval and \c standbyOverride; for
+     * invalid ones \c error.
+     *
+     * @param plugins plugins to load first, failures are ignored.
+     * @return sensor descriptions by sensor ID.
+     */
+    QVariantMap sensorInfo(const QStringList& plugins);
+
+    /**
+     * Start recording a buffer of an adaptor or a chain into a file
+     * (see SampleRecorder). Recordings are written into the directory
+     * configured with <tt>global/recording_dir</tt>.
+     *
+     * @param id adaptor or chain ID.
+     * @param buffer buffer name, for adaptors the adapted sensor name.
+     * @param name file name in the recording directory. An existing
+     *             recording of the same type is appended to.
+     * @return was recording started.
+     */
+    bool startRecording(const QString& id, const QString& buffer, const QString& name);
+
+    /**
+     * Stop recording a buffer.
+     *
+     * @param id adaptor or chain ID.
+     * @param buffer buffer name.
+     * @return was buffer found.
+     */
+    bool stopRecording(const QString& id, const QString& buffer);
+
     /**
      * Get sensor instance.
      *
@@ -308,6 +457,42 @@ public:
      */
     QList<QString> getAdaptorTypes() const;
 
+    /**
+     * Get list of registered sensor IDs.
+     */
+    QList<QString> getSensorTypes() const;
+
+    /**
+     * Get list of registered chain IDs.
+     */
+    QList<QString> getChainTypes() const;
+
+    /**
+     * Get number of instantiated sensors, chains and adaptors.
+     */
+    int getInstanceCount() const;
+
+    /**
+     * Get list of registered filter IDs.
+     */
+    QList<QString> getFilterTypes() const;
+
+    /**
+     * Is sensor, chain or adaptor with given ID instantiated.
+     *
+     * @param id sensor, chain or adaptor ID.
+     * @return is there an instance.
+     */
+    bool isInstantiated(const QString& id) const;
+
+    /**
+     * Forget registration of given ID, so that the plugin registering
+     * it can be unloaded. Instantiated IDs are left as they are.
+     *
+     * @param id sensor, chain, adaptor or filter ID.
+     */
+    void unregister(const QString& id);
+
     /**
      * Get list configured of adaptor types.
      */
@@ -317,7 +502,7 @@ public:
     /**
      * Get pointer to MceWatcher instance.
      *
-     * @return MceWatcher instance pointer.
+     * @return MceWatcher instance pointer, NULL until a sensor is requested.
      */
     MceWatcher* MCEWatcher() const;
 #endif
@@ -345,11 +530,59 @@ private Q_SLOTS:
     void devicePSMStateChanged(bool deviceMode);
 
     /**
-     * Callback for arrived sensor data in internal pipe which SensorManager
-     * needs to propagate to the SocketHandler.
+     * Callback for wake-up from sensor channels which have queued data
+     * SensorManager needs to propagate to the SocketHandler.
      */
     void sensorDataHandler(int);
 
+    /**
+     * Delete sensors, chains and adaptors which have not been used for
+     * the configured grace period and, if configured, unload plugins
+     * which have nothing instantiated.
+     */
+    void reapIdle();
+
+    /**
+     * Export objects to a new peer-to-peer DBus connection.
+     *
+     * @param connection new connection.
+     */
+    void peerConnected(const QDBusConnection& connection);
+
+public Q_SLOTS:
+    /**
+     * Reload configuration files and notify instantiated sensors, chains
+     * and adaptors of the changed keys.
+     *
+     * @return were all configuration files loaded.
+     */
+    bool reloadConfiguration();
+
+    /**
+     * Write the samples kept by the flight recorders of instantiated
+     * adaptors, and those left behind by the previous run of sensord,
+     * into sample recordings in <tt>global/recording_dir</tt>. Node
+     * statistics are written alongside. Called on SIGUSR2 too.
+     *
+     * @return written files.
+     */
+    QStringList dumpFlightRecorders();
+
+    /**
+     * Counters of all sessions, named by their sensor. For more details
+     * see #SessionData::statistics().
+     *
+     * @return one line per session.
+     */
+    QStringList sessionStatistics() const;
+
+    /**
+     * Counters of the stream bridge.
+     *
+     * @return report lines, empty if the bridge is disabled.
+     */
+    QStringList streamStatistics() const;
+
 Q_SIGNALS:
     /**
      * Signal for occured errors.
@@ -434,8 +667,86 @@ private:
      */
     QString socketToPid(const QSet<int>& ids) const;
 
+    /**
+     * Find buffer of an instantiated adaptor or chain.
+     *
+     * @param id adaptor or chain ID.
+     * @param buffer buffer name.
+     * @param interval set to the interval of the node in microseconds.
+     * @return buffer or NULL if not found.
+     */
+    RingBufferBase* findNodeBuffer(const QString& id, const QString& buffer, unsigned int& interval);
+
+    /**
+     * Start the flight recorder of a newly instantiated adaptor, if
+     * <tt>global/flight_recorder_dir</tt> is set. The recorder keeps
+     * <tt>global/flight_recorder_seconds</tt> of samples at the fastest
+     * interval of the adaptor.
+     *
+     * @param id adaptor ID.
+     * @param adaptor adaptor.
+     */
+    void startFlightRecorder(const QString& id, DeviceAdaptor* adaptor);
+
+    /**
+     * Stream a newly instantiated adaptor through the stream bridge, if
+     * it is listed in <tt>bridge/adaptors</tt>.
+     *
+     * @param id adaptor ID.
+     * @param adaptor adaptor.
+     */
+    void startStream(const QString& id, DeviceAdaptor* adaptor);
+
+    /**
+     * Stop streaming an adaptor before it is deleted.
+     *
+     * @param adaptor adaptor.
+     */
+    void stopStream(DeviceAdaptor* adaptor);
+
+    /**
+     * Start following display and power save state from MCE, unless
+     * already done. Deferred until the first sensor is requested.
+     */
+    void startMceWatcher();
+
+    /**
+     * Note that an instance lost its last user and schedule reaping.
+     *
+     * @param idleSince idle timestamp of the instance entry.
+     */
+    void markIdle(quint64& idleSince);
+
+    /**
+     * Instantiate the channel of a registered sensor if it is not yet.
+     *
+     * @param id sensor ID, may include parameters.
+     * @param entry instance entry of the sensor.
+     * @return sensor channel, NULL if it could not be instantiated.
+     */
+    AbstractSensorChannel* instantiateSensor(const QString& id, SensorInstanceEntry& entry);
+
+    /**
+     * Delete expired idle instances once.
+     *
+     * @param now current time in microseconds.
+     * @param passStart start of the reaping pass. Instances released
+     *                  by the pass are deleted without waiting.
+     * @return was anything deleted.
+     */
+    bool reapIdleOnce(quint64 now, quint64 passStart);
+
+    /**
+     * Peer-to-peer DBus connections still connected. Closed ones are
+     * dropped.
+     *
+     * @return connected peers.
+     */
+    QList<QDBusConnection> peers();
+
     QMap<QString, SensorChannelFactoryMethod>      sensorFactoryMap_; /**< factories for sensor types */
     QMap<QString, SensorInstanceEntry>             sensorInstanceMap_; /**< sensor instances */
+    QHash<int, QString>                            sessionSensorMap_; /**< sensor ID of each session */
 
     QMap<QString, DeviceAdaptorFactoryMethod>      deviceAdaptorFactoryMap_; /**< factories for adaptor types. */
     QMap<QString, DeviceAdaptorInstanceEntry>      deviceAdaptorInstanceMap_; /**< adaptor instances */
@@ -449,11 +760,25 @@ private:
     MceWatcher*                                    mceWatcher_; /**< MCE watcher */
     SensorManagerError                             errorCode_; /** global error code */
     QString                                        errorString_; /** global error description */
-    int                                            pipefds_[2]; /** pipe for sensor samples */
-    QSocketNotifier*                               pipeNotifier_; /** notifier for pipe stream */
+    int                                            eventFd_; /** eventfd for queued sensor samples */
+    QAtomicInt                                     samplesPending_; /** is wake-up already signalled */
+    QSocketNotifier*                               eventNotifier_; /** notifier for eventfd */
+    QTimer                                         idleTimer_; /** timer for reaping idle instances */
+    quint64                                        idleUnloadDelay_; /** grace period in microseconds, 0 if disabled */
+    bool                                           idleUnloadPlugins_; /** unload plugins of reaped instances */
+    bool                                           idleConfigRead_; /** have idle settings been read */
+    QList<AbstractSensorChannel*>                  deliveryChannels_; /** instantiated channels, in delivery order */
+    QMutex                                         deliveryMutex_; /** held for a delivery round, protects deliveryChannels_ */
+    QThread*                                       deliveryThread_; /** thread delivering samples, NULL if main thread */
+    StreamBridge*                                  streamBridge_; /** bridge to a collector, NULL if disabled */
+    QDBusServer*                                   peerServer_; /** peer-to-peer DBus server, NULL if not listening */
+    QList<QDBusConnection>                         peerConnections_; /** connections accepted by peerServer_ */
+    QHash<int, LocalSession*>                      localSessions_; /** in-process sessions when embedded */
+    QMutex                                         localSessionMutex_; /** protects localSessions_ */
 
     static SensorManager*                          instance_; /** singleton */
     static int                                     sessionIdCount_; /** session ID counter */
+    static bool                                    embedded_; /** is embedded into an application */
 };
 
 template<class SENSOR_TYPE>
@@ -29,6 +29,8 @@
 
 #include "sensormanager_a.h"
 #include "logging.h"
+#include "nodestatistics.h"
+#include "cpuboost.h"
 
 /*
  * Implementation of adaptor class SensorManagerAdaptor
@@ -67,7 +69,56 @@ bool SensorManagerAdaptor::releaseSensor(const QString &id, int sessionId, qint6
     return sensorManager()->releaseSensor(id, sessionId);
 }
 
+bool SensorManagerAdaptor::openSession(const QString &id, int sessionId, const QVariantMap& config, qint64 pid)
+{
+    sensordLog() << "Sensor '" << id << "' session " << sessionId << " opened with " << config.keys().join(",") << ". Client PID: " << pid;
+    return sensorManager()->openSession(id, sessionId, config);
+}
+
+QVariantMap SensorManagerAdaptor::sensorInfo(const QStringList& plugins, qint64 pid)
+{
+    sensordLog() << "Sensor information requested with plugins " << plugins.join(",") << ". Client PID: " << pid;
+    return sensorManager()->sensorInfo(plugins);
+}
+
+QStringList SensorManagerAdaptor::nodeStatistics()
+{
+    return NodeStatistics::report() + sensorManager()->sessionStatistics() + sensorManager()->streamStatistics() + CpuBoost::instance().report();
+}
+
+void SensorManagerAdaptor::setNodeStatisticsEnabled(bool enabled)
+{
+    sensordLogD() << "Node statistics " << (enabled ? "enabled" : "disabled");
+    NodeStatistics::setEnabled(enabled);
+}
+
+bool SensorManagerAdaptor::startRecording(const QString& id, const QString& buffer, const QString& name)
+{
+    return sensorManager()->startRecording(id, buffer, name);
+}
+
+bool SensorManagerAdaptor::stopRecording(const QString& id, const QString& buffer)
+{
+    return sensorManager()->stopRecording(id, buffer);
+}
+
+QStringList SensorManagerAdaptor::dumpFlightRecorders()
+{
+    return sensorManager()->dumpFlightRecorders();
+}
+
+bool SensorManagerAdaptor::reloadConfiguration()
+{
+    sensordLog() << "Configuration reload requested";
+    return sensorManager()->reloadConfiguration();
+}
+
+QString SensorManagerAdaptor::peerAddress()
+{
+    return sensorManager()->peerAddress();
+}
+
 SensorManager* SensorManagerAdaptor::sensorManager() const
 {
-    return dynamic_cast<SensorManager*>(parent());
+    return qobject_cast<SensorManager*>(parent());
 }
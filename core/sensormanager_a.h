@@ -105,6 +105,93 @@ public Q_SLOTS:
      */
     bool releaseSensor(const QString &id, int sessionId, qint64 pid);
 
+    /**
+     * Configure and start a sensor session in one call, instead of
+     * separate calls for every property followed by start. The chain of
+     * the sensor is reconfigured once.
+     *
+     * @param id Sensor ID.
+     * @param sessionId Session ID.
+     * @param config session configuration: \c interval, \c bufferSize,
+     *               \c bufferInterval, \c downsampling,
+     *               \c standbyOverride, \c packedFormat,
+     *               \c compactFormat and \c latencyTracing, all
+     *               optional.
+     * @param pid Requestor PID.
+     * @return was every setting applied. The session is started anyway.
+     */
+    bool openSession(const QString &id, int sessionId, const QVariantMap& config, qint64 pid);
+
+    /**
+     * Describe every available sensor with its metadata and state in
+     * one reply, see SensorManager::sensorInfo().
+     *
+     * @param plugins plugins to load first.
+     * @param pid Requestor PID.
+     * @return sensor descriptions by sensor ID.
+     */
+    QVariantMap sensorInfo(const QStringList& plugins, qint64 pid);
+
+    /**
+     * Get throughput and processing time counters of the nodes which
+     * have processed samples since counting was enabled, followed by
+     * the counters of every session. sensordstat shows these live.
+     *
+     * @return one line per node and session.
+     */
+    QStringList nodeStatistics();
+
+    /**
+     * Enable or disable node statistics. Counters are reset when
+     * enabled.
+     *
+     * @param enabled should statistics be collected.
+     */
+    void setNodeStatisticsEnabled(bool enabled);
+
+    /**
+     * Start recording a buffer of an adaptor or a chain.
+     *
+     * @param id adaptor or chain ID.
+     * @param buffer buffer name.
+     * @param name file name in the recording directory.
+     * @return was recording started.
+     */
+    bool startRecording(const QString& id, const QString& buffer, const QString& name);
+
+    /**
+     * Stop recording a buffer.
+     *
+     * @param id adaptor or chain ID.
+     * @param buffer buffer name.
+     * @return was buffer found.
+     */
+    bool stopRecording(const QString& id, const QString& buffer);
+
+    /**
+     * Write the samples kept by the flight recorders into sample
+     * recordings in the recording directory.
+     *
+     * @return written files.
+     */
+    QStringList dumpFlightRecorders();
+
+    /**
+     * Reload configuration files and apply changed values to running
+     * sensors, chains and adaptors which support it.
+     *
+     * @return were all configuration files loaded.
+     */
+    bool reloadConfiguration();
+
+    /**
+     * Get address of the peer-to-peer DBus server, which takes the same
+     * calls without going through the bus daemon.
+     *
+     * @return server address, empty if sensord is not listening.
+     */
+    QString peerAddress();
+
 Q_SIGNALS:
     /**
      * Signal which is emitted for occured errors.
@@ -0,0 +1,101 @@
+/**
+   @file sessionblockpool.cpp
+   @brief SessionBlockPool
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "sessionblockpool.h"
+#include <string.h>
+
+SessionBlockPool::SessionBlockPool(int maxFreeBlocks) :
+    free_(SIZE_CLASSES),
+    maxFreeBlocks_(maxFreeBlocks)
+{
+}
+
+SessionBlockPool::~SessionBlockPool()
+{
+    for (int i = 0; i < free_.size(); ++i)
+    {
+        foreach (char* block, free_.at(i))
+            delete[] block;
+    }
+}
+
+int SessionBlockPool::sizeClass(unsigned int bytes)
+{
+    int n = 0;
+    unsigned int blockSize = MIN_BLOCK_SIZE;
+    while (blockSize < bytes)
+    {
+        blockSize <<= 1;
+        if (++n == SIZE_CLASSES)
+            return -1;
+    }
+    return n;
+}
+
+char* SessionBlockPool::take(unsigned int bytes)
+{
+    int n = sizeClass(bytes);
+    if (n < 0)
+        return new char[bytes];
+
+    QVector<char*>& blocks = free_[n];
+    if (!blocks.isEmpty())
+    {
+        char* block = blocks.last();
+        blocks.pop_back();
+        return block;
+    }
+    return new char[MIN_BLOCK_SIZE << n];
+}
+
+void SessionBlockPool::reserve(int count, unsigned int maxBytes)
+{
+    int last = sizeClass(maxBytes);
+    if (last < 0)
+        last = SIZE_CLASSES - 1;
+    count = qMin(count, maxFreeBlocks_);
+    for (int n = 0; n <= last; ++n)
+    {
+        unsigned int blockSize = MIN_BLOCK_SIZE << n;
+        while (free_.at(n).size() < count)
+        {
+            char* block = new char[blockSize];
+            memset(block, 0, blockSize);
+            free_[n].append(block);
+        }
+    }
+}
+
+void SessionBlockPool::give(char* block, unsigned int bytes)
+{
+    if (!block)
+        return;
+
+    int n = sizeClass(bytes);
+    if (n < 0 || free_.at(n).size() >= maxFreeBlocks_)
+    {
+        delete[] block;
+        return;
+    }
+    free_[n].append(block);
+}
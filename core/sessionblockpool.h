@@ -0,0 +1,98 @@
+/**
+   @file sessionblockpool.h
+   @brief SessionBlockPool
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef SESSIONBLOCKPOOL_H
+#define SESSIONBLOCKPOOL_H
+
+#include <QVector>
+
+/**
+ * Pool of the memory blocks holding the sample buffers of sessions.
+ * Blocks are sized in powers of two, and a block given back when a
+ * session is removed or resized is kept for the next session of the
+ * same size class. Clients opening and closing sessions at a high rate
+ * then reuse the same few blocks instead of fragmenting the heap.
+ *
+ * Used only from the main thread, so there is no locking.
+ */
+class SessionBlockPool
+{
+public:
+    /**
+     * Constructor.
+     *
+     * @param maxFreeBlocks how many unused blocks of each size class are
+     *                      kept.
+     */
+    SessionBlockPool(int maxFreeBlocks = 16);
+
+    /**
+     * Destructor. Frees the unused blocks. Blocks still held by sessions
+     * must have been given back.
+     */
+    ~SessionBlockPool();
+
+    /**
+     * Take a block.
+     *
+     * @param bytes minimum size of the block.
+     * @return block of at least given size.
+     */
+    char* take(unsigned int bytes);
+
+    /**
+     * Fill the pool with faulted in blocks of each size class up to a
+     * size, so that sessions set up later take their buffers from
+     * resident memory. At most the number of kept blocks is reserved.
+     *
+     * @param count blocks of each size class.
+     * @param maxBytes size of the largest class to fill.
+     */
+    void reserve(int count, unsigned int maxBytes);
+
+    /**
+     * Give a block back to the pool.
+     *
+     * @param block block from #take().
+     * @param bytes size given to #take().
+     */
+    void give(char* block, unsigned int bytes);
+
+private:
+    /**
+     * Size class of a block: blocks of class n are MIN_BLOCK_SIZE << n
+     * bytes.
+     *
+     * @param bytes minimum size of the block.
+     * @return size class, or -1 if blocks of this size are not pooled.
+     */
+    static int sizeClass(unsigned int bytes);
+
+    static const unsigned int MIN_BLOCK_SIZE = 256;
+    static const int          SIZE_CLASSES = 13;
+
+    QVector<QVector<char*> > free_;          /**< unused blocks by size class */
+    int                      maxFreeBlocks_; /**< unused blocks kept per class */
+};
+
+#endif // SESSIONBLOCKPOOL_H
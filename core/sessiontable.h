@@ -0,0 +1,189 @@
+/**
+   @file sessiontable.h
+   @brief SessionTable
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef SESSIONTABLE_H
+#define SESSIONTABLE_H
+
+#include <QVector>
+
+/**
+ * Table of session pointers by session ID, looked up for every
+ * delivered sample. Session IDs are handed out sequentially, so the
+ * live ones form a narrow window and an ID masked by the table size is
+ * almost always the slot of the session itself: a lookup is an array
+ * index and one compare. Collisions are resolved by linear probing.
+ * The values are also kept in a dense array for iteration.
+ */
+template <class TYPE>
+class SessionTable
+{
+public:
+    SessionTable() : mask_(0) {}
+
+    /**
+     * Find session.
+     *
+     * @param id session ID.
+     * @return session or NULL if not found.
+     */
+    TYPE* value(int id) const
+    {
+        if (entries_.isEmpty())
+            return NULL;
+        for (unsigned int slot = id & mask_; ; slot = (slot + 1) & mask_) {
+            int index = slots_[slot];
+            if (index < 0)
+                return NULL;
+            if (entries_[index].id == id)
+                return entries_[index].value;
+        }
+    }
+
+    /**
+     * Is there a session with given ID.
+     *
+     * @param id session ID.
+     * @return is there a session.
+     */
+    bool contains(int id) const { return value(id) != NULL; }
+
+    /**
+     * Add session. The ID must not be in the table.
+     *
+     * @param id session ID.
+     * @param value session.
+     */
+    void insert(int id, TYPE* value)
+    {
+        // Keep the load at most half for short probe sequences.
+        if ((entries_.size() + 1) * 2 > slots_.size())
+            rehash(qMax(16, slots_.size() * 2));
+        Entry entry;
+        entry.id = id;
+        entry.value = value;
+        entries_.append(entry);
+        place(id, entries_.size() - 1);
+    }
+
+    /**
+     * Remove session.
+     *
+     * @param id session ID.
+     * @return removed session or NULL if not found.
+     */
+    TYPE* take(int id)
+    {
+        if (entries_.isEmpty())
+            return NULL;
+        unsigned int slot = id & mask_;
+        for (;; slot = (slot + 1) & mask_) {
+            if (slots_[slot] < 0)
+                return NULL;
+            if (entries_[slots_[slot]].id == id)
+                break;
+        }
+        int index = slots_[slot];
+        TYPE* value = entries_[index].value;
+
+        // Shift later entries of the probe sequence back into the hole.
+        unsigned int hole = slot;
+        for (unsigned int next = (hole + 1) & mask_; slots_[next] >= 0; next = (next + 1) & mask_) {
+            unsigned int home = entries_[slots_[next]].id & mask_;
+            if (((next - home) & mask_) >= ((next - hole) & mask_)) {
+                slots_[hole] = slots_[next];
+                hole = next;
+            }
+        }
+        slots_[hole] = -1;
+
+        // Move the last entry into the freed position of the dense array.
+        int last = entries_.size() - 1;
+        if (index != last) {
+            entries_[index] = entries_[last];
+            slots_[find(entries_[index].id)] = index;
+        }
+        entries_.resize(last);
+        return value;
+    }
+
+    /**
+     * Number of sessions.
+     *
+     * @return session count.
+     */
+    int size() const { return entries_.size(); }
+
+    /**
+     * Session ID at given position of the dense array. Positions
+     * change when sessions are removed.
+     *
+     * @param index position, 0 to size() - 1.
+     * @return session ID.
+     */
+    int idAt(int index) const { return entries_[index].id; }
+
+    /**
+     * Session at given position of the dense array.
+     *
+     * @param index position, 0 to size() - 1.
+     * @return session.
+     */
+    TYPE* at(int index) const { return entries_[index].value; }
+
+private:
+    struct Entry
+    {
+        int   id;    /**< session ID */
+        TYPE* value; /**< session */
+    };
+
+    unsigned int find(int id) const
+    {
+        unsigned int slot = id & mask_;
+        while (entries_[slots_[slot]].id != id)
+            slot = (slot + 1) & mask_;
+        return slot;
+    }
+
+    void place(int id, int index)
+    {
+        unsigned int slot = id & mask_;
+        while (slots_[slot] >= 0)
+            slot = (slot + 1) & mask_;
+        slots_[slot] = index;
+    }
+
+    void rehash(int size)
+    {
+        slots_.fill(-1, size);
+        mask_ = size - 1;
+        for (int i = 0; i < entries_.size(); ++i)
+            place(entries_[i].id, i);
+    }
+
+    QVector<int>   slots_;   /**< dense array position of each slot, -1 if free */
+    QVector<Entry> entries_; /**< sessions in no particular order */
+    unsigned int   mask_;    /**< slot count minus one */
+};
+
+#endif // SESSIONTABLE_H
@@ -28,11 +28,36 @@
 #ifndef SINK_H
 #define SINK_H
 
+#include "nodestatistics.h"
+#include "datatypes/datatypeid.h"
+
 /**
  * Data sink base class.
  */
 class SinkBase
 {
+public:
+    /**
+     * Does the owner of the sink have a live downstream.
+     *
+     * @return is data given to the sink used.
+     */
+    virtual bool hasDemand() const { return true; }
+
+    /**
+     * Key of the data type the sink accepts, see DataType::key().
+     *
+     * @return type key.
+     */
+    virtual quintptr dataTypeKey() const = 0;
+
+    /**
+     * Name of the data type the sink accepts.
+     *
+     * @return type name.
+     */
+    virtual const char* dataTypeName() const = 0;
+
 protected:
     /**
      * Destructor.
@@ -56,6 +81,10 @@ public:
      * @param values Data source location.
      */
     virtual void collect(int n, const TYPE* values) = 0;
+
+    quintptr dataTypeKey() const { return DataType<TYPE>::key(); }
+
+    const char* dataTypeName() const { return DataType<TYPE>::name(); }
 };
 
 /**
@@ -81,17 +110,48 @@ public:
      */
     Sink(DERIVED* instance, Member member) :
         instance_(instance),
-        member_(member)
+        member_(member),
+        statistics_(NULL)
     {}
 
+    /**
+     * Count the incoming samples and the time spent in the callback
+     * into given statistics. The time includes the nodes the callback
+     * propagates to synchronously.
+     *
+     * @param statistics statistics of the owning node.
+     */
+    void setStatistics(NodeStatistics* statistics)
+    {
+        statistics_ = statistics;
+    }
+
+    /**
+     * Sink has demand when its implementor has.
+     *
+     * @return is data given to the sink used.
+     */
+    bool hasDemand() const
+    {
+        return instance_->hasDemand();
+    }
+
 private:
     void collect(int n, const TYPE* values)
     {
+        if (statistics_ && NodeStatistics::isEnabled()) {
+            quint64 start = NodeStatistics::timestamp();
+            (instance_->*member_)(n, values);
+            statistics_->addInput(n);
+            statistics_->addProcessingTime(start);
+            return;
+        }
         (instance_->*member_)(n, values);
     }
 
-    DERIVED* instance_; /** sink callback implementor */
-    Member   member_;   /** sink callback function */
+    DERIVED*        instance_;   /** sink callback implementor */
+    Member          member_;     /** sink callback function */
+    NodeStatistics* statistics_; /** statistics of the owning node */
 };
 
 #endif
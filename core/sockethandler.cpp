@@ -28,134 +28,825 @@
 
 #include <QLocalSocket>
 #include <QLocalServer>
+#include <QSocketNotifier>
+#include <QThread>
 #include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
 #include "logging.h"
+#include "config.h"
 #include "sockethandler.h"
+#include "sessionprotocol.h"
+#include "sampletrace.h"
+#ifdef SENSORFW_IO_URING
+#include "uringreactor.h"
+#endif
 #include <unistd.h>
 #include <limits.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
 
-SessionData::SessionData(QLocalSocket* socket, QObject* parent) : QObject(parent),
+/**
+ * How many unbuffered samples can be collected into one frame
+ * before they are flushed.
+ */
+static const unsigned int MAX_COALESCED_SAMPLES = 16;
+
+/**
+ * Default limit for bytes waiting in the socket write queue.
+ */
+static const int DEFAULT_HIGH_WATER_BYTES = 64 * 1024;
+
+/**
+ * Default number of samples held while the client is congested.
+ */
+static const unsigned int DEFAULT_HIGH_WATER_SAMPLES = 256;
+
+/**
+ * Kernel bookkeeping charged against the send buffer per queued write.
+ */
+static const int SEND_BUFFER_WRITE_OVERHEAD = 512;
+
+/**
+ * Smallest automatically sized send buffer.
+ */
+static const int MIN_SEND_BUFFER = 4096;
+
+/**
+ * Flushes finding the socket drained before an adaptive batch is halved.
+ */
+static const unsigned int ADAPTIVE_SHRINK_FLUSHES = 8;
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+#ifdef SENSORFW_IO_URING
+/**
+ * Frame of a session queued to the UringReactor. Frame and trace
+ * headers are built on the stack, so they are copied here together
+ * with small payloads; larger payloads stay in the session buffers,
+ * which are not written to before the batch completes.
+ */
+struct SessionSend : public UringSender
+{
+    SessionSend(SessionData* session) : session(session), pending(false) {}
+
+    void sendCompleted(int result)
+    {
+        pending = false;
+        if(!session->finishWrite(iov, pieces, total, count, result))
+            session->dropped += count;
+    }
+
+    SessionData* session;   /**< owning session */
+    bool pending;           /**< is the send queued */
+    struct msghdr msg;      /**< queued message */
+    struct iovec iov[4];    /**< pieces of the frame */
+    int pieces;             /**< number of pieces */
+    int total;              /**< frame size in bytes */
+    unsigned int count;     /**< samples in the frame */
+    char scratch[256];      /**< copies of the small pieces */
+};
+#endif
+
+SessionData::SessionData(QLocalSocket* socket, QObject* parent, int id, SessionBlockPool* pool, FlushWheel* wheel,
+                         UringReactor* reactor) : QObject(parent),
                                                                   socket(socket),
                                                                   interval(-1),
                                                                   buffer(0),
                                                                   size(0),
+                                                                  capacity(0),
                                                                   count(0),
+                                                                  flushRequested_(false),
+                                                                  nextDue(0),
+                                                                  wheel(wheel),
+                                                                  flushSlack(0),
                                                                   bufferSize(1),
                                                                   bufferInterval(0),
-                                                                  downsampling(false)
+                                                                  burstInterval(0),
+                                                                  downsampling(false),
+                                                                  ring(NULL),
+                                                                  sequence(0),
+                                                                  dropped(0),
+                                                                  highWaterBytes(DEFAULT_HIGH_WATER_BYTES),
+                                                                  highWaterSamples(DEFAULT_HIGH_WATER_SAMPLES),
+                                                                  policy(DropOldest),
+                                                                  congestedState(false),
+                                                                  congestionCount(0),
+                                                                  id(id),
+                                                                  tracing(false),
+                                                                  traceQueued(0),
+                                                                  traceDelivered(0),
+                                                                  multiplexed(false),
+                                                                  compact(false),
+                                                                  compactBuffer(NULL),
+                                                                  pool(pool),
+                                                                  blockSize(0),
+                                                                  pid(0),
+                                                                  cpuAccounting(false),
+                                                                  usedBytes(0),
+                                                                  usedCpuNs(0),
+                                                                  throttle(1),
+                                                                  throttleCount(0),
+                                                                  priority(InteractivePriority),
+                                                                  seqPacket(false),
+                                                                  sendBufferLatency(0),
+                                                                  sendBufferMax(0),
+                                                                  sendBuffer(0),
+                                                                  framePeriod(0),
+                                                                  framePhase(0),
+                                                                  frameLead(0),
+                                                                  adaptiveLimit(1),
+                                                                  adaptiveBatch(1),
+                                                                  drainedFlushes(0),
+                                                                  reactor(reactor),
+                                                                  pendingSend(NULL)
 {
-    lastWrite.tv_sec = 0;
-    lastWrite.tv_usec = 0;
-    timer.setSingleShot(true);
-    connect(&timer, SIGNAL(timeout()), this, SLOT(timerTimeout()));
+    // Follows the session when the handler moves to the delivery thread.
+    frameTimer.setParent(this);
+    frameTimer.setSingleShot(true);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    frameTimer.setTimerType(Qt::PreciseTimer);
+#endif
+    connect(&frameTimer, SIGNAL(timeout()), this, SLOT(frameDue()));
+
+    if(!this->wheel)
+        this->wheel = new FlushWheel(1, this);
+    connect(socket, SIGNAL(bytesWritten(qint64)), this, SLOT(socketBytesWritten()));
+
+    struct ucred cred;
+    socklen_t credLength = sizeof(cred);
+    if(getsockopt(socket->socketDescriptor(), SOL_SOCKET, SO_PEERCRED, &cred, &credLength) == 0)
+        pid = cred.pid;
+
+    int type = 0;
+    socklen_t typeLength = sizeof(type);
+    if(getsockopt(socket->socketDescriptor(), SOL_SOCKET, SO_TYPE, &type, &typeLength) == 0)
+        seqPacket = (type == SOCK_SEQPACKET);
+
+    Config* config = Config::configuration();
+    if(config)
+    {
+        highWaterBytes = config->value<int>("global/session_high_water_bytes", DEFAULT_HIGH_WATER_BYTES);
+        highWaterSamples = config->value<unsigned int>("global/session_high_water_samples", DEFAULT_HIGH_WATER_SAMPLES);
+        QString policyName = config->value<QString>("global/session_backpressure_policy", "drop_oldest");
+        if(policyName == "drop_newest")
+            policy = DropNewest;
+        else if(policyName == "coalesce")
+            policy = CoalesceLatest;
+        if(highWaterSamples < 1)
+            highWaterSamples = 1;
+        flushSlack = config->value<unsigned int>("global/session_flush_slack", 0);
+        sendBufferLatency = config->value<unsigned int>("global/session_send_buffer_latency", 0);
+        sendBufferMax = config->value<int>("global/session_send_buffer_max", 1024 * 1024);
+        adaptiveLimit = config->value<unsigned int>("global/session_adaptive_batch", 1);
+        if(adaptiveLimit < 1)
+            adaptiveLimit = 1;
+    }
 }
 
 SessionData::~SessionData()
 {
-    timer.stop();
-    delete socket;
-    delete[] buffer;
+    wheel->cancel(this);
+#ifdef SENSORFW_IO_URING
+    if(pendingSend && pendingSend->pending)
+        reactor->complete();
+    delete pendingSend;
+#endif
+    setTracing(false);
+    if(!multiplexed)
+        delete socket;
+    releaseBuffer();
+    if(ring)
+        munmap(ring, sharedRingSize(ring->capacity, ring->slotSize));
 }
 
-void SessionData::timerTimeout()
+void SessionData::expired()
 {
-    delayedWrite();
+    requestFlush();
 }
 
-long SessionData::sinceLastWrite() const
+bool SessionData::downsampleDue(const void* source, int size)
 {
-    if(lastWrite.tv_sec == 0)
-        return LONG_MAX;
-    struct timeval now;
-    gettimeofday(&now, 0);
-    return (now.tv_sec - lastWrite.tv_sec) * 1000 + ((now.tv_usec - lastWrite.tv_usec) / 1000);
+    quint64 period = (quint64)interval * 1000;
+    quint64 time = SampleTrace::sampleTime(source, size);
+    if(!time)
+        time = SampleTrace::now();
+
+    if(nextDue && time + period / 8 < nextDue && nextDue <= time + 2 * period)
+        return false;
+
+    // Keep the phase unless the sample missed the slot by more than an
+    // interval.
+    if(nextDue && time < nextDue + period && time + 2 * period >= nextDue)
+        nextDue += period;
+    else
+        nextDue = time + period;
+    return true;
 }
 
-bool SessionData::write(void* source, int size, unsigned int count)
+bool SessionData::write(const char* source, int size, unsigned int count)
 {
-    if(socket && count)
+    if(!socket || !count)
+        return false;
+
+    if(ring)
+    {
+        usedBytes += size * count;
+        return writeShared(source, size, count);
+    }
+
+    sensordLogT() << "[SocketHandler]: writing " << count << " fragments to socket with payload (bytes): " << size;
+
+    struct timespec cpuStart;
+    if(cpuAccounting)
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuStart);
+
+    int payload = size * count;
+    const char* samples = source;
+    if(compact && count > 1)
+    {
+        size_t compacted = sessionCompactEncode(source, count, size, compactBuffer);
+        if(compacted)
+        {
+            samples = compactBuffer;
+            payload = compacted;
+        }
+    }
+
+    SessionFrameHeader header = sessionFrameHeader(count, sequence, tracing, samples != source);
+    sequence += count;
+
+    struct iovec iov[4];
+    int pieces = 0;
+    SessionMultiplexTag tag;
+    if(multiplexed)
+    {
+        tag.sessionId = id;
+        iov[pieces].iov_base = &tag;
+        iov[pieces].iov_len = sizeof(tag);
+        ++pieces;
+    }
+    iov[pieces].iov_base = &header;
+    iov[pieces].iov_len = sizeof(header);
+    ++pieces;
+    iov[pieces].iov_base = (void*)samples;
+    iov[pieces].iov_len = payload;
+    ++pieces;
+
+    SessionFrameTrace trace;
+    if(tracing)
+    {
+        trace.sampled = SampleTrace::sampleTime(source + size * (count - 1), size);
+        trace.queued = traceQueued;
+        trace.delivered = traceDelivered;
+        trace.written = SampleTrace::now();
+        iov[pieces].iov_base = &trace;
+        iov[pieces].iov_len = sizeof(trace);
+        ++pieces;
+    }
+    if(SampleTrace::isEnabled())
+        SampleTrace::mark("written", id, SampleTrace::sampleTime(source + size * (count - 1), size));
+
+    int total = 0;
+    for(int i = 0; i < pieces; ++i)
+        total += iov[i].iov_len;
+    if(multiplexed)
+        tag.size = total - sizeof(tag);
+#ifdef SENSORFW_IO_URING
+    // Anything still queued in QLocalSocket must go out first to keep frames intact.
+    if(reactor && reactor->batching() && socket->bytesToWrite() == 0 && queueSend(iov, pieces, total, count))
+    {
+        if(cpuAccounting)
+            addCpuTime(cpuStart);
+        return true;
+    }
+#endif
+
+    int written = 0;
+
+    // Anything still queued in QLocalSocket must go out first to keep frames intact.
+    if(socket->bytesToWrite() == 0)
     {
-        sensordLogT() << "[SocketHandler]: writing " << count << " fragments to socket with payload (bytes): " << size;
-        memcpy(source, &count, sizeof(unsigned int));
-        int written = socket->write((const char*)source, size * count + sizeof(unsigned int));
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = pieces;
+
+        written = ::sendmsg(socket->socketDescriptor(), &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
         if(written < 0)
+            written = -errno;
+    }
+
+    if(!finishWrite(iov, pieces, total, count, written))
+        return false;
+    if(cpuAccounting)
+        addCpuTime(cpuStart);
+    return true;
+}
+
+bool SessionData::finishWrite(const struct iovec* iov, int pieces, int total, unsigned int count, int written)
+{
+    if(written < 0)
+    {
+        int error = -written;
+        if(error != EAGAIN && error != EWOULDBLOCK)
         {
-            sensordLogW() << "[SocketHandler]: failed to write payload to the socket: " << socket->errorString();
+            sensordLogW() << "[SocketHandler]: failed to write payload to the socket: " << strerror(error);
             return false;
         }
+        if(seqPacket && error == EMSGSIZE)
+            sensordLogW() << "[SocketHandler]: frame of " << total << " bytes exceeds the socket buffer";
+        written = 0;
+    }
+
+    if(seqPacket && written < total)
+    {
+        // A packet is sent whole or not at all. Rather than queueing it,
+        // the frame is dropped; the client sees the sequence gap.
+        sensordLogT() << "[SocketHandler]: socket busy, dropping frame of " << count << " samples";
+        dropped += count;
         return true;
     }
-    return false;
+
+    if(written < total)
+    {
+        sensordLogT() << "[SocketHandler]: socket busy, queueing " << (total - written) << " bytes";
+        int offset = 0;
+        for(int i = 0; i < pieces; ++i)
+        {
+            int length = iov[i].iov_len;
+            int skip = written > offset ? qMin(written - offset, length) : 0;
+            offset += length;
+            if(skip == length)
+                continue;
+            if(socket->write((const char*)iov[i].iov_base + skip, length - skip) < 0)
+            {
+                sensordLogW() << "[SocketHandler]: failed to write payload to the socket: " << socket->errorString();
+                return false;
+            }
+        }
+    }
+
+    usedBytes += total;
+    return true;
 }
 
-bool SessionData::write(const void* source, int size)
+void SessionData::addCpuTime(const struct timespec& start)
 {
-    long since = sinceLastWrite();
-    int allocSize = bufferSize * size + sizeof(unsigned int);
-    if(!buffer)
-        buffer = new char[allocSize];
-    else if(size != this->size)
+    struct timespec end;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end);
+    usedCpuNs += (end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec);
+}
+
+#ifdef SENSORFW_IO_URING
+bool SessionData::queueSend(const struct iovec* iov, int pieces, int total, unsigned int count)
+{
+    if(!pendingSend)
+        pendingSend = new SessionSend(this);
+    else if(pendingSend->pending)
+        reactor->complete();
+
+    SessionSend* send = pendingSend;
+    size_t used = 0;
+    for(int i = 0; i < pieces; ++i)
     {
-        socket->waitForBytesWritten();
-        delete[] buffer;
-        buffer = new char[allocSize];
+        send->iov[i] = iov[i];
+        if(iov[i].iov_len <= sizeof(send->scratch) - used)
+        {
+            memcpy(send->scratch + used, iov[i].iov_base, iov[i].iov_len);
+            send->iov[i].iov_base = send->scratch + used;
+            used += iov[i].iov_len;
+        }
+    }
+    send->pieces = pieces;
+    send->total = total;
+    send->count = count;
+    memset(&send->msg, 0, sizeof(send->msg));
+    send->msg.msg_iov = send->iov;
+    send->msg.msg_iovlen = pieces;
+
+    if(!reactor->queueSend(socket->socketDescriptor(), &send->msg, MSG_NOSIGNAL | MSG_DONTWAIT, send))
+        return false;
+    send->pending = true;
+    return true;
+}
+#endif
+
+bool SessionData::writeShared(const char* source, int size, unsigned int count)
+{
+    if(size > (int)ring->slotSize)
+    {
+        sensordLogW() << "[SocketHandler]: sample of " << size << " bytes does not fit into shared ring slot";
+        return false;
+    }
+
+    sensordLogT() << "[SocketHandler]: writing " << count << " fragments to shared ring";
+
+    ring->elementSize = size;
+    unsigned int writeCount = ring->writeCount;
+    sequence += count;
+    for(unsigned int i = 0; i < count; ++i)
+    {
+        // Publish one by one so that at most one slot is ever in flux.
+        memcpy(sharedRingSlot(ring, writeCount + i), source + size * i, size);
+        sharedRingPublish(ring, writeCount + i + 1);
+    }
+
+    // Client drains all doorbells at once, so a full socket is no loss.
+    char doorbell = 0;
+    if(socket->bytesToWrite() == 0 &&
+       ::send(socket->socketDescriptor(), &doorbell, 1, MSG_NOSIGNAL | MSG_DONTWAIT) < 0 &&
+       errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+        sensordLogW() << "[SocketHandler]: failed to ring doorbell: " << strerror(errno);
+        return false;
     }
-    this->size = size;
-    if(bufferSize <= 1)
+    return true;
+}
+
+int SessionData::createSharedRing()
+{
+    if(ring)
+        return -1;
+
+#ifdef __NR_memfd_create
+    int fd = syscall(__NR_memfd_create, "sensord-session", MFD_CLOEXEC);
+#else
+    int fd = -1;
+    errno = ENOSYS;
+#endif
+    if(fd < 0)
+    {
+        sensordLogW() << "[SocketHandler]: failed to create shared memory: " << strerror(errno);
+        return -1;
+    }
+
+    size_t ringSize = sharedRingSize(SHARED_RING_CAPACITY, SHARED_RING_SLOT_SIZE);
+    void* mem = MAP_FAILED;
+    if(ftruncate(fd, ringSize) == 0)
+        mem = mmap(NULL, ringSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(mem == MAP_FAILED)
+    {
+        sensordLogW() << "[SocketHandler]: failed to map shared memory: " << strerror(errno);
+        close(fd);
+        return -1;
+    }
+
+    ring = (SharedRingHeader*)mem;
+    ring->magic = SHARED_RING_MAGIC;
+    ring->version = SHARED_RING_VERSION;
+    ring->capacity = SHARED_RING_CAPACITY;
+    ring->slotSize = SHARED_RING_SLOT_SIZE;
+    ring->elementSize = 0;
+    ring->dropCount = dropped;
+    sharedRingPublish(ring, 0);
+    return fd;
+}
+
+void SessionData::addDropped(unsigned int count)
+{
+    if(!count)
+        return;
+    dropped += count;
+    sequence += count;
+    if(ring)
+        __atomic_store_n(&ring->dropCount, dropped, __ATOMIC_RELAXED);
+    sensordLogD() << "[SocketHandler]: session dropped " << count << " samples, " << dropped << " in total";
+}
+
+unsigned int SessionData::getDropped() const
+{
+    return dropped;
+}
+
+void SessionData::setHighWaterMark(qint64 bytes, unsigned int samples)
+{
+    highWaterBytes = bytes;
+    if(samples < 1)
+        samples = 1;
+    if(samples != highWaterSamples)
     {
-        memcpy(buffer + sizeof(unsigned int), source, size);
-        if(!downsampling || (downsampling && since >= interval))
+        highWaterSamples = samples;
+        if(buffer && capacity < highWaterSamples)
         {
-            sensordLogT() << "[SocketHandler]: writing, since > interval or downsampling disabled";
-            gettimeofday(&lastWrite, 0);
-            return write(buffer, size, 1);
+            flush();
+            discardBuffered();
+            releaseBuffer();
         }
     }
+}
+
+void SessionData::setBackpressurePolicy(BackpressurePolicy policy)
+{
+    this->policy = policy;
+}
+
+SessionData::BackpressurePolicy SessionData::getBackpressurePolicy() const
+{
+    return policy;
+}
+
+unsigned int SessionData::getCongestionCount() const
+{
+    return congestionCount;
+}
+
+QString SessionData::statistics() const
+{
+    return QString("session %1: out %2, drops %3, queue %4, socket bytes %5, congested %6, client %7")
+        .arg(id)
+        .arg(sequence - dropped)
+        .arg(count)
+        .arg(socket && !ring ? socket->bytesToWrite() : 0)
+        .arg(congestionCount)
+        .arg(pid);
+}
+
+qint64 SessionData::peerPid() const
+{
+    return pid;
+}
+
+void SessionData::setCpuAccounting(bool value)
+{
+    cpuAccounting = value;
+}
+
+void SessionData::takeUsage(quint64& bytes, quint64& cpuNs)
+{
+    bytes = usedBytes;
+    cpuNs = usedCpuNs;
+    usedBytes = 0;
+    usedCpuNs = 0;
+}
+
+void SessionData::setThrottle(unsigned int factor)
+{
+    throttle = qMax(1u, factor);
+    throttleCount = 0;
+}
+
+unsigned int SessionData::getThrottle() const
+{
+    return throttle;
+}
+
+void SessionData::setPriority(Priority priority)
+{
+    this->priority = priority;
+}
+
+SessionData::Priority SessionData::getPriority() const
+{
+    return priority;
+}
+
+void SessionData::setFrameClock(unsigned int period, quint64 phase, unsigned int lead)
+{
+    sensordLogT() << "[SocketHandler]: frame clock of session " << id << ": " << period << " us, phase " << phase << ", lead " << lead;
+    frameTimer.stop();
+    wheel->cancel(this);
+    framePeriod = period;
+    framePhase = phase;
+    frameLead = lead < period ? lead : 0;
+    if(!count)
+        return;
+    if(framePeriod)
+        scheduleFrame();
+    else
+        requestFlush();
+}
+
+void SessionData::scheduleFrame()
+{
+    if(frameTimer.isActive())
+        return;
+    quint64 now = SampleTrace::now();
+    quint64 base = framePhase - frameLead;
+    quint64 elapsed = now >= base ? (now - base) % framePeriod : (framePeriod - (base - now) % framePeriod) % framePeriod;
+    // Timer resolution is a millisecond, rounding down keeps the write
+    // before the vsync.
+    frameTimer.start((framePeriod - elapsed) / 1000);
+}
+
+void SessionData::frameDue()
+{
+    flush();
+}
+
+bool SessionData::congested() const
+{
+    qint64 limit = (priority == BackgroundPriority) ? highWaterBytes / 4 : highWaterBytes;
+    return socket && !ring && limit > 0 && socket->bytesToWrite() >= limit;
+}
+
+void SessionData::discardBuffered()
+{
+    addDropped(count);
+    count = 0;
+}
+
+void SessionData::socketBytesWritten()
+{
+    if(congestedState && !congested())
+    {
+        sensordLogD() << "[SocketHandler]: client caught up, resuming writes";
+        congestedState = false;
+        if(count)
+            requestFlush();
+    }
+}
+
+void SessionData::allocateBuffer()
+{
+    discardBuffered();
+    releaseBuffer();
+    capacity = (bufferSize > 1) ? bufferSize : MAX_COALESCED_SAMPLES;
+    if(capacity < highWaterSamples)
+        capacity = highWaterSamples;
+    blockSize = capacity * size * (compact ? 2 : 1);
+    buffer = pool ? pool->take(blockSize) : new char[blockSize];
+    compactBuffer = compact ? buffer + capacity * size : NULL;
+    count = 0;
+}
+
+void SessionData::releaseBuffer()
+{
+    if(pool)
+        pool->give(buffer, blockSize);
     else
+        delete[] buffer;
+    buffer = 0;
+    compactBuffer = NULL;
+    blockSize = 0;
+}
+
+void SessionData::requestFlush()
+{
+    if(!flushRequested_)
     {
-        memcpy(buffer + sizeof(unsigned int) + size * count, source, size);
-        ++count;
-        if(bufferSize == count)
+        flushRequested_ = true;
+        emit flushRequested();
+    }
+}
+
+bool SessionData::write(const void* source, int size, const SessionFrameTrace* trace)
+{
+    if(!buffer || size != this->size)
+    {
+        // Samples of the previous size have to be written out before reallocating.
+        if(count)
+            flush();
+        this->size = size;
+        allocateBuffer();
+        updateSendBuffer();
+    }
+    else if(count == capacity)
+    {
+        flush();
+    }
+
+    if(!framePeriod && bufferSize <= 1 && !burstInterval && downsampling && interval > 0 && !downsampleDue(source, size))
+    {
+        sensordLogT() << "[SocketHandler]: dropping sample, next slot not reached";
+        return true;
+    }
+
+    if(throttle > 1 && (throttleCount++ % throttle) != 0)
+    {
+        sensordLogT() << "[SocketHandler]: dropping sample, client over budget";
+        return true;
+    }
+
+    if(congestedState && count)
+    {
+        if(policy == CoalesceLatest)
+        {
+            discardBuffered();
+        }
+        else if(count == capacity || count >= highWaterSamples)
         {
-            sensordLogT() << "[SocketHandler]: writing, bufferSize == count";
-            return delayedWrite();
+            if(policy == DropNewest)
+            {
+                addDropped(1);
+                return true;
+            }
+            memmove(buffer, buffer + size, size * (count - 1));
+            --count;
+            addDropped(1);
         }
     }
-    if(!timer.isActive())
+
+    if(tracing && trace)
     {
-        if(bufferSize > 1 && bufferInterval)
+        traceQueued = trace->queued;
+        traceDelivered = trace->delivered;
+    }
+
+    if(framePeriod)
+    {
+        // Older samples of the frame are superseded, not lost.
+        memcpy(buffer, source, size);
+        count = 1;
+        scheduleFrame();
+        return true;
+    }
+
+    if(bufferSize <= 1 && !burstInterval)
+    {
+        memcpy(buffer + size * count, source, size);
+        ++count;
+        // A lagging client gets several samples per frame, held for at
+        // most the time the batch takes to fill up.
+        if(count >= qMin(adaptiveBatch, capacity) || interval <= 0)
         {
-            sensordLogT() << "[SocketHandler]: delayed write by " << bufferInterval << "ms";
-            timer.start(bufferInterval);
+            sensordLogT() << "[SocketHandler]: writing, slot reached or downsampling disabled";
+            requestFlush();
         }
-        else if(!bufferSize && (interval - since) > 0)
+        else if(!FlushWheel::isScheduled(this))
         {
-            sensordLogT() << "[SocketHandler]: delayed write by " << (interval - since) << "ms";
-            timer.start(interval - since);
+            unsigned int delay = adaptiveBatch * interval;
+            wheel->schedule(this, delay, delay * flushSlack / 100);
         }
+        return true;
     }
-    else
+
+    memcpy(buffer + size * count, source, size);
+    ++count;
+    unsigned int flushCount = burstInterval ? capacity : bufferSize;
+    unsigned int delay = qMax(bufferInterval, burstInterval);
+    if(count >= flushCount)
+    {
+        sensordLogT() << "[SocketHandler]: writing, bufferSize == count";
+        requestFlush();
+    }
+    else if(!FlushWheel::isScheduled(this) && delay)
     {
-        sensordLogT() << "[SocketHandler]: timer already running";
+        sensordLogT() << "[SocketHandler]: delayed write by " << delay << "ms";
+        wheel->schedule(this, delay, delay * flushSlack / 100);
     }
     return true;
 }
 
-bool SessionData::delayedWrite()
+bool SessionData::flush()
 {
-    if(timer.isActive())
-        timer.stop();
-    gettimeofday(&lastWrite, 0);
+    flushRequested_ = false;
+    wheel->cancel(this);
+    if(!count)
+        return true;
+    if(congested())
+    {
+        // Hold on to the samples until the client has read what is queued.
+        if(!congestedState)
+        {
+            sensordLogW() << "[SocketHandler]: client not keeping up, " << socket->bytesToWrite() << " bytes queued";
+            congestedState = true;
+            ++congestionCount;
+        }
+        return true;
+    }
+    adaptBatch();
     bool ret = write(buffer, size, count);
+    if(!ret)
+        dropped += count;
     count = 0;
     return ret;
 }
 
+void SessionData::adaptBatch()
+{
+    if(adaptiveLimit <= 1 || !socket || ring)
+        return;
+
+    if(socket->bytesToWrite() > 0)
+    {
+        // The previous frame is still queued, the client is falling behind.
+        drainedFlushes = 0;
+        if(adaptiveBatch < adaptiveLimit)
+        {
+            adaptiveBatch = qMin(adaptiveBatch * 2, adaptiveLimit);
+            sensordLogD() << "[SocketHandler]: session " << id << " lagging, batching " << adaptiveBatch << " samples";
+        }
+    }
+    else if(adaptiveBatch > 1 && ++drainedFlushes >= ADAPTIVE_SHRINK_FLUSHES)
+    {
+        drainedFlushes = 0;
+        adaptiveBatch /= 2;
+        sensordLogD() << "[SocketHandler]: session " << id << " catching up, batching " << adaptiveBatch << " samples";
+    }
+}
+
 QLocalSocket* SessionData::stealSocket()
 {
     QLocalSocket* tmpsocket = socket;
     socket = 0;
-    return tmpsocket;
+    return multiplexed ? NULL : tmpsocket;
 }
 
 QLocalSocket* SessionData::getSocket() const
@@ -165,7 +856,10 @@ QLocalSocket* SessionData::getSocket() const
 
 void SessionData::setInterval(int interval)
 {
+    if(interval != this->interval)
+        nextDue = 0;
     this->interval = interval;
+    updateSendBuffer();
 }
 
 int SessionData::getInterval() const
@@ -176,6 +870,7 @@ int SessionData::getInterval() const
 void SessionData::setBufferInterval(unsigned int interval)
 {
     bufferInterval = interval;
+    updateSendBuffer();
 }
 
 unsigned int SessionData::getBufferInterval() const
@@ -183,21 +878,54 @@ unsigned int SessionData::getBufferInterval() const
     return bufferInterval;
 }
 
+void SessionData::setBurstInterval(unsigned int interval)
+{
+    if(interval == burstInterval)
+        return;
+    burstInterval = interval;
+    wheel->cancel(this);
+    if(!burstInterval && count)
+        requestFlush();
+}
+
 void SessionData::setBufferSize(unsigned int size)
 {
     if(size != bufferSize)
     {
-        if(timer.isActive())
-            timer.stop();
-        socket->waitForBytesWritten();
-        delete[] buffer;
-        buffer = 0;
-        count = 0;
+        flush();
+        discardBuffered();
+        releaseBuffer();
         bufferSize = size;
         if(bufferSize < 1)
             bufferSize = 1;
         sensordLogT() << "[SocketHandler]: new buffersize: " << bufferSize;
+        updateSendBuffer();
+    }
+}
+
+void SessionData::updateSendBuffer()
+{
+    // Multiplexed sockets are shared and rings only carry doorbells.
+    if(!sendBufferLatency || !socket || multiplexed || ring || size <= 0 || interval <= 0)
+        return;
+
+    // Samples arriving while a frame is being buffered and while the
+    // client is allowed to lag behind, written bufferSize at a time.
+    quint64 window = bufferInterval + sendBufferLatency;
+    quint64 samples = window / interval + bufferSize;
+    quint64 writes = samples / bufferSize + 1;
+    quint64 bytes = samples * size + writes * (sizeof(SessionFrameHeader) + SEND_BUFFER_WRITE_OVERHEAD);
+    int value = (int)qBound((quint64)MIN_SEND_BUFFER, bytes, (quint64)qMax(sendBufferMax, MIN_SEND_BUFFER));
+    if(value == sendBuffer)
+        return;
+
+    if(setsockopt(socket->socketDescriptor(), SOL_SOCKET, SO_SNDBUF, &value, sizeof(value)) != 0)
+    {
+        sensordLogW() << "[SocketHandler]: failed to set send buffer of session " << id << ": " << strerror(errno);
+        return;
     }
+    sendBuffer = value;
+    sensordLogT() << "[SocketHandler]: send buffer of session " << id << " set to " << value << " bytes";
 }
 
 unsigned int SessionData::getBufferSize() const
@@ -210,8 +938,8 @@ void SessionData::setDownsampling(bool value)
     if(value != downsampling)
     {
         downsampling = value;
-        if(timer.isActive())
-            timer.stop();
+        nextDue = 0;
+        wheel->cancel(this);
     }
 }
 
@@ -220,10 +948,84 @@ bool SessionData::getDownsampling() const
     return downsampling;
 }
 
-SocketHandler::SocketHandler(QObject* parent) : QObject(parent), m_server(NULL)
+void SessionData::setTracing(bool value)
+{
+    if(value && ring)
+    {
+        sensordLogW() << "[SocketHandler]: latency tracing is not supported with shared memory transport";
+        return;
+    }
+    if(value != tracing)
+    {
+        tracing = value;
+        SampleTrace::setUser(value);
+    }
+}
+
+bool SessionData::setCompactFormat(bool value)
+{
+    if(value && ring)
+    {
+        sensordLogW() << "[SocketHandler]: compact format is not supported with shared memory transport";
+        return false;
+    }
+    if(value != compact)
+    {
+        if(buffer)
+            flush();
+        compact = value;
+        if(buffer)
+            allocateBuffer();
+    }
+    return true;
+}
+
+void SessionData::setMultiplexed(bool value)
 {
+    multiplexed = value;
+}
+
+bool SessionData::isMultiplexed() const
+{
+    return multiplexed;
+}
+
+SocketHandler::SocketHandler(QObject* parent) : QObject(parent), m_server(NULL), m_seqPacketFd(-1), m_seqPacketNotifier(NULL),
+    m_burstInterval(0), m_delivering(false),
+    m_blockPool(Config::configuration() ? Config::configuration()->value<int>("global/session_pool_blocks", 16) : 16),
+    m_flushWheel(Config::configuration() ? Config::configuration()->value<unsigned int>("global/session_flush_tick", 10) : 10, this),
+    m_reactor(NULL),
+    m_byteBudget(0),
+    m_cpuBudget(0)
+{
+#ifdef SENSORFW_IO_URING
+    m_reactor = UringReactor::create();
+#endif
+    // Member timers follow the handler when it is moved to the delivery thread.
+    m_flushTimer.setParent(this);
+    m_budgetTimer.setParent(this);
+
+    unsigned int budgetWindow = 1000;
+    if (Config::configuration()) {
+        m_flushWheel.setAlignment(Config::configuration()->value<unsigned int>("global/session_flush_alignment", 0));
+        m_byteBudget = Config::configuration()->value<quint64>("global/client_byte_budget", 0);
+        // Percent of one CPU.
+        m_cpuBudget = Config::configuration()->value<quint64>("global/client_cpu_budget", 0) * 10000000;
+        budgetWindow = qMax(100u, Config::configuration()->value<unsigned int>("global/client_budget_window", budgetWindow));
+    }
+    if (m_byteBudget || m_cpuBudget) {
+        m_budgetTimer.setInterval(budgetWindow);
+        connect(&m_budgetTimer, SIGNAL(timeout()), this, SLOT(checkBudgets()));
+        m_budgetTimer.start();
+    }
     m_server = new QLocalServer(this);
     connect(m_server, SIGNAL(newConnection()), this, SLOT(newConnection()));
+
+    qRegisterMetaType<SessionData::Priority>("SessionData::Priority");
+
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(0);
+    connect(&m_flushTimer, SIGNAL(timeout()), this, SLOT(flushSessions()));
 }
 
 SocketHandler::~SocketHandler()
@@ -231,6 +1033,63 @@ SocketHandler::~SocketHandler()
     if (m_server) {
         delete m_server;
     }
+    delete m_seqPacketNotifier;
+    if (m_seqPacketFd != -1) {
+        close(m_seqPacketFd);
+        unlink(m_seqPacketPath.constData());
+    }
+    // Sessions give their buffers back to m_blockPool, delete them
+    // before it.
+    for (int i = 0; i < m_sessions.size(); ++i)
+        delete m_sessions.at(i);
+#ifdef SENSORFW_IO_URING
+    delete m_reactor;
+#endif
+    foreach (const ClientWatch& watch, m_clientWatches) {
+        delete watch.notifier;
+        close(watch.fd);
+    }
+}
+
+/**
+ * First descriptor passed by systemd socket activation.
+ */
+static const int LISTEN_FDS_START = 3;
+
+/**
+ * Get listening socket passed by systemd for given path. Implements the
+ * relevant part of sd_listen_fds() to avoid linking against libsystemd.
+ *
+ * @param serverName socket path.
+ * @return socket descriptor or -1 if none was passed.
+ */
+static int activatedSocket(const QString& serverName)
+{
+    const char* pid = getenv("LISTEN_PID");
+    const char* fds = getenv("LISTEN_FDS");
+    if (!pid || !fds || atol(pid) != (long)getpid())
+        return -1;
+
+    // Descriptors are not meant for children.
+    int count = atoi(fds);
+    unsetenv("LISTEN_PID");
+    unsetenv("LISTEN_FDS");
+
+    QByteArray path = serverName.toLocal8Bit();
+    for (int fd = LISTEN_FDS_START; fd < LISTEN_FDS_START + count; ++fd)
+    {
+        struct sockaddr_un address;
+        socklen_t length = sizeof(address);
+        int listening = 0;
+        socklen_t optionLength = sizeof(listening);
+        memset(&address, 0, sizeof(address));
+        if (getsockname(fd, (struct sockaddr*)&address, &length) != 0 || address.sun_family != AF_UNIX ||
+            getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &listening, &optionLength) != 0 || !listening)
+            continue;
+        if (path == address.sun_path)
+            return fd;
+    }
+    return -1;
 }
 
 bool SocketHandler::listen(const QString& serverName)
@@ -240,6 +1099,21 @@ bool SocketHandler::listen(const QString& serverName)
         return false;
     }
 
+    int fd = activatedSocket(serverName);
+    if (fd != -1)
+    {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+        if (m_server->listen(fd)) {
+            sensordLogD() << "[SocketHandler]: Using socket " << serverName << " passed by systemd";
+            return true;
+        }
+        sensordLogW() << "[SocketHandler]: Failed to use socket passed by systemd: " << m_server->errorString();
+#else
+        sensordLogW() << "[SocketHandler]: Socket activation needs Qt 5.10, creating a new socket";
+#endif
+        close(fd);
+    }
+
     bool unlinkDone = false;
     while (!m_server->listen(serverName) && !unlinkDone && serverName[0] == QChar('/'))
     {
@@ -253,26 +1127,99 @@ bool SocketHandler::listen(const QString& serverName)
     return m_server->isListening();
 }
 
-bool SocketHandler::write(int id, const void* source, int size)
+bool SocketHandler::listenSeqPacket(const QString& path)
+{
+    if (m_seqPacketFd != -1) {
+        sensordLogW() << "[SocketHandler]: Already listening on packet socket";
+        return false;
+    }
+
+    QByteArray name = path.toLocal8Bit();
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (name.size() >= (int)sizeof(address.sun_path)) {
+        sensordLogW() << "[SocketHandler]: Packet socket path too long: " << path;
+        return false;
+    }
+    strcpy(address.sun_path, name.constData());
+
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        sensordLogW() << "[SocketHandler]: Failed to create packet socket: " << strerror(errno);
+        return false;
+    }
+    // Stale socket of a previous instance.
+    unlink(address.sun_path);
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || ::listen(fd, SOMAXCONN) != 0) {
+        sensordLogW() << "[SocketHandler]: Failed to listen on " << path << ": " << strerror(errno);
+        close(fd);
+        return false;
+    }
+
+    m_seqPacketFd = fd;
+    m_seqPacketPath = name;
+    m_seqPacketNotifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(m_seqPacketNotifier, SIGNAL(activated(int)), this, SLOT(newSeqPacketConnection()));
+    sensordLogD() << "[SocketHandler]: Listening on packet socket " << path;
+    return true;
+}
+
+bool SocketHandler::write(int id, const void* source, int size, const SessionFrameTrace* trace)
 {
-    QMap<int, SessionData*>::iterator it = m_idMap.find(id);
-    if (it == m_idMap.end())
+    SessionData* session = m_sessions.value(id);
+    if (!session)
     {
         sensordLogD() << "[SocketHandler]: Trying to write to nonexistent session (normal, no panic).";
         return false;
     }
     sensordLogT() << "[SocketHandler]: Writing to session " << id;
-    return (*it)->write(source, size);
+    return session->write(source, size, trace);
+}
+
+void SocketHandler::setTracing(int sessionId, bool value)
+{
+    if (forward()) {
+        QMetaObject::invokeMethod(this, "setTracing", Qt::QueuedConnection, Q_ARG(int, sessionId), Q_ARG(bool, value));
+        return;
+    }
+    SessionData* session = m_sessions.value(sessionId);
+    if (session)
+        session->setTracing(value);
+}
+
+bool SocketHandler::setCompactFormat(int sessionId, bool value)
+{
+    if (forward()) {
+        bool result = false;
+        QMetaObject::invokeMethod(this, "setCompactFormat", Qt::BlockingQueuedConnection, Q_RETURN_ARG(bool, result), Q_ARG(int, sessionId), Q_ARG(bool, value));
+        return result;
+    }
+    SessionData* session = m_sessions.value(sessionId);
+    if (!session)
+        return false;
+    return session->setCompactFormat(value);
 }
 
 bool SocketHandler::removeSession(int sessionId)
 {
-    if (!(m_idMap.keys().contains(sessionId))) {
+    if (forward()) {
+        bool result = false;
+        QMetaObject::invokeMethod(this, "removeSession", Qt::BlockingQueuedConnection, Q_RETURN_ARG(bool, result), Q_ARG(int, sessionId));
+        return result;
+    }
+    SessionData* removed = m_sessions.take(sessionId);
+    if (!removed) {
         sensordLogW() << "[SocketHandler]: Trying to remove nonexistent session.";
         return false;
     }
 
-    QLocalSocket* socket = (*m_idMap.find(sessionId))->stealSocket();
+    unwatchClient(sessionId, removed->peerPid());
+    QHash<QLocalSocket*, int>::iterator owner = m_socketIdMap.find(removed->getSocket());
+    if (owner != m_socketIdMap.end() && owner.value() == sessionId)
+        m_socketIdMap.erase(owner);
+
+    QLocalSocket* socket = removed->stealSocket();
 
     if (socket) {
         disconnect(socket, SIGNAL(readyRead()), this, SLOT(socketReadable()));
@@ -281,39 +1228,338 @@ bool SocketHandler::removeSession(int sessionId)
         socket->deleteLater();
     }
 
-    delete m_idMap.take(sessionId);
+    m_flushList.removeAll(removed);
+    delete removed;
+
+    return true;
+}
+
+void SocketHandler::sessionFlushRequested()
+{
+    m_flushList.append((SessionData*)sender());
+    // Delivery rounds flush at their end; starting the timer would
+    // register a timer with the event dispatcher for every round.
+    if (!m_delivering && !m_flushTimer.isActive())
+        m_flushTimer.start();
+}
+
+void SocketHandler::beginDelivery()
+{
+    m_delivering = true;
+}
+
+void SocketHandler::flushSessions()
+{
+    m_delivering = false;
+    m_flushTimer.stop();
+    if (m_flushList.isEmpty())
+        return;
+
+    sensordLogT() << "[SocketHandler]: flushing " << m_flushList.size() << " sessions";
+    // Sessions requesting a flush meanwhile are appended after these.
+    // Erasing keeps the allocation of the list for the next round.
+    // Higher priority classes are written first.
+    // With io_uring the writes are queued and go out with one submission.
+    int count = m_flushList.size();
+#ifdef SENSORFW_IO_URING
+    if (m_reactor)
+        m_reactor->begin();
+#endif
+    for (int priority = SessionData::RealtimePriority; priority <= SessionData::BackgroundPriority; ++priority) {
+        for (int i = 0; i < count; ++i) {
+            if (m_flushList.at(i)->getPriority() == priority)
+                m_flushList.at(i)->flush();
+        }
+    }
+#ifdef SENSORFW_IO_URING
+    if (m_reactor)
+        m_reactor->end();
+#endif
+    m_flushList.erase(m_flushList.begin(), m_flushList.begin() + count);
+}
+
+bool SocketHandler::sendSharedRing(QLocalSocket* socket, int fd)
+{
+    char reply = (fd < 0) ? SHARED_RING_REJECTED : SHARED_RING_ACCEPTED;
+    struct iovec iov;
+    iov.iov_base = &reply;
+    iov.iov_len = 1;
 
+    char control[CMSG_SPACE(sizeof(int))];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if(fd >= 0)
+    {
+        memset(control, 0, sizeof(control));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    }
+
+    if(::sendmsg(socket->socketDescriptor(), &msg, MSG_NOSIGNAL) != 1)
+    {
+        sensordLogW() << "[SocketHandler]: failed to send shared ring: " << strerror(errno);
+        return false;
+    }
     return true;
 }
 
+SessionData* SocketHandler::createSession(QLocalSocket* socket, int sessionId)
+{
+    SessionData* session = new SessionData(socket, this, sessionId, &m_blockPool, &m_flushWheel, m_reactor);
+    session->setBurstInterval(m_burstInterval);
+    session->setCpuAccounting(m_cpuBudget > 0);
+    connect(session, SIGNAL(flushRequested()), this, SLOT(sessionFlushRequested()));
+    m_sessions.insert(sessionId, session);
+    m_socketIdMap.insert(socket, sessionId);
+    watchClient(sessionId, session->peerPid());
+    return session;
+}
+
+void SocketHandler::watchClient(int sessionId, qint64 pid)
+{
+    if (pid <= 0)
+        return;
+
+    QHash<qint64, ClientWatch>::iterator it = m_clientWatches.find(pid);
+    if (it == m_clientWatches.end()) {
+        ClientWatch watch;
+#ifdef __NR_pidfd_open
+        watch.fd = syscall(__NR_pidfd_open, (pid_t)pid, 0);
+#endif
+        if (watch.fd < 0) {
+            // Lost sessions are noticed from their sockets only.
+            sensordLogD() << "[SocketHandler]: Not watching client " << pid << " for exit";
+            return;
+        }
+        watch.notifier = new QSocketNotifier(watch.fd, QSocketNotifier::Read, this);
+        connect(watch.notifier, SIGNAL(activated(int)), this, SLOT(clientExited(int)));
+        m_clientFds.insert(watch.fd, pid);
+        it = m_clientWatches.insert(pid, watch);
+    }
+    it.value().sessions.append(sessionId);
+}
+
+void SocketHandler::unwatchClient(int sessionId, qint64 pid)
+{
+    QHash<qint64, ClientWatch>::iterator it = m_clientWatches.find(pid);
+    if (it == m_clientWatches.end())
+        return;
+
+    it.value().sessions.removeAll(sessionId);
+    if (!it.value().sessions.isEmpty())
+        return;
+    // May run from the slot of the notifier.
+    it.value().notifier->setEnabled(false);
+    it.value().notifier->deleteLater();
+    m_clientFds.remove(it.value().fd);
+    close(it.value().fd);
+    m_clientWatches.erase(it);
+}
+
+void SocketHandler::clientExited(int fd)
+{
+    qint64 pid = m_clientFds.value(fd);
+    QList<int> sessions = m_clientWatches.value(pid).sessions;
+    sensordLogW() << "[SocketHandler]: Client " << pid << " exited, losing its " << sessions.size() << " sessions";
+    foreach (int id, sessions)
+        unwatchClient(id, pid);
+    foreach (int id, sessions)
+        emit lostSession(id);
+}
+
+bool SocketHandler::forward() const
+{
+    return QThread::currentThread() != thread() && thread()->isRunning();
+}
+
+void SocketHandler::execute(Task* task)
+{
+    if (forward())
+        QMetaObject::invokeMethod(this, "runTask", Qt::BlockingQueuedConnection, Q_ARG(void*, task));
+    else
+        task->run();
+}
+
+void SocketHandler::runTask(void* task)
+{
+    static_cast<Task*>(task)->run();
+}
+
+void SocketHandler::checkBudgets()
+{
+    /**
+     * Usage of a client during the window.
+     */
+    struct Usage
+    {
+        Usage() : bytes(0), cpuNs(0) {}
+        quint64 bytes;
+        quint64 cpuNs;
+    };
+
+    QMap<qint64, Usage> clients;
+    for (int i = 0; i < m_sessions.size(); ++i)
+    {
+        SessionData* session = m_sessions.at(i);
+        quint64 bytes;
+        quint64 cpuNs;
+        session->takeUsage(bytes, cpuNs);
+        Usage& usage = clients[session->peerPid()];
+        usage.bytes += bytes;
+        usage.cpuNs += cpuNs;
+    }
+
+    // Budgets are per second, scale them to the window.
+    quint64 window = m_budgetTimer.interval();
+    quint64 byteBudget = m_byteBudget * window / 1000;
+    quint64 cpuBudget = m_cpuBudget * window / 1000;
+    static const unsigned int MAX_THROTTLE = 64;
+
+    for (QMap<qint64, Usage>::const_iterator it = clients.constBegin(); it != clients.constEnd(); ++it)
+    {
+        const Usage& usage = it.value();
+        bool over = (byteBudget && usage.bytes > byteBudget) || (cpuBudget && usage.cpuNs > cpuBudget);
+        bool under = (!byteBudget || usage.bytes < byteBudget / 2) && (!cpuBudget || usage.cpuNs < cpuBudget / 2);
+        if (!over && !under)
+            continue;
+
+        for (int i = 0; i < m_sessions.size(); ++i)
+        {
+            SessionData* session = m_sessions.at(i);
+            if (session->peerPid() != it.key())
+                continue;
+            unsigned int throttle = session->getThrottle();
+            if (over && throttle < MAX_THROTTLE)
+            {
+                sensordLogW() << "[SocketHandler]: client " << it.key() << " over budget (" << usage.bytes << " bytes, "
+                              << usage.cpuNs / 1000 << " us), throttling session " << m_sessions.idAt(i) << " by " << throttle * 2;
+                session->setThrottle(throttle * 2);
+            }
+            else if (under && throttle > 1)
+            {
+                session->setThrottle(throttle / 2);
+            }
+        }
+    }
+}
+
+void SocketHandler::readMultiplexRequests(QLocalSocket* socket)
+{
+    while (socket->bytesAvailable() >= (qint64)sizeof(SessionRequest)) {
+        char data[sizeof(SessionRequest)];
+        socket->read(data, sizeof(data));
+        SessionRequest request;
+        sessionRequestDecode(data, sizeof(data), request);
+
+        if (request.sessionId < 0 || request.transport != SESSION_MULTIPLEX_REQUEST) {
+            sensordLogW() << "[SocketHandler]: Invalid request on multiplexed socket.";
+            continue;
+        }
+        if (m_sessions.contains(request.sessionId)) {
+            sensordLogW() << "[SocketHandler]: Session " << request.sessionId << " already connected.";
+            continue;
+        }
+        sensordLogD() << "[SocketHandler]: Session " << request.sessionId << " attached to multiplexed socket";
+        createSession(socket, request.sessionId)->setMultiplexed(true);
+    }
+}
+
+void SocketHandler::multiplexReadable()
+{
+    readMultiplexRequests((QLocalSocket*)sender());
+}
+
 void SocketHandler::newConnection()
 {
     sensordLogT() << "[SocketHandler]: New connection received.";
 
     while (m_server->hasPendingConnections()) {
+        acceptSocket(m_server->nextPendingConnection());
+    }
+}
 
-        QLocalSocket* socket = m_server->nextPendingConnection();
-        connect(socket, SIGNAL(readyRead()), this, SLOT(socketReadable()));
-        connect(socket, SIGNAL(disconnected()), this, SLOT(socketDisconnected()));
-        connect(socket, SIGNAL(error(QLocalSocket::LocalSocketError)), this, SLOT(socketError(QLocalSocket::LocalSocketError)));
+void SocketHandler::newSeqPacketConnection()
+{
+    sensordLogT() << "[SocketHandler]: New packet connection received.";
 
-        // Initialize socket
-        socket->write("\n", 1);
-        socket->waitForBytesWritten();
+    int fd;
+    while ((fd = accept4(m_seqPacketFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+        QLocalSocket* socket = new QLocalSocket(this);
+        if (!socket->setSocketDescriptor(fd, QLocalSocket::ConnectedState, QIODevice::ReadWrite)) {
+            sensordLogW() << "[SocketHandler]: Failed to use packet connection: " << socket->errorString();
+            delete socket;
+            close(fd);
+            continue;
+        }
+        acceptSocket(socket);
     }
+    if (errno != EAGAIN && errno != EWOULDBLOCK)
+        sensordLogW() << "[SocketHandler]: Failed to accept packet connection: " << strerror(errno);
+}
+
+void SocketHandler::acceptSocket(QLocalSocket* socket)
+{
+    connect(socket, SIGNAL(readyRead()), this, SLOT(socketReadable()));
+    connect(socket, SIGNAL(disconnected()), this, SLOT(socketDisconnected()));
+    connect(socket, SIGNAL(error(QLocalSocket::LocalSocketError)), this, SLOT(socketError(QLocalSocket::LocalSocketError)));
+
+    // Initialize socket
+    socket->write(&SESSION_GREETING, 1);
+    socket->waitForBytesWritten();
 }
 
 void SocketHandler::socketReadable()
 {
-    int sessionId = -1;
     QLocalSocket* socket = (QLocalSocket*)sender();
-    ((QLocalSocket*)sender())->read((char*)&sessionId, sizeof(int));
+
+    // Clients asking for shared memory send the request right after the
+    // session ID in the same write. Older clients send just the ID.
+    char data[sizeof(SessionRequest)];
+    qint64 size = socket->read(data, sizeof(data));
+    SessionRequest request;
+    sessionRequestDecode(data, size > 0 ? size : 0, request);
+    int sessionId = request.sessionId;
 
     disconnect(socket, SIGNAL(readyRead()), this, SLOT(socketReadable()));
 
     if (sessionId >= 0) {
-        if(!m_idMap.contains(sessionId))
-            m_idMap.insert(sessionId, new SessionData((QLocalSocket*)sender(), this));
+        if (request.transport == SESSION_MULTIPLEX_REQUEST) {
+            if (m_sessions.contains(sessionId)) {
+                sensordLogW() << "[SocketHandler]: Session " << sessionId << " already connected. Closing socket.";
+                socket->abort();
+                return;
+            }
+            sensordLogD() << "[SocketHandler]: Session " << sessionId << " opened multiplexed socket";
+            createSession(socket, sessionId)->setMultiplexed(true);
+            m_multiplexSockets.insert(socket);
+            socket->write(&SESSION_MULTIPLEX_ACCEPTED, 1);
+            connect(socket, SIGNAL(readyRead()), this, SLOT(multiplexReadable()));
+            readMultiplexRequests(socket);
+            return;
+        }
+
+        int ringFd = -1;
+        if(!m_sessions.contains(sessionId))
+        {
+            SessionData* session = createSession(socket, sessionId);
+            if (request.transport == SHARED_RING_REQUEST)
+                ringFd = session->createSharedRing();
+        }
+        if (request.transport == SHARED_RING_REQUEST) {
+            sensordLogD() << "[SocketHandler]: Session " << sessionId << " uses shared memory transport: " << (ringFd >= 0);
+            bool sent = sendSharedRing(socket, ringFd);
+            if (ringFd >= 0)
+                close(ringFd);
+            if (!sent)
+                socket->abort();
+        }
     } else {
         sensordLogC() << "[SocketHandler]: Failed to read valid session ID from client. Closing socket.";
         socket->abort();
@@ -324,11 +1570,27 @@ void SocketHandler::socketDisconnected()
 {
     QLocalSocket* socket = (QLocalSocket*)sender();
 
-    int sessionId = -1;
-    for(QMap<int, SessionData*>::const_iterator it = m_idMap.constBegin(); it != m_idMap.constEnd(); ++it)
-    {
-        if(it.value()->getSocket() == socket)
-            sessionId = it.key();
+    int sessionId = m_socketIdMap.value(socket, -1);
+
+    if (m_multiplexSockets.contains(socket)) {
+        // All sessions carried by the socket are lost at once. The socket
+        // is owned by none of them, so it is released here.
+        QList<int> sessions;
+        for(int i = 0; i < m_sessions.size(); ++i)
+        {
+            if(m_sessions.at(i)->getSocket() == socket)
+                sessions.append(m_sessions.idAt(i));
+        }
+        m_multiplexSockets.remove(socket);
+        foreach (int id, sessions) {
+            sensordLogW() << "[SocketHandler]: Noticed lost multiplexed session: " << id;
+            emit lostSession(id);
+            if (m_sessions.contains(id))
+                removeSession(id);
+        }
+        disconnect(socket, 0, this, 0);
+        socket->deleteLater();
+        return;
     }
 
     if (sessionId == -1) {
@@ -348,39 +1610,56 @@ void SocketHandler::socketError(QLocalSocket::LocalSocketError socketError)
 
 int SocketHandler::getSocketFd(int sessionId) const
 {
-    QMap<int, SessionData*>::const_iterator it = m_idMap.find(sessionId);
-    if (it != m_idMap.end() && (*it)->getSocket())
-        return (*it)->getSocket()->socketDescriptor();
+    if (forward()) {
+        int result = 0;
+        QMetaObject::invokeMethod(const_cast<SocketHandler*>(this), "getSocketFd", Qt::BlockingQueuedConnection, Q_RETURN_ARG(int, result), Q_ARG(int, sessionId));
+        return result;
+    }
+    SessionData* session = m_sessions.value(sessionId);
+    if (session && session->getSocket())
+        return session->getSocket()->socketDescriptor();
     return 0;
 }
 
 void SocketHandler::setInterval(int sessionId, int value)
 {
-    QMap<int, SessionData*>::iterator it = m_idMap.find(sessionId);
-    if (it != m_idMap.end())
-        (*it)->setInterval(value);
+    if (forward()) {
+        QMetaObject::invokeMethod(this, "setInterval", Qt::QueuedConnection, Q_ARG(int, sessionId), Q_ARG(int, value));
+        return;
+    }
+    SessionData* session = m_sessions.value(sessionId);
+    if (session)
+        session->setInterval(value);
 }
 
 void SocketHandler::clearInterval(int sessionId)
 {
-    QMap<int, SessionData*>::iterator it = m_idMap.find(sessionId);
-    if (it != m_idMap.end())
-        (*it)->setInterval(-1);
+    if (forward()) {
+        QMetaObject::invokeMethod(this, "clearInterval", Qt::QueuedConnection, Q_ARG(int, sessionId));
+        return;
+    }
+    SessionData* session = m_sessions.value(sessionId);
+    if (session)
+        session->setInterval(-1);
 }
 
 int SocketHandler::interval(int sessionId) const
 {
-    QMap<int, SessionData*>::const_iterator it = m_idMap.find(sessionId);
-    if (it != m_idMap.end())
-        return (*it)->getInterval();
+    SessionData* session = m_sessions.value(sessionId);
+    if (session)
+        return session->getInterval();
     return 0;
 }
 
 void SocketHandler::setBufferSize(int sessionId, unsigned int value)
 {
-    QMap<int, SessionData*>::iterator it = m_idMap.find(sessionId);
-    if (it != m_idMap.end())
-        (*it)->setBufferSize(value);
+    if (forward()) {
+        QMetaObject::invokeMethod(this, "setBufferSize", Qt::QueuedConnection, Q_ARG(int, sessionId), Q_ARG(unsigned int, value));
+        return;
+    }
+    SessionData* session = m_sessions.value(sessionId);
+    if (session)
+        session->setBufferSize(value);
 }
 
 void SocketHandler::clearBufferSize(int sessionId)
@@ -390,17 +1669,21 @@ void SocketHandler::clearBufferSize(int sessionId)
 
 unsigned int SocketHandler::bufferSize(int sessionId) const
 {
-    QMap<int, SessionData*>::const_iterator it = m_idMap.find(sessionId);
-    if (it != m_idMap.end())
-        return (*it)->getBufferSize();
+    SessionData* session = m_sessions.value(sessionId);
+    if (session)
+        return session->getBufferSize();
     return 0;
 }
 
 void SocketHandler::setBufferInterval(int sessionId, unsigned int value)
 {
-    QMap<int, SessionData*>::iterator it = m_idMap.find(sessionId);
-    if (it != m_idMap.end())
-        (*it)->setBufferInterval(value);
+    if (forward()) {
+        QMetaObject::invokeMethod(this, "setBufferInterval", Qt::QueuedConnection, Q_ARG(int, sessionId), Q_ARG(unsigned int, value));
+        return;
+    }
+    SessionData* session = m_sessions.value(sessionId);
+    if (session)
+        session->setBufferInterval(value);
 }
 
 void SocketHandler::clearBufferInterval(int sessionId)
@@ -410,23 +1693,114 @@ void SocketHandler::clearBufferInterval(int sessionId)
 
 unsigned int SocketHandler::bufferInterval(int sessionId) const
 {
-    QMap<int, SessionData*>::const_iterator it = m_idMap.find(sessionId);
-    if (it != m_idMap.end())
-        return (*it)->getBufferInterval();
+    SessionData* session = m_sessions.value(sessionId);
+    if (session)
+        return session->getBufferInterval();
     return 0;
 }
 
+void SocketHandler::setBurstInterval(unsigned int interval)
+{
+    if (forward()) {
+        QMetaObject::invokeMethod(this, "setBurstInterval", Qt::QueuedConnection, Q_ARG(unsigned int, interval));
+        return;
+    }
+    m_burstInterval = interval;
+    for (int i = 0; i < m_sessions.size(); ++i)
+        m_sessions.at(i)->setBurstInterval(interval);
+}
+
+void SocketHandler::reserveSessionBlocks(int count, unsigned int maxBytes)
+{
+    if (forward()) {
+        QMetaObject::invokeMethod(this, "reserveSessionBlocks", Qt::BlockingQueuedConnection,
+                                  Q_ARG(int, count), Q_ARG(unsigned int, maxBytes));
+        return;
+    }
+    m_blockPool.reserve(count, maxBytes);
+}
+
+void SocketHandler::addDropped(int sessionId, unsigned int count)
+{
+    SessionData* session = m_sessions.value(sessionId);
+    if (session)
+        session->addDropped(count);
+}
+
+unsigned int SocketHandler::droppedSamples(int sessionId) const
+{
+    if (forward()) {
+        unsigned int result = 0;
+        QMetaObject::invokeMethod(const_cast<SocketHandler*>(this), "droppedSamples", Qt::BlockingQueuedConnection, Q_RETURN_ARG(unsigned int, result), Q_ARG(int, sessionId));
+        return result;
+    }
+    SessionData* session = m_sessions.value(sessionId);
+    if (session)
+        return session->getDropped();
+    return 0;
+}
+
+QStringList SocketHandler::sessionStatistics() const
+{
+    if (forward()) {
+        QStringList result;
+        QMetaObject::invokeMethod(const_cast<SocketHandler*>(this), "sessionStatistics", Qt::BlockingQueuedConnection, Q_RETURN_ARG(QStringList, result));
+        return result;
+    }
+    QStringList lines;
+    for (int i = 0; i < m_sessions.size(); ++i)
+        lines << m_sessions.at(i)->statistics();
+    return lines;
+}
+
+void SocketHandler::setHighWaterMark(int sessionId, qint64 bytes, unsigned int samples)
+{
+    SessionData* session = m_sessions.value(sessionId);
+    if (session)
+        session->setHighWaterMark(bytes, samples);
+}
+
+void SocketHandler::setBackpressurePolicy(int sessionId, SessionData::BackpressurePolicy policy)
+{
+    SessionData* session = m_sessions.value(sessionId);
+    if (session)
+        session->setBackpressurePolicy(policy);
+}
+
+void SocketHandler::setPriority(int sessionId, SessionData::Priority priority)
+{
+    if (forward()) {
+        QMetaObject::invokeMethod(this, "setPriority", Qt::QueuedConnection, Q_ARG(int, sessionId), Q_ARG(SessionData::Priority, priority));
+        return;
+    }
+    SessionData* session = m_sessions.value(sessionId);
+    if (session)
+        session->setPriority(priority);
+}
+
+void SocketHandler::setFrameClock(int sessionId, unsigned int period, quint64 phase, unsigned int lead)
+{
+    if (forward()) {
+        QMetaObject::invokeMethod(this, "setFrameClock", Qt::QueuedConnection, Q_ARG(int, sessionId), Q_ARG(unsigned int, period),
+                                  Q_ARG(quint64, phase), Q_ARG(unsigned int, lead));
+        return;
+    }
+    SessionData* session = m_sessions.value(sessionId);
+    if (session)
+        session->setFrameClock(period, phase, lead);
+}
+
 bool SocketHandler::downsampling(int sessionId) const
 {
-    QMap<int, SessionData*>::const_iterator it = m_idMap.find(sessionId);
-    if (it != m_idMap.end())
-        return (*it)->getBufferSize();
+    SessionData* session = m_sessions.value(sessionId);
+    if (session)
+        return session->getBufferSize();
     return 0;
 }
 
 void SocketHandler::setDownsampling(int sessionId, bool value)
 {
-    QMap<int, SessionData*>::iterator it = m_idMap.find(sessionId);
-    if (it != m_idMap.end())
-        (*it)->setBufferInterval(value);
+    SessionData* session = m_sessions.value(sessionId);
+    if (session)
+        session->setBufferInterval(value);
 }
@@ -30,32 +30,76 @@
 
 #include <QObject>
 #include <QMap>
+#include <QHash>
+#include <QSet>
 #include <QTimer>
 #include <QList>
 #include <QMutex>
 #include <QLocalSocket>
-#include <sys/time.h>
+#include "sessionblockpool.h"
+#include "flushwheel.h"
+#include "sessiontable.h"
 
 class QLocalServer;
+class QSocketNotifier;
+struct SharedRingHeader;
+struct SessionFrameTrace;
+struct SessionSend;
+struct iovec;
+struct timespec;
+class UringReactor;
 
 /**
  * Class contains data for single sensor session related data socket
  * connection.
  */
-class SessionData : public QObject
+class SessionData : public QObject, private FlushWheel::Entry
 {
     Q_OBJECT
     Q_DISABLE_COPY(SessionData)
 
 public:
+    /**
+     * What to do with new samples while the client is not keeping up
+     * and the socket has reached its high-water mark.
+     */
+    enum BackpressurePolicy
+    {
+        DropOldest = 0, /**< discard the oldest held sample */
+        DropNewest,     /**< discard the incoming sample */
+        CoalesceLatest  /**< keep only the latest sample */
+    };
+
+    /**
+     * Delivery priority class. Sessions of a higher class are written
+     * first in every delivery round, background sessions hit their
+     * high-water mark at a quarter of the configured bytes, so they
+     * start dropping before anybody else when sensord is loaded.
+     */
+    enum Priority
+    {
+        RealtimePriority = 0,    /**< latency critical, e.g. screen rotation */
+        InteractivePriority,     /**< default */
+        BackgroundPriority       /**< logging and other bulk consumers */
+    };
+
     /**
      * Constructor.
      *
      * @param socket Established socket connection. SessionData will take
      *               the ownership of it.
      * @param parent Parent object.
+     * @param id     Session ID, used in tracepoints.
+     * @param pool   Pool for the sample buffer, or NULL to allocate it
+     *               from the heap. Must outlive the session.
+     * @param wheel  Timer wheel for delayed writes, or NULL to use a
+     *               wheel of the session's own. Must outlive the session.
+     * @param reactor io_uring reactor batching the writes of delivery
+     *                rounds, or NULL to write directly. Must outlive the
+     *                session.
      */
-    SessionData(QLocalSocket* socket, QObject* parent = 0);
+    SessionData(QLocalSocket* socket, QObject* parent = 0, int id = -1, SessionBlockPool* pool = NULL,
+                FlushWheel* wheel = NULL, UringReactor* reactor = NULL);
 
     /**
      * Destructor.
@@ -67,9 +111,47 @@ public:
      *
      * @param source Source from where to write.
      * @param size How many bytes to write from source.
+     * @param trace stage timestamps of the sample, if tracing.
      * @return was data succesfully written.
      */
-    bool write(const void* source, int size);
+    bool write(const void* source, int size, const SessionFrameTrace* trace = NULL);
+
+    /**
+     * Enable or disable latency tracing. Frames written to a traced
+     * session carry a SessionFrameTrace with the stage timestamps of
+     * their newest sample. Not supported with shared memory transport.
+     *
+     * @param value should frames be traced.
+     */
+    void setTracing(bool value);
+
+    /**
+     * Enable or disable the compact frame encoding. Frames of several
+     * samples are then written with delta encoded timestamps and values
+     * narrowed to 16 bits where they fit, see SessionCompactHeader.
+     * Frames which would not get smaller are written as they are. Not
+     * supported with shared memory transport.
+     *
+     * @param value should frames be compacted.
+     * @return was the setting applied.
+     */
+    bool setCompactFormat(bool value);
+
+    /**
+     * Mark the session as one of several sessions carried by the same
+     * socket. Frames of a multiplexed session are preceded by the
+     * session ID, and the socket is not owned by the session.
+     *
+     * @param value is the socket shared with other sessions.
+     */
+    void setMultiplexed(bool value);
+
+    /**
+     * Is the socket shared with other sessions.
+     *
+     * @return is session multiplexed.
+     */
+    bool isMultiplexed() const;
 
     /**
      * Get used local socket pointer.
@@ -83,6 +165,8 @@ public:
      * from SessionData.
      *
      * @return local socket or NULL if connection is closed or stolen.
+     *         Shared socket of a multiplexed session is never handed
+     *         over, NULL is returned instead.
      */
     QLocalSocket* stealSocket();
 
@@ -131,6 +215,17 @@ public:
      */
     unsigned int getBufferInterval() const;
 
+    /**
+     * Set burst interval used while the display is off. Samples are
+     * then held until the interval elapses or the buffer fills up, and
+     * written out as a single frame, regardless of the buffer size and
+     * interval requested by the client. Held samples are written out
+     * when burst mode is turned off.
+     *
+     * @param interval interval in milliseconds, 0 to turn burst mode off.
+     */
+    void setBurstInterval(unsigned int interval);
+
     /**
      * Enable or disable downsampling. Downsampling is implemented by
      * just dropping extra samples.
@@ -146,52 +241,359 @@ public:
      */
     bool getDownsampling() const;
 
+    /**
+     * Write buffered samples to the socket as a single frame.
+     *
+     * @return was writing to socket succesful.
+     */
+    bool flush();
+
+    /**
+     * Switch the session to the shared memory transport. A memfd backed
+     * ring is created and mapped; after this samples are written into
+     * the ring and only a single doorbell byte per frame goes through
+     * the socket.
+     *
+     * @return file descriptor of the ring to be passed to the client,
+     *         or -1 on failure. Caller owns the descriptor.
+     */
+    int createSharedRing();
+
+    /**
+     * Account samples which were dropped before reaching the session.
+     * The sequence number of the next frame is advanced accordingly so
+     * that the client can notice the loss.
+     *
+     * @param count number of dropped samples.
+     */
+    void addDropped(unsigned int count);
+
+    /**
+     * Get number of samples dropped for the session.
+     *
+     * @return dropped sample count.
+     */
+    unsigned int getDropped() const;
+
+    /**
+     * Set high-water marks for the session. When more than given amount
+     * of bytes is waiting to be written to the socket no more frames are
+     * written until the client catches up. Meanwhile at most given
+     * amount of samples are held and the backpressure policy decides
+     * which ones are kept.
+     *
+     * @param bytes byte limit for the socket write queue. Zero disables.
+     * @param samples how many samples to hold while the socket is full.
+     */
+    void setHighWaterMark(qint64 bytes, unsigned int samples);
+
+    /**
+     * Set backpressure policy.
+     *
+     * @param policy policy to use.
+     */
+    void setBackpressurePolicy(BackpressurePolicy policy);
+
+    /**
+     * Get backpressure policy.
+     *
+     * @return used policy.
+     */
+    BackpressurePolicy getBackpressurePolicy() const;
+
+    /**
+     * How many times the session has hit its high-water mark.
+     *
+     * @return number of congestion periods.
+     */
+    unsigned int getCongestionCount() const;
+
+    /**
+     * Format counters of the session into a single line in the format
+     * of NodeStatistics: samples written, dropped, held in the buffer,
+     * bytes waiting in the socket and congestion periods.
+     *
+     * @return counters as text.
+     */
+    QString statistics() const;
+
+    /**
+     * Process ID of the client at the other end of the socket, read
+     * with <tt>SO_PEERCRED</tt> when the session was created.
+     *
+     * @return client PID, 0 if not known.
+     */
+    qint64 peerPid() const;
+
+    /**
+     * Enable measuring thread CPU time spent writing to the session.
+     *
+     * @param value measure CPU time.
+     */
+    void setCpuAccounting(bool value);
+
+    /**
+     * Get and reset usage accounted since the previous call.
+     *
+     * @param bytes bytes written to the client.
+     * @param cpuNs CPU time spent writing in nanoseconds.
+     */
+    void takeUsage(quint64& bytes, quint64& cpuNs);
+
+    /**
+     * Pass only every factor-th sample to the session, widening its
+     * effective interval. Used to hold a client within its budget.
+     *
+     * @param factor throttle factor, 1 passes every sample.
+     */
+    void setThrottle(unsigned int factor);
+
+    /**
+     * Get throttle factor.
+     *
+     * @return throttle factor.
+     */
+    unsigned int getThrottle() const;
+
+    /**
+     * Set delivery priority class.
+     *
+     * @param priority priority class.
+     */
+    void setPriority(Priority priority);
+
+    /**
+     * Get delivery priority class.
+     *
+     * @return priority class.
+     */
+    Priority getPriority() const;
+
+    /**
+     * Deliver in step with a display frame clock. Instead of every
+     * sample, only the newest one received since the previous frame is
+     * written, shortly before each vsync. Buffering, downsampling and
+     * delayed writes do not apply meanwhile.
+     *
+     * @param period frame period in microseconds, 0 to stop.
+     * @param phase time of any vsync, CLOCK_MONOTONIC microseconds.
+     * @param lead how long before the vsync the sample is written,
+     *             microseconds. Ignored unless less than the period.
+     */
+    void setFrameClock(unsigned int period, quint64 phase, unsigned int lead);
+
+Q_SIGNALS:
+    /**
+     * Emitted once when samples are waiting to be flushed. The flush is
+     * left to the SocketHandler so that all sessions with pending data
+     * can be written in one go.
+     */
+    void flushRequested();
+
 private:
     /**
-     * How many milliseconds since last time data was written to socket.
+     * Is a sample due for a downsampling session. Output slots are
+     * spaced by the interval on the sample timestamps, which are on
+     * CLOCK_MONOTONIC, and keep their phase: a sample is passed when it
+     * reaches the next slot, give or take an eighth of the interval of
+     * timestamp jitter, and the slot after that is one interval later.
+     * After a gap or a jump back in time the slots lock to the sample.
      *
-     * @return How many milliseconds since last time data was
-     *         written to socket.
+     * @param source sample.
+     * @param size size of the sample.
+     * @return should sample be written.
      */
-    long sinceLastWrite() const;
+    bool downsampleDue(const void* source, int size);
 
     /**
-     * Write data directly to the socket.
+     * Write data directly to the socket. The frame header and the
+     * samples are gathered with a single sendmsg() call without copying
+     * them together. If the socket can not take everything right away
+     * the remainder is handed to QLocalSocket, which writes it once the
+     * socket becomes writable, so the event loop is never blocked.
      *
      * @param source Source from where to write.
      * @param size How many bytes to write.
      * @param count How many data elements are written.
      */
-    bool write(void* source, int size, unsigned int count);
+    bool write(const char* source, int size, unsigned int count);
 
     /**
-     * Delayed write invocation.
+     * Handle the result of sending a frame: hand an unsent remainder to
+     * QLocalSocket, or drop the frame of a packet socket.
      *
-     * @return was writing to socket succesful.
+     * @param iov pieces of the frame.
+     * @param pieces number of pieces.
+     * @param total frame size in bytes.
+     * @param count number of samples in the frame.
+     * @param written bytes sent, or negative errno.
+     * @return was the frame written or queued.
+     */
+    bool finishWrite(const struct iovec* iov, int pieces, int total, unsigned int count, int written);
+
+    /**
+     * Queue a frame to the io_uring batch of the delivery round. The
+     * result is handled by #finishWrite() when the batch completes.
+     *
+     * @param iov pieces of the frame.
+     * @param pieces number of pieces.
+     * @param total frame size in bytes.
+     * @param count number of samples in the frame.
+     * @return was the frame queued.
+     */
+    bool queueSend(const struct iovec* iov, int pieces, int total, unsigned int count);
+
+    /**
+     * Account thread CPU time used since a point.
+     *
+     * @param start thread CPU time at the point.
+     */
+    void addCpuTime(const struct timespec& start);
+
+    /**
+     * Write samples into the shared memory ring and ring the doorbell.
+     *
+     * @param source Source from where to write.
+     * @param size Size of single element.
+     * @param count How many data elements are written.
+     */
+    bool writeShared(const char* source, int size, unsigned int count);
+
+    /**
+     * Request flush from the SocketHandler unless already requested.
+     */
+    void requestFlush();
+
+    /**
+     * (Re)allocate sample buffer for current element size and buffer size.
+     * The sample buffer and the compact buffer share one block.
+     */
+    void allocateBuffer();
+
+    /**
+     * Give the sample buffer back. Buffered samples must have been
+     * flushed or discarded.
+     */
+    void releaseBuffer();
+
+    /**
+     * Size the socket send buffer for the sample size, interval and
+     * buffering of the session, so that samples written while the client
+     * lags behind by up to <tt>global/session_send_buffer_latency</tt>
+     * fit without blocking.
+     */
+    void updateSendBuffer();
+
+    /**
+     * Arm the frame timer for the next write point, unless armed.
+     */
+    void scheduleFrame();
+
+    /**
+     * Is the client too far behind to write more to the socket.
+     *
+     * @return has the socket write queue reached the high-water mark.
+     */
+    bool congested() const;
+
+    /**
+     * Throw away buffered samples and account them as dropped.
      */
-    bool delayedWrite();
+    void discardBuffered();
+
+    /**
+     * Adapt the batch of an unbuffered session to the socket backlog.
+     * The batch doubles while the previous frame is still queued when
+     * the next one is written, up to <tt>global/session_adaptive_batch</tt>,
+     * and halves once the client has kept up for a while.
+     */
+    void adaptBatch();
 
     QLocalSocket* socket;        /**< socket pointer. */
     int interval;                /**< interval in milliseconds. */
     char* buffer;                /**< pointer to buffer allocation. */
-    int size;                    /**< allocated buffer size. */
+    int size;                    /**< size of single element in the buffer. */
+    unsigned int capacity;       /**< how many elements fit into the buffer */
     unsigned int count;          /**< how many elements are in the buffer */
-    struct timeval lastWrite;    /**< when data was written last time */
-    QTimer timer;                /**< timer for delayed write */
+    bool flushRequested_;        /**< has flush been requested */
+    quint64 nextDue;             /**< timestamp of the next downsampling slot, 0 if not locked */
+    FlushWheel* wheel;           /**< timer wheel for delayed write */
+    unsigned int flushSlack;     /**< allowed delayed write lateness, percent of the delay */
     unsigned int bufferSize;     /**< buffer size */
     unsigned int bufferInterval; /**< buffer interval in milliseconds */
+    unsigned int burstInterval;  /**< display-off burst interval in milliseconds, 0 when off */
     bool downsampling;           /**< sample dropping */
+    SharedRingHeader* ring;      /**< shared memory ring or NULL */
+    unsigned int sequence;       /**< sequence number of the next sample */
+    unsigned int dropped;        /**< number of dropped samples */
+    qint64 highWaterBytes;       /**< socket write queue limit */
+    unsigned int highWaterSamples; /**< samples held while congested */
+    BackpressurePolicy policy;   /**< backpressure policy */
+    bool congestedState;         /**< is session currently congested */
+    unsigned int congestionCount; /**< how many times got congested */
+    int id;                      /**< session ID */
+    bool tracing;                /**< are frames traced */
+    bool multiplexed;            /**< is socket shared with other sessions */
+    bool compact;                /**< are frames compacted */
+    char* compactBuffer;         /**< compacted samples of the frame being written */
+    SessionBlockPool* pool;      /**< pool of the buffer block, or NULL */
+    unsigned int blockSize;      /**< size of the buffer block */
+    unsigned long long traceQueued;    /**< newest sample queued */
+    unsigned long long traceDelivered; /**< newest sample delivered */
+    qint64 pid;                  /**< client process ID */
+    bool cpuAccounting;          /**< is CPU time measured */
+    quint64 usedBytes;           /**< bytes written since takeUsage() */
+    quint64 usedCpuNs;           /**< CPU time since takeUsage() */
+    unsigned int throttle;       /**< throttle factor */
+    unsigned int throttleCount;  /**< samples seen while throttled */
+    Priority priority;           /**< delivery priority class */
+    bool seqPacket;              /**< does socket keep frame boundaries */
+    unsigned int sendBufferLatency; /**< client lag covered by the send buffer, ms, 0 if not sized */
+    int sendBufferMax;           /**< largest automatic send buffer */
+    int sendBuffer;              /**< send buffer size applied, 0 if kernel default */
+    unsigned int framePeriod;    /**< frame clock period, microseconds, 0 if off */
+    quint64 framePhase;          /**< frame clock vsync time, microseconds */
+    unsigned int frameLead;      /**< write point before vsync, microseconds */
+    QTimer frameTimer;           /**< timer for the next frame clock write point */
+    unsigned int adaptiveLimit;  /**< largest adaptive batch, 1 if not adaptive */
+    unsigned int adaptiveBatch;  /**< samples per frame of an unbuffered session */
+    unsigned int drainedFlushes; /**< flushes in a row finding the socket drained */
+    UringReactor* reactor;       /**< batches socket writes, or NULL */
+    SessionSend* pendingSend;    /**< frame queued to the reactor, allocated on first use */
+
+    friend struct SessionSend;
+
+    /**
+     * Callback for delayed write deadline.
+     */
+    void expired();
 
 private slots:
 
     /**
-     * Callback for delayed write timer.
+     * Callback for socket having written data. Resumes writing once the
+     * client has caught up.
      */
-    void timerTimeout();
+    void socketBytesWritten();
+
+    /**
+     * Callback for frame clock write point.
+     */
+    void frameDue();
 };
 
 /**
- * Establishes and track session data connections.
+ * Establishes and track session data connections. Bytes written and,
+ * when a CPU budget is set, CPU time spent writing are accounted per
+ * client process. Clients exceeding <tt>global/client_byte_budget</tt>
+ * or <tt>global/client_cpu_budget</tt> have their sessions throttled
+ * until they are back within budget.
+ *
+ * With <tt>global/delivery_thread</tt> the handler and all session
+ * sockets live in a thread of their own. Calls made from other threads
+ * are then passed to that thread as queued invocations, waiting only
+ * for those returning a value, so DBus traffic in the main thread does
+ * not delay sample delivery.
  */
 class SocketHandler : public QObject
 {
@@ -199,6 +601,20 @@ class SocketHandler : public QObject
     Q_DISABLE_COPY(SocketHandler)
 
 public:
+    /**
+     * Work run in the thread of the handler, see #execute().
+     */
+    class Task
+    {
+    public:
+        virtual ~Task() {}
+
+        /**
+         * Run the task in the thread of the handler.
+         */
+        virtual void run() = 0;
+    };
+
     /**
      * Constructor.
      *
@@ -212,21 +628,63 @@ public:
     ~SocketHandler();
 
     /**
-     * Start to listen incoming connections.
+     * Start to listen incoming connections. When sensord was started by
+     * systemd socket activation, the socket passed by systemd is used
+     * instead of creating a new one.
      *
      * @param serverName Name to listen for connections.
      * @return was listening started succesfully.
      */
     bool listen(const QString& serverName);
 
+    /**
+     * Start to listen incoming connections on a SOCK_SEQPACKET socket
+     * as well. Sessions connected to it get every frame as one packet,
+     * and a frame which does not fit into the socket is dropped whole
+     * instead of being queued.
+     *
+     * @param path socket path.
+     * @return was listening started succesfully.
+     */
+    bool listenSeqPacket(const QString& path);
+
+    /**
+     * Run task in the thread of the handler and wait for it to finish.
+     * State shared with the delivery, such as per session state of the
+     * sensor channels, is changed this way from other threads.
+     *
+     * @param task task to run. Caller keeps ownership.
+     */
+    void execute(Task* task);
+
     /**
      * Write data to given session.
      *
      * @param id Session ID.
      * @param source Location from where to write.
      * @param size How many bytes to write.
+     * @param trace stage timestamps of the sample, if tracing.
      */
-    bool write(int id, const void* source, int size);
+    bool write(int id, const void* source, int size, const SessionFrameTrace* trace = NULL);
+
+    /**
+     * Enable or disable latency tracing for given session. For more
+     * details see #SessionData::setTracing(bool).
+     *
+     * @param sessionId Session ID.
+     * @param value should frames be traced.
+     */
+    Q_INVOKABLE void setTracing(int sessionId, bool value);
+
+    /**
+     * Enable or disable the compact frame encoding for given session.
+     * For more details see #SessionData::setCompactFormat(bool).
+     *
+     * @param sessionId Session ID.
+     * @param value should frames be compacted.
+     * @return was the setting applied.
+     */
+    Q_INVOKABLE bool setCompactFormat(int sessionId, bool value);
 
     /**
      * Close related socket connection for session.
@@ -234,7 +692,7 @@ public:
      * @param sessionId Session ID.
      * @return was socket connection closed succesfully.
      */
-    bool removeSession(int sessionId);
+    Q_INVOKABLE bool removeSession(int sessionId);
 
     /**
      * Get socket file descriptor for given session.
@@ -242,7 +700,7 @@ public:
      * @param sessionId Session ID.
      * @return socket file descriptor.
      */
-    int getSocketFd(int sessionId) const;
+    Q_INVOKABLE int getSocketFd(int sessionId) const;
 
     /**
      * Set interval for given session. For more details see
@@ -251,14 +709,14 @@ public:
      * @param sessionId Session ID.
      * @param value Interval in milliseconds.
      */
-    void setInterval(int sessionId, int value);
+    Q_INVOKABLE void setInterval(int sessionId, int value);
 
     /**
      * Remove set interval from given session.
      *
      * @param sessionId Session ID.
      */
-    void clearInterval(int sessionId);
+    Q_INVOKABLE void clearInterval(int sessionId);
 
     /**
      * Get interval for given session. For more details see
@@ -276,7 +734,7 @@ public:
      * @param sessionId Session ID.
      * @param value buffer size.
      */
-    void setBufferSize(int sessionId, unsigned int value);
+    Q_INVOKABLE void setBufferSize(int sessionId, unsigned int value);
 
     /**
      * Remove set buffer size for given session.
@@ -301,7 +759,7 @@ public:
      * @param sessionId Session ID.
      * @param value buffer inteval in milliseconds.
      */
-    void setBufferInterval(int sessionId, unsigned int value);
+    Q_INVOKABLE void setBufferInterval(int sessionId, unsigned int value);
 
     /**
      * Remove set buffer inteval for given session.
@@ -319,6 +777,87 @@ public:
      */
     unsigned int bufferInterval(int sessionId) const;
 
+    /**
+     * Set burst interval of all sessions, also applied to sessions
+     * created later. For more details see
+     * #SessionData::setBurstInterval(unsigned int).
+     *
+     * @param interval interval in milliseconds, 0 to turn burst mode off.
+     */
+    Q_INVOKABLE void setBurstInterval(unsigned int interval);
+
+    /**
+     * Fill the pool of session buffers with resident blocks. For more
+     * details see #SessionBlockPool::reserve(int, unsigned int).
+     *
+     * @param count blocks of each size class.
+     * @param maxBytes size of the largest class to fill.
+     */
+    Q_INVOKABLE void reserveSessionBlocks(int count, unsigned int maxBytes);
+
+    /**
+     * Account samples dropped for given session. For more details see
+     * #SessionData::addDropped(unsigned int).
+     *
+     * @param sessionId Session ID.
+     * @param count number of dropped samples.
+     */
+    void addDropped(int sessionId, unsigned int count);
+
+    /**
+     * Get number of samples dropped for given session.
+     *
+     * @param sessionId Session ID.
+     * @return dropped sample count.
+     */
+    Q_INVOKABLE unsigned int droppedSamples(int sessionId) const;
+
+    /**
+     * Counters of all sessions, one line per session. For more details
+     * see #SessionData::statistics().
+     *
+     * @return counters as text.
+     */
+    Q_INVOKABLE QStringList sessionStatistics() const;
+
+    /**
+     * Set high-water marks for given session. For more details see
+     * #SessionData::setHighWaterMark(qint64, unsigned int).
+     *
+     * @param sessionId Session ID.
+     * @param bytes byte limit for the socket write queue.
+     * @param samples how many samples to hold while congested.
+     */
+    void setHighWaterMark(int sessionId, qint64 bytes, unsigned int samples);
+
+    /**
+     * Set backpressure policy for given session.
+     *
+     * @param sessionId Session ID.
+     * @param policy policy to use.
+     */
+    void setBackpressurePolicy(int sessionId, SessionData::BackpressurePolicy policy);
+
+    /**
+     * Set delivery priority class for given session. For more details
+     * see #SessionData::Priority.
+     *
+     * @param sessionId Session ID.
+     * @param priority priority class.
+     */
+    Q_INVOKABLE void setPriority(int sessionId, SessionData::Priority priority);
+
+    /**
+     * Set display frame clock of given session. For more details see
+     * #SessionData::setFrameClock().
+     *
+     * @param sessionId Session ID.
+     * @param period frame period in microseconds, 0 to stop.
+     * @param phase time of any vsync, CLOCK_MONOTONIC microseconds.
+     * @param lead write point before vsync, microseconds.
+     */
+    Q_INVOKABLE void setFrameClock(int sessionId, unsigned int period, quint64 phase, unsigned int lead);
+
     /**
      * Is downsampling enabled for given session. For more details see
      * #SessionData::downsampling().
@@ -337,6 +876,19 @@ public:
      */
     void setDownsampling(int sessionId, bool value);
 
+    /**
+     * Start a delivery round which ends with #flushSessions(). Flushes
+     * requested during the round do not start the flush timer.
+     */
+    void beginDelivery();
+
+public slots:
+    /**
+     * Write buffered samples of all sessions which have requested
+     * flushing.
+     */
+    void flushSessions();
+
 Q_SIGNALS:
     /**
      * Signal is emitted for lost sessions which can happen for example
@@ -352,11 +904,22 @@ private slots:
      */
     void newConnection();
 
+    /**
+     * Callback for new client connection on the packet socket.
+     */
+    void newSeqPacketConnection();
+
     /**
      * Callback for new data in socket.
      */
     void socketReadable();
 
+    /**
+     * Callback for new data in multiplexed socket. Attach requests for
+     * further sessions are read.
+     */
+    void multiplexReadable();
+
     /**
      * Callback for disconnected client.
      */
@@ -369,10 +932,126 @@ private slots:
      */
     void socketError(QLocalSocket::LocalSocketError socketError);
 
+    /**
+     * Callback for exited client process. Sessions of the client are
+     * lost without waiting for their sockets to notice.
+     *
+     * @param fd pidfd of the client.
+     */
+    void clientExited(int fd);
+
+    /**
+     * Callback for session requesting flush.
+     */
+    void sessionFlushRequested();
+
+    /**
+     * Sum usage of the sessions of each client over the last budget
+     * window and widen or relax throttling of clients over or well
+     * under their budget.
+     */
+    void checkBudgets();
+
+    /**
+     * Run task passed from another thread by #execute().
+     *
+     * @param task task to run.
+     */
+    void runTask(void* task);
+
 private:
+    /**
+     * Should a call be passed to the thread of the handler. True when
+     * called from another thread while the handler thread is running.
+     *
+     * @return is caller in another thread.
+     */
+    bool forward() const;
+
+    /**
+     * Reply to shared memory transport request. The ring file
+     * descriptor is attached to the reply when available.
+     *
+     * @param socket Socket to reply to.
+     * @param fd Ring file descriptor or -1 if request was rejected.
+     * @return was reply sent.
+     */
+    bool sendSharedRing(QLocalSocket* socket, int fd);
+
+    /**
+     * Set up a new client connection and greet the client.
+     *
+     * @param socket Connected socket.
+     */
+    void acceptSocket(QLocalSocket* socket);
+
+    /**
+     * Create session for an established connection.
+     *
+     * @param socket Socket carrying the session.
+     * @param sessionId Session ID.
+     * @return created session.
+     */
+    SessionData* createSession(QLocalSocket* socket, int sessionId);
+
+    /**
+     * Read pending attach requests from a multiplexed socket and
+     * create the requested sessions.
+     *
+     * @param socket Multiplexed socket.
+     */
+    void readMultiplexRequests(QLocalSocket* socket);
+
+    /**
+     * Watch the client process of a session for exit with a pidfd.
+     * Nothing is watched on kernels without pidfd support.
+     *
+     * @param sessionId Session ID.
+     * @param pid client PID, 0 if not known.
+     */
+    void watchClient(int sessionId, qint64 pid);
+
+    /**
+     * Stop watching the client process for a session.
+     *
+     * @param sessionId Session ID.
+     * @param pid client PID.
+     */
+    void unwatchClient(int sessionId, qint64 pid);
+
+    /**
+     * Exit watch of a client process.
+     */
+    struct ClientWatch
+    {
+        ClientWatch() : fd(-1), notifier(NULL) {}
+
+        int              fd;       /**< pidfd of the client */
+        QSocketNotifier* notifier; /**< readable when the client exits */
+        QList<int>       sessions; /**< sessions of the client */
+    };
 
     QLocalServer*            m_server; /**< listening server socket. */
-    QMap<int, SessionData*>  m_idMap;  /**< map of client sessions. */
+    int                      m_seqPacketFd; /**< listening packet socket, -1 if none. */
+    QByteArray               m_seqPacketPath; /**< path of the packet socket. */
+    QSocketNotifier*         m_seqPacketNotifier; /**< notifier for packet socket connections. */
+    SessionTable<SessionData> m_sessions; /**< client sessions by session ID. */
+    QList<SessionData*>      m_flushList; /**< sessions waiting to be flushed. */
+    QSet<QLocalSocket*>      m_multiplexSockets; /**< sockets shared by several sessions. */
+    QHash<QLocalSocket*, int> m_socketIdMap; /**< session of each socket not shared. */
+    QHash<qint64, ClientWatch> m_clientWatches; /**< exit watches by client PID. */
+    QHash<int, qint64>       m_clientFds; /**< client PID of each pidfd. */
+    QTimer                   m_flushTimer; /**< timer for flushing at the end of event loop iteration. */
+    unsigned int             m_burstInterval; /**< burst interval of sessions in milliseconds. */
+    bool                     m_delivering; /**< is a delivery round in progress. */
+    SessionBlockPool         m_blockPool; /**< sample buffers of the sessions. */
+    FlushWheel               m_flushWheel; /**< delayed write deadlines of the sessions. */
+    UringReactor*            m_reactor; /**< batches the writes of a flush, or NULL. */
+    QTimer                   m_budgetTimer; /**< timer for checking client budgets. */
+    quint64                  m_byteBudget; /**< bytes per second allowed per client, 0 if unlimited. */
+    quint64                  m_cpuBudget; /**< CPU ns per second allowed per client, 0 if unlimited. */
 };
 
+Q_DECLARE_METATYPE(SessionData::Priority)
+
 #endif // SOCKETHANDLER_H
@@ -30,12 +30,30 @@
 
 bool SourceBase::join(SinkBase* sink)
 {
+    if (frozen_) {
+        sensordLogW() << "Trying to join sink to frozen source";
+        return false;
+    }
     joinTypeChecked(sink);
     return true;
 }
 
 bool SourceBase::unjoin(SinkBase* sink)
 {
+    if (frozen_) {
+        sensordLogW() << "Trying to unjoin sink from frozen source";
+        return false;
+    }
     unjoinTypeChecked(sink);
     return true;
 }
+
+void SourceBase::freeze()
+{
+    frozen_ = true;
+}
+
+bool SourceBase::isFrozen() const
+{
+    return frozen_;
+}
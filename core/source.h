@@ -31,8 +31,7 @@
 
 #include "sink.h"
 #include "logging.h"
-#include <typeinfo>
-#include <QSet>
+#include <QVector>
 
 class SinkBase;
 
@@ -42,6 +41,11 @@ class SinkBase;
 class SourceBase
 {
 public:
+    /**
+     * Constructor.
+     */
+    SourceBase() : frozen_(false) {}
+
     /**
      * Connect sink to the source.
      *
@@ -58,6 +62,27 @@ public:
      */
     bool unjoin(SinkBase* sink);
 
+    /**
+     * Freeze the connections of the source. After this sinks can not be
+     * joined or unjoined, so the sink list stays fixed while data flows.
+     */
+    void freeze();
+
+    /**
+     * Is the source frozen.
+     *
+     * @return is source frozen.
+     */
+    bool isFrozen() const;
+
+    /**
+     * Does any connected sink lead to a live consumer. Filters use this
+     * to skip computing outputs nobody reads.
+     *
+     * @return is data propagated from the source used.
+     */
+    virtual bool hasDemand() const = 0;
+
 protected:
     /**
      * Destructor.
@@ -80,10 +105,13 @@ private:
      * @return was sink unjoined.
      */
     virtual bool unjoinTypeChecked(SinkBase* sink) = 0;
+
+    bool frozen_; /**< are connections frozen */
 };
 
 /**
- * Data source.
+ * Data source. Connected sinks are kept in a flat array and called in
+ * the order they were joined.
  *
  * @tparam TYPE type of data streamed from the source.
  */
@@ -91,6 +119,21 @@ template <class TYPE>
 class Source : public SourceBase
 {
 public:
+    /**
+     * Constructor.
+     */
+    Source() : statistics_(NULL) {}
+
+    /**
+     * Count the outgoing samples into given statistics.
+     *
+     * @param statistics statistics of the owning node.
+     */
+    void setStatistics(NodeStatistics* statistics)
+    {
+        statistics_ = statistics;
+    }
+
     /**
      * Propagate data to connected sinks.
      *
@@ -99,36 +142,67 @@ public:
      */
     void propagate(int n, const TYPE* values)
     {
-        foreach (SinkTyped<TYPE>* sink, sinks_) {
-            sink->collect(n, values);
+        if (statistics_)
+            statistics_->addOutput(n);
+        SinkTyped<TYPE>* const* sinks = sinks_.constData();
+        for (int i = 0, count = sinks_.size(); i < count; ++i) {
+            sinks[i]->collect(n, values);
+        }
+    }
+
+    bool hasDemand() const
+    {
+        SinkTyped<TYPE>* const* sinks = sinks_.constData();
+        for (int i = 0, count = sinks_.size(); i < count; ++i) {
+            if (sinks[i]->hasDemand())
+                return true;
         }
+        return false;
     }
+
 private:
+    /**
+     * Cast sink to the type of the source, checked without RTTI.
+     *
+     * @param sink Sink.
+     * @return typed sink, or NULL if the types differ.
+     */
+    static SinkTyped<TYPE>* typed(SinkBase* sink)
+    {
+        if (sink->dataTypeKey() != DataType<TYPE>::key())
+            return NULL;
+        return static_cast<SinkTyped<TYPE>*>(sink);
+    }
+
     bool joinTypeChecked(SinkBase* sink)
     {
-        SinkTyped<TYPE>* type = dynamic_cast<SinkTyped<TYPE>*>(sink);
+        SinkTyped<TYPE>* type = typed(sink);
         if(type)
         {
-            sinks_.insert(type);
+            if (!sinks_.contains(type))
+                sinks_.append(type);
             return true;
         }
-        sensordLogC() << "Failed to join type '" << typeid(type).name() << " to source!";
+        sensordLogC() << "Failed to join sink of type '" << sink->dataTypeName() << "' to source of type '" << DataType<TYPE>::name() << "'!";
         return false;
     }
 
     bool unjoinTypeChecked(SinkBase* sink)
     {
-        SinkTyped<TYPE>* type = dynamic_cast<SinkTyped<TYPE>*>(sink);
+        SinkTyped<TYPE>* type = typed(sink);
         if(type)
         {
-            sinks_.remove(type);
+            int index = sinks_.indexOf(type);
+            if (index >= 0)
+                sinks_.remove(index);
             return true;
         }
-        sensordLogC() << "Failed to unjoin type '" << typeid(type).name() << " from source!";
+        sensordLogC() << "Failed to unjoin sink of type '" << sink->dataTypeName() << "' from source of type '" << DataType<TYPE>::name() << "'!";
         return false;
     }
 
-    QSet<SinkTyped<TYPE>*> sinks_; /**< connected sinks. */
+    QVector<SinkTyped<TYPE>*> sinks_;      /**< connected sinks in join order. */
+    NodeStatistics*           statistics_; /**< statistics of the owning node. */
 };
 
 #endif
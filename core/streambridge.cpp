@@ -0,0 +1,293 @@
+/**
+   @file streambridge.cpp
+   @brief StreamBridge
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "streambridge.h"
+#include "samplerecording.h"
+#include "threadscheduling.h"
+#include "config.h"
+#include "logging.h"
+#include <QThread>
+#include <QTimer>
+#include <QTcpSocket>
+#include <QUdpSocket>
+#include <QDateTime>
+#include <QStringList>
+
+/**
+ * Largest UDP frame, fits an Ethernet MTU without IP fragmentation.
+ */
+static const int MAX_DATAGRAM = 1400;
+
+/**
+ * Largest TCP frame.
+ */
+static const int MAX_TCP_FRAME = 65536;
+
+/**
+ * Unsent TCP bytes above which frames are dropped.
+ */
+static const qint64 MAX_UNSENT = 256 * 1024;
+
+/**
+ * Milliseconds between TCP connection attempts.
+ */
+static const qint64 RECONNECT_INTERVAL = 1000;
+
+class BridgeThread : public QThread
+{
+protected:
+    void run()
+    {
+        ThreadScheduling::apply("bridgethread");
+        exec();
+    }
+};
+
+StreamTap::StreamTap(quint32 type, quint32 sampleSize, unsigned int capacity, quint32 interval) :
+    type_(type),
+    sampleSize_(sampleSize),
+    interval_(interval),
+    writeCount_(0),
+    writeStart_(0),
+    readCount_(0)
+{
+    quint64 slots = 1;
+    while (slots < capacity)
+        slots <<= 1;
+    mask_ = slots - 1;
+    slots_ = new char[slots * sampleSize];
+}
+
+StreamTap::~StreamTap()
+{
+    delete[] slots_;
+}
+
+unsigned int StreamTap::take(QByteArray& out, unsigned int max, unsigned int& dropped)
+{
+    quint64 capacity = mask_ + 1;
+    quint64 end = __atomic_load_n(&writeCount_, __ATOMIC_ACQUIRE);
+    if (end - readCount_ > capacity) {
+        dropped += end - capacity - readCount_;
+        readCount_ = end - capacity;
+    }
+
+    quint64 count = qMin(end - readCount_, (quint64)max);
+    int offset = out.size();
+    out.resize(offset + count * sampleSize_);
+    char* copy = out.data() + offset;
+    for (quint64 n = 0; n < count; ++n)
+        memcpy(copy + n * sampleSize_, slots_ + ((readCount_ + n) & mask_) * sampleSize_, sampleSize_);
+
+    // Slots the writer has reached in the meantime may hold newer
+    // samples or a torn copy, leave them out.
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    quint64 writeStart = __atomic_load_n(&writeStart_, __ATOMIC_RELAXED);
+    quint64 valid = writeStart > capacity ? writeStart - capacity : 0;
+    quint64 skip = valid > readCount_ ? qMin(valid - readCount_, count) : 0;
+    if (skip) {
+        out.remove(offset, skip * sampleSize_);
+        dropped += skip;
+    }
+    readCount_ += count;
+    return count - skip;
+}
+
+StreamBridge* StreamBridge::create()
+{
+    Config* config = Config::configuration();
+    QString collector = config ? config->value<QString>("bridge/collector", "") : QString();
+    if (collector.isEmpty())
+        return NULL;
+
+    int colon = collector.lastIndexOf(':');
+    bool ok = false;
+    quint16 port = colon > 0 ? collector.mid(colon + 1).toUShort(&ok) : 0;
+    QString protocol = config->value<QString>("bridge/protocol", "tcp");
+    if (!ok || !port || (protocol != "tcp" && protocol != "udp")) {
+        sensordLogW() << "Invalid stream bridge collector " << collector << " or protocol " << protocol;
+        return NULL;
+    }
+    unsigned int latency = qMax(1u, config->value<unsigned int>("bridge/latency", 100));
+    QStringList adaptors = config->value<QStringList>("bridge/adaptors", QStringList());
+
+    sensordLogD() << "Streaming " << adaptors.join(",") << " to " << collector << " over " << protocol;
+    return new StreamBridge(collector.left(colon), port, protocol == "udp", latency, adaptors);
+}
+
+StreamBridge::StreamBridge(const QString& host, quint16 port, bool udp, unsigned int latency, const QStringList& adaptors) :
+    host_(host),
+    port_(port),
+    udp_(udp),
+    latency_(latency),
+    adaptors_(adaptors),
+    thread_(new BridgeThread),
+    timer_(NULL),
+    socket_(NULL),
+    lastConnect_(0),
+    framesSent_(0),
+    framesDropped_(0),
+    samplesDropped_(0)
+{
+    moveToThread(thread_);
+    thread_->start();
+    QMetaObject::invokeMethod(this, "start", Qt::QueuedConnection);
+}
+
+StreamBridge::~StreamBridge()
+{
+    QMetaObject::invokeMethod(this, "stop", Qt::BlockingQueuedConnection);
+    thread_->quit();
+    thread_->wait();
+    delete thread_;
+}
+
+bool StreamBridge::isSelected(const QString& id) const
+{
+    return adaptors_.contains(id);
+}
+
+void StreamBridge::addStream(const QString& name, StreamTap* tap)
+{
+    Stream stream;
+    stream.name = name.toUtf8();
+    stream.tap = tap;
+    stream.sequence = 0;
+    stream.dropped = 0;
+
+    QMutexLocker locker(&mutex_);
+    streams_.append(stream);
+}
+
+void StreamBridge::removeStream(StreamTap* tap)
+{
+    QMutexLocker locker(&mutex_);
+    for (int i = 0; i < streams_.size(); ++i) {
+        if (streams_.at(i).tap == tap) {
+            streams_.removeAt(i);
+            return;
+        }
+    }
+}
+
+unsigned int StreamBridge::tapCapacity(unsigned int interval) const
+{
+    // Four batching periods, so a late flush does not drop samples.
+    quint64 capacity = (quint64)latency_ * 4000 / (interval ? interval : 10000);
+    return qBound((quint64)64, capacity, (quint64)65536);
+}
+
+QStringList StreamBridge::report() const
+{
+    QMutexLocker locker(&mutex_);
+    return QStringList() << QString("stream bridge %1:%2: %3 streams, %4 frames sent, %5 frames dropped, %6 samples dropped")
+                            .arg(host_).arg(port_).arg(streams_.size())
+                            .arg(framesSent_).arg(framesDropped_).arg(samplesDropped_);
+}
+
+void StreamBridge::start()
+{
+    if (udp_)
+        socket_ = new QUdpSocket;
+    else
+        socket_ = new QTcpSocket;
+    timer_ = new QTimer;
+    connect(timer_, SIGNAL(timeout()), this, SLOT(flush()));
+    timer_->start(latency_);
+}
+
+void StreamBridge::stop()
+{
+    delete timer_;
+    timer_ = NULL;
+    delete socket_;
+    socket_ = NULL;
+}
+
+void StreamBridge::flush()
+{
+    if (socket_->state() == QAbstractSocket::UnconnectedState) {
+        qint64 now = QDateTime::currentMSecsSinceEpoch();
+        if (now - lastConnect_ >= RECONNECT_INTERVAL) {
+            lastConnect_ = now;
+            socket_->connectToHost(host_, port_);
+        }
+    }
+
+    QMutexLocker locker(&mutex_);
+    for (QList<Stream>::iterator it = streams_.begin(); it != streams_.end(); ++it) {
+        Stream& stream = *it;
+        int nameSize = (stream.name.size() + 7) & ~7;
+        int prefix = sizeof(StreamFrameHeader) + nameSize + sizeof(SampleRecordingHeader);
+        int limit = udp_ ? MAX_DATAGRAM : MAX_TCP_FRAME;
+        unsigned int maxSamples = qMax(1, (limit - prefix) / (int)stream.tap->sampleSize());
+
+        forever {
+            QByteArray frame(prefix, 0);
+            unsigned int dropped = 0;
+            unsigned int count = stream.tap->take(frame, maxSamples, dropped);
+            stream.dropped += dropped;
+            samplesDropped_ += dropped;
+            if (!count)
+                break;
+
+            StreamFrameHeader* header = (StreamFrameHeader*)frame.data();
+            header->magic = STREAM_FRAME_MAGIC;
+            header->version = STREAM_FRAME_VERSION;
+            header->size = frame.size() - sizeof(StreamFrameHeader);
+            header->sequence = stream.sequence;
+            header->dropped = stream.dropped;
+            header->nameLength = stream.name.size();
+            memcpy(frame.data() + sizeof(StreamFrameHeader), stream.name.constData(), stream.name.size());
+
+            SampleRecordingHeader* recording = (SampleRecordingHeader*)(frame.data() + sizeof(StreamFrameHeader) + nameSize);
+            recording->magic = SAMPLE_RECORDING_MAGIC;
+            recording->version = SAMPLE_RECORDING_VERSION;
+            recording->type = stream.tap->type();
+            recording->sampleSize = stream.tap->sampleSize();
+            recording->count = count;
+            recording->interval = stream.tap->interval();
+
+            if (send(frame)) {
+                ++framesSent_;
+                ++stream.sequence;
+                stream.dropped = 0;
+            } else {
+                ++framesDropped_;
+                stream.dropped += count;
+            }
+            if (count < maxSamples)
+                break;
+        }
+    }
+}
+
+bool StreamBridge::send(const QByteArray& frame)
+{
+    if (socket_->state() != QAbstractSocket::ConnectedState)
+        return false;
+    if (!udp_ && socket_->bytesToWrite() > MAX_UNSENT)
+        return false;
+    // A connected UDP socket sends each write as one datagram.
+    return socket_->write(frame) == frame.size();
+}
@@ -0,0 +1,290 @@
+/**
+   @file streambridge.h
+   @brief StreamBridge
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef STREAMBRIDGE_H
+#define STREAMBRIDGE_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QStringList>
+#include <QMutex>
+#include <string.h>
+
+class QAbstractSocket;
+class QThread;
+class QTimer;
+
+/**
+ * Magic number at the beginning of a stream frame, "SFWB".
+ */
+const quint32 STREAM_FRAME_MAGIC = 0x42574653;
+
+/**
+ * Version of the stream frame layout.
+ */
+const quint32 STREAM_FRAME_VERSION = 1;
+
+/**
+ * Header of a frame sent by StreamBridge. The stream name follows the
+ * header, padded with zeros to a multiple of eight bytes, and after it
+ * a complete sample recording (see SampleRecordingHeader) holding the
+ * samples of the frame. A collector gets a recording of the stream by
+ * keeping the recording header of the first frame and appending the
+ * samples of every frame, fixing up the count.
+ */
+struct StreamFrameHeader
+{
+    quint32 magic;      /**< STREAM_FRAME_MAGIC */
+    quint32 version;    /**< STREAM_FRAME_VERSION */
+    quint32 size;       /**< bytes following this header */
+    quint32 sequence;   /**< frame number within the stream, gaps are lost frames */
+    quint32 dropped;    /**< samples of the stream lost since the previous frame */
+    quint16 nameLength; /**< length of the stream name, without padding */
+    quint16 reserved;   /**< zero */
+};
+
+/**
+ * Staging ring between the writer of a buffer and StreamBridge. The
+ * writer copies its samples into the ring and never waits; the bridge
+ * takes them from its own thread. When the bridge falls a full ring
+ * behind the oldest samples are overwritten and counted as dropped.
+ *
+ * Only one thread may append and only one may take.
+ */
+class StreamTap
+{
+public:
+    /**
+     * Constructor.
+     *
+     * @param type SampleRecordingTypeId of the samples.
+     * @param sampleSize size of a single sample in bytes.
+     * @param capacity number of samples staged, rounded up to a power of two.
+     * @param interval fastest sample interval in microseconds, 0 if unknown.
+     */
+    StreamTap(quint32 type, quint32 sampleSize, unsigned int capacity, quint32 interval);
+
+    /**
+     * Destructor.
+     */
+    ~StreamTap();
+
+    /**
+     * Stage samples for the bridge.
+     *
+     * @param samples samples to stage.
+     * @param count number of samples.
+     */
+    void append(const void* samples, unsigned int count)
+    {
+        const char* in = (const char*)samples;
+        quint64 writeCount = writeCount_;
+        __atomic_store_n(&writeStart_, writeCount + count, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        for (unsigned int i = 0; i < count; ++i, in += sampleSize_)
+            memcpy(slots_ + ((writeCount + i) & mask_) * sampleSize_, in, sampleSize_);
+        __atomic_store_n(&writeCount_, writeCount + count, __ATOMIC_RELEASE);
+    }
+
+    /**
+     * Move staged samples to the end of a byte array, oldest first.
+     *
+     * @param out array to append to.
+     * @param max maximum number of samples taken.
+     * @param dropped increased by the samples overwritten before they
+     *                could be taken.
+     * @return number of samples appended.
+     */
+    unsigned int take(QByteArray& out, unsigned int max, unsigned int& dropped);
+
+    /**
+     * SampleRecordingTypeId of the samples.
+     *
+     * @return recording type.
+     */
+    quint32 type() const { return type_; }
+
+    /**
+     * Size of a single sample.
+     *
+     * @return size in bytes.
+     */
+    quint32 sampleSize() const { return sampleSize_; }
+
+    /**
+     * Fastest sample interval.
+     *
+     * @return interval in microseconds, 0 if unknown.
+     */
+    quint32 interval() const { return interval_; }
+
+private:
+    Q_DISABLE_COPY(StreamTap)
+
+    char*   slots_;      /**< sample slots */
+    quint64 mask_;       /**< capacity - 1 */
+    quint32 type_;       /**< SampleRecordingTypeId */
+    quint32 sampleSize_; /**< size of a slot */
+    quint32 interval_;   /**< fastest interval in microseconds */
+    quint64 writeCount_; /**< samples written */
+    quint64 writeStart_; /**< samples written or being written */
+    quint64 readCount_;  /**< samples taken, used by the reader only */
+};
+
+/**
+ * Optional bridge streaming the samples of selected adaptors to a
+ * collector over TCP or UDP, for capturing what devices in a test farm
+ * see without attaching a client to each of them. Writers only stage
+ * their samples in a StreamTap; every <tt>bridge/latency</tt>
+ * milliseconds the bridge thread batches the staged samples of each
+ * stream into a frame (see StreamFrameHeader) and sends it. Frames are
+ * never queued behind a slow collector: with TCP a frame is dropped
+ * while too much is still unsent, and while the connection is down,
+ * with UDP a frame is a single datagram which the network may drop.
+ */
+class StreamBridge : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(StreamBridge)
+
+public:
+    /**
+     * Start the bridge if <tt>bridge/collector</tt> is set.
+     *
+     * @return bridge or NULL if disabled or misconfigured.
+     */
+    static StreamBridge* create();
+
+    /**
+     * Destructor. Stops the bridge thread. Taps must stay valid until
+     * this returns.
+     */
+    ~StreamBridge();
+
+    /**
+     * Is an adaptor listed in <tt>bridge/adaptors</tt>.
+     *
+     * @param id adaptor ID.
+     * @return should the adaptor be streamed.
+     */
+    bool isSelected(const QString& id) const;
+
+    /**
+     * Start streaming samples staged in a tap. The tap must stay valid
+     * as long as the bridge.
+     *
+     * @param name stream name, "<adaptor>/<buffer>".
+     * @param tap tap of the buffer.
+     */
+    void addStream(const QString& name, StreamTap* tap);
+
+    /**
+     * Stop streaming a tap. After this returns the bridge does not
+     * touch the tap any more.
+     *
+     * @param tap tap given to #addStream().
+     */
+    void removeStream(StreamTap* tap);
+
+    /**
+     * Capacity of a tap which holds the samples written at the given
+     * interval during a few batching periods.
+     *
+     * @param interval fastest sample interval in microseconds, 0 if unknown.
+     * @return number of samples.
+     */
+    unsigned int tapCapacity(unsigned int interval) const;
+
+    /**
+     * Counters of sent and dropped frames.
+     *
+     * @return report lines.
+     */
+    QStringList report() const;
+
+private Q_SLOTS:
+    /**
+     * Create the socket and timer in the bridge thread.
+     */
+    void start();
+
+    /**
+     * Delete the socket and timer in the bridge thread.
+     */
+    void stop();
+
+    /**
+     * Batch staged samples into frames and send them.
+     */
+    void flush();
+
+private:
+    /**
+     * Constructor.
+     *
+     * @param host collector host.
+     * @param port collector port.
+     * @param udp send datagrams instead of a TCP stream.
+     * @param latency batching period in milliseconds.
+     * @param adaptors adaptors to stream.
+     */
+    StreamBridge(const QString& host, quint16 port, bool udp, unsigned int latency, const QStringList& adaptors);
+
+    /**
+     * Send one frame, or drop it if the collector cannot take it now.
+     *
+     * @param frame complete frame.
+     * @return was the frame sent.
+     */
+    bool send(const QByteArray& frame);
+
+    /**
+     * Streamed buffer.
+     */
+    struct Stream
+    {
+        QByteArray   name;     /**< stream name, UTF-8 */
+        StreamTap*   tap;      /**< staged samples */
+        quint32      sequence; /**< next frame number */
+        unsigned int dropped;  /**< samples lost since the last sent frame */
+    };
+
+    QString          host_;           /**< collector host */
+    quint16          port_;           /**< collector port */
+    bool             udp_;            /**< send datagrams */
+    unsigned int     latency_;        /**< batching period in milliseconds */
+    QStringList      adaptors_;       /**< adaptors to stream */
+    QThread*         thread_;         /**< bridge thread */
+    QTimer*          timer_;          /**< batching timer, in the bridge thread */
+    QAbstractSocket* socket_;         /**< collector socket, in the bridge thread */
+    qint64           lastConnect_;    /**< last connection attempt, ms since epoch */
+    mutable QMutex   mutex_;          /**< protects streams_ and the counters */
+    QList<Stream>    streams_;        /**< streamed buffers */
+    quint64          framesSent_;     /**< frames handed to the socket */
+    quint64          framesDropped_;  /**< frames dropped before sending */
+    quint64          samplesDropped_; /**< samples overwritten in the taps */
+};
+
+#endif // STREAMBRIDGE_H
@@ -0,0 +1,62 @@
+/**
+   @file stringpool.cpp
+   @brief StringPool
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "stringpool.h"
+#include <QSet>
+#include <QMutex>
+#include <QMutexLocker>
+
+namespace {
+
+QSet<QString>& pool()
+{
+    static QSet<QString> strings;
+    return strings;
+}
+
+QMutex& poolMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+}
+
+QString StringPool::intern(const QString& str)
+{
+    if (str.isEmpty())
+        return QString();
+
+    QMutexLocker locker(&poolMutex());
+    QSet<QString>& strings = pool();
+    QSet<QString>::const_iterator it = strings.constFind(str);
+    if (it != strings.constEnd())
+        return *it;
+    return *strings.insert(str);
+}
+
+int StringPool::size()
+{
+    QMutexLocker locker(&poolMutex());
+    return pool().size();
+}
@@ -0,0 +1,55 @@
+/**
+   @file stringpool.h
+   @brief StringPool
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <QString>
+
+/**
+ * Pool of interned strings. Node IDs, descriptions and source and sink
+ * names repeat across nodes; interning them lets every node share one
+ * copy of the characters instead of holding its own.
+ */
+class StringPool
+{
+public:
+    /**
+     * Get the pooled copy of given string, adding it if needed. The
+     * returned string shares its data with every other copy returned
+     * for an equal string. Strings are never removed from the pool.
+     *
+     * @param str string to intern.
+     * @return pooled copy of the string.
+     */
+    static QString intern(const QString& str);
+
+    /**
+     * Number of strings in the pool.
+     *
+     * @return pool size.
+     */
+    static int size();
+};
+
+#endif // STRINGPOOL_H
@@ -32,9 +32,15 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include "logging.h"
 #include "config.h"
+#include "threadscheduling.h"
+#include "datatypes/utils.h"
 
 SysfsAdaptor::SysfsAdaptor(const QString& id,
                            PollMode mode,
@@ -42,26 +48,34 @@ SysfsAdaptor::SysfsAdaptor(const QString& id,
                            const QString& path,
                            const int pathId) :
     DeviceAdaptor(id),
-    reader_(this),
     mode_(mode),
-    epollDescriptor_(-1),
+    timerDescriptor_(-1),
     interval_(0),
     inStandbyMode_(false),
     running_(false),
     shouldBeRunning_(false),
-    doSeek_(seek)
+    doSeek_(seek),
+    warmStandby_(false),
+    parked_(false),
+    iioBufferLength_(128),
+    monotonicScanTimestamps_(false),
+    scanBatchTime_(0),
+    triggerInterval_(0),
+    fifoWatermark_(0),
+    bufferSize_(1),
+    bufferInterval_(0)
 {
     if (!path.isEmpty()) {
         addPath(path, pathId);
     }
-
-    pipeDescriptors_[0] = -1;
-    pipeDescriptors_[1] = -1;
 }
 
 SysfsAdaptor::~SysfsAdaptor()
 {
     stopAdaptor();
+
+    QMutexLocker locker(&mutex_);
+    closeSysfsFds();
 }
 
 bool SysfsAdaptor::addPath(const QString& path, const int id)
@@ -72,6 +86,59 @@ bool SysfsAdaptor::addPath(const QString& path, const int id)
 
     paths_.append(path);
     pathIds_.append(id);
+    groupSizes_.append(1);
+
+    return true;
+}
+
+bool SysfsAdaptor::addPathGroup(const QStringList& paths, const int id)
+{
+    if (paths.isEmpty() || paths.size() > MAX_GROUP_SIZE) {
+        sensordLogW() << "Invalid path group size: " << paths.size();
+        return false;
+    }
+    foreach (const QString& path, paths) {
+        if (!QFile::exists(path)) {
+            return false;
+        }
+    }
+
+    for (int i = 0; i < paths.size(); ++i) {
+        paths_.append(paths.at(i));
+        pathIds_.append(id);
+        groupSizes_.append(i ? 0 : paths.size());
+    }
+
+    return true;
+}
+
+bool SysfsAdaptor::addIioDevice(const QString& devicePath, const QStringList& channels, const int id)
+{
+    QString node = "/dev/" + QFileInfo(devicePath).fileName();
+    if (!QFile::exists(node)) {
+        sensordLogW() << "IIO device node not found: " << node;
+        return false;
+    }
+
+    if (!scanLayout_.load(devicePath, channels)) {
+        return false;
+    }
+
+    // IIO timestamps default to the realtime clock. Only use them when
+    // the device can be switched to the clock samples are stamped with.
+    monotonicScanTimestamps_ = scanLayout_.hasTimestamp() &&
+        writeToFile((devicePath + "/current_timestamp_clock").toLocal8Bit(), "monotonic");
+
+    // The IIO buffer is the FIFO, its watermark batches the wakeups.
+    if (fifoWatermarkPath_.isEmpty() && QFile::exists(devicePath + "/buffer/watermark"))
+        fifoWatermarkPath_ = (devicePath + "/buffer/watermark").toLocal8Bit();
+
+    iioDevicePath_ = devicePath;
+    mode_ = IioBufferMode;
+    doSeek_ = false;
+    paths_.append(node);
+    pathIds_.append(id);
+    groupSizes_.append(1);
 
     return true;
 }
@@ -151,9 +218,10 @@ void SysfsAdaptor::stopSensor()
 
     entry->removeReference();
     if (entry->referenceCount() <= 0) {
-        if (!inStandbyMode_) {
+        if (!inStandbyMode_ || parked_) {
             stopReaderThread();
             closeAllFds();
+            parked_ = false;
         }
         entry->setIsRunning(false);
         running_ = false;
@@ -180,8 +248,12 @@ bool SysfsAdaptor::standby()
     }
 
     sensordLogD() << "Adaptor '" << id() << "' going to standby";
-    stopReaderThread();
-    closeAllFds();
+    if (warmStandby_) {
+        parkReader();
+    } else {
+        stopReaderThread();
+        closeAllFds();
+    }
 
     running_ = false;
 
@@ -207,7 +279,7 @@ bool SysfsAdaptor::resume()
 
     sensordLogD() << "Adaptor '" << id() << "' resuming from standby";
 
-    if (!startReaderThread()) {
+    if (parked_ ? !unparkReader() : !startReaderThread()) {
         sensordLogW() << "Adaptor '" << id() << "' failed to resume from standby!";
         return false;
     }
@@ -216,57 +288,89 @@ bool SysfsAdaptor::resume()
     return true;
 }
 
-bool SysfsAdaptor::openFds()
+void SysfsAdaptor::parkReader()
 {
+    SysfsAdaptorReader::instance().park(this, true);
+
     QMutexLocker locker(&mutex_);
+    if (timerDescriptor_ != -1) {
+        struct itimerspec spec;
+        memset(&spec, 0, sizeof(spec));
+        timerfd_settime(timerDescriptor_, 0, &spec, NULL);
+    }
+    if (mode_ == IioBufferMode) {
+        enableIioBuffer(false);
+    }
+    parked_ = true;
+}
 
-    int fd;
-    for (int i = 0; i < paths_.size(); i++) {
-        if ((fd = open(paths_.at(i).toLatin1().constData(), O_RDONLY)) == -1) {
-            sensordLogW() << "open(): " << strerror(errno);
-            return false;
+bool SysfsAdaptor::unparkReader()
+{
+    flushPendingWrites();
+
+    bool ok = true;
+    {
+        QMutexLocker locker(&mutex_);
+        parked_ = false;
+        if (mode_ == IioBufferMode) {
+            ok = enableIioBuffer(true);
+        }
+        if (timerDescriptor_ != -1) {
+            armTimer();
         }
-        sysfsDescriptors_.append(fd);
+    }
+    // Changes while parked were not dispatched.
+    if (ok) {
+        pushInitialState();
+    }
+    if (ok && SysfsAdaptorReader::instance().park(this, false)) {
+        return true;
     }
 
-    // Set up epoll for select mode
-    if (mode_ == SelectMode) {
+    sensordLogW() << "Adaptor '" << id() << "' failed to unpark, reopening";
+    stopReaderThread();
+    closeAllFds();
+    return startReaderThread();
+}
 
-        if (pipe(pipeDescriptors_) == -1 ) {
-            sensordLogW() << "pipe(): " << strerror(errno);
-            return false;
-        }
+bool SysfsAdaptor::openFds()
+{
+    QMutexLocker locker(&mutex_);
 
-        if (fcntl(pipeDescriptors_[0], F_SETFD, FD_CLOEXEC) == -1) {
-            sensordLogW() << "fcntl(): " << strerror(errno);
+    int flags = O_RDONLY;
+    if (mode_ == IioBufferMode) {
+        if (!enableIioBuffer(true)) {
             return false;
         }
+        scanBuffer_.resize(scanLayout_.frameSize() * iioBufferLength_);
+        flags |= O_NONBLOCK;
+    }
 
-        // Set up epoll fd
-        if ((epollDescriptor_ = epoll_create(sysfsDescriptors_.size() + 1)) == -1) {
-            sensordLogW() << "epoll_create(): " << strerror(errno);
-            return false;
+    if (sysfsDescriptors_.size() == paths_.size()) {
+        // Reuse descriptors kept open since the last stop.
+        foreach (int fd, sysfsDescriptors_) {
+            lseek(fd, 0, SEEK_SET);
         }
+    } else {
+        closeSysfsFds();
 
-        struct epoll_event ev;
-        memset(&ev, 0, sizeof(epoll_event));
-        ev.events  = EPOLLIN;
-
-        // Set up epolling for the list
-        for (int i = 0; i < sysfsDescriptors_.size(); ++i) {
-            ev.data.fd = sysfsDescriptors_.at(i);
-            if (epoll_ctl(epollDescriptor_, EPOLL_CTL_ADD, sysfsDescriptors_.at(i), &ev) == -1) {
-                sensordLogW() << "epoll_ctl(): " << strerror(errno);
+        int fd;
+        for (int i = 0; i < paths_.size(); i++) {
+            if ((fd = open(paths_.at(i).toLatin1().constData(), flags)) == -1) {
+                sensordLogW() << "open(): " << strerror(errno);
                 return false;
             }
+            sysfsDescriptors_.append(fd);
         }
+    }
 
-        // Add control pipe to poll list
-        ev.data.fd = pipeDescriptors_[0];
-        if (epoll_ctl(epollDescriptor_, EPOLL_CTL_ADD, pipeDescriptors_[0], &ev) == -1) {
-            sensordLogW() << "epoll_ctl(): " << strerror(errno);
+    // In IntervalMode the timer drives reading instead of the files
+    if (mode_ == IntervalMode) {
+        if ((timerDescriptor_ = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK)) == -1) {
+            sensordLogW() << "timerfd_create(): " << strerror(errno);
             return false;
         }
+        armTimer();
     }
 
     return true;
@@ -274,23 +378,30 @@ bool SysfsAdaptor::openFds()
 
 void SysfsAdaptor::closeAllFds()
 {
+    // Descriptors must not be closed while the reader still uses them.
+    SysfsAdaptorReader::instance().remove(this);
+
     QMutexLocker locker(&mutex_);
 
-    /* Epoll */
-    if (epollDescriptor_ != -1) {
-        close(epollDescriptor_);
-        epollDescriptor_ = -1;
+    /* Timer */
+    if (timerDescriptor_ != -1) {
+        close(timerDescriptor_);
+        timerDescriptor_ = -1;
     }
 
-    /* Pipe */
-    for (int i = 0; i < 2; ++i) {
-        if (pipeDescriptors_[i] != -1) {
-            close(pipeDescriptors_[i]);
-            pipeDescriptors_[i] = -1;
-        }
+    /* SysFS, kept open for the next start when possible */
+    if (!canCacheFds() || sysfsDescriptors_.size() != paths_.size()) {
+        closeSysfsFds();
     }
 
-    /* SysFS */
+    /* IIO buffer */
+    if (mode_ == IioBufferMode) {
+        enableIioBuffer(false);
+    }
+}
+
+void SysfsAdaptor::closeSysfsFds()
+{
     while (!sysfsDescriptors_.empty()) {
         if (sysfsDescriptors_.last() != -1) {
             close(sysfsDescriptors_.last());
@@ -299,33 +410,213 @@ void SysfsAdaptor::closeAllFds()
     }
 }
 
+bool SysfsAdaptor::canCacheFds() const
+{
+    if (mode_ == IioBufferMode) {
+        return false;
+    }
+    foreach (const QString& path, paths_) {
+        if (!path.startsWith("/sys/")) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SysfsAdaptor::enableIioBuffer(bool enable)
+{
+    QByteArray bufferPath = (iioDevicePath_ + "/buffer/").toLocal8Bit();
+
+    if (!enable) {
+        return writeToFile(bufferPath + "enable", "0");
+    }
+
+    // Buffer parameters can only be changed while it is disabled.
+    writeToFile(bufferPath + "enable", "0");
+    writeToFile(bufferPath + "length", QByteArray::number(iioBufferLength_));
+    if (fifoWatermarkPath_ == bufferPath + "watermark")
+        writeToFile(fifoWatermarkPath_, QByteArray::number(qMax(fifoWatermark_, 1u)));
+
+    if (!iioTrigger_.isEmpty()) {
+        writeToFile((iioDevicePath_ + "/trigger/current_trigger").toLocal8Bit(), iioTrigger_);
+    }
+
+    if (!writeToFile(bufferPath + "enable", "1")) {
+        sensordLogW() << "Failed to enable IIO buffer of " << iioDevicePath_;
+        return false;
+    }
+    return true;
+}
+
+void SysfsAdaptor::readScanFrames(int pathId, int fd)
+{
+    const int frameSize = scanLayout_.frameSize();
+
+    // Drain the buffer; a short read means it is empty.
+    for (;;) {
+        ssize_t bytes = read(fd, scanBuffer_.data(), scanBuffer_.size());
+        if (bytes <= 0) {
+            if (bytes == -1 && errno != EAGAIN) {
+                sensordLogW() << "Failed to read IIO buffer: " << strerror(errno);
+            }
+            return;
+        }
+
+        int frames = bytes / frameSize;
+        if (frames > 0) {
+            scanBatchTime_ = Utils::getTimeStamp();
+            processScanFrames(pathId, scanBuffer_.constData(), frames);
+        }
+        if (bytes < scanBuffer_.size()) {
+            return;
+        }
+    }
+}
+
+bool SysfsAdaptor::readInitialState(int pathId, int fd)
+{
+    Q_UNUSED(pathId);
+    Q_UNUSED(fd);
+    return false;
+}
+
+void SysfsAdaptor::pushInitialState()
+{
+    if (mode_ != SelectMode) {
+        return;
+    }
+
+    for (int i = 0; i < sysfsDescriptors_.size(); i += qMax(1, groupSizes_.at(i))) {
+        if (readInitialState(pathIds_.at(i), sysfsDescriptors_.at(i))) {
+            continue;
+        }
+        // Reading a device node may block until the next event.
+        bool attributes = true;
+        for (int j = i; j < i + qMax(1, groupSizes_.at(i)); ++j) {
+            if (!paths_.at(j).startsWith("/sys/")) {
+                attributes = false;
+            }
+        }
+        if (attributes) {
+            readPath(i);
+        }
+    }
+}
+
+void SysfsAdaptor::processPathGroup(int groupId, const int* fds, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        processSample(groupId, fds[i]);
+    }
+}
+
+void SysfsAdaptor::processScanFrames(int pathId, const char* frames, int count)
+{
+    Q_UNUSED(pathId);
+    Q_UNUSED(frames);
+    Q_UNUSED(count);
+}
+
+const IioScanLayout& SysfsAdaptor::scanLayout() const
+{
+    return scanLayout_;
+}
+
+quint64 SysfsAdaptor::scanFrameTimeStamp(const char* frames, int index, int count) const
+{
+    if (monotonicScanTimestamps_) {
+        return Utils::getTimeStamp(scanLayout_.timestamp(frames + index * scanLayout_.frameSize()));
+    }
+
+    // Frames were sampled at the configured interval, or at the rate of
+    // the shared trigger, the last one when the batch was read.
+    unsigned int period = triggerInterval_ ? triggerInterval_ : interval();
+    return scanBatchTime_ - (quint64)(count - 1 - index) * period * 1000;
+}
+
 void SysfsAdaptor::stopReaderThread()
 {
-    if (mode_ == SelectMode) {
-        quint64 dummy = 1;
-        write(pipeDescriptors_[1], &dummy, 8);
+    SysfsAdaptorReader::instance().remove(this);
+}
+
+void SysfsAdaptor::armTimer()
+{
+    unsigned int period = qMax(1u, interval());
+
+    struct itimerspec spec;
+    clock_gettime(CLOCK_MONOTONIC, &spec.it_value);
+    spec.it_interval.tv_sec = period / 1000;
+    spec.it_interval.tv_nsec = (period % 1000) * 1000000;
+    spec.it_value.tv_sec += spec.it_interval.tv_sec;
+    spec.it_value.tv_nsec += spec.it_interval.tv_nsec;
+    if (spec.it_value.tv_nsec >= 1000000000) {
+        spec.it_value.tv_sec += 1;
+        spec.it_value.tv_nsec -= 1000000000;
+    }
+
+    if (timerfd_settime(timerDescriptor_, TFD_TIMER_ABSTIME, &spec, NULL) == -1) {
+        sensordLogW() << "timerfd_settime(): " << strerror(errno);
     }
-    else
-        reader_.stopReader();
-    reader_.wait();
 }
 
 bool SysfsAdaptor::startReaderThread()
 {
+    // Rate changes made while stopped go out with the power up.
+    flushPendingWrites();
+
     if (!openFds()) {
 
         closeAllFds();
         return false;
     }
 
-    reader_.startReader();
+    pushInitialState();
+
+    SysfsAdaptorReader& reader = SysfsAdaptorReader::instance();
+    bool added = true;
+    if (mode_ == IntervalMode) {
+        added = reader.add(this, timerDescriptor_, -1);
+    } else if (mode_ == IioBufferMode) {
+        for (int i = 0; i < sysfsDescriptors_.size() && added; ++i) {
+            added = reader.add(this, sysfsDescriptors_.at(i), i, iioTrigger_);
+        }
+    } else {
+        // Group members are read when the first file of the group is.
+        for (int i = 0; i < sysfsDescriptors_.size() && added; ++i) {
+            if (groupSizes_.at(i))
+                added = reader.add(this, sysfsDescriptors_.at(i), i);
+        }
+    }
+    if (!added) {
+        closeAllFds();
+        return false;
+    }
 
     return true;
 }
 
-bool SysfsAdaptor::writeToFile(const QByteArray& path, const QByteArray& content)
+namespace {
+
+/**
+ * Sysfs attribute written by an adaptor. The descriptor is kept open and
+ * the last written value remembered, so repeated start, stop and rate
+ * changes neither reopen the attribute nor rewrite an unchanged value.
+ */
+struct CachedAttribute
+{
+    CachedAttribute() : fd(-1) {}
+
+    int        fd;    /**< open descriptor, -1 if not open */
+    QByteArray value; /**< last value written */
+};
+
+QMutex attributeMutex;
+QHash<QByteArray, CachedAttribute> attributeCache;
+
+}
+
+static bool writeUncached(const QByteArray& path, const QByteArray& content)
 {
-    sensordLogT() << "Writing to '" << path << ": " << content;
     if (!QFile::exists(path))
     {
         sensordLogW() << "Path does not exists: " << path;
@@ -348,8 +639,76 @@ bool SysfsAdaptor::writeToFile(const QByteArray& path, const QByteArray& content
     return true;
 }
 
+bool SysfsAdaptor::writeToFile(const QByteArray& path, const QByteArray& content)
+{
+    // Device nodes are opened per write, keeping them open may keep the
+    // hardware powered.
+    if (!path.startsWith("/sys/")) {
+        sensordLogT() << "Writing to '" << path << ": " << content;
+        return writeUncached(path, content);
+    }
+
+    QMutexLocker locker(&attributeMutex);
+    CachedAttribute& attribute = attributeCache[path];
+    if (attribute.fd != -1 && attribute.value == content) {
+        sensordLogT() << "Skipping unchanged write to '" << path << ": " << content;
+        return true;
+    }
+
+    sensordLogT() << "Writing to '" << path << ": " << content;
+    if (attribute.fd == -1) {
+        attribute.fd = open(path.constData(), O_WRONLY | O_CLOEXEC);
+        if (attribute.fd == -1) {
+            sensordLogW() << "Failed to open '" << path << "': " << strerror(errno);
+            attributeCache.remove(path);
+            return false;
+        }
+    }
+
+    // Attributes take the whole value in one write from the start.
+    if (pwrite(attribute.fd, content.constData(), content.size(), 0) == -1) {
+        sensordLogW() << "Failed to write '" << path << "': " << strerror(errno);
+        close(attribute.fd);
+        attributeCache.remove(path);
+        return false;
+    }
+    attribute.value = content;
+    return true;
+}
+
+bool SysfsAdaptor::writeWhenRunning(const QByteArray& path, const QByteArray& content)
+{
+    if (running_)
+        return writeToFile(path, content);
+
+    for (int i = 0; i < pendingWrites_.size(); ++i) {
+        if (pendingWrites_.at(i).first == path) {
+            pendingWrites_[i].second = content;
+            return true;
+        }
+    }
+    pendingWrites_.append(qMakePair(path, content));
+    return true;
+}
+
+void SysfsAdaptor::flushPendingWrites()
+{
+    for (int i = 0; i < pendingWrites_.size(); ++i)
+        writeToFile(pendingWrites_.at(i).first, pendingWrites_.at(i).second);
+    pendingWrites_.clear();
+}
+
 QByteArray SysfsAdaptor::readFromFile(const QByteArray& path)
 {
+    {
+        QMutexLocker locker(&attributeMutex);
+        QHash<QByteArray, CachedAttribute>::const_iterator it = attributeCache.constFind(path);
+        if (it != attributeCache.constEnd()) {
+            sensordLogT() << "Cached value of '" << path << ": " << it->value;
+            return it->value;
+        }
+    }
+
     QFile file(path);
     if (!file.exists(path) || !(file.open(QIODevice::ReadOnly)))
     {
@@ -362,6 +721,63 @@ QByteArray SysfsAdaptor::readFromFile(const QByteArray& path)
     return data;
 }
 
+int SysfsAdaptor::readValues(int fd, int* values, int count, int base)
+{
+    char buf[64];
+    ssize_t bytes = pread(fd, buf, sizeof(buf), 0);
+    if (bytes < 0) {
+        sensordLogW() << "pread(): " << strerror(errno);
+        return -1;
+    }
+    return parseValues(buf, bytes, values, count, base);
+}
+
+int SysfsAdaptor::parseValues(const char* data, int size, int* values, int count, int base)
+{
+    const char* p = data;
+    const char* end = data + size;
+    int parsed = 0;
+
+    while (parsed < count) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == ',' || *p == ':')) {
+            ++p;
+        }
+
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negative = (*p == '-');
+            ++p;
+        }
+        if (base == 16 && end - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+            p += 2;
+        }
+
+        const char* start = p;
+        unsigned int value = 0;
+        for (; p < end; ++p) {
+            unsigned int digit;
+            if (*p >= '0' && *p <= '9') {
+                digit = *p - '0';
+            } else if (*p >= 'a' && *p <= 'f') {
+                digit = *p - 'a' + 10;
+            } else if (*p >= 'A' && *p <= 'F') {
+                digit = *p - 'A' + 10;
+            } else {
+                break;
+            }
+            if (digit >= (unsigned int)base) {
+                break;
+            }
+            value = value * base + digit;
+        }
+        if (p == start) {
+            break;
+        }
+        values[parsed++] = negative ? -(int)value : (int)value;
+    }
+    return parsed;
+}
+
 bool SysfsAdaptor::checkIntervalUsage() const
 {
     if (mode_ == SysfsAdaptor::SelectMode)
@@ -380,7 +796,7 @@ unsigned int SysfsAdaptor::interval() const
 {
     if(!checkIntervalUsage())
         return 0;
-    return interval_;
+    return interval_.loadAcquire();
 }
 
 bool SysfsAdaptor::setInterval(const unsigned int value, const int sessionId)
@@ -388,90 +804,442 @@ bool SysfsAdaptor::setInterval(const unsigned int value, const int sessionId)
     Q_UNUSED(sessionId);
     if(!checkIntervalUsage())
         return false;
-    interval_ = value;
+    interval_.storeRelease(value);
+
+    if (mode_ == IntervalMode) {
+        // Running timer switches to the new period right away.
+        QMutexLocker locker(&mutex_);
+        if (timerDescriptor_ != -1 && !parked_) {
+            armTimer();
+        }
+    }
+
+    if (mode_ == IioBufferMode && value > 0) {
+        if (!iioTrigger_.isEmpty()) {
+            // Devices on the trigger run at the fastest rate among them.
+            SysfsAdaptorReader::instance().setTriggerRate(iioTrigger_);
+        } else {
+            QByteArray frequencyPath = (iioDevicePath_ + "/sampling_frequency").toLocal8Bit();
+            if (QFile::exists(frequencyPath)) {
+                writeToFile(frequencyPath, QByteArray::number(qMax(1u, 1000 / value)));
+            }
+        }
+    }
+    if (bufferInterval_)
+        applyFifoWatermark();
     return true;
 }
 
+IntegerRangeList SysfsAdaptor::getAvailableBufferSizes(bool& hwSupported) const
+{
+    if (hasFifo()) {
+        IntegerRangeList list;
+        list.push_back(IntegerRange(1, fifoSize()));
+        hwSupported = true;
+        return list;
+    }
+    return DeviceAdaptor::getAvailableBufferSizes(hwSupported);
+}
+
+IntegerRangeList SysfsAdaptor::getAvailableBufferIntervals(bool& hwSupported) const
+{
+    if (hasFifo()) {
+        IntegerRangeList list;
+        list.push_back(IntegerRange(0, 60000));
+        hwSupported = true;
+        return list;
+    }
+    return DeviceAdaptor::getAvailableBufferIntervals(hwSupported);
+}
+
+unsigned int SysfsAdaptor::bufferSize() const
+{
+    return bufferSize_;
+}
+
+unsigned int SysfsAdaptor::bufferInterval() const
+{
+    return bufferInterval_;
+}
+
+bool SysfsAdaptor::setBufferSize(unsigned int value)
+{
+    if (!hasFifo())
+        return false;
+    bufferSize_ = value;
+    return applyFifoWatermark();
+}
+
+bool SysfsAdaptor::setBufferInterval(unsigned int value)
+{
+    if (!hasFifo())
+        return false;
+    bufferInterval_ = value;
+    bool ok = true;
+    if (!fifoTimeoutPath_.isEmpty())
+        ok = writeToFile(fifoTimeoutPath_, QByteArray::number(value));
+    return applyFifoWatermark() && ok;
+}
+
+unsigned int SysfsAdaptor::bufferCapacity(unsigned int minimum) const
+{
+    return DeviceAdaptor::bufferCapacity(qMax(minimum, fifoSize()));
+}
+
+unsigned int SysfsAdaptor::fifoSize() const
+{
+    unsigned int size = iioDevicePath_.isEmpty() ? 0 : iioBufferLength_;
+    Config* config = Config::configuration();
+    if (config)
+        size = config->value<unsigned int>(id() + "/fifo_size", size);
+    return size;
+}
+
+bool SysfsAdaptor::hasFifo() const
+{
+    return !fifoWatermarkPath_.isEmpty() && fifoSize() > 1;
+}
+
+bool SysfsAdaptor::applyFifoWatermark()
+{
+    if (!hasFifo())
+        return true;
+
+    unsigned int watermark = bufferSize_;
+    unsigned int currentInterval = interval();
+    if (bufferInterval_ && currentInterval)
+        watermark = qMax(watermark, bufferInterval_ / currentInterval);
+    watermark = qBound(1u, watermark, fifoSize());
+
+    if (watermark == fifoWatermark_)
+        return true;
+    fifoWatermark_ = watermark;
+    sensordLogD() << "FIFO watermark of " << id() << " set to " << watermark << " samples";
+
+    if (!iioDevicePath_.isEmpty() && fifoWatermarkPath_ == (iioDevicePath_ + "/buffer/watermark").toLocal8Bit()) {
+        // IIO buffer parameters only change while the buffer is disabled.
+        QMutexLocker locker(&mutex_);
+        return !running_ || enableIioBuffer(true);
+    }
+    return writeToFile(fifoWatermarkPath_, QByteArray::number(watermark));
+}
+
 SysfsAdaptor::PollMode SysfsAdaptor::mode() const
 {
     return mode_;
 }
 
-SysfsAdaptorReader::SysfsAdaptorReader(SysfsAdaptor *parent) : running_(false), parent_(parent)
+void SysfsAdaptor::dispatch(int index, int fd)
 {
+    if (index == -1) {
+        quint64 expirations;
+        read(timerDescriptor_, &expirations, sizeof(expirations));
+
+        // Read through all fds.
+        for (int j = 0; j < sysfsDescriptors_.size(); j += qMax(1, groupSizes_.at(j))) {
+            readPath(j);
+        }
+        return;
+    }
+
+    if (mode_ == IioBufferMode) {
+        readScanFrames(pathIds_.at(index), fd);
+        return;
+    }
+
+    readPath(index);
 }
 
-void SysfsAdaptorReader::stopReader()
+void SysfsAdaptor::readPath(int index)
 {
-    running_ = false;
+    int count = groupSizes_.at(index);
+    if (count > 1) {
+        int fds[MAX_GROUP_SIZE];
+        for (int i = 0; i < count; ++i) {
+            fds[i] = sysfsDescriptors_.at(index + i);
+        }
+        processPathGroup(pathIds_.at(index), fds, count);
+    } else {
+        processSample(pathIds_.at(index), sysfsDescriptors_.at(index));
+        count = 1;
+    }
+
+    for (int i = 0; doSeek_ && i < count; ++i) {
+        if (lseek(sysfsDescriptors_.at(index + i), 0, SEEK_SET) == -1) {
+            sensordLogW() << "Failed to lseek fd: " << strerror(errno);
+        }
+    }
 }
 
-void SysfsAdaptorReader::startReader()
+SysfsAdaptorReader::SysfsAdaptorReader() :
+    epollDescriptor_(-1),
+    nextId_(0)
 {
-    running_ = true;
-    start();
+    if ((epollDescriptor_ = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+        sensordLogC() << "epoll_create1(): " << strerror(errno);
+    }
 }
 
-void SysfsAdaptorReader::run()
+SysfsAdaptorReader& SysfsAdaptorReader::instance()
 {
-    while (running_) {
+    // Never deleted: the thread runs until the process exits.
+    static SysfsAdaptorReader* reader = new SysfsAdaptorReader;
+    return *reader;
+}
 
-        if (parent_->mode_ == SysfsAdaptor::SelectMode) {
+bool SysfsAdaptorReader::add(SysfsAdaptor* adaptor, int fd, int index, const QByteArray& trigger)
+{
+    QMutexLocker locker(&mutex_);
 
-            struct epoll_event events[parent_->sysfsDescriptors_.size() + 1];
-            memset(events, 0x0, sizeof(events));
+    Registration registration;
+    registration.adaptor = adaptor;
+    registration.fd = fd;
+    registration.index = index;
+    registration.parked = false;
+    registration.polled = false;
+    registration.trigger = trigger;
+    quint64 id = nextId_++;
+
+    if (trigger.isEmpty()) {
+        if (!setPolled(id, registration, true)) {
+            return false;
+        }
+        registrations_.insert(id, registration);
+    } else {
+        if (!triggers_.contains(trigger)) {
+            Trigger group;
+            QString directory = triggerDirectory(trigger);
+            if (!directory.isEmpty() && QFile::exists(directory + "/sampling_frequency")) {
+                group.frequencyPath = (directory + "/sampling_frequency").toLocal8Bit();
+            }
+            triggers_.insert(trigger, group);
+        }
+        registrations_.insert(id, registration);
+        triggers_[trigger].members.append(id);
+        if (!updateTrigger(trigger)) {
+            registrations_.remove(id);
+            triggers_[trigger].members.removeAll(id);
+            if (triggers_[trigger].members.isEmpty()) {
+                triggers_.remove(trigger);
+            } else {
+                updateTrigger(trigger);
+            }
+            return false;
+        }
+        applyTriggerRate(trigger);
+    }
 
-            int descriptors = epoll_wait(parent_->epollDescriptor_, events, parent_->sysfsDescriptors_.size() + 1, -1);
+    if (!isRunning()) {
+        start();
+    }
+    return true;
+}
 
-            if (descriptors == -1) {
-                sensordLogD() << "epoll_wait(): " << strerror(errno);
+void SysfsAdaptorReader::remove(SysfsAdaptor* adaptor)
+{
+    // Events are dispatched with the mutex held, so once it is acquired
+    // the adaptor is not being called.
+    QMutexLocker locker(&mutex_);
+    QList<QByteArray> changedTriggers;
+    QHash<quint64, Registration>::iterator it = registrations_.begin();
+    while (it != registrations_.end()) {
+        if (it.value().adaptor == adaptor) {
+            setPolled(it.key(), it.value(), false);
+            if (!it.value().trigger.isEmpty()) {
+                triggers_[it.value().trigger].members.removeAll(it.key());
+                if (!changedTriggers.contains(it.value().trigger))
+                    changedTriggers.append(it.value().trigger);
+            }
+            it = registrations_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // Remaining devices on the trigger get a new leader and rate.
+    adaptor->triggerInterval_ = 0;
+    foreach (const QByteArray& trigger, changedTriggers) {
+        if (triggers_.value(trigger).members.isEmpty()) {
+            triggers_.remove(trigger);
+            continue;
+        }
+        updateTrigger(trigger);
+        applyTriggerRate(trigger);
+    }
+}
+
+bool SysfsAdaptorReader::park(SysfsAdaptor* adaptor, bool parked)
+{
+    QMutexLocker locker(&mutex_);
+    bool ok = true;
+    QList<QByteArray> changedTriggers;
+    QHash<quint64, Registration>::iterator it;
+    for (it = registrations_.begin(); it != registrations_.end(); ++it) {
+        if (it.value().adaptor != adaptor)
+            continue;
+        it.value().parked = parked;
+        if (!it.value().trigger.isEmpty()) {
+            // Membership in the epoll set follows the trigger leader.
+            if (!changedTriggers.contains(it.value().trigger))
+                changedTriggers.append(it.value().trigger);
+            continue;
+        }
+        // Errors are reported even without EPOLLIN, and sysfs reports
+        // changes as errors. One shot keeps a parked attribute from
+        // waking the reader more than once.
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(epoll_event));
+        ev.events = parked ? EPOLLONESHOT : EPOLLIN;
+        ev.data.u64 = it.key();
+        if (epoll_ctl(epollDescriptor_, EPOLL_CTL_MOD, it.value().fd, &ev) == -1) {
+            sensordLogW() << "epoll_ctl(): " << strerror(errno);
+            ok = false;
+        }
+    }
+    foreach (const QByteArray& trigger, changedTriggers) {
+        ok = updateTrigger(trigger) && ok;
+        applyTriggerRate(trigger);
+    }
+    return ok;
+}
+
+void SysfsAdaptorReader::setTriggerRate(const QByteArray& trigger)
+{
+    QMutexLocker locker(&mutex_);
+    applyTriggerRate(trigger);
+}
+
+bool SysfsAdaptorReader::setPolled(quint64 id, Registration& registration, bool poll)
+{
+    if (registration.polled == poll)
+        return true;
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(epoll_event));
+    ev.events = EPOLLIN;
+    ev.data.u64 = id;
+    if (epoll_ctl(epollDescriptor_, poll ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, registration.fd, &ev) == -1) {
+        sensordLogW() << "epoll_ctl(): " << strerror(errno);
+        return false;
+    }
+    registration.polled = poll;
+    return true;
+}
+
+bool SysfsAdaptorReader::updateTrigger(const QByteArray& trigger)
+{
+    const QList<quint64> members = triggers_.value(trigger).members;
+
+    // Keep the current leader while it is unparked, so the epoll set
+    // only changes when it has to.
+    quint64 leader = 0;
+    bool hasLeader = false;
+    foreach (quint64 id, members) {
+        const Registration& registration = registrations_[id];
+        if (!registration.parked && (!hasLeader || registration.polled)) {
+            leader = id;
+            hasLeader = true;
+        }
+    }
+
+    bool ok = true;
+    foreach (quint64 id, members) {
+        ok = setPolled(id, registrations_[id], hasLeader && id == leader) && ok;
+    }
+    return ok;
+}
+
+void SysfsAdaptorReader::applyTriggerRate(const QByteArray& trigger)
+{
+    QHash<QByteArray, Trigger>::const_iterator group = triggers_.constFind(trigger);
+    if (group == triggers_.constEnd())
+        return;
+
+    unsigned int interval = 0;
+    foreach (quint64 id, group.value().members) {
+        const Registration& registration = registrations_[id];
+        unsigned int requested = registration.adaptor->interval_.loadAcquire();
+        if (!registration.parked && requested && (!interval || requested < interval))
+            interval = requested;
+    }
+    if (!interval)
+        return;
+
+    QByteArray frequency = QByteArray::number(qMax(1u, 1000 / interval));
+    if (!group.value().frequencyPath.isEmpty())
+        SysfsAdaptor::writeToFile(group.value().frequencyPath, frequency);
+
+    foreach (quint64 id, group.value().members) {
+        SysfsAdaptor* adaptor = registrations_[id].adaptor;
+        QByteArray frequencyPath = (adaptor->iioDevicePath_ + "/sampling_frequency").toLocal8Bit();
+        if (QFile::exists(frequencyPath))
+            SysfsAdaptor::writeToFile(frequencyPath, frequency);
+        adaptor->triggerInterval_ = interval;
+    }
+    sensordLogD() << "IIO trigger " << trigger << " running at " << frequency << " Hz";
+}
+
+QString SysfsAdaptorReader::triggerDirectory(const QByteArray& trigger)
+{
+    QDir devices("/sys/bus/iio/devices");
+    foreach (const QString& entry, devices.entryList(QStringList() << "trigger*", QDir::Dirs | QDir::System)) {
+        QFile name(devices.filePath(entry) + "/name");
+        if (name.open(QIODevice::ReadOnly) && name.readAll().trimmed() == trigger)
+            return devices.filePath(entry);
+    }
+    sensordLogD() << "IIO trigger " << trigger << " has no sysfs directory, rate set on devices only";
+    return QString();
+}
+
+void SysfsAdaptorReader::run()
+{
+    static const int MAX_EVENTS = 16;
+    struct epoll_event events[MAX_EVENTS];
+
+    ThreadScheduling::apply("sysfsreader");
+
+    for (;;) {
+        int descriptors = epoll_wait(epollDescriptor_, events, MAX_EVENTS, -1);
+
+        if (descriptors == -1) {
+            if (errno != EINTR) {
+                sensordLogW() << "epoll_wait(): " << strerror(errno);
                 QThread::msleep(1000);
-            } else {
-                bool errorInInput = false;
-                for (int i = 0; i < descriptors; ++i) {
-                    if (events[i].events & (EPOLLHUP | EPOLLERR)) {
-                        //Note: we ignore error so the sensordiverter.sh works. This should be handled better when testcases are improved.
-                        sensordLogD() << "epoll_wait(): error in input fd";
-                        errorInInput = true;
-                    }
-                    int index = parent_->sysfsDescriptors_.lastIndexOf(events[i].data.fd);
-                    if (index != -1) {
-                        parent_->processSample(parent_->pathIds_.at(index), events[i].data.fd);
-
-                        if (parent_->doSeek_)
-                        {
-                            if (lseek(events[i].data.fd, 0, SEEK_SET) == -1)
-                            {
-                                sensordLogW() << "Failed to lseek fd: " << strerror(errno);
-                                QThread::msleep(1000);
-                            }
-                        }
-                    } else if (events[i].data.fd == parent_->pipeDescriptors_[0]) {
-                        running_ = false;
-                    }
-                }
-                if (errorInInput)
-                    QThread::msleep(50);
             }
-        } else { //IntervalMode
-
-            // Read through all fds.
-            for (int i = 0; i < parent_->sysfsDescriptors_.size(); ++i) {
-                parent_->processSample(parent_->pathIds_.at(i), parent_->sysfsDescriptors_.at(i));
-
-                if (parent_->doSeek_)
-                {
-                    if (lseek(parent_->sysfsDescriptors_.at(i), 0, SEEK_SET) == -1)
-                    {
-                        sensordLogW() << "Failed to lseek fd: " << strerror(errno);
-                        QThread::msleep(1000);
-                    }
-                }
+            continue;
+        }
+
+        bool errorInInput = false;
+        for (int i = 0; i < descriptors; ++i) {
+            QMutexLocker locker(&mutex_);
+
+            // Registration may have been removed after the wait returned.
+            QHash<quint64, Registration>::const_iterator it = registrations_.find(events[i].data.u64);
+            if (it == registrations_.end() || it.value().parked)
+                continue;
+
+            if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                //Note: we ignore error so the sensordiverter.sh works. This should be handled better when testcases are improved.
+                sensordLogD() << "epoll_wait(): error in input fd";
+                errorInInput = true;
+            }
+
+            if (it.value().trigger.isEmpty()) {
+                it.value().adaptor->dispatch(it.value().index, it.value().fd);
+                continue;
             }
 
-            // Sleep for interval
-            QThread::msleep(parent_->interval());
+            // Every device on the trigger sampled in the same tick, so
+            // the wakeup of the leader reads all of them. A scan not yet
+            // in its buffer is read on the next wakeup.
+            foreach (quint64 id, triggers_.value(it.value().trigger).members) {
+                const Registration& member = registrations_[id];
+                if (!member.parked)
+                    member.adaptor->dispatch(member.index, member.fd);
+            }
         }
+        if (errorInInput)
+            QThread::msleep(50);
     }
 }
 
@@ -488,6 +1256,14 @@ void SysfsAdaptor::init()
     }
     mode_ = (PollMode)Config::configuration()->value<int>(name() + "/mode", mode_);
     doSeek_ = Config::configuration()->value<bool>(name() + "/seek", doSeek_);
+    iioBufferLength_ = Config::configuration()->value<unsigned int>(name() + "/iio_buffer_length", iioBufferLength_);
+    iioTrigger_ = Config::configuration()->value<QString>(name() + "/iio_trigger", "").toLocal8Bit();
+    QString watermarkPath = Config::configuration()->value<QString>(id() + "/fifo_watermark_path", "");
+    if (!watermarkPath.isEmpty())
+        fifoWatermarkPath_ = watermarkPath.toLocal8Bit();
+    fifoTimeoutPath_ = Config::configuration()->value<QString>(id() + "/fifo_timeout_path", "").toLocal8Bit();
+    warmStandby_ = Config::configuration()->value<bool>("global/warm_standby", canCacheFds());
+    warmStandby_ = Config::configuration()->value<bool>(id() + "/warm_standby", warmStandby_);
 
     introduceAvailableDataRanges(name());
     introduceAvailableIntervals(name());
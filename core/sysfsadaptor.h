@@ -31,18 +31,23 @@
 
 #include "deviceadaptor.h"
 #include "deviceadaptorringbuffer.h"
+#include "iioscanlayout.h"
 #include <QString>
 #include <QStringList>
 #include <QThread>
 #include <QMutex>
+#include <QAtomicInt>
 #include <QFile>
+#include <QHash>
 
 class SysfsAdaptor;
 
 /**
- * Threading functionality for SysfsAdaptor. Helper class that removes
- * ambiguous inheritance from QObject. Should not be invoked directly
- * by anything except #SysfsAdaptor.
+ * Reader thread shared by all SysfsAdaptor instances. File descriptors
+ * of running adaptors are registered to a single epoll descriptor and
+ * events are dispatched to the owning adaptor, so idle adaptors do not
+ * each keep a thread waiting. Should not be invoked directly by
+ * anything except #SysfsAdaptor.
  */
 class SysfsAdaptorReader : public QThread
 {
@@ -51,50 +56,154 @@ class SysfsAdaptorReader : public QThread
 
 public:
     /**
-     * Constructor.
+     * Get the shared reader. Thread is started on first use.
+     *
+     * @return reader instance.
+     */
+    static SysfsAdaptorReader& instance();
+
+    /**
+     * Start monitoring file descriptor for an adaptor.
      *
-     * @param parent Parent object.
+     * @param adaptor adaptor to dispatch events to.
+     * @param fd      file descriptor to monitor.
+     * @param index   index of the path of the descriptor, -1 for the
+     *                interval timer.
+     * @param trigger name of the IIO trigger driving the descriptor. All
+     *                descriptors sharing a trigger are read together on
+     *                the first one becoming readable, see #setTriggerRate().
+     * @return was descriptor added.
      */
-    SysfsAdaptorReader(SysfsAdaptor *parent);
+    bool add(SysfsAdaptor* adaptor, int fd, int index, const QByteArray& trigger = QByteArray());
 
+    /**
+     * Stop monitoring all descriptors of an adaptor. When this returns
+     * the adaptor is not called from the reader thread any more. Must
+     * not be called from the reader thread.
+     *
+     * @param adaptor adaptor.
+     */
+    void remove(SysfsAdaptor* adaptor);
+
+    /**
+     * Park or unpark all descriptors of an adaptor. Parked descriptors
+     * stay in the epoll set but do not wake the reader, so unparking
+     * costs one epoll_ctl() per descriptor and nothing is reopened.
+     *
+     * @param adaptor adaptor.
+     * @param parked  should events be ignored.
+     * @return were all descriptors changed.
+     */
+    bool park(SysfsAdaptor* adaptor, bool parked);
+
+    /**
+     * Program a shared IIO trigger for the fastest interval requested by
+     * the running adaptors it drives. The rate is written to the
+     * <tt>sampling_frequency</tt> of the trigger and of each device, so
+     * every device produces one scan per trigger and the scans of a
+     * wakeup belong together.
+     *
+     * @param trigger name of the trigger.
+     */
+    void setTriggerRate(const QByteArray& trigger);
+
+protected:
     /**
      * Reader thread entry-function.
      */
     void run();
 
+private:
+    /**
+     * Monitored descriptor.
+     */
+    struct Registration
+    {
+        SysfsAdaptor* adaptor; /**< owning adaptor */
+        int           fd;      /**< file descriptor */
+        int           index;   /**< path index, -1 for timer */
+        bool          parked;  /**< are events ignored */
+        bool          polled;  /**< is descriptor in the epoll set */
+        QByteArray    trigger; /**< shared IIO trigger, empty if none */
+    };
+
     /**
-     * Initiate reader stopping.
+     * Descriptors driven by one IIO trigger. Only one unparked member,
+     * the leader, is in the epoll set; its wakeup reads all of them.
      */
-    void stopReader();
+    struct Trigger
+    {
+        QByteArray     frequencyPath; /**< sampling_frequency of the trigger, empty if none */
+        QList<quint64> members;       /**< registrations driven by the trigger */
+    };
+
+    SysfsAdaptorReader();
 
     /**
-     * Initiate reader starting.
+     * Put the leader of a trigger into the epoll set and the other
+     * members out of it. Caller must hold #mutex_.
+     *
+     * @param trigger name of the trigger.
+     * @return was the epoll set changed.
      */
-    void startReader();
+    bool updateTrigger(const QByteArray& trigger);
 
-private:
-    bool          running_; /**< should thread be running or not */
-    SysfsAdaptor *parent_;  /**< parent object. */
+    /**
+     * Unlocked #setTriggerRate().
+     *
+     * @param trigger name of the trigger.
+     */
+    void applyTriggerRate(const QByteArray& trigger);
+
+    /**
+     * Find the sysfs directory of an IIO trigger.
+     *
+     * @param trigger name of the trigger.
+     * @return directory, empty if not found.
+     */
+    static QString triggerDirectory(const QByteArray& trigger);
+
+    /**
+     * Add or remove a descriptor from the epoll set.
+     *
+     * @param id           registration ID.
+     * @param registration registration to change.
+     * @param poll         should the descriptor wake the reader.
+     * @return was the epoll set changed.
+     */
+    bool setPolled(quint64 id, Registration& registration, bool poll);
+
+    int                            epollDescriptor_; /**< shared epoll descriptor */
+    quint64                        nextId_;          /**< ID of the next registration */
+    QHash<quint64, Registration>   registrations_;   /**< registrations by ID */
+    QHash<QByteArray, Trigger>     triggers_;        /**< shared IIO triggers by name */
+    QMutex                         mutex_;           /**< protects registrations and dispatching */
 };
 
 /**
  * @brief Base class for adaptors accessing device drivers through sysfs.
  *
- * Two different polling modes are supported:
+ * Three different polling modes are supported:
  * <ul>
- *   <li><tt>SysfsAdaptor::IntervalMode</tt> - Read constantly by given frequency (ms delay between reads).</li>
+ *   <li><tt>SysfsAdaptor::IntervalMode</tt> - Read constantly by given frequency. Reads are
+ *       driven by a periodic timer, so read time does not add to the period.</li>
  *   <li><tt>SysfsAdaptor::SelectMode</tt>   - Wait for interrupt from driver before reading.</li>
+ *   <li><tt>SysfsAdaptor::IioBufferMode</tt> - Read binary scan frames in bulk from an IIO
+ *       character device. Set up with #addIioDevice().</li>
  * </ul>
  *
  * Simultaneous monitoring of several files is supported by giving unique
- * index for each file.
+ * index for each file. Files which together make one sample, like one
+ * attribute per axis, can be added as a group with #addPathGroup() and
+ * are then read back to back in a single #processPathGroup() call.
  */
 class SysfsAdaptor : public DeviceAdaptor
 {
 public:
     enum PollMode {
         SelectMode = 0, /**< Wait for interrupt from driver before reading. */
-        IntervalMode    /**< Read constantly with given frequency. */
+        IntervalMode,   /**< Read constantly with given frequency. */
+        IioBufferMode   /**< Read scan frames from IIO device buffer. */
     };
 
     /**
@@ -124,6 +233,37 @@ public:
      */
     bool addPath(const QString& path, const int id = 0);
 
+    /**
+     * Add files which are always read together. In SelectMode only the
+     * first file is monitored, in IntervalMode the group is read on each
+     * period; either way all files are handed to #processPathGroup() at
+     * once, so the adaptor can commit a complete sample. Adaptor must be
+     * restarted to get the group into monitoring list.
+     *
+     * @param paths Paths of the files, at most #MAX_GROUP_SIZE.
+     * @param id    Identifier for the group (used as parameter to processPathGroup).
+     * @return      True on success, false if some file does not exist.
+     */
+    bool addPathGroup(const QStringList& paths, const int id = 0);
+
+    /**
+     * Maximum number of files in a path group.
+     */
+    static const int MAX_GROUP_SIZE = 8;
+
+    /**
+     * Monitor the buffer of an IIO device instead of separate sysfs
+     * files. Given scan elements are enabled and the character device
+     * of the IIO device is added as path. Switches the adaptor to
+     * #IioBufferMode; frames are delivered to #processScanFrames().
+     *
+     * @param devicePath sysfs directory of the IIO device.
+     * @param channels   scan element names, for example <tt>in_accel_x</tt>.
+     * @param id         Identifier for the path (used as parameter to processScanFrames).
+     * @return           True on success, false otherwise.
+     */
+    bool addIioDevice(const QString& devicePath, const QStringList& channels, const int id = 0);
+
     /**
      * Start adaptor and open required resources.
      *
@@ -146,10 +286,32 @@ public:
     virtual bool startSensor();
     virtual void stopSensor();
 
+    /**
+     * Opening the files and registering them to the reader thread are
+     * safe in a pool thread.
+     */
+    virtual bool startsConcurrently() const { return true; }
+
+    /**
+     * Go into standby. With warm standby the descriptors stay open and
+     * registered to the reader, which only stops dispatching them, and
+     * the interval timer is disarmed. Enabled with <tt>warm_standby</tt>
+     * in the adaptor group or <tt>global/warm_standby</tt>, by default
+     * for adaptors whose files all are under <tt>/sys</tt>.
+     */
     virtual bool standby();
 
     virtual bool resume();
 
+    /**
+     * Hardware FIFO depth when the adaptor has a FIFO watermark, see
+     * #applyFifoWatermark(). Otherwise buffering is done by sensord.
+     */
+    virtual IntegerRangeList getAvailableBufferSizes(bool& hwSupported) const;
+    virtual IntegerRangeList getAvailableBufferIntervals(bool& hwSupported) const;
+    virtual unsigned int bufferSize() const;
+    virtual unsigned int bufferInterval() const;
+
 protected:
     /**
      * Called when new data is available on some file descriptor.
@@ -163,9 +325,68 @@ protected:
      */
     virtual void processSample(int pathId, int fd) = 0;
 
+    /**
+     * Called for each monitored file when the adaptor starts or resumes,
+     * before events of the file are dispatched. Files monitored in
+     * SelectMode only report changes, so without this a new user gets
+     * nothing until the state next changes. If this returns false and
+     * the files of the path are under <tt>/sys</tt>, they are read once
+     * like on an interrupt.
+     *
+     * @param pathId Path ID for the file.
+     * @param fd     Open file descriptor, must not be closed.
+     * @return was the state read, default implementation returns false.
+     */
+    virtual bool readInitialState(int pathId, int fd);
+
+    /**
+     * Called with all files of a group added with #addPathGroup() when
+     * the group is to be read. Default implementation calls
+     * #processSample() for each file.
+     *
+     * @param groupId Identifier given to #addPathGroup().
+     * @param fds     Open file descriptors, in the order the paths were given.
+     * @param count   Number of descriptors.
+     */
+    virtual void processPathGroup(int groupId, const int* fds, int count);
+
+    /**
+     * Called in #IioBufferMode with the scan frames read from the
+     * device buffer. All frames available at once are delivered in a
+     * single call. Default implementation does nothing.
+     *
+     * @param pathId Path ID given to #addIioDevice().
+     * @param frames Frame data, use #scanLayout() to decode it.
+     * @param count  Number of frames.
+     */
+    virtual void processScanFrames(int pathId, const char* frames, int count);
+
+    /**
+     * Layout of the scan frames in #IioBufferMode.
+     *
+     * @return scan layout.
+     */
+    const IioScanLayout& scanLayout() const;
+
+    /**
+     * Timestamp of a frame delivered to #processScanFrames(). Uses the
+     * timestamp channel of the device when it runs on the monotonic
+     * clock. Otherwise the clock is read once per batch and the frames
+     * before the last one are spaced back at the configured interval,
+     * or at the rate of the shared trigger, see <tt>iio_trigger</tt>.
+     *
+     * @param frames Frame data given to #processScanFrames().
+     * @param index  Index of the frame.
+     * @param count  Number of frames.
+     * @return timestamp in microsecs.
+     */
+    quint64 scanFrameTimeStamp(const char* frames, int index, int count) const;
+
     /**
      * Utility function for writing to files. Can be used to control
      * sensor driver parameters (setting to powersave mode etc.)
+     * Descriptors of sysfs attributes are kept open and writes of the
+     * value last written are skipped.
      *
      * @param path    Path of the file to write to
      * @param content What to write
@@ -174,13 +395,56 @@ protected:
     static bool writeToFile(const QByteArray& path, const QByteArray& content);
 
     /**
-     * Utility function for reading from sysfs entries.
+     * Utility function for reading from sysfs entries. Attributes
+     * written through #writeToFile() return the value last written.
      *
      * @param path    Path of the file to read from
      * @return Content of the file
      */
     static QByteArray readFromFile(const QByteArray& path);
 
+    /**
+     * Write to a file now if the adaptor is running, otherwise right
+     * before the reader is next started. Used for rate attributes, so
+     * changes made while the sensor is off do not wake the driver and
+     * are applied together with the power up. Later writes to the same
+     * path replace pending ones.
+     *
+     * @param path    Path of the file to write to
+     * @param content What to write
+     * @return True on success, false on failure.
+     */
+    bool writeWhenRunning(const QByteArray& path, const QByteArray& content);
+
+    /**
+     * Read integer values from an open sysfs attribute. The attribute
+     * is read from the beginning with pread(), so the descriptor does
+     * not need to be rewound, and adaptors using this can pass
+     * <tt>seek = false</tt> to the constructor. Nothing is allocated, so
+     * this is cheap enough to call for every sample.
+     *
+     * @param fd     open file descriptor.
+     * @param values array for the values.
+     * @param count  maximum number of values to read.
+     * @param base   10 or 16. A <tt>0x</tt> prefix is accepted in base 16.
+     * @return number of values read, -1 if reading failed.
+     */
+    static int readValues(int fd, int* values, int count, int base = 10);
+
+    /**
+     * Parse integer values separated by whitespace, commas or colons,
+     * for example <tt>"12 -4 980\n"</tt> or <tt>"ff3a:0012:0100"</tt>.
+     * Parsing stops at the first character which is neither.
+     *
+     * @param data   text to parse.
+     * @param size   length of the text.
+     * @param values array for the values.
+     * @param count  maximum number of values to parse.
+     * @param base   10 or 16.
+     * @return number of values parsed.
+     */
+    static int parseValues(const char* data, int size, int* values, int count, int base = 10);
+
 protected:
     /**
      * Returns the current interval. Valid for PollMode.
@@ -192,8 +456,9 @@ protected:
 
     /**
      * Sets the interval for the adaptor. This function is valid for
-     * adaptors using PollMode. It just sets the number of milliseconds
-     * that the adaptor will sleep between reads.
+     * adaptors using PollMode. It sets the period in milliseconds of
+     * the timer driving the reads; a running reader picks up the new
+     * period immediately.
      *
      * For adaptors using SelectMode, reimplementation is a must as this
      * implementatino will have no effect on the behavior.
@@ -213,6 +478,33 @@ protected:
      */
     PollMode mode() const;
 
+    virtual bool setBufferSize(unsigned int value);
+    virtual bool setBufferInterval(unsigned int value);
+
+    /**
+     * Buffer also holds a full hardware FIFO, one watermark interrupt
+     * may deliver all of it in a single read.
+     */
+    virtual unsigned int bufferCapacity(unsigned int minimum) const;
+
+    /**
+     * Program the hardware FIFO of the chip from the buffer size and
+     * buffer interval of the sessions, so that the driver reports a
+     * batch of samples per watermark interrupt instead of one sample
+     * per interrupt. The watermark is the buffer size, or the buffer
+     * interval divided by #interval(), limited to the FIFO depth.
+     *
+     * Configured with <tt>fifo_watermark_path</tt>, the sysfs attribute
+     * taking the watermark in samples, <tt>fifo_size</tt>, the FIFO
+     * depth, and optionally <tt>fifo_timeout_path</tt>, an attribute
+     * taking the buffer interval in milliseconds. In #IioBufferMode the
+     * <tt>buffer/watermark</tt> attribute of the device is used when
+     * present. Subclasses call this when their interval changes.
+     *
+     * @return was watermark written, true when there is no FIFO.
+     */
+    bool applyFifoWatermark();
+
 private:
     /**
      * Opens all file descriptors required by the adaptor.
@@ -222,12 +514,51 @@ private:
     bool openFds();
 
     /**
-     * Closes all file descriptors.
-     *
-     * @return were files closed succesfully.
+     * Closes all file descriptors. Descriptors of sysfs attributes are
+     * kept open for the next start, see #canCacheFds().
      */
     void closeAllFds();
 
+    /**
+     * Close sysfs descriptors, including ones kept open by
+     * #closeAllFds(). Caller must hold #mutex_.
+     */
+    void closeSysfsFds();
+
+    /**
+     * Can sysfs descriptors be kept open while the adaptor is stopped.
+     * Only attributes under <tt>/sys</tt> are, opening device nodes may
+     * power up the hardware.
+     *
+     * @return can descriptors be cached.
+     */
+    bool canCacheFds() const;
+
+    /**
+     * Stop dispatching events for warm standby, see #standby().
+     */
+    void parkReader();
+
+    /**
+     * Undo #parkReader(). Falls back to reopening everything if the
+     * parked descriptors can not be reused.
+     *
+     * @return is the reader running again.
+     */
+    bool unparkReader();
+
+    /**
+     * Push the current state of SelectMode files into the buffers, see
+     * #readInitialState(). Must be called while the descriptors are not
+     * dispatched by the reader.
+     */
+    void pushInitialState();
+
+    /**
+     * Write the values queued by #writeWhenRunning().
+     */
+    void flushPendingWrites();
+
     /**
      * Stop reader thread.
      */
@@ -245,19 +576,88 @@ private:
      */
     bool checkIntervalUsage() const;
 
-    SysfsAdaptorReader  reader_; /**< reader thread instance */
+    /**
+     * Arm the IntervalMode timer with the current interval. The first
+     * expiry is one interval from now, following ones are at absolute
+     * multiples of the interval, so the period does not drift.
+     */
+    void armTimer();
+
+    /**
+     * Enable or disable the IIO device buffer.
+     *
+     * @param enable should buffer be enabled.
+     * @return was the buffer state changed succesfully.
+     */
+    bool enableIioBuffer(bool enable);
+
+    /**
+     * Depth of the hardware FIFO, <tt>fifo_size</tt> or the IIO buffer
+     * length.
+     *
+     * @return FIFO size in samples, 0 if unknown.
+     */
+    unsigned int fifoSize() const;
+
+    /**
+     * Is a hardware FIFO watermark configured.
+     *
+     * @return does the adaptor batch in hardware.
+     */
+    bool hasFifo() const;
+
+    /**
+     * Handle an event from the reader thread.
+     *
+     * @param index path index, -1 for the interval timer.
+     * @param fd    descriptor with the event.
+     */
+    void dispatch(int index, int fd);
+
+    /**
+     * Read path, or the group starting at it.
+     *
+     * @param index path index.
+     */
+    void readPath(int index);
+
+    /**
+     * Read all available scan frames from IIO device and pass them to
+     * #processScanFrames().
+     *
+     * @param pathId path ID.
+     * @param fd     open IIO character device.
+     */
+    void readScanFrames(int pathId, int fd);
+
     PollMode            mode_;   /**< used poll mode */
-    int                 epollDescriptor_;    /**< open epoll descriptors */
-    int                 pipeDescriptors_[2]; /**< open pipe descriptors */
+    int                 timerDescriptor_;    /**< IntervalMode timerfd */
     QStringList         paths_;   /**< added paths. */
     QList<int>          pathIds_; /**< added path IDs. */
-    unsigned int interval_; /**< used interval */
+    QList<int>          groupSizes_; /**< files in the group starting at each path, 0 for group members. */
+    QAtomicInt interval_;   /**< used interval, also read by the reader thread */
     bool inStandbyMode_;    /**< are we in standby */
     bool running_;          /**< are we running */
     bool shouldBeRunning_;  /**< should we be running */
     bool doSeek_;           /**< should lseek() be performed after reading */
+    bool warmStandby_;      /**< keep descriptors open in standby */
+    bool parked_;           /**< in warm standby with descriptors open */
     QList<int> sysfsDescriptors_; /**< List of open file descriptors. */
     QMutex mutex_;          /** mutex protecting starting and stopping. */
+    QString iioDevicePath_;        /**< sysfs directory of IIO device */
+    IioScanLayout scanLayout_;     /**< IIO scan frame layout */
+    unsigned int iioBufferLength_; /**< IIO buffer length in frames */
+    QByteArray scanBuffer_;        /**< buffer for reading scan frames */
+    bool monotonicScanTimestamps_; /**< are IIO timestamps on the monotonic clock */
+    quint64 scanBatchTime_;        /**< time the current batch of frames was read */
+    QByteArray iioTrigger_;        /**< IIO trigger of the device, empty if own */
+    unsigned int triggerInterval_; /**< interval of the shared trigger, 0 if not shared */
+    QList<QPair<QByteArray, QByteArray> > pendingWrites_; /**< writes waiting for the start */
+    QByteArray fifoWatermarkPath_; /**< FIFO watermark attribute, empty if none */
+    QByteArray fifoTimeoutPath_;   /**< FIFO timeout attribute, empty if none */
+    unsigned int fifoWatermark_;   /**< watermark in use */
+    unsigned int bufferSize_;      /**< requested buffer size */
+    unsigned int bufferInterval_;  /**< requested buffer interval */
 
     friend class SysfsAdaptorReader;
 };
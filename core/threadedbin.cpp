@@ -0,0 +1,87 @@
+/**
+   @file threadedbin.cpp
+   @brief ThreadedBin
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "threadedbin.h"
+#include "pusher.h"
+
+ThreadedBin::ThreadedBin() :
+    scheduled_(0)
+{
+}
+
+ThreadedBin::~ThreadedBin()
+{
+    // Pushers may be gone already, only wait for a queued run.
+    QMutexLocker locker(&mutex_);
+    drain();
+}
+
+void ThreadedBin::start()
+{
+    QMutexLocker locker(&mutex_);
+    if (!wakeups_.isEmpty())
+        return;
+    foreach (Pusher* pusher, pushers())
+    {
+        Wakeup* wakeup = new Wakeup(this, pusher);
+        wakeups_.append(wakeup);
+        pusher->setReadyCallback(wakeup);
+    }
+}
+
+void ThreadedBin::stop()
+{
+    QMutexLocker locker(&mutex_);
+    foreach (Wakeup* wakeup, wakeups_)
+        wakeup->pusher_->resetReadyCallback();
+    drain();
+}
+
+void ThreadedBin::drain()
+{
+    while (scheduled_.loadAcquire())
+        idle_.wait(&mutex_);
+    qDeleteAll(wakeups_);
+    wakeups_.clear();
+}
+
+void ThreadedBin::Wakeup::operator()() const
+{
+    // One pending wakeup covers all data written before it is handled.
+    if (pending_.testAndSetOrdered(0, 1) && bin_->scheduled_.testAndSetOrdered(0, 1))
+        WorkerPool::instance().submit(bin_);
+}
+
+void ThreadedBin::run()
+{
+    QMutexLocker locker(&mutex_);
+    // Wakeups from now on queue the bin again; that run waits for this
+    // one, which keeps the order.
+    scheduled_.fetchAndStoreOrdered(0);
+    foreach (Wakeup* wakeup, wakeups_)
+    {
+        if (wakeup->pending_.fetchAndStoreOrdered(0))
+            wakeup->pusher_->pushNewData();
+    }
+    idle_.wakeAll();
+}
@@ -0,0 +1,100 @@
+/**
+   @file threadedbin.h
+   @brief ThreadedBin
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef THREADEDBIN_H
+#define THREADEDBIN_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QList>
+#include "bin.h"
+#include "callback.h"
+#include "workerpool.h"
+
+/**
+ * Bin run by the shared WorkerPool. While the bin is started, new data
+ * in the buffers of its pushers does not run the filters in the writing
+ * thread: the bin is queued to the pool, and a pool thread pushes the
+ * data through. At most one pool thread runs a bin at a time, so the
+ * samples of a bin stay in order while different bins run in parallel.
+ *
+ * Enabled for a node with <tt>worker_pool = true</tt> in the group of
+ * its ID, see Bin::create().
+ */
+class ThreadedBin : public Bin, private WorkerPool::Task
+{
+public:
+    /**
+     * Constructor.
+     */
+    ThreadedBin();
+
+    /**
+     * Destructor. Waits for a queued run of the bin to finish.
+     */
+    ~ThreadedBin();
+
+    /**
+     * Run the pushers of the bin in the pool.
+     */
+    void start();
+
+    /**
+     * Push data in the writing threads again. When this returns no pool
+     * thread runs the bin.
+     */
+    void stop();
+
+private:
+    /**
+     * Wakeup callback given to a pusher of the bin.
+     */
+    class Wakeup : public CallbackBase
+    {
+    public:
+        Wakeup(ThreadedBin* bin, Pusher* pusher) :
+            bin_(bin), pusher_(pusher), pending_(0) {}
+
+        void operator()() const;
+
+        ThreadedBin*       bin_;     /**< owning bin */
+        Pusher*            pusher_;  /**< pusher to run */
+        mutable QAtomicInt pending_; /**< has pusher been woken up */
+    };
+
+    void run();
+
+    /**
+     * Wait for a queued run to finish and delete the wakeups. Called
+     * with mutex_ locked.
+     */
+    void drain();
+
+    QList<Wakeup*> wakeups_;   /**< wakeups of the pushers */
+    QMutex         mutex_;     /**< protects wakeups_ and processing */
+    QWaitCondition idle_;      /**< signalled when a queued run is done */
+    QAtomicInt     scheduled_; /**< is bin queued to the pool */
+};
+
+#endif // THREADEDBIN_H
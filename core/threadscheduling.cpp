@@ -0,0 +1,96 @@
+/**
+   @file threadscheduling.cpp
+   @brief ThreadScheduling
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "threadscheduling.h"
+#include "config.h"
+#include "logging.h"
+#include "realtimememory.h"
+#include <QStringList>
+#include <sched.h>
+#include <pthread.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+bool ThreadScheduling::apply(const QString& group)
+{
+    RealtimeMemory::prefaultStack();
+
+    Config* config = Config::configuration();
+    if (!config)
+        return true;
+
+    bool ok = true;
+
+    QVariant affinity = config->value(group + "/cpu_affinity");
+    QStringList cpus = affinity.type() == QVariant::StringList ?
+                       affinity.toStringList() :
+                       affinity.toString().split(',', QString::SkipEmptyParts);
+    if (!cpus.isEmpty())
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        foreach (const QString& cpu, cpus)
+        {
+            bool valid = false;
+            int index = cpu.trimmed().toInt(&valid);
+            if (valid && index >= 0 && index < CPU_SETSIZE)
+                CPU_SET(index, &set);
+        }
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err)
+        {
+            sensordLogW() << "Failed to set CPU affinity of " << group << " thread: " << strerror(err);
+            ok = false;
+        }
+    }
+
+    if (config->exists(group + "/nice"))
+    {
+        // Nice level is per thread on Linux when given the thread ID.
+        int nice = config->value<int>(group + "/nice", 0);
+        if (setpriority(PRIO_PROCESS, syscall(SYS_gettid), nice) == -1)
+        {
+            sensordLogW() << "Failed to set nice level of " << group << " thread: " << strerror(errno);
+            ok = false;
+        }
+    }
+
+    int priority = config->value<int>(group + "/fifo_priority", 0);
+    if (priority > 0)
+    {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = priority;
+        int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err)
+        {
+            sensordLogW() << "Failed to set SCHED_FIFO priority of " << group << " thread: " << strerror(err);
+            ok = false;
+        }
+    }
+
+    return ok;
+}
@@ -0,0 +1,52 @@
+/**
+   @file threadscheduling.h
+   @brief ThreadScheduling
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef THREADSCHEDULING_H
+#define THREADSCHEDULING_H
+
+#include <QString>
+
+/**
+ * Scheduling settings of sensord threads. Settings are read from the
+ * given configuration group:
+ *
+ * - \c cpu_affinity CPUs the thread may run on, for example
+ *   <tt>0,1</tt>. Any CPU when empty.
+ * - \c nice nice level of the thread.
+ * - \c fifo_priority SCHED_FIFO priority. Zero keeps normal scheduling.
+ */
+class ThreadScheduling
+{
+public:
+    /**
+     * Apply settings of given group to the calling thread. Unset keys
+     * leave the thread as it is. The stack of the thread is prefaulted
+     * if #RealtimeMemory is enabled.
+     *
+     * @param group configuration group.
+     * @return were all configured settings applied.
+     */
+    static bool apply(const QString& group);
+};
+
+#endif // THREADSCHEDULING_H
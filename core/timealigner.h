@@ -0,0 +1,275 @@
+/**
+   @file timealigner.h
+   @brief TimeAligner
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef TIMEALIGNER_H
+#define TIMEALIGNER_H
+
+#include <QVector>
+#include <QString>
+#include "orientationdata.h"
+
+/**
+ * How a sample is picked for a time between two buffered samples.
+ */
+enum TimeAlignMode
+{
+    TimeAlignNearest = 0, /**< sample closest in time */
+    TimeAlignInterpolate  /**< linear interpolation of the two samples */
+};
+
+/**
+ * Parse time alignment mode from configuration.
+ *
+ * @param name "nearest" or "interpolate".
+ * @param fallback mode used for unknown names.
+ * @return mode.
+ */
+inline TimeAlignMode timeAlignModeFromString(const QString& name, TimeAlignMode fallback = TimeAlignNearest)
+{
+    if (name == "nearest")
+        return TimeAlignNearest;
+    if (name == "interpolate")
+        return TimeAlignInterpolate;
+    return fallback;
+}
+
+/**
+ * Describes how a sample type is interpolated. The generic version has
+ * no interpolation and picks the nearest sample. A specialization
+ * provides \c interpolate(), which blends \c before and \c after at
+ * \c timestamp, which lies strictly between their timestamps.
+ */
+template <class TYPE>
+struct TimeAlignTraits
+{
+    static TYPE interpolate(const TYPE& before, const TYPE& after, quint64 timestamp)
+    {
+        return timestamp - before.timestamp_ < after.timestamp_ - timestamp ? before : after;
+    }
+};
+
+/**
+ * Linear interpolation of an integer component.
+ */
+inline int timeAlignLerp(int before, int after, quint64 elapsed, quint64 span)
+{
+    return before + (int)(((qint64)after - before) * (qint64)elapsed / (qint64)span);
+}
+
+template <>
+struct TimeAlignTraits<TimedXyzData>
+{
+    static TimedXyzData interpolate(const TimedXyzData& before, const TimedXyzData& after, quint64 timestamp)
+    {
+        quint64 elapsed = timestamp - before.timestamp_;
+        quint64 span = after.timestamp_ - before.timestamp_;
+        return TimedXyzData(timestamp,
+                            timeAlignLerp(before.x_, after.x_, elapsed, span),
+                            timeAlignLerp(before.y_, after.y_, elapsed, span),
+                            timeAlignLerp(before.z_, after.z_, elapsed, span));
+    }
+};
+
+template <>
+struct TimeAlignTraits<CalibratedMagneticFieldData>
+{
+    static CalibratedMagneticFieldData interpolate(const CalibratedMagneticFieldData& before,
+                                                   const CalibratedMagneticFieldData& after,
+                                                   quint64 timestamp)
+    {
+        quint64 elapsed = timestamp - before.timestamp_;
+        quint64 span = after.timestamp_ - before.timestamp_;
+        // Calibration level is not blended, it is a property of the
+        // calibration the sample was made with.
+        return CalibratedMagneticFieldData(timestamp,
+                                           timeAlignLerp(before.x_, after.x_, elapsed, span),
+                                           timeAlignLerp(before.y_, after.y_, elapsed, span),
+                                           timeAlignLerp(before.z_, after.z_, elapsed, span),
+                                           timeAlignLerp(before.rx_, after.rx_, elapsed, span),
+                                           timeAlignLerp(before.ry_, after.ry_, elapsed, span),
+                                           timeAlignLerp(before.rz_, after.rz_, elapsed, span),
+                                           elapsed * 2 < span ? before.level_ : after.level_);
+    }
+};
+
+template <>
+struct TimeAlignTraits<CompassData>
+{
+    static CompassData interpolate(const CompassData& before, const CompassData& after, quint64 timestamp)
+    {
+        quint64 elapsed = timestamp - before.timestamp_;
+        quint64 span = after.timestamp_ - before.timestamp_;
+        CompassData data(elapsed * 2 < span ? before : after);
+        data.timestamp_ = timestamp;
+
+        // Headings are interpolated along the shorter arc.
+        int delta = ((after.degrees_ - before.degrees_) % 360 + 540) % 360 - 180;
+        data.degrees_ = (before.degrees_ + timeAlignLerp(0, delta, elapsed, span) + 360) % 360;
+        return data;
+    }
+};
+
+/**
+ * Short history of an input of a filter with several inputs, for
+ * looking up its value at the time of a sample of another input. Fusion
+ * filters add every sample of their secondary inputs and look them up
+ * at the timestamps of the primary input, instead of combining with
+ * whatever arrived last. The history is a fixed size ring, nothing is
+ * allocated after construction.
+ *
+ * @tparam TYPE sample type. Must have \c timestamp_.
+ * @tparam TRAITS interpolation of the type.
+ */
+template <class TYPE, class TRAITS = TimeAlignTraits<TYPE> >
+class TimeAligner
+{
+public:
+    /**
+     * Constructor.
+     *
+     * @param capacity number of buffered samples. Zero is treated as one.
+     * @param mode how samples between two buffered ones are picked.
+     */
+    TimeAligner(unsigned int capacity = 8, TimeAlignMode mode = TimeAlignNearest) :
+        samples_(capacity ? capacity : 1),
+        mode_(mode),
+        head_(0),
+        count_(0)
+    {
+    }
+
+    /**
+     * Alignment mode.
+     *
+     * @return mode.
+     */
+    TimeAlignMode mode() const { return mode_; }
+
+    /**
+     * Set alignment mode.
+     *
+     * @param mode new mode.
+     */
+    void setMode(TimeAlignMode mode) { mode_ = mode; }
+
+    /**
+     * Number of buffered samples.
+     *
+     * @return sample count.
+     */
+    unsigned int count() const { return count_; }
+
+    /**
+     * Forget buffered samples.
+     */
+    void clear()
+    {
+        head_ = 0;
+        count_ = 0;
+    }
+
+    /**
+     * Add samples. Samples older than the newest buffered one are
+     * ignored, so the history stays sorted.
+     *
+     * @param n number of samples.
+     * @param data samples.
+     */
+    void add(unsigned n, const TYPE* data)
+    {
+        const unsigned int capacity = samples_.size();
+        for (unsigned i = 0; i < n; ++i) {
+            if (count_ && data[i].timestamp_ < latest().timestamp_)
+                continue;
+            samples_[head_] = data[i];
+            head_ = (head_ + 1) % capacity;
+            if (count_ < capacity)
+                ++count_;
+        }
+    }
+
+    /**
+     * Newest buffered sample. Only valid when #count() is not zero.
+     *
+     * @return sample.
+     */
+    const TYPE& latest() const
+    {
+        return at(count_ - 1);
+    }
+
+    /**
+     * Value of the input at given time. Times outside the history give
+     * the oldest or the newest sample, values are not extrapolated.
+     *
+     * @param timestamp time to look up.
+     * @param value set to the value at the time.
+     * @return false if no samples have been added.
+     */
+    bool sample(quint64 timestamp, TYPE& value) const
+    {
+        if (!count_)
+            return false;
+
+        if (timestamp >= latest().timestamp_) {
+            value = latest();
+            return true;
+        }
+
+        // History is short, a linear search from the newest end finds
+        // the usual case of a recent timestamp at once.
+        for (unsigned int i = count_ - 1; i > 0; --i) {
+            const TYPE& before = at(i - 1);
+            if (timestamp < before.timestamp_)
+                continue;
+            const TYPE& after = at(i);
+            if (timestamp == before.timestamp_)
+                value = before;
+            else if (mode_ == TimeAlignInterpolate)
+                value = TRAITS::interpolate(before, after, timestamp);
+            else
+                value = timestamp - before.timestamp_ < after.timestamp_ - timestamp ? before : after;
+            return true;
+        }
+
+        value = at(0);
+        return true;
+    }
+
+private:
+    /**
+     * Buffered sample by age, 0 is the oldest.
+     */
+    const TYPE& at(unsigned int index) const
+    {
+        const unsigned int capacity = samples_.size();
+        return samples_[(head_ + capacity - count_ + index) % capacity];
+    }
+
+    QVector<TYPE> samples_; /**< sample ring */
+    TimeAlignMode mode_;    /**< alignment mode */
+    unsigned int  head_;    /**< next write position */
+    unsigned int  count_;   /**< number of buffered samples */
+};
+
+#endif // TIMEALIGNER_H
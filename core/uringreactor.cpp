@@ -0,0 +1,133 @@
+/**
+   @file uringreactor.cpp
+   @brief UringReactor
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "uringreactor.h"
+#include "logging.h"
+#include "config.h"
+#include <string.h>
+#include <errno.h>
+
+/** Default number of submission queue entries */
+static const unsigned int DEFAULT_URING_ENTRIES = 64;
+
+UringReactor* UringReactor::create()
+{
+    if (Config::configuration() && !Config::configuration()->value<bool>("global/io_uring", true))
+        return NULL;
+    unsigned int entries = DEFAULT_URING_ENTRIES;
+    if (Config::configuration())
+        entries = Config::configuration()->value<unsigned int>("global/io_uring_entries", entries);
+
+    UringReactor* reactor = new UringReactor;
+    int ret = io_uring_queue_init(entries, &reactor->ring_, 0);
+    if (ret < 0) {
+        sensordLogD() << "[UringReactor]: io_uring not available: " << strerror(-ret);
+        delete reactor;
+        return NULL;
+    }
+    sensordLogD() << "[UringReactor]: batching session writes with " << entries << " entries";
+    return reactor;
+}
+
+UringReactor::UringReactor() :
+    batching_(false),
+    failed_(false),
+    queued_(0)
+{
+    memset(&ring_, 0, sizeof(ring_));
+    ring_.ring_fd = -1;
+}
+
+UringReactor::~UringReactor()
+{
+    if (ring_.ring_fd != -1) {
+        end();
+        io_uring_queue_exit(&ring_);
+    }
+}
+
+void UringReactor::begin()
+{
+    batching_ = !failed_;
+}
+
+bool UringReactor::queueSend(int fd, const struct msghdr* msg, int flags, UringSender* sender)
+{
+    if (!batching_)
+        return false;
+
+    struct io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
+    if (!sqe) {
+        complete();
+        sqe = io_uring_get_sqe(&ring_);
+        if (!sqe)
+            return false;
+    }
+    io_uring_prep_sendmsg(sqe, fd, msg, flags);
+    io_uring_sqe_set_data(sqe, sender);
+    senders_.append(sender);
+    ++queued_;
+    return true;
+}
+
+void UringReactor::complete()
+{
+    if (!queued_)
+        return;
+
+    int ret;
+    do {
+        ret = io_uring_submit_and_wait(&ring_, queued_);
+    } while (ret == -EINTR);
+    if (ret < 0) {
+        // Sends stuck in the submission queue can not be taken back, so
+        // the ring is never entered again. Senders see the error as a
+        // failed write.
+        sensordLogW() << "[UringReactor]: io_uring_submit_and_wait(): " << strerror(-ret) << ", disabling";
+        failed_ = true;
+        batching_ = false;
+        foreach (UringSender* sender, senders_)
+            sender->sendCompleted(ret);
+        senders_.resize(0);
+        queued_ = 0;
+        return;
+    }
+
+    while (queued_) {
+        struct io_uring_cqe* cqe = NULL;
+        if (io_uring_wait_cqe(&ring_, &cqe) != 0 || !cqe)
+            break;
+        UringSender* sender = (UringSender*)io_uring_cqe_get_data(cqe);
+        int result = cqe->res;
+        io_uring_cqe_seen(&ring_, cqe);
+        --queued_;
+        sender->sendCompleted(result);
+    }
+    senders_.resize(0);
+}
+
+void UringReactor::end()
+{
+    complete();
+    batching_ = false;
+}
@@ -0,0 +1,115 @@
+/**
+   @file uringreactor.h
+   @brief UringReactor
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef URINGREACTOR_H
+#define URINGREACTOR_H
+
+#include <QVector>
+#include <liburing.h>
+
+/**
+ * Completion callback of a send queued to #UringReactor.
+ */
+class UringSender
+{
+public:
+    virtual ~UringSender() {}
+
+    /**
+     * Called when the send has completed.
+     *
+     * @param result bytes sent, or negative errno.
+     */
+    virtual void sendCompleted(int result) = 0;
+};
+
+/**
+ * Batches the session socket writes of a delivery round into one
+ * io_uring submission. Between #begin() and #end() senders queue their
+ * sendmsg() requests instead of making the calls, and #end() submits
+ * all of them and waits for their completions with a single system
+ * call. Sends use MSG_DONTWAIT, so a full socket completes right away
+ * with -EAGAIN and is handled by the sender as a short write would be.
+ *
+ * The message, its iovecs and the data must stay untouched until the
+ * completion callback. Used from a single thread only.
+ */
+class UringReactor
+{
+public:
+    /**
+     * Set up a ring if the kernel supports io_uring and
+     * <tt>global/io_uring</tt> does not disable it.
+     *
+     * @return reactor, or \c NULL if not available.
+     */
+    static UringReactor* create();
+
+    ~UringReactor();
+
+    /**
+     * Start collecting sends.
+     */
+    void begin();
+
+    /**
+     * Is a batch being collected.
+     *
+     * @return are sends queued instead of made.
+     */
+    bool batching() const { return batching_; }
+
+    /**
+     * Queue a sendmsg() to the batch. A full submission queue is
+     * submitted and completed first.
+     *
+     * @param fd     socket descriptor.
+     * @param msg    message to send, valid until completion.
+     * @param flags  sendmsg() flags.
+     * @param sender completion callback.
+     * @return was the send queued. Not queued outside a batch.
+     */
+    bool queueSend(int fd, const struct msghdr* msg, int flags, UringSender* sender);
+
+    /**
+     * Submit the queued sends and call their completion callbacks. The
+     * batch stays open.
+     */
+    void complete();
+
+    /**
+     * Complete the queued sends and stop collecting.
+     */
+    void end();
+
+private:
+    UringReactor();
+
+    struct io_uring ring_;     /**< submission and completion queues */
+    bool            batching_; /**< is a batch being collected */
+    bool            failed_;   /**< has the ring been given up on */
+    unsigned int    queued_;   /**< sends queued but not completed */
+    QVector<UringSender*> senders_; /**< senders of the queued sends */
+};
+
+#endif // URINGREACTOR_H
@@ -0,0 +1,119 @@
+/**
+   @file workerpool.cpp
+   @brief WorkerPool
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "workerpool.h"
+#include "config.h"
+#include "logging.h"
+#include "threadscheduling.h"
+
+WorkerPool& WorkerPool::instance()
+{
+    static WorkerPool pool;
+    return pool;
+}
+
+WorkerPool::WorkerPool() :
+    next_(0),
+    running_(1)
+{
+    int count = QThread::idealThreadCount();
+    Config* config = Config::configuration();
+    if (config)
+        count = config->value<int>("workerpool/threads", count);
+    if (count < 1)
+        count = 1;
+
+    for (int i = 0; i < count; ++i)
+        workers_.append(new Worker(this, i));
+    foreach (Worker* worker, workers_)
+        worker->start();
+    sensordLogD() << "Worker pool started with " << count << " threads";
+}
+
+WorkerPool::~WorkerPool()
+{
+    running_.fetchAndStoreOrdered(0);
+    tasks_.release(workers_.size());
+    foreach (Worker* worker, workers_)
+        worker->wait();
+    qDeleteAll(workers_);
+}
+
+void WorkerPool::submit(Task* task)
+{
+    Worker* target = NULL;
+    QThread* current = QThread::currentThread();
+    foreach (Worker* worker, workers_)
+    {
+        if (worker == current)
+        {
+            target = worker;
+            break;
+        }
+    }
+    if (!target)
+        target = workers_.at((unsigned int)next_.fetchAndAddRelaxed(1) % workers_.size());
+
+    {
+        QMutexLocker locker(&target->mutex_);
+        target->tasks_.append(task);
+    }
+    tasks_.release();
+}
+
+WorkerPool::Task* WorkerPool::take(int index)
+{
+    {
+        Worker* own = workers_.at(index);
+        QMutexLocker locker(&own->mutex_);
+        if (!own->tasks_.isEmpty())
+            return own->tasks_.takeFirst();
+    }
+    for (int i = 1; i < workers_.size(); ++i)
+    {
+        Worker* victim = workers_.at((index + i) % workers_.size());
+        QMutexLocker locker(&victim->mutex_);
+        if (!victim->tasks_.isEmpty())
+            return victim->tasks_.takeLast();
+    }
+    return NULL;
+}
+
+void WorkerPool::Worker::run()
+{
+    ThreadScheduling::apply("workerpool");
+
+    while (true)
+    {
+        pool_->tasks_.acquire();
+        if (!pool_->running_.loadAcquire())
+            break;
+
+        // Every release is preceded by a queued task, so one is found
+        // once the submitting thread has released its queue.
+        Task* task = NULL;
+        while (!task)
+            task = pool_->take(index_);
+        task->run();
+    }
+}
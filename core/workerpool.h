@@ -0,0 +1,121 @@
+/**
+   @file workerpool.h
+   @brief WorkerPool
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <QThread>
+#include <QMutex>
+#include <QSemaphore>
+#include <QAtomicInt>
+#include <QList>
+
+/**
+ * Small pool of threads shared by all ThreadedBin instances. Each thread
+ * has its own task queue: tasks submitted from a pool thread go to the
+ * queue of that thread, others are spread round robin. An idle thread
+ * takes the oldest task of its own queue and steals the newest task of
+ * another queue when its own is empty, so work of independent bins
+ * spreads over the cores while follow-up work stays on the thread which
+ * produced the data.
+ *
+ * Number of threads is <tt>[workerpool] threads</tt>, by default the
+ * number of cores. Thread scheduling is read from the
+ * <tt>[workerpool]</tt> group, see ThreadScheduling.
+ */
+class WorkerPool
+{
+public:
+    /**
+     * Unit of work run by the pool.
+     */
+    class Task
+    {
+    public:
+        virtual ~Task() {}
+
+        /**
+         * Run the task in a pool thread.
+         */
+        virtual void run() = 0;
+    };
+
+    /**
+     * Get the pool. Threads are started on first use.
+     *
+     * @return pool instance.
+     */
+    static WorkerPool& instance();
+
+    /**
+     * Destructor. Stops the threads, queued tasks are not run.
+     */
+    ~WorkerPool();
+
+    /**
+     * Queue task to be run by a pool thread. Pool does not take
+     * ownership of the task.
+     *
+     * @param task task to run.
+     */
+    void submit(Task* task);
+
+private:
+    /**
+     * Pool thread and its task queue.
+     */
+    class Worker : public QThread
+    {
+    public:
+        Worker(WorkerPool* pool, int index) : pool_(pool), index_(index) {}
+
+        QMutex       mutex_; /**< protects tasks_ */
+        QList<Task*> tasks_; /**< queued tasks */
+
+    protected:
+        void run();
+
+    private:
+        WorkerPool* pool_;  /**< owning pool */
+        int         index_; /**< index of the thread in the pool */
+    };
+
+    WorkerPool();
+    Q_DISABLE_COPY(WorkerPool)
+
+    /**
+     * Take a task for given thread, stealing from the other queues when
+     * the own queue is empty.
+     *
+     * @param index index of the thread.
+     * @return task, or NULL if all queues are empty.
+     */
+    Task* take(int index);
+
+    QList<Worker*> workers_; /**< pool threads */
+    QSemaphore     tasks_;   /**< released for each queued task */
+    QAtomicInt     next_;    /**< next queue for outside submissions */
+    QAtomicInt     running_; /**< should threads keep running */
+};
+
+#endif // WORKERPOOL_H
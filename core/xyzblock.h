@@ -0,0 +1,204 @@
+/**
+   @file xyzblock.h
+   @brief XyzBlock
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef XYZBLOCK_H
+#define XYZBLOCK_H
+
+#include <QVector>
+#include "datatypes/genericdata.h"
+#include "fixedpoint.h"
+
+/**
+ * Batch of #TimedXyzData samples stored as separate arrays per field.
+ * Samples travel through the ring buffers and sockets interleaved with
+ * their timestamps. Kernels which apply the same arithmetic to every
+ * sample load a batch into a block, work over the contiguous axis
+ * arrays, which the compiler can vectorize, and store the result back.
+ * Storage only grows, so a block kept as a member does not allocate
+ * once it has seen the largest batch.
+ */
+class XyzBlock
+{
+public:
+    /**
+     * Constructor.
+     */
+    XyzBlock() : size_(0) {}
+
+    /**
+     * Number of samples in the block.
+     *
+     * @return sample count.
+     */
+    unsigned size() const { return size_; }
+
+    /**
+     * Load samples into the block, replacing the previous contents.
+     *
+     * @param n number of samples.
+     * @param data samples.
+     */
+    void load(unsigned n, const TimedXyzData* data)
+    {
+        reserve(n);
+        quint64* t = timestamps_.data();
+        int* x = x_.data();
+        int* y = y_.data();
+        int* z = z_.data();
+        for (unsigned i = 0; i < n; ++i) {
+            t[i] = data[i].timestamp_;
+            x[i] = data[i].x_;
+            y[i] = data[i].y_;
+            z[i] = data[i].z_;
+        }
+        size_ = n;
+    }
+
+    /**
+     * Store the block as interleaved samples.
+     *
+     * @param data destination for #size() samples.
+     */
+    void store(TimedXyzData* data) const
+    {
+        const quint64* t = timestamps_.constData();
+        const int* x = x_.constData();
+        const int* y = y_.constData();
+        const int* z = z_.constData();
+        for (unsigned i = 0; i < size_; ++i) {
+            data[i].timestamp_ = t[i];
+            data[i].x_ = x[i];
+            data[i].y_ = y[i];
+            data[i].z_ = z[i];
+        }
+    }
+
+    /**
+     * Subtract a constant from every sample.
+     *
+     * @param dx subtracted from x axis.
+     * @param dy subtracted from y axis.
+     * @param dz subtracted from z axis.
+     */
+    void subtract(int dx, int dy, int dz)
+    {
+        int* x = x_.data();
+        int* y = y_.data();
+        int* z = z_.data();
+        for (unsigned i = 0; i < size_; ++i) {
+            x[i] -= dx;
+            y[i] -= dy;
+            z[i] -= dz;
+        }
+    }
+
+    /**
+     * Multiply every sample with a matrix.
+     *
+     * @param m row major 3x3 matrix.
+     */
+    void transform(const FilterScalar m[3][3])
+    {
+        // Coefficients are copied to locals so the loop body does not
+        // reload them through the pointer.
+        const FilterScalar m00 = m[0][0], m01 = m[0][1], m02 = m[0][2];
+        const FilterScalar m10 = m[1][0], m11 = m[1][1], m12 = m[1][2];
+        const FilterScalar m20 = m[2][0], m21 = m[2][1], m22 = m[2][2];
+        int* x = x_.data();
+        int* y = y_.data();
+        int* z = z_.data();
+        for (unsigned i = 0; i < size_; ++i) {
+            const int a = x[i];
+            const int b = y[i];
+            const int c = z[i];
+            x[i] = scalarToInt(m00 * a + m01 * b + m02 * c);
+            y[i] = scalarToInt(m10 * a + m11 * b + m12 * c);
+            z[i] = scalarToInt(m20 * a + m21 * b + m22 * c);
+        }
+    }
+
+    /**
+     * Swap and negate axes of every sample: output axis k is
+     * <tt>sign[k] * input[axis[k]]</tt>.
+     *
+     * @param axis source axis for each output axis.
+     * @param sign sign for each output axis, 1 or -1.
+     */
+    void permute(const int axis[3], const int sign[3])
+    {
+        int* in[3] = { x_.data(), y_.data(), z_.data() };
+        for (unsigned i = 0; i < size_; ++i) {
+            const int v[3] = { in[0][i], in[1][i], in[2][i] };
+            in[0][i] = sign[0] * v[axis[0]];
+            in[1][i] = sign[1] * v[axis[1]];
+            in[2][i] = sign[2] * v[axis[2]];
+        }
+    }
+
+    /**
+     * Timestamps of the samples.
+     *
+     * @return #size() timestamps.
+     */
+    quint64* timestamps() { return timestamps_.data(); }
+
+    /**
+     * X axis of the samples.
+     *
+     * @return #size() values.
+     */
+    int* x() { return x_.data(); }
+
+    /**
+     * Y axis of the samples.
+     *
+     * @return #size() values.
+     */
+    int* y() { return y_.data(); }
+
+    /**
+     * Z axis of the samples.
+     *
+     * @return #size() values.
+     */
+    int* z() { return z_.data(); }
+
+private:
+    void reserve(unsigned n)
+    {
+        if ((unsigned)x_.size() >= n)
+            return;
+        timestamps_.resize(n);
+        x_.resize(n);
+        y_.resize(n);
+        z_.resize(n);
+    }
+
+    QVector<quint64> timestamps_; /**< sample timestamps */
+    QVector<int>     x_;          /**< x axis */
+    QVector<int>     y_;          /**< y axis */
+    QVector<int>     z_;          /**< z axis */
+    unsigned         size_;       /**< number of samples */
+};
+
+#endif // XYZBLOCK_H
@@ -0,0 +1,124 @@
+/**
+   @file datatypeid.h
+   @brief Compile time identifiers of the sample types
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef DATATYPEID_H
+#define DATATYPEID_H
+
+#include <QtGlobal>
+
+class TimedUnsigned;
+class TimedXyzData;
+class TimedXyzFloatData;
+class ProximityData;
+class CalibratedMagneticFieldData;
+class CompassData;
+class PoseData;
+class TapData;
+class TouchData;
+class TimedQuaternionData;
+class PackedQuaternionData;
+class TimedImuData;
+class GestureData;
+
+/**
+ * Identifier of a sample type. Values are stable, new types are only
+ * appended, so they can be used in protocols and stored tables.
+ */
+enum DataTypeId
+{
+    DataTypeUnknown = 0,              /**< type without an identifier */
+    DataTypeTimedUnsigned,            /**< TimedUnsigned */
+    DataTypeTimedXyzData,             /**< TimedXyzData */
+    DataTypeTimedXyzFloatData,        /**< TimedXyzFloatData */
+    DataTypeProximityData,            /**< ProximityData */
+    DataTypeCalibratedMagneticFieldData, /**< CalibratedMagneticFieldData */
+    DataTypeCompassData,              /**< CompassData */
+    DataTypePoseData,                 /**< PoseData */
+    DataTypeTapData,                  /**< TapData */
+    DataTypeTouchData,                /**< TouchData */
+    DataTypeTimedQuaternionData,      /**< TimedQuaternionData */
+    DataTypePackedQuaternionData,     /**< PackedQuaternionData */
+    DataTypeTimedImuData,             /**< TimedImuData */
+    DataTypeGestureData               /**< GestureData */
+};
+
+/**
+ * Maps sample types to DataTypeId without RTTI. Types declared with
+ * DECLARE_DATATYPE_ID() use their identifier as key; any other type
+ * gets the address of a variable of its own, which never collides with
+ * an identifier, so types can always be compared by their key.
+ */
+template <class TYPE>
+struct DataType
+{
+    static const quint32 ID = DataTypeUnknown;
+
+    /**
+     * Key unique to the type.
+     *
+     * @return key.
+     */
+    static quintptr key()
+    {
+        static const char tag = 0;
+        return (quintptr)&tag;
+    }
+
+    /**
+     * Name of the type for log messages.
+     *
+     * @return name.
+     */
+    static const char* name() { return "unregistered type"; }
+};
+
+/**
+ * Declare the identifier of a sample type.
+ *
+ * @param TYPE sample type.
+ * @param TYPEID DataTypeId of the type.
+ */
+#define DECLARE_DATATYPE_ID(TYPE, TYPEID)                       \
+    template <>                                                 \
+    struct DataType<TYPE>                                       \
+    {                                                           \
+        static const quint32 ID = TYPEID;                       \
+        static quintptr key() { return TYPEID; }                \
+        static const char* name() { return #TYPE; }             \
+    };
+
+DECLARE_DATATYPE_ID(TimedUnsigned, DataTypeTimedUnsigned)
+DECLARE_DATATYPE_ID(TimedXyzData, DataTypeTimedXyzData)
+DECLARE_DATATYPE_ID(TimedXyzFloatData, DataTypeTimedXyzFloatData)
+DECLARE_DATATYPE_ID(ProximityData, DataTypeProximityData)
+DECLARE_DATATYPE_ID(CalibratedMagneticFieldData, DataTypeCalibratedMagneticFieldData)
+DECLARE_DATATYPE_ID(CompassData, DataTypeCompassData)
+DECLARE_DATATYPE_ID(PoseData, DataTypePoseData)
+DECLARE_DATATYPE_ID(TapData, DataTypeTapData)
+DECLARE_DATATYPE_ID(TouchData, DataTypeTouchData)
+DECLARE_DATATYPE_ID(TimedQuaternionData, DataTypeTimedQuaternionData)
+DECLARE_DATATYPE_ID(PackedQuaternionData, DataTypePackedQuaternionData)
+DECLARE_DATATYPE_ID(TimedImuData, DataTypeTimedImuData)
+DECLARE_DATATYPE_ID(GestureData, DataTypeGestureData)
+
+#endif // DATATYPEID_H
@@ -23,14 +23,24 @@ HEADERS += xyz.h \
     posedata.h \
     tapdata.h \
     touchdata.h \
-    proximity.h
+    proximity.h \
+    quaterniondata.h \
+    quaternion.h \
+    imudata.h \
+    imu.h \
+    gesturedata.h \
+    gesture.h \
+    datatypeid.h
 
 SOURCES += xyz.cpp \
     orientation.cpp \
     unsigned.cpp \
     compass.cpp \
     utils.cpp \
-    tap.cpp
+    tap.cpp \
+    quaternion.cpp \
+    imu.cpp \
+    gesture.cpp
 
 include(../common-install.pri)
 publicheaders.path  = $${publicheaders.path}/datatypes
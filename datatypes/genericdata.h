@@ -29,6 +29,32 @@
 
 #include <QMetaType>
 
+/**
+ * Compile time assertion. Fails to compile with a negative array size
+ * when condition is false.
+ *
+ * @param condition constant expression to check.
+ * @param name identifier naming the check.
+ */
+#define SENSORFW_STATIC_ASSERT(condition, name) \
+    typedef char sensorfw_static_assert_##name[(condition) ? 1 : -1]
+
+/**
+ * Check the wire layout of a sample type. Samples are written to the
+ * client sockets and sample queues with memcpy and read back by the
+ * client as the same type, so besides being trivially copyable they
+ * must not have padding anywhere but at the end: the timestamp comes
+ * first and the payload follows without holes. Trailing padding only
+ * depends on the alignment of quint64 on the platform.
+ *
+ * @param TYPE sample type.
+ * @param payload size of the fields after the timestamp.
+ */
+#define SENSORFW_WIRE_LAYOUT(TYPE, payload) \
+    SENSORFW_STATIC_ASSERT(sizeof(TYPE) >= sizeof(quint64) + (payload) && \
+                           sizeof(TYPE) < 2 * sizeof(quint64) + (payload), TYPE##_wire_layout); \
+    Q_DECLARE_TYPEINFO(TYPE, Q_MOVABLE_TYPE)
+
 /**
  * A base class for measurement data that contain timestamp.
  */
@@ -73,4 +99,38 @@ public:
 };
 Q_DECLARE_METATYPE ( TimedXyzData )
 
+/**
+ * Vector type measurement data in floating point, for sensors whose
+ * hardware reports floats. Values are in the units of the hardware,
+ * without a detour through scaled integers.
+ */
+class TimedXyzFloatData : public TimedData
+{
+public:
+    /**
+     * Constructor.
+     */
+    TimedXyzFloatData() : TimedData(0), x_(0), y_(0), z_(0) {}
+
+    /**
+     * Constructor.
+     *
+     * @param timestamp monotonic time (microsec)
+     * @param x X coordinate.
+     * @param y Y coordinate.
+     * @param z Z coordinate.
+     */
+    TimedXyzFloatData(const quint64& timestamp, float x, float y, float z) : TimedData(timestamp), x_(x), y_(y), z_(z) {}
+
+    float x_; /**< X value */
+    float y_; /**< Y value */
+    float z_; /**< Z value */
+};
+Q_DECLARE_METATYPE ( TimedXyzFloatData )
+
+SENSORFW_STATIC_ASSERT(sizeof(TimedData) == sizeof(quint64), TimedData_wire_layout);
+Q_DECLARE_TYPEINFO(TimedData, Q_MOVABLE_TYPE)
+SENSORFW_WIRE_LAYOUT(TimedXyzData, 3 * sizeof(int))
+SENSORFW_WIRE_LAYOUT(TimedXyzFloatData, 3 * sizeof(float))
+
 #endif // GENERICDATA_H
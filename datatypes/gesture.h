@@ -0,0 +1,153 @@
+/**
+   @file gesture.h
+   @brief QObject facade for GestureData
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef GESTURE_H
+#define GESTURE_H
+
+#include <QDBusArgument>
+
+#include <datatypes/gesturedata.h>
+
+/**
+ * QObject facade for #GestureData.
+ */
+class Gesture : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(int type READ type)
+    Q_PROPERTY(int direction READ direction)
+
+public:
+
+    /**
+     * Default constructor.
+     */
+    Gesture() {}
+
+    /**
+     * Copy constructor.
+     *
+     * @param data Source object.
+     */
+    Gesture(const GestureData& data);
+
+    /**
+     * Copy constructor.
+     *
+     * @param gesture Source object.
+     */
+    Gesture(const Gesture& gesture);
+
+    /**
+     * Returns the contained #GestureData
+     * @return Contained GestureData
+     */
+    const GestureData& gestureData() const { return data_; }
+
+    /**
+     * Returns the timestamp of the gesture.
+     * @return timestamp.
+     */
+    quint64 timestamp() const { return data_.timestamp_; }
+
+    /**
+     * Returns the type of the gesture.
+     * @return type.
+     */
+    GestureData::Type type() const { return data_.type_; }
+
+    /**
+     * Returns the axis of the gesture.
+     * @return axis.
+     */
+    TapData::Direction direction() const { return data_.direction_; }
+
+    /**
+     * Assignment operator.
+     *
+     * @param origin Source object for assigment.
+     */
+    Gesture& operator=(const Gesture& origin)
+    {
+        data_ = origin.gestureData();
+        return *this;
+    }
+
+    /**
+     * Comparison operator.
+     *
+     * @param right Object to compare to.
+     * @return comparison result.
+     */
+    bool operator==(const Gesture& right) const
+    {
+        return (data_.timestamp_ == right.data_.timestamp_ &&
+                data_.type_ == right.data_.type_ &&
+                data_.direction_ == right.data_.direction_);
+    }
+
+private:
+    GestureData data_; /**< Contained data. */
+
+    friend const QDBusArgument &operator>>(const QDBusArgument &argument, Gesture& gesture);
+};
+
+Q_DECLARE_METATYPE( Gesture )
+
+/**
+ * Marshall the Gesture data into a D-Bus argument.
+ *
+ * @param argument dbus argument.
+ * @param gesture data to marshall.
+ * @return dbus argument.
+ */
+inline QDBusArgument &operator<<(QDBusArgument &argument, const Gesture &gesture)
+{
+    argument.beginStructure();
+    argument << gesture.gestureData().timestamp_ << (int)(gesture.gestureData().type_) << (int)(gesture.gestureData().direction_);
+    argument.endStructure();
+    return argument;
+}
+
+/**
+ * Unmarshall Gesture data from the D-Bus argument
+ *
+ * @param argument dbus argument.
+ * @param gesture unmarshalled data.
+ * @return dbus argument.
+ */
+inline const QDBusArgument &operator>>(const QDBusArgument &argument, Gesture &gesture)
+{
+    int tmp;
+    argument.beginStructure();
+    argument >> gesture.data_.timestamp_;
+    argument >> tmp;
+    gesture.data_.type_ = (GestureData::Type)tmp;
+    argument >> tmp;
+    gesture.data_.direction_ = (TapData::Direction)tmp;
+    argument.endStructure();
+    return argument;
+}
+
+#endif // GESTURE_H
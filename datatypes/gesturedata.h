@@ -0,0 +1,71 @@
+/**
+   @file gesturedata.h
+   @brief Datatype for gesture events
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef GESTUREDATA_H
+#define GESTUREDATA_H
+
+#include <datatypes/genericdata.h>
+#include <datatypes/tapdata.h>
+
+/**
+ * @brief Datatype for gesture events.
+ *
+ * Gestures are detected inside sensord from the accelerometer, see
+ * GestureFilter, and only delivered when they happen.
+ */
+class GestureData : public TimedData {
+public:
+    /**
+     * Type of gesture.
+     */
+    enum Type
+    {
+        Shake = 0, /**< Device was shaken back and forth. */
+        DoubleTap, /**< Device was tapped twice. */
+        FlipDown,  /**< Device was put face down. */
+        FlipUp     /**< Device was taken out of face down. */
+    };
+
+    GestureData::Type type_;           /**< Type of gesture */
+    TapData::Direction direction_;     /**< Axis of shake or tap, Z for flips */
+
+    /**
+     * Constructor.
+     */
+    GestureData() : TimedData(0), type_(Shake), direction_(TapData::X) {}
+
+    /**
+     * Constructor.
+     * @param timestamp Timestamp of gesture.
+     * @param type Type of gesture.
+     * @param direction Axis of gesture.
+     */
+    GestureData(const quint64& timestamp, Type type, TapData::Direction direction) :
+        TimedData(timestamp), type_(type), direction_(direction) {}
+};
+SENSORFW_STATIC_ASSERT(sizeof(GestureData::Type) == sizeof(int), GestureData_enum_size);
+SENSORFW_WIRE_LAYOUT(GestureData, 2 * sizeof(int))
+
+Q_DECLARE_METATYPE ( GestureData )
+
+#endif // GESTUREDATA_H
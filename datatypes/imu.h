@@ -0,0 +1,177 @@
+/**
+   @file imu.h
+   @brief Imu
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef IMU_H
+#define IMU_H
+
+#include <QDBusArgument>
+#include <string.h>
+#include <datatypes/imudata.h>
+
+/**
+ * QObject facade for #TimedImuData.
+ */
+class Imu : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(int ax READ ax)
+    Q_PROPERTY(int ay READ ay)
+    Q_PROPERTY(int az READ az)
+    Q_PROPERTY(int gx READ gx)
+    Q_PROPERTY(int gy READ gy)
+    Q_PROPERTY(int gz READ gz)
+    Q_PROPERTY(int mx READ mx)
+    Q_PROPERTY(int my READ my)
+    Q_PROPERTY(int mz READ mz)
+    Q_PROPERTY(bool hasMagnetometer READ hasMagnetometer)
+
+public:
+
+    /**
+     * Default constructor.
+     */
+    Imu() {}
+
+    /**
+     * Copy constructor.
+     *
+     * @param data Source object.
+     */
+    Imu(const TimedImuData& data);
+
+    /**
+     * Copy constructor.
+     *
+     * @param imu Source object.
+     */
+    Imu(const Imu& imu);
+
+    /**
+     * Returns the contained #TimedImuData
+     * @return Contained TimedImuData
+     */
+    const TimedImuData& imuData() const { return data_; }
+
+    /**
+     * Returns the timestamp of the frame.
+     * @return timestamp.
+     */
+    quint64 timestamp() const { return data_.timestamp_; }
+
+    /** @return acceleration X, mG. */
+    int ax() const { return data_.ax_; }
+    /** @return acceleration Y, mG. */
+    int ay() const { return data_.ay_; }
+    /** @return acceleration Z, mG. */
+    int az() const { return data_.az_; }
+    /** @return angular rate X, mdps. */
+    int gx() const { return data_.gx_; }
+    /** @return angular rate Y, mdps. */
+    int gy() const { return data_.gy_; }
+    /** @return angular rate Z, mdps. */
+    int gz() const { return data_.gz_; }
+    /** @return magnetic field X, nT. */
+    int mx() const { return data_.mx_; }
+    /** @return magnetic field Y, nT. */
+    int my() const { return data_.my_; }
+    /** @return magnetic field Z, nT. */
+    int mz() const { return data_.mz_; }
+
+    /**
+     * Are the magnetometer fields valid.
+     * @return has magnetometer data.
+     */
+    bool hasMagnetometer() const { return data_.flags_ & TimedImuData::HasMagnetometer; }
+
+    /**
+     * Assignment operator.
+     *
+     * @param origin Source object for assigment.
+     */
+    Imu& operator=(const Imu& origin)
+    {
+        data_ = origin.imuData();
+        return *this;
+    }
+
+    /**
+     * Comparison operator.
+     *
+     * @param right Object to compare to.
+     * @return comparison result.
+     */
+    bool operator==(const Imu& right) const
+    {
+        return memcmp(&data_, &right.data_, sizeof(data_)) == 0;
+    }
+
+private:
+    TimedImuData data_; /**< Contained data. */
+
+    friend const QDBusArgument &operator>>(const QDBusArgument &argument, Imu& imu);
+};
+
+Q_DECLARE_METATYPE( Imu )
+
+/**
+ * Marshall the Imu data into a D-Bus argument.
+ *
+ * @param argument dbus argument.
+ * @param imu data to marshall.
+ * @return dbus argument.
+ */
+inline QDBusArgument &operator<<(QDBusArgument &argument, const Imu &imu)
+{
+    const TimedImuData& data = imu.imuData();
+    argument.beginStructure();
+    argument << data.timestamp_
+             << data.ax_ << data.ay_ << data.az_
+             << data.gx_ << data.gy_ << data.gz_
+             << data.mx_ << data.my_ << data.mz_
+             << data.flags_;
+    argument.endStructure();
+    return argument;
+}
+
+/**
+ * Unmarshall Imu data from the D-Bus argument
+ *
+ * @param argument dbus argument.
+ * @param imu unmarshalled data.
+ * @return dbus argument.
+ */
+inline const QDBusArgument &operator>>(const QDBusArgument &argument, Imu &imu)
+{
+    TimedImuData& data = imu.data_;
+    argument.beginStructure();
+    argument >> data.timestamp_
+             >> data.ax_ >> data.ay_ >> data.az_
+             >> data.gx_ >> data.gy_ >> data.gz_
+             >> data.mx_ >> data.my_ >> data.mz_
+             >> data.flags_;
+    argument.endStructure();
+    return argument;
+}
+
+#endif // IMU_H
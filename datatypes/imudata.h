@@ -0,0 +1,69 @@
+/**
+   @file imudata.h
+   @brief TimedImuData
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef IMUDATA_H
+#define IMUDATA_H
+
+#include <datatypes/genericdata.h>
+
+/**
+ * Datatype for one time-aligned inertial frame: accelerometer,
+ * gyroscope and optionally magnetometer samples for the same instant.
+ * The layout has no padding and is written to the socket as is, so a
+ * client gets all three sensors with a single read per frame.
+ */
+class TimedImuData : public TimedData
+{
+public:
+    /**
+     * Validity flags of a frame.
+     */
+    enum Flags
+    {
+        HasMagnetometer = 1 /**< magnetometer fields are valid */
+    };
+
+    /**
+     * Constructor.
+     */
+    TimedImuData() : TimedData(0),
+        ax_(0), ay_(0), az_(0),
+        gx_(0), gy_(0), gz_(0),
+        mx_(0), my_(0), mz_(0),
+        flags_(0) {}
+
+    int ax_;    /**< acceleration X, mG */
+    int ay_;    /**< acceleration Y, mG */
+    int az_;    /**< acceleration Z, mG */
+    int gx_;    /**< angular rate X, mdps */
+    int gy_;    /**< angular rate Y, mdps */
+    int gz_;    /**< angular rate Z, mdps */
+    int mx_;    /**< hard iron corrected magnetic field X, nT */
+    int my_;    /**< hard iron corrected magnetic field Y, nT */
+    int mz_;    /**< hard iron corrected magnetic field Z, nT */
+    int flags_; /**< #Flags */
+};
+Q_DECLARE_METATYPE ( TimedImuData )
+SENSORFW_WIRE_LAYOUT(TimedImuData, 10 * sizeof(int))
+
+#endif // IMUDATA_H
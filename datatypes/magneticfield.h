@@ -52,14 +52,7 @@ public:
      * @param calibratedData Source object.
      */
     MagneticField(const CalibratedMagneticFieldData& calibratedData) : QObject() {
-        data_.timestamp_ = calibratedData.timestamp_;
-        data_.level_ = calibratedData.level_;
-        data_.x_ = calibratedData.x_;
-        data_.y_ = calibratedData.y_;
-        data_.z_ = calibratedData.z_;
-        data_.rx_ = calibratedData.rx_;
-        data_.ry_ = calibratedData.ry_;
-        data_.rz_ = calibratedData.rz_;
+        data_ = calibratedData;
     }
 
     /**
@@ -68,14 +61,7 @@ public:
      * @param data Source object.
      */
     MagneticField(const MagneticField& data) : QObject() {
-        data_.timestamp_ = data.data_.timestamp_;
-        data_.level_ = data.data_.level_;
-        data_.x_ = data.data_.x_;
-        data_.y_ = data.data_.y_;
-        data_.z_ = data.data_.z_;
-        data_.rx_ = data.data_.rx_;
-        data_.ry_ = data.data_.ry_;
-        data_.rz_ = data.data_.rz_;
+        data_ = data.data_;
     }
 
     /**
@@ -92,14 +78,7 @@ public:
      */
     MagneticField& operator=(const MagneticField& origin)
     {
-        data_.timestamp_ = origin.data_.timestamp_;
-        data_.level_ = origin.data_.level_;
-        data_.x_ = origin.data_.x_;
-        data_.y_ = origin.data_.y_;
-        data_.z_ = origin.data_.z_;
-        data_.rx_ = origin.data_.rx_;
-        data_.ry_ = origin.data_.ry_;
-        data_.rz_ = origin.data_.rz_;
+        data_ = origin.data_;
 
         return *this;
     }
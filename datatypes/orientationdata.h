@@ -37,6 +37,11 @@
  */
 typedef TimedXyzData AccelerationData;
 
+/**
+ * Accelerometer measurement data in m/s^2, as reported by the hardware.
+ */
+typedef TimedXyzFloatData AccelerationFloatData;
+
 /**
  * Magnetometer measurement data.
  */
@@ -104,6 +109,7 @@ public:
     int rz_;    /**< raw Z coordinate value */
     int level_; /**< Magnetometer calibration level. Higher value means better calibration. */
 };
+SENSORFW_WIRE_LAYOUT(CalibratedMagneticFieldData, 7 * sizeof(int))
 
 /**
  * Datatype for compass measurements.
@@ -143,6 +149,7 @@ public:
     int correctedDegrees_; /**< Declination corrected angle to north */
     int level_;   /**< Magnetometer calibration level. Higher value means better calibration. */
 };
+SENSORFW_WIRE_LAYOUT(CompassData, 4 * sizeof(int))
 
 /**
  * Datatype for proximity measurements
@@ -167,5 +174,6 @@ public:
 
     bool withinProximity_; /**< is an object within proximity or not */
 };
+SENSORFW_WIRE_LAYOUT(ProximityData, sizeof(unsigned) + sizeof(bool))
 
 #endif // ORIENTATIONDATA_H
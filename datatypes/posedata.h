@@ -103,5 +103,7 @@ public:
 };
 
 Q_DECLARE_METATYPE(PoseData)
+SENSORFW_STATIC_ASSERT(sizeof(PoseData::Orientation) == sizeof(int), PoseData_orientation_size);
+SENSORFW_WIRE_LAYOUT(PoseData, sizeof(int))
 
 #endif // POSEDATA_H
@@ -0,0 +1,171 @@
+/**
+   @file quaternion.h
+   @brief Quaternion
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef QUATERNION_H
+#define QUATERNION_H
+
+#include <QDBusArgument>
+#include <datatypes/quaterniondata.h>
+
+/**
+ * QObject facade for #TimedQuaternionData.
+ */
+class Quaternion : public QObject
+{
+    Q_OBJECT
+
+    Q_PROPERTY(float w READ w)
+    Q_PROPERTY(float x READ x)
+    Q_PROPERTY(float y READ y)
+    Q_PROPERTY(float z READ z)
+
+public:
+
+    /**
+     * Default constructor. Identity rotation.
+     */
+    Quaternion() {}
+
+    /**
+     * Copy constructor.
+     *
+     * @param data Source object.
+     */
+    Quaternion(const TimedQuaternionData& data);
+
+    /**
+     * Copy constructor.
+     *
+     * @param quaternion Source object.
+     */
+    Quaternion(const Quaternion& quaternion);
+
+    /**
+     * Returns the contained #TimedQuaternionData
+     * @return Contained TimedQuaternionData
+     */
+    const TimedQuaternionData& quaternionData() const { return data_; }
+
+    /**
+     * Returns the timestamp of the sample.
+     * @return timestamp.
+     */
+    quint64 timestamp() const { return data_.timestamp_; }
+
+    /**
+     * Returns the scalar part.
+     * @return w value.
+     */
+    float w() const { return data_.w_; }
+
+    /**
+     * Returns the X component.
+     * @return x value.
+     */
+    float x() const { return data_.x_; }
+
+    /**
+     * Returns the Y component.
+     * @return y value.
+     */
+    float y() const { return data_.y_; }
+
+    /**
+     * Returns the Z component.
+     * @return z value.
+     */
+    float z() const { return data_.z_; }
+
+    /**
+     * Assignment operator.
+     *
+     * @param origin Source object for assigment.
+     */
+    Quaternion& operator=(const Quaternion& origin)
+    {
+        data_ = origin.quaternionData();
+        return *this;
+    }
+
+    /**
+     * Comparison operator.
+     *
+     * @param right Object to compare to.
+     * @return comparison result.
+     */
+    bool operator==(const Quaternion& right) const
+    {
+        const TimedQuaternionData& rdata = right.quaternionData();
+        return (data_.w_ == rdata.w_ &&
+                data_.x_ == rdata.x_ &&
+                data_.y_ == rdata.y_ &&
+                data_.z_ == rdata.z_ &&
+                data_.timestamp_ == rdata.timestamp_);
+    }
+
+private:
+    TimedQuaternionData data_; /**< Contained data. */
+
+    friend const QDBusArgument &operator>>(const QDBusArgument &argument, Quaternion& quaternion);
+};
+
+Q_DECLARE_METATYPE( Quaternion )
+
+/**
+ * Marshall the Quaternion data into a D-Bus argument. D-Bus has no
+ * single precision type, so components travel as doubles.
+ *
+ * @param argument dbus argument.
+ * @param quaternion data to marshall.
+ * @return dbus argument.
+ */
+inline QDBusArgument &operator<<(QDBusArgument &argument, const Quaternion &quaternion)
+{
+    const TimedQuaternionData& data = quaternion.quaternionData();
+    argument.beginStructure();
+    argument << data.timestamp_ << (double)data.w_ << (double)data.x_ << (double)data.y_ << (double)data.z_;
+    argument.endStructure();
+    return argument;
+}
+
+/**
+ * Unmarshall Quaternion data from the D-Bus argument
+ *
+ * @param argument dbus argument.
+ * @param quaternion unmarshalled data.
+ * @return dbus argument.
+ */
+inline const QDBusArgument &operator>>(const QDBusArgument &argument, Quaternion &quaternion)
+{
+    double w, x, y, z;
+    argument.beginStructure();
+    argument >> quaternion.data_.timestamp_ >> w >> x >> y >> z;
+    argument.endStructure();
+    quaternion.data_.w_ = w;
+    quaternion.data_.x_ = x;
+    quaternion.data_.y_ = y;
+    quaternion.data_.z_ = z;
+    return argument;
+}
+
+#endif // QUATERNION_H
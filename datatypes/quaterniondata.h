@@ -0,0 +1,136 @@
+/**
+   @file quaterniondata.h
+   @brief TimedQuaternionData and PackedQuaternionData
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef QUATERNIONDATA_H
+#define QUATERNIONDATA_H
+
+#include <datatypes/genericdata.h>
+
+/**
+ * Datatype for device attitude as a unit quaternion. The quaternion
+ * rotates vectors from the device frame to the earth frame, where z
+ * points up and x towards magnetic north.
+ */
+class TimedQuaternionData : public TimedData
+{
+public:
+    /**
+     * Constructor. Identity rotation.
+     */
+    TimedQuaternionData() : TimedData(0), w_(1), x_(0), y_(0), z_(0) {}
+
+    /**
+     * Constructor.
+     *
+     * @param timestamp monotonic time (microsec)
+     * @param w scalar part.
+     * @param x X component of the vector part.
+     * @param y Y component of the vector part.
+     * @param z Z component of the vector part.
+     */
+    TimedQuaternionData(const quint64& timestamp, float w, float x, float y, float z) :
+        TimedData(timestamp), w_(w), x_(x), y_(y), z_(z) {}
+
+    float w_; /**< scalar part */
+    float x_; /**< X component */
+    float y_; /**< Y component */
+    float z_; /**< Z component */
+};
+Q_DECLARE_METATYPE ( TimedQuaternionData )
+SENSORFW_WIRE_LAYOUT(TimedQuaternionData, 4 * sizeof(float))
+
+/**
+ * Compact wire format of #TimedQuaternionData. Components are stored as
+ * signed Q1.14 fixed point, which keeps the resolution of a unit
+ * quaternion well below 0.01 degrees while halving the component
+ * payload. The timestamp is kept first and at full width, like in every
+ * other sample type.
+ */
+class PackedQuaternionData : public TimedData
+{
+public:
+    /**
+     * Fractional bits of the fixed point components.
+     */
+    static const int FRACTION_BITS = 14;
+
+    /**
+     * Constructor. Identity rotation.
+     */
+    PackedQuaternionData() : TimedData(0), w_(1 << FRACTION_BITS), x_(0), y_(0), z_(0) {}
+
+    /**
+     * Constructor.
+     *
+     * @param data quaternion to pack.
+     */
+    PackedQuaternionData(const TimedQuaternionData& data) :
+        TimedData(data.timestamp_),
+        w_(pack(data.w_)), x_(pack(data.x_)), y_(pack(data.y_)), z_(pack(data.z_)) {}
+
+    /**
+     * Unpack to full precision.
+     *
+     * @return unpacked quaternion.
+     */
+    TimedQuaternionData unpack() const
+    {
+        return TimedQuaternionData(timestamp_, unpack(w_), unpack(x_), unpack(y_), unpack(z_));
+    }
+
+    /**
+     * Convert a component to fixed point, saturating at the range.
+     *
+     * @param value component.
+     * @return fixed point component.
+     */
+    static qint16 pack(float value)
+    {
+        float scaled = value * (1 << FRACTION_BITS);
+        if (scaled >= 32767.0f)
+            return 32767;
+        if (scaled <= -32768.0f)
+            return -32768;
+        return (qint16)(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+    }
+
+    /**
+     * Convert a fixed point component back to float.
+     *
+     * @param value fixed point component.
+     * @return component.
+     */
+    static float unpack(qint16 value)
+    {
+        return value / (float)(1 << FRACTION_BITS);
+    }
+
+    qint16 w_; /**< scalar part */
+    qint16 x_; /**< X component */
+    qint16 y_; /**< Y component */
+    qint16 z_; /**< Z component */
+};
+Q_DECLARE_METATYPE ( PackedQuaternionData )
+SENSORFW_WIRE_LAYOUT(PackedQuaternionData, 4 * sizeof(qint16))
+
+#endif // QUATERNIONDATA_H
@@ -78,5 +78,7 @@ public:
     TapData(const quint64& timestamp, Direction direction, Type type) :
         TimedData(timestamp), direction_(direction), type_(type) {}
 };
+SENSORFW_STATIC_ASSERT(sizeof(TapData::Direction) == sizeof(int) && sizeof(TapData::Type) == sizeof(int), TapData_enum_size);
+SENSORFW_WIRE_LAYOUT(TapData, 2 * sizeof(int))
 
 #endif // TAPDATA_H
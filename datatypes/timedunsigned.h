@@ -50,5 +50,6 @@ public:
 };
 
 Q_DECLARE_METATYPE ( TimedUnsigned )
+SENSORFW_WIRE_LAYOUT(TimedUnsigned, sizeof(unsigned))
 
 #endif // TIMED_UNSIGNED_H
@@ -62,5 +62,7 @@ public:
     TouchData(TimedXyzData timedXyzData, int object, FingerState state) :
         TimedXyzData(timedXyzData), object_(object), state_(state) {}
 };
+SENSORFW_STATIC_ASSERT(sizeof(TouchData::FingerState) == sizeof(int), TouchData_state_size);
+SENSORFW_WIRE_LAYOUT(TouchData, 5 * sizeof(int))
 
 #endif // TOUCHDATA_H
@@ -39,6 +39,9 @@
 #include "tap.h"
 #include "posedata.h"
 #include "proximity.h"
+#include "quaternion.h"
+#include "imu.h"
+#include "gesture.h"
 
 void __attribute__ ((constructor)) datatypes_init(void)
 {
@@ -48,6 +51,9 @@ void __attribute__ ((constructor)) datatypes_init(void)
     qDBusRegisterMetaType<Orientation>();
     qDBusRegisterMetaType<MagneticField>();
     qDBusRegisterMetaType<Tap>();
+    qDBusRegisterMetaType<Quaternion>();
+    qDBusRegisterMetaType<Imu>();
+    qDBusRegisterMetaType<Gesture>();
     qDBusRegisterMetaType<DataRange>();
     qDBusRegisterMetaType<DataRangeList>();
     qDBusRegisterMetaType<IntegerRange>();
@@ -55,6 +61,9 @@ void __attribute__ ((constructor)) datatypes_init(void)
     qRegisterMetaType<TimedUnsigned>();
     qRegisterMetaType<PoseData>();
     qRegisterMetaType<Proximity>();
+    qRegisterMetaType<TimedQuaternionData>();
+    qRegisterMetaType<TimedImuData>();
+    qRegisterMetaType<GestureData>();
 }
 
 void __attribute__ ((destructor)) datatypes_fini(void)
@@ -71,6 +80,25 @@ quint64 Utils::getTimeStamp()
     return data;
 }
 
+quint64 Utils::getCoarseTimeStamp()
+{
+#ifdef CLOCK_MONOTONIC_COARSE
+    timespec stamp;
+    if (clock_gettime(CLOCK_MONOTONIC_COARSE, &stamp) == 0) {
+        quint64 data = stamp.tv_sec;
+        data = data * 1000000;
+        data = stamp.tv_nsec / 1000 + data;
+        return data;
+    }
+#endif
+    return getTimeStamp();
+}
+
+quint64 Utils::getTimeStamp(qint64 nanoseconds)
+{
+    return nanoseconds > 0 ? (quint64)nanoseconds / 1000 : 0;
+}
+
 quint64 Utils::getTimeStamp(const struct timeval *tp)
 {
     quint64 data = tp->tv_sec;
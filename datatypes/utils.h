@@ -48,6 +48,25 @@ public:
      * @return timestamp.
      */
     static quint64 getTimeStamp(const struct timeval*);
+
+    /**
+     * Get timestamp of monotonic clock in microsecs, at the resolution of
+     * the kernel tick. Cheaper than #getTimeStamp(), for slow sensors and
+     * bookkeeping where a few milliseconds do not matter. Same clock
+     * domain as #getTimeStamp().
+     *
+     * @return timestamp.
+     */
+    static quint64 getCoarseTimeStamp();
+
+    /**
+     * Convert a monotonic clock time in nanosecs, as given by sensor HALs
+     * and IIO timestamp channels, into a timestamp in microsecs.
+     *
+     * @param nanoseconds monotonic clock time in nanosecs.
+     * @return timestamp.
+     */
+    static quint64 getTimeStamp(qint64 nanoseconds);
 };
 
 #endif // UTILS_H
@@ -0,0 +1,48 @@
+QT += network
+
+TEMPLATE = lib
+TARGET = sensorfw-embedded
+
+include( ../common-config.pri )
+
+# Sensord running inside the application, see LocalSensorManager.
+SOURCES += localsensormanager.cpp \
+    localsensorchannel.cpp
+
+HEADERS += localsensormanager.h \
+    localsensorchannel.h
+
+SENSORFW_INCLUDEPATHS = .. \
+    ../include \
+    ../filters \
+    ../datatypes \
+    ../core
+
+DEPENDPATH += $$SENSORFW_INCLUDEPATHS
+INCLUDEPATH += $$SENSORFW_INCLUDEPATHS
+
+QMAKE_LIBDIR_FLAGS += -L../datatypes \
+                      -L../core
+
+static_plugins:equals(QT_MAJOR_VERSION, 5) {
+    # Same plugins as linked into sensord
+    STATIC_PLUGIN_LIST =
+    for(entry, SENSORFW_STATIC_PLUGINS) {
+        LIBS += -L../$$section(entry, :, 1, 1) -l$$section(entry, :, 0, 0)-qt5
+        STATIC_PLUGIN_LIST += "SENSORD_STATIC_PLUGIN($$section(entry, :, 0, 0), $$section(entry, :, 2, 2))"
+    }
+    write_file($$OUT_PWD/staticpluginlist.h, STATIC_PLUGIN_LIST)
+
+    INCLUDEPATH += $$OUT_PWD ../sensord
+    DEFINES += SENSORD_STATIC_PLUGINS
+    CONFIG += ltcg
+    SOURCES += ../sensord/staticplugins.cpp
+    HEADERS += ../sensord/staticplugins.h
+}
+
+include(../common-install.pri)
+publicheaders.files = $$HEADERS
+target.path = $$SHAREDLIBPATH
+INSTALLS += target
+
+include(../common.pri)
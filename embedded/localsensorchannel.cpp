@@ -0,0 +1,161 @@
+/**
+   @file localsensorchannel.cpp
+   @brief LocalSensorChannelInterface
+
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "localsensorchannel.h"
+#include "sensormanager.h"
+#include "abstractsensor.h"
+#include "localsensormanager.h"
+#include "idutils.h"
+
+LocalSensorChannelInterface::LocalSensorChannelInterface(const QString& id, QObject* parent) :
+    QObject(parent),
+    channel_(NULL),
+    id_(getCleanId(id)),
+    sessionId_(-1),
+    running_(false),
+    sampleSize_(0),
+    notified_(false)
+{
+    if (!LocalSensorManager::initialized()) {
+        sensordLogW() << "Sensor " << id << " requested before LocalSensorManager::init()";
+        return;
+    }
+
+    SensorManager& sm = SensorManager::instance();
+    int sessionId = sm.requestSensor(id);
+    if (sessionId < 0) {
+        sensordLogW() << "Failed to open sensor " << id << ": " << sm.errorString();
+        return;
+    }
+    const SensorInstanceEntry* entry = sm.getSensorInstance(id_);
+    if (!entry || !entry->sensor_) {
+        sm.releaseSensor(id_, sessionId);
+        return;
+    }
+    channel_ = entry->sensor_;
+    sessionId_ = sessionId;
+    sm.setLocalSession(sessionId_, this);
+}
+
+LocalSensorChannelInterface::~LocalSensorChannelInterface()
+{
+    if (sessionId_ < 0)
+        return;
+
+    SensorManager& sm = SensorManager::instance();
+    // Waits for a delivery in progress, nothing is written after this.
+    sm.setLocalSession(sessionId_, NULL);
+    stop();
+    sm.releaseSensor(id_, sessionId_);
+}
+
+bool LocalSensorChannelInterface::isValid() const
+{
+    return channel_ && channel_->isValid();
+}
+
+bool LocalSensorChannelInterface::start()
+{
+    if (!channel_)
+        return false;
+    if (!running_) {
+        channel_->start(sessionId_);
+        running_ = true;
+    }
+    return true;
+}
+
+bool LocalSensorChannelInterface::stop()
+{
+    if (!channel_)
+        return false;
+    if (running_) {
+        channel_->stop(sessionId_);
+        running_ = false;
+    }
+    return true;
+}
+
+void LocalSensorChannelInterface::setInterval(unsigned int value)
+{
+    if (channel_)
+        channel_->setIntervalRequest(sessionId_, value);
+}
+
+unsigned int LocalSensorChannelInterface::interval() const
+{
+    return channel_ ? channel_->getInterval() : 0;
+}
+
+void LocalSensorChannelInterface::setDownsampling(bool value)
+{
+    if (channel_)
+        channel_->setDownsamplingEnabled(sessionId_, value);
+}
+
+bool LocalSensorChannelInterface::setStandbyOverride(bool value)
+{
+    return channel_ && channel_->setStandbyOverrideRequest(sessionId_, value);
+}
+
+void LocalSensorChannelInterface::setChangeOnly(bool value, unsigned int deadband)
+{
+    if (channel_)
+        channel_->setChangeOnly(sessionId_, value, deadband);
+}
+
+bool LocalSensorChannelInterface::write(const void* source, int size)
+{
+    QMutexLocker locker(&mutex_);
+    if (sampleSize_ != size) {
+        // Channels deliver one data type, keep the latest one if it changes.
+        if (sampleSize_)
+            sensordLogW() << id_ << " sample size changed from " << sampleSize_ << " to " << size;
+        pending_.clear();
+        sampleSize_ = size;
+    }
+    // An application not reading loses the oldest samples.
+    if (pending_.size() >= MAX_PENDING_SAMPLES * size)
+        pending_.remove(0, size);
+    pending_.append((const char*)source, size);
+    return true;
+}
+
+void LocalSensorChannelInterface::flush()
+{
+    QMutexLocker locker(&mutex_);
+    if (notified_ || pending_.isEmpty())
+        return;
+    notified_ = true;
+    QMetaObject::invokeMethod(this, "notifySamples", Qt::QueuedConnection);
+}
+
+void LocalSensorChannelInterface::notifySamples()
+{
+    {
+        QMutexLocker locker(&mutex_);
+        notified_ = false;
+    }
+    emit samplesAvailable();
+}
@@ -0,0 +1,192 @@
+/**
+   @file localsensorchannel.h
+   @brief LocalSensorChannelInterface
+
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef LOCALSENSORCHANNEL_H
+#define LOCALSENSORCHANNEL_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QVector>
+#include <QMutex>
+#include <string.h>
+
+#include "localsession.h"
+#include "logging.h"
+
+class AbstractSensorChannel;
+
+/**
+ * Session of a sensor channel in the same process, see
+ * LocalSensorManager. Offers the session controls of
+ * AbstractSensorChannelInterface, but samples are handed over by the
+ * delivery thread directly instead of through a socket. They are
+ * collected until the application reads them with #read(), and
+ * #samplesAvailable() is emitted in the thread of the object once per
+ * delivery round.
+ *
+ * Samples have the data type of the channel, for example
+ * AccelerationData for "accelerometersensor".
+ */
+class LocalSensorChannelInterface : public QObject, public LocalSession
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(LocalSensorChannelInterface)
+
+public:
+    /**
+     * Constructor. Opens a session of the channel, check #isValid().
+     *
+     * @param id sensor channel ID.
+     * @param parent parent object.
+     */
+    LocalSensorChannelInterface(const QString& id, QObject* parent = 0);
+
+    /**
+     * Destructor. Stops and releases the session.
+     */
+    virtual ~LocalSensorChannelInterface();
+
+    /**
+     * Is the session open and the channel valid.
+     *
+     * @return is session valid.
+     */
+    bool isValid() const;
+
+    /**
+     * Session ID.
+     *
+     * @return session ID, or -1 if not valid.
+     */
+    int sessionId() const { return sessionId_; }
+
+    /**
+     * Start the session.
+     *
+     * @return was session started.
+     */
+    bool start();
+
+    /**
+     * Stop the session. Samples not read yet are kept.
+     *
+     * @return was session stopped.
+     */
+    bool stop();
+
+    /**
+     * Request interval for the session.
+     *
+     * @param value interval in milliseconds, 0 for default.
+     */
+    void setInterval(unsigned int value);
+
+    /**
+     * Current interval of the channel.
+     *
+     * @return interval in milliseconds.
+     */
+    unsigned int interval() const;
+
+    /**
+     * Enable or disable downsampling to the session interval.
+     *
+     * @param value downsampling state.
+     */
+    void setDownsampling(bool value);
+
+    /**
+     * Keep the sensor running when the display is off.
+     *
+     * @param value standby override state.
+     * @return was request accepted.
+     */
+    bool setStandbyOverride(bool value);
+
+    /**
+     * Deliver only changed samples, see
+     * AbstractSensorChannel::setChangeOnly().
+     *
+     * @param value enable change only delivery.
+     * @param deadband largest change which is not delivered.
+     */
+    void setChangeOnly(bool value, unsigned int deadband = 0);
+
+    /**
+     * Take the samples delivered since the previous call.
+     *
+     * @tparam T data type of the channel.
+     * @param samples location for the samples, oldest first.
+     * @return number of samples, 0 also if T does not match the channel.
+     */
+    template <class T>
+    int read(QVector<T>& samples);
+
+    virtual bool write(const void* source, int size);
+    virtual void flush();
+
+Q_SIGNALS:
+    /**
+     * New samples can be read with #read().
+     */
+    void samplesAvailable();
+
+private Q_SLOTS:
+    /**
+     * Emit #samplesAvailable() in the thread of the object.
+     */
+    void notifySamples();
+
+private:
+    static const int MAX_PENDING_SAMPLES = 1024; /**< samples kept until read */
+
+    AbstractSensorChannel* channel_;   /**< sensor channel */
+    QString                id_;        /**< sensor channel ID */
+    int                    sessionId_; /**< session ID */
+    bool                   running_;   /**< is session started */
+    QMutex                 mutex_;     /**< protects pending_, sampleSize_ and notified_ */
+    QByteArray             pending_;   /**< samples not read yet */
+    int                    sampleSize_; /**< size of the samples, 0 until known */
+    bool                   notified_;  /**< is notifySamples() queued */
+};
+
+template <class T>
+int LocalSensorChannelInterface::read(QVector<T>& samples)
+{
+    QMutexLocker locker(&mutex_);
+    samples.clear();
+    if (pending_.isEmpty())
+        return 0;
+    if (sampleSize_ != (int)sizeof(T)) {
+        sensordLogW() << id_ << " samples are " << sampleSize_ << " bytes, read as " << sizeof(T);
+        return 0;
+    }
+    int n = pending_.size() / sizeof(T);
+    samples.resize(n);
+    memcpy(samples.data(), pending_.constData(), n * sizeof(T));
+    pending_.clear();
+    return n;
+}
+
+#endif // LOCALSENSORCHANNEL_H
@@ -0,0 +1,76 @@
+/**
+   @file localsensormanager.cpp
+   @brief LocalSensorManager
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "localsensormanager.h"
+#include "sensormanager.h"
+#include "config.h"
+#include "logging.h"
+#ifdef SENSORD_STATIC_PLUGINS
+#include "staticplugins.h"
+#endif
+
+bool LocalSensorManager::initialized_ = false;
+
+bool LocalSensorManager::init(const QString& configFile, const QString& configDir)
+{
+    if (initialized_)
+        return true;
+
+    // Before the manager exists, so no session sockets are created.
+    SensorManager::setEmbedded(true);
+
+    if (!Config::loadConfig(configFile, configDir)) {
+        sensordLogC() << "Failed to load sensord configuration from " << configFile;
+        return false;
+    }
+
+#ifdef SENSORD_STATIC_PLUGINS
+    registerStaticPlugins();
+#endif
+
+    SensorManager& sm = SensorManager::instance();
+
+    QVariant preload = Config::configuration()->value("global/preload_plugins");
+    QStringList preloadPlugins = preload.type() == QVariant::StringList ?
+                                 preload.toStringList() :
+                                 preload.toString().split(',', QString::SkipEmptyParts);
+    if (!preloadPlugins.isEmpty())
+        sensordLogD() << "Preloading plugins " << sm.loadPlugins(preloadPlugins);
+
+    initialized_ = true;
+    return true;
+}
+
+bool LocalSensorManager::loadPlugin(const QString& name)
+{
+    if (!initialized_) {
+        sensordLogW() << "Loading plugin " << name << " before initialization";
+        return false;
+    }
+    return SensorManager::instance().loadPlugin(name);
+}
+
+bool LocalSensorManager::initialized()
+{
+    return initialized_;
+}
@@ -0,0 +1,72 @@
+/**
+   @file localsensormanager.h
+   @brief LocalSensorManager
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef LOCALSENSORMANAGER_H
+#define LOCALSENSORMANAGER_H
+
+#include <QString>
+#include <QStringList>
+
+/**
+ * Sets up sensord inside an application, for devices where it is the
+ * only user of the sensors. Adaptors, chains and channels run in the
+ * process of the application and LocalSensorChannelInterface reads
+ * the channels without DBus or sockets. Must be initialized after the
+ * QCoreApplication is created and before any other use.
+ */
+class LocalSensorManager
+{
+public:
+    /**
+     * Load configuration and register the plugins. Plugins linked into
+     * the library are registered first, the ones named in
+     * <tt>global/preload_plugins</tt> are loaded right away and the rest
+     * on demand, as in the daemon.
+     *
+     * @param configFile configuration file.
+     * @param configDir directory of configuration fragments.
+     * @return was configuration loaded.
+     */
+    static bool init(const QString& configFile = "/etc/sensorfw/sensord.conf",
+                     const QString& configDir = "/etc/sensorfw/sensord.conf.d/");
+
+    /**
+     * Load a plugin which is not loaded on demand.
+     *
+     * @param name plugin name.
+     * @return was plugin loaded.
+     */
+    static bool loadPlugin(const QString& name);
+
+    /**
+     * Has #init() succeeded.
+     *
+     * @return is sensord initialized.
+     */
+    static bool initialized();
+
+private:
+    static bool initialized_; /**< has init() succeeded */
+};
+
+#endif // LOCALSENSORMANAGER_H
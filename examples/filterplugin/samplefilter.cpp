@@ -30,18 +30,21 @@ SampleFilter::SampleFilter() :
 {
 }
 
-void SampleFilter::filter(unsigned, const TimedUnsigned* data)
+void SampleFilter::filter(unsigned n, const TimedUnsigned* data)
 {
-    TimedUnsigned transformed;
+    // Samples come in batches; process all of them into the output span.
+    TimedUnsigned* transformed = outputSpan(n);
 
-    // Usually you want to keep the timestamp of the original data, as
-    // one is likely to be interested in the time that the action
-    // happened. Apply common sense.
-    transformed.timestamp_ = data->timestamp_;
+    for (unsigned i = 0; i < n; ++i) {
+        // Usually you want to keep the timestamp of the original data, as
+        // one is likely to be interested in the time that the action
+        // happened. Apply common sense.
+        transformed[i].timestamp_ = data[i].timestamp_;
 
-    // Do something for the value.
-    transformed.value_ = data->value_ * data->value_;
+        // Do something for the value.
+        transformed[i].value_ = data[i].value_ * data[i].value_;
+    }
 
-    // Propagate the altered sample to outputs
-    source_.propagate(1, &transformed);
+    // Propagate the altered samples to outputs
+    source_.propagate(n, transformed);
 }
@@ -24,28 +24,45 @@
 AvgAccFilter::AvgAccFilter() :
     Filter<TimedXyzData, AvgAccFilter, TimedXyzData>(this, &AvgAccFilter::interpret),
     avgAccdata(0,0,0,0),
-    filterFactor(0.2)
+    weights(makeWeights(0.2))
 {
 }
 
-void AvgAccFilter::interpret(unsigned, const TimedXyzData *data)
+AvgAccFilter::Weights AvgAccFilter::makeWeights(qreal f)
 {
-    avgAccdata.x_ = data->x_ * filterFactor + avgAccdata.x_ * (1.0 - filterFactor);
-    avgAccdata.y_ = data->y_ * filterFactor + avgAccdata.y_ * (1.0 - filterFactor);
-    avgAccdata.z_ = data->z_ * filterFactor + avgAccdata.z_ * (1.0 - filterFactor);
-
-    TimedXyzData filteredData(data->timestamp_,
-                              avgAccdata.x_,
-                              avgAccdata.y_,
-                              avgAccdata.z_);
-
-    sensordLogT() << "averaged: "
-                  << filteredData.x_
-                  << ", "
-                  << filteredData.y_
-                  << ", " << filteredData.z_;
-
-    source_.propagate(1, &filteredData);
+    Weights w;
+    w.factor = f;
+    w.newWeight = FilterScalar((double)f);
+    w.oldWeight = FilterScalar(1.0 - f);
+    return w;
+}
+
+void AvgAccFilter::interpret(unsigned n, const TimedXyzData *data)
+{
+    TimedXyzData* filteredData = outputSpan(n);
+
+    weights.update();
+    const FilterScalar newWeight = weights.current().newWeight;
+    const FilterScalar oldWeight = weights.current().oldWeight;
+
+    for (unsigned i = 0; i < n; ++i) {
+        avgAccdata.x_ = scalarToInt(newWeight * data[i].x_ + oldWeight * avgAccdata.x_);
+        avgAccdata.y_ = scalarToInt(newWeight * data[i].y_ + oldWeight * avgAccdata.y_);
+        avgAccdata.z_ = scalarToInt(newWeight * data[i].z_ + oldWeight * avgAccdata.z_);
+
+        filteredData[i] = TimedXyzData(data[i].timestamp_,
+                                       avgAccdata.x_,
+                                       avgAccdata.y_,
+                                       avgAccdata.z_);
+
+        sensordLogT() << "averaged: "
+                      << filteredData[i].x_
+                      << ", "
+                      << filteredData[i].y_
+                      << ", " << filteredData[i].z_;
+    }
+
+    source_.propagate(n, filteredData);
 }
 
 void AvgAccFilter::reset()
@@ -57,12 +74,13 @@ void AvgAccFilter::reset()
 
 void AvgAccFilter::setFactor(qreal f)
 {
-    filterFactor = f;
+    // Picked up by the chain at its next batch.
+    weights.publish(makeWeights(f));
 }
 
 
 qreal AvgAccFilter::factor()
 {
-    return filterFactor;
+    return weights.value().factor;
 }
 
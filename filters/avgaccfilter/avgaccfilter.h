@@ -25,6 +25,8 @@
 
 #include "orientationdata.h"
 #include "filter.h"
+#include "fixedpoint.h"
+#include "liveparameter.h"
 
 class AvgAccFilter : public QObject, public Filter<TimedXyzData, AvgAccFilter, TimedXyzData>
 {
@@ -48,10 +50,28 @@ private:
 
     typedef QList<TimedXyzData> XyzAvgAccBuffer;
 
+    /**
+     * Smoothing weights, published by #setFactor().
+     */
+    struct Weights
+    {
+        qreal        factor;    /**< smoothing factor */
+        FilterScalar newWeight; /**< weight of the new sample */
+        FilterScalar oldWeight; /**< weight of the running average */
+    };
+
+    /**
+     * Weights for a factor.
+     *
+     * @param f smoothing factor.
+     * @return weights.
+     */
+    static Weights makeWeights(qreal f);
+
     TimedXyzData avgAccdata;
     XyzAvgAccBuffer avgBuffer;
     unsigned int avgBufferSize;
-    qreal filterFactor;
+    LiveParameter<Weights> weights; /**< weights read by interpret() */
 };
 
 #endif // ROTATIONFILTER_H
@@ -25,21 +25,93 @@
  */
 
 #include "coordinatealignfilter.h"
+#include <QStringList>
+#include "logging.h"
 
 CoordinateAlignFilter::CoordinateAlignFilter() :
         Filter<TimedXyzData, CoordinateAlignFilter, TimedXyzData>(this, &CoordinateAlignFilter::filter)
 {
+    classifyMatrix();
 }
 
-void CoordinateAlignFilter::filter(unsigned, const TimedXyzData* data)
+void CoordinateAlignFilter::setMatrix(const TMatrix& matrix)
 {
-    TimedXyzData transformed;
+    matrix_ = matrix;
+    classifyMatrix();
+}
+
+QString CoordinateAlignFilter::matrixString() const
+{
+    QStringList cells;
+    for (int i = 0; i < 9; ++i)
+        cells << QString::number(matrix_.data_[i / 3][i % 3]);
+    return cells.join(",");
+}
+
+void CoordinateAlignFilter::setMatrixString(const QString& str)
+{
+    QStringList cells = str.split(',');
+    if (cells.size() != 9) {
+        sensordLogW() << "Invalid cell count from matrix. Expected 9, got" << cells.size();
+        return;
+    }
+
+    TMatrix matrix;
+    for (int i = 0; i < 9; ++i)
+        matrix.data_[i / 3][i % 3] = cells.at(i).toDouble();
+    setMatrix(matrix);
+}
+
+void CoordinateAlignFilter::classifyMatrix()
+{
+    Transform transform;
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j)
+            transform.coeff[i][j] = FilterScalar(matrix_.data_[i][j]);
+
+    transform.axisSwap = true;
+    for (int i = 0; i < 3 && transform.axisSwap; ++i) {
+        int nonZero = 0;
+        for (int j = 0; j < 3; ++j) {
+            double value = matrix_.data_[i][j];
+            if (value == 0)
+                continue;
+            if ((value != 1 && value != -1) || ++nonZero > 1) {
+                transform.axisSwap = false;
+                break;
+            }
+            transform.axis[i] = j;
+            transform.sign[i] = (int)value;
+        }
+        if (nonZero == 0) {
+            transform.axisSwap = false;
+        }
+    }
+
+    // Picked up by the chain at its next batch.
+    transform_.publish(transform);
+}
+
+void CoordinateAlignFilter::filter(unsigned n, const TimedXyzData* data)
+{
+    TimedXyzData* transformed = outputSpan(n);
 
-    transformed.timestamp_ = data->timestamp_;
+    transform_.update();
+    const Transform& t = transform_.current();
 
-    transformed.x_ = matrix_.get(0,0)*data->x_ + matrix_.get(0,1)*data->y_ + matrix_.get(0,2)*data->z_;
-    transformed.y_ = matrix_.get(1,0)*data->x_ + matrix_.get(1,1)*data->y_ + matrix_.get(1,2)*data->z_;
-    transformed.z_ = matrix_.get(2,0)*data->x_ + matrix_.get(2,1)*data->y_ + matrix_.get(2,2)*data->z_;
+    if (t.axisSwap) {
+        for (unsigned i = 0; i < n; ++i) {
+            const int in[3] = { data[i].x_, data[i].y_, data[i].z_ };
+            transformed[i].timestamp_ = data[i].timestamp_;
+            transformed[i].x_ = t.sign[0] * in[t.axis[0]];
+            transformed[i].y_ = t.sign[1] * in[t.axis[1]];
+            transformed[i].z_ = t.sign[2] * in[t.axis[2]];
+        }
+    } else {
+        block_.load(n, data);
+        block_.transform(t.coeff);
+        block_.store(transformed);
+    }
 
-    source_.propagate(1, &transformed);
+    source_.propagate(n, transformed);
 }
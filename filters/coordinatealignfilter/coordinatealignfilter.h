@@ -29,6 +29,9 @@
 
 #include "datatypes/orientationdata.h"
 #include "filter.h"
+#include "fixedpoint.h"
+#include "xyzblock.h"
+#include "liveparameter.h"
 
 /**
  * TMatrix holds a transformation matrix.
@@ -76,6 +79,7 @@ class CoordinateAlignFilter : public QObject, public Filter<TimedXyzData, Coordi
 {
     Q_OBJECT;
     Q_PROPERTY(TMatrix transMatrix READ matrix WRITE setMatrix);
+    Q_PROPERTY(QString matrix READ matrixString WRITE setMatrixString);
 public:
 
     /**
@@ -88,7 +92,23 @@ public:
 
     const TMatrix& matrix() const { return matrix_; }
 
-    void setMatrix(const TMatrix& matrix) { matrix_ = matrix; }
+    void setMatrix(const TMatrix& matrix);
+
+    /**
+     * Matrix as nine comma separated values in row order, the format
+     * of the <tt>transformation_matrix</tt> configuration keys.
+     *
+     * @return matrix as string.
+     */
+    QString matrixString() const;
+
+    /**
+     * Set matrix from nine comma separated values in row order. Invalid
+     * strings leave the matrix unchanged.
+     *
+     * @param str matrix as string.
+     */
+    void setMatrixString(const QString& str);
 
 protected:
     /**
@@ -99,7 +119,27 @@ protected:
 private:
     void filter(unsigned, const TimedXyzData*);
 
-    TMatrix matrix_;
+    /**
+     * Transformation derived from the matrix, read by #filter().
+     */
+    struct Transform
+    {
+        FilterScalar coeff[3][3]; /**< matrix in filter arithmetic */
+        bool    axisSwap;    /**< matrix is a signed permutation */
+        int     axis[3];     /**< source axis for each output axis */
+        int     sign[3];     /**< sign for each output axis */
+    };
+
+    /**
+     * Publish the transformation for #matrix_. Checks whether the matrix
+     * only swaps and/or negates axes. In that case transformation is
+     * done with integer shuffles instead of the floating point multiply.
+     */
+    void classifyMatrix();
+
+    TMatrix matrix_;      /**< matrix last set */
+    LiveParameter<Transform> transform_; /**< transformation used by the chain */
+    XyzBlock block_;      /**< batch being transformed */
 };
 
 #endif // COORDINATEALIGNFILTER_H
@@ -36,34 +36,34 @@ DeclinationFilter::DeclinationFilter() :
         declinationCorrection_(0)
 {
     g_type_init();
-    updateInterval_ = Config::configuration()->value<quint64>("compass/declination_update_interval", 1000 * 60 * 60) * 1000;
+    loadSettings();
+    connect(&updateTimer_, SIGNAL(timeout()), this, SLOT(loadSettings()));
+    updateTimer_.start(Config::configuration()->value<int>("compass/declination_update_interval", 1000 * 60 * 60));
 }
 
-void DeclinationFilter::correct(unsigned, const CompassData* data)
+void DeclinationFilter::correct(unsigned n, const CompassData* data)
 {
-    CompassData newOrientation(*data);
-    if(newOrientation.timestamp_ - lastUpdate_ > updateInterval_)
-    {
-        loadSettings();
-        lastUpdate_ = newOrientation.timestamp_;
-    }
-    newOrientation.correctedDegrees_ = newOrientation.degrees_;
-#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
-    if(declinationCorrection_)
-#else
-    if(declinationCorrection_.loadAcquire() == 0)
-#endif
-    {
+    if (!n || !source_.hasDemand())
+        return;
+
 #if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
-        newOrientation.correctedDegrees_ += declinationCorrection_;
+    int correction = declinationCorrection_;
 #else
-        newOrientation.correctedDegrees_ += declinationCorrection_.loadAcquire();
+    int correction = declinationCorrection_.loadAcquire();
 #endif
-        newOrientation.correctedDegrees_ %= 360;
-        sensordLogT() << "DeclinationFilter corrected degree " << newOrientation.degrees_ << " => " << newOrientation.correctedDegrees_ << ". Level: " << newOrientation.level_;
+    CompassData* corrected = outputSpan(n);
+    for (unsigned i = 0; i < n; ++i) {
+        CompassData& newOrientation = corrected[i];
+        newOrientation = data[i];
+        newOrientation.correctedDegrees_ = newOrientation.degrees_;
+        if (correction)
+        {
+            newOrientation.correctedDegrees_ += correction;
+            newOrientation.correctedDegrees_ = (newOrientation.correctedDegrees_ % 360 + 360) % 360;
+        }
     }
-    orientation_ = newOrientation;
-    source_.propagate(1, &orientation_);
+    orientation_ = corrected[n - 1];
+    source_.propagate(n, corrected);
 }
 
 void DeclinationFilter::loadSettings()
@@ -29,11 +29,17 @@
 
 #include <QObject>
 #include <QAtomicInt>
+#include <QTimer>
 #include "datatypes/orientationdata.h"
 #include "filter.h"
 
 /**
  * Filter for calculating declination correction for Compass data.
+ *
+ * The declination is read when the filter is created and refreshed
+ * every \c compass/declination_update_interval milliseconds from the
+ * thread owning the filter, so samples only add the cached value.
+ * Nothing is computed while no one reads the output.
  */
 class DeclinationFilter : public QObject, public Filter<CompassData, DeclinationFilter, CompassData>
 {
@@ -56,17 +62,17 @@ public:
      */
     int declinationCorrection();
 
+private Q_SLOTS:
+    void loadSettings();
+
 private:
     DeclinationFilter();
 
     void correct(unsigned, const CompassData*);
 
-    void loadSettings();
-
     CompassData orientation_;
     QAtomicInt declinationCorrection_;
-    quint64 lastUpdate_;
-    quint64 updateInterval_;
+    QTimer updateTimer_;
 
     static const char* declinationKey;
 };
@@ -27,72 +27,67 @@
 #include "logging.h"
 
 DownsampleFilter::DownsampleFilter() :
-    Filter<TimedXyzData, DownsampleFilter, TimedXyzData>(this, &DownsampleFilter::filter),
-    bufferSize_(1),
-    timeout_(-1)
+    Filter<TimedXyzData, DownsampleFilter, TimedXyzData>(this, &DownsampleFilter::filter)
 {
+    window_.setCapacity(parameters_.current().bufferSize);
 }
 
 unsigned int DownsampleFilter::bufferSize() const
 {
-    return bufferSize_;
+    return parameters_.value().bufferSize;
 }
 
 void DownsampleFilter::setBufferSize(unsigned int size)
 {
     sensordLogD() << "DownsampleFilter buffer size = " << size;
-    bufferSize_ = size;
+    Parameters parameters = parameters_.value();
+    parameters.bufferSize = size;
+    parameters_.publish(parameters);
 }
 
 int DownsampleFilter::timeout() const
 {
-    return timeout_ / 1000;
+    return parameters_.value().timeout / 1000;
 }
 
 void DownsampleFilter::setTimeout(int ms)
 {
-    timeout_ = static_cast<long>(ms) * 1000;
+    Parameters parameters = parameters_.value();
+    parameters.timeout = static_cast<long>(ms) * 1000;
+    parameters_.publish(parameters);
     sensordLogD() << "DownsampleFilter timeout = " << ms;
 }
 
-void DownsampleFilter::filter(unsigned, const TimedXyzData* data)
+void DownsampleFilter::filter(unsigned n, const TimedXyzData* data)
 {
-    buffer_.push_back(*data);
-
-    for(TimedXyzDownsampleBuffer::iterator it = buffer_.begin(); it != buffer_.end(); ++it)
-    {
-        if(static_cast<unsigned int>(buffer_.size()) > bufferSize_ ||
-           (timeout_ && (data->timestamp_ - it->timestamp_ >
-                         static_cast<unsigned long>(timeout_))))
-        {
-            it = buffer_.erase(it);
-            if(it == buffer_.end())
-                break;
-        }
-        else
-            break;
+    // The window is resized by the chain, never under its feet.
+    if (parameters_.update())
+        window_.setCapacity(parameters_.current().bufferSize);
+    const long timeout = parameters_.current().timeout;
+
+    TimedXyzData* downsampled = outputSpan(n);
+    unsigned count = 0;
+    for (unsigned i = 0; i < n; ++i) {
+        if (downsample(data[i], downsampled[count], timeout))
+            ++count;
     }
+    if (count)
+        source_.propagate(count, downsampled);
+}
 
-    if(static_cast<unsigned int>(buffer_.size()) < bufferSize_)
-        return;
-
-    long x = 0;
-    long y = 0;
-    long z = 0;
-    foreach(const TimedXyzData& data, buffer_)
-    {
-        x += data.x_;
-        y += data.y_;
-        z += data.z_;
-    }
-    int count = buffer_.count();
-    TimedXyzData downsampled(data->timestamp_,
-                             x / count,
-                             y / count,
-                             z / count);
+bool DownsampleFilter::downsample(const TimedXyzData& sample, TimedXyzData& downsampled, long timeout)
+{
+    window_.push(sample);
+    if (timeout > 0)
+        window_.dropOlderThan(sample.timestamp_, static_cast<quint64>(timeout));
+
+    if (!window_.isFull())
+        return false;
+
+    downsampled = window_.result();
 
     sensordLogT() << "Downsampled: " << downsampled.x_ << ", " << downsampled.y_ << ", " << downsampled.z_;
 
-    source_.propagate(1, &downsampled);
-    buffer_.clear();
+    window_.clear();
+    return true;
 }
@@ -26,10 +26,11 @@
 #ifndef DOWNSAMPLEFILTER_H
 #define DOWNSAMPLEFILTER_H
 
-#include <QList>
 #include <QObject>
 #include "datatypes/orientationdata.h"
 #include "filter.h"
+#include "downsamplewindow.h"
+#include "liveparameter.h"
 
 /**
  * @brief Downsample filter.
@@ -95,12 +96,29 @@ private:
      */
     void filter(unsigned, const TimedXyzData*);
 
-    /** Sample buffer type for TimedXyzData downsampling. */
-    typedef QList<TimedXyzData> TimedXyzDownsampleBuffer;
+    /**
+     * Add single sample to the downsample window.
+     *
+     * @param sample incoming sample.
+     * @param downsampled location for the downsampled result.
+     * @param timeout maximum sample age in microseconds, not used if not positive.
+     * @return was a downsampled result produced.
+     */
+    bool downsample(const TimedXyzData& sample, TimedXyzData& downsampled, long timeout);
+
+    /**
+     * Parameters set from the outside, read by #filter().
+     */
+    struct Parameters
+    {
+        Parameters() : bufferSize(1), timeout(-1) {}
+
+        unsigned int bufferSize; /**< buffer size */
+        long timeout;            /**< timeout in microseconds */
+    };
 
-    unsigned int bufferSize_; /**< buffer size */
-    long timeout_;   /**< timeout in milliseconds */
-    TimedXyzDownsampleBuffer buffer_; /**< downsample buffer */
+    LiveParameter<Parameters> parameters_; /**< parameters used by the chain */
+    DownsampleWindow<TimedXyzData> window_; /**< downsample window, used by the chain */
 };
 
 #endif // DOWNSAMPLEFILTER_H
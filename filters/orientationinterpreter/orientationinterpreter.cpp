@@ -30,6 +30,7 @@
 #include "orientationinterpreter.h"
 #include "logging.h"
 #include "config.h"
+#include "cpuboost.h"
 #include <math.h>
 #include <stdlib.h>
 #include <limits.h>
@@ -42,7 +43,9 @@ const int OrientationInterpreter::THRESHOLD_LANDSCAPE = 25;
 const int OrientationInterpreter::THRESHOLD_PORTRAIT = 20;
 const int OrientationInterpreter::DISCARD_TIME = 750000;
 const int OrientationInterpreter::AVG_BUFFER_MAX_SIZE = 10;
-const char* OrientationInterpreter::CPU_BOOST_PATH = "/sys/power/pm_optimizer_rotation";
+const int OrientationInterpreter::STILL_THRESHOLD = 20;
+const int OrientationInterpreter::STILL_TIME = 3000;
+const int OrientationInterpreter::BURST_TIME = 500;
 typedef PoseData (OrientationInterpreter::*ptrFUN)(int);
 
 OrientationInterpreter::OrientationInterpreter() :
@@ -51,7 +54,14 @@ OrientationInterpreter::OrientationInterpreter() :
         face(PoseData::Undefined),
         previousFace(PoseData::Undefined),
         orientationData(PoseData::Undefined),
-        cpuBoostFile(CPU_BOOST_PATH)
+        classifiedValid(false),
+        still(false),
+        burstEnabled(false),
+        burstTime(0),
+        burst(false),
+        burstStart(0),
+        rejectedCandidate(PoseData::Undefined),
+        reloadPending(0)
 
 {
     addSink(&accDataSink, "accsink");
@@ -59,6 +69,11 @@ OrientationInterpreter::OrientationInterpreter() :
     addSource(&faceSource, "face");
     addSource(&orientationSource, "orientation");
 
+    readConfiguration();
+}
+
+void OrientationInterpreter::readConfiguration()
+{
     minLimit = Config::configuration()->value("orientation/overflow_min", QVariant(OVERFLOW_MIN)).toInt();
     maxLimit = Config::configuration()->value("orientation/overflow_max", QVariant(OVERFLOW_MAX)).toInt();
 
@@ -66,17 +81,39 @@ OrientationInterpreter::OrientationInterpreter() :
     angleThresholdLandscape = Config::configuration()->value("orientation/threshold_landscape",QVariant(THRESHOLD_LANDSCAPE)).toInt();
     discardTime = Config::configuration()->value("orientation/discard_time", QVariant(DISCARD_TIME)).toUInt();
     maxBufferSize = Config::configuration()->value("orientation/buffer_size", QVariant(AVG_BUFFER_MAX_SIZE)).toInt();
+    long stillThreshold = Config::configuration()->value("orientation/still_threshold", QVariant(STILL_THRESHOLD)).toInt();
+    stillThresholdSquared = stillThreshold * stillThreshold;
+    stillTime = Config::configuration()->value("orientation/still_time", QVariant(STILL_TIME)).toUInt() * (quint64)1000;
+    burstEnabled = Config::configuration()->value("orientation/burst_interval", QVariant(0)).toUInt() > 0;
+    burstTime = Config::configuration()->value("orientation/burst_time", QVariant(BURST_TIME)).toUInt() * (quint64)1000;
+    if (!burstEnabled)
+        setBurst(false);
+
+    dataBuffer.setCapacity(maxBufferSize > 0 ? maxBufferSize : 1);
+}
 
-    // Open the handle for boosting cpu on changes that affect orientation
-    if (!cpuBoostFile.exists() || !cpuBoostFile.open(QIODevice::WriteOnly))
-    {
-        sensordLogW() << "Failed to open" << CPU_BOOST_PATH << "for adjusting cpu freq for orientation.";
-    }
+void OrientationInterpreter::reloadConfiguration()
+{
+    reloadPending.fetchAndStoreRelease(1);
 }
 
-void OrientationInterpreter::accDataAvailable(unsigned, const AccelerationData* pdata)
+void OrientationInterpreter::accDataAvailable(unsigned n, const AccelerationData* pdata)
 {
-    data = *pdata;
+    // Settings are only touched from the thread processing samples.
+    if (reloadPending.fetchAndStoreAcquire(0))
+        readConfiguration();
+
+    // Nobody reads top edge, face or orientation, skip classification.
+    if (!hasDemand())
+        return;
+
+    for (unsigned i = 0; i < n; ++i)
+        processSample(pdata[i]);
+}
+
+void OrientationInterpreter::processSample(const AccelerationData& input)
+{
+    data = input;
 
     // Check overflow
     if (overFlowCheck())
@@ -85,29 +122,26 @@ void OrientationInterpreter::accDataAvailable(unsigned, const AccelerationData*
         return;
     }
 
-    // Append new value to buffer
-    dataBuffer.append(data);
+    if (burstEnabled)
+        checkBurst(data);
 
-    // Clear old values from buffer.
-    while (dataBuffer.count() > maxBufferSize || (dataBuffer.count() > 1 && (data.timestamp_ - dataBuffer.first().timestamp_ > discardTime)))
-    {
-        dataBuffer.removeFirst();
-    }
+    // Window drops the oldest value when full and keeps running sums,
+    // so averaging does not depend on the buffer size.
+    dataBuffer.push(data);
+    dataBuffer.dropOlderThan(data.timestamp_, discardTime);
+    data = dataBuffer.result();
 
-    //Calculate average
-    long x = 0;
-    long y = 0;
-    long z = 0;
-    foreach (const AccelerationData& sample, dataBuffer)
+    // Classification only changes when the averaged vector moves, so
+    // the angle math is skipped while the device is still.
+    if (!hasMoved())
     {
-        x += sample.x_;
-        y += sample.y_;
-        z += sample.z_;
+        if (!still && data.timestamp_ - classified.timestamp_ >= stillTime)
+            setStill(true);
+        return;
     }
-
-    data.x_ = x / dataBuffer.count();
-    data.y_ = y / dataBuffer.count();
-    data.z_ = z / dataBuffer.count();
+    classified = data;
+    classifiedValid = true;
+    setStill(false);
 
     // calculate topedge
     processTopEdge();
@@ -125,6 +159,65 @@ bool OrientationInterpreter::overFlowCheck()
     return !((vector >= minLimit) && (vector <= maxLimit));
 }
 
+bool OrientationInterpreter::hasMoved() const
+{
+    if (!classifiedValid)
+        return true;
+    long dx = data.x_ - classified.x_;
+    long dy = data.y_ - classified.y_;
+    long dz = data.z_ - classified.z_;
+    long distance = dx * dx + dy * dy + dz * dz;
+    return distance && distance >= stillThresholdSquared;
+}
+
+void OrientationInterpreter::setStill(bool value)
+{
+    if (still == value)
+        return;
+    still = value;
+    sensordLogT() << "Device still: " << still;
+    emit stillnessChanged(still);
+}
+
+void OrientationInterpreter::checkBurst(const AccelerationData& sample)
+{
+    if (burst)
+    {
+        if (sample.timestamp_ - burstStart >= burstTime)
+        {
+            // Not confirmed, do not burst again for the same candidate
+            // while the device is held at that angle.
+            sensordLogT() << "Orientation burst timed out";
+            rejectedCandidate = classifyTopEdge(sample).orientation_;
+            setBurst(false);
+        }
+        return;
+    }
+
+    // A single sample is enough to suspect a change, the average is
+    // what confirms it.
+    PoseData::Orientation candidate = classifyTopEdge(sample).orientation_;
+    if (candidate == topEdge.orientation_)
+    {
+        rejectedCandidate = PoseData::Undefined;
+        return;
+    }
+    if (candidate == rejectedCandidate)
+        return;
+
+    sensordLogT() << "Candidate top edge " << candidate << ", bursting";
+    burstStart = sample.timestamp_;
+    setBurst(true);
+}
+
+void OrientationInterpreter::setBurst(bool value)
+{
+    if (burst == value)
+        return;
+    burst = value;
+    emit burstChanged(burst);
+}
+
 int OrientationInterpreter::orientationCheck(const AccelerationData &data,  OrientationMode mode) const
 {
     if (mode == OrientationInterpreter::Landscape)
@@ -176,7 +269,7 @@ PoseData OrientationInterpreter::orientationRotation (const AccelerationData &da
     return newTopEdge;
 }
 
-void OrientationInterpreter::processTopEdge()
+PoseData OrientationInterpreter::classifyTopEdge(const AccelerationData& vector)
 {
     PoseData newTopEdge = PoseData::Undefined;
     ptrFUN rotator;
@@ -191,29 +284,39 @@ void OrientationInterpreter::processTopEdge()
         rotator = &OrientationInterpreter::rotateToLandscape;
     }
 
-    newTopEdge = orientationRotation(data, mode, rotator);
+    newTopEdge = orientationRotation(vector, mode, rotator);
 
     if (newTopEdge.orientation_ == PoseData::Undefined) //not rotate yet, then check for the other threshold
     {
         mode = (mode == OrientationInterpreter::Portrait) ? (OrientationInterpreter::Landscape) : (OrientationInterpreter::Portrait);
         rotator = (rotator == (&OrientationInterpreter::rotateToPortrait)) ? (&OrientationInterpreter::rotateToLandscape) : (&OrientationInterpreter::rotateToPortrait);
-        newTopEdge = orientationRotation(data, mode, rotator);
+        newTopEdge = orientationRotation(vector, mode, rotator);
     }
 
+    return newTopEdge;
+}
+
+void OrientationInterpreter::processTopEdge()
+{
+    PoseData newTopEdge = classifyTopEdge(data);
+
     // Propagate if changed
     if (topEdge.orientation_ != newTopEdge.orientation_)
     {
         // Request CPU clock raise to get smooth desktop rotation
-        if (cpuBoostFile.isOpen())
+        CpuBoost::instance().request(CpuBoost::OrientationChange);
+
         {
-            cpuBoostFile.write("1", 1);
-            cpuBoostFile.flush();
+            QMutexLocker locker(&stateMutex);
+            topEdge.orientation_ = newTopEdge.orientation_;
+            topEdge.timestamp_ = data.timestamp_;
         }
-
-        topEdge.orientation_ = newTopEdge.orientation_;
         sensordLogT() << "new TopEdge value: " << topEdge.orientation_;
-        topEdge.timestamp_ = data.timestamp_;
         topEdgeSource.propagate(1, &topEdge);
+
+        // Change is confirmed, back to the requested rate.
+        rejectedCandidate = PoseData::Undefined;
+        setBurst(false);
     }
 }
 
@@ -237,8 +340,11 @@ void OrientationInterpreter::processFace()
 
         if (face.orientation_ != previousFace.orientation_)
         {
-            previousFace.orientation_ = face.orientation_;
             face.timestamp_ = data.timestamp_;
+            {
+                QMutexLocker locker(&stateMutex);
+                previousFace = face;
+            }
             faceSource.propagate(1, &face);
         }
     }
@@ -255,9 +361,12 @@ void OrientationInterpreter::processOrientation()
     }
 
     if (newPose.orientation_ != orientationData.orientation_) {
-        orientationData.orientation_ = newPose.orientation_;
+        {
+            QMutexLocker locker(&stateMutex);
+            orientationData.orientation_ = newPose.orientation_;
+            orientationData.timestamp_ = data.timestamp_;
+        }
         sensordLogT() << "New orientation value: " << orientationData.orientation_;
-        orientationData.timestamp_ = data.timestamp_;
         orientationSource.propagate(1, &orientationData);
     }
 }
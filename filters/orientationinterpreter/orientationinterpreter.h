@@ -30,8 +30,10 @@
 #define ORIENTATIONINTERPRETER_H
 
 #include <QObject>
-#include <QFile>
+#include <QAtomicInt>
+#include <QMutex>
 #include "filter.h"
+#include "downsamplewindow.h"
 #include <datatypes/orientationdata.h>
 #include <datatypes/posedata.h>
 
@@ -41,12 +43,18 @@
  * Filter for calculating the device orientation. Input from
  * #AccelerometerChain is used.
  *
+ * Top edge, face and orientation are events: each source propagates a
+ * value only when the classification changes. The current state can be
+ * read at any time from the \c orientation, \c topEdge and \c face
+ * properties.
  */
 class OrientationInterpreter : public QObject, public FilterBase
 {
     Q_OBJECT;
 
     Q_PROPERTY(PoseData orientation READ orientation);
+    Q_PROPERTY(PoseData topEdge READ currentTopEdge);
+    Q_PROPERTY(PoseData face READ currentFace);
 
 private:
     Sink<OrientationInterpreter, AccelerationData> accDataSink;
@@ -55,8 +63,15 @@ private:
     Source<PoseData> orientationSource;
 
     void accDataAvailable(unsigned, const AccelerationData*);
+    void readConfiguration();
+    void processSample(const AccelerationData& input);
 
     bool overFlowCheck();
+    bool hasMoved() const;
+    void setStill(bool value);
+    void checkBurst(const AccelerationData& sample);
+    void setBurst(bool value);
+    PoseData classifyTopEdge(const AccelerationData& vector);
     void processTopEdge();
     void processFace();
     void processOrientation();
@@ -69,7 +84,18 @@ private:
     bool updatePreviousFace;
 
     AccelerationData data;
-    QList<AccelerationData> dataBuffer;
+    DownsampleWindow<AccelerationData> dataBuffer;
+
+    AccelerationData classified;   /**< averaged vector of the last classification */
+    bool classifiedValid;          /**< has a vector been classified */
+    long stillThresholdSquared;    /**< squared movement below which classification is skipped */
+    quint64 stillTime;             /**< time without movement before device is still (microsec) */
+    bool still;                    /**< is device still */
+    bool burstEnabled;             /**< confirm candidate top edges at a raised rate */
+    quint64 burstTime;             /**< longest burst (microsec) */
+    bool burst;                    /**< is a burst running */
+    quint64 burstStart;            /**< timestamp of the sample starting the burst */
+    PoseData::Orientation rejectedCandidate; /**< candidate whose burst timed out */
 
     int minLimit;
     int maxLimit;
@@ -80,7 +106,14 @@ private:
 
     PoseData orientationData;
 
-    QFile cpuBoostFile;
+    /**
+     * Protects topEdge, previousFace and orientationData against
+     * queries from other threads. The processing thread takes it only
+     * to change them.
+     */
+    mutable QMutex stateMutex;
+
+    QAtomicInt reloadPending;      /**< read configuration before the next sample */
 
     enum OrientationMode
     {
@@ -104,8 +137,10 @@ private:
 
     static const int DISCARD_TIME;
     static const int AVG_BUFFER_MAX_SIZE;
+    static const int STILL_THRESHOLD;
+    static const int STILL_TIME;
+    static const int BURST_TIME;
 
-    static const char* CPU_BOOST_PATH;
 
 public:
     /**
@@ -117,7 +152,70 @@ public:
         return new OrientationInterpreter();
     }
 
-    PoseData orientation() const { return orientationData; }
+    /**
+     * Current orientation, top edge if defined, face otherwise. Safe to
+     * call from any thread.
+     *
+     * @return current orientation.
+     */
+    PoseData orientation() const
+    {
+        QMutexLocker locker(&stateMutex);
+        return orientationData;
+    }
+
+    /**
+     * Current top edge. Safe to call from any thread.
+     *
+     * @return current top edge.
+     */
+    PoseData currentTopEdge() const
+    {
+        QMutexLocker locker(&stateMutex);
+        return topEdge;
+    }
+
+    /**
+     * Current face. Safe to call from any thread.
+     *
+     * @return current face.
+     */
+    PoseData currentFace() const
+    {
+        QMutexLocker locker(&stateMutex);
+        return previousFace;
+    }
+
+public Q_SLOTS:
+    /**
+     * Read the <tt>orientation/</tt> settings again before the next
+     * sample is processed. Safe to call from any thread.
+     */
+    void reloadConfiguration();
+
+Q_SIGNALS:
+    /**
+     * Emitted when the averaged acceleration has not moved beyond
+     * <tt>orientation/still_threshold</tt> for
+     * <tt>orientation/still_time</tt>, and again when it moves. Emitted
+     * from the thread processing the samples.
+     *
+     * @param still is device still.
+     */
+    void stillnessChanged(bool still);
+
+    /**
+     * Emitted when a single sample points to another top edge than the
+     * averaged classification, and again when the change is confirmed
+     * or <tt>orientation/burst_time</tt> passes. The chain raises the
+     * accelerometer rate in between, so the average catches up quickly
+     * even at a low idle rate. Only emitted when
+     * <tt>orientation/burst_interval</tt> is set. Emitted from the
+     * thread processing the samples.
+     *
+     * @param burst is a burst wanted.
+     */
+    void burstChanged(bool burst);
 };
 
 #endif
@@ -26,6 +26,7 @@
 
 #include "rotationfilter.h"
 #include <math.h>
+#include "config.h"
 
 RotationFilter::RotationFilter() :
         accelerometerDataSink_(this, &RotationFilter::interpret),
@@ -35,36 +36,65 @@ RotationFilter::RotationFilter() :
     addSink(&accelerometerDataSink_, "accelerometersink");
     addSink(&compassDataSink_, "compasssink");
     addSource(&source_, "source");
+
+    compassHistory_.setMode(timeAlignModeFromString(Config::configuration()->value<QString>("compass/sync_mode", "nearest")));
 }
 
-void RotationFilter::interpret(unsigned, const TimedXyzData* data)
+void RotationFilter::interpret(unsigned n, const TimedXyzData* values)
 {
-    const int RADIANS_TO_DEGREES = 180/M_PI;
-
-    rotation_.timestamp_ = data->timestamp_;
-
-    // X-Rotation
-    rotation_.x_ = round(atan((double)data->y_ / sqrt(data->x_ * data->x_ + data->z_ * data->z_)) * RADIANS_TO_DEGREES);
-    rotation_.x_ = -rotation_.x_;
-
-    // Y-rotation
-    if (data->x_ == 0 && data->y_ == 0 && data->z_ > 0) {
-        rotation_.y_ = 180;
-    } else if (data->x_ == 0 && data->z_  == 0) {
-        rotation_.y_ = 0;
-    } else {
-        rotation_.y_ = round(atan((double)data->x_ / sqrt(data->y_ * data->y_ + data->z_ * data->z_)) * RADIANS_TO_DEGREES);
-
-        qreal theta = atan(sqrt(data->x_ * data->x_ + data->y_ * data->y_) / data->z_) * RADIANS_TO_DEGREES;
-        if (theta > 0) {
-            if (rotation_.y_ >= 0)
-                rotation_.y_ = 180 - rotation_.y_;
-            else
-                rotation_.y_ = -180 - rotation_.y_;
+    const float RADIANS_TO_DEGREES = 180.0f / (float)M_PI;
+
+    if (!source_.hasDemand())
+        return;
+
+    if ((unsigned)output_.size() < n)
+        output_.resize(n);
+
+    for (unsigned i = 0; i < n; ++i) {
+        const TimedXyzData* data = &values[i];
+
+        // Squares are shared by both rotations. Float also keeps large
+        // raw values from overflowing the int products.
+        float x = data->x_;
+        float y = data->y_;
+        float z = data->z_;
+        float xx = x * x;
+        float yy = y * y;
+        float zz = z * z;
+
+        rotation_.timestamp_ = data->timestamp_;
+
+        /// Z-rotation from the heading at the time of this sample.
+        /// Compass output is [0, 360), rotation is (-180, 180]
+        CompassData compass;
+        if (compassHistory_.sample(data->timestamp_, compass))
+            rotation_.z_ = -1 * (compass.degrees_ - 180);
+
+        // X-Rotation
+        rotation_.x_ = -(int)lroundf(atan2f(y, sqrtf(xx + zz)) * RADIANS_TO_DEGREES);
+
+        // Y-rotation
+        if (data->x_ == 0 && data->y_ == 0 && data->z_ > 0) {
+            rotation_.y_ = 180;
+        } else if (data->x_ == 0 && data->z_  == 0) {
+            rotation_.y_ = 0;
+        } else {
+            rotation_.y_ = lroundf(atan2f(x, sqrtf(yy + zz)) * RADIANS_TO_DEGREES);
+
+            // Tilt from the z axis is positive unless z points down,
+            // x and y can not both be zero here when z is up.
+            if (data->z_ >= 0) {
+                if (rotation_.y_ >= 0)
+                    rotation_.y_ = 180 - rotation_.y_;
+                else
+                    rotation_.y_ = -180 - rotation_.y_;
+            }
         }
+
+        output_[i] = rotation_;
     }
 
-    source_.propagate(1, &rotation_);
+    source_.propagate(n, output_.constData());
 }
 
 double RotationFilter::vectorLength(const TimedXyzData& data)
@@ -72,11 +102,8 @@ double RotationFilter::vectorLength(const TimedXyzData& data)
     return sqrt(data.x_ * data.x_ + data.y_ * data.y_ + data.z_ * data.z_);
 }
 
-void RotationFilter::updateZvalue(unsigned, const CompassData* data)
+void RotationFilter::updateZvalue(unsigned n, const CompassData* values)
 {
-    rotation_.timestamp_ = data->timestamp_;
-
-    /// Z-rotation
-    /// Compass output is [0, 360), rotation is (-180, 180]
-    rotation_.z_ = -1 * (data->degrees_ - 180);
+    // Headings are looked up at the time of each accelerometer sample.
+    compassHistory_.add(n, values);
 }
@@ -30,6 +30,7 @@
 
 #include "orientationdata.h"
 #include "filter.h"
+#include "timealigner.h"
 
 /**
  * @brief Filter for calculating device axis rotations.
@@ -76,6 +77,8 @@ private:
     }
 
     TimedXyzData rotation_;
+    QVector<TimedXyzData> output_;
+    TimeAligner<CompassData> compassHistory_; /**< headings by time */
 };
 
 #endif // ROTATIONFILTER_H
@@ -0,0 +1,114 @@
+/**
+   @file latestsample.h
+   @brief Shared memory latest sample page layout
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef LATEST_SAMPLE_H
+#define LATEST_SAMPLE_H
+
+#include <string.h>
+
+/**
+ * Prefix of the POSIX shared memory name of a latest sample page. The
+ * sensor ID follows, e.g. <tt>/sensord-latest-accelerometersensor</tt>.
+ */
+const char LATEST_SAMPLE_PREFIX[] = "/sensord-latest-";
+
+/**
+ * Magic number stored at the beginning of the page.
+ */
+const unsigned int LATEST_SAMPLE_MAGIC = 0x73666c73;
+
+/**
+ * Version of the page layout.
+ */
+const unsigned int LATEST_SAMPLE_VERSION = 1;
+
+/**
+ * Largest supported sample size.
+ */
+const unsigned int LATEST_SAMPLE_MAX_SIZE = 64;
+
+/**
+ * Latest sample of a sensor channel, guarded by a sequence lock.
+ * sensord is the only writer: it makes the sequence odd, copies the
+ * sample and makes the sequence even again. Readers copy the sample
+ * between two loads of the sequence and retry when the sequence was
+ * odd or changed. Sequence zero means no sample has been written yet.
+ */
+struct LatestSamplePage
+{
+    unsigned int magic;     /**< LATEST_SAMPLE_MAGIC */
+    unsigned int version;   /**< LATEST_SAMPLE_VERSION */
+    unsigned int size;      /**< size of the sample */
+    unsigned int sequence;  /**< odd while the sample is written */
+    char padding[48];       /**< keep the sample cache line aligned */
+    char data[LATEST_SAMPLE_MAX_SIZE]; /**< the sample */
+};
+
+/**
+ * Store a sample into the page.
+ *
+ * @param page page to write.
+ * @param data sample.
+ * @param size sample size, at most LATEST_SAMPLE_MAX_SIZE.
+ */
+inline void latestSampleWrite(LatestSamplePage* page, const void* data, unsigned int size)
+{
+    if (size > LATEST_SAMPLE_MAX_SIZE)
+        return;
+    unsigned int sequence = page->sequence;
+    __atomic_store_n(&page->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    page->size = size;
+    memcpy(page->data, data, size);
+    __atomic_store_n(&page->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+/**
+ * Read the sample from the page.
+ *
+ * @param page page to read.
+ * @param data location for the sample.
+ * @param size expected sample size.
+ * @return was a consistent sample of expected size read.
+ */
+inline bool latestSampleRead(const LatestSamplePage* page, void* data, unsigned int size)
+{
+    if (size > LATEST_SAMPLE_MAX_SIZE)
+        return false;
+    // The writer holds the page for a single memcpy, a few tries suffice.
+    for (int tries = 0; tries < 16; ++tries) {
+        unsigned int sequence = __atomic_load_n(&page->sequence, __ATOMIC_ACQUIRE);
+        if (!sequence)
+            return false;
+        if (sequence & 1)
+            continue;
+        unsigned int written = page->size;
+        memcpy(data, page->data, size);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&page->sequence, __ATOMIC_RELAXED) == sequence)
+            return written == size;
+    }
+    return false;
+}
+
+#endif // LATEST_SAMPLE_H
@@ -39,4 +39,9 @@ const QString SERVICE_NAME = "com.nokia.SensorService";
  */
 const QString OBJECT_PATH  = "/SensorManager";
 
+/**
+ * Path of the optional peer-to-peer DBus socket.
+ */
+const QString PEER_SOCKET_PATH = "/var/run/sensord-dbus.sock";
+
 #endif // SRVC_INFO_H
@@ -0,0 +1,105 @@
+/**
+   @file sessionframe.h
+   @brief Session data frame header
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef SESSION_FRAME_H
+#define SESSION_FRAME_H
+
+/**
+ * Set in SessionFrameHeader::count when the samples of the frame are
+ * followed by a SessionFrameTrace. Only sent to sessions which have
+ * enabled latency tracing.
+ */
+const unsigned int SESSION_FRAME_TRACED = 0x80000000;
+
+/**
+ * Set in SessionFrameHeader::count when the samples of the frame are
+ * in the compact encoding described by SessionCompactHeader. Only sent
+ * to sessions which have enabled the compact format.
+ */
+const unsigned int SESSION_FRAME_COMPACT = 0x40000000;
+
+/**
+ * Header preceding the samples of every frame written to the session
+ * data socket.
+ */
+struct SessionFrameHeader
+{
+    /**
+     * Number of samples in the frame, possibly combined with
+     * #SESSION_FRAME_TRACED.
+     */
+    unsigned int count;
+
+    /**
+     * Sequence number of the first sample in the frame. The sequence
+     * advances by one for every sample written or dropped by sensord,
+     * so a gap between consecutive frames tells how many samples were
+     * lost on the way. Samples left out by downsampling do not count.
+     */
+    unsigned int sequence;
+};
+
+/**
+ * Starts the samples of a compact frame. Every sample is taken to be a
+ * 64-bit timestamp followed by 32-bit values. The samples are encoded
+ * as follows:
+ *
+ * - \c count - 1 timestamp deltas of \c deltaBytes each, the first
+ *   sample having #timestamp.
+ * - For every sample, the values of the sample. Values whose bit is set
+ *   in #narrowMask are stored as 16 bits and sign extended when
+ *   decoded, the others as 32 bits.
+ *
+ * Decoding restores the samples byte for byte.
+ */
+struct SessionCompactHeader
+{
+    unsigned long long timestamp; /**< timestamp of the first sample */
+    unsigned char deltaBytes;     /**< size of a timestamp delta, 2 or 4 */
+    unsigned char values;         /**< 32-bit values per sample */
+    unsigned short narrowMask;    /**< values stored as 16 bits */
+    unsigned int reserved;        /**< zero */
+};
+
+/**
+ * Precedes every frame on a connection carrying several sessions.
+ */
+struct SessionMultiplexTag
+{
+    int sessionId;     /**< session the frame belongs to */
+    unsigned int size; /**< size of the following frame in bytes */
+};
+
+/**
+ * Stage timestamps of the newest sample of a traced frame. All times
+ * are CLOCK_MONOTONIC in microseconds, the clock of sample timestamps.
+ */
+struct SessionFrameTrace
+{
+    unsigned long long sampled;   /**< timestamp set by the adaptor */
+    unsigned long long queued;    /**< queued for the main thread by the channel */
+    unsigned long long delivered; /**< taken from the queue by the main thread */
+    unsigned long long written;   /**< frame written to the socket */
+};
+
+#endif // SESSION_FRAME_H
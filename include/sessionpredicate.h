@@ -0,0 +1,131 @@
+/**
+   @file sessionpredicate.h
+   @brief Session predicate
+
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef SESSION_PREDICATE_H
+#define SESSION_PREDICATE_H
+
+#include <math.h>
+
+/*
+ * Condition a session attaches to a sensor channel so that sensord
+ * delivers samples only while it holds, shared by sensord and the
+ * client libraries. Plain C++ only, see sessionprotocol.h.
+ *
+ * The condition becomes true when the value of the axis crosses the
+ * threshold and false only when it crosses back by the hysteresis.
+ * Samples are delivered once it has been true for the duration, and
+ * the first sample after it turns false is delivered too, so that the
+ * client learns about that.
+ */
+
+/**
+ * Value a predicate compares. Sensors with a single value, such as
+ * ambient light or proximity, only have #PREDICATE_AXIS_X.
+ */
+enum SessionPredicateAxis
+{
+    PREDICATE_AXIS_X = 0,         /**< x axis, or the value */
+    PREDICATE_AXIS_Y = 1,         /**< y axis */
+    PREDICATE_AXIS_Z = 2,         /**< z axis */
+    PREDICATE_AXIS_MAGNITUDE = 3, /**< length of the xyz vector */
+    PREDICATE_AXIS_TILT = 4       /**< angle between the xyz vector and z axis, degrees */
+};
+
+/**
+ * Comparison of a predicate.
+ */
+enum SessionPredicateComparison
+{
+    PREDICATE_ABOVE = 0, /**< value above the threshold */
+    PREDICATE_BELOW = 1  /**< value below the threshold */
+};
+
+/**
+ * Condition of a session.
+ */
+struct SessionPredicate
+{
+    int          axis;       /**< SessionPredicateAxis */
+    int          comparison; /**< SessionPredicateComparison */
+    double       threshold;  /**< threshold in the unit of the sensor */
+    double       hysteresis; /**< crossing back needed to turn false */
+    unsigned int duration;   /**< time the condition holds before delivery, milliseconds */
+};
+
+/**
+ * Number of sensor axes a predicate needs.
+ *
+ * @param axis SessionPredicateAxis.
+ * @return number of axes, 0 if axis is not known.
+ */
+inline int sessionPredicateAxes(int axis)
+{
+    switch (axis) {
+    case PREDICATE_AXIS_X: return 1;
+    case PREDICATE_AXIS_Y: return 2;
+    case PREDICATE_AXIS_Z:
+    case PREDICATE_AXIS_MAGNITUDE:
+    case PREDICATE_AXIS_TILT: return 3;
+    default: return 0;
+    }
+}
+
+/**
+ * Value of the predicate axis.
+ *
+ * @param predicate predicate.
+ * @param axes values of the sensor axes.
+ * @return compared value.
+ */
+inline double sessionPredicateValue(const SessionPredicate& predicate, const double* axes)
+{
+    double magnitude;
+    switch (predicate.axis) {
+    case PREDICATE_AXIS_MAGNITUDE:
+        return sqrt(axes[0] * axes[0] + axes[1] * axes[1] + axes[2] * axes[2]);
+    case PREDICATE_AXIS_TILT:
+        magnitude = sqrt(axes[0] * axes[0] + axes[1] * axes[1] + axes[2] * axes[2]);
+        return magnitude > 0 ? acos(fabs(axes[2]) / magnitude) * 180 / M_PI : 0;
+    default:
+        return axes[predicate.axis];
+    }
+}
+
+/**
+ * Does the condition hold.
+ *
+ * @param predicate predicate.
+ * @param value compared value.
+ * @param held did it hold for the previous sample.
+ * @return does condition hold.
+ */
+inline bool sessionPredicateHolds(const SessionPredicate& predicate, double value, bool held)
+{
+    double hysteresis = held ? predicate.hysteresis : 0;
+    if (predicate.comparison == PREDICATE_BELOW)
+        return value < predicate.threshold + hysteresis;
+    return value > predicate.threshold - hysteresis;
+}
+
+#endif // SESSION_PREDICATE_H
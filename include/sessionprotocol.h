@@ -0,0 +1,625 @@
+/**
+   @file sessionprotocol.h
+   @brief Session data connection protocol
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef SESSION_PROTOCOL_H
+#define SESSION_PROTOCOL_H
+
+#include <stddef.h>
+#include <string.h>
+
+#include "sessionframe.h"
+#include "sharedring.h"
+
+/*
+ * Wire protocol of the session data connection, shared by sensord and
+ * the client libraries. Only plain C++ is used so that clients which do
+ * not link Qt can include it.
+ *
+ * Handshake:
+ * - sensord writes #SESSION_GREETING to every new connection.
+ * - Client writes its session ID as an int, optionally followed by
+ *   #SHARED_RING_REQUEST in the same write.
+ * - After a shared memory request sensord replies with
+ *   #SHARED_RING_ACCEPTED and the ring descriptor, or with
+ *   #SHARED_RING_REJECTED.
+ * - Or the client writes #SESSION_MULTIPLEX_REQUEST after the ID, and
+ *   sensord replies with #SESSION_MULTIPLEX_ACCEPTED. After that the
+ *   client may attach more sessions to the same connection by writing
+ *   further multiplex requests; those are not replied to.
+ *
+ * After the handshake sensord writes frames: a SessionFrameHeader,
+ * \c count samples and a SessionFrameTrace if the frame is traced. With
+ * shared memory the samples are in the ring and the socket only carries
+ * single doorbell bytes. On a multiplexed connection every frame is
+ * preceded by a SessionMultiplexTag.
+ *
+ * The same protocol is spoken on #SESSION_SEQPACKET_SOCKET_PATH when
+ * sensord listens on it. There every frame, with its tag if any, is one
+ * packet, so a client never receives part of a frame. Frames not fitting
+ * into the socket are dropped whole and show up as a sequence gap.
+ */
+
+/**
+ * Path of the sensord data socket.
+ */
+const char* const SESSION_SOCKET_PATH = "/var/run/sensord.sock";
+
+/**
+ * Path of the optional SOCK_SEQPACKET data socket.
+ */
+const char* const SESSION_SEQPACKET_SOCKET_PATH = "/var/run/sensord-seqpacket.sock";
+
+/**
+ * Byte written by sensord to every new data connection.
+ */
+const char SESSION_GREETING = '\n';
+
+/**
+ * Frames claiming more samples than this are treated as corrupted.
+ */
+const unsigned int SESSION_FRAME_MAX_SAMPLES = 1000;
+
+/**
+ * Written by the client right after the session ID to carry the session
+ * on a connection shared by several sessions.
+ */
+const int SESSION_MULTIPLEX_REQUEST = 0x4d555831; // "MUX1"
+
+/**
+ * Reply byte sent by sensord when it accepts the first multiplexed
+ * session of a connection.
+ */
+const char SESSION_MULTIPLEX_ACCEPTED = 'M';
+
+/**
+ * Session request written by the client after the greeting.
+ */
+struct SessionRequest
+{
+    int sessionId;  /**< session ID from requestSensor */
+    int transport;  /**< #SHARED_RING_REQUEST, #SESSION_MULTIPLEX_REQUEST or not sent */
+};
+
+/**
+ * Encode session request.
+ *
+ * @param sessionId session ID.
+ * @param sharedMemory request shared memory transport.
+ * @param request request to fill.
+ * @return number of bytes of the request to write.
+ */
+inline size_t sessionRequestEncode(int sessionId, bool sharedMemory, SessionRequest& request)
+{
+    request.sessionId = sessionId;
+    request.transport = SHARED_RING_REQUEST;
+    return sharedMemory ? sizeof(request) : sizeof(request.sessionId);
+}
+
+/**
+ * Encode request to carry the session on a multiplexed connection.
+ *
+ * @param sessionId session ID.
+ * @param request request to fill.
+ * @return number of bytes of the request to write.
+ */
+inline size_t sessionMultiplexEncode(int sessionId, SessionRequest& request)
+{
+    request.sessionId = sessionId;
+    request.transport = SESSION_MULTIPLEX_REQUEST;
+    return sizeof(request);
+}
+
+/**
+ * Read the tag preceding a frame on a multiplexed connection.
+ *
+ * @param buffer received bytes.
+ * @param size number of received bytes.
+ * @param tag tag to fill.
+ * @return was the tag and the whole frame following it received.
+ */
+inline bool sessionMultiplexTag(const char* buffer, size_t size, SessionMultiplexTag& tag)
+{
+    if (size < sizeof(tag))
+        return false;
+    memcpy(&tag, buffer, sizeof(tag));
+    return size - sizeof(tag) >= tag.size;
+}
+
+/**
+ * Decode session request.
+ *
+ * @param data received bytes.
+ * @param size number of received bytes.
+ * @param request request to fill. Transport is zero if not sent.
+ * @return was a session ID received.
+ */
+inline bool sessionRequestDecode(const void* data, size_t size, SessionRequest& request)
+{
+    request.sessionId = -1;
+    request.transport = 0;
+    memcpy(&request, data, size < sizeof(request) ? size : sizeof(request));
+    return size >= sizeof(request.sessionId) && request.sessionId >= 0;
+}
+
+/**
+ * Build a frame header.
+ *
+ * @param count number of samples.
+ * @param sequence sequence number of the first sample.
+ * @param traced is the frame followed by a SessionFrameTrace.
+ * @param compact are the samples in the compact encoding.
+ * @return header.
+ */
+inline SessionFrameHeader sessionFrameHeader(unsigned int count, unsigned int sequence, bool traced, bool compact = false)
+{
+    SessionFrameHeader header;
+    header.count = count | (traced ? SESSION_FRAME_TRACED : 0) | (compact ? SESSION_FRAME_COMPACT : 0);
+    header.sequence = sequence;
+    return header;
+}
+
+/**
+ * Most values per sample in the compact encoding.
+ */
+const unsigned int SESSION_COMPACT_MAX_VALUES = 16;
+
+/**
+ * Size of compact encoded samples.
+ *
+ * @param header compact header.
+ * @param count number of samples.
+ * @return size in bytes, including the header.
+ */
+inline size_t sessionCompactSize(const SessionCompactHeader& header, unsigned int count)
+{
+    unsigned int narrow = 0;
+    for (unsigned int i = 0; i < header.values; ++i)
+        narrow += (header.narrowMask >> i) & 1;
+    size_t sampleBytes = narrow * 2 + (header.values - narrow) * 4;
+    return sizeof(header) + (size_t)(count ? count - 1 : 0) * header.deltaBytes + (size_t)count * sampleBytes;
+}
+
+/**
+ * Encode samples in the compact encoding, see SessionCompactHeader.
+ *
+ * @param samples samples, back to back.
+ * @param count number of samples.
+ * @param sampleSize size of a single sample.
+ * @param target location for the encoded samples, at least
+ *               <tt>count * sampleSize</tt> bytes.
+ * @return size of the encoded samples, or 0 if the samples can not be
+ *         encoded or would not get smaller.
+ */
+inline size_t sessionCompactEncode(const char* samples, unsigned int count, unsigned int sampleSize, char* target)
+{
+    const size_t stamp = sizeof(unsigned long long);
+    if (count < 2 || sampleSize <= stamp || (sampleSize - stamp) % 4 ||
+        (sampleSize - stamp) / 4 > SESSION_COMPACT_MAX_VALUES)
+        return 0;
+
+    SessionCompactHeader header;
+    memset(&header, 0, sizeof(header));
+    header.values = (sampleSize - stamp) / 4;
+    header.narrowMask = (unsigned short)((1u << header.values) - 1);
+    header.deltaBytes = 2;
+
+    unsigned long long previous = 0;
+    for (unsigned int n = 0; n < count; ++n) {
+        const char* sample = samples + (size_t)n * sampleSize;
+        unsigned long long timestamp;
+        memcpy(&timestamp, sample, stamp);
+        if (n == 0) {
+            header.timestamp = timestamp;
+        } else {
+            // Timestamps going backwards do not fit an unsigned delta.
+            if (timestamp < previous || timestamp - previous > 0xffffffffULL)
+                return 0;
+            if (timestamp - previous > 0xffff)
+                header.deltaBytes = 4;
+        }
+        previous = timestamp;
+        for (unsigned int i = 0; i < header.values; ++i) {
+            int value;
+            memcpy(&value, sample + stamp + i * 4, 4);
+            if (value < -32768 || value > 32767)
+                header.narrowMask &= ~(1u << i);
+        }
+    }
+
+    size_t size = sessionCompactSize(header, count);
+    if (size >= (size_t)count * sampleSize)
+        return 0;
+
+    char* out = target;
+    memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+    previous = header.timestamp;
+    for (unsigned int n = 1; n < count; ++n) {
+        unsigned long long timestamp;
+        memcpy(&timestamp, samples + (size_t)n * sampleSize, stamp);
+        unsigned int delta = (unsigned int)(timestamp - previous);
+        previous = timestamp;
+        if (header.deltaBytes == 2) {
+            unsigned short shortDelta = (unsigned short)delta;
+            memcpy(out, &shortDelta, 2);
+        } else {
+            memcpy(out, &delta, 4);
+        }
+        out += header.deltaBytes;
+    }
+    for (unsigned int n = 0; n < count; ++n) {
+        const char* sample = samples + (size_t)n * sampleSize + stamp;
+        for (unsigned int i = 0; i < header.values; ++i) {
+            if (header.narrowMask & (1u << i)) {
+                int value;
+                memcpy(&value, sample + i * 4, 4);
+                short narrow = (short)value;
+                memcpy(out, &narrow, 2);
+                out += 2;
+            } else {
+                memcpy(out, sample + i * 4, 4);
+                out += 4;
+            }
+        }
+    }
+    return size;
+}
+
+/**
+ * Decode compact encoded samples.
+ *
+ * @param data encoded samples, starting with SessionCompactHeader.
+ * @param count number of samples.
+ * @param target location for the samples, <tt>count * sampleSize</tt>
+ *               bytes.
+ */
+inline void sessionCompactDecode(const char* data, unsigned int count, char* target)
+{
+    const size_t stamp = sizeof(unsigned long long);
+    SessionCompactHeader header;
+    memcpy(&header, data, sizeof(header));
+    const char* deltas = data + sizeof(header);
+    const char* in = deltas + (size_t)(count ? count - 1 : 0) * header.deltaBytes;
+    size_t sampleSize = stamp + header.values * 4;
+
+    unsigned long long timestamp = header.timestamp;
+    for (unsigned int n = 0; n < count; ++n) {
+        char* sample = target + (size_t)n * sampleSize;
+        if (n) {
+            if (header.deltaBytes == 2) {
+                unsigned short delta;
+                memcpy(&delta, deltas, 2);
+                timestamp += delta;
+            } else {
+                unsigned int delta;
+                memcpy(&delta, deltas, 4);
+                timestamp += delta;
+            }
+            deltas += header.deltaBytes;
+        }
+        memcpy(sample, &timestamp, stamp);
+        for (unsigned int i = 0; i < header.values; ++i) {
+            if (header.narrowMask & (1u << i)) {
+                short narrow;
+                memcpy(&narrow, in, 2);
+                int value = narrow;
+                memcpy(sample + stamp + i * 4, &value, 4);
+                in += 2;
+            } else {
+                memcpy(sample + stamp + i * 4, in, 4);
+                in += 4;
+            }
+        }
+    }
+}
+
+/**
+ * View over a single frame in a caller supplied buffer. Nothing is
+ * copied; the view is valid as long as the buffer is.
+ */
+class SessionFrameView
+{
+public:
+    /**
+     * Result of parsing a frame.
+     */
+    enum Status
+    {
+        Complete = 0, /**< frame parsed */
+        Incomplete,   /**< more bytes needed */
+        Invalid       /**< buffer does not start with a valid frame */
+    };
+
+    SessionFrameView() :
+        data_(NULL), sampleSize_(0), count_(0), sequence_(0), traced_(false),
+        compact_(false), compactSize_(0) {}
+
+    /**
+     * Parse the frame at the beginning of the buffer.
+     *
+     * @param buffer received bytes.
+     * @param size number of received bytes.
+     * @param sampleSize size of a single sample.
+     * @return parse result. View is only valid if Complete.
+     */
+    Status parse(const char* buffer, size_t size, unsigned int sampleSize)
+    {
+        SessionFrameHeader header;
+        if (size < sizeof(header))
+            return Incomplete;
+        memcpy(&header, buffer, sizeof(header));
+
+        traced_ = header.count & SESSION_FRAME_TRACED;
+        compact_ = header.count & SESSION_FRAME_COMPACT;
+        count_ = header.count & ~(SESSION_FRAME_TRACED | SESSION_FRAME_COMPACT);
+        sequence_ = header.sequence;
+        sampleSize_ = sampleSize;
+        compactSize_ = 0;
+        if (count_ > SESSION_FRAME_MAX_SAMPLES || !sampleSize)
+            return Invalid;
+        if (compact_) {
+            SessionCompactHeader compact;
+            if (size < sizeof(header) + sizeof(compact))
+                return Incomplete;
+            memcpy(&compact, buffer + sizeof(header), sizeof(compact));
+            if ((compact.deltaBytes != 2 && compact.deltaBytes != 4) ||
+                sizeof(unsigned long long) + compact.values * 4 != sampleSize)
+                return Invalid;
+            compactSize_ = sessionCompactSize(compact, count_);
+        }
+        if (size < totalSize())
+            return Incomplete;
+        data_ = buffer + sizeof(header);
+        return Complete;
+    }
+
+    /**
+     * Total size of the frame in the buffer.
+     *
+     * @return size in bytes, including header and trace.
+     */
+    size_t totalSize() const
+    {
+        return sizeof(SessionFrameHeader) + payloadSize() + (traced_ ? sizeof(SessionFrameTrace) : 0);
+    }
+
+    /**
+     * Size of the samples of the frame as received.
+     *
+     * @return size in bytes.
+     */
+    size_t payloadSize() const { return compact_ ? compactSize_ : (size_t)count_ * sampleSize_; }
+
+    /**
+     * Size of the samples of the frame once decoded.
+     *
+     * @return size in bytes.
+     */
+    size_t sampleBytes() const { return (size_t)count_ * sampleSize_; }
+
+    /**
+     * Samples of the frame, back to back. May be unaligned. Compact
+     * frames have to be decoded with #decode() instead.
+     *
+     * @return pointer to the first sample.
+     */
+    const char* samples() const { return data_; }
+
+    /**
+     * Copy the samples of the frame, decoding compact frames.
+     *
+     * @param target location for #sampleBytes() bytes.
+     */
+    void decode(char* target) const
+    {
+        if (compact_)
+            sessionCompactDecode(data_, count_, target);
+        else
+            memcpy(target, data_, sampleBytes());
+    }
+
+    /**
+     * Get a sample of the frame. May be unaligned. Not available for
+     * compact frames.
+     *
+     * @param index sample index.
+     * @return pointer to the sample.
+     */
+    const char* sample(unsigned int index) const { return data_ + (size_t)index * sampleSize_; }
+
+    unsigned int count() const { return count_; }
+    unsigned int sequence() const { return sequence_; }
+    bool traced() const { return traced_; }
+    bool compact() const { return compact_; }
+
+    /**
+     * Copy the trace of a traced frame.
+     *
+     * @param trace trace to fill.
+     * @return is the frame traced.
+     */
+    bool trace(SessionFrameTrace& trace) const
+    {
+        if (!traced_)
+            return false;
+        memcpy(&trace, data_ + payloadSize(), sizeof(trace));
+        return true;
+    }
+
+private:
+    const char*  data_;
+    unsigned int sampleSize_;
+    unsigned int count_;
+    unsigned int sequence_;
+    bool         traced_;
+    bool         compact_;
+    size_t       compactSize_;
+};
+
+/**
+ * Follows the sequence numbers of received frames.
+ */
+class SessionSequence
+{
+public:
+    SessionSequence() : valid_(false), next_(0) {}
+
+    /**
+     * Account a received frame.
+     *
+     * @param sequence sequence number of the frame.
+     * @param count number of samples in the frame.
+     * @return number of samples lost before the frame.
+     */
+    unsigned int accept(unsigned int sequence, unsigned int count)
+    {
+        unsigned int lost = valid_ ? sequence - next_ : 0;
+        valid_ = true;
+        next_ = sequence + count;
+        return lost;
+    }
+
+    /**
+     * Forget the expected sequence, for a new connection.
+     */
+    void reset() { valid_ = false; }
+
+private:
+    bool         valid_;
+    unsigned int next_;
+};
+
+/**
+ * Reader of the shared memory ring mapped by a client.
+ */
+class SharedRingReader
+{
+public:
+    SharedRingReader() : ring_(NULL), readCount_(0) {}
+
+    /**
+     * Validate and use a mapped ring. Reading starts from the samples
+     * published after this call.
+     *
+     * @param ring mapped ring.
+     * @param mappedSize size of the mapping.
+     * @return is the ring valid.
+     */
+    bool attach(const SharedRingHeader* ring, size_t mappedSize)
+    {
+        ring_ = NULL;
+        if (mappedSize < sizeof(SharedRingHeader) ||
+            ring->magic != SHARED_RING_MAGIC ||
+            ring->version != SHARED_RING_VERSION ||
+            ring->capacity == 0 ||
+            (ring->capacity & (ring->capacity - 1)) ||
+            sharedRingSize(ring->capacity, ring->slotSize) > mappedSize)
+            return false;
+        ring_ = ring;
+        readCount_ = sharedRingWriteCount(ring);
+        return true;
+    }
+
+    /**
+     * Stop using the ring. Unmapping is left to the caller.
+     */
+    void detach() { ring_ = NULL; }
+
+    const SharedRingHeader* ring() const { return ring_; }
+
+    /**
+     * Number of samples waiting in the ring.
+     *
+     * @return sample count. Never more than the ring capacity.
+     */
+    unsigned int available() const
+    {
+        unsigned int count = sharedRingWriteCount(ring_) - readCount_;
+        return count > ring_->capacity ? ring_->capacity : count;
+    }
+
+    /**
+     * Number of samples dropped by sensord.
+     *
+     * @return drop count.
+     */
+    unsigned int dropCount() const
+    {
+        return __atomic_load_n(&ring_->dropCount, __ATOMIC_RELAXED);
+    }
+
+    /**
+     * Copy samples from the ring. Samples overwritten by sensord before
+     * or while copying are skipped and counted as lost. On a sample size
+     * mismatch everything waiting is skipped and nothing copied.
+     *
+     * @param buffer location for the samples.
+     * @param elementSize expected size of a sample.
+     * @param maxCount maximum number of samples to copy.
+     * @param lost incremented by the number of skipped samples.
+     * @return number of samples copied.
+     */
+    unsigned int read(void* buffer, unsigned int elementSize, unsigned int maxCount, unsigned int& lost)
+    {
+        unsigned int writeCount = sharedRingWriteCount(ring_);
+        if (elementSize != ring_->elementSize || elementSize > ring_->slotSize)
+        {
+            lost += writeCount - readCount_;
+            readCount_ = writeCount;
+            return 0;
+        }
+        if (writeCount - readCount_ > ring_->capacity)
+        {
+            lost += writeCount - readCount_ - ring_->capacity;
+            readCount_ = writeCount - ring_->capacity;
+        }
+        unsigned int count = writeCount - readCount_;
+        if (count > maxCount)
+            count = maxCount;
+
+        char* dest = (char*)buffer;
+        for (unsigned int i = 0; i < count; ++i)
+            memcpy(dest + (size_t)elementSize * i, sharedRingSlot(ring_, readCount_ + i), elementSize);
+
+        // Slots may have been reused while copying; drop the ones that were.
+        // The slot after the last published one may be in the middle of a write.
+        unsigned int overwritten = 0;
+        writeCount = sharedRingWriteCount(ring_) + 1;
+        if (writeCount - readCount_ > ring_->capacity)
+            overwritten = writeCount - readCount_ - ring_->capacity;
+        if (overwritten > count)
+            overwritten = count;
+        lost += overwritten;
+        if (overwritten)
+            memmove(dest, dest + (size_t)elementSize * overwritten, (size_t)elementSize * (count - overwritten));
+
+        readCount_ += count;
+        return count - overwritten;
+    }
+
+private:
+    const SharedRingHeader* ring_;
+    unsigned int readCount_;
+};
+
+#endif // SESSION_PROTOCOL_H
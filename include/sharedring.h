@@ -0,0 +1,143 @@
+/**
+   @file sharedring.h
+   @brief Shared memory sample ring layout
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef SHARED_RING_H
+#define SHARED_RING_H
+
+#include <stddef.h>
+
+/**
+ * Written by the client right after the session ID to request the
+ * shared memory transport for the session.
+ */
+const int SHARED_RING_REQUEST = 0x53484d31; // "SHM1"
+
+/**
+ * Reply byte sent by sensord when the ring file descriptor is attached.
+ */
+const char SHARED_RING_ACCEPTED = 'S';
+
+/**
+ * Reply byte sent by sensord when the session stays on the socket.
+ */
+const char SHARED_RING_REJECTED = 'N';
+
+/**
+ * Magic number stored at the beginning of the ring.
+ */
+const unsigned int SHARED_RING_MAGIC = 0x73666d72;
+
+/**
+ * Version of the ring layout.
+ */
+const unsigned int SHARED_RING_VERSION = 1;
+
+/**
+ * Size of a single slot in bytes. Largest supported sample size.
+ */
+const unsigned int SHARED_RING_SLOT_SIZE = 64;
+
+/**
+ * Default number of slots in the ring. Must be a power of two.
+ */
+const unsigned int SHARED_RING_CAPACITY = 256;
+
+/**
+ * Header at the beginning of the shared memory ring. Samples follow
+ * the header in fixed size slots, like in RingBuffer the slot for the
+ * n:th sample is n modulo capacity. sensord is the only writer; it
+ * stores samples into their slots and then publishes them by
+ * advancing writeCount with release semantics. Readers load writeCount
+ * with acquire semantics and keep their own read position.
+ */
+struct SharedRingHeader
+{
+    unsigned int magic;          /**< SHARED_RING_MAGIC */
+    unsigned int version;        /**< SHARED_RING_VERSION */
+    unsigned int capacity;       /**< number of slots, power of two */
+    unsigned int slotSize;       /**< size of a slot in bytes */
+    unsigned int elementSize;    /**< size of the samples currently written */
+    unsigned int writeCount;     /**< total number of samples published */
+    unsigned int dropCount;      /**< samples dropped by sensord */
+    char padding[36];            /**< keep slots cache line aligned */
+};
+
+/**
+ * Total size of the shared memory ring.
+ *
+ * @param capacity number of slots.
+ * @param slotSize size of a slot.
+ * @return size in bytes.
+ */
+inline size_t sharedRingSize(unsigned int capacity, unsigned int slotSize)
+{
+    return sizeof(SharedRingHeader) + (size_t)capacity * slotSize;
+}
+
+/**
+ * Get pointer to the slot of given sample.
+ *
+ * @param header ring header.
+ * @param index sample index.
+ * @return pointer to the slot.
+ */
+inline char* sharedRingSlot(SharedRingHeader* header, unsigned int index)
+{
+    return (char*)(header + 1) + (size_t)(index & (header->capacity - 1)) * header->slotSize;
+}
+
+/**
+ * Get pointer to the slot of given sample.
+ *
+ * @param header ring header.
+ * @param index sample index.
+ * @return pointer to the slot.
+ */
+inline const char* sharedRingSlot(const SharedRingHeader* header, unsigned int index)
+{
+    return (const char*)(header + 1) + (size_t)(index & (header->capacity - 1)) * header->slotSize;
+}
+
+/**
+ * Publish samples written up to given count.
+ *
+ * @param header ring header.
+ * @param count new write count.
+ */
+inline void sharedRingPublish(SharedRingHeader* header, unsigned int count)
+{
+    __atomic_store_n(&header->writeCount, count, __ATOMIC_RELEASE);
+}
+
+/**
+ * Get count of published samples.
+ *
+ * @param header ring header.
+ * @return write count.
+ */
+inline unsigned int sharedRingWriteCount(const SharedRingHeader* header)
+{
+    return __atomic_load_n(&header->writeCount, __ATOMIC_ACQUIRE);
+}
+
+#endif // SHARED_RING_H
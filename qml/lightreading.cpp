@@ -0,0 +1,69 @@
+/**
+   @file lightreading.cpp
+   @brief QML reading of the ambient light sensor
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "lightreading.h"
+#include "alssensor_i.h"
+
+AmbientLightReading::AmbientLightReading(QObject* parent) :
+    SensorReading("alssensor", parent),
+    lux_(0),
+    sum_(0),
+    count_(0)
+{
+}
+
+qreal AmbientLightReading::lux() const
+{
+    return lux_;
+}
+
+AbstractSensorChannelInterface* AmbientLightReading::createInterface(const QString& sensorId)
+{
+    ALSSensorChannelInterface* iface = openInterface<ALSSensorChannelInterface>(sensorId);
+    if (iface)
+        connect(iface, &ALSSensorChannelInterface::samplesAvailable,
+                this, &AmbientLightReading::receive);
+    return iface;
+}
+
+quint64 AmbientLightReading::publish()
+{
+    if (averaging() && count_ > 1)
+        lux_ = (qreal)sum_ / count_;
+    else
+        lux_ = latest_.value_;
+    sum_ = 0;
+    count_ = 0;
+    return latest_.timestamp_;
+}
+
+void AmbientLightReading::receive(const QVector<TimedUnsigned>& samples)
+{
+    if (samples.isEmpty())
+        return;
+    foreach (const TimedUnsigned& sample, samples)
+        sum_ += sample.value_;
+    count_ += samples.size();
+    latest_ = samples.last();
+    scheduleUpdate();
+}
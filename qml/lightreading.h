@@ -0,0 +1,61 @@
+/**
+   @file lightreading.h
+   @brief QML reading of the ambient light sensor
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef LIGHTREADING_H
+#define LIGHTREADING_H
+
+#include "sensorreading.h"
+#include "datatypes/timedunsigned.h"
+
+/**
+ * @brief Ambient light reading in lux.
+ */
+class AmbientLightReading : public SensorReading
+{
+    Q_OBJECT
+    Q_PROPERTY(qreal lux READ lux NOTIFY readingChanged)
+
+public:
+    AmbientLightReading(QObject* parent = 0);
+
+    qreal lux() const;
+
+protected:
+    virtual AbstractSensorChannelInterface* createInterface(const QString& sensorId);
+    virtual quint64 publish();
+
+private:
+    /**
+     * Take in a batch of samples.
+     *
+     * @param samples received samples.
+     */
+    void receive(const QVector<TimedUnsigned>& samples);
+
+    qreal lux_; /**< published level */
+    quint64 sum_; /**< sum of the samples of the frame */
+    int count_; /**< number of samples of the frame */
+    TimedUnsigned latest_; /**< latest sample of the frame */
+};
+
+#endif // LIGHTREADING_H
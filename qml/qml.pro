@@ -0,0 +1,36 @@
+TEMPLATE = lib
+CONFIG += plugin
+
+include( ../common-config.pri )
+
+# QML module over the Qt API, see SensorReading.
+QT += gui qml
+TARGET = sensorfwplugin
+
+SOURCES += sensorfwplugin.cpp \
+    sensorreading.cpp \
+    xyzreading.cpp \
+    lightreading.cpp
+
+HEADERS += sensorfwplugin.h \
+    sensorreading.h \
+    xyzreading.h \
+    lightreading.h
+
+SENSORFW_INCLUDEPATHS = .. \
+    ../include \
+    ../datatypes \
+    ../qt-api
+
+DEPENDPATH += $$SENSORFW_INCLUDEPATHS
+INCLUDEPATH += $$SENSORFW_INCLUDEPATHS
+
+QMAKE_LIBDIR_FLAGS += -L../datatypes -lsensordatatypes-qt5 \
+                      -L../qt-api -lsensorclient-qt5
+
+OTHER_FILES += qmldir
+
+target.path = $$[QT_INSTALL_QML]/Sensorfw
+qmldir.files = qmldir
+qmldir.path = $$target.path
+INSTALLS += target qmldir
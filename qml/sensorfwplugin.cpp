@@ -0,0 +1,36 @@
+/**
+   @file sensorfwplugin.cpp
+   @brief QML module of the sensor framework
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "sensorfwplugin.h"
+#include "xyzreading.h"
+#include "lightreading.h"
+#include <QtQml>
+
+void SensorfwPlugin::registerTypes(const char* uri)
+{
+    qmlRegisterUncreatableType<SensorReading>(uri, 1, 0, "SensorReading", "Abstract base of the readings");
+    qmlRegisterType<AccelerometerReading>(uri, 1, 0, "Accelerometer");
+    qmlRegisterType<GyroscopeReading>(uri, 1, 0, "Gyroscope");
+    qmlRegisterType<MagnetometerReading>(uri, 1, 0, "Magnetometer");
+    qmlRegisterType<AmbientLightReading>(uri, 1, 0, "AmbientLight");
+}
@@ -0,0 +1,41 @@
+/**
+   @file sensorfwplugin.h
+   @brief QML module of the sensor framework
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef SENSORFWPLUGIN_H
+#define SENSORFWPLUGIN_H
+
+#include <QQmlExtensionPlugin>
+
+/**
+ * @brief Registers the sensor readings of the Sensorfw QML module.
+ */
+class SensorfwPlugin : public QQmlExtensionPlugin
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID "org.qt-project.Qt.QQmlExtensionInterface")
+
+public:
+    virtual void registerTypes(const char* uri);
+};
+
+#endif // SENSORFWPLUGIN_H
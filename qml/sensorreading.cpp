@@ -0,0 +1,207 @@
+/**
+   @file sensorreading.cpp
+   @brief Base of the QML sensor readings
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "sensorreading.h"
+#include "abstractsensor_i.h"
+#include <QGuiApplication>
+#include <QScreen>
+#include <QDebug>
+
+/** Frame interval used when the screen refresh rate is not known */
+static const int DEFAULT_FRAME_INTERVAL = 16;
+
+SensorReading::SensorReading(const QString& sensorId, QObject* parent) :
+    QObject(parent),
+    sensorId_(sensorId),
+    active_(false),
+    interval_(0),
+    averaging_(false),
+    complete_(false),
+    timestamp_(0),
+    interface_(NULL)
+{
+}
+
+SensorReading::~SensorReading()
+{
+    FrameTicker::instance()->cancel(this);
+    delete interface_;
+}
+
+QString SensorReading::sensorId() const
+{
+    return sensorId_;
+}
+
+void SensorReading::setSensorId(const QString& sensorId)
+{
+    if (sensorId_ == sensorId)
+        return;
+    sensorId_ = sensorId;
+    if (interface_) {
+        // Session is for the old sensor.
+        delete interface_;
+        interface_ = NULL;
+    }
+    updateSession();
+    emit sensorIdChanged();
+}
+
+bool SensorReading::active() const
+{
+    return active_;
+}
+
+void SensorReading::setActive(bool active)
+{
+    if (active_ == active)
+        return;
+    active_ = active;
+    updateSession();
+    emit activeChanged();
+}
+
+int SensorReading::interval() const
+{
+    return interval_;
+}
+
+void SensorReading::setInterval(int interval)
+{
+    if (interval_ == interval)
+        return;
+    interval_ = interval;
+    if (interface_)
+        interface_->setInterval(interval_);
+    emit intervalChanged();
+}
+
+bool SensorReading::averaging() const
+{
+    return averaging_;
+}
+
+void SensorReading::setAveraging(bool averaging)
+{
+    if (averaging_ == averaging)
+        return;
+    averaging_ = averaging;
+    emit averagingChanged();
+}
+
+quint64 SensorReading::timestamp() const
+{
+    return timestamp_;
+}
+
+void SensorReading::classBegin()
+{
+}
+
+void SensorReading::componentComplete()
+{
+    // Properties set in QML are all in, open the session only once.
+    complete_ = true;
+    updateSession();
+}
+
+void SensorReading::scheduleUpdate()
+{
+    FrameTicker::instance()->schedule(this);
+}
+
+void SensorReading::updateSession()
+{
+    if (!complete_)
+        return;
+
+    if (active_ && !interface_) {
+        interface_ = createInterface(sensorId_);
+        if (!interface_) {
+            qWarning() << "[SENSORREADING]: Sensor" << sensorId_ << "not available";
+            return;
+        }
+        if (interval_ > 0)
+            interface_->setInterval(interval_);
+        interface_->start();
+    } else if (!active_ && interface_) {
+        interface_->stop();
+        delete interface_;
+        interface_ = NULL;
+        FrameTicker::instance()->cancel(this);
+    }
+}
+
+void SensorReading::frame()
+{
+    timestamp_ = publish();
+    emit readingChanged();
+}
+
+FrameTicker* FrameTicker::instance()
+{
+    static FrameTicker* ticker = new FrameTicker;
+    return ticker;
+}
+
+FrameTicker::FrameTicker()
+{
+    int interval = DEFAULT_FRAME_INTERVAL;
+    QGuiApplication* app = qobject_cast<QGuiApplication*>(QCoreApplication::instance());
+    if (app && app->primaryScreen() && app->primaryScreen()->refreshRate() > 0)
+        interval = qMax(1, qRound(1000 / app->primaryScreen()->refreshRate()));
+    timer_.setInterval(interval);
+    timer_.setTimerType(Qt::PreciseTimer);
+    connect(&timer_, SIGNAL(timeout()), this, SLOT(tick()));
+}
+
+void FrameTicker::schedule(SensorReading* reading)
+{
+    pending_.insert(reading);
+    if (!timer_.isActive())
+        timer_.start();
+}
+
+void FrameTicker::cancel(SensorReading* reading)
+{
+    pending_.remove(reading);
+    publishing_.remove(reading);
+}
+
+void FrameTicker::tick()
+{
+    if (pending_.isEmpty()) {
+        // Nothing arrived during the last frame, sleep until something does.
+        timer_.stop();
+        return;
+    }
+    // Bindings reacting to an update may schedule readings again or
+    // delete them, which cancel() takes out of the set being published.
+    publishing_.swap(pending_);
+    while (!publishing_.isEmpty()) {
+        QSet<SensorReading*>::iterator it = publishing_.begin();
+        SensorReading* reading = *it;
+        publishing_.erase(it);
+        reading->frame();
+    }
+}
@@ -0,0 +1,222 @@
+/**
+   @file sensorreading.h
+   @brief Base of the QML sensor readings
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef SENSORREADING_H
+#define SENSORREADING_H
+
+#include <QObject>
+#include <QQmlParserStatus>
+#include <QTimer>
+#include <QSet>
+#include "sensormanagerinterface.h"
+
+/**
+ * @brief Sensor reading exposed to QML.
+ *
+ * Samples arrive with the batched signals of the Qt API as fast as the
+ * session interval makes them, but the reading properties only change
+ * once per display frame: a reading which got samples is published by
+ * the next frame tick, with the latest sample or the average of all
+ * samples since the previous tick. Bindings on the properties are thus
+ * evaluated at most at the display refresh rate whatever the sensor
+ * rate is.
+ */
+class SensorReading : public QObject, public QQmlParserStatus
+{
+    Q_OBJECT
+    Q_INTERFACES(QQmlParserStatus)
+    Q_PROPERTY(QString sensorId READ sensorId WRITE setSensorId NOTIFY sensorIdChanged)
+    Q_PROPERTY(bool active READ active WRITE setActive NOTIFY activeChanged)
+    Q_PROPERTY(int interval READ interval WRITE setInterval NOTIFY intervalChanged)
+    Q_PROPERTY(bool averaging READ averaging WRITE setAveraging NOTIFY averagingChanged)
+    Q_PROPERTY(quint64 timestamp READ timestamp NOTIFY readingChanged)
+
+public:
+    /**
+     * Constructor.
+     *
+     * @param sensorId default sensor ID.
+     * @param parent parent QObject.
+     */
+    SensorReading(const QString& sensorId, QObject* parent = 0);
+
+    /**
+     * Destructor.
+     */
+    virtual ~SensorReading();
+
+    QString sensorId() const;
+    void setSensorId(const QString& sensorId);
+
+    bool active() const;
+    void setActive(bool active);
+
+    /**
+     * Requested session interval in milliseconds, 0 for the sensor
+     * default.
+     */
+    int interval() const;
+    void setInterval(int interval);
+
+    /**
+     * Publish the average of the samples received during a frame
+     * instead of the latest one.
+     */
+    bool averaging() const;
+    void setAveraging(bool averaging);
+
+    /**
+     * Timestamp of the published reading in microseconds.
+     */
+    quint64 timestamp() const;
+
+    virtual void classBegin();
+    virtual void componentComplete();
+
+Q_SIGNALS:
+    void sensorIdChanged();
+    void activeChanged();
+    void intervalChanged();
+    void averagingChanged();
+
+    /**
+     * Emitted at most once per frame when the reading properties have
+     * changed.
+     */
+    void readingChanged();
+
+protected:
+    /**
+     * Open a session for the sensor.
+     *
+     * @param sensorId sensor ID.
+     * @return interface or \c NULL if not available.
+     */
+    virtual AbstractSensorChannelInterface* createInterface(const QString& sensorId) = 0;
+
+    /**
+     * Move the samples received since the last frame to the reading
+     * properties.
+     *
+     * @return timestamp of the published reading.
+     */
+    virtual quint64 publish() = 0;
+
+    /**
+     * Load the sensor plugin and open a session for it.
+     *
+     * @param sensorId sensor ID.
+     * @tparam T interface class of the sensor.
+     * @return interface or \c NULL if not available.
+     */
+    template<typename T>
+    static T* openInterface(const QString& sensorId);
+
+    /**
+     * Publish the reading on the next frame. Called by subclasses after
+     * taking in a batch of samples.
+     */
+    void scheduleUpdate();
+
+private:
+    friend class FrameTicker;
+
+    /**
+     * Open or close the session to match the properties.
+     */
+    void updateSession();
+
+    /**
+     * Publish pending samples, called by the frame ticker.
+     */
+    void frame();
+
+    QString sensorId_; /**< sensor ID */
+    bool active_; /**< should the sensor run */
+    int interval_; /**< requested interval in milliseconds */
+    bool averaging_; /**< publish averages instead of latest samples */
+    bool complete_; /**< has the component been completed */
+    quint64 timestamp_; /**< timestamp of the published reading */
+    AbstractSensorChannelInterface* interface_; /**< session, when active */
+};
+
+/**
+ * @brief Frame tick shared by all readings.
+ *
+ * Runs at the refresh rate of the primary screen while any reading has
+ * unpublished samples and stops when there are none.
+ */
+class FrameTicker : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Get the ticker of the process.
+     *
+     * @return ticker.
+     */
+    static FrameTicker* instance();
+
+    /**
+     * Publish a reading on the next tick.
+     *
+     * @param reading reading with pending samples.
+     */
+    void schedule(SensorReading* reading);
+
+    /**
+     * Forget a reading going away.
+     *
+     * @param reading reading.
+     */
+    void cancel(SensorReading* reading);
+
+private Q_SLOTS:
+    /**
+     * Publish all scheduled readings.
+     */
+    void tick();
+
+private:
+    FrameTicker();
+
+    QTimer timer_; /**< frame tick */
+    QSet<SensorReading*> pending_; /**< readings with unpublished samples */
+    QSet<SensorReading*> publishing_; /**< readings being published by tick() */
+};
+
+template<typename T>
+T* SensorReading::openInterface(const QString& sensorId)
+{
+    SensorManagerInterface& sm = SensorManagerInterface::instance();
+    if (!sm.isValid())
+        return NULL;
+    QDBusReply<bool> loaded = sm.loadPlugin(sensorId);
+    if (!loaded.isValid() || !loaded.value())
+        return NULL;
+    sm.registerSensorInterface<T>(sensorId);
+    return T::interface(sensorId);
+}
+
+#endif // SENSORREADING_H
@@ -0,0 +1,110 @@
+/**
+   @file xyzreading.cpp
+   @brief QML readings of three axis sensors
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "xyzreading.h"
+#include "accelerometersensor_i.h"
+#include "gyroscopesensor_i.h"
+#include "magnetometersensor_i.h"
+
+XyzReading::XyzReading(const QString& sensorId, QObject* parent) :
+    SensorReading(sensorId, parent),
+    x_(0),
+    y_(0),
+    z_(0),
+    count_(0)
+{
+    sum_[0] = sum_[1] = sum_[2] = 0;
+}
+
+qreal XyzReading::x() const
+{
+    return x_;
+}
+
+qreal XyzReading::y() const
+{
+    return y_;
+}
+
+qreal XyzReading::z() const
+{
+    return z_;
+}
+
+quint64 XyzReading::publish()
+{
+    if (averaging() && count_ > 1) {
+        x_ = (qreal)sum_[0] / count_;
+        y_ = (qreal)sum_[1] / count_;
+        z_ = (qreal)sum_[2] / count_;
+    } else {
+        x_ = latest_.x_;
+        y_ = latest_.y_;
+        z_ = latest_.z_;
+    }
+    sum_[0] = sum_[1] = sum_[2] = 0;
+    count_ = 0;
+    return latest_.timestamp_;
+}
+
+AccelerometerReading::AccelerometerReading(QObject* parent) :
+    XyzReading("accelerometersensor", parent)
+{
+}
+
+AbstractSensorChannelInterface* AccelerometerReading::createInterface(const QString& sensorId)
+{
+    AccelerometerSensorChannelInterface* iface = openInterface<AccelerometerSensorChannelInterface>(sensorId);
+    if (iface)
+        connect(iface, &AccelerometerSensorChannelInterface::samplesAvailable,
+                this, &AccelerometerReading::receive<AccelerationData>);
+    return iface;
+}
+
+GyroscopeReading::GyroscopeReading(QObject* parent) :
+    XyzReading("gyroscopesensor", parent)
+{
+}
+
+AbstractSensorChannelInterface* GyroscopeReading::createInterface(const QString& sensorId)
+{
+    GyroscopeSensorChannelInterface* iface = openInterface<GyroscopeSensorChannelInterface>(sensorId);
+    if (iface)
+        connect(iface, &GyroscopeSensorChannelInterface::samplesAvailable,
+                this, &GyroscopeReading::receive<TimedXyzData>);
+    return iface;
+}
+
+MagnetometerReading::MagnetometerReading(QObject* parent) :
+    XyzReading("magnetometersensor", parent)
+{
+}
+
+AbstractSensorChannelInterface* MagnetometerReading::createInterface(const QString& sensorId)
+{
+    MagnetometerSensorChannelInterface* iface = openInterface<MagnetometerSensorChannelInterface>(sensorId);
+    if (iface)
+        connect(iface, &MagnetometerSensorChannelInterface::samplesAvailable,
+                this, &MagnetometerReading::receive<CalibratedMagneticFieldData>);
+    return iface;
+}
@@ -0,0 +1,131 @@
+/**
+   @file xyzreading.h
+   @brief QML readings of three axis sensors
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef XYZREADING_H
+#define XYZREADING_H
+
+#include "sensorreading.h"
+#include "datatypes/orientationdata.h"
+
+/**
+ * @brief Reading of a three axis sensor, in the units of its sensor.
+ */
+class XyzReading : public SensorReading
+{
+    Q_OBJECT
+    Q_PROPERTY(qreal x READ x NOTIFY readingChanged)
+    Q_PROPERTY(qreal y READ y NOTIFY readingChanged)
+    Q_PROPERTY(qreal z READ z NOTIFY readingChanged)
+
+public:
+    /**
+     * Constructor.
+     *
+     * @param sensorId default sensor ID.
+     * @param parent parent QObject.
+     */
+    XyzReading(const QString& sensorId, QObject* parent = 0);
+
+    qreal x() const;
+    qreal y() const;
+    qreal z() const;
+
+protected:
+    /**
+     * Take in a batch of samples.
+     *
+     * @param samples received samples.
+     */
+    template<typename T>
+    void receive(const QVector<T>& samples);
+
+    virtual quint64 publish();
+
+private:
+    qreal x_; /**< published X value */
+    qreal y_; /**< published Y value */
+    qreal z_; /**< published Z value */
+    qint64 sum_[3]; /**< sum of the samples of the frame */
+    int count_; /**< number of samples of the frame */
+    TimedXyzData latest_; /**< latest sample of the frame */
+};
+
+/**
+ * @brief Accelerometer reading in mG.
+ */
+class AccelerometerReading : public XyzReading
+{
+    Q_OBJECT
+
+public:
+    AccelerometerReading(QObject* parent = 0);
+
+protected:
+    virtual AbstractSensorChannelInterface* createInterface(const QString& sensorId);
+};
+
+/**
+ * @brief Gyroscope reading in mdps.
+ */
+class GyroscopeReading : public XyzReading
+{
+    Q_OBJECT
+
+public:
+    GyroscopeReading(QObject* parent = 0);
+
+protected:
+    virtual AbstractSensorChannelInterface* createInterface(const QString& sensorId);
+};
+
+/**
+ * @brief Calibrated magnetometer reading in nT.
+ */
+class MagnetometerReading : public XyzReading
+{
+    Q_OBJECT
+
+public:
+    MagnetometerReading(QObject* parent = 0);
+
+protected:
+    virtual AbstractSensorChannelInterface* createInterface(const QString& sensorId);
+};
+
+template<typename T>
+void XyzReading::receive(const QVector<T>& samples)
+{
+    if (samples.isEmpty())
+        return;
+    foreach (const T& sample, samples) {
+        sum_[0] += sample.x_;
+        sum_[1] += sample.y_;
+        sum_[2] += sample.z_;
+    }
+    count_ += samples.size();
+    const T& last = samples.last();
+    latest_ = TimedXyzData(last.timestamp_, last.x_, last.y_, last.z_);
+    scheduleUpdate();
+}
+
+#endif // XYZREADING_H
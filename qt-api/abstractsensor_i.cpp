@@ -28,6 +28,10 @@
 
 #include "sensormanagerinterface.h"
 #include "abstractsensor_i.h"
+#include "latestsample.h"
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 struct AbstractSensorChannelInterface::AbstractSensorChannelInterfaceImpl : public QDBusAbstractInterface
 {
@@ -48,10 +52,30 @@ struct AbstractSensorChannelInterface::AbstractSensorChannelInterfaceImpl : publ
     bool running_;
     bool standbyOverride_;
     bool downsampling_;
+    bool latencyTracing_;
+    bool packedFormat_;
+    bool compactFormat_;
+    bool changeOnly_;
+    unsigned int changeDeadband_;
+    bool hasPredicate_;
+    SessionPredicate predicate_;
+    unsigned int history_;
+    const LatestSamplePage* latestPage_;
+    int priority_;
+    unsigned int framePeriod_;
+    quint64 framePhase_;
+    unsigned int frameLead_;
+    QVariantMap metadata_;
+    bool metadataCached_;
+    bool metadataUnsupported_;
+    AbstractSensorChannelInterface* leader_;
+    QList<AbstractSensorChannelInterface*> followers_;
+    QString sharedKey_;
+    bool unshared_;
 };
 
 AbstractSensorChannelInterface::AbstractSensorChannelInterfaceImpl::AbstractSensorChannelInterfaceImpl(QObject* parent, int sessionId, const QString& path, const char* interfaceName) :
-    QDBusAbstractInterface(SERVICE_NAME, path, interfaceName, QDBusConnection::systemBus(), 0),
+    QDBusAbstractInterface(SensorManagerInterface::serviceName(), path, interfaceName, SensorManagerInterface::connection(), 0),
     errorCode_(SNoError),
     errorString_(""),
     sessionId_(sessionId),
@@ -61,24 +85,65 @@ AbstractSensorChannelInterface::AbstractSensorChannelInterfaceImpl::AbstractSens
     socketReader_(parent),
     running_(false),
     standbyOverride_(false),
-    downsampling_(true)
+    downsampling_(true),
+    latencyTracing_(false),
+    packedFormat_(false),
+    compactFormat_(false),
+    changeOnly_(false),
+    changeDeadband_(0),
+    hasPredicate_(false),
+    history_(0),
+    latestPage_(NULL),
+    priority_(1),
+    framePeriod_(0),
+    framePhase_(0),
+    frameLead_(0),
+    metadataCached_(false),
+    metadataUnsupported_(false),
+    leader_(0),
+    unshared_(false)
 {
 }
 
+/**
+ * Sessions of the process followed by other interfaces, by
+ * AbstractSensorChannelInterface::sharedSessionKey().
+ */
+static QMap<QString, AbstractSensorChannelInterface*>& sharedSessions()
+{
+    static QMap<QString, AbstractSensorChannelInterface*> sessions;
+    return sessions;
+}
+
 AbstractSensorChannelInterface::AbstractSensorChannelInterface(const QString& path, const char* interfaceName, int sessionId) :
     pimpl_(new AbstractSensorChannelInterfaceImpl(this, sessionId, path, interfaceName))
 {
-    if (!pimpl_->socketReader_.initiateConnection(sessionId)) {
+    // Shared memory transport is opt-in until all clients are known to cope with it.
+    bool sharedMemory = !qgetenv("SENSORFW_SHARED_MEMORY").isEmpty();
+    // Carrying all sessions of the process on one connection is opt-in as well.
+    bool multiplex = !qgetenv("SENSORFW_MULTIPLEX").isEmpty();
+    // So is the packet socket, which sensord only offers when configured to.
+    bool seqPacket = !qgetenv("SENSORFW_SEQPACKET").isEmpty();
+    // Reading the socket on a thread of its own costs a thread per process.
+    bool threaded = !qgetenv("SENSORFW_READER_THREAD").isEmpty();
+    if (!pimpl_->socketReader_.initiateConnection(sessionId, sharedMemory, multiplex, seqPacket, threaded)) {
         setError(SClientSocketError, "Socket connection failed.");
     }
+    pimpl_->connection().connect(pimpl_->service(), pimpl_->path(), pimpl_->interface(),
+                                 QLatin1String("metadataChanged"), this, SLOT(metadataChanged()));
+    pimpl_->connection().connect(pimpl_->service(), pimpl_->path(), pimpl_->interface(),
+                                 QLatin1String("propertiesChanged"), this, SLOT(propertiesChanged(QStringList)));
 }
 
 AbstractSensorChannelInterface::~AbstractSensorChannelInterface()
 {
+    leaveSharedSession(false);
     if ( pimpl_->isValid() )
         SensorManagerInterface::instance().releaseInterface(id(), pimpl_->sessionId_);
     if (!pimpl_->socketReader_.dropConnection())
         setError(SClientSocketError, "Socket disconnect failed.");
+    if (pimpl_->latestPage_)
+        munmap((void*)pimpl_->latestPage_, sizeof(LatestSamplePage));
     delete pimpl_;
 }
 
@@ -87,6 +152,33 @@ SocketReader& AbstractSensorChannelInterface::getSocketReader() const
     return pimpl_->socketReader_;
 }
 
+bool AbstractSensorChannelInterface::readLatestSample(void* data, unsigned int size)
+{
+    // sensord retires the page on exit, the next instance creates a new one.
+    if (pimpl_->latestPage_ && pimpl_->latestPage_->magic != LATEST_SAMPLE_MAGIC) {
+        munmap((void*)pimpl_->latestPage_, sizeof(LatestSamplePage));
+        pimpl_->latestPage_ = NULL;
+    }
+
+    if (!pimpl_->latestPage_) {
+        QByteArray name = LATEST_SAMPLE_PREFIX + pimpl_->path().section('/', -1).toLocal8Bit();
+        int fd = shm_open(name.constData(), O_RDONLY | O_CLOEXEC, 0);
+        if (fd < 0)
+            return false;
+        void* mem = mmap(NULL, sizeof(LatestSamplePage), PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mem == MAP_FAILED)
+            return false;
+        const LatestSamplePage* page = (const LatestSamplePage*)mem;
+        if (page->magic != LATEST_SAMPLE_MAGIC || page->version != LATEST_SAMPLE_VERSION) {
+            munmap(mem, sizeof(LatestSamplePage));
+            return false;
+        }
+        pimpl_->latestPage_ = page;
+    }
+    return latestSampleRead(pimpl_->latestPage_, data, size);
+}
+
 bool AbstractSensorChannelInterface::release()
 {
     return true;
@@ -110,42 +202,204 @@ QDBusReply<void> AbstractSensorChannelInterface::stop()
 
 QDBusReply<void> AbstractSensorChannelInterface::start(int sessionId)
 {
-    clearError();
+    Q_UNUSED(sessionId);
 
     if (pimpl_->running_) {
+        clearError();
         return QDBusReply<void>();
     }
+    return startAsync();
+}
+
+QDBusReply<void> AbstractSensorChannelInterface::stop(int sessionId)
+{
+    Q_UNUSED(sessionId);
+
+    if (!pimpl_->running_) {
+        clearError();
+        return QDBusReply<void>();
+    }
+    return stopAsync();
+}
+
+QDBusPendingCall AbstractSensorChannelInterface::startAsync()
+{
+    clearError();
+
+    if (pimpl_->running_) {
+        return QDBusPendingReply<void>();
+    }
+    if (joinSharedSession())
+        return QDBusPendingReply<void>();
     pimpl_->running_ = true;
 
-    connect(pimpl_->socketReader_.socket(), SIGNAL(readyRead()), this, SLOT(dataReceived()));
+    // Format has to be known before the first sample is written.
+    QDBusPendingReply<bool> packed;
+    if (pimpl_->packedFormat_)
+        packed = sessionCall("setPackedFormat", true);
+    // Compact frames are flagged, so the reply is not needed. Sensord
+    // versions without the compact format keep sending full frames.
+    if (pimpl_->compactFormat_ && !pimpl_->socketReader_.isSharedMemory())
+        sessionCall("setCompactFormat", true);
+
+    QDBusPendingCall started = sessionCall("start");
+
+    watchCall(sessionCall("setStandbyOverride", pimpl_->standbyOverride_));
+    watchCall(sessionCall("setInterval", pimpl_->interval_));
+    watchCall(sessionCall("setBufferInterval", pimpl_->bufferInterval_));
+    watchCall(sessionCall("setBufferSize", pimpl_->bufferSize_));
+    watchCall(sessionCall("setDownsampling", pimpl_->downsampling_));
+    if (pimpl_->changeOnly_) {
+        QList<QVariant> argumentList;
+        argumentList << qVariantFromValue(pimpl_->sessionId_) << qVariantFromValue(true) << qVariantFromValue(pimpl_->changeDeadband_);
+        watchCall(pimpl_->asyncCallWithArgumentList(QLatin1String("setChangeOnly"), argumentList));
+    }
+    if (pimpl_->hasPredicate_) {
+        const SessionPredicate& predicate = pimpl_->predicate_;
+        QList<QVariant> argumentList;
+        argumentList << qVariantFromValue(pimpl_->sessionId_) << qVariantFromValue(predicate.axis)
+                     << qVariantFromValue(predicate.comparison) << qVariantFromValue(predicate.threshold)
+                     << qVariantFromValue(predicate.hysteresis) << qVariantFromValue(predicate.duration);
+        watchCall(pimpl_->asyncCallWithArgumentList(QLatin1String("setPredicate"), argumentList));
+    }
+    if (pimpl_->priority_ != 1)
+        watchCall(sessionCall("setPriority", pimpl_->priority_));
+    if (pimpl_->framePeriod_) {
+        QList<QVariant> argumentList;
+        argumentList << qVariantFromValue(pimpl_->sessionId_) << qVariantFromValue(pimpl_->framePeriod_)
+                     << qVariantFromValue((qulonglong)pimpl_->framePhase_) << qVariantFromValue(pimpl_->frameLead_);
+        watchCall(pimpl_->asyncCallWithArgumentList(QLatin1String("setFrameClock"), argumentList));
+    }
+    if (pimpl_->latencyTracing_)
+        watchCall(sessionCall("setLatencyTracing", true));
+    // History follows the start, the daemon writes it before live samples.
+    if (pimpl_->history_)
+        watchCall(sessionCall("requestHistory", pimpl_->history_));
+
+    if (pimpl_->packedFormat_) {
+        packed.waitForFinished();
+        pimpl_->packedFormat_ = packed.isValid() && packed.value();
+    }
 
-    QList<QVariant> argumentList;
-    argumentList << qVariantFromValue(sessionId);
-    QDBusReply<void> returnValue = pimpl_->callWithArgumentList(QDBus::Block, QLatin1String("start"), argumentList);
+    connect(&pimpl_->socketReader_, SIGNAL(readyRead()), this, SLOT(dataReceived()));
 
-    setStandbyOverride(sessionId, pimpl_->standbyOverride_);
-    setInterval(sessionId, pimpl_->interval_);
-    setBufferInterval(sessionId, pimpl_->bufferInterval_);
-    setBufferSize(sessionId, pimpl_->bufferSize_);
-    setDownsampling(pimpl_->sessionId_, pimpl_->downsampling_);
+    QString key = sharedSessionKey();
+    if (!key.isEmpty() && !sharedSessions().contains(key)) {
+        sharedSessions().insert(key, this);
+        pimpl_->sharedKey_ = key;
+    }
 
-    return returnValue;
+    return started;
 }
 
-QDBusReply<void> AbstractSensorChannelInterface::stop(int sessionId)
+QDBusPendingCall AbstractSensorChannelInterface::stopAsync()
 {
     clearError();
 
     if (!pimpl_->running_) {
-        return QDBusReply<void>();
+        return QDBusPendingReply<void>();
+    }
+    if (pimpl_->leader_) {
+        leaveSharedSession(false);
+        return QDBusPendingReply<void>();
     }
+    leaveSharedSession(false);
     pimpl_->running_ = false ;
 
-    disconnect(pimpl_->socketReader_.socket(), SIGNAL(readyRead()), this, SLOT(dataReceived()));
+    disconnect(&pimpl_->socketReader_, SIGNAL(readyRead()), this, SLOT(dataReceived()));
 
+    return sessionCall("stop");
+}
+
+QDBusPendingCall AbstractSensorChannelInterface::sessionCall(const char* method, const QVariant& value)
+{
     QList<QVariant> argumentList;
-    argumentList << qVariantFromValue(sessionId);
-    return pimpl_->callWithArgumentList(QDBus::Block, QLatin1String("stop"), argumentList);
+    argumentList << qVariantFromValue(pimpl_->sessionId_);
+    if (value.isValid())
+        argumentList << value;
+    return pimpl_->asyncCallWithArgumentList(QLatin1String(method), argumentList);
+}
+
+QString AbstractSensorChannelInterface::sharedSessionKey() const
+{
+    static bool enabled = !qgetenv("SENSORFW_SHARE_SESSIONS").isEmpty();
+    if (!enabled || pimpl_->unshared_ || pimpl_->packedFormat_ || pimpl_->compactFormat_ || pimpl_->changeOnly_ ||
+        pimpl_->hasPredicate_ || pimpl_->priority_ != 1 || pimpl_->framePeriod_ ||
+        pimpl_->latencyTracing_ || pimpl_->history_ || pimpl_->socketReader_.isSharedMemory())
+        return QString();
+    return QString("%1 %2 %3 %4 %5 %6").arg(pimpl_->path()).arg(pimpl_->interval_)
+        .arg(pimpl_->bufferInterval_).arg(pimpl_->bufferSize_)
+        .arg(pimpl_->downsampling_).arg(pimpl_->standbyOverride_);
+}
+
+bool AbstractSensorChannelInterface::joinSharedSession()
+{
+    QString key = sharedSessionKey();
+    if (key.isEmpty())
+        return false;
+    AbstractSensorChannelInterface* leader = sharedSessions().value(key);
+    if (!leader || leader == this)
+        return false;
+
+    pimpl_->running_ = true;
+    pimpl_->leader_ = leader;
+    leader->pimpl_->followers_.append(this);
+    leader->pimpl_->socketReader_.addFollower(&pimpl_->socketReader_);
+    connect(&pimpl_->socketReader_, SIGNAL(readyRead()), this, SLOT(dataReceived()));
+    return true;
+}
+
+void AbstractSensorChannelInterface::leaveSharedSession(bool restart)
+{
+    AbstractSensorChannelInterface* leader = pimpl_->leader_;
+    if (leader) {
+        leader->pimpl_->followers_.removeAll(this);
+        leader->pimpl_->socketReader_.removeFollower(&pimpl_->socketReader_);
+        pimpl_->leader_ = 0;
+        disconnect(&pimpl_->socketReader_, SIGNAL(readyRead()), this, SLOT(dataReceived()));
+        pimpl_->running_ = false;
+        if (restart)
+            watchCall(startAsync());
+        return;
+    }
+
+    if (pimpl_->sharedKey_.isEmpty())
+        return;
+    sharedSessions().remove(pimpl_->sharedKey_);
+    pimpl_->sharedKey_.clear();
+    // The first follower to restart takes over as the leader of the rest.
+    QList<AbstractSensorChannelInterface*> followers = pimpl_->followers_;
+    foreach (AbstractSensorChannelInterface* follower, followers)
+        follower->leaveSharedSession(true);
+}
+
+void AbstractSensorChannelInterface::unshareSession()
+{
+    if (!pimpl_->leader_) {
+        leaveSharedSession(false);
+        return;
+    }
+    // Configuration of the own session is about to change, so start it
+    // without looking for another session to follow.
+    leaveSharedSession(false);
+    pimpl_->unshared_ = true;
+    watchCall(startAsync());
+    pimpl_->unshared_ = false;
+}
+
+void AbstractSensorChannelInterface::watchCall(const QDBusPendingCall& call)
+{
+    QDBusPendingCallWatcher* watcher = new QDBusPendingCallWatcher(call, this);
+    connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)), this, SLOT(callFinished(QDBusPendingCallWatcher*)));
+}
+
+void AbstractSensorChannelInterface::callFinished(QDBusPendingCallWatcher* watcher)
+{
+    if (watcher->isError()) {
+        qDebug() << "Call to sensord failed: " << watcher->error().message();
+        setError(SaCannotAccessSensor, watcher->error().message());
+    }
+    watcher->deleteLater();
 }
 
 QDBusReply<void> AbstractSensorChannelInterface::setInterval(int sessionId, int value)
@@ -186,7 +440,7 @@ QDBusReply<bool> AbstractSensorChannelInterface::setStandbyOverride(int sessionI
 
 DataRangeList AbstractSensorChannelInterface::getAvailableDataRanges()
 {
-    return getAccessor<DataRangeList>("getAvailableDataRanges");
+    return getMetadata<DataRangeList>("availableDataRanges", "getAvailableDataRanges");
 }
 
 DataRange AbstractSensorChannelInterface::getCurrentDataRange()
@@ -208,22 +462,27 @@ void AbstractSensorChannelInterface::removeDataRangeRequest()
 
 DataRangeList AbstractSensorChannelInterface::getAvailableIntervals()
 {
-    return getAccessor<DataRangeList>("getAvailableIntervals");
+    return getMetadata<DataRangeList>("availableIntervals", "getAvailableIntervals");
 }
 
 IntegerRangeList AbstractSensorChannelInterface::getAvailableBufferIntervals()
 {
-    return getAccessor<IntegerRangeList>("getAvailableBufferIntervals");
+    return getMetadata<IntegerRangeList>("availableBufferIntervals", "getAvailableBufferIntervals");
 }
 
 IntegerRangeList AbstractSensorChannelInterface::getAvailableBufferSizes()
 {
-    return getAccessor<IntegerRangeList>("getAvailableBufferSizes");
+    return getMetadata<IntegerRangeList>("availableBufferSizes", "getAvailableBufferSizes");
 }
 
 bool AbstractSensorChannelInterface::hwBuffering()
 {
-    return getAccessor<bool>("hwBuffering");
+    return getMetadata<bool>("hwBuffering", "hwBuffering");
+}
+
+unsigned int AbstractSensorChannelInterface::samplesDropped() const
+{
+    return pimpl_->socketReader_.samplesDropped();
 }
 
 int AbstractSensorChannelInterface::sessionId() const
@@ -248,7 +507,7 @@ QString AbstractSensorChannelInterface::errorString()
 
 QString AbstractSensorChannelInterface::description()
 {
-    return getAccessor<QString>("description");
+    return getMetadata<QString>("description", "description");
 }
 
 QString AbstractSensorChannelInterface::id()
@@ -265,9 +524,10 @@ int AbstractSensorChannelInterface::interval()
 
 void AbstractSensorChannelInterface::setInterval(int value)
 {
+    unshareSession();
     pimpl_->interval_ = value;
     if (pimpl_->running_)
-        setInterval(pimpl_->sessionId_, value);
+        watchCall(sessionCall("setInterval", value));
 }
 
 unsigned int AbstractSensorChannelInterface::bufferInterval()
@@ -279,9 +539,10 @@ unsigned int AbstractSensorChannelInterface::bufferInterval()
 
 void AbstractSensorChannelInterface::setBufferInterval(unsigned int value)
 {
+    unshareSession();
     pimpl_->bufferInterval_ = value;
     if (pimpl_->running_)
-        setBufferInterval(pimpl_->sessionId_, value);
+        watchCall(sessionCall("setBufferInterval", value));
 }
 
 unsigned int AbstractSensorChannelInterface::bufferSize()
@@ -293,9 +554,10 @@ unsigned int AbstractSensorChannelInterface::bufferSize()
 
 void AbstractSensorChannelInterface::setBufferSize(unsigned int value)
 {
+    unshareSession();
     pimpl_->bufferSize_ = value;
     if (pimpl_->running_)
-        setBufferSize(pimpl_->sessionId_, value);
+        watchCall(sessionCall("setBufferSize", value));
 }
 
 bool AbstractSensorChannelInterface::standbyOverride()
@@ -307,6 +569,7 @@ bool AbstractSensorChannelInterface::standbyOverride()
 
 bool AbstractSensorChannelInterface::setStandbyOverride(bool override)
 {
+    unshareSession();
     pimpl_->standbyOverride_ = override;
     if (pimpl_->running_)
         return setStandbyOverride(pimpl_->sessionId_, override);
@@ -315,7 +578,35 @@ bool AbstractSensorChannelInterface::setStandbyOverride(bool override)
 
 QString AbstractSensorChannelInterface::type()
 {
-    return getAccessor<QString>("type");
+    return getMetadata<QString>("type", "type");
+}
+
+const QVariantMap* AbstractSensorChannelInterface::cachedMetadata()
+{
+    if (pimpl_->metadataUnsupported_)
+        return NULL;
+    if (!pimpl_->metadataCached_) {
+        QDBusReply<QVariantMap> reply(call(QDBus::Block, QLatin1String("metadata")));
+        if (!reply.isValid()) {
+            // Older sensord, use the accessors from now on.
+            pimpl_->metadataUnsupported_ = reply.error().type() == QDBusError::UnknownMethod;
+            return NULL;
+        }
+        pimpl_->metadata_ = reply.value();
+        pimpl_->metadataCached_ = true;
+    }
+    return &pimpl_->metadata_;
+}
+
+void AbstractSensorChannelInterface::metadataChanged()
+{
+    pimpl_->metadataCached_ = false;
+}
+
+void AbstractSensorChannelInterface::propertiesChanged(const QStringList& names)
+{
+    foreach (const QString& name, names)
+        emit propertyChanged(name);
 }
 
 void AbstractSensorChannelInterface::clearError()
@@ -326,11 +617,13 @@ void AbstractSensorChannelInterface::clearError()
 
 void AbstractSensorChannelInterface::dataReceived()
 {
+    // Each round delivers everything received so far as one batch, more
+    // rounds are only needed if the batch size limit was hit.
     do
     {
         if(!dataReceivedImpl())
             return;
-    } while(pimpl_->socketReader_.socket()->bytesAvailable());
+    } while(pimpl_->socketReader_.hasPendingData());
 }
 
 bool AbstractSensorChannelInterface::read(void* buffer, int size)
@@ -388,6 +681,7 @@ bool AbstractSensorChannelInterface::downsampling()
 
 bool AbstractSensorChannelInterface::setDownsampling(bool value)
 {
+    unshareSession();
     pimpl_->downsampling_ = value;
     return setDownsampling(pimpl_->sessionId_, value).isValid();
 }
@@ -400,3 +694,209 @@ QDBusReply<void> AbstractSensorChannelInterface::setDownsampling(int sessionId,
     argumentList << qVariantFromValue(sessionId) << qVariantFromValue(value);
     return pimpl_->callWithArgumentList(QDBus::Block, QLatin1String("setDownsampling"), argumentList);
 }
+
+bool AbstractSensorChannelInterface::changeOnly() const
+{
+    return pimpl_->changeOnly_;
+}
+
+bool AbstractSensorChannelInterface::setChangeOnly(bool value, unsigned int deadband)
+{
+    unshareSession();
+    pimpl_->changeOnly_ = value;
+    pimpl_->changeDeadband_ = deadband;
+    if (!pimpl_->running_)
+        return true;
+    return setChangeOnly(pimpl_->sessionId_, value, deadband).isValid();
+}
+
+QDBusReply<void> AbstractSensorChannelInterface::setChangeOnly(int sessionId, bool value, unsigned int deadband)
+{
+    clearError();
+
+    QList<QVariant> argumentList;
+    argumentList << qVariantFromValue(sessionId) << qVariantFromValue(value) << qVariantFromValue(deadband);
+    return pimpl_->callWithArgumentList(QDBus::Block, QLatin1String("setChangeOnly"), argumentList);
+}
+
+bool AbstractSensorChannelInterface::hasPredicate() const
+{
+    return pimpl_->hasPredicate_;
+}
+
+bool AbstractSensorChannelInterface::setPredicate(const SessionPredicate& predicate)
+{
+    unshareSession();
+    pimpl_->hasPredicate_ = true;
+    pimpl_->predicate_ = predicate;
+    if (!pimpl_->running_)
+        return true;
+    QDBusReply<bool> reply = setPredicate(pimpl_->sessionId_, predicate);
+    return reply.isValid() && reply.value();
+}
+
+QDBusReply<bool> AbstractSensorChannelInterface::setPredicate(int sessionId, const SessionPredicate& predicate)
+{
+    clearError();
+
+    QList<QVariant> argumentList;
+    argumentList << qVariantFromValue(sessionId) << qVariantFromValue(predicate.axis)
+                 << qVariantFromValue(predicate.comparison) << qVariantFromValue(predicate.threshold)
+                 << qVariantFromValue(predicate.hysteresis) << qVariantFromValue(predicate.duration);
+    return pimpl_->callWithArgumentList(QDBus::Block, QLatin1String("setPredicate"), argumentList);
+}
+
+bool AbstractSensorChannelInterface::clearPredicate()
+{
+    unshareSession();
+    pimpl_->hasPredicate_ = false;
+    if (!pimpl_->running_)
+        return true;
+    watchCall(sessionCall("clearPredicate"));
+    return true;
+}
+
+int AbstractSensorChannelInterface::priority() const
+{
+    return pimpl_->priority_;
+}
+
+bool AbstractSensorChannelInterface::setPriority(int priority)
+{
+    unshareSession();
+    pimpl_->priority_ = priority;
+    if (!pimpl_->running_)
+        return true;
+    QDBusReply<bool> reply = setPriority(pimpl_->sessionId_, priority);
+    return reply.isValid() && reply.value();
+}
+
+QDBusReply<bool> AbstractSensorChannelInterface::setPriority(int sessionId, int priority)
+{
+    clearError();
+
+    QList<QVariant> argumentList;
+    argumentList << qVariantFromValue(sessionId) << qVariantFromValue(priority);
+    return pimpl_->callWithArgumentList(QDBus::Block, QLatin1String("setPriority"), argumentList);
+}
+
+void AbstractSensorChannelInterface::setFrameClock(unsigned int period, quint64 phase, unsigned int lead)
+{
+    unshareSession();
+    pimpl_->framePeriod_ = period;
+    pimpl_->framePhase_ = phase;
+    pimpl_->frameLead_ = lead;
+    if (pimpl_->running_)
+        setFrameClock(pimpl_->sessionId_, period, phase, lead);
+}
+
+QDBusReply<void> AbstractSensorChannelInterface::setFrameClock(int sessionId, unsigned int period, quint64 phase, unsigned int lead)
+{
+    clearError();
+
+    QList<QVariant> argumentList;
+    argumentList << qVariantFromValue(sessionId) << qVariantFromValue(period) << qVariantFromValue((qulonglong)phase) << qVariantFromValue(lead);
+    return pimpl_->callWithArgumentList(QDBus::Block, QLatin1String("setFrameClock"), argumentList);
+}
+
+unsigned int AbstractSensorChannelInterface::history() const
+{
+    return pimpl_->history_;
+}
+
+void AbstractSensorChannelInterface::setHistory(unsigned int duration)
+{
+    pimpl_->history_ = duration;
+}
+
+QDBusReply<int> AbstractSensorChannelInterface::requestHistory(int sessionId, unsigned int duration)
+{
+    clearError();
+
+    QList<QVariant> argumentList;
+    argumentList << qVariantFromValue(sessionId) << qVariantFromValue(duration);
+    return pimpl_->callWithArgumentList(QDBus::Block, QLatin1String("requestHistory"), argumentList);
+}
+
+QDBusReply<QDBusUnixFileDescriptor> AbstractSensorChannelInterface::openDirectChannel(int sessionId, unsigned int interval)
+{
+    clearError();
+
+    QList<QVariant> argumentList;
+    argumentList << qVariantFromValue(sessionId) << qVariantFromValue(interval);
+    return pimpl_->callWithArgumentList(QDBus::Block, QLatin1String("openDirectChannel"), argumentList);
+}
+
+QDBusReply<void> AbstractSensorChannelInterface::closeDirectChannel(int sessionId)
+{
+    clearError();
+
+    QList<QVariant> argumentList;
+    argumentList << qVariantFromValue(sessionId);
+    return pimpl_->callWithArgumentList(QDBus::Block, QLatin1String("closeDirectChannel"), argumentList);
+}
+
+bool AbstractSensorChannelInterface::packedFormat() const
+{
+    return pimpl_->packedFormat_;
+}
+
+bool AbstractSensorChannelInterface::setPackedFormat(bool value)
+{
+    if (pimpl_->running_)
+        return false;
+    pimpl_->packedFormat_ = value;
+    return true;
+}
+
+QDBusReply<bool> AbstractSensorChannelInterface::setPackedFormat(int sessionId, bool value)
+{
+    clearError();
+
+    QList<QVariant> argumentList;
+    argumentList << qVariantFromValue(sessionId) << qVariantFromValue(value);
+    return pimpl_->callWithArgumentList(QDBus::Block, QLatin1String("setPackedFormat"), argumentList);
+}
+
+bool AbstractSensorChannelInterface::compactFormat() const
+{
+    return pimpl_->compactFormat_;
+}
+
+bool AbstractSensorChannelInterface::setCompactFormat(bool value)
+{
+    if (pimpl_->running_)
+        return false;
+    pimpl_->compactFormat_ = value;
+    return true;
+}
+
+bool AbstractSensorChannelInterface::latencyTracing() const
+{
+    return pimpl_->latencyTracing_;
+}
+
+bool AbstractSensorChannelInterface::setLatencyTracing(bool value)
+{
+    unshareSession();
+    if (value && pimpl_->socketReader_.isSharedMemory())
+        return false;
+    pimpl_->latencyTracing_ = value;
+    if (value)
+        pimpl_->socketReader_.clearLatencyStatistics();
+    return setLatencyTracing(pimpl_->sessionId_, value).isValid();
+}
+
+QDBusReply<void> AbstractSensorChannelInterface::setLatencyTracing(int sessionId, bool value)
+{
+    clearError();
+
+    QList<QVariant> argumentList;
+    argumentList << qVariantFromValue(sessionId) << qVariantFromValue(value);
+    return pimpl_->callWithArgumentList(QDBus::Block, QLatin1String("setLatencyTracing"), argumentList);
+}
+
+const LatencyStatistics& AbstractSensorChannelInterface::latencyStatistics() const
+{
+    return pimpl_->socketReader_.latencyStatistics();
+}
@@ -37,6 +37,7 @@
 #include "sfwerror.h"
 #include "serviceinfo.h"
 #include "socketreader.h"
+#include "sessionpredicate.h"
 #include "datatypes/datarange.h"
 
 /**
@@ -58,6 +59,7 @@ class AbstractSensorChannelInterface : public QObject
     Q_PROPERTY(unsigned int bufferSize READ bufferSize WRITE setBufferSize)
     Q_PROPERTY(bool hwBuffering READ hwBuffering)
     Q_PROPERTY(bool downsampling READ downsampling WRITE setDownsampling)
+    Q_PROPERTY(unsigned int samplesDropped READ samplesDropped)
 
 public:
 
@@ -122,6 +124,8 @@ public:
      * Set sensor sampling interval (in millisecs).
      * Value "0" will clear previously set interval.
      * Supported intervals are listed by #getAvailableIntervals().
+     * The call does not wait for sensord; failures are reported
+     * through #errorCode().
      *
      * @param value sampling interval (in millisecs).
      */
@@ -158,6 +162,7 @@ public:
      * Set buffer interval. Buffer interval defines the timeout for
      * buffered data to be flushed unless the buffer is filled before it.
      * Supported intervals are listed by #getAvailableBufferIntervals().
+     * The call does not wait for sensord.
      *
      * @param value interval in millisecs.
      */
@@ -183,6 +188,99 @@ public:
      */
     bool setDownsampling(bool value);
 
+    /**
+     * Is change only delivery enabled.
+     *
+     * @return is change only delivery enabled.
+     */
+    bool changeOnly() const;
+
+    /**
+     * Deliver samples only when they change. With a deadband, changes
+     * up to the deadband are not delivered, for example small lux changes
+     * of an ambient light sensor. Sensors without a meaningful deadband
+     * ignore it and deliver every change.
+     *
+     * @param value enable or disable change only delivery.
+     * @param deadband largest change not delivered.
+     * @return was delivery mode succesfully changed.
+     */
+    bool setChangeOnly(bool value, unsigned int deadband = 0);
+
+    /**
+     * Is delivery conditional.
+     *
+     * @return is a predicate set.
+     */
+    bool hasPredicate() const;
+
+    /**
+     * Deliver samples only while a condition holds, for example tilt
+     * beyond 30 degrees or lux below 10, so that the process is not woken
+     * up for samples it would discard. See SessionPredicate.
+     *
+     * @param predicate condition.
+     * @return was predicate accepted. Sensors without axes to compare
+     *         reject it.
+     */
+    bool setPredicate(const SessionPredicate& predicate);
+
+    /**
+     * Deliver all samples again.
+     *
+     * @return was predicate cleared.
+     */
+    bool clearPredicate();
+
+    /**
+     * Get delivery priority class.
+     *
+     * @return 0 realtime, 1 interactive, 2 background.
+     */
+    int priority() const;
+
+    /**
+     * Set delivery priority class. When sensord is loaded it writes to
+     * realtime sessions first and drops samples of background sessions
+     * before those of others. Interactive is the default.
+     *
+     * @param priority 0 realtime, 1 interactive, 2 background.
+     * @return was priority succesfully changed.
+     */
+    bool setPriority(int priority);
+
+    /**
+     * Deliver in step with the display. Sensord then writes only the
+     * newest sample of each frame, shortly before the vsync, instead of
+     * samples at an arbitrary phase. The frame clock is typically taken
+     * from the presentation feedback of the compositor.
+     *
+     * @param period frame period in microseconds, 0 to stop.
+     * @param phase time of any vsync, CLOCK_MONOTONIC microseconds.
+     * @param lead how long before the vsync the sample is written,
+     *             microseconds.
+     */
+    void setFrameClock(unsigned int period, quint64 phase, unsigned int lead = 2000);
+
+    /**
+     * Get requested history duration.
+     *
+     * @return duration in milliseconds, 0 when history is not requested.
+     */
+    unsigned int history() const;
+
+    /**
+     * Request recent samples on start. Every time the sensor is started,
+     * for example when resuming after suspend, sensord first writes the
+     * samples of the last \c duration milliseconds it still has, in as few
+     * frames as possible. Sensord keeps history only for channels with
+     * <tt>history_duration</tt> configured, otherwise live delivery starts
+     * as usual. Takes effect on the next start.
+     *
+     * @param duration history duration in milliseconds, 0 to disable.
+     */
+    void setHistory(unsigned int duration);
+
     /**
      * Returns list of available buffer interval ranges.
      *
@@ -201,6 +299,7 @@ public:
     /**
      * Set buffer size. Buffer size is used to control how many
      * samples are collected before signaling application about them.
+     * The call does not wait for sensord.
      *
      * @param value buffer size.
      */
@@ -236,6 +335,24 @@ public:
      */
     virtual QDBusReply<void> stop();
 
+    /**
+     * Start sensor without waiting for sensord. Start and the stored
+     * session configuration are sent back to back and sensord handles
+     * them in order, so starting costs a single round trip no matter
+     * how many properties have been set. Only a requested packed
+     * format is waited for, as it must be known before reading.
+     *
+     * @return pending reply of the start call.
+     */
+    QDBusPendingCall startAsync();
+
+    /**
+     * Stop sensor without waiting for sensord.
+     *
+     * @return pending reply of the stop call.
+     */
+    QDBusPendingCall stopAsync();
+
     /**
      * Get the list of available intervals ranges for the sensor.
      *
@@ -286,6 +403,80 @@ public:
      */
     bool hwBuffering();
 
+    /**
+     * Number of samples which were lost before this client could read
+     * them. Both drops in sensord and in the client end are counted.
+     *
+     * @return dropped sample count.
+     */
+    unsigned int samplesDropped() const;
+
+    /**
+     * Is latency tracing enabled or not.
+     *
+     * @return latency tracing state.
+     */
+    bool latencyTracing() const;
+
+    /**
+     * Enable or disable latency tracing. When enabled sensord appends
+     * the time spent in each stage of the sample path to the frames of
+     * this session and the measurements are collected to
+     * #latencyStatistics(). Not available with the shared memory
+     * transport.
+     *
+     * @param value enable or disable tracing.
+     * @return was tracing state succesfully changed.
+     */
+    bool setLatencyTracing(bool value);
+
+    /**
+     * Is packed wire format in use. Sensors which support it deliver
+     * samples in a compact fixed point form, see the sensor specific
+     * interface for the sample type.
+     *
+     * @return is packed format in use.
+     */
+    bool packedFormat() const;
+
+    /**
+     * Select packed wire format. Format can only be changed while the
+     * sensor is stopped, it is applied when the sensor is started. If
+     * sensord does not support the packed format for the sensor, full
+     * format is used and #packedFormat() returns false after start.
+     *
+     * @param value use packed format.
+     * @return was format selected.
+     */
+    bool setPackedFormat(bool value);
+
+    /**
+     * Is compact frame encoding requested.
+     *
+     * @return is compact format requested.
+     */
+    bool compactFormat() const;
+
+    /**
+     * Request compact frame encoding. Buffered frames are then sent with
+     * delta encoded timestamps and values narrowed to 16 bits where the
+     * data range allows. Frames are decoded transparently, so the
+     * samples received do not change. Format can only be changed while
+     * the sensor is stopped, it is applied when the sensor is started.
+     * Not available with the shared memory transport.
+     *
+     * @param value use compact format.
+     * @return was format selected.
+     */
+    bool setCompactFormat(bool value);
+
+    /**
+     * Latencies measured while latency tracing has been enabled.
+     *
+     * @return latency statistics.
+     */
+    const LatencyStatistics& latencyStatistics() const;
+
     /**
      * Does the current instance have valid connection established
      * to sensor daemon.
@@ -313,6 +504,65 @@ private:
      */
     SocketReader& getSocketReader() const;
 
+    /**
+     * Call session method of the sensor without waiting for the reply.
+     *
+     * @param method method name.
+     * @param value method argument after the session ID, if any.
+     * @return pending reply.
+     */
+    QDBusPendingCall sessionCall(const char* method, const QVariant& value = QVariant());
+
+    /**
+     * Report failure of a pending call through #errorCode() when it
+     * finishes.
+     *
+     * @param call pending call.
+     */
+    void watchCall(const QDBusPendingCall& call);
+
+    /**
+     * Key of the session configuration for sharing the session with
+     * other interfaces of the process. Sharing is opt-in with
+     * SENSORFW_SHARE_SESSIONS set, and only sessions without per-session
+     * delivery options can be shared.
+     *
+     * @return key, empty if session cannot be shared.
+     */
+    QString sharedSessionKey() const;
+
+    /**
+     * Follow a running session of another interface with the same
+     * configuration instead of starting this one.
+     *
+     * @return was a session joined.
+     */
+    bool joinSharedSession();
+
+    /**
+     * Stop sharing the session. A follower detaches from its leader, a
+     * leader lets its followers start sessions of their own.
+     *
+     * @param restart start the own session of a follower.
+     */
+    void leaveSharedSession(bool restart);
+
+    /**
+     * Stop sharing before the configuration of a running session
+     * changes. A follower starts its own session right away, which the
+     * change then applies to.
+     */
+    void unshareSession();
+
+Q_SIGNALS:
+    /**
+     * Sensor property has changed. Changes are batched by sensord, so
+     * a property changing many times in a row is signalled once.
+     *
+     * @param name property name.
+     */
+    void propertyChanged(const QString& name);
+
 private Q_SLOTS: // METHODS
     /**
      * Set interval to session.
@@ -359,6 +609,93 @@ private Q_SLOTS: // METHODS
      */
     QDBusReply<void> setDownsampling(int sessionId, bool value);
 
+    /**
+     * Set wire format of session.
+     *
+     * @param sessionId session ID.
+     * @param value use packed format.
+     * @return DBus reply, true if format was accepted.
+     */
+    QDBusReply<bool> setPackedFormat(int sessionId, bool value);
+
+    /**
+     * Set change only delivery of session.
+     *
+     * @param sessionId session ID.
+     * @param value change only delivery.
+     * @param deadband largest change not delivered.
+     * @return DBus reply.
+     */
+    QDBusReply<void> setChangeOnly(int sessionId, bool value, unsigned int deadband);
+
+    /**
+     * Set condition of delivery of session.
+     *
+     * @param sessionId session ID.
+     * @param predicate condition.
+     * @return DBus reply.
+     */
+    QDBusReply<bool> setPredicate(int sessionId, const SessionPredicate& predicate);
+
+    /**
+     * Set delivery priority class of a session.
+     *
+     * @param sessionId session ID.
+     * @param priority 0 realtime, 1 interactive, 2 background.
+     * @return DBus reply.
+     */
+    QDBusReply<bool> setPriority(int sessionId, int priority);
+
+    /**
+     * Set display frame clock of a session.
+     *
+     * @param sessionId session ID.
+     * @param period frame period in microseconds, 0 to stop.
+     * @param phase time of any vsync, CLOCK_MONOTONIC microseconds.
+     * @param lead write point before the vsync, microseconds.
+     * @return DBus reply.
+     */
+    QDBusReply<void> setFrameClock(int sessionId, unsigned int period, quint64 phase, unsigned int lead);
+
+    /**
+     * Request recent samples for a started session.
+     *
+     * @param sessionId session ID.
+     * @param duration history duration in milliseconds.
+     * @return DBus reply, number of samples written.
+     */
+    QDBusReply<int> requestHistory(int sessionId, unsigned int duration);
+
+    /**
+     * Open a direct channel for a session. The hardware writes samples
+     * as Android <tt>sensors_event_t</tt> records into the returned
+     * memory, which the client maps and reads itself. Samples of a
+     * direct channel do not go through sensord filtering.
+     *
+     * @param sessionId session ID.
+     * @param interval requested interval in milliseconds.
+     * @return DBus reply, invalid descriptor if the sensor has no
+     *         direct channel support.
+     */
+    QDBusReply<QDBusUnixFileDescriptor> openDirectChannel(int sessionId, unsigned int interval);
+
+    /**
+     * Close direct channel of a session.
+     *
+     * @param sessionId session ID.
+     * @return DBus reply.
+     */
+    QDBusReply<void> closeDirectChannel(int sessionId);
+
+    /**
+     * Set latency tracing to session.
+     *
+     * @param sessionId session ID.
+     * @param value latency tracing.
+     * @return DBus reply.
+     */
+    QDBusReply<void> setLatencyTracing(int sessionId, bool value);
+
     /**
      * Start sensor for session.
      *
@@ -380,6 +717,26 @@ private Q_SLOTS: // METHODS
      */
     void dataReceived();
 
+    /**
+     * Callback for finished watched calls.
+     *
+     * @param watcher watcher of the call.
+     */
+    void callFinished(QDBusPendingCallWatcher* watcher);
+
+    /**
+     * Callback for changed metadata of the sensor. Drops the cached
+     * metadata.
+     */
+    void metadataChanged();
+
+    /**
+     * Callback for a batch of changed properties of the sensor.
+     *
+     * @param names property names.
+     */
+    void propertiesChanged(const QStringList& names);
+
 protected:
     /**
      * Constructor.
@@ -427,6 +784,38 @@ protected:
     template<typename T>
     T getAccessor(const char* name);
 
+    /**
+     * Get sensor metadata value. Metadata is fetched with one call and
+     * cached until sensord signals a change. Falls back to calling the
+     * accessor against a sensord without the metadata call.
+     *
+     * @tparam value type.
+     * @param key metadata key.
+     * @param accessor accessor method name.
+     * @return metadata value.
+     */
+    template<typename T>
+    T getMetadata(const char* key, const char* accessor);
+
+    /**
+     * Read the latest sample of the channel from the shared memory page
+     * sensord keeps for it, without any IPC. The page is mapped
+     * read-only on first use. Callers fall back to #getAccessor() when
+     * this fails, for example against a sensord without the pages.
+     *
+     * @param data location for the sample.
+     * @param size size of the sample type of the channel.
+     * @return was a sample read.
+     */
+    bool readLatestSample(void* data, unsigned int size);
+
+    /**
+     * Get cached sensor metadata, fetching it first if needed.
+     *
+     * @return metadata, NULL if sensord does not provide it.
+     */
+    const QVariantMap* cachedMetadata();
+
     /**
      * Utility for calling DBus methods from current connection which
      * return nothing and take one arg.
@@ -493,6 +882,18 @@ T AbstractSensorChannelInterface::getAccessor(const char* name)
     return reply.value();
 }
 
+template<typename T>
+T AbstractSensorChannelInterface::getMetadata(const char* key, const char* accessor)
+{
+    const QVariantMap* metadata = cachedMetadata();
+    if (!metadata)
+        return getAccessor<T>(accessor);
+    QVariant value = metadata->value(QLatin1String(key));
+    if (value.userType() == qMetaTypeId<QDBusArgument>())
+        return qdbus_cast<T>(value.value<QDBusArgument>());
+    return value.value<T>();
+}
+
 template<typename T>
 void AbstractSensorChannelInterface::setAccessor(const char* name, const T& value)
 {
@@ -0,0 +1,57 @@
+/**
+   @file accelerometerfloatsensor_i.cpp
+   @brief Interface for AccelerometerFloatSensor
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "sensormanagerinterface.h"
+#include "accelerometerfloatsensor_i.h"
+
+const char* AccelerometerFloatSensorChannelInterface::staticInterfaceName = "local.AccelerometerFloatSensor";
+
+AbstractSensorChannelInterface* AccelerometerFloatSensorChannelInterface::factoryMethod(const QString& id, int sessionId)
+{
+    return new AccelerometerFloatSensorChannelInterface(OBJECT_PATH + "/" + id, sessionId);
+}
+
+AccelerometerFloatSensorChannelInterface::AccelerometerFloatSensorChannelInterface(const QString &path, int sessionId) :
+    AbstractSensorChannelInterface(path, AccelerometerFloatSensorChannelInterface::staticInterfaceName, sessionId)
+{
+}
+
+AccelerometerFloatSensorChannelInterface* AccelerometerFloatSensorChannelInterface::interface(const QString& id)
+{
+    SensorManagerInterface& sm = SensorManagerInterface::instance();
+    if ( !sm.registeredAndCorrectClassName( id, AccelerometerFloatSensorChannelInterface::staticMetaObject.className() ) )
+    {
+        return 0;
+    }
+    return dynamic_cast<AccelerometerFloatSensorChannelInterface*>(sm.interface(id));
+}
+
+bool AccelerometerFloatSensorChannelInterface::dataReceivedImpl()
+{
+    values_.resize(0);
+    if(!read<AccelerationFloatData>(values_))
+        return false;
+    emit samplesAvailable(values_);
+    foreach(const AccelerationFloatData& data, values_)
+        emit dataAvailable(data);
+    return true;
+}
@@ -0,0 +1,98 @@
+/**
+   @file accelerometerfloatsensor_i.h
+   @brief Interface for AccelerometerFloatSensor
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef ACCELEROMETERFLOATSENSOR_I_H
+#define ACCELEROMETERFLOATSENSOR_I_H
+
+#include <QtDBus/QtDBus>
+#include <QVector>
+#include "abstractsensor_i.h"
+#include <datatypes/orientationdata.h>
+
+/**
+ * Client interface for accessing accelerometer samples in m/s^2, as
+ * floats in the units the hardware reports.
+ */
+class AccelerometerFloatSensorChannelInterface : public AbstractSensorChannelInterface
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(AccelerometerFloatSensorChannelInterface)
+
+public:
+    /**
+     * Name of the D-Bus interface for this class.
+     */
+    static const char* staticInterfaceName;
+
+    /**
+     * Create new instance of the class.
+     *
+     * @param id Sensor ID.
+     * @param sessionId Session ID.
+     * @return Pointer to new instance of the class.
+     */
+    static AbstractSensorChannelInterface* factoryMethod(const QString& id, int sessionId);
+
+    /**
+     * Constructor.
+     *
+     * @param path      path.
+     * @param sessionId session ID.
+     */
+    AccelerometerFloatSensorChannelInterface(const QString& path, int sessionId);
+
+    /**
+     * Request an interface to the sensor.
+     *
+     * @param id sensor ID.
+     * @return Pointer to interface, or NULL on failure.
+     */
+    static AccelerometerFloatSensorChannelInterface* interface(const QString& id);
+
+protected:
+    virtual bool dataReceivedImpl();
+
+private:
+    QVector<AccelerationFloatData> values_; /**< receive buffer, reused between reads */
+
+Q_SIGNALS:
+    /**
+     * Sent when new measurement data has become available.
+     *
+     * @param data New measurement data.
+     */
+    void dataAvailable(const AccelerationFloatData& data);
+
+    /**
+     * Sent with every batch of samples as received from sensord. The
+     * vector shares the receive buffer.
+     *
+     * @param samples received samples.
+     */
+    void samplesAvailable(const QVector<AccelerationFloatData>& samples);
+};
+
+namespace local {
+  typedef ::AccelerometerFloatSensorChannelInterface AccelerometerFloatSensor;
+}
+
+#endif
@@ -62,19 +62,20 @@ AccelerometerSensorChannelInterface* AccelerometerSensorChannelInterface::interf
 
 bool AccelerometerSensorChannelInterface::dataReceivedImpl()
 {
-    QVector<AccelerationData> values;
-    if(!read<AccelerationData>(values))
+    values_.resize(0);
+    if(!read<AccelerationData>(values_))
         return false;
-    if(!frameAvailableConnected || values.size() == 1)
+    emit samplesAvailable(values_);
+    if(!frameAvailableConnected || values_.size() == 1)
     {
-        foreach(const AccelerationData& data, values)
+        foreach(const AccelerationData& data, values_)
             emit dataAvailable(XYZ(data));
     }
     else
     {
         QVector<XYZ> realValues;
-        realValues.reserve(values.size());
-        foreach(const AccelerationData& data, values)
+        realValues.reserve(values_.size());
+        foreach(const AccelerationData& data, values_)
             realValues.push_back(XYZ(data));
         emit frameAvailable(realValues);
     }
@@ -83,6 +84,9 @@ bool AccelerometerSensorChannelInterface::dataReceivedImpl()
 
 XYZ AccelerometerSensorChannelInterface::get()
 {
+    AccelerationData sample;
+    if (readLatestSample(&sample, sizeof(sample)))
+        return XYZ(sample);
     return getAccessor<XYZ>("xyz");
 }
 
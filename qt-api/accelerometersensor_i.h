@@ -107,6 +107,7 @@ protected:
 virtual bool dataReceivedImpl();
 
 private:
+    QVector<AccelerationData> values_; /**< receive buffer, reused between reads */
     bool frameAvailableConnected; /**< has applicaiton connected slot for frameAvailable signal. */
 
 Q_SIGNALS:
@@ -125,6 +126,16 @@ Q_SIGNALS:
      * @param frame New measurement frame.
      */
     void frameAvailable(const QVector<XYZ>& frame);
+
+    /**
+     * Sent with every batch of samples as received from sensord, before
+     * any conversion. The vector shares the receive buffer, slots
+     * which handle samples themselves avoid any per sample copies and
+     * signals.
+     *
+     * @param samples received samples.
+     */
+    void samplesAvailable(const QVector<AccelerationData>& samples);
 };
 
 namespace local {
@@ -64,15 +64,30 @@ ALSSensorChannelInterface* ALSSensorChannelInterface::interface(const QString& i
 
 bool ALSSensorChannelInterface::dataReceivedImpl()
 {
-    QVector<TimedUnsigned> values;
-    if(!read<TimedUnsigned>(values))
+    values_.resize(0);
+    if(!read<TimedUnsigned>(values_))
         return false;
-    foreach(const TimedUnsigned& data, values)
-        emit ALSChanged(data);
+    emit samplesAvailable(values_);
+    if(values_.size() == 1 || !receivers(SIGNAL(frameAvailable(QVector<Unsigned>))))
+    {
+        foreach(const TimedUnsigned& data, values_)
+            emit ALSChanged(data);
+    }
+    else
+    {
+        QVector<Unsigned> realValues;
+        realValues.reserve(values_.size());
+        foreach(const TimedUnsigned& data, values_)
+            realValues.push_back(Unsigned(data));
+        emit frameAvailable(realValues);
+    }
     return true;
 }
 
 Unsigned ALSSensorChannelInterface::lux()
 {
+    TimedUnsigned sample;
+    if (readLatestSample(&sample, sizeof(sample)))
+        return Unsigned(sample);
     return getAccessor<Unsigned>("lux");
 }
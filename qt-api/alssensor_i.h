@@ -28,6 +28,7 @@
 #define ALSSENSOR_I_H
 
 #include <QtDBus/QtDBus>
+#include <QVector>
 
 #include "datatypes/unsigned.h"
 #include "abstractsensor_i.h"
@@ -103,6 +104,9 @@ public:
 protected:
     virtual bool dataReceivedImpl();
 
+private:
+    QVector<TimedUnsigned> values_; /**< receive buffer, reused between reads */
+
 Q_SIGNALS:
     /**
      * Sent when measured ambient light intensity has changed.
@@ -110,6 +114,25 @@ Q_SIGNALS:
      * @param value ambient light reading.
      */
     void ALSChanged(const Unsigned& value);
+
+    /**
+     * Sent when new measurement frame has become available.
+     * If app doesn't connect to this signal content of frames
+     * will be sent through #ALSChanged signal.
+     *
+     * @param frame New measurement frame.
+     */
+    void frameAvailable(const QVector<Unsigned>& frame);
+
+    /**
+     * Sent with every batch of samples as received from sensord, before
+     * any conversion. The vector shares the receive buffer, slots
+     * which handle samples themselves avoid any per sample copies and
+     * signals.
+     *
+     * @param samples received samples.
+     */
+    void samplesAvailable(const QVector<TimedUnsigned>& samples);
 };
 
 namespace local {
@@ -62,16 +62,31 @@ CompassSensorChannelInterface* CompassSensorChannelInterface::interface(const QS
 
 bool CompassSensorChannelInterface::dataReceivedImpl()
 {
-    QVector<CompassData> values;
-    if(!read<CompassData>(values))
+    values_.resize(0);
+    if(!read<CompassData>(values_))
         return false;
-    foreach(const CompassData& data, values)
-        emit dataAvailable(Compass(data, useDeclination_));
+    emit samplesAvailable(values_);
+    if(values_.size() == 1 || !receivers(SIGNAL(frameAvailable(QVector<Compass>))))
+    {
+        foreach(const CompassData& data, values_)
+            emit dataAvailable(Compass(data, useDeclination_));
+    }
+    else
+    {
+        QVector<Compass> realValues;
+        realValues.reserve(values_.size());
+        foreach(const CompassData& data, values_)
+            realValues.push_back(Compass(data, useDeclination_));
+        emit frameAvailable(realValues);
+    }
     return true;
 }
 
 Compass CompassSensorChannelInterface::get()
 {
+    CompassData sample;
+    if (readLatestSample(&sample, sizeof(sample)))
+        return Compass(sample, useDeclination_);
     return Compass(getAccessor<Compass>("value").data(), useDeclination_);
 }
 
@@ -83,6 +98,11 @@ bool CompassSensorChannelInterface::useDeclination()
 void CompassSensorChannelInterface::setUseDeclination(bool enable)
 {
     useDeclination_ = enable;
+    // Let the daemon skip declination correction when no one needs it.
+    QDBusReply<bool> reply(call(QDBus::Block, QLatin1String("setDeclinationCorrection"),
+                                qVariantFromValue(sessionId()), qVariantFromValue(enable)));
+    if (!reply.isValid())
+        qDebug() << "Failed to set declination correction: " << reply.error().message();
 }
 
 int CompassSensorChannelInterface::declinationValue()
@@ -28,6 +28,7 @@
 #define COMPASSSENSOR_I_H
 
 #include <QtDBus/QtDBus>
+#include <QVector>
 
 #include "abstractsensor_i.h"
 #include <datatypes/compass.h>
@@ -76,6 +77,8 @@ public:
 
     /**
      * Sets whether the declination correction should be applied or not.
+     * The daemon only computes the correction while some session uses
+     * it.
      *
      * @param enable If true, declination correction will be applied,
      *               if false, it will not be applied
@@ -135,8 +138,28 @@ Q_SIGNALS:
      */
     void dataAvailable(const Compass& value);
 
+    /**
+     * Sent when new measurement frame has become available.
+     * If app doesn't connect to this signal content of frames
+     * will be sent through #dataAvailable signal.
+     *
+     * @param frame New measurement frame.
+     */
+    void frameAvailable(const QVector<Compass>& frame);
+
+    /**
+     * Sent with every batch of samples as received from sensord, before
+     * any conversion. The vector shares the receive buffer, slots
+     * which handle samples themselves avoid any per sample copies and
+     * signals.
+     *
+     * @param samples received samples.
+     */
+    void samplesAvailable(const QVector<CompassData>& samples);
+
 private:
 
+    QVector<CompassData> values_; /**< receive buffer, reused between reads */
     bool useDeclination_;
 };
 
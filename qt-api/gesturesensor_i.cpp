@@ -0,0 +1,64 @@
+/**
+   @file gesturesensor_i.cpp
+   @brief GestureSensorChannelInterface
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "sensormanagerinterface.h"
+#include "gesturesensor_i.h"
+
+const char* GestureSensorChannelInterface::staticInterfaceName = "local.GestureSensor";
+
+AbstractSensorChannelInterface* GestureSensorChannelInterface::factoryMethod(const QString& id, int sessionId)
+{
+    return new GestureSensorChannelInterface(OBJECT_PATH + "/" + id, sessionId);
+}
+
+GestureSensorChannelInterface::GestureSensorChannelInterface(const QString &path, int sessionId)
+    : AbstractSensorChannelInterface(path, GestureSensorChannelInterface::staticInterfaceName, sessionId)
+{
+}
+
+GestureSensorChannelInterface* GestureSensorChannelInterface::interface(const QString& id)
+{
+    SensorManagerInterface& sm = SensorManagerInterface::instance();
+    if ( !sm.registeredAndCorrectClassName( id, GestureSensorChannelInterface::staticMetaObject.className() ) )
+    {
+        return 0;
+    }
+
+    return dynamic_cast<GestureSensorChannelInterface*>(sm.interface(id));
+}
+
+bool GestureSensorChannelInterface::dataReceivedImpl()
+{
+    values_.resize(0);
+    if(!read<GestureData>(values_))
+        return false;
+
+    foreach(const GestureData& data, values_)
+        emit dataAvailable(Gesture(data));
+    return true;
+}
+
+Gesture GestureSensorChannelInterface::get()
+{
+    return getAccessor<Gesture>("value");
+}
@@ -0,0 +1,100 @@
+/**
+   @file gesturesensor_i.h
+   @brief GestureSensorChannelInterface
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef GESTURESENSOR_I_H
+#define GESTURESENSOR_I_H
+
+#include <QtDBus/QtDBus>
+#include <QVector>
+
+#include "abstractsensor_i.h"
+#include <datatypes/gesture.h>
+
+/**
+ * Client interface for shake, double tap and flip gestures. Gestures
+ * are detected by sensord, data only arrives when one happens.
+ */
+class GestureSensorChannelInterface : public AbstractSensorChannelInterface
+{
+    Q_OBJECT;
+    Q_DISABLE_COPY(GestureSensorChannelInterface)
+    Q_PROPERTY(Gesture value READ get)
+
+public:
+    /**
+     * Name of the D-Bus interface for this class.
+     */
+    static const char* staticInterfaceName;
+
+    /**
+     * Create new instance of the class.
+     *
+     * @param id Sensor ID.
+     * @param sessionId Session ID.
+     * @return Pointer to new instance of the class.
+     */
+    static AbstractSensorChannelInterface* factoryMethod(const QString& id, int sessionId);
+
+    /**
+     * Get latest gesture from sensor daemon.
+     *
+     * @return gesture.
+     */
+    Gesture get();
+
+    /**
+     * Constructor.
+     *
+     * @param path      path.
+     * @param sessionId session id.
+     */
+    GestureSensorChannelInterface(const QString &path, int sessionId);
+
+    /**
+     * Request an interface to the sensor.
+     *
+     * @param id sensor ID.
+     * @return Pointer to interface, or NULL on failure.
+     */
+    static GestureSensorChannelInterface* interface(const QString& id);
+
+protected:
+    virtual bool dataReceivedImpl();
+
+private:
+    QVector<GestureData> values_; /**< receive buffer, reused between reads */
+
+Q_SIGNALS:
+    /**
+     * Sent when a gesture has been detected.
+     *
+     * @param data The gesture.
+     */
+    void dataAvailable(const Gesture& data);
+};
+
+namespace local {
+  typedef ::GestureSensorChannelInterface GestureSensor;
+}
+
+#endif
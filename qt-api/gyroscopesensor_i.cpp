@@ -67,19 +67,20 @@ GyroscopeSensorChannelInterface* GyroscopeSensorChannelInterface::interface(cons
 
 bool GyroscopeSensorChannelInterface::dataReceivedImpl()
 {
-    QVector<TimedXyzData> values;
-    if(!read<TimedXyzData>(values))
+    values_.resize(0);
+    if(!read<TimedXyzData>(values_))
         return false;
-    if(!frameAvailableConnected || values.size() == 1)
+    emit samplesAvailable(values_);
+    if(!frameAvailableConnected || values_.size() == 1)
     {
-        foreach(const TimedXyzData& data, values)
+        foreach(const TimedXyzData& data, values_)
             emit dataAvailable(XYZ(data));
     }
     else
     {
         QVector<XYZ> realValues;
-        realValues.reserve(values.size());
-        foreach(const TimedXyzData& data, values)
+        realValues.reserve(values_.size());
+        foreach(const TimedXyzData& data, values_)
             realValues.push_back(XYZ(data));
         emit frameAvailable(realValues);
     }
@@ -104,5 +105,8 @@ void GyroscopeSensorChannelInterface::connectNotify(const QMetaMethod &signal)
 
 XYZ GyroscopeSensorChannelInterface::get()
 {
+    TimedXyzData sample;
+    if (readLatestSample(&sample, sizeof(sample)))
+        return XYZ(sample);
     return getAccessor<XYZ>("value");
 }
@@ -29,6 +29,7 @@
 #define GYROSCOPESENSOR_I_H
 
 #include <QtDBus/QtDBus>
+#include <QVector>
 
 #include "abstractsensor_i.h"
 #include <datatypes/xyz.h>
@@ -107,6 +108,7 @@ protected:
     virtual bool dataReceivedImpl();
 
 private:
+    QVector<TimedXyzData> values_; /**< receive buffer, reused between reads */
     bool frameAvailableConnected; /**< has applicaiton connected slot for frameAvailable signal. */
 
 Q_SIGNALS:
@@ -125,6 +127,16 @@ Q_SIGNALS:
      * @param frame New measurement frame.
      */
     void frameAvailable(const QVector<XYZ>& frame);
+
+    /**
+     * Sent with every batch of samples as received from sensord, before
+     * any conversion. The vector shares the receive buffer, slots
+     * which handle samples themselves avoid any per sample copies and
+     * signals.
+     *
+     * @param samples received samples.
+     */
+    void samplesAvailable(const QVector<TimedXyzData>& samples);
 };
 
 namespace local {
@@ -0,0 +1,93 @@
+/**
+   @file imusensor_i.cpp
+   @brief ImuSensorChannelInterface
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "sensormanagerinterface.h"
+#include "imusensor_i.h"
+
+const char* ImuSensorChannelInterface::staticInterfaceName = "local.ImuSensor";
+
+AbstractSensorChannelInterface* ImuSensorChannelInterface::factoryMethod(const QString& id, int sessionId)
+{
+    return new ImuSensorChannelInterface(OBJECT_PATH + "/" + id, sessionId);
+}
+
+ImuSensorChannelInterface::ImuSensorChannelInterface(const QString &path, int sessionId)
+    : AbstractSensorChannelInterface(path, ImuSensorChannelInterface::staticInterfaceName, sessionId),
+      frameAvailableConnected(false)
+{
+}
+
+ImuSensorChannelInterface* ImuSensorChannelInterface::interface(const QString& id)
+{
+    SensorManagerInterface& sm = SensorManagerInterface::instance();
+    if ( !sm.registeredAndCorrectClassName( id, ImuSensorChannelInterface::staticMetaObject.className() ) )
+    {
+        return 0;
+    }
+
+    return dynamic_cast<ImuSensorChannelInterface*>(sm.interface(id));
+}
+
+bool ImuSensorChannelInterface::dataReceivedImpl()
+{
+    values_.resize(0);
+    if(!read<TimedImuData>(values_))
+        return false;
+
+    emit samplesAvailable(values_);
+    if(!frameAvailableConnected || values_.size() == 1)
+    {
+        foreach(const TimedImuData& data, values_)
+            emit dataAvailable(Imu(data));
+    }
+    else
+    {
+        QVector<Imu> realValues;
+        realValues.reserve(values_.size());
+        foreach(const TimedImuData& data, values_)
+            realValues.push_back(Imu(data));
+        emit frameAvailable(realValues);
+    }
+    return true;
+}
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+void ImuSensorChannelInterface::connectNotify(const char* signal)
+#else
+void ImuSensorChannelInterface::connectNotify(const QMetaMethod &signal)
+#endif
+{
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+    if(QLatin1String(signal) == SIGNAL(frameAvailable(QVector<Imu>)))
+#else
+    static const QMetaMethod frameAvailableSignal = QMetaMethod::fromSignal(&ImuSensorChannelInterface::frameAvailable);
+    if(signal == frameAvailableSignal)
+#endif
+        frameAvailableConnected = true;
+    dbusConnectNotify(signal);
+}
+
+Imu ImuSensorChannelInterface::get()
+{
+    return getAccessor<Imu>("value");
+}
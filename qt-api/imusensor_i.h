@@ -0,0 +1,126 @@
+/**
+   @file imusensor_i.h
+   @brief ImuSensorChannelInterface
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef IMUSENSOR_I_H
+#define IMUSENSOR_I_H
+
+#include <QtDBus/QtDBus>
+#include <QVector>
+
+#include "abstractsensor_i.h"
+#include <datatypes/imu.h>
+
+/**
+ * Client interface for time-aligned accelerometer, gyroscope and
+ * magnetometer frames. Every frame arrives with a single read, so
+ * clients need neither three sessions nor realignment of their own.
+ */
+class ImuSensorChannelInterface : public AbstractSensorChannelInterface
+{
+    Q_OBJECT;
+    Q_DISABLE_COPY(ImuSensorChannelInterface)
+    Q_PROPERTY(Imu value READ get)
+
+public:
+    /**
+     * Name of the D-Bus interface for this class.
+     */
+    static const char* staticInterfaceName;
+
+    /**
+     * Create new instance of the class.
+     *
+     * @param id Sensor ID.
+     * @param sessionId Session ID.
+     * @return Pointer to new instance of the class.
+     */
+    static AbstractSensorChannelInterface* factoryMethod(const QString& id, int sessionId);
+
+    /**
+     * Get latest frame from sensor daemon.
+     *
+     * @return frame.
+     */
+    Imu get();
+
+    /**
+     * Constructor.
+     *
+     * @param path      path.
+     * @param sessionId session id.
+     */
+    ImuSensorChannelInterface(const QString &path, int sessionId);
+
+    /**
+     * Request an interface to the sensor.
+     *
+     * @param id sensor ID.
+     * @return Pointer to interface, or NULL on failure.
+     */
+    static ImuSensorChannelInterface* interface(const QString& id);
+
+protected:
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+    virtual void connectNotify(const char* signal);
+#else
+    virtual void connectNotify(const QMetaMethod & signal);
+#endif
+    virtual bool dataReceivedImpl();
+
+private:
+    QVector<TimedImuData> values_; /**< receive buffer, reused between reads */
+    bool frameAvailableConnected; /**< has applicaiton connected slot for frameAvailable signal. */
+
+Q_SIGNALS:
+    /**
+     * Sent when new measurement data has become available.
+     *
+     * @param data New measurement data.
+     */
+    void dataAvailable(const Imu& data);
+
+    /**
+     * Sent when new measurement frame has become available.
+     * If app doesn't connect to this signal content of frames
+     * will be sent through dataAvailable signal.
+     *
+     * @param frame New measurement frame.
+     */
+    void frameAvailable(const QVector<Imu>& frame);
+
+    /**
+     * Sent with every batch of samples as received from sensord, before
+     * any conversion. The vector shares the receive buffer, slots
+     * which handle samples themselves avoid any per sample copies and
+     * signals.
+     *
+     * @param samples received samples.
+     */
+    void samplesAvailable(const QVector<TimedImuData>& samples);
+};
+
+namespace local {
+  typedef ::ImuSensorChannelInterface ImuSensor;
+}
+
+#endif
@@ -0,0 +1,81 @@
+/**
+   @file latencystatistics.cpp
+   @brief LatencyStatistics
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "latencystatistics.h"
+#include <string.h>
+
+LatencyStatistics::LatencyStatistics()
+{
+    clear();
+}
+
+void LatencyStatistics::clear()
+{
+    count_ = 0;
+    memset(stages_, 0, sizeof(stages_));
+}
+
+void LatencyStatistics::add(const SessionFrameTrace& trace, quint64 received)
+{
+    addStage(QueueStage, trace.sampled, trace.queued);
+    addStage(DispatchStage, trace.queued, trace.delivered);
+    addStage(SessionStage, trace.delivered, trace.written);
+    addStage(SocketStage, trace.written, received);
+    addStage(TotalStage, trace.sampled, received);
+    ++count_;
+}
+
+void LatencyStatistics::addStage(Stage stage, quint64 from, quint64 to)
+{
+    // Adaptors may stamp samples with the driver time, which can be
+    // slightly ahead of the time read in sensord.
+    quint64 latency = to > from ? to - from : 0;
+
+    StageData& data = stages_[stage];
+    if (!count_ || latency < data.minimum)
+        data.minimum = latency;
+    if (latency > data.maximum)
+        data.maximum = latency;
+    data.sum += latency;
+
+    int bucket = 0;
+    while (bucket < BUCKETS - 1 && latency >= ((quint64)1 << bucket))
+        ++bucket;
+    ++data.histogram[bucket];
+}
+
+quint64 LatencyStatistics::percentile(Stage stage, int percent) const
+{
+    if (!count_)
+        return 0;
+
+    quint64 wanted = ((quint64)count_ * qBound(0, percent, 100) + 99) / 100;
+    quint64 seen = 0;
+    for (int bucket = 0; bucket < BUCKETS - 1; ++bucket)
+    {
+        seen += stages_[stage].histogram[bucket];
+        if (seen >= wanted)
+            return qMin((quint64)1 << bucket, stages_[stage].maximum);
+    }
+    return stages_[stage].maximum;
+}
@@ -0,0 +1,143 @@
+/**
+   @file latencystatistics.h
+   @brief LatencyStatistics
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef LATENCYSTATISTICS_H
+#define LATENCYSTATISTICS_H
+
+#include <QtGlobal>
+#include "sessionframe.h"
+
+/**
+ * Distribution of sample latencies measured from traced frames. The
+ * time of the newest sample of every traced frame is split into the
+ * stages the sample passes on its way from the adaptor to the client.
+ */
+class LatencyStatistics
+{
+public:
+    /**
+     * Stages of the sample path.
+     */
+    enum Stage
+    {
+        QueueStage = 0, /**< adaptor timestamp to queued for the main thread */
+        DispatchStage,  /**< waiting in the queue for the main thread */
+        SessionStage,   /**< buffering in the session until written */
+        SocketStage,    /**< socket until read by the client */
+        TotalStage,     /**< adaptor timestamp to read by the client */
+        StageCount
+    };
+
+    /**
+     * Number of histogram buckets. Bucket n counts latencies below
+     * 2^n microseconds, the last bucket everything above.
+     */
+    static const int BUCKETS = 16;
+
+    /**
+     * Constructor.
+     */
+    LatencyStatistics();
+
+    /**
+     * Account a traced frame.
+     *
+     * @param trace stage timestamps sent by sensord.
+     * @param received time the frame was read, CLOCK_MONOTONIC in
+     *                 microseconds.
+     */
+    void add(const SessionFrameTrace& trace, quint64 received);
+
+    /**
+     * Forget all measurements.
+     */
+    void clear();
+
+    /**
+     * Number of measured samples.
+     *
+     * @return sample count.
+     */
+    unsigned int count() const { return count_; }
+
+    /**
+     * Smallest latency of a stage.
+     *
+     * @param stage stage.
+     * @return latency in microseconds.
+     */
+    quint64 minimum(Stage stage) const { return count_ ? stages_[stage].minimum : 0; }
+
+    /**
+     * Largest latency of a stage.
+     *
+     * @param stage stage.
+     * @return latency in microseconds.
+     */
+    quint64 maximum(Stage stage) const { return stages_[stage].maximum; }
+
+    /**
+     * Average latency of a stage.
+     *
+     * @param stage stage.
+     * @return latency in microseconds.
+     */
+    quint64 average(Stage stage) const { return count_ ? stages_[stage].sum / count_ : 0; }
+
+    /**
+     * Number of latencies in a histogram bucket.
+     *
+     * @param stage stage.
+     * @param bucket bucket index, see #BUCKETS.
+     * @return sample count.
+     */
+    unsigned int histogram(Stage stage, int bucket) const { return stages_[stage].histogram[bucket]; }
+
+    /**
+     * Estimate latency below which given percentage of samples fall.
+     *
+     * @param stage stage.
+     * @param percent percentage, 0 - 100.
+     * @return upper bound of the histogram bucket in microseconds.
+     */
+    quint64 percentile(Stage stage, int percent) const;
+
+private:
+    /**
+     * Measurements of a single stage.
+     */
+    struct StageData
+    {
+        quint64      minimum;            /**< smallest latency */
+        quint64      maximum;            /**< largest latency */
+        quint64      sum;                /**< sum of latencies */
+        unsigned int histogram[BUCKETS]; /**< log2 histogram */
+    };
+
+    void addStage(Stage stage, quint64 from, quint64 to);
+
+    unsigned int count_;              /**< number of measured samples */
+    StageData    stages_[StageCount]; /**< per stage measurements */
+};
+
+#endif // LATENCYSTATISTICS_H
@@ -64,19 +64,20 @@ MagnetometerSensorChannelInterface* MagnetometerSensorChannelInterface::interfac
 
 bool MagnetometerSensorChannelInterface::dataReceivedImpl()
 {
-    QVector<CalibratedMagneticFieldData> values;
-    if(!read<CalibratedMagneticFieldData>(values))
+    values_.resize(0);
+    if(!read<CalibratedMagneticFieldData>(values_))
         return false;
-    if(!frameAvailableConnected || values.size() == 1)
+    emit samplesAvailable(values_);
+    if(!frameAvailableConnected || values_.size() == 1)
     {
-        foreach(const CalibratedMagneticFieldData& data, values)
+        foreach(const CalibratedMagneticFieldData& data, values_)
             emit dataAvailable(MagneticField(data));
     }
     else
     {
         QVector<MagneticField> realValues;
-        realValues.reserve(values.size());
-        foreach(const CalibratedMagneticFieldData& data, values)
+        realValues.reserve(values_.size());
+        foreach(const CalibratedMagneticFieldData& data, values_)
             realValues.push_back(MagneticField(data));
         emit frameAvailable(realValues);
     }
@@ -106,5 +107,8 @@ QDBusReply<void> MagnetometerSensorChannelInterface::reset()
 
 MagneticField MagnetometerSensorChannelInterface::magneticField()
 {
+    CalibratedMagneticFieldData sample;
+    if (readLatestSample(&sample, sizeof(sample)))
+        return MagneticField(sample);
     return getAccessor<MagneticField>("magneticField");
 }
@@ -108,6 +108,7 @@ protected:
     virtual bool dataReceivedImpl();
 
 private:
+    QVector<CalibratedMagneticFieldData> values_; /**< receive buffer, reused between reads */
     bool frameAvailableConnected; /**< has applicaiton connected slot for frameAvailable signal. */
 
 public Q_SLOTS:
@@ -134,6 +135,16 @@ Q_SIGNALS:
      * @param frame New measurement frame.
      */
     void frameAvailable(const QVector<MagneticField>& frame);
+
+    /**
+     * Sent with every batch of samples as received from sensord, before
+     * any conversion. The vector shares the receive buffer, slots
+     * which handle samples themselves avoid any per sample copies and
+     * signals.
+     *
+     * @param samples received samples.
+     */
+    void samplesAvailable(const QVector<CalibratedMagneticFieldData>& samples);
 };
 
 namespace local {
@@ -62,11 +62,23 @@ OrientationSensorChannelInterface* OrientationSensorChannelInterface::interface(
 
 bool OrientationSensorChannelInterface::dataReceivedImpl()
 {
-    QVector<TimedUnsigned> values;
-    if(!read<TimedUnsigned>(values))
+    values_.resize(0);
+    if(!read<TimedUnsigned>(values_))
         return false;
-    foreach(const TimedUnsigned& data, values)
-        emit orientationChanged(data);
+    emit samplesAvailable(values_);
+    if(values_.size() == 1 || !receivers(SIGNAL(frameAvailable(QVector<Unsigned>))))
+    {
+        foreach(const TimedUnsigned& data, values_)
+            emit orientationChanged(data);
+    }
+    else
+    {
+        QVector<Unsigned> realValues;
+        realValues.reserve(values_.size());
+        foreach(const TimedUnsigned& data, values_)
+            realValues.push_back(Unsigned(data));
+        emit frameAvailable(realValues);
+    }
     return true;
 }
 
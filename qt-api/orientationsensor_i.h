@@ -28,6 +28,7 @@
 #define ORIENTATIONSENSOR_I_H
 
 #include <QtDBus/QtDBus>
+#include <QVector>
 
 #include <datatypes/unsigned.h>
 #include "abstractsensor_i.h"
@@ -118,6 +119,9 @@ public:
 protected:
     virtual bool dataReceivedImpl();
 
+private:
+    QVector<TimedUnsigned> values_; /**< receive buffer, reused between reads */
+
 Q_SIGNALS:
     /**
      * Sent when device orientation has changed.
@@ -126,6 +130,25 @@ Q_SIGNALS:
      *                    value is enumeration from #PoseData::Orientation.
      */
     void orientationChanged(const Unsigned& orientation);
+
+    /**
+     * Sent when new measurement frame has become available.
+     * If app doesn't connect to this signal content of frames
+     * will be sent through #orientationChanged signal.
+     *
+     * @param frame New measurement frame.
+     */
+    void frameAvailable(const QVector<Unsigned>& frame);
+
+    /**
+     * Sent with every batch of samples as received from sensord, before
+     * any conversion. The vector shares the receive buffer, slots
+     * which handle samples themselves avoid any per sample copies and
+     * signals.
+     *
+     * @param samples received samples.
+     */
+    void samplesAvailable(const QVector<TimedUnsigned>& samples);
 };
 
 namespace local {
@@ -63,10 +63,11 @@ ProximitySensorChannelInterface* ProximitySensorChannelInterface::interface(cons
 
 bool ProximitySensorChannelInterface::dataReceivedImpl()
 {
-    QVector<ProximityData> values;
-    if(!read<ProximityData>(values))
+    values_.resize(0);
+    if(!read<ProximityData>(values_))
         return false;
-    foreach(const ProximityData& data, values)
+    emit samplesAvailable(values_);
+    foreach(const ProximityData& data, values_)
     {
         Proximity proximity(data);
         emit dataAvailable(proximity);
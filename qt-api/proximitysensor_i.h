@@ -28,6 +28,7 @@
 #define PROXIMITYSENSOR_I_H
 
 #include <QtDBus/QtDBus>
+#include <QVector>
 
 #include "abstractsensor_i.h"
 #include <datatypes/unsigned.h>
@@ -112,6 +113,9 @@ public:
 protected:
     virtual bool dataReceivedImpl();
 
+private:
+    QVector<ProximityData> values_; /**< receive buffer, reused between reads */
+
 Q_SIGNALS:
     /**
      * Sent when new measurement data has become available.
@@ -129,6 +133,16 @@ Q_SIGNALS:
      * @param data New measurement data.
      */
     void reflectanceDataAvailable(const Proximity& data);
+
+    /**
+     * Sent with every batch of samples as received from sensord, before
+     * any conversion. The vector shares the receive buffer, slots
+     * which handle samples themselves avoid any per sample copies and
+     * signals.
+     *
+     * @param samples received samples.
+     */
+    void samplesAvailable(const QVector<ProximityData>& samples);
 };
 
 namespace local {
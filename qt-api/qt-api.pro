@@ -5,33 +5,48 @@ TEMPLATE = lib
 
 include( ../common-config.pri )
 
+# shm_open for the latest sample pages
+LIBS += -lrt
+
 SOURCES += sensormanagerinterface.cpp \
     sensormanager_i.cpp \
     abstractsensor_i.cpp \
     socketreader.cpp \
+    latencystatistics.cpp \
     compasssensor_i.cpp \
     orientationsensor_i.cpp \
     accelerometersensor_i.cpp \
+    accelerometerfloatsensor_i.cpp \
     alssensor_i.cpp \
     tapsensor_i.cpp \
     proximitysensor_i.cpp \
     rotationsensor_i.cpp \
     magnetometersensor_i.cpp \
-    gyroscopesensor_i.cpp
+    gyroscopesensor_i.cpp \
+    quaternionsensor_i.cpp \
+    imusensor_i.cpp \
+    gesturesensor_i.cpp \
+    stepcountersensor_i.cpp
 
 HEADERS += sensormanagerinterface.h \
     sensormanager_i.h \
     abstractsensor_i.h \
     socketreader.h \
+    latencystatistics.h \
     compasssensor_i.h \
     orientationsensor_i.h \
     accelerometersensor_i.h \
+    accelerometerfloatsensor_i.h \
     alssensor_i.h \
     tapsensor_i.h \
     proximitysensor_i.h \
     rotationsensor_i.h \
     magnetometersensor_i.h \
-    gyroscopesensor_i.h
+    gyroscopesensor_i.h \
+    quaternionsensor_i.h \
+    imusensor_i.h \
+    gesturesensor_i.h \
+    stepcountersensor_i.h
 
 SENSORFW_INCLUDEPATHS = .. \
     ../include \
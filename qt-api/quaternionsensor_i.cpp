@@ -0,0 +1,108 @@
+/**
+   @file quaternionsensor_i.cpp
+   @brief QuaternionSensorChannelInterface
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "sensormanagerinterface.h"
+#include "quaternionsensor_i.h"
+
+const char* QuaternionSensorChannelInterface::staticInterfaceName = "local.QuaternionSensor";
+
+AbstractSensorChannelInterface* QuaternionSensorChannelInterface::factoryMethod(const QString& id, int sessionId)
+{
+    return new QuaternionSensorChannelInterface(OBJECT_PATH + "/" + id, sessionId);
+}
+
+QuaternionSensorChannelInterface::QuaternionSensorChannelInterface(const QString &path, int sessionId)
+    : AbstractSensorChannelInterface(path, QuaternionSensorChannelInterface::staticInterfaceName, sessionId),
+      frameAvailableConnected(false)
+{
+}
+
+QuaternionSensorChannelInterface* QuaternionSensorChannelInterface::interface(const QString& id)
+{
+    SensorManagerInterface& sm = SensorManagerInterface::instance();
+    if ( !sm.registeredAndCorrectClassName( id, QuaternionSensorChannelInterface::staticMetaObject.className() ) )
+    {
+        return 0;
+    }
+
+    return dynamic_cast<QuaternionSensorChannelInterface*>(sm.interface(id));
+}
+
+bool QuaternionSensorChannelInterface::dataReceivedImpl()
+{
+    values_.resize(0);
+    if(packedFormat())
+    {
+        packed_.resize(0);
+        if(!read<PackedQuaternionData>(packed_))
+            return false;
+        values_.reserve(packed_.size());
+        foreach(const PackedQuaternionData& data, packed_)
+            values_.push_back(data.unpack());
+    }
+    else if(!read<TimedQuaternionData>(values_))
+    {
+        return false;
+    }
+    emitValues(values_);
+    return true;
+}
+
+void QuaternionSensorChannelInterface::emitValues(const QVector<TimedQuaternionData>& values)
+{
+    emit samplesAvailable(values);
+    if(!frameAvailableConnected || values.size() == 1)
+    {
+        foreach(const TimedQuaternionData& data, values)
+            emit dataAvailable(Quaternion(data));
+    }
+    else
+    {
+        QVector<Quaternion> realValues;
+        realValues.reserve(values.size());
+        foreach(const TimedQuaternionData& data, values)
+            realValues.push_back(Quaternion(data));
+        emit frameAvailable(realValues);
+    }
+}
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+void QuaternionSensorChannelInterface::connectNotify(const char* signal)
+#else
+void QuaternionSensorChannelInterface::connectNotify(const QMetaMethod &signal)
+#endif
+{
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+    if(QLatin1String(signal) == SIGNAL(frameAvailable(QVector<Quaternion>)))
+#else
+    static const QMetaMethod frameAvailableSignal = QMetaMethod::fromSignal(&QuaternionSensorChannelInterface::frameAvailable);
+    if(signal == frameAvailableSignal)
+#endif
+        frameAvailableConnected = true;
+    dbusConnectNotify(signal);
+}
+
+Quaternion QuaternionSensorChannelInterface::get()
+{
+    return getAccessor<Quaternion>("value");
+}
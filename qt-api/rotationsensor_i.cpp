@@ -63,19 +63,20 @@ RotationSensorChannelInterface* RotationSensorChannelInterface::interface(const
 
 bool RotationSensorChannelInterface::dataReceivedImpl()
 {
-    QVector<TimedXyzData> values;
-    if(!read<TimedXyzData>(values))
+    values_.resize(0);
+    if(!read<TimedXyzData>(values_))
         return false;
-    if(!frameAvailableConnected || values.size() == 1)
+    emit samplesAvailable(values_);
+    if(!frameAvailableConnected || values_.size() == 1)
     {
-        foreach(const TimedXyzData& data, values)
+        foreach(const TimedXyzData& data, values_)
             emit dataAvailable(XYZ(data));
     }
     else
     {
         QVector<XYZ> realValues;
-        realValues.reserve(values.size());
-        foreach(const TimedXyzData& data, values)
+        realValues.reserve(values_.size());
+        foreach(const TimedXyzData& data, values_)
             realValues.push_back(XYZ(data));
         emit frameAvailable(realValues);
     }
@@ -84,6 +85,9 @@ bool RotationSensorChannelInterface::dataReceivedImpl()
 
 XYZ RotationSensorChannelInterface::rotation()
 {
+    TimedXyzData sample;
+    if (readLatestSample(&sample, sizeof(sample)))
+        return XYZ(sample);
     return getAccessor<XYZ>("rotation");
 }
 
@@ -92,6 +96,17 @@ bool RotationSensorChannelInterface::hasZ()
     return getAccessor<bool>("hasZ");
 }
 
+bool RotationSensorChannelInterface::setPredictionHorizon(unsigned int microseconds)
+{
+    QDBusReply<bool> reply(call(QDBus::Block, QLatin1String("setPredictionHorizon"),
+                                qVariantFromValue(sessionId()), qVariantFromValue(microseconds)));
+    if (!reply.isValid()) {
+        qDebug() << "Failed to set prediction horizon: " << reply.error().message();
+        return false;
+    }
+    return reply.value();
+}
+
 #if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
 void RotationSensorChannelInterface::connectNotify(const char* signal)
 #else
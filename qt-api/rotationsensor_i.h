@@ -74,6 +74,18 @@ public:
      */
     bool hasZ();
 
+    /**
+     * Deliver rotations extrapolated ahead in time with the gyroscope
+     * rate. Horizon is counted from the time the sample is delivered,
+     * so it should be the latency from delivery until the value is used,
+     * for example shown on screen. Sample timestamps are moved to the
+     * predicted time.
+     *
+     * @param microseconds prediction horizon, 0 disables prediction.
+     * @return was horizon accepted. Fails if the device has no gyroscope.
+     */
+    bool setPredictionHorizon(unsigned int microseconds);
+
     /**
      * Constructor.
      *
@@ -118,6 +130,7 @@ protected:
     virtual bool dataReceivedImpl();
 
 private:
+    QVector<TimedXyzData> values_; /**< receive buffer, reused between reads */
     bool frameAvailableConnected; /**< has applicaiton connected slot for frameAvailable signal. */
 
 Q_SIGNALS:
@@ -136,6 +149,16 @@ Q_SIGNALS:
      * @param frame New measurement frame.
      */
     void frameAvailable(const QVector<XYZ>& frame);
+
+    /**
+     * Sent with every batch of samples as received from sensord, before
+     * any conversion. The vector shares the receive buffer, slots
+     * which handle samples themselves avoid any per sample copies and
+     * signals.
+     *
+     * @param samples received samples.
+     */
+    void samplesAvailable(const QVector<TimedXyzData>& samples);
 };
 
 namespace local {
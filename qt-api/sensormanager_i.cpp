@@ -95,3 +95,25 @@ QDBusReply<bool> LocalSensorManagerInterface::releaseSensor(const QString& id, i
     argumentList << qVariantFromValue(pid);
     return callWithArgumentList(QDBus::Block, QLatin1String("releaseSensor"), argumentList);
 }
+
+QDBusPendingReply<bool> LocalSensorManagerInterface::openSession(const QString& id, int sessionId, const QVariantMap& config)
+{
+    qint64 pid = QCoreApplication::applicationPid();
+    QList<QVariant> argumentList;
+    argumentList << qVariantFromValue(id) << qVariantFromValue(sessionId);
+    argumentList << qVariantFromValue(config) << qVariantFromValue(pid);
+    return asyncCallWithArgumentList(QLatin1String("openSession"), argumentList);
+}
+
+QDBusReply<QVariantMap> LocalSensorManagerInterface::sensorInfo(const QStringList& plugins)
+{
+    qint64 pid = QCoreApplication::applicationPid();
+    QList<QVariant> argumentList;
+    argumentList << qVariantFromValue(plugins) << qVariantFromValue(pid);
+    return callWithArgumentList(QDBus::Block, QLatin1String("sensorInfo"), argumentList);
+}
+
+QDBusReply<QString> LocalSensorManagerInterface::peerAddress()
+{
+    return call(QDBus::Block, QLatin1String("peerAddress"));
+}
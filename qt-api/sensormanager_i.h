@@ -106,6 +106,36 @@ public Q_SLOTS:
      */
     QDBusReply<bool> releaseSensor(const QString& id, int sessionId);
 
+    /**
+     * Request sensor daemon to configure and start a session in one
+     * call. The call does not block.
+     *
+     * @param id sensor ID.
+     * @param sessionId session ID.
+     * @param config session configuration, see the sensord
+     *               SensorManager::openSession().
+     * @return pending DBus reply, true if every setting was applied.
+     */
+    QDBusPendingReply<bool> openSession(const QString& id, int sessionId, const QVariantMap& config);
+
+    /**
+     * Request sensor daemon to describe every available sensor in one
+     * call, instead of loading plugins and reading the properties of
+     * each sensor separately.
+     *
+     * @param plugins plugins to load first.
+     * @return DBus reply, sensor descriptions by sensor ID, see the
+     *         sensord SensorManager::sensorInfo().
+     */
+    QDBusReply<QVariantMap> sensorInfo(const QStringList& plugins = QStringList());
+
+    /**
+     * Request address of the peer-to-peer DBus server of sensor daemon.
+     *
+     * @return DBus reply, empty address if sensor daemon is not listening.
+     */
+    QDBusReply<QString> peerAddress();
+
 Q_SIGNALS:
 
     /**
@@ -32,8 +32,49 @@
 SensorManagerInterface* SensorManagerInterface::ifc_ = 0;
 QMutex SensorManagerInterface::mutex_;
 
+static const char* const PEER_CONNECTION_NAME = "sensord-peer";
+
+/**
+ * Connect to the peer-to-peer DBus server announced by sensord on the
+ * system bus.
+ *
+ * @return was the connection made.
+ */
+static bool connectToPeer()
+{
+    // Peer connection is opt-in, sensord only offers it when configured to.
+    if (qgetenv("SENSORFW_DBUS_PEER").isEmpty())
+        return false;
+
+    LocalSensorManagerInterface bus(SERVICE_NAME, OBJECT_PATH, QDBusConnection::systemBus());
+    QDBusReply<QString> address = bus.peerAddress();
+    if (!address.isValid() || address.value().isEmpty()) {
+        qDebug() << "Sensord has no peer-to-peer connection, using system bus";
+        return false;
+    }
+
+    QDBusConnection peer = QDBusConnection::connectToPeer(address.value(), PEER_CONNECTION_NAME);
+    if (!peer.isConnected()) {
+        qDebug() << "Failed to connect to sensord peer: " << peer.lastError().message();
+        QDBusConnection::disconnectFromPeer(PEER_CONNECTION_NAME);
+        return false;
+    }
+    return true;
+}
+
+QDBusConnection SensorManagerInterface::connection()
+{
+    static bool peer = connectToPeer();
+    return peer ? QDBusConnection(PEER_CONNECTION_NAME) : QDBusConnection::systemBus();
+}
+
+QString SensorManagerInterface::serviceName()
+{
+    return connection().name() == PEER_CONNECTION_NAME ? QString() : SERVICE_NAME;
+}
+
 SensorManagerInterface::SensorManagerInterface()
-  : LocalSensorManagerInterface( SERVICE_NAME, OBJECT_PATH, QDBusConnection::systemBus() )
+  : LocalSensorManagerInterface( serviceName(), OBJECT_PATH, connection() )
 {
 }
 
@@ -55,6 +55,23 @@ public:
 
     bool registeredAndCorrectClassName(const QString& id, const QString& className ) const;
 
+    /**
+     * Connection used for sensord calls. With SENSORFW_DBUS_PEER set
+     * the peer-to-peer connection of sensord is used when it offers
+     * one, the system bus otherwise.
+     *
+     * @return DBus connection.
+     */
+    static QDBusConnection connection();
+
+    /**
+     * Service name to use on #connection(). Peer-to-peer connections
+     * have none.
+     *
+     * @return DBus service name.
+     */
+    static QString serviceName();
+
 protected:
     SensorManagerInterface();
     virtual ~SensorManagerInterface() {}
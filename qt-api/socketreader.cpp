@@ -25,13 +25,51 @@
  */
 
 #include "socketreader.h"
+#include <QThread>
+#include <QCoreApplication>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+/**
+ * How long to wait for sensord to reply to shared memory request.
+ */
+static const int SHARED_RING_REPLY_TIMEOUT = 1000;
+/** Stop pulling more from the socket into one batch after this many bytes */
+static const qint64 MAX_BATCH_BYTES = 65536;
+/**
+ * How long to wait for sensord to accept a multiplexed connection.
+ */
+static const int MULTIPLEX_REPLY_TIMEOUT = 1000;
+/** Receive space initially kept free for a single packet */
+static const int INITIAL_PACKET_SPACE = 65536;
+/** Stop reading a threaded socket until this much queued data is taken */
+static const int MAX_QUEUED_BYTES = 4 * 1024 * 1024;
+
+SocketMultiplexer* SocketMultiplexer::instance_ = NULL;
 
 const char* SocketReader::channelIDString = "_SENSORCHANNEL_";
 
 SocketReader::SocketReader(QObject* parent) :
     QObject(parent),
     socket_(NULL),
-    tagRead_(false)
+    receiver_(NULL),
+    multiplexed_(false),
+    seqPacket_(false),
+    packetSpace_(INITIAL_PACKET_SPACE),
+    sessionId_(-1),
+    tagRead_(false),
+    ringSize_(0),
+    samplesDropped_(0),
+    bufferPos_(0),
+    bufferUsed_(0),
+    forwarded_(0)
 {
 }
 
@@ -42,42 +80,145 @@ SocketReader::~SocketReader()
     }
 }
 
-bool SocketReader::initiateConnection(int sessionId)
+bool SocketReader::initiateConnection(int sessionId, bool sharedMemory, bool multiplex, bool seqPacket, bool threaded)
 {
     if (socket_ != NULL) {
         qDebug() << "attempting to initiate connection on connected socket";
         return false;
     }
 
-    socket_ = new QLocalSocket(this);
-    socket_->connectToServer("/var/run/sensord.sock", QIODevice::ReadWrite);
+    if (multiplex && !sharedMemory) {
+        SocketMultiplexer* multiplexer = SocketMultiplexer::instance();
+        if (!multiplexer->attach(sessionId, this)) {
+            qWarning() << "[SOCKETREADER]: Failed to attach session" << sessionId << "to multiplexed connection";
+            return false;
+        }
+        socket_ = multiplexer->socket();
+        multiplexed_ = true;
+        sessionId_ = sessionId;
+        return true;
+    }
 
-    if (!(socket_->serverName().size())) {
+    // A socket read on the I/O thread is moved there, which needs it
+    // to be without a parent.
+    threaded = threaded && !sharedMemory;
+    socket_ = new QLocalSocket(threaded ? NULL : this);
+    if (!threaded)
+        connect(socket_, SIGNAL(readyRead()), this, SIGNAL(readyRead()));
+    if (seqPacket && !threaded && connectSeqPacket()) {
+        seqPacket_ = true;
+    } else {
+        if (seqPacket)
+            qDebug() << "[SOCKETREADER]: Packet socket not available, using stream socket";
+        socket_->connectToServer(SESSION_SOCKET_PATH, QIODevice::ReadWrite);
+    }
+
+    if (!seqPacket_ && !(socket_->serverName().size())) {
         qDebug() << socket_->errorString();
         return false;
     }
 
-    if (socket_->write((const char*)&sessionId, sizeof(sessionId)) != sizeof(sessionId)) {
+    if (sharedMemory) {
+        // Read the tag first so that QLocalSocket does not buffer the
+        // reply and lose the attached file descriptor.
+        readSocketTag();
+        SessionRequest request;
+        qint64 size = sessionRequestEncode(sessionId, true, request);
+        if (socket_->write((const char*)&request, size) != size) {
+            qDebug() << "[SOCKETREADER]: SessionId write failed: " << socket_->errorString();
+        }
+        socket_->flush();
+        if (!receiveSharedRing())
+            qDebug() << "[SOCKETREADER]: Shared memory not available, using socket";
+        return true;
+    }
+
+    SessionRequest request;
+    qint64 size = sessionRequestEncode(sessionId, false, request);
+    if (socket_->write((const char*)&request, size) != size) {
         qDebug() << "[SOCKETREADER]: SessionId write failed: " << socket_->errorString();
     }
     socket_->flush();
     readSocketTag();
 
+    if (threaded)
+        receiver_ = new SocketReceiver(socket_, this);
+
+    return true;
+}
+
+bool SocketReader::connectSeqPacket()
+{
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, SESSION_SEQPACKET_SOCKET_PATH, sizeof(address.sun_path) - 1);
+
+    int fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd == -1)
+        return false;
+    if (::connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+        !socket_->setSocketDescriptor(fd, QLocalSocket::ConnectedState, QIODevice::ReadWrite)) {
+        close(fd);
+        return false;
+    }
     return true;
 }
 
+qint64 SocketReader::receivePackets()
+{
+    int fd = socket_->socketDescriptor();
+    qint64 received = 0;
+    while (received < MAX_BATCH_BYTES) {
+        if (bufferUsed_ + packetSpace_ > buffer_.size())
+            buffer_.resize(bufferUsed_ + packetSpace_);
+        ssize_t bytes = ::recv(fd, buffer_.data() + bufferUsed_, packetSpace_, MSG_DONTWAIT | MSG_TRUNC);
+        if (bytes <= 0)
+            break;
+        if (bytes > packetSpace_) {
+            // Rest of the frame is gone, the sequence gap accounts for it.
+            qWarning() << "[SOCKETREADER]: Dropped a frame of" << bytes << "bytes not fitting the receive buffer";
+            packetSpace_ = bytes;
+            continue;
+        }
+        bufferUsed_ += bytes;
+        received += bytes;
+    }
+    return received;
+}
+
 bool SocketReader::dropConnection()
 {
     if (!socket_)
         return false;
 
-    socket_->disconnectFromServer();
-    if(socket_->state() != QLocalSocket::UnconnectedState)
-        socket_->waitForDisconnected();
-    delete socket_;
+    if (multiplexed_) {
+        SocketMultiplexer::instance()->detach(sessionId_);
+        multiplexed_ = false;
+        sessionId_ = -1;
+    } else if (receiver_) {
+        receiver_->close();
+        receiver_ = NULL;
+    } else {
+        socket_->disconnectFromServer();
+        if(socket_->state() != QLocalSocket::UnconnectedState)
+            socket_->waitForDisconnected();
+        delete socket_;
+    }
     socket_ = NULL;
+    seqPacket_ = false;
+
+    if (ring_.ring()) {
+        munmap((void*)ring_.ring(), ringSize_);
+        ring_.detach();
+        ringSize_ = 0;
+    }
 
     tagRead_ = false;
+    sequence_.reset();
+    bufferPos_ = 0;
+    bufferUsed_ = 0;
+    forwarded_ = 0;
 
     return true;
 }
@@ -87,6 +228,23 @@ QLocalSocket* SocketReader::socket()
     return socket_;
 }
 
+bool SocketReader::isMultiplexed() const
+{
+    return multiplexed_;
+}
+
+bool SocketReader::isThreaded() const
+{
+    return receiver_ != NULL;
+}
+
+bool SocketReader::hasPendingData() const
+{
+    // Multiplexed and threaded sessions are handed whole batches, all
+    // consumed by a read.
+    return socket_ && !multiplexed_ && !receiver_ && socket_->bytesAvailable() > 0;
+}
+
 bool SocketReader::readSocketTag()
 {
     char foo;
@@ -97,6 +255,17 @@ bool SocketReader::readSocketTag()
 
 bool SocketReader::read(void* buffer, int size)
 {
+    if (receiver_) {
+        // The socket belongs to the I/O thread, serve from what it queued.
+        if (bufferUsed_ - bufferPos_ < size)
+            receive();
+        if (bufferUsed_ - bufferPos_ < size)
+            return false;
+        memcpy(buffer, buffer_.constData() + bufferPos_, size);
+        bufferPos_ += size;
+        return true;
+    }
+
     int bytesRead = 0;
     int retry = 100;
     while(bytesRead < size)
@@ -124,3 +293,484 @@ bool SocketReader::isConnected()
 {
     return (socket_ && socket_->isValid() && socket_->state() == QLocalSocket::ConnectedState);
 }
+
+bool SocketReader::isSharedMemory() const
+{
+    return ring_.ring() != NULL;
+}
+
+bool SocketReader::receiveSharedRing()
+{
+    int sock = socket_->socketDescriptor();
+    struct pollfd pfd;
+    pfd.fd = sock;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, SHARED_RING_REPLY_TIMEOUT) <= 0) {
+        return false;
+    }
+
+    char reply = 0;
+    struct iovec iov;
+    iov.iov_base = &reply;
+    iov.iov_len = 1;
+    char control[CMSG_SPACE(sizeof(int))];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    if (recvmsg(sock, &msg, MSG_CMSG_CLOEXEC) != 1) {
+        qDebug() << "[SOCKETREADER]: Failed to read shared memory reply: " << strerror(errno);
+        return false;
+    }
+
+    int fd = -1;
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+        memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    if (reply != SHARED_RING_ACCEPTED || fd < 0) {
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+
+    struct stat st;
+    void* mem = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(SharedRingHeader))
+        mem = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        qDebug() << "[SOCKETREADER]: Failed to map shared memory: " << strerror(errno);
+        return false;
+    }
+
+    if (!ring_.attach((const SharedRingHeader*)mem, st.st_size)) {
+        qWarning() << "[SOCKETREADER]: Invalid shared memory ring";
+        munmap(mem, st.st_size);
+        return false;
+    }
+
+    ringSize_ = st.st_size;
+    return true;
+}
+
+int SocketReader::readShared(void* buffer, int elementSize, unsigned int maxCount)
+{
+    unsigned int lost = 0;
+    int count = ring_.read(buffer, elementSize, maxCount, lost);
+    if (lost) {
+        qWarning() << "[SOCKETREADER]: Shared memory ring overrun, dropped" << lost << "samples";
+        samplesDropped_ += lost;
+    }
+    return count;
+}
+
+void SocketReader::checkSequence(unsigned int sequence, unsigned int count)
+{
+    unsigned int lost = sequence_.accept(sequence, count);
+    if (lost) {
+        qWarning() << "[SOCKETREADER]: Lost" << lost << "samples";
+        samplesDropped_ += lost;
+    }
+}
+
+unsigned int SocketReader::samplesDropped() const
+{
+    if (ring_.ring())
+        return samplesDropped_ + ring_.dropCount();
+    return samplesDropped_;
+}
+
+void SocketReader::addTrace(const SessionFrameView& frame)
+{
+    SessionFrameTrace trace;
+    if (!frame.trace(trace))
+        return;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    latency_.add(trace, (quint64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+bool SocketReader::receive()
+{
+    // Parsed frames are dropped from the front only here, so views
+    // returned by nextFrame() stay valid until the next receive.
+    if (bufferPos_) {
+        memmove(buffer_.data(), buffer_.constData() + bufferPos_, bufferUsed_ - bufferPos_);
+        bufferUsed_ -= bufferPos_;
+        forwarded_ -= bufferPos_;
+        bufferPos_ = 0;
+    }
+
+    bool received = receiveSocket();
+
+    // Followers get the bytes before any frame is parsed out of them.
+    if (bufferUsed_ > forwarded_) {
+        foreach (SocketReader* follower, followers_) {
+            follower->deliver(buffer_.constData() + forwarded_, bufferUsed_ - forwarded_);
+            QMetaObject::invokeMethod(follower, "readyRead", Qt::QueuedConnection);
+        }
+    }
+    forwarded_ = bufferUsed_;
+    return received;
+}
+
+bool SocketReader::receiveSocket()
+{
+    if (multiplexed_)
+        return bufferUsed_ > 0;
+
+    if (receiver_) {
+        receiver_->take(buffer_, bufferUsed_);
+        return bufferUsed_ > 0;
+    }
+
+    if (seqPacket_) {
+        // QLocalSocket reads whole packets, so what it has buffered ends
+        // at a frame boundary. Queued packets follow it.
+        qint64 available = socket_->bytesAvailable();
+        if (available > 0) {
+            if (bufferUsed_ + available > buffer_.size())
+                buffer_.resize(bufferUsed_ + available);
+            qint64 bytes = socket_->read(buffer_.data() + bufferUsed_, available);
+            if (bytes > 0)
+                bufferUsed_ += bytes;
+        }
+        receivePackets();
+        return bufferUsed_ > 0;
+    }
+
+    // QLocalSocket only buffers what arrived before the readiness event.
+    // Frames written while the client was busy are still queued in the
+    // kernel; pull them in too so that they are delivered as one batch
+    // instead of one batch per event loop round.
+    while (socket_->bytesAvailable() < MAX_BATCH_BYTES && socket_->waitForReadyRead(0))
+        ;
+
+    qint64 available = socket_->bytesAvailable();
+    if (available <= 0)
+        return bufferUsed_ > 0;
+    if (bufferUsed_ + available > buffer_.size())
+        buffer_.resize(bufferUsed_ + available);
+
+    qint64 bytes = socket_->read(buffer_.data() + bufferUsed_, available);
+    if (bytes < 0) {
+        qWarning() << "Error occured while reading data from socket: " << socket_->errorString();
+        return false;
+    }
+    bufferUsed_ += bytes;
+    return bufferUsed_ > 0;
+}
+
+bool SocketReader::nextFrame(SessionFrameView& frame, unsigned int sampleSize)
+{
+    switch (frame.parse(buffer_.constData() + bufferPos_, bufferUsed_ - bufferPos_, sampleSize)) {
+    case SessionFrameView::Complete:
+        break;
+    case SessionFrameView::Incomplete:
+        return false;
+    case SessionFrameView::Invalid:
+        qWarning() << "Too many samples waiting in socket. Flushing it to empty";
+        // Samples flushed here show up as a gap in the next frame.
+        if (!multiplexed_ && !receiver_)
+            socket_->readAll();
+        bufferPos_ = 0;
+        bufferUsed_ = 0;
+        forwarded_ = 0;
+        return false;
+    }
+
+    checkSequence(frame.sequence(), frame.count());
+    addTrace(frame);
+    bufferPos_ += frame.totalSize();
+    return true;
+}
+
+void SocketReader::deliver(const char* data, int size)
+{
+    int needed = bufferUsed_ + size;
+    if (needed > buffer_.size())
+        buffer_.resize(qMax(needed, buffer_.size() * 2));
+    memcpy(buffer_.data() + bufferUsed_, data, size);
+    bufferUsed_ = needed;
+}
+
+void SocketReader::addFollower(SocketReader* follower)
+{
+    if (follower == this || followers_.contains(follower))
+        return;
+    follower->bufferPos_ = 0;
+    follower->bufferUsed_ = 0;
+    follower->forwarded_ = 0;
+    // Frames of this session continue a sequence the follower never saw.
+    follower->sequence_.reset();
+    // Start from a frame boundary, with the frame not complete yet.
+    if (forwarded_ > bufferPos_)
+        follower->deliver(buffer_.constData() + bufferPos_, forwarded_ - bufferPos_);
+    followers_.append(follower);
+}
+
+void SocketReader::removeFollower(SocketReader* follower)
+{
+    followers_.removeAll(follower);
+}
+
+const LatencyStatistics& SocketReader::latencyStatistics() const
+{
+    return latency_;
+}
+
+void SocketReader::clearLatencyStatistics()
+{
+    latency_.clear();
+}
+
+SocketMultiplexer::SocketMultiplexer() :
+    socket_(NULL),
+    bufferUsed_(0)
+{
+}
+
+SocketMultiplexer::~SocketMultiplexer()
+{
+}
+
+SocketReceiver::SocketReceiver(QLocalSocket* socket, SocketReader* reader) :
+    socket_(socket),
+    reader_(reader),
+    throttled_(false),
+    notified_(0)
+{
+    // Qt stops reading the socket when its own buffer is full, which
+    // leaves the backlog to sensord while the queue is throttled.
+    socket_->setReadBufferSize(MAX_QUEUED_BYTES);
+    socket_->moveToThread(ioThread());
+    moveToThread(ioThread());
+    connect(socket_, SIGNAL(readyRead()), this, SLOT(readSocket()));
+    // Pick up whatever arrived during the handshake.
+    QMetaObject::invokeMethod(this, "readSocket", Qt::QueuedConnection);
+}
+
+bool SocketReceiver::take(QByteArray& buffer, int& used)
+{
+    // Cleared before taking, so anything queued after the take is
+    // notified again.
+    notified_.fetchAndStoreOrdered(0);
+
+    bool resume;
+    int size;
+    {
+        QMutexLocker locker(&mutex_);
+        size = queue_.size();
+        if (size) {
+            if (used + size > buffer.size())
+                buffer.resize(qMax(used + size, buffer.size() * 2));
+            memcpy(buffer.data() + used, queue_.constData(), size);
+            used += size;
+            queue_.resize(0);
+        }
+        resume = throttled_;
+        throttled_ = false;
+    }
+
+    if (resume)
+        QMetaObject::invokeMethod(this, "readSocket", Qt::QueuedConnection);
+    return size > 0;
+}
+
+void SocketReceiver::close()
+{
+    if (!thread()->isRunning()) {
+        // I/O thread is already stopped on application exit.
+        closeSocket();
+        delete this;
+        return;
+    }
+    if (QThread::currentThread() == thread())
+        closeSocket();
+    else
+        QMetaObject::invokeMethod(this, "closeSocket", Qt::BlockingQueuedConnection);
+    deleteLater();
+}
+
+QThread* SocketReceiver::ioThread()
+{
+    static QThread* thread = NULL;
+    if (!thread) {
+        thread = new QThread;
+        thread->start();
+        qAddPostRoutine(stopIoThread);
+    }
+    return thread;
+}
+
+void SocketReceiver::stopIoThread()
+{
+    QThread* thread = ioThread();
+    thread->quit();
+    thread->wait();
+}
+
+void SocketReceiver::readSocket()
+{
+    if (!socket_)
+        return;
+
+    QMutexLocker locker(&mutex_);
+    if (queue_.size() >= MAX_QUEUED_BYTES) {
+        // Leave the rest in the kernel until the reader catches up.
+        throttled_ = true;
+        return;
+    }
+    qint64 available = socket_->bytesAvailable();
+    if (available <= 0)
+        return;
+    int size = queue_.size();
+    queue_.resize(size + available);
+    qint64 bytes = socket_->read(queue_.data() + size, available);
+    queue_.resize(size + qMax(bytes, (qint64)0));
+    if (bytes < 0) {
+        qWarning() << "Error occured while reading data from socket: " << socket_->errorString();
+        return;
+    }
+    locker.unlock();
+
+    if (notified_.testAndSetOrdered(0, 1))
+        QMetaObject::invokeMethod(reader_, "readyRead", Qt::QueuedConnection);
+}
+
+void SocketReceiver::closeSocket()
+{
+    if (!socket_)
+        return;
+    socket_->disconnectFromServer();
+    if (socket_->state() != QLocalSocket::UnconnectedState)
+        socket_->waitForDisconnected();
+    delete socket_;
+    socket_ = NULL;
+}
+
+SocketMultiplexer* SocketMultiplexer::instance()
+{
+    if (!instance_)
+        instance_ = new SocketMultiplexer();
+    return instance_;
+}
+
+QLocalSocket* SocketMultiplexer::socket() const
+{
+    return socket_;
+}
+
+bool SocketMultiplexer::open(int sessionId)
+{
+    socket_ = new QLocalSocket(this);
+    socket_->connectToServer(SESSION_SOCKET_PATH, QIODevice::ReadWrite);
+
+    char greeting = 0;
+    if (!socket_->waitForReadyRead(MULTIPLEX_REPLY_TIMEOUT) || socket_->read(&greeting, 1) != 1) {
+        qDebug() << "[SOCKETREADER]: No greeting on multiplexed connection: " << socket_->errorString();
+        delete socket_;
+        socket_ = NULL;
+        return false;
+    }
+
+    SessionRequest request;
+    qint64 size = sessionMultiplexEncode(sessionId, request);
+    char reply = 0;
+    if (socket_->write((const char*)&request, size) == size && socket_->flush() &&
+        (socket_->bytesAvailable() || socket_->waitForReadyRead(MULTIPLEX_REPLY_TIMEOUT)))
+        socket_->read(&reply, 1);
+    if (reply != SESSION_MULTIPLEX_ACCEPTED) {
+        qDebug() << "[SOCKETREADER]: Multiplexed connection not accepted";
+        delete socket_;
+        socket_ = NULL;
+        return false;
+    }
+
+    connect(socket_, SIGNAL(readyRead()), this, SLOT(socketReadable()));
+    return true;
+}
+
+bool SocketMultiplexer::attach(int sessionId, SocketReader* reader)
+{
+    if (readers_.contains(sessionId))
+        return false;
+
+    if (!socket_) {
+        if (!open(sessionId)) {
+            if (readers_.isEmpty()) {
+                instance_ = NULL;
+                deleteLater();
+            }
+            return false;
+        }
+    } else {
+        SessionRequest request;
+        qint64 size = sessionMultiplexEncode(sessionId, request);
+        if (socket_->write((const char*)&request, size) != size) {
+            qDebug() << "[SOCKETREADER]: SessionId write failed: " << socket_->errorString();
+            return false;
+        }
+        socket_->flush();
+    }
+
+    readers_.insert(sessionId, reader);
+    return true;
+}
+
+void SocketMultiplexer::detach(int sessionId)
+{
+    readers_.remove(sessionId);
+    if (!readers_.isEmpty())
+        return;
+
+    // Sensord releases the sessions of the connection when it is closed.
+    socket_->disconnectFromServer();
+    instance_ = NULL;
+    deleteLater();
+}
+
+void SocketMultiplexer::socketReadable()
+{
+    while (socket_->bytesAvailable() < MAX_BATCH_BYTES && socket_->waitForReadyRead(0))
+        ;
+
+    qint64 available = socket_->bytesAvailable();
+    if (available <= 0)
+        return;
+    if (bufferUsed_ + available > buffer_.size())
+        buffer_.resize(bufferUsed_ + available);
+    qint64 bytes = socket_->read(buffer_.data() + bufferUsed_, available);
+    if (bytes < 0) {
+        qWarning() << "Error occured while reading data from socket: " << socket_->errorString();
+        return;
+    }
+    bufferUsed_ += bytes;
+
+    QList<int> received;
+    int pos = 0;
+    SessionMultiplexTag tag;
+    while (sessionMultiplexTag(buffer_.constData() + pos, bufferUsed_ - pos, tag)) {
+        QMap<int, SocketReader*>::iterator it = readers_.find(tag.sessionId);
+        if (it != readers_.end()) {
+            (*it)->deliver(buffer_.constData() + pos + sizeof(tag), tag.size);
+            if (!received.contains(tag.sessionId))
+                received.append(tag.sessionId);
+        }
+        pos += sizeof(tag) + tag.size;
+    }
+    memmove(buffer_.data(), buffer_.constData() + pos, bufferUsed_ - pos);
+    bufferUsed_ -= pos;
+
+    // Handlers may release sessions, so look each one up again.
+    foreach (int sessionId, received) {
+        QMap<int, SocketReader*>::iterator it = readers_.find(sessionId);
+        if (it != readers_.end())
+            emit (*it)->readyRead();
+    }
+}
@@ -30,6 +30,17 @@
 #include <QObject>
 #include <QLocalSocket>
 #include <QVector>
+#include <QByteArray>
+#include <QMap>
+#include <QList>
+#include <QMutex>
+#include <QAtomicInt>
+#include <string.h>
+#include "sessionprotocol.h"
+#include "latencystatistics.h"
+
+class SocketMultiplexer;
+class SocketReceiver;
 
 /**
  * @brief Helper class for reading socket datachannel from sensord
@@ -61,9 +72,27 @@ public:
      * Initiates new data socket connection.
      *
      * @param sessionId ID for the current session.
+     * @param sharedMemory request shared memory transport for the
+     *                     session. Falls back to the socket if sensord
+     *                     does not support it.
+     * @param multiplex carry the session on the connection shared by
+     *                  all sessions of the process instead of a
+     *                  connection of its own. Ignored if shared memory
+     *                  is requested.
+     * @param seqPacket connect to the SOCK_SEQPACKET socket of sensord,
+     *                  where every frame is a packet of its own. Falls
+     *                  back to the stream socket if sensord does not
+     *                  listen on it. Ignored if the session is
+     *                  multiplexed.
+     * @param threaded read the socket on the I/O thread shared by all
+     *                 sessions of the process and hand the received
+     *                 bytes over in batches. Only applies to a session
+     *                 with a socket of its own, which is then always a
+     *                 stream socket.
      * @return was the connection established successfully.
      */
-    bool initiateConnection(int sessionId);
+    bool initiateConnection(int sessionId, bool sharedMemory = false, bool multiplex = false,
+                            bool seqPacket = false, bool threaded = false);
 
     /**
      * Drops socket connection.
@@ -73,12 +102,36 @@ public:
 
     /**
      * Provides access to the internal QLocalSocket for direct reading.
+     * A multiplexed session returns the socket shared with the other
+     * sessions, which must not be read directly.
      *
      * @return Pointer to the internal QLocalSocket. Pointer can be \c NULL
      *         if \c initiateConnection() has not been called successfully.
      */
     QLocalSocket* socket();
 
+    /**
+     * Is the session carried by the connection shared by all sessions
+     * of the process.
+     *
+     * @return is session multiplexed.
+     */
+    bool isMultiplexed() const;
+
+    /**
+     * Is the socket read on the I/O thread.
+     *
+     * @return is socket read on the I/O thread.
+     */
+    bool isThreaded() const;
+
+    /**
+     * Is there data left which was not consumed by the last read.
+     *
+     * @return is more data waiting.
+     */
+    bool hasPendingData() const;
+
     /**
      * Attempt to read given number of bytes from the socket. As
      * QLocalSocket is used, we are guaranteed that any number of bytes
@@ -92,8 +145,12 @@ public:
     bool read(void* buffer, int size);
 
     /**
-     * Attempt to read objects from the sockets. The call blocks until
-     * there are minimum amount of expected bytes availabled in the socket.
+     * Attempt to read objects from the sockets. Everything available in
+     * the socket is read into the receive buffer with a single call and
+     * all complete frames in it are appended to the vector. An
+     * incomplete frame is kept for the next call. The vector storage
+     * only grows, so a vector reused with resize(0) between the calls
+     * is not reallocated.
      *
      * @param values Vector to which objects will be appended.
      * @tparam T type of expected object in the stream.
@@ -109,7 +166,71 @@ public:
      */
     bool isConnected();
 
+    /**
+     * Is the session using the shared memory transport.
+     *
+     * @return is shared memory used.
+     */
+    bool isSharedMemory() const;
+
+    /**
+     * Number of samples lost before they could be read. Includes samples
+     * dropped by sensord, samples flushed from the socket because of
+     * read errors or a too large backlog and shared memory ring overruns.
+     *
+     * @return dropped sample count.
+     */
+    unsigned int samplesDropped() const;
+
+    /**
+     * Latencies measured from traced frames. Frames are only traced
+     * after tracing has been enabled for the session in sensord.
+     *
+     * @return latency statistics.
+     */
+    const LatencyStatistics& latencyStatistics() const;
+
+    /**
+     * Forget measured latencies.
+     */
+    void clearLatencyStatistics();
+
+    /**
+     * Hand a copy of everything received to another reader, for a
+     * session shared by several interfaces of the process. The follower
+     * parses the frames on its own, so it must expect the same sample
+     * type. Its receive buffer is cleared first.
+     *
+     * @param follower reader of an interface following this session.
+     */
+    void addFollower(SocketReader* follower);
+
+    /**
+     * Stop handing received data to a reader.
+     *
+     * @param follower reader added with #addFollower().
+     */
+    void removeFollower(SocketReader* follower);
+
+Q_SIGNALS:
+    /**
+     * Emitted when new data is available for reading.
+     */
+    void readyRead();
+
 private:
+    friend class SocketMultiplexer;
+    friend class SocketReceiver;
+
+    /**
+     * Append frames routed to the session by the multiplexed connection
+     * to the receive buffer.
+     *
+     * @param data frame bytes.
+     * @param size number of bytes.
+     */
+    void deliver(const char* data, int size);
+
     /**
      * Prefix text needed to be written to the sensor daemon socket connection
      * when establishing new session.
@@ -121,8 +242,242 @@ private:
      */
     bool readSocketTag();
 
+    /**
+     * Receive and map the shared memory ring sent by sensord as a reply
+     * to the shared memory request.
+     *
+     * @return was the ring mapped.
+     */
+    bool receiveSharedRing();
+
+    /**
+     * Check the frame sequence number against the expected one and
+     * account any gap as dropped samples.
+     *
+     * @param sequence sequence number of the frame.
+     * @param count number of samples in the frame.
+     */
+    void checkSequence(unsigned int sequence, unsigned int count);
+
+    /**
+     * Account the stage timestamps following the samples of a traced
+     * frame.
+     *
+     * @param frame received frame.
+     */
+    void addTrace(const SessionFrameView& frame);
+
+    /**
+     * Append everything available in the socket to the receive buffer.
+     *
+     * @return was anything received.
+     */
+    bool receive();
+
+    /**
+     * Take the next complete frame from the receive buffer. The frame
+     * stays valid until the next #receive(). A corrupted frame flushes
+     * the buffer and the socket.
+     *
+     * @param frame frame to fill.
+     * @param sampleSize size of a single sample.
+     * @return was a complete frame available.
+     */
+    bool nextFrame(SessionFrameView& frame, unsigned int sampleSize);
+
+    /**
+     * Copy samples from the shared memory ring. Samples which got
+     * overwritten by sensord while copying are discarded.
+     *
+     * @param buffer Location for storing the samples.
+     * @param elementSize Expected size of a single sample.
+     * @param maxCount Maximum number of samples to copy.
+     * @return number of samples copied.
+     */
+    int readShared(void* buffer, int elementSize, unsigned int maxCount);
+
+    /**
+     * Connect a socket to the SOCK_SEQPACKET socket of sensord.
+     *
+     * @return was the connection established.
+     */
+    bool connectSeqPacket();
+
+    /**
+     * Receive from the socket into the receive buffer, see #receive().
+     *
+     * @return was anything received.
+     */
+    bool receiveSocket();
+
+    /**
+     * Receive queued packets into the receive buffer, one recv per
+     * packet.
+     *
+     * @return number of bytes received.
+     */
+    qint64 receivePackets();
+
     QLocalSocket* socket_; /**< socket data connection to sensord */
+    SocketReceiver* receiver_; /**< reads socket_ on the I/O thread, if used */
+    bool multiplexed_; /**< is socket_ shared with other sessions */
+    bool seqPacket_; /**< does socket_ carry one frame per packet */
+    int packetSpace_; /**< receive space kept free for a packet */
+    int sessionId_; /**< session ID */
     bool tagRead_; /**< is initial magic byte read from the socket */
+    SharedRingReader ring_; /**< shared memory ring, if used */
+    size_t ringSize_; /**< size of the ring mapping */
+    SessionSequence sequence_; /**< sequence numbers of received frames */
+    unsigned int samplesDropped_; /**< number of samples lost on client side */
+    QByteArray buffer_; /**< receive buffer, only grows */
+    int bufferPos_; /**< start of the first unparsed frame in the buffer */
+    int bufferUsed_; /**< number of received bytes in the buffer */
+    int forwarded_; /**< bytes of the buffer already handed to followers */
+    QList<SocketReader*> followers_; /**< readers of interfaces sharing the session */
+    LatencyStatistics latency_; /**< latencies of traced frames */
+};
+
+/**
+ * @brief Reads the socket of a session on the client I/O thread.
+ *
+ * The socket and the receiver live in a thread shared by all threaded
+ * sessions of the process. Received bytes are appended to a queue which
+ * the SocketReader takes over as a whole on its own thread, so parsing
+ * and signal delivery stay on the thread owning the interface while the
+ * socket is drained even when that thread is busy. Only one readyRead()
+ * is posted for everything queued between two takes.
+ */
+class SocketReceiver : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(SocketReceiver)
+
+public:
+    /**
+     * Constructor. Moves the socket and the receiver to the I/O thread.
+     *
+     * @param socket connected socket without a parent.
+     * @param reader reader to notify about received data.
+     */
+    SocketReceiver(QLocalSocket* socket, SocketReader* reader);
+
+    /**
+     * Append everything queued to a buffer.
+     *
+     * @param buffer buffer to append to.
+     * @param used number of bytes used in the buffer, updated.
+     * @return was anything appended.
+     */
+    bool take(QByteArray& buffer, int& used);
+
+    /**
+     * Close the socket and delete the receiver on the I/O thread. The
+     * reader is not notified after this returns.
+     */
+    void close();
+
+    /**
+     * Thread reading the sockets, started on first use.
+     *
+     * @return I/O thread.
+     */
+    static QThread* ioThread();
+
+private Q_SLOTS:
+    /**
+     * Queue everything available in the socket.
+     */
+    void readSocket();
+
+    /**
+     * Disconnect and delete the socket.
+     */
+    void closeSocket();
+
+private:
+    /**
+     * Stop the I/O thread on application exit.
+     */
+    static void stopIoThread();
+
+    QLocalSocket* socket_; /**< socket read on the I/O thread */
+    SocketReader* reader_; /**< reader notified about received data */
+    QMutex mutex_; /**< guards queue_ and throttled_ */
+    QByteArray queue_; /**< received bytes not yet taken */
+    bool throttled_; /**< did the queue fill up */
+    QAtomicInt notified_; /**< is a readyRead() on its way to the reader */
+};
+
+/**
+ * @brief Data connection shared by all multiplexed sessions of the
+ * process.
+ *
+ * Frames of every session arrive tagged with the session ID and are
+ * routed to the receive buffer of the SocketReader of the session. The
+ * connection is opened with the first session and closed when the last
+ * one is detached.
+ */
+class SocketMultiplexer : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(SocketMultiplexer)
+
+public:
+    /**
+     * Get the connection of the process, creating it if needed.
+     *
+     * @return connection.
+     */
+    static SocketMultiplexer* instance();
+
+    /**
+     * Carry a session on the connection.
+     *
+     * @param sessionId session ID.
+     * @param reader reader receiving the frames of the session.
+     * @return was the session attached.
+     */
+    bool attach(int sessionId, SocketReader* reader);
+
+    /**
+     * Stop carrying a session. Connection is closed after the last
+     * session.
+     *
+     * @param sessionId session ID.
+     */
+    void detach(int sessionId);
+
+    /**
+     * Shared socket.
+     *
+     * @return socket or \c NULL if not connected.
+     */
+    QLocalSocket* socket() const;
+
+private slots:
+    /**
+     * Route received frames to the sessions.
+     */
+    void socketReadable();
+
+private:
+    SocketMultiplexer();
+    ~SocketMultiplexer();
+
+    /**
+     * Connect to sensord and open the first session.
+     *
+     * @param sessionId session ID.
+     * @return was the connection accepted.
+     */
+    bool open(int sessionId);
+
+    static SocketMultiplexer* instance_; /**< connection of the process */
+
+    QLocalSocket* socket_; /**< socket shared by the sessions */
+    QMap<int, SocketReader*> readers_; /**< attached sessions */
+    QByteArray buffer_; /**< receive buffer, only grows */
+    int bufferUsed_; /**< number of received bytes in the buffer */
 };
 
 template<typename T>
@@ -132,26 +487,33 @@ bool SocketReader::read(QVector<T>& values)
         return false;
     }
 
-    unsigned int count;
-    if(!read((void*)&count, sizeof(unsigned int)))
-    {
+    if (ring_.ring()) {
+        // Socket only carries doorbells; the samples are in the ring.
         socket_->readAll();
-        return false;
+        unsigned int available = ring_.available();
+        if (!available)
+            return false;
+        int oldSize = values.size();
+        values.resize(oldSize + available);
+        int count = readShared(values.data() + oldSize, sizeof(T), available);
+        values.resize(oldSize + count);
+        return count > 0;
     }
-    if(count > 1000)
-    {
-        qWarning() << "Too many samples waiting in socket. Flushing it to empty";
-        socket_->readAll();
-        return false;
-    }
-    values.resize(values.size() + count);
-    if(!read((void*)values.data(), sizeof(T) * count))
-    {
-        qWarning() << "Error occured while reading data from socket: " << socket_->errorString();
-        socket_->readAll();
+
+    if (!receive())
         return false;
+
+    int oldSize = values.size();
+    SessionFrameView frame;
+    while (nextFrame(frame, sizeof(T))) {
+        int size = values.size();
+        int needed = size + frame.count();
+        if (values.capacity() < needed)
+            values.reserve(qMax(needed, values.capacity() * 2));
+        values.resize(needed);
+        frame.decode((char*)(values.data() + size));
     }
-    return true;
+    return values.size() > oldSize;
 }
 
 #endif // SOCKETREADER_H
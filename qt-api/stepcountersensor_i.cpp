@@ -0,0 +1,65 @@
+/**
+   @file stepcountersensor_i.cpp
+   @brief StepCounterSensorChannelInterface
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "sensormanagerinterface.h"
+#include "stepcountersensor_i.h"
+
+const char* StepCounterSensorChannelInterface::staticInterfaceName = "local.StepCounterSensor";
+
+AbstractSensorChannelInterface* StepCounterSensorChannelInterface::factoryMethod(const QString& id, int sessionId)
+{
+    return new StepCounterSensorChannelInterface(OBJECT_PATH + "/" + id, sessionId);
+}
+
+StepCounterSensorChannelInterface::StepCounterSensorChannelInterface(const QString& path, int sessionId)
+    : AbstractSensorChannelInterface(path, StepCounterSensorChannelInterface::staticInterfaceName, sessionId)
+{
+}
+
+StepCounterSensorChannelInterface* StepCounterSensorChannelInterface::interface(const QString& id)
+{
+    SensorManagerInterface& sm = SensorManagerInterface::instance();
+    if ( !sm.registeredAndCorrectClassName( id, StepCounterSensorChannelInterface::staticMetaObject.className() ) )
+    {
+        return 0;
+    }
+
+    return dynamic_cast<StepCounterSensorChannelInterface*>(sm.interface(id));
+}
+
+bool StepCounterSensorChannelInterface::dataReceivedImpl()
+{
+    values_.resize(0);
+    if(!read<TimedUnsigned>(values_))
+        return false;
+
+    // Counts are cumulative, only the latest one matters.
+    if (!values_.isEmpty())
+        emit stepsChanged(values_.last());
+    return true;
+}
+
+Unsigned StepCounterSensorChannelInterface::steps()
+{
+    return getAccessor<Unsigned>("steps");
+}
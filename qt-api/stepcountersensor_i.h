@@ -0,0 +1,101 @@
+/**
+   @file stepcountersensor_i.h
+   @brief StepCounterSensorChannelInterface
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef STEPCOUNTERSENSOR_I_H
+#define STEPCOUNTERSENSOR_I_H
+
+#include <QtDBus/QtDBus>
+#include <QVector>
+
+#include "datatypes/unsigned.h"
+#include "abstractsensor_i.h"
+
+/**
+ * Client interface for the cumulative step count. Updates only arrive
+ * when the count changes and are batched by sensord, clients do not
+ * need a continuous accelerometer stream to count steps.
+ */
+class StepCounterSensorChannelInterface : public AbstractSensorChannelInterface
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(StepCounterSensorChannelInterface)
+    Q_PROPERTY(Unsigned steps READ steps)
+
+public:
+    /**
+     * Name of the D-Bus interface for this class.
+     */
+    static const char* staticInterfaceName;
+
+    /**
+     * Create new instance of the class.
+     *
+     * @param id Sensor ID.
+     * @param sessionId Session ID.
+     * @return Pointer to new instance of the class.
+     */
+    static AbstractSensorChannelInterface* factoryMethod(const QString& id, int sessionId);
+
+    /**
+     * Get latest step count from sensor daemon.
+     *
+     * @return cumulative steps.
+     */
+    Unsigned steps();
+
+    /**
+     * Constructor.
+     *
+     * @param path      path.
+     * @param sessionId session id.
+     */
+    StepCounterSensorChannelInterface(const QString& path, int sessionId);
+
+    /**
+     * Request an interface to the sensor.
+     *
+     * @param id sensor ID.
+     * @return Pointer to interface, or NULL on failure.
+     */
+    static StepCounterSensorChannelInterface* interface(const QString& id);
+
+protected:
+    virtual bool dataReceivedImpl();
+
+private:
+    QVector<TimedUnsigned> values_; /**< receive buffer, reused between reads */
+
+Q_SIGNALS:
+    /**
+     * Sent when the step count has changed.
+     *
+     * @param value cumulative steps.
+     */
+    void stepsChanged(const Unsigned& value);
+};
+
+namespace local {
+  typedef ::StepCounterSensorChannelInterface StepCounterSensor;
+}
+
+#endif
@@ -66,10 +66,10 @@ TapSensorChannelInterface* TapSensorChannelInterface::interface(const QString& i
 
 bool TapSensorChannelInterface::dataReceivedImpl()
 {
-    QVector<TapData> values;
-    if(!read<TapData>(values))
+    values_.resize(0);
+    if(!read<TapData>(values_))
         return false;
-    foreach(TapData value, values) {
+    foreach(TapData value, values_) {
         if (type_ == Single) {
             emit dataAvailable(Tap(value));
         } else if (timer_->isActive()) {
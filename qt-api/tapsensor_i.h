@@ -134,6 +134,7 @@ Q_SIGNALS:
 
 private:
 
+    QVector<TapData> values_; /**< receive buffer, reused between reads */
     QList<TapData> tapValues_; /**< buffer of received tap values. */
     TapSelection type_; /**< tap type to listen for. */
     QTimer *timer_; /**< timer for doubletap detection. */
@@ -18,6 +18,7 @@ Source0:    %{name}-%{version}.tar.bz2
 Source1:    sensorfw-rpmlintrc
 Source2:    sensord.service
 Source3:    sensord-daemon-conf-setup
+Source4:    sensord.socket
 Source100:  sensorfw-qt5.yaml
 Requires:   qt5-qtcore
 Requires:   GConf-dbus
@@ -33,6 +34,7 @@ BuildRequires:  pkgconfig(Qt5DBus)
 BuildRequires:  pkgconfig(Qt5Network)
 BuildRequires:  pkgconfig(Qt5Test)
 BuildRequires:  pkgconfig(gconf-2.0)
+BuildRequires:  pkgconfig(dbus-1)
 Provides:   sensord-qt5
 Obsoletes:   sensorframework
 
@@ -114,9 +116,10 @@ export QT_SELECT=5
 # >> install post
 install -D -m644 %{SOURCE2} $RPM_BUILD_ROOT/%{_lib}/systemd/system/sensord.service
 install -D -m750 %{SOURCE3} $RPM_BUILD_ROOT/%{_bindir}/sensord-daemon-conf-setup
+install -D -m644 %{SOURCE4} $RPM_BUILD_ROOT/%{_lib}/systemd/system/sensord.socket
 
-mkdir -p %{buildroot}/%{_lib}/systemd/system/basic.target.wants
-ln -s ../sensord.service %{buildroot}/%{_lib}/systemd/system/basic.target.wants/sensord.service
+mkdir -p %{buildroot}/%{_lib}/systemd/system/sockets.target.wants
+ln -s ../sensord.socket %{buildroot}/%{_lib}/systemd/system/sockets.target.wants/sensord.socket
 # << install post
 
 %preun
@@ -151,7 +154,9 @@ systemctl daemon-reload
 %config %{_sysconfdir}/sensorfw/sensord.conf
 %dir %{_sysconfdir}/sensorfw/sensord.conf.d/
 /%{_lib}/systemd/system/sensord.service
-/%{_lib}/systemd/system/basic.target.wants/sensord.service
+/%{_lib}/systemd/system/sensord.socket
+/%{_lib}/systemd/system/sockets.target.wants/sensord.socket
+%{_datadir}/dbus-1/system-services/com.nokia.SensorService.service
 %{_bindir}/sensord-daemon-conf-setup
 # << files
 
@@ -32,6 +32,7 @@
 #include "config.h"
 
 const QString CalibrationHandler::SENSOR_NAME("magnetometersensor");
+const int CalibrationHandler::FULL_CALIBRATION_LEVEL = 3;
 
 CalibrationHandler::CalibrationHandler(QObject* parent) :
     QObject(parent),
@@ -88,6 +89,16 @@ void CalibrationHandler::sampleReceived(const MagneticField& sample)
         m_level = sample.level();
         m_timer.start(m_calibTimeout);
     }
+
+    // Nothing more to gain once fully calibrated.
+    if (m_sensor && m_level >= FULL_CALIBRATION_LEVEL && m_timer.isActive())
+    {
+        m_timer.stop();
+        sensordLogD() << "Stopping magnetometer background calibration, fully calibrated.";
+        m_sensor->setStandbyOverrideRequest(m_sessionId, false);
+        m_sensor->stop();
+        disconnect(m_sensor, SIGNAL(internalData(const MagneticField&)), this, SLOT(sampleReceived(const MagneticField&)));
+    }
 }
 
 void CalibrationHandler::stopCalibration()
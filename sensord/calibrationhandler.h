@@ -87,6 +87,7 @@ private slots:
 
 private:
     static const QString       SENSOR_NAME;    /**< magnetometer sensor name */
+    static const int           FULL_CALIBRATION_LEVEL; /**< level at which calibration stops early */
 
     MagnetometerSensorChannel* m_sensor;       /**< magnetometer sensor channel */
     int                        m_sessionId;    /**< session ID */
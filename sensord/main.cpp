@@ -36,11 +36,19 @@
 #include <errno.h>
 
 #include "config.h"
+#include "nodestatistics.h"
+#include "sampletrace.h"
+#include "cpuboost.h"
 #include "sensormanager.h"
 #include "sensormanager_a.h"
 #include "logging.h"
 #include "calibrationhandler.h"
 #include "parser.h"
+#include "threadscheduling.h"
+#include "realtimememory.h"
+#ifdef SENSORD_STATIC_PLUGINS
+#include "staticplugins.h"
+#endif
 
 void printUsage();
 
@@ -61,11 +69,23 @@ void signalUSR2(int param)
 
     output.append("Flushing sensord state\n");
     output.append(QString("  Logging level: %1\n").arg(SensordLogger::getOutputLevel()));
+    output.append(QString("  Dropped log messages: %1\n").arg(SensordLogger::droppedMessages()));
     SensorManager::instance().printStatus(output);
 
     foreach (const QString& line, output) {
         sensordLogW() << line.toLocal8Bit().data();
     }
+
+    // Dump from the event loop, not inside the handler.
+    QMetaObject::invokeMethod(&SensorManager::instance(), "dumpFlightRecorders", Qt::QueuedConnection);
+}
+
+void signalHUP(int param)
+{
+    Q_UNUSED(param);
+
+    // Reload from the event loop, not inside the handler.
+    QMetaObject::invokeMethod(&SensorManager::instance(), "reloadConfiguration", Qt::QueuedConnection);
 }
 
 void signalINT(int param)
@@ -109,7 +129,18 @@ int main(int argc, char *argv[])
         defConfigDir = parser.configDirPath();
     }
 
-    if (!Config::loadConfig(defConfigFile, defConfigDir))
+    if (parser.compileConfig())
+    {
+        if (parser.configCachePath().isEmpty() ||
+            !Config::compileConfig(defConfigFile, defConfigDir, parser.configCachePath()))
+        {
+            sensordLogC() << "Compiling configuration failed";
+            return 1;
+        }
+        return 0;
+    }
+
+    if (!Config::loadConfig(defConfigFile, defConfigDir, parser.configCachePath()))
     {
         sensordLogC() << "Config file error! Load using default paths.";
         if (!Config::loadConfig(CONFIG_FILE_PATH, CONFIG_DIR_PATH))
@@ -119,9 +150,24 @@ int main(int argc, char *argv[])
         }
     }
 
+#ifdef SENSORD_STATIC_PLUGINS
+    registerStaticPlugins();
+#endif
+
+    NodeStatistics::setEnabled(Config::configuration()->value<bool>("global/node_statistics", false));
+
+    QString traceMarker = Config::configuration()->value<QString>("global/trace_marker", "");
+    if (!traceMarker.isEmpty())
+        SampleTrace::openMarker(traceMarker);
+
+    // Read boost hooks and bind their release timers to the main thread.
+    CpuBoost::instance();
+
     signal(SIGUSR1, signalUSR1);
     signal(SIGUSR2, signalUSR2);
+    signal(SIGHUP, signalHUP);
     signal(SIGINT, signalINT);
+    signal(SIGTERM, signalINT);
 
 #ifdef PROVIDE_CONTEXT_INFO
     if (parser.contextInfo())
@@ -131,6 +177,13 @@ int main(int argc, char *argv[])
     }
 #endif
 
+    QVariant preload = Config::configuration()->value("global/preload_plugins");
+    QStringList preloadPlugins = preload.type() == QVariant::StringList ?
+                                 preload.toStringList() :
+                                 preload.toString().split(',', QString::SkipEmptyParts);
+    if (!preloadPlugins.isEmpty())
+        sensordLogD() << "Preloading plugins " << sm.loadPlugins(preloadPlugins);
+
     
     if (parser.createDaemon())
     {
@@ -146,6 +199,19 @@ int main(int argc, char *argv[])
         }
     }
 
+    // Keep log output off the sensor threads. Threads do not survive
+    // fork(), so the writer is started only now.
+    SensordLogger::setAsynchronous(true);
+
+    // Memory locks are not inherited by the daemon either.
+    if (parser.realtimeMemory() || Config::configuration()->value<bool>("global/realtime_memory", false))
+    {
+        if (RealtimeMemory::enable())
+            sm.reserveSessionBuffers();
+    }
+
+    ThreadScheduling::apply("mainthread");
+
     if (parser.magnetometerCalibration())
     {
         CalibrationHandler* calibrationHandler_ = new CalibrationHandler(NULL);
@@ -162,6 +228,7 @@ int main(int argc, char *argv[])
 
     int ret = app.exec();
     sensordLogD() << "Exiting...";
+    SampleTrace::closeMarker();
     Config::close();
     SensordLogger::close();
     return ret;
@@ -180,9 +247,16 @@ void printUsage()
     qDebug() << " --log-file-path=<path>           Log file path\n";
     qDebug() << " -c=P, --config-file=<path>       Load configuration from given path. By default";
     qDebug() << "                                  /etc/sensorfw/sensord.conf is used.\n";
+    qDebug() << " --config-cache=<path>            Read configuration compiled to given path when it";
+    qDebug() << "                                  is up to date, otherwise compile it there.\n";
+    qDebug() << " --compile-config                 Compile configuration to the --config-cache path";
+    qDebug() << "                                  and exit.\n";
     qDebug() << " --no-context-info                Do not provide context information for context";
     qDebug() << "                                  framework.\n";
     qDebug() << " --no-magnetometer-bg-calibration Do not start calibration of magnetometer in";
     qDebug() << "                                  the background.\n";
+    qDebug() << " --realtime-memory                Lock all memory and prefault buffers and thread";
+    qDebug() << "                                  stacks, so that the sample path does not take";
+    qDebug() << "                                  page faults.\n";
     qDebug() << " -h, --help                       Show usage info and exit.";
 }
@@ -35,6 +35,8 @@ Parser::Parser(QStringList arguments) :
     configDir_(false),
     daemon_(false),
     magnetometerCalibration_(true),
+    realtimeMemory_(false),
+    compileConfig_(false),
     configFilePath_(""),
     logLevel_(SensordLogWarning),
     logTarget_(8),
@@ -92,10 +94,19 @@ void Parser::parsingCommandLine(QStringList arguments)
             configDir_ = true;
             configDirPath_ = data.at(1);
         }
+        else if (opt.startsWith("--config-cache"))
+        {
+            data = opt.split("=");
+            configCachePath_ = data.at(1);
+        }
+        else if (opt.startsWith("--compile-config"))
+            compileConfig_ = true;
         else if (opt.startsWith("--no-context-info"))
             contextInfo_ = false;
         else if (opt.startsWith("--no-magnetometer-bg-calibration"))
             magnetometerCalibration_ = false;
+        else if (opt.startsWith("--realtime-memory"))
+            realtimeMemory_ = true;
         else if (opt.startsWith("-d") || opt.startsWith("--daemon"))
             daemon_ = true;
         else if (opt.startsWith("-h") || opt.startsWith("--help"))
@@ -140,6 +151,16 @@ const QString& Parser::configDirPath() const
     return configDirPath_;
 }
 
+const QString& Parser::configCachePath() const
+{
+    return configCachePath_;
+}
+
+bool Parser::compileConfig() const
+{
+    return compileConfig_;
+}
+
 bool Parser::contextInfo() const
 {
     return contextInfo_;
@@ -155,6 +176,11 @@ bool Parser::createDaemon() const
     return daemon_;
 }
 
+bool Parser::realtimeMemory() const
+{
+    return realtimeMemory_;
+}
+
 int Parser::logTarget() const
 {
     return logTarget_;
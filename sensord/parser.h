@@ -45,10 +45,13 @@ public:
     const QString& configFilePath() const;
     bool configDirInput() const;
     const QString& configDirPath() const;
+    const QString& configCachePath() const;
+    bool compileConfig() const;
 
     bool contextInfo() const;
     bool magnetometerCalibration() const;
     bool createDaemon() const;
+    bool realtimeMemory() const;
     int logTarget() const;
     const QString& logFilePath() const;
 
@@ -62,9 +65,12 @@ private:
     bool configDir_;
     bool daemon_;
     bool magnetometerCalibration_;
+    bool realtimeMemory_;
+    bool compileConfig_;
 
     QString configFilePath_;
     QString configDirPath_;
+    QString configCachePath_;
     SensordLogLevel logLevel_;
     int logTarget_; //TODO: add some enum about log targets
     QString logFilePath_;
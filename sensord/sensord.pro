@@ -36,6 +36,22 @@ SOURCES += main.cpp \
 HEADERS += parser.h \
            calibrationhandler.h
 
+static_plugins:equals(QT_MAJOR_VERSION, 5) {
+    # List of the linked plugins for staticplugins.cpp
+    STATIC_PLUGIN_LIST =
+    for(entry, SENSORFW_STATIC_PLUGINS) {
+        LIBS += -L../$$section(entry, :, 1, 1) -l$$section(entry, :, 0, 0)-qt5
+        STATIC_PLUGIN_LIST += "SENSORD_STATIC_PLUGIN($$section(entry, :, 0, 0), $$section(entry, :, 2, 2))"
+    }
+    write_file($$OUT_PWD/staticpluginlist.h, STATIC_PLUGIN_LIST)
+
+    INCLUDEPATH += $$OUT_PWD
+    DEFINES += SENSORD_STATIC_PLUGINS
+    CONFIG += ltcg
+    SOURCES += staticplugins.cpp
+    HEADERS += staticplugins.h
+}
+
 contextprovider {
     DEFINES += PROVIDE_CONTEXT_INFO
     PKGCONFIG += contextprovider-1.0
@@ -0,0 +1,42 @@
+/**
+   @file staticplugins.cpp
+   @brief Plugins linked into sensord
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include <QtPlugin>
+
+#include "staticplugins.h"
+#include "loader.h"
+
+// staticpluginlist.h is generated by sensord.pro and holds one
+// SENSORD_STATIC_PLUGIN(name, class) line for each linked plugin.
+
+#define SENSORD_STATIC_PLUGIN(name, className) Q_IMPORT_PLUGIN(className)
+#include "staticpluginlist.h"
+#undef SENSORD_STATIC_PLUGIN
+
+void registerStaticPlugins()
+{
+    Loader& loader = Loader::instance();
+#define SENSORD_STATIC_PLUGIN(name, className) loader.registerStaticPlugin(#name, #className);
+#include "staticpluginlist.h"
+#undef SENSORD_STATIC_PLUGIN
+}
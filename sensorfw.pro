@@ -7,10 +7,18 @@ SUBDIRS = datatypes \
           sensors \
           sensord \
           qt-api \
+          c-api \
+          embedded \
+          qml \
           chains \
           tests \
           examples
 
+# Statically linked plugins have to be built before sensord
+static_plugins {
+    SUBDIRS = datatypes adaptors core filters sensors chains sensord qt-api c-api embedded qml tests examples
+}
+
 equals(QT_MAJOR_VERSION, 4): {
     SUBDIRS = datatypes qt-api
 }
@@ -27,6 +35,7 @@ contains(CONFIG,hybris) {
     QTCONFIGFILES.files = sensord.prf
 
     qt-api.depends = datatypes
+    qml.depends = qt-api
     sensord.depends = datatypes adaptors sensors chains
 
     #include( doc/doc.pri )
@@ -62,13 +71,16 @@ equals(QT_MAJOR_VERSION, 5):  {
         DBUSCONFIGFILES.files = sensorfw.conf
         DBUSCONFIGFILES.path = /etc/dbus-1/system.d
 
+        DBUSSERVICEFILES.files = com.nokia.SensorService.service
+        DBUSSERVICEFILES.path = /usr/share/dbus-1/system-services
+
         SENSORDCONFIGFILE.files = config/sensor*.conf
         SENSORDCONFIGFILE.path = /etc/sensorfw
 
         SENSORDCONFIGFILES.files = config/90-sensord-default.conf
         SENSORDCONFIGFILES.path = /etc/sensorfw/sensord.conf.d
 
-        INSTALLS += DBUSCONFIGFILES SENSORDCONFIGFILE SENSORDCONFIGFILES
+        INSTALLS += DBUSCONFIGFILES DBUSSERVICEFILES SENSORDCONFIGFILE SENSORDCONFIGFILES
     }
 }
 
@@ -0,0 +1,100 @@
+/**
+   @file accelerometerfloatsensor.cpp
+   @brief AccelerometerFloatSensor
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "accelerometerfloatsensor.h"
+
+#include "sensormanager.h"
+#include "bin.h"
+
+AccelerometerFloatSensorChannel::AccelerometerFloatSensorChannel(const QString& id) :
+        AbstractSensorChannel(id),
+        DataEmitter<AccelerationFloatData>(32)
+{
+    SensorManager& sm = SensorManager::instance();
+
+    accelerometerChain_ = sm.requestChain("accelerometerchain");
+    Q_ASSERT( accelerometerChain_ );
+    setValid(accelerometerChain_->isValid() &&
+             accelerometerChain_->findBuffer("accelerometerfloat"));
+
+    marshallingBin_ = Bin::create(id);
+    marshallingBin_->add(this, "sensorchannel");
+
+    if (isValid())
+        connectToSource(accelerometerChain_, "accelerometerfloat", this);
+
+    // Set MetaData
+    setDescription("x, y, and z axes accelerations in m/s^2");
+    setRangeSource(accelerometerChain_);
+    addStandbyOverrideSource(accelerometerChain_);
+    setIntervalSource(accelerometerChain_);
+}
+
+AccelerometerFloatSensorChannel::~AccelerometerFloatSensorChannel()
+{
+    SensorManager& sm = SensorManager::instance();
+
+    if (isValid())
+        disconnectFromSource(accelerometerChain_, "accelerometerfloat", this);
+
+    sm.releaseChain("accelerometerchain");
+
+    delete marshallingBin_;
+}
+
+bool AccelerometerFloatSensorChannel::start()
+{
+    sensordLogD() << "Starting AccelerometerFloatSensorChannel";
+
+    if (AbstractSensorChannel::start()) {
+        marshallingBin_->start();
+        accelerometerChain_->start();
+    }
+    return true;
+}
+
+bool AccelerometerFloatSensorChannel::stop()
+{
+    sensordLogD() << "Stopping AccelerometerFloatSensorChannel";
+
+    if (AbstractSensorChannel::stop()) {
+        accelerometerChain_->stop();
+        marshallingBin_->stop();
+    }
+    return true;
+}
+
+void AccelerometerFloatSensorChannel::emitData(const AccelerationFloatData& value)
+{
+    downsampleAndPropagate(value, downsampleBuffer_);
+}
+
+void AccelerometerFloatSensorChannel::emitBatch(const AccelerationFloatData* values, unsigned n)
+{
+    downsampleAndPropagate(values, n, downsampleBuffer_);
+}
+
+bool AccelerometerFloatSensorChannel::downsamplingSupported() const
+{
+    return true;
+}
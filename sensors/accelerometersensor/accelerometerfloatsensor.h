@@ -0,0 +1,80 @@
+/**
+   @file accelerometerfloatsensor.h
+   @brief AccelerometerFloatSensor
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef ACCELEROMETER_FLOAT_SENSOR_CHANNEL_H
+#define ACCELEROMETER_FLOAT_SENSOR_CHANNEL_H
+
+#include "abstractsensor.h"
+#include "abstractchain.h"
+#include "accelerometerfloatsensor_a.h"
+#include "dataemitter.h"
+#include "datatypes/orientationdata.h"
+
+class Bin;
+
+/**
+ * @brief Sensor providing accelerometer measurements in m/s^2.
+ *
+ * Same measurements as #AccelerometerSensorChannel, but as floats in
+ * the units the hardware reports, without rounding to milli-G. Only
+ * valid when the accelerometer adaptor offers float samples.
+ */
+class AccelerometerFloatSensorChannel :
+        public AbstractSensorChannel,
+        public DataEmitter<AccelerationFloatData>
+{
+    Q_OBJECT;
+
+public:
+    /**
+     * Factory method for AccelerometerFloatSensorChannel.
+     * @return new AccelerometerFloatSensorChannel as AbstractSensorChannel*.
+     */
+    static AbstractSensorChannel* factoryMethod(const QString& id)
+    {
+        AccelerometerFloatSensorChannel* sc = new AccelerometerFloatSensorChannel(id);
+        new AccelerometerFloatSensorChannelAdaptor(sc);
+
+        return sc;
+    }
+
+    virtual bool downsamplingSupported() const;
+
+public Q_SLOTS:
+    bool start();
+    bool stop();
+
+protected:
+    AccelerometerFloatSensorChannel(const QString& id);
+    virtual ~AccelerometerFloatSensorChannel();
+
+private:
+    Bin*                                    marshallingBin_;
+    AbstractChain*                          accelerometerChain_;
+    DownsampleBuffer<AccelerationFloatData> downsampleBuffer_;
+
+    void emitData(const AccelerationFloatData& value);
+    void emitBatch(const AccelerationFloatData* values, unsigned n);
+};
+
+#endif
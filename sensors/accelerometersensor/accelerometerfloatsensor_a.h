@@ -0,0 +1,46 @@
+/**
+   @file accelerometerfloatsensor_a.h
+   @brief D-Bus adaptor for AccelerometerFloatSensor
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef ACCELEROMETER_FLOAT_SENSOR_H
+#define ACCELEROMETER_FLOAT_SENSOR_H
+
+#include <QtDBus/QtDBus>
+
+#include "abstractsensor_a.h"
+
+/**
+ * D-Bus adaptor of AccelerometerFloatSensorChannel. Samples only go
+ * through the data socket, so there is nothing beyond the common
+ * sensor interface.
+ */
+class AccelerometerFloatSensorChannelAdaptor : public AbstractSensorChannelAdaptor
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(AccelerometerFloatSensorChannelAdaptor)
+    Q_CLASSINFO("D-Bus Interface", "local.AccelerometerFloatSensor")
+
+public:
+    AccelerometerFloatSensorChannelAdaptor(QObject* parent);
+};
+
+#endif
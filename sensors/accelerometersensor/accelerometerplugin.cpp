@@ -26,6 +26,7 @@
 
 #include "accelerometerplugin.h"
 #include "accelerometersensor.h"
+#include "accelerometerfloatsensor.h"
 #include "sensormanager.h"
 #include "logging.h"
 
@@ -34,6 +35,7 @@ void AccelerometerPlugin::Register(class Loader&)
     sensordLogD() << "registering accelerometersensor";
     SensorManager& sm = SensorManager::instance();
     sm.registerSensor<AccelerometerSensorChannel>("accelerometersensor");
+    sm.registerSensor<AccelerometerFloatSensorChannel>("accelerometerfloatsensor");
 }
 
 QStringList AccelerometerPlugin::Dependencies() {
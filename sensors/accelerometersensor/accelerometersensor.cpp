@@ -29,11 +29,10 @@
 
 #include "sensormanager.h"
 #include "bin.h"
-#include "bufferreader.h"
 
 AccelerometerSensorChannel::AccelerometerSensorChannel(const QString& id) :
         AbstractSensorChannel(id),
-        DataEmitter<AccelerationData>(1),
+        DataEmitter<AccelerationData>(32),
         previousSample_(0,0,0,0)
 {
     SensorManager& sm = SensorManager::instance();
@@ -42,25 +41,12 @@ AccelerometerSensorChannel::AccelerometerSensorChannel(const QString& id) :
     Q_ASSERT( accelerometerChain_ );
     setValid(accelerometerChain_->isValid());
 
-    accelerometerReader_ = new BufferReader<AccelerationData>(1);
-
-    outputBuffer_ = new RingBuffer<AccelerationData>(1);
-
-    // Create buffers for filter chain
-    filterBin_ = new Bin;
-
-    filterBin_->add(accelerometerReader_, "accelerometer");
-    filterBin_->add(outputBuffer_, "buffer");
-
-    filterBin_->join("accelerometer", "source", "buffer", "sink");
-
-    // Join datasources to the chain
-    connectToSource(accelerometerChain_, "accelerometer", accelerometerReader_);
-
-    marshallingBin_ = new Bin;
+    marshallingBin_ = Bin::create(id);
     marshallingBin_->add(this, "sensorchannel");
 
-    outputBuffer_->join(this);
+    // Chain output is passed on as is, so read it directly instead of
+    // copying it into a private buffer first.
+    connectToSource(accelerometerChain_, "accelerometer", this);
 
     // Set MetaData
     setDescription("x, y, and z axes accelerations in mG");
@@ -73,14 +59,11 @@ AccelerometerSensorChannel::~AccelerometerSensorChannel()
 {
     SensorManager& sm = SensorManager::instance();
 
-    disconnectFromSource(accelerometerChain_, "accelerometer", accelerometerReader_);
+    disconnectFromSource(accelerometerChain_, "accelerometer", this);
 
     sm.releaseChain("accelerometerchain");
 
-    delete accelerometerReader_;
-    delete outputBuffer_;
     delete marshallingBin_;
-    delete filterBin_;
 }
 
 bool AccelerometerSensorChannel::start()
@@ -89,7 +72,6 @@ bool AccelerometerSensorChannel::start()
 
     if (AbstractSensorChannel::start()) {
         marshallingBin_->start();
-        filterBin_->start();
         accelerometerChain_->start();
     }
     return true;
@@ -101,7 +83,6 @@ bool AccelerometerSensorChannel::stop()
 
     if (AbstractSensorChannel::stop()) {
         accelerometerChain_->stop();
-        filterBin_->stop();
         marshallingBin_->stop();
     }
     return true;
@@ -113,13 +94,26 @@ void AccelerometerSensorChannel::emitData(const AccelerationData& value)
     downsampleAndPropagate(value, downsampleBuffer_);
 }
 
-void AccelerometerSensorChannel::removeSession(int sessionId)
+void AccelerometerSensorChannel::emitBatch(const AccelerationData* values, unsigned n)
 {
-    downsampleBuffer_.remove(sessionId);
-    AbstractSensorChannel::removeSession(sessionId);
+    previousSample_ = values[n - 1];
+    downsampleAndPropagate(values, n, downsampleBuffer_);
 }
 
 bool AccelerometerSensorChannel::downsamplingSupported() const
 {
     return true;
 }
+
+int AccelerometerSensorChannel::predicateAxes() const
+{
+    return 3;
+}
+
+void AccelerometerSensorChannel::sampleAxes(const void* source, double* axes) const
+{
+    const AccelerationData* sample = (const AccelerationData*)source;
+    axes[0] = sample->x_;
+    axes[1] = sample->y_;
+    axes[2] = sample->z_;
+}
@@ -35,8 +35,6 @@
 #include "datatypes/orientationdata.h"
 
 class Bin;
-template <class TYPE> class BufferReader;
-class FilterBase;
 
 
 /**
@@ -67,8 +65,6 @@ public:
 
     XYZ get() const { return previousSample_; }
 
-    virtual void removeSession(int sessionId);
-
     virtual bool downsamplingSupported() const;
 
 public Q_SLOTS:
@@ -86,17 +82,18 @@ protected:
     AccelerometerSensorChannel(const QString& id);
     virtual ~AccelerometerSensorChannel();
 
+    virtual int predicateAxes() const;
+    virtual void sampleAxes(const void* source, double* axes) const;
+
 private:
     static double                    aconv_[3][3];
-    Bin*                             filterBin_;
     Bin*                             marshallingBin_;
     AbstractChain*                   accelerometerChain_;
-    BufferReader<AccelerationData>*  accelerometerReader_;
-    RingBuffer<AccelerationData>*    outputBuffer_;
     AccelerationData                 previousSample_;
     TimedXyzDownsampleBuffer         downsampleBuffer_;
 
     void emitData(const AccelerationData& value);
+    void emitBatch(const AccelerationData* values, unsigned n);
 };
 
 #endif
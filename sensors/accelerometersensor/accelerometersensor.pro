@@ -2,10 +2,14 @@ TARGET       = accelerometersensor
 
 HEADERS += accelerometersensor.h   \
            accelerometersensor_a.h \
+           accelerometerfloatsensor.h \
+           accelerometerfloatsensor_a.h \
            accelerometerplugin.h
 
 SOURCES += accelerometersensor.cpp   \
            accelerometersensor_a.cpp \
+           accelerometerfloatsensor.cpp \
+           accelerometerfloatsensor_a.cpp \
            accelerometerplugin.cpp
 
 include( ../sensor-config.pri )
@@ -29,6 +29,8 @@
 #include "bin.h"
 #include "bufferreader.h"
 #include "datatypes/orientation.h"
+#include "config.h"
+#include <math.h>
 
 #ifdef PROVIDE_CONTEXT_INFO
 #include "serviceinfo.h"
@@ -37,7 +39,14 @@
 ALSSensorChannel::ALSSensorChannel(const QString& id) :
         AbstractSensorChannel(id),
         DataEmitter<TimedUnsigned>(1),
-        previousValue_(0,0)
+        previousValue_(0,0),
+        adaptiveInterval_(Config::configuration()->value<unsigned int>(this->id() + "/adaptive_interval", 0)),
+        adaptiveThreshold_(Config::configuration()->value<qreal>(this->id() + "/adaptive_threshold", 0.01)),
+        adaptiveValid_(false),
+        adaptiveSlow_(false),
+        logMean_(0),
+        logVariance_(0),
+        steadySamples_(0)
 #ifdef PROVIDE_CONTEXT_INFO
         ,service(QDBusConnection::systemBus()),
         isDarkProperty(service, "Environment.IsDark"),
@@ -51,24 +60,19 @@ ALSSensorChannel::ALSSensorChannel(const QString& id) :
 
     alsReader_ = new BufferReader<TimedUnsigned>(1);
 
-    outputBuffer_ = new RingBuffer<TimedUnsigned>(1);
+    outputSink_ = new EmitterSink<TimedUnsigned>(this);
 
     // Create buffers for filter chain
-    filterBin_ = new Bin;
+    filterBin_ = Bin::create(id);
 
     filterBin_->add(alsReader_, "als");
-    filterBin_->add(outputBuffer_, "buffer");
+    filterBin_->add(outputSink_, "buffer");
 
     filterBin_->join("als", "source", "buffer", "sink");
 
     // Join datasources to the chain
     connectToSource(alsAdaptor_, "als", alsReader_);
 
-    marshallingBin_ = new Bin;
-    marshallingBin_->add(this, "sensorchannel");
-
-    outputBuffer_->join(this);
-
 #ifdef PROVIDE_CONTEXT_INFO
     // Start listening to context clients. When a client comes, we
     // start the sensor channel, and when we no more have clients, we
@@ -100,8 +104,7 @@ ALSSensorChannel::~ALSSensorChannel()
     sm.releaseDeviceAdaptor("alsadaptor");
 
     delete alsReader_;
-    delete outputBuffer_;
-    delete marshallingBin_;
+    delete outputSink_;
     delete filterBin_;
 }
 
@@ -110,9 +113,8 @@ bool ALSSensorChannel::start()
     sensordLogD() << "Starting ALSSensorChannel";
 
     if (AbstractSensorChannel::start()) {
-        marshallingBin_->start();
         filterBin_->start();
-        alsAdaptor_->startSensor();
+        alsAdaptor_->acquireSensor();
     }
     return true;
 }
@@ -122,20 +124,74 @@ bool ALSSensorChannel::stop()
     sensordLogD() << "Stopping ALSSensorChannel";
 
     if (AbstractSensorChannel::stop()) {
-        alsAdaptor_->stopSensor();
+        alsAdaptor_->releaseSensor();
         filterBin_->stop();
-        marshallingBin_->stop();
+        adaptiveValid_ = false;
+        if (adaptiveSlow_) {
+            adaptiveSlow_ = false;
+            setIntervalFloor(0);
+        }
     }
     return true;
 }
 
-void ALSSensorChannel::emitData(const TimedUnsigned& value)
+void ALSSensorChannel::applyIntervalFloor()
+{
+    // Latest decision wins, earlier queued calls may still arrive.
+    setIntervalFloor(adaptiveSlow_ ? adaptiveInterval_ : 0);
+}
+
+void ALSSensorChannel::adaptInterval(unsigned int lux)
 {
-    if (value.value_ != previousValue_.value_) {
-        previousValue_.value_ = value.value_;
+    // Samples needed below the threshold before slowing down.
+    static const int STEADY_SAMPLES = 8;
+    // Weight of a new sample in the running statistics.
+    static const qreal WEIGHT = 0.125;
+
+    qreal x = log(1.0 + lux);
+    if (!adaptiveValid_) {
+        logMean_ = x;
+        logVariance_ = adaptiveThreshold_;
+        steadySamples_ = 0;
+        adaptiveValid_ = true;
+        return;
+    }
+
+    qreal deviation = x - logMean_;
+    logMean_ += WEIGHT * deviation;
+    logVariance_ += WEIGHT * (deviation * deviation - logVariance_);
+
+    // A single jump well outside the steady spread, like stepping out
+    // of the shade, speeds up right away.
+    bool jump = deviation * deviation > 4 * adaptiveThreshold_;
+    if (jump || logVariance_ >= adaptiveThreshold_) {
+        steadySamples_ = 0;
+        if (jump)
+            logVariance_ = qMax(logVariance_, adaptiveThreshold_);
+        if (adaptiveSlow_) {
+            adaptiveSlow_ = false;
+            sensordLogD() << "ALS level changing, back to requested interval";
+            QMetaObject::invokeMethod(this, "applyIntervalFloor", Qt::QueuedConnection);
+        }
+        return;
+    }
 
-        writeToClients((const void*)(&value), sizeof(value));
+    if (!adaptiveSlow_ && ++steadySamples_ >= STEADY_SAMPLES) {
+        adaptiveSlow_ = true;
+        sensordLogD() << "ALS level steady, slowing down to " << adaptiveInterval_ << " ms";
+        QMetaObject::invokeMethod(this, "applyIntervalFloor", Qt::QueuedConnection);
     }
+}
+
+void ALSSensorChannel::emitData(const TimedUnsigned& value)
+{
+    // Sessions which are not downsampling only get changes in the value.
+    bool changed = value.value_ != previousValue_.value_;
+    previousValue_.value_ = value.value_;
+    downsampleAndPropagate(value, downsampleBuffer_, changed);
+
+    if (adaptiveInterval_)
+        adaptInterval(value.value_);
 
 #ifdef PROVIDE_CONTEXT_INFO
     // Publish the new data via Context FW. Note that setting the same
@@ -154,3 +210,20 @@ void ALSSensorChannel::emitData(const TimedUnsigned& value)
     }
 #endif
 }
+
+bool ALSSensorChannel::sampleChanged(const void* previous, const void* current, int, unsigned int deadband) const
+{
+    unsigned int from = ((const TimedUnsigned*)previous)->value_;
+    unsigned int to = ((const TimedUnsigned*)current)->value_;
+    return (from > to ? from - to : to - from) > deadband;
+}
+
+int ALSSensorChannel::predicateAxes() const
+{
+    return 1;
+}
+
+void ALSSensorChannel::sampleAxes(const void* source, double* axes) const
+{
+    axes[0] = ((const TimedUnsigned*)source)->value_;
+}
@@ -48,6 +48,14 @@ class FilterBase;
  *
  * Signals listeners whenever observed ambient light intensity level has
  * changed.
+ *
+ * With <tt>adaptive_interval</tt> set in the group of the sensor ID the
+ * channel slows the adaptor down to that interval while the light level
+ * is steady, and returns to the interval requested by the sessions as
+ * soon as it changes. Steadiness is judged from a running variance of
+ * the logarithm of the lux value, so it is the same for dim and bright
+ * light; <tt>adaptive_threshold</tt> sets the variance below which the
+ * level counts as steady.
  */
 class ALSSensorChannel :
         public AbstractSensorChannel,
@@ -75,6 +83,8 @@ public:
      */
     Unsigned lux() const { return previousValue_; }
 
+    virtual bool downsamplingSupported() const;
+
 public Q_SLOTS:
     bool start();
     bool stop();
@@ -86,20 +96,48 @@ signals:
      */
     void ALSChanged(const Unsigned& value);
 
+private Q_SLOTS:
+    /**
+     * Apply interval floor chosen by the adaptive mode. Queued from the
+     * thread running the filter chain.
+     */
+    void applyIntervalFloor();
+
 protected:
     ALSSensorChannel(const QString& id);
     virtual ~ALSSensorChannel();
 
+    virtual bool sampleChanged(const void* previous, const void* current, int size, unsigned int deadband) const;
+
+    virtual int predicateAxes() const;
+    virtual void sampleAxes(const void* source, double* axes) const;
+
 private:
     TimedUnsigned                 previousValue_;
+    DownsampleBuffer<TimedUnsigned> downsampleBuffer_;
     Bin*                          filterBin_;
-    Bin*                          marshallingBin_;
     DeviceAdaptor*                alsAdaptor_;
     BufferReader<TimedUnsigned>*  alsReader_;
-    RingBuffer<TimedUnsigned>*    outputBuffer_;
+    EmitterSink<TimedUnsigned>*   outputSink_;
 
     void emitData(const TimedUnsigned& value);
 
+    /**
+     * Update the running statistics of the adaptive mode with a sample
+     * and slow down or speed up the adaptor when steadiness changes.
+     *
+     * @param lux measured value.
+     */
+    void adaptInterval(unsigned int lux);
+
+    unsigned int                  adaptiveInterval_;  /**< interval while steady, 0 if not adaptive */
+    qreal                         adaptiveThreshold_; /**< variance of ln(lux) counted as steady */
+    bool                          adaptiveValid_;     /**< have statistics been seeded */
+    bool                          adaptiveSlow_;      /**< is the adaptor slowed down */
+    qreal                         logMean_;           /**< running mean of ln(lux) */
+    qreal                         logVariance_;       /**< running variance of ln(lux) */
+    int                           steadySamples_;     /**< consecutive steady samples */
+
 #ifdef PROVIDE_CONTEXT_INFO
     ContextProvider::Service service;
     ContextProvider::Property isDarkProperty; ///< For publishing the Environment.IsDark contextProperty
@@ -33,7 +33,8 @@
 CompassSensorChannel::CompassSensorChannel(const QString& id) :
         AbstractSensorChannel(id),
         DataEmitter<CompassData>(1),
-        compassData(0, -1, -1)
+        compassData(0, -1, -1),
+        trueNorth_(true)
 {
     SensorManager& sm = SensorManager::instance();
 
@@ -43,24 +44,19 @@ CompassSensorChannel::CompassSensorChannel(const QString& id) :
 
     inputReader_ = new BufferReader<CompassData>(1);
 
-    outputBuffer_ = new RingBuffer<CompassData>(1);
+    outputSink_ = new EmitterSink<CompassData>(this);
 
     // Create buffers for filter chain
-    filterBin_ = new Bin;
+    filterBin_ = Bin::create(id);
 
     filterBin_->add(inputReader_, "input");
-    filterBin_->add(outputBuffer_, "output");
+    filterBin_->add(outputSink_, "output");
 
     // Join filterchain buffers
     filterBin_->join("input", "source", "output", "sink");
 
     connectToSource(compassChain_, "truenorth", inputReader_);
 
-    marshallingBin_ = new Bin;
-    marshallingBin_->add(this, "sensorchannel");
-
-    outputBuffer_->join(this);
-
     setDescription("compass north in degrees");
     addStandbyOverrideSource(compassChain_);
     setIntervalSource(compassChain_);
@@ -71,12 +67,11 @@ CompassSensorChannel::~CompassSensorChannel()
 {
     SensorManager& sm = SensorManager::instance();
 
-    disconnectFromSource(compassChain_, "truenorth", inputReader_);
+    disconnectFromSource(compassChain_, trueNorth_ ? "truenorth" : "magneticnorth", inputReader_);
     sm.releaseChain("compasschain");
 
     delete inputReader_;
-    delete outputBuffer_;
-    delete marshallingBin_;
+    delete outputSink_;
     delete filterBin_;
 }
 
@@ -90,11 +85,11 @@ bool CompassSensorChannel::start()
     sensordLogD() << "Starting CompassSensorChannel";
 
     if (AbstractSensorChannel::start()) {
-        marshallingBin_->start();
         filterBin_->start();
         compassChain_->setProperty("compassEnabled", true);
         compassChain_->start();
     }
+    updateInput();
     return true;
 }
 
@@ -106,7 +101,6 @@ bool CompassSensorChannel::stop()
         compassChain_->stop();
         compassChain_->setProperty("compassEnabled", false);
         filterBin_->stop();
-        marshallingBin_->stop();
     }
     return true;
 }
@@ -114,5 +108,46 @@ bool CompassSensorChannel::stop()
 void CompassSensorChannel::emitData(const CompassData& value)
 {
     compassData = value;
-    writeToClients((const void*)(&value), sizeof(CompassData));
+    downsampleAndPropagate(value, downsampleBuffer_);
+}
+
+bool CompassSensorChannel::downsamplingSupported() const
+{
+    return true;
+}
+
+bool CompassSensorChannel::setDeclinationCorrection(int sessionId, bool enabled)
+{
+    if (enabled)
+        magneticNorthSessions_.remove(sessionId);
+    else
+        magneticNorthSessions_.insert(sessionId);
+    updateInput();
+    return true;
+}
+
+void CompassSensorChannel::removeSession(int sessionId)
+{
+    AbstractSensorChannel::removeSession(sessionId);
+    magneticNorthSessions_.remove(sessionId);
+    updateInput();
+}
+
+void CompassSensorChannel::updateInput()
+{
+    bool wanted = activeSessions().isEmpty();
+    foreach (int sessionId, activeSessions()) {
+        if (!magneticNorthSessions_.contains(sessionId)) {
+            wanted = true;
+            break;
+        }
+    }
+    if (wanted == trueNorth_)
+        return;
+
+    // Without readers the declination filter of the chain is idle.
+    disconnectFromSource(compassChain_, trueNorth_ ? "truenorth" : "magneticnorth", inputReader_);
+    connectToSource(compassChain_, wanted ? "truenorth" : "magneticnorth", inputReader_);
+    trueNorth_ = wanted;
+    sensordLogD() << "Compass reads " << (trueNorth_ ? "true" : "magnetic") << " north";
 }
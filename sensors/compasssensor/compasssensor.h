@@ -68,6 +68,21 @@ public:
 
     Compass get() const { return compassData; }
 
+    virtual bool downsamplingSupported() const;
+
+    /**
+     * Select whether a session needs declination corrected headings.
+     * Declination is only computed while at least one active session
+     * needs it, which is the default for new sessions.
+     *
+     * @param sessionId session ID.
+     * @param enabled does the session use true north.
+     * @return always true.
+     */
+    bool setDeclinationCorrection(int sessionId, bool enabled);
+
+    virtual void removeSession(int sessionId);
+
 public Q_SLOTS:
     bool start();
     bool stop();
@@ -81,15 +96,24 @@ protected:
 
 private:
     CompassData compassData;
+    DownsampleBuffer<CompassData> downsampleBuffer_;
 
     Bin* filterBin_;
-    Bin* marshallingBin_;
 
     AbstractChain* compassChain_;
     BufferReader<CompassData>* inputReader_;
-    RingBuffer<CompassData>* outputBuffer_;
+    EmitterSink<CompassData>* outputSink_;
+
+    QSet<int> magneticNorthSessions_; /**< sessions not using declination */
+    bool trueNorth_;                  /**< is input read from true north */
 
     void emitData(const CompassData& value);
+
+    /**
+     * Read true north from the chain if any active session needs it,
+     * magnetic north otherwise.
+     */
+    void updateInput();
 };
 
 #endif
@@ -25,6 +25,7 @@
  */
 
 #include "compasssensor_a.h"
+#include "compasssensor.h"
 
 CompassSensorChannelAdaptor::CompassSensorChannelAdaptor(QObject* parent) :
     AbstractSensorChannelAdaptor(parent)
@@ -40,3 +41,9 @@ int CompassSensorChannelAdaptor::declinationValue() const
 {
     return qvariant_cast<int>(parent()->property("declinationvalue"));
 }
+
+bool CompassSensorChannelAdaptor::setDeclinationCorrection(int sessionId, bool enabled)
+{
+    CompassSensorChannel* channel = qobject_cast<CompassSensorChannel*>(parent());
+    return channel && channel->setDeclinationCorrection(sessionId, enabled);
+}
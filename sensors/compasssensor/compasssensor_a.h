@@ -46,6 +46,9 @@ public Q_SLOTS:
     Compass value() const;
     int declinationValue() const;
 
+    /** CompassSensorChannel::setDeclinationCorrection(int, bool) */
+    bool setDeclinationCorrection(int sessionId, bool enabled);
+
 Q_SIGNALS:
     void dataAvailable(const Compass& value);
 };
@@ -23,64 +23,83 @@
 */
 
 #include "avgvarfilter.h"
-#include <QMutexLocker>
-#include <math.h>
 
-AvgVarFilter::AvgVarFilter(int size) :
+AvgVarFilter::AvgVarFilter(int size, bool welford) :
     Filter<double, AvgVarFilter, QPair<double, double> >(this, &AvgVarFilter::interpret),
-    size(size), samplesReceived(0), current(0), samples(size), samplesSquared(size), sampleSum(0), sampleSquareSum(0)
+    size(size), samplesReceived(0), current(0), welford(welford), samples(size),
+    sampleSum(0), sampleSquareSum(0), mean(0), squaredDistance(0), resetPending(0)
+{
+}
 
+void AvgVarFilter::clear()
 {
+    samplesReceived = 0;
+    current = 0;
+    sampleSum = 0;
+    sampleSquareSum = 0;
+    mean = 0;
+    squaredDistance = 0;
 }
 
-void AvgVarFilter::interpret(unsigned, const double* data)
+void AvgVarFilter::interpret(unsigned n, const double* values)
 {
-    double avg,var;
-    {
-        QMutexLocker locker(&mutex);
+    if (resetPending.testAndSetAcquire(1, 0))
+        clear();
+
+    QPair<double, double>* pairs = outputSpan(n);
+    unsigned count = 0;
+    for (unsigned i = 0; i < n; ++i) {
+        double value = values[i];
 
         // Ramp-up-phase:
         if (samplesReceived < size) {
-            samples[samplesReceived] = *data;
-            samplesSquared[samplesReceived] = (*data)*(*data);
-            sampleSum += *data;
-            sampleSquareSum += (*data)*(*data);
+            samples[samplesReceived] = value;
             ++samplesReceived;
-            return;
+            if (welford) {
+                double delta = value - mean;
+                mean += delta / samplesReceived;
+                squaredDistance += delta * (value - mean);
+            } else {
+                sampleSum += value;
+                sampleSquareSum += value * value;
+            }
+            continue;
         }
 
-        //qDebug() << "Data received on AvgVarFilter:" << *data;
-        //qDebug() << "Cur data:" << samples;
-
         // Moving average & variance computations:
         // Remove the oldest sample, replace with the new sample
-        sampleSum = sampleSum - samples[current] + *data;
-        sampleSquareSum = sampleSquareSum - samples[current] * samples[current] + (*data) * (*data);
-
-        // Take the new value in
-        samples[current] = *data;
+        double oldest = samples[current];
+        samples[current] = value;
         ++current;
         if (current >= size) {
             current = 0;
         }
 
-        avg = sampleSum / size;
-        var = (size * sampleSquareSum - (sampleSum * sampleSum)) / (size * (size - 1));
-    }
+        double avg, var;
+        if (welford) {
+            double oldMean = mean;
+            mean += (value - oldest) / size;
+            squaredDistance += (value - oldest) * (value - mean + oldest - oldMean);
+            if (squaredDistance < 0)
+                squaredDistance = 0;
+            avg = mean;
+            var = squaredDistance / (size - 1);
+        } else {
+            sampleSum = sampleSum - oldest + value;
+            sampleSquareSum = sampleSquareSum - oldest * oldest + value * value;
+            avg = sampleSum / size;
+            var = (size * sampleSquareSum - (sampleSum * sampleSum)) / (size * (size - 1));
+        }
 
-    //qDebug() << "Avg and var" << avg << var;
+        pairs[count++] = QPair<double, double>(avg, var);
+    }
 
-    QPair<double, double> pair(avg, var);
-    source_.propagate(1, &pair);
+    if (count)
+        source_.propagate(count, pairs);
 }
 
 // Start the ramp-up again
 void AvgVarFilter::reset()
 {
-    QMutexLocker locker(&mutex);
-
-    samplesReceived = 0;
-    current = 0;
-    sampleSum = 0;
-    sampleSquareSum = 0;
+    resetPending.fetchAndStoreRelease(1);
 }
@@ -29,27 +29,51 @@
 
 #include <QPair>
 #include <QVector>
-#include <QMutex>
+#include <QAtomicInt>
 
+/**
+ * Moving average and variance over a window of samples. Output starts
+ * once the window is full.
+ *
+ * The filter is fed from a single thread and keeps no lock. #reset() may
+ * be called from another thread, the window is cleared before the next
+ * span is processed.
+ */
 class AvgVarFilter : public QObject, public Filter<double, AvgVarFilter, QPair<double, double> >
 {
     Q_OBJECT
 
 public:
-    AvgVarFilter(int samples);
+    /**
+     * Constructor.
+     *
+     * @param samples window size.
+     * @param welford update mean and variance with Welford's method
+     *                instead of running sums of samples and their
+     *                squares, which lose precision when the variance
+     *                is small compared to the mean.
+     */
+    AvgVarFilter(int samples, bool welford = false);
+
+    /**
+     * Start filling the window again.
+     */
     void reset();
 
 private:
     int size;
     int samplesReceived;
     int current;
+    bool welford;
     QVector<double> samples;
-    QVector<double> samplesSquared;
     double sampleSum;
     double sampleSquareSum;
-    QMutex mutex;
+    double mean;
+    double squaredDistance;
+    QAtomicInt resetPending;
 
     void interpret(unsigned, const double* data);
+    void clear();
 };
 
 #endif
@@ -26,14 +26,19 @@
 #include "compassbin.h"
 #include "contextplugin.h"
 #include "sensormanager.h"
+#include "deferredwork.h"
 
-CompassBin::CompassBin(ContextProvider::Service& s, bool pluginValid):
+CompassBin::CompassBin(ContextProvider::Service& s, PropertyPublisher& publisher, bool pluginValid):
     headingProperty(s, "Location.Heading"),
     compassChain(0),
     compassReader(10),
-    headingFilter(&headingProperty),
-    sessionId(0)
+    headingFilter(&publisher, &headingProperty),
+    sessionId(0),
+    running(false)
 {
+    stopTimer.setSingleShot(true);
+    connect(&stopTimer, SIGNAL(timeout()), this, SLOT(stopRunNow()));
+
     if (pluginValid)
     {
         add(&compassReader, "compass");
@@ -50,10 +55,23 @@ CompassBin::CompassBin(ContextProvider::Service& s, bool pluginValid):
     }
 }
 
-CompassBin::~CompassBin() {}
+CompassBin::~CompassBin()
+{
+    stopRunNow();
+}
 
 void CompassBin::startRun()
 {
+    // A subscriber came back within the grace period, keep running.
+    if (stopTimer.isActive())
+    {
+        stopTimer.stop();
+        return;
+    }
+    if (running)
+        return;
+    running = true;
+
     // Get unique sessionId for this Bin.
     sessionId = SensorManager::instance().requestSensor("contextsensor");
     if (sessionId == INVALID_SESSION)
@@ -75,6 +93,9 @@ void CompassBin::startRun()
     }
     else
     {
+        unsigned int latency = ContextPlugin::deferredLatency();
+        if (latency > 0)
+            DeferredWork::instance().attach(&compassReader, latency);
         rb->join(&compassReader);
     }
 
@@ -84,6 +105,25 @@ void CompassBin::startRun()
 
 void CompassBin::stopRun()
 {
+    if (!running)
+        return;
+
+    int grace = ContextPlugin::stopGracePeriod();
+    if (grace > 0)
+    {
+        stopTimer.start(grace);
+        return;
+    }
+    stopRunNow();
+}
+
+void CompassBin::stopRunNow()
+{
+    stopTimer.stop();
+    if (!running)
+        return;
+    running = false;
+
     stop();
     if (compassChain) {
         compassChain->stop();
@@ -92,6 +132,7 @@ void CompassBin::stopRun()
         if (rb)
         {
             rb->unjoin(&compassReader);
+            DeferredWork::instance().detach(&compassReader);
         }
         SensorManager::instance().releaseChain("compasschain");
         compassChain = NULL;
@@ -30,9 +30,12 @@
 #include "datatypes/orientationdata.h"
 
 #include "headingfilter.h"
+#include "propertypublisher.h"
 
 #include <ContextProvider>
 
+#include <QTimer>
+
 class AbstractChain;
 
 class CompassBin : public QObject, Bin
@@ -40,12 +43,13 @@ class CompassBin : public QObject, Bin
     Q_OBJECT
 
 public:
-    CompassBin(ContextProvider::Service& service, bool pluginValid = true);
+    CompassBin(ContextProvider::Service& service, PropertyPublisher& publisher, bool pluginValid = true);
     ~CompassBin();
 
 private Q_SLOTS:
     void startRun();
     void stopRun();
+    void stopRunNow();
 
 private:
     Property headingProperty;
@@ -55,6 +59,8 @@ private:
     HeadingFilter headingFilter;
 
     int sessionId;
+    bool running;
+    QTimer stopTimer;
 };
 
 #endif
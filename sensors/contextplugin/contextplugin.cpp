@@ -26,10 +26,14 @@
 #include "contextplugin.h"
 #include "sensormanager.h"
 #include "contextsensor.h"
+#include "config.h"
 #include "logging.h"
 
 int ContextPlugin::sessionId = 0;
 
+static const int DEFAULT_STOP_GRACE_PERIOD = 5000; // milliseconds
+static const unsigned int DEFAULT_DEFERRED_LATENCY = 0; // milliseconds
+
 void ContextPlugin::Register(class Loader&)
 {
     sensordLogD() << "registering contextsensor";
@@ -51,6 +55,16 @@ int ContextPlugin::getSessionId()
     return sessionId;
 }
 
+int ContextPlugin::stopGracePeriod()
+{
+    return Config::configuration()->value("context/stop_grace_period", QVariant(DEFAULT_STOP_GRACE_PERIOD)).toInt();
+}
+
+unsigned int ContextPlugin::deferredLatency()
+{
+    return Config::configuration()->value<unsigned int>("context/deferred_latency", DEFAULT_DEFERRED_LATENCY);
+}
+
 #if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
 Q_EXPORT_PLUGIN2(contextsensor, ContextPlugin)
 #endif
@@ -36,6 +36,21 @@ class ContextPlugin : public Plugin
 public:
     static int getSessionId();
 
+    /**
+     * Time in milliseconds a context bin keeps running after its last
+     * subscriber has gone, so quick resubscription does not restart
+     * the underlying chains. Read from context/stop_grace_period.
+     */
+    static int stopGracePeriod();
+
+    /**
+     * Time in milliseconds samples for non-urgent context properties
+     * may wait before being processed, so they are handled while the
+     * CPU is awake anyway. Read from context/deferred_latency; zero
+     * processes samples as they arrive.
+     */
+    static unsigned int deferredLatency();
+
 private:
     void Register(class Loader& l);
     void Init(class Loader& l);
@@ -16,7 +16,8 @@ HEADERS += contextplugin.h \
            avgvarfilter.h \
            cutterfilter.h \
            stabilityfilter.h \
-           headingfilter.h
+           headingfilter.h \
+           propertypublisher.h
 
 
 SOURCES += contextplugin.cpp \
@@ -29,7 +30,8 @@ SOURCES += contextplugin.cpp \
            avgvarfilter.cpp \
            cutterfilter.cpp \
            stabilityfilter.cpp \
-           headingfilter.cpp
+           headingfilter.cpp \
+           propertypublisher.cpp
 
 CONTEXT.files = 'com.nokia.SensorService.context'
 CONTEXT.path = '/usr/share/contextkit/providers'
@@ -29,18 +29,18 @@
 
 ContextSensorChannel::ContextSensorChannel(const QString& id) :
     AbstractSensorChannel(id), service(QDBusConnection::systemBus()),
-    orientationBin(service), compassBin(NULL), stabilityBin(service)
+    orientationBin(service, publisher), compassBin(NULL), stabilityBin(service, publisher)
 {
     // Attempt to load compasschain
     if (SensorManager::instance().loadPlugin("compasschain"))
     {
-        compassBin = new CompassBin(service);
+        compassBin = new CompassBin(service, publisher);
     } else {
         sensordLogD() << "Loading of 'compasschain' failed, no Location.Heading available";
 
         // Creating as dummy to provide the service with value 'unknown'
         // rather than miss the service.
-        compassBin = new CompassBin(service, false);
+        compassBin = new CompassBin(service, publisher, false);
     }
 
     setValid(true);
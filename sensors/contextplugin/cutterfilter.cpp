@@ -31,8 +31,10 @@ CutterFilter::CutterFilter(double divider) :
     //qDebug() << "Creating the CutterFilter";
 }
 
-void CutterFilter::interpret(unsigned, const double* data)
+void CutterFilter::interpret(unsigned n, const double* data)
 {
-    double n = *data / divider;
-    source_.propagate(1, &n);
+    double* cut = outputSpan(n);
+    for (unsigned i = 0; i < n; ++i)
+        cut[i] = data[i] / divider;
+    source_.propagate(n, cut);
 }
@@ -23,15 +23,20 @@
 */
 
 #include "headingfilter.h"
+#include "propertypublisher.h"
 
-HeadingFilter::HeadingFilter(Property* headingProperty) :
+HeadingFilter::HeadingFilter(PropertyPublisher* publisher, Property* headingProperty) :
     Filter<CompassData, HeadingFilter, CompassData>(this, &HeadingFilter::interpret),
+    publisher(publisher),
     headingProperty(headingProperty)
 {
 }
 
-void HeadingFilter::interpret(unsigned, const CompassData* data)
+void HeadingFilter::interpret(unsigned n, const CompassData* data)
 {
-    headingProperty->setValue(data->degrees_);
-    source_.propagate(1, data);
+    if (!n)
+        return;
+    // Only the latest heading matters for the property.
+    publisher->setValue(headingProperty, data[n - 1].degrees_);
+    source_.propagate(n, data);
 }
@@ -32,15 +32,18 @@
 
 using ContextProvider::Property;
 
+class PropertyPublisher;
+
 class HeadingFilter : public QObject, public Filter<CompassData, HeadingFilter, CompassData>
 {
     Q_OBJECT
 
 public:
-    HeadingFilter(Property* headingProperty);
+    HeadingFilter(PropertyPublisher* publisher, Property* headingProperty);
     void reset();
 
 private:
+    PropertyPublisher* publisher;
     Property* headingProperty;
     void interpret(unsigned, const CompassData* data);
 };
@@ -32,15 +32,20 @@ NormalizerFilter::NormalizerFilter() :
         prevTime(0)
 {}
 
-void NormalizerFilter::interpret(unsigned, const TimedXyzData* data)
+void NormalizerFilter::interpret(unsigned n, const TimedXyzData* data)
 {
-    // Subsample to 1hz rate.
-    if (data->timestamp_ - prevTime > 1000000 || prevTime == 0)
-    {
-        double n = sqrt(data->x_ * data->x_ + data->y_ * data->y_ + data->z_ * data-> z_);
-        source_.propagate(1, &n);
-        prevTime = data->timestamp_;
-    } else {
-        sensordLogT() << "Discarded sample from normalizer due to too short time delta.";
+    double* norms = outputSpan(n);
+    unsigned count = 0;
+    for (unsigned i = 0; i < n; ++i) {
+        // Subsample to 1hz rate.
+        if (data[i].timestamp_ - prevTime > 1000000 || prevTime == 0)
+        {
+            norms[count++] = sqrt(data[i].x_ * data[i].x_ + data[i].y_ * data[i].y_ + data[i].z_ * data[i].z_);
+            prevTime = data[i].timestamp_;
+        } else {
+            sensordLogT() << "Discarded sample from normalizer due to too short time delta.";
+        }
     }
+    if (count)
+        source_.propagate(count, norms);
 }
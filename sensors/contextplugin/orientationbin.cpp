@@ -30,16 +30,22 @@
 
 const int OrientationBin::POLL_INTERVAL = 250;
 
-OrientationBin::OrientationBin(ContextProvider::Service& s):
+OrientationBin::OrientationBin(ContextProvider::Service& s, PropertyPublisher& publisher):
     topEdgeProperty(s, "Screen.TopEdge"),
     isCoveredProperty(s, "Screen.IsCovered"),
     isFlatProperty(s, "Position.IsFlat"),
+    publisher(publisher),
     accelerometerReader(10),
     topEdgeReader(10),
     faceReader(10),
-    screenInterpreterFilter(&topEdgeProperty, &isCoveredProperty, &isFlatProperty),
-    sessionId(0)
+    orientationChain(NULL),
+    screenInterpreterFilter(&publisher, &topEdgeProperty, &isCoveredProperty, &isFlatProperty),
+    sessionId(0),
+    running(false)
 {
+    stopTimer.setSingleShot(true);
+    connect(&stopTimer, SIGNAL(timeout()), this, SLOT(stopRunNow()));
+
     add(&topEdgeReader, "topedge");
     add(&faceReader, "face");
     add(&screenInterpreterFilter, "screeninterpreterfilter");
@@ -56,18 +62,28 @@ OrientationBin::OrientationBin(ContextProvider::Service& s):
     connect(&group, SIGNAL(lastSubscriberDisappeared()), this, SLOT(stopRun()));
 
     // Set default values (if the default isn't Unknown)
-    topEdgeProperty.setValue("top");
-    isCoveredProperty.setValue(false);
-    isFlatProperty.setValue(false);
+    publisher.setValue(&topEdgeProperty, "top");
+    publisher.setValue(&isCoveredProperty, false);
+    publisher.setValue(&isFlatProperty, false);
 }
 
 OrientationBin::~OrientationBin()
 {
-    stopRun();
+    stopRunNow();
 }
 
 void OrientationBin::startRun()
 {
+    // A subscriber came back within the grace period, keep running.
+    if (stopTimer.isActive())
+    {
+        stopTimer.stop();
+        return;
+    }
+    if (running)
+        return;
+    running = true;
+
     // Get unique sessionId for this Bin.
     sessionId = SensorManager::instance().requestSensor("contextsensor");
     if (sessionId == INVALID_SESSION)
@@ -107,6 +123,25 @@ void OrientationBin::startRun()
 
 void OrientationBin::stopRun()
 {
+    if (!running)
+        return;
+
+    int grace = ContextPlugin::stopGracePeriod();
+    if (grace > 0)
+    {
+        stopTimer.start(grace);
+        return;
+    }
+    stopRunNow();
+}
+
+void OrientationBin::stopRunNow()
+{
+    stopTimer.stop();
+    if (!running)
+        return;
+    running = false;
+
     stop();
     if (orientationChain)
     {
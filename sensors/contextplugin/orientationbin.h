@@ -33,10 +33,12 @@
 #include "posedata.h"
 
 #include "screeninterpreterfilter.h"
+#include "propertypublisher.h"
 
 #include <ContextProvider>
 
 #include <QPair>
+#include <QTimer>
 
 class DeviceAdaptor;
 
@@ -45,18 +47,20 @@ class OrientationBin : public QObject, Bin
     Q_OBJECT
 
 public:
-    OrientationBin(ContextProvider::Service& service);
+    OrientationBin(ContextProvider::Service& service, PropertyPublisher& publisher);
     ~OrientationBin();
 
 private Q_SLOTS:
     void startRun();
     void stopRun();
+    void stopRunNow();
 
 private:
     ContextProvider::Property topEdgeProperty;
     ContextProvider::Property isCoveredProperty;
     ContextProvider::Property isFlatProperty;
     ContextProvider::Group group;
+    PropertyPublisher& publisher;
 
     BufferReader<AccelerationData> accelerometerReader;
     BufferReader<PoseData> topEdgeReader;
@@ -66,6 +70,8 @@ private:
     ScreenInterpreterFilter screenInterpreterFilter;
 
     int sessionId;
+    bool running;
+    QTimer stopTimer;
 
     static const int POLL_INTERVAL;
 };
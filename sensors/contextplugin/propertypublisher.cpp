@@ -0,0 +1,82 @@
+/**
+   @file propertypublisher.cpp
+   @brief PropertyPublisher
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "propertypublisher.h"
+#include "config.h"
+#include "logging.h"
+
+const int PropertyPublisher::defaultInterval = 200; // milliseconds
+
+PropertyPublisher::PropertyPublisher(QObject* parent) :
+    QObject(parent)
+{
+    interval = Config::configuration()->value("context/min_publish_interval", QVariant(defaultInterval)).toInt();
+    timer.setSingleShot(true);
+    connect(&timer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+void PropertyPublisher::setValue(ContextProvider::Property* property, const QVariant& value)
+{
+    bool unchanged = published.contains(property) && published.value(property) == value;
+
+    if (timer.isActive()) {
+        if (unchanged)
+            pending.remove(property);
+        else
+            pending.insert(property, value);
+        return;
+    }
+
+    if (unchanged)
+        return;
+    publish(property, value);
+    if (interval > 0)
+        timer.start(interval);
+}
+
+void PropertyPublisher::unsetValue(ContextProvider::Property* property)
+{
+    pending.remove(property);
+    published.remove(property);
+    property->unsetValue();
+}
+
+void PropertyPublisher::flush()
+{
+    if (pending.isEmpty())
+        return;
+
+    sensordLogT() << "Publishing " << pending.size() << " coalesced context properties";
+    for (QHash<ContextProvider::Property*, QVariant>::const_iterator it = pending.constBegin(); it != pending.constEnd(); ++it)
+        publish(it.key(), it.value());
+    pending.clear();
+
+    // Keep limiting the rate while changes keep coming.
+    timer.start(interval);
+}
+
+void PropertyPublisher::publish(ContextProvider::Property* property, const QVariant& value)
+{
+    published.insert(property, value);
+    property->setValue(value);
+}
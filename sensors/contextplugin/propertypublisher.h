@@ -0,0 +1,84 @@
+/**
+   @file propertypublisher.h
+   @brief PropertyPublisher
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef PROPERTYPUBLISHER_H
+#define PROPERTYPUBLISHER_H
+
+#include <QObject>
+#include <QHash>
+#include <QVariant>
+#include <QTimer>
+
+#include <ContextProvider>
+
+/*!
+
+    \class PropertyPublisher
+
+    \brief Rate limited publishing of context properties.
+
+    Every published value may reach ContextKit subscribers over D-Bus, so
+    values are only passed to the properties when they change and at most
+    once per \c context/min_publish_interval milliseconds. A change after
+    a quiet period is published at once. Changes arriving faster are
+    collected for all properties and at the end of the interval only the
+    properties whose latest value differs from the published one are
+    updated. A value which jitters back to the published one within the
+    interval is not published at all.
+
+*/
+
+class PropertyPublisher : public QObject
+{
+    Q_OBJECT
+
+public:
+    PropertyPublisher(QObject* parent = 0);
+
+    /**
+     * Set value of a property, published now or at the end of the
+     * current interval.
+     */
+    void setValue(ContextProvider::Property* property, const QVariant& value);
+
+    /**
+     * Unset value of a property. Takes effect immediately and drops any
+     * value waiting to be published.
+     */
+    void unsetValue(ContextProvider::Property* property);
+
+private Q_SLOTS:
+    void flush();
+
+private:
+    void publish(ContextProvider::Property* property, const QVariant& value);
+
+    QHash<ContextProvider::Property*, QVariant> published; /**< values passed to properties */
+    QHash<ContextProvider::Property*, QVariant> pending;   /**< changes waiting for the interval to end */
+    QTimer timer;
+    int interval;
+
+    static const int defaultInterval;
+};
+
+#endif
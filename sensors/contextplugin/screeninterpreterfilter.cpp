@@ -24,6 +24,7 @@
 */
 
 #include "screeninterpreterfilter.h"
+#include "propertypublisher.h"
 #include "genericdata.h"
 #include "config.h"
 #include "logging.h"
@@ -33,10 +34,12 @@
 const char* ScreenInterpreterFilter::orientationValues[4] = {"left", "top", "right", "bottom"};
 
 ScreenInterpreterFilter::ScreenInterpreterFilter(
+    PropertyPublisher* publisher,
     ContextProvider::Property* topEdgeProperty,
     ContextProvider::Property* isCoveredProperty,
     ContextProvider::Property* isFlatProperty) :
     Filter<PoseData, ScreenInterpreterFilter, PoseData>(this, &ScreenInterpreterFilter::interpret),
+    publisher(publisher),
     topEdgeProperty(topEdgeProperty),
     isCoveredProperty(isCoveredProperty),
     isFlatProperty(isFlatProperty),
@@ -44,17 +47,28 @@ ScreenInterpreterFilter::ScreenInterpreterFilter(
     isCovered(false),
     isFlat(false),
     lastOrientation(PoseData::BottomDown),
+    hasLastOrientation(false),
     topEdge("top")
 {
     // Get offset from config
     offset = Config::configuration()->value("context/orientation_offset", QVariant(0)).toInt();
 }
 
-void ScreenInterpreterFilter::interpret(unsigned, const PoseData* data)
+void ScreenInterpreterFilter::interpret(unsigned n, const PoseData* data)
 {
-    sensordLogT() << "Data received on ScreenInterpreter... " << data->timestamp_;
-    provideScreenData(data->orientation_);
-    source_.propagate(1, data);
+    PoseData* changed = outputSpan(n);
+    unsigned count = 0;
+    for (unsigned i = 0; i < n; ++i) {
+        sensordLogT() << "Data received on ScreenInterpreter... " << data[i].timestamp_;
+        if (hasLastOrientation && data[i].orientation_ == lastOrientation)
+            continue;
+        lastOrientation = data[i].orientation_;
+        hasLastOrientation = true;
+        provideScreenData(data[i].orientation_);
+        changed[count++] = data[i];
+    }
+    if (count)
+        source_.propagate(count, changed);
 }
 
 void ScreenInterpreterFilter::provideScreenData(PoseData::Orientation orientation)
@@ -99,7 +113,7 @@ void ScreenInterpreterFilter::provideScreenData(PoseData::Orientation orientatio
             break;
     }
 
-    topEdgeProperty->setValue(topEdge);
-    isCoveredProperty->setValue(isCovered);
-    isFlatProperty->setValue(isFlat);
+    publisher->setValue(topEdgeProperty, topEdge);
+    publisher->setValue(isCoveredProperty, isCovered);
+    publisher->setValue(isFlatProperty, isFlat);
 }
@@ -32,6 +32,8 @@
 
 #include <ContextProvider>
 
+class PropertyPublisher;
+
 /*!
 
     \class ScreenInterpreterFilter
@@ -40,7 +42,8 @@
     Screen.IsCovered context properties.
 
     ScreenInterpreterFilter computes the context properties from
-    TimedXyzData. It pushes the data forward unchanged.
+    top edge and face events. Events repeating the previous pose are
+    dropped, others are pushed forward unchanged.
 
 */
 
@@ -49,9 +52,10 @@ class ScreenInterpreterFilter : public QObject, public Filter<PoseData, ScreenIn
     Q_OBJECT
 
 public:
-    ScreenInterpreterFilter(ContextProvider::Property* topEdgeProperty, ContextProvider::Property* isCoveredProperty, ContextProvider::Property* isFlatProperty);
+    ScreenInterpreterFilter(PropertyPublisher* publisher, ContextProvider::Property* topEdgeProperty, ContextProvider::Property* isCoveredProperty, ContextProvider::Property* isFlatProperty);
 
 private:
+    PropertyPublisher* publisher;
     ContextProvider::Property* topEdgeProperty;
     ContextProvider::Property* isCoveredProperty;
     ContextProvider::Property* isFlatProperty;
@@ -62,6 +66,7 @@ private:
     bool isCovered;
     bool isFlat;
     PoseData::Orientation lastOrientation;
+    bool hasLastOrientation;
     QString topEdge;
     int offset;
     static const char* orientationValues[4];
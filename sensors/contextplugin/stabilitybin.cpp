@@ -27,6 +27,7 @@
 #include "stabilitybin.h"
 #include "contextplugin.h"
 #include "sensormanager.h"
+#include "deferredwork.h"
 #include "config.h"
 #include "logging.h"
 
@@ -34,15 +35,21 @@ const int StabilityBin::STABILITY_THRESHOLD = 7;
 const int StabilityBin::UNSTABILITY_THRESHOLD = 300;
 const float StabilityBin::STABILITY_HYSTERESIS = 0.1;
 
-StabilityBin::StabilityBin(ContextProvider::Service& s):
+StabilityBin::StabilityBin(ContextProvider::Service& s, PropertyPublisher& publisher):
     isStableProperty(s, "Position.Stable"),
     isShakyProperty(s, "Position.Shaky"),
+    publisher(publisher),
     accelerometerReader(10),
+    accelerometerAdaptor(NULL),
     cutterFilter(4.0),
-    avgVarFilter(60),
-    stabilityFilter(&isStableProperty, &isShakyProperty, STABILITY_THRESHOLD, UNSTABILITY_THRESHOLD, STABILITY_HYSTERESIS),
-    sessionId(0)
+    avgVarFilter(60, Config::configuration()->value<bool>("context/stability_welford", false)),
+    stabilityFilter(&publisher, &isStableProperty, &isShakyProperty, STABILITY_THRESHOLD, UNSTABILITY_THRESHOLD, STABILITY_HYSTERESIS),
+    sessionId(0),
+    running(false)
 {
+    stopTimer.setSingleShot(true);
+    connect(&stopTimer, SIGNAL(timeout()), this, SLOT(stopRunNow()));
+
     add(&accelerometerReader, "accelerometer");
     add(&normalizerFilter, "normalizerfilter");
     add(&cutterFilter, "cutterfilter");
@@ -63,11 +70,21 @@ StabilityBin::StabilityBin(ContextProvider::Service& s):
 
 StabilityBin::~StabilityBin()
 {
-    stopRun();
+    stopRunNow();
 }
 
 void StabilityBin::startRun()
 {
+    // A subscriber came back within the grace period, keep running.
+    if (stopTimer.isActive())
+    {
+        stopTimer.stop();
+        return;
+    }
+    if (running)
+        return;
+    running = true;
+
     // Get unique sessionId for this Bin.
     sessionId = SensorManager::instance().requestSensor("contextsensor");
     if (sessionId == INVALID_SESSION)
@@ -87,6 +104,9 @@ void StabilityBin::startRun()
     {
         sensordLogC() << "Unable to connect to accelerometer.";
     } else {
+        unsigned int latency = ContextPlugin::deferredLatency();
+        if (latency > 0)
+            DeferredWork::instance().attach(&accelerometerReader, latency);
         rb->join(&accelerometerReader);
     }
 
@@ -94,23 +114,43 @@ void StabilityBin::startRun()
     // values for properties whose values aren't reliable after a
     // restart
     avgVarFilter.reset();
-    isStableProperty.unsetValue();
-    isShakyProperty.unsetValue();
+    publisher.unsetValue(&isStableProperty);
+    publisher.unsetValue(&isShakyProperty);
     start();
-    accelerometerAdaptor->startSensor();
+    accelerometerAdaptor->acquireSensor();
     accelerometerAdaptor->setStandbyOverrideRequest(sessionId, true);
 }
 
 void StabilityBin::stopRun()
 {
+    if (!running)
+        return;
+
+    int grace = ContextPlugin::stopGracePeriod();
+    if (grace > 0)
+    {
+        stopTimer.start(grace);
+        return;
+    }
+    stopRunNow();
+}
+
+void StabilityBin::stopRunNow()
+{
+    stopTimer.stop();
+    if (!running)
+        return;
+    running = false;
+
     stop();
     if (accelerometerAdaptor)
     {
-        accelerometerAdaptor->stopSensor();
+        accelerometerAdaptor->releaseSensor();
         RingBufferBase* rb = accelerometerAdaptor->findBuffer("accelerometer");
         if (rb)
         {
             rb->unjoin(&accelerometerReader);
+            DeferredWork::instance().detach(&accelerometerReader);
         }
         accelerometerAdaptor->removeSession(sessionId);
         SensorManager::instance().releaseDeviceAdaptor("accelerometeradaptor");
@@ -36,10 +36,12 @@
 #include "cutterfilter.h"
 #include "avgvarfilter.h"
 #include "stabilityfilter.h"
+#include "propertypublisher.h"
 
 #include <ContextProvider>
 
 #include <QPair>
+#include <QTimer>
 
 class DeviceAdaptor;
 
@@ -48,17 +50,19 @@ class StabilityBin : public QObject, Bin
     Q_OBJECT
 
 public:
-    StabilityBin(ContextProvider::Service& service);
+    StabilityBin(ContextProvider::Service& service, PropertyPublisher& publisher);
     ~StabilityBin();
 
 private Q_SLOTS:
     void startRun();
     void stopRun();
+    void stopRunNow();
 
 private:
     ContextProvider::Property isStableProperty;
     ContextProvider::Property isShakyProperty;
     ContextProvider::Group group;
+    PropertyPublisher& publisher;
 
     BufferReader<AccelerationData> accelerometerReader;
     DeviceAdaptor* accelerometerAdaptor;
@@ -69,6 +73,8 @@ private:
     StabilityFilter stabilityFilter;
 
     int sessionId;
+    bool running;
+    QTimer stopTimer;
 
     static const int STABILITY_THRESHOLD;
     static const int UNSTABILITY_THRESHOLD;
@@ -23,17 +23,19 @@
 */
 
 #include "stabilityfilter.h"
+#include "propertypublisher.h"
 #include "logging.h"
 #include "config.h"
 
 const int StabilityFilter::defaultTimeout = 60; // seconds
 
-StabilityFilter::StabilityFilter(Property* stableProperty, Property* unstableProperty,
+StabilityFilter::StabilityFilter(PropertyPublisher* publisher, Property* stableProperty, Property* unstableProperty,
                                  double lowThreshold, double highThreshold, double hysteresis)
     : Filter<QPair<double, double>, StabilityFilter, QPair<double, double> >(this, &StabilityFilter::interpret),
       lowThreshold(lowThreshold),
       highThreshold(highThreshold),
       hysteresis(hysteresis),
+      publisher(publisher),
       stableProperty(stableProperty),
       unstableProperty(unstableProperty)
 {
@@ -41,37 +43,43 @@ StabilityFilter::StabilityFilter(Property* stableProperty, Property* unstablePro
     timeout = Config::configuration()->value("context/stability_timeout", QVariant(defaultTimeout)).toInt() * 1000;
 }
 
-void StabilityFilter::interpret(unsigned, const QPair<double, double>* data)
+void StabilityFilter::interpret(unsigned n, const QPair<double, double>* data)
+{
+    for (unsigned i = 0; i < n; ++i)
+        update(data[i]);
+
+    // Propagate the data further without changing it
+    source_.propagate(n, data);
+}
+
+void StabilityFilter::update(const QPair<double, double>& sample)
 {
     // To take into account hysteresis and keep it simple, compute
     // stability and instability separately
-    if (data->second < lowThreshold * (1 - hysteresis)) {
-        stableProperty->setValue(true);
+    if (sample.second < lowThreshold * (1 - hysteresis)) {
+        publisher->setValue(stableProperty, true);
         timer.stop();
     }
     else {
         timer.start(timeout);
 
-        if (data->second > lowThreshold * (1 + hysteresis)) {
-            stableProperty->setValue(false);
+        if (sample.second > lowThreshold * (1 + hysteresis)) {
+            publisher->setValue(stableProperty, false);
         }
     }
 
-    if (data->second < highThreshold * (1 - hysteresis)) {
-        unstableProperty->setValue(false);
+    if (sample.second < highThreshold * (1 - hysteresis)) {
+        publisher->setValue(unstableProperty, false);
     }
-    else if (data->second > highThreshold * (1 + hysteresis)) {
-        unstableProperty->setValue(true);
+    else if (sample.second > highThreshold * (1 + hysteresis)) {
+        publisher->setValue(unstableProperty, true);
     }
-
-    // Propagate the data further without changing it
-    source_.propagate(1, data);
 }
 
 void StabilityFilter::timeoutTriggered()
 {
     sensordLogT() << "Stationary timeout triggered.";
 
-    stableProperty->setValue(true);
+    publisher->setValue(stableProperty, true);
     timer.stop();
 }
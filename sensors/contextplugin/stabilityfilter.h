@@ -47,12 +47,14 @@
 
 using ContextProvider::Property;
 
+class PropertyPublisher;
+
 class StabilityFilter : public QObject, public Filter<QPair<double, double>, StabilityFilter, QPair<double, double> >
 {
     Q_OBJECT
 
 public:
-    StabilityFilter(Property* stableProperty, Property* unstableProperty,
+    StabilityFilter(PropertyPublisher* publisher, Property* stableProperty, Property* unstableProperty,
                     double lowThreshold, double highThreshold, double hysteresis = 0.0);
 
 public Q_SLOTS:
@@ -62,9 +64,11 @@ private:
     double lowThreshold;
     double highThreshold;
     double hysteresis;
+    PropertyPublisher* publisher;
     Property* stableProperty;
     Property* unstableProperty;
     void interpret(unsigned, const QPair<double, double>* data);
+    void update(const QPair<double, double>& sample);
     QTimer timer;
 
     int timeout;
@@ -0,0 +1,216 @@
+/**
+   @file gesturefilter.cpp
+   @brief GestureFilter
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "gesturefilter.h"
+#include "config.h"
+#include <stdlib.h>
+
+/** Weight of a new sample in the gravity estimate is 1/GRAVITY_SMOOTHING. */
+static const int GRAVITY_SMOOTHING = 8;
+
+static quint64 millis(const char* key, unsigned int defaultValue)
+{
+    return (quint64)Config::configuration()->value<unsigned int>(key, defaultValue) * 1000;
+}
+
+GestureFilter::GestureFilter() :
+    accelSink_(this, &GestureFilter::accelDataAvailable),
+    tapSink_(this, &GestureFilter::tapDataAvailable),
+    hardwareTap_(false)
+{
+    addSink(&accelSink_, "accsink");
+    addSink(&tapSink_, "tapsink");
+    addSource(&source_, "gesture");
+
+    Config* config = Config::configuration();
+    shakeThreshold_ = config->value<int>("gesture/shake_threshold", 1500);
+    shakeCount_ = qMax(2u, config->value<unsigned int>("gesture/shake_count", 4));
+    shakeWindow_ = millis("gesture/shake_window", 1000);
+    tapThreshold_ = config->value<int>("gesture/tap_threshold", 800);
+    tapMaxDuration_ = millis("gesture/tap_max_duration", 60);
+    tapMinGap_ = millis("gesture/tap_min_gap", 80);
+    tapMaxGap_ = millis("gesture/tap_max_gap", 400);
+    flipThreshold_ = config->value<int>("gesture/flip_threshold", 800);
+    flipHold_ = millis("gesture/flip_hold", 500);
+    reset();
+}
+
+void GestureFilter::reset()
+{
+    QMutexLocker locker(&mutex_);
+    hasGravity_ = false;
+    shakePeaks_ = 0;
+    shakeQuietUntil_ = 0;
+    inSpike_ = false;
+    hasTap_ = false;
+    face_ = FaceUnknown;
+    candidate_ = FaceUnknown;
+    candidateSince_ = 0;
+}
+
+void GestureFilter::setHardwareTap(bool enabled)
+{
+    QMutexLocker locker(&mutex_);
+    hardwareTap_ = enabled;
+    inSpike_ = false;
+    hasTap_ = false;
+}
+
+void GestureFilter::accelDataAvailable(unsigned n, const AccelerationData* data)
+{
+    QVector<GestureData> events;
+    {
+        QMutexLocker locker(&mutex_);
+        for (unsigned i = 0; i < n; ++i) {
+            const int sample[3] = { data[i].x_, data[i].y_, data[i].z_ };
+            if (!hasGravity_) {
+                for (int j = 0; j < 3; ++j)
+                    gravity_[j] = sample[j];
+                hasGravity_ = true;
+                continue;
+            }
+
+            // Linear acceleration on the dominant axis.
+            int axis = 0;
+            int linear[3];
+            for (int j = 0; j < 3; ++j) {
+                linear[j] = sample[j] - gravity_[j];
+                gravity_[j] += linear[j] / GRAVITY_SMOOTHING;
+                if (abs(linear[j]) > abs(linear[axis]))
+                    axis = j;
+            }
+
+            quint64 t = data[i].timestamp_;
+            detectShake(t, (TapData::Direction)axis, linear[axis], events);
+            if (!hardwareTap_)
+                detectSpike(t, (TapData::Direction)axis, linear[axis], events);
+            detectFlip(t, events);
+        }
+    }
+    if (!events.isEmpty())
+        source_.propagate(events.size(), events.constData());
+}
+
+void GestureFilter::tapDataAvailable(unsigned n, const TapData* data)
+{
+    QVector<GestureData> events;
+    {
+        QMutexLocker locker(&mutex_);
+        if (!hardwareTap_)
+            return;
+        for (unsigned i = 0; i < n; ++i) {
+            if (data[i].type_ == TapData::DoubleTap)
+                events.append(GestureData(data[i].timestamp_, GestureData::DoubleTap, data[i].direction_));
+            else
+                detectTap(data[i].timestamp_, data[i].direction_, events);
+        }
+    }
+    if (!events.isEmpty())
+        source_.propagate(events.size(), events.constData());
+}
+
+void GestureFilter::detectShake(quint64 timestamp, TapData::Direction axis, int value, QVector<GestureData>& events)
+{
+    if (abs(value) < shakeThreshold_)
+        return;
+
+    bool positive = value > 0;
+    if (!shakePeaks_ || axis != shakeAxis_ || timestamp - shakeStart_ > shakeWindow_) {
+        shakePeaks_ = 1;
+        shakeStart_ = timestamp;
+        shakeAxis_ = axis;
+    } else if (positive != shakePositive_) {
+        ++shakePeaks_;
+    }
+    shakePositive_ = positive;
+
+    if (shakePeaks_ >= shakeCount_ && timestamp >= shakeQuietUntil_) {
+        events.append(GestureData(timestamp, GestureData::Shake, axis));
+        shakePeaks_ = 0;
+        shakeQuietUntil_ = timestamp + shakeWindow_;
+        // A shake is no tap.
+        inSpike_ = false;
+        hasTap_ = false;
+    }
+}
+
+void GestureFilter::detectSpike(quint64 timestamp, TapData::Direction axis, int value, QVector<GestureData>& events)
+{
+    if (!inSpike_) {
+        if (abs(value) >= tapThreshold_) {
+            inSpike_ = true;
+            spikeStart_ = timestamp;
+            spikeAxis_ = axis;
+        }
+        return;
+    }
+
+    // Spike ends when it has settled to half of the threshold.
+    if (abs(value) * 2 >= tapThreshold_)
+        return;
+    inSpike_ = false;
+    if (timestamp - spikeStart_ <= tapMaxDuration_)
+        detectTap(spikeStart_, spikeAxis_, events);
+}
+
+void GestureFilter::detectTap(quint64 timestamp, TapData::Direction axis, QVector<GestureData>& events)
+{
+    if (hasTap_ && timestamp >= lastTap_) {
+        quint64 gap = timestamp - lastTap_;
+        // Ringing of the first tap.
+        if (gap < tapMinGap_)
+            return;
+        if (gap <= tapMaxGap_) {
+            events.append(GestureData(timestamp, GestureData::DoubleTap, axis));
+            hasTap_ = false;
+            return;
+        }
+    }
+    hasTap_ = true;
+    lastTap_ = timestamp;
+}
+
+void GestureFilter::detectFlip(quint64 timestamp, QVector<GestureData>& events)
+{
+    Face face = FaceOther;
+    if (gravity_[2] >= flipThreshold_)
+        face = FaceDown;
+    else if (gravity_[2] <= -flipThreshold_)
+        face = FaceUp;
+
+    if (face != candidate_) {
+        candidate_ = face;
+        candidateSince_ = timestamp;
+        return;
+    }
+    if (face == face_ || timestamp - candidateSince_ < flipHold_)
+        return;
+
+    if (face_ != FaceUnknown) {
+        if (face == FaceDown)
+            events.append(GestureData(timestamp, GestureData::FlipDown, TapData::Z));
+        else if (face_ == FaceDown)
+            events.append(GestureData(timestamp, GestureData::FlipUp, TapData::Z));
+    }
+    face_ = face;
+}
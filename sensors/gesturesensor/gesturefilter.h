@@ -0,0 +1,137 @@
+/**
+   @file gesturefilter.h
+   @brief GestureFilter
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef GESTUREFILTER_H
+#define GESTUREFILTER_H
+
+#include <QMutex>
+#include <QVector>
+#include "filter.h"
+#include "orientationdata.h"
+#include "datatypes/tapdata.h"
+#include "datatypes/gesturedata.h"
+
+/**
+ * Detector for shake, double tap and flip gestures.
+ *
+ * Works on the accelerometer stream, in mG. Gravity is tracked with a
+ * low-pass filter and subtracted, leaving the linear acceleration:
+ * - \e Shake is a number of peaks of alternating sign on the same axis
+ *   within a time window.
+ * - \e Tap is a short spike of linear acceleration. Two of them with
+ *   a pause in between make a \e DoubleTap. When taps come from
+ *   hardware through \c tapsink instead, spike detection is off.
+ * - \e FlipDown is sent when gravity has pointed out of the screen for
+ *   a while, \e FlipUp when the device then leaves face down. The
+ *   initial pose does not produce events.
+ *
+ * Only detected gestures are propagated. Sinks may be called from
+ * different adaptor threads.
+ *
+ * Configuration, group \c gesture, times in milliseconds and
+ * accelerations in mG:
+ * - \c shake_threshold, \c shake_count, \c shake_window
+ * - \c tap_threshold, \c tap_max_duration, \c tap_min_gap, \c tap_max_gap
+ * - \c flip_threshold, \c flip_hold
+ */
+class GestureFilter : public FilterBase
+{
+public:
+    static FilterBase* factoryMethod()
+    {
+        return new GestureFilter;
+    }
+
+    /**
+     * Forget gravity, pose and partial gestures.
+     */
+    void reset();
+
+    /**
+     * Take taps from \c tapsink instead of detecting them from the
+     * accelerometer.
+     *
+     * @param enabled are hardware taps used.
+     */
+    void setHardwareTap(bool enabled);
+
+protected:
+    GestureFilter();
+
+private:
+    /**
+     * Pose used for flip detection.
+     */
+    enum Face
+    {
+        FaceUnknown = 0, /**< not settled yet */
+        FaceOther,       /**< neither face up nor face down */
+        FaceUp,          /**< screen up */
+        FaceDown         /**< screen down */
+    };
+
+    void accelDataAvailable(unsigned n, const AccelerationData* data);
+    void tapDataAvailable(unsigned n, const TapData* data);
+
+    void detectShake(quint64 timestamp, TapData::Direction axis, int value, QVector<GestureData>& events);
+    void detectSpike(quint64 timestamp, TapData::Direction axis, int value, QVector<GestureData>& events);
+    void detectTap(quint64 timestamp, TapData::Direction axis, QVector<GestureData>& events);
+    void detectFlip(quint64 timestamp, QVector<GestureData>& events);
+
+    Sink<GestureFilter, AccelerationData> accelSink_;
+    Sink<GestureFilter, TapData>          tapSink_;
+    Source<GestureData>                   source_;
+
+    QMutex   mutex_;            /**< protects the detector state */
+    bool     hardwareTap_;      /**< taps come from tapsink */
+
+    bool     hasGravity_;       /**< has gravity been initialised */
+    int      gravity_[3];       /**< low-passed acceleration, mG */
+
+    int      shakeThreshold_;   /**< minimum peak, mG */
+    unsigned shakeCount_;       /**< peaks making a shake */
+    quint64  shakeWindow_;      /**< time for the peaks, microseconds */
+    unsigned shakePeaks_;       /**< peaks seen so far */
+    quint64  shakeStart_;       /**< time of first peak */
+    TapData::Direction shakeAxis_; /**< axis of the peaks */
+    bool     shakePositive_;    /**< sign of the latest peak */
+    quint64  shakeQuietUntil_;  /**< no new shake before this */
+
+    int      tapThreshold_;     /**< minimum spike, mG */
+    quint64  tapMaxDuration_;   /**< longest spike, microseconds */
+    quint64  tapMinGap_;        /**< shortest pause between taps, microseconds */
+    quint64  tapMaxGap_;        /**< longest pause between taps, microseconds */
+    bool     inSpike_;          /**< above tap threshold */
+    quint64  spikeStart_;       /**< time the spike began */
+    TapData::Direction spikeAxis_; /**< axis of the spike */
+    bool     hasTap_;           /**< waiting for a second tap */
+    quint64  lastTap_;          /**< time of the first tap */
+
+    int      flipThreshold_;    /**< gravity on Z for face up or down, mG */
+    quint64  flipHold_;         /**< time a pose must be held, microseconds */
+    Face     face_;             /**< settled pose */
+    Face     candidate_;        /**< pose being held */
+    quint64  candidateSince_;   /**< time the candidate was entered */
+};
+
+#endif // GESTUREFILTER_H
@@ -0,0 +1,48 @@
+/**
+   @file gestureplugin.cpp
+   @brief GesturePlugin
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "gestureplugin.h"
+#include "gesturesensor.h"
+#include "gesturefilter.h"
+#include "sensormanager.h"
+#include "config.h"
+#include "logging.h"
+
+void GesturePlugin::Register(class Loader&)
+{
+    sensordLogD() << "registering gesturesensor";
+    SensorManager& sm = SensorManager::instance();
+    sm.registerSensor<GestureSensorChannel>("gesturesensor");
+    sm.registerFilter<GestureFilter>("gesturefilter");
+}
+
+QStringList GesturePlugin::Dependencies() {
+    QStringList dependencies("accelerometerchain");
+    if (Config::configuration()->value<bool>("gesture/hardware_tap", false))
+        dependencies << "tapadaptor";
+    return dependencies;
+}
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+Q_EXPORT_PLUGIN2(gesturesensor, GesturePlugin)
+#endif
@@ -0,0 +1,152 @@
+/**
+   @file gesturesensor.cpp
+   @brief GestureSensorChannel
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "gesturesensor.h"
+#include "gesturefilter.h"
+
+#include <QMutexLocker>
+#include "sensormanager.h"
+#include "config.h"
+#include "bin.h"
+#include "bufferreader.h"
+#include "cpuboost.h"
+
+GestureSensorChannel::GestureSensorChannel(const QString& id) :
+        AbstractSensorChannel(id),
+        DataEmitter<GestureData>(1),
+        tapAdaptor_(NULL),
+        tapReader_(NULL),
+        previousSample_()
+{
+    SensorManager& sm = SensorManager::instance();
+
+    accelerometerChain_ = sm.requestChain("accelerometerchain");
+    Q_ASSERT( accelerometerChain_ );
+    setValid(accelerometerChain_ && accelerometerChain_->isValid());
+
+    if (Config::configuration()->value<bool>("gesture/hardware_tap", false)) {
+        tapAdaptor_ = sm.requestDeviceAdaptor("tapadaptor");
+        if (tapAdaptor_ && !tapAdaptor_->isValid()) {
+            sensordLogW() << "Tap adaptor not available, detecting taps from accelerometer";
+            sm.releaseDeviceAdaptor("tapadaptor");
+            tapAdaptor_ = NULL;
+        }
+    }
+
+    accelerometerReader_ = new BufferReader<AccelerationData>(1);
+
+    gestureFilter_ = sm.instantiateFilter("gesturefilter");
+    Q_ASSERT( gestureFilter_ );
+
+    outputSink_ = new EmitterSink<GestureData>(this);
+
+    // Create buffers for filter chain
+    filterBin_ = Bin::create(id);
+    filterBin_->add(accelerometerReader_, "accelerometer");
+    filterBin_->add(gestureFilter_, "gesture");
+    filterBin_->add(outputSink_, "output");
+
+    filterBin_->join("accelerometer", "source", "gesture", "accsink");
+    filterBin_->join("gesture", "gesture", "output", "sink");
+
+    // Join datasources to the chain
+    connectToSource(accelerometerChain_, "accelerometer", accelerometerReader_);
+
+    if (tapAdaptor_) {
+        tapReader_ = new BufferReader<TapData>(1);
+        filterBin_->add(tapReader_, "tap");
+        filterBin_->join("tap", "source", "gesture", "tapsink");
+        connectToSource(tapAdaptor_, "tap", tapReader_);
+        static_cast<GestureFilter*>(gestureFilter_)->setHardwareTap(true);
+    }
+
+    setDescription("shake, double tap and flip gestures");
+    setIntervalSource(accelerometerChain_);
+    setDefaultInterval(Config::configuration()->value<unsigned int>("gesture/interval", 10));
+
+    // Gestures need to work with display off
+    addStandbyOverrideSource(accelerometerChain_);
+    if (tapAdaptor_)
+        addStandbyOverrideSource(tapAdaptor_);
+}
+
+GestureSensorChannel::~GestureSensorChannel()
+{
+    SensorManager& sm = SensorManager::instance();
+
+    disconnectFromSource(accelerometerChain_, "accelerometer", accelerometerReader_);
+    if (tapAdaptor_) {
+        disconnectFromSource(tapAdaptor_, "tap", tapReader_);
+        sm.releaseDeviceAdaptor("tapadaptor");
+    }
+    sm.releaseChain("accelerometerchain");
+
+    delete accelerometerReader_;
+    delete tapReader_;
+    delete gestureFilter_;
+    delete outputSink_;
+    delete filterBin_;
+}
+
+bool GestureSensorChannel::start()
+{
+    sensordLogD() << "Starting GestureSensorChannel";
+
+    if (AbstractSensorChannel::start()) {
+        static_cast<GestureFilter*>(gestureFilter_)->reset();
+        filterBin_->start();
+        accelerometerChain_->start();
+        if (tapAdaptor_)
+            tapAdaptor_->acquireSensor();
+    }
+    return true;
+}
+
+bool GestureSensorChannel::stop()
+{
+    sensordLogD() << "Stopping GestureSensorChannel";
+
+    if (AbstractSensorChannel::stop()) {
+        if (tapAdaptor_)
+            tapAdaptor_->releaseSensor();
+        accelerometerChain_->stop();
+        filterBin_->stop();
+    }
+    return true;
+}
+
+Gesture GestureSensorChannel::get() const
+{
+    QMutexLocker locker(&mutex_);
+    return Gesture(previousSample_);
+}
+
+void GestureSensorChannel::emitData(const GestureData& value)
+{
+    {
+        QMutexLocker locker(&mutex_);
+        previousSample_ = value;
+    }
+    CpuBoost::instance().request(CpuBoost::Tap);
+    writeToClients((const void*)&value, sizeof(value));
+}
@@ -0,0 +1,107 @@
+/**
+   @file gesturesensor.h
+   @brief GestureSensorChannel
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef GESTURE_SENSOR_CHANNEL_H
+#define GESTURE_SENSOR_CHANNEL_H
+
+#include <QMutex>
+
+#include "abstractsensor.h"
+#include "abstractchain.h"
+#include "deviceadaptor.h"
+#include "gesturesensor_a.h"
+#include "dataemitter.h"
+#include "datatypes/orientationdata.h"
+#include "datatypes/tapdata.h"
+#include "datatypes/gesturedata.h"
+#include "datatypes/gesture.h"
+
+class Bin;
+template <class TYPE> class BufferReader;
+class FilterBase;
+
+/**
+ * @brief Sensor for shake, double tap and flip gestures.
+ *
+ * Gestures are detected in sensord from the accelerometer chain (see
+ * GestureFilter) and clients only get a sample when one happens, so
+ * they do not need an accelerometer stream of their own. The
+ * accelerometer runs at <tt>gesture/interval</tt> unless clients ask
+ * for something faster. With <tt>gesture/hardware_tap</tt> set, taps
+ * come from the tap adaptor instead, when it is available.
+ */
+class GestureSensorChannel :
+        public AbstractSensorChannel,
+        public DataEmitter<GestureData>
+{
+    Q_OBJECT;
+    Q_PROPERTY(Gesture value READ get);
+
+public:
+    /**
+     * Factory method for GestureSensorChannel.
+     * @return new GestureSensorChannel as AbstractSensorChannel*.
+     */
+    static AbstractSensorChannel* factoryMethod(const QString& id)
+    {
+        GestureSensorChannel* sc = new GestureSensorChannel(id);
+        new GestureSensorChannelAdaptor(sc);
+
+        return sc;
+    }
+
+    /**
+     * Latest gesture.
+     *
+     * @return latest gesture.
+     */
+    Gesture get() const;
+
+public Q_SLOTS:
+    bool start();
+    bool stop();
+
+signals:
+    void dataAvailable(const Gesture& data);
+
+protected:
+    GestureSensorChannel(const QString& id);
+    ~GestureSensorChannel();
+
+private:
+    Bin*                            filterBin_;
+
+    AbstractChain*                  accelerometerChain_;
+    DeviceAdaptor*                  tapAdaptor_;
+    BufferReader<AccelerationData>* accelerometerReader_;
+    BufferReader<TapData>*          tapReader_;
+    FilterBase*                     gestureFilter_;
+    EmitterSink<GestureData>*       outputSink_;
+
+    GestureData                     previousSample_;
+    mutable QMutex                  mutex_;
+
+    void emitData(const GestureData& value);
+};
+
+#endif // GESTURE_SENSOR_CHANNEL_H
@@ -0,0 +1,13 @@
+TARGET       = gesturesensor
+
+HEADERS += gesturesensor.h   \
+           gesturesensor_a.h \
+           gesturefilter.h \
+           gestureplugin.h
+
+SOURCES += gesturesensor.cpp   \
+           gesturesensor_a.cpp \
+           gesturefilter.cpp \
+           gestureplugin.cpp
+
+include( ../sensor-config.pri )
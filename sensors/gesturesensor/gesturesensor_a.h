@@ -0,0 +1,49 @@
+/**
+   @file gesturesensor_a.h
+   @brief GestureSensorChannelAdaptor
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef GESTURE_SENSOR_H
+#define GESTURE_SENSOR_H
+
+#include <QtDBus/QtDBus>
+
+#include "abstractsensor_a.h"
+#include "datatypes/gesture.h"
+
+class GestureSensorChannelAdaptor : public AbstractSensorChannelAdaptor
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(GestureSensorChannelAdaptor)
+    Q_CLASSINFO("D-Bus Interface", "local.GestureSensor")
+    Q_PROPERTY(Gesture value READ value)
+
+public:
+    GestureSensorChannelAdaptor(QObject* parent);
+
+public Q_SLOTS:
+    Gesture value() const;
+
+Q_SIGNALS:
+    void dataAvailable(const Gesture& data);
+};
+
+#endif
@@ -28,58 +28,41 @@
 
 #include "sensormanager.h"
 #include "bin.h"
-#include "bufferreader.h"
 
 GyroscopeSensorChannel::GyroscopeSensorChannel(const QString& id) :
         AbstractSensorChannel(id),
-        DataEmitter<TimedXyzData>(10),
+        DataEmitter<TimedXyzData>(32),
         previousSample_()
 {
     SensorManager& sm = SensorManager::instance();
 
-    gyroscopeAdaptor_ = sm.requestDeviceAdaptor("gyroscopeadaptor");
-    Q_ASSERT( gyroscopeAdaptor_ );
+    gyroscopeChain_ = sm.requestChain("gyroscopechain");
+    Q_ASSERT( gyroscopeChain_ );
+    setValid(gyroscopeChain_->isValid());
 
-    gyroscopeReader_ = new BufferReader<TimedXyzData>(1);
-
-    outputBuffer_ = new RingBuffer<TimedXyzData>(1);
-
-    // Create buffers for filter chain
-    filterBin_ = new Bin;
-    filterBin_->add(gyroscopeReader_, "gyroscope");
-    filterBin_->add(outputBuffer_, "output");
-
-    filterBin_->join("gyroscope", "source", "output", "sink");
-
-    // Join datasources to the chain
-    connectToSource(gyroscopeAdaptor_, "gyroscope", gyroscopeReader_);
-
-    marshallingBin_ = new Bin;
+    marshallingBin_ = Bin::create(id);
     marshallingBin_->add(this, "sensorchannel");
 
-    outputBuffer_->join(this);
+    // Chain output is passed on as is, so read it directly instead of
+    // copying it into a private buffer first.
+    connectToSource(gyroscopeChain_, "gyroscope", this);
 
     // Set MetaData
     setDescription("x, y, and z axes angular velocity in mdps");
-    setRangeSource(gyroscopeAdaptor_);
-    addStandbyOverrideSource(gyroscopeAdaptor_);
-    setIntervalSource(gyroscopeAdaptor_);
-
-    setValid(true);
+    setRangeSource(gyroscopeChain_);
+    addStandbyOverrideSource(gyroscopeChain_);
+    setIntervalSource(gyroscopeChain_);
 }
 
 GyroscopeSensorChannel::~GyroscopeSensorChannel()
 {
     SensorManager& sm = SensorManager::instance();
 
-    disconnectFromSource(gyroscopeAdaptor_, "gyroscope", gyroscopeReader_);
+    disconnectFromSource(gyroscopeChain_, "gyroscope", this);
 
-    sm.releaseDeviceAdaptor("gyroscopeadaptor");
+    sm.releaseChain("gyroscopechain");
 
-    delete gyroscopeReader_;
-    delete outputBuffer_;
     delete marshallingBin_;
-    delete filterBin_;
 }
 
 bool GyroscopeSensorChannel::start()
@@ -88,8 +71,7 @@ bool GyroscopeSensorChannel::start()
 
     if (AbstractSensorChannel::start()) {
         marshallingBin_->start();
-        filterBin_->start();
-        gyroscopeAdaptor_->startSensor();
+        gyroscopeChain_->start();
     }
     return true;
 }
@@ -99,8 +81,7 @@ bool GyroscopeSensorChannel::stop()
     sensordLogD() << "Stopping GyroscopeSensorChannel";
 
     if (AbstractSensorChannel::stop()) {
-        gyroscopeAdaptor_->stopSensor();
-        filterBin_->stop();
+        gyroscopeChain_->stop();
         marshallingBin_->stop();
     }
     return true;
@@ -109,5 +90,29 @@ bool GyroscopeSensorChannel::stop()
 void GyroscopeSensorChannel::emitData(const TimedXyzData& value)
 {
     previousSample_ = value;
-    writeToClients((const void*)(&value), sizeof(TimedXyzData));
+    downsampleAndPropagate(value, downsampleBuffer_);
+}
+
+void GyroscopeSensorChannel::emitBatch(const TimedXyzData* values, unsigned n)
+{
+    previousSample_ = values[n - 1];
+    downsampleAndPropagate(values, n, downsampleBuffer_);
+}
+
+bool GyroscopeSensorChannel::downsamplingSupported() const
+{
+    return true;
+}
+
+int GyroscopeSensorChannel::predicateAxes() const
+{
+    return 3;
+}
+
+void GyroscopeSensorChannel::sampleAxes(const void* source, double* axes) const
+{
+    const TimedXyzData* sample = (const TimedXyzData*)source;
+    axes[0] = sample->x_;
+    axes[1] = sample->y_;
+    axes[2] = sample->z_;
 }
@@ -28,7 +28,7 @@
 #define GYROSCOPE_SENSOR_CHANNEL_H
 
 #include "abstractsensor.h"
-#include "deviceadaptor.h"
+#include "abstractchain.h"
 
 #include "gyroscopesensor_a.h"
 #include "dataemitter.h"
@@ -37,8 +37,6 @@
 #include "datatypes/xyz.h"
 
 class Bin;
-template <class TYPE> class BufferReader;
-class FilterBase;
 
 class GyroscopeSensorChannel :
         public AbstractSensorChannel,
@@ -62,6 +60,8 @@ public:
 
     XYZ get() const { return previousSample_; }
 
+    virtual bool downsamplingSupported() const;
+
 public Q_SLOTS:
     bool start();
     bool stop();
@@ -73,17 +73,19 @@ protected:
     GyroscopeSensorChannel(const QString& id);
     ~GyroscopeSensorChannel();
 
+    virtual int predicateAxes() const;
+    virtual void sampleAxes(const void* source, double* axes) const;
+
 private:
-    Bin*                         filterBin_;
-    Bin*                         marshallingBin_;
+    Bin*                        marshallingBin_;
 
-    DeviceAdaptor*                     gyroscopeAdaptor_;
-    BufferReader<TimedXyzData>* gyroscopeReader_;
-    RingBuffer<TimedXyzData>*   outputBuffer_;
+    AbstractChain*              gyroscopeChain_;
 
     TimedXyzData                previousSample_;
+    TimedXyzDownsampleBuffer    downsampleBuffer_;
 
     void emitData(const TimedXyzData& value);
+    void emitBatch(const TimedXyzData* values, unsigned n);
 
 };
 
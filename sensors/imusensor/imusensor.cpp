@@ -0,0 +1,160 @@
+/**
+   @file imusensor.cpp
+   @brief ImuSensorChannel
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "imusensor.h"
+#include "imusyncfilter.h"
+
+#include <QMutexLocker>
+#include "sensormanager.h"
+#include "config.h"
+#include "bin.h"
+#include "bufferreader.h"
+
+ImuSensorChannel::ImuSensorChannel(const QString& id) :
+        AbstractSensorChannel(id),
+        DataEmitter<TimedImuData>(10),
+        magChain_(NULL),
+        magReader_(NULL),
+        previousSample_()
+{
+    SensorManager& sm = SensorManager::instance();
+
+    gyroscopeAdaptor_ = sm.requestDeviceAdaptor("gyroscopeadaptor");
+    Q_ASSERT( gyroscopeAdaptor_ );
+
+    accelerometerChain_ = sm.requestChain("accelerometerchain");
+    Q_ASSERT( accelerometerChain_ );
+
+    bool valid = gyroscopeAdaptor_ && gyroscopeAdaptor_->isValid() &&
+                 accelerometerChain_ && accelerometerChain_->isValid();
+
+    if (Config::configuration()->value<bool>("imu/magnetometer", true)) {
+        magChain_ = sm.requestChain("magcalibrationchain");
+        Q_ASSERT( magChain_ );
+        valid = valid && magChain_ && magChain_->isValid();
+    }
+    setValid(valid);
+
+    gyroscopeReader_ = new BufferReader<TimedXyzData>(1);
+    accelerometerReader_ = new BufferReader<AccelerationData>(1);
+
+    syncFilter_ = sm.instantiateFilter("imusyncfilter");
+    Q_ASSERT( syncFilter_ );
+
+    outputSink_ = new EmitterSink<TimedImuData>(this);
+
+    // Create buffers for filter chain
+    filterBin_ = Bin::create(id);
+    filterBin_->add(gyroscopeReader_, "gyroscope");
+    filterBin_->add(accelerometerReader_, "accelerometer");
+    filterBin_->add(syncFilter_, "sync");
+    filterBin_->add(outputSink_, "output");
+
+    filterBin_->join("gyroscope", "source", "sync", "gyrosink");
+    filterBin_->join("accelerometer", "source", "sync", "accsink");
+    filterBin_->join("sync", "imu", "output", "sink");
+
+    // Join datasources to the chain
+    connectToSource(gyroscopeAdaptor_, "gyroscope", gyroscopeReader_);
+    connectToSource(accelerometerChain_, "accelerometer", accelerometerReader_);
+
+    if (magChain_) {
+        magReader_ = new BufferReader<CalibratedMagneticFieldData>(1);
+        filterBin_->add(magReader_, "magnetometer");
+        filterBin_->join("magnetometer", "source", "sync", "magsink");
+        connectToSource(magChain_, "calibratedmagnetometerdata", magReader_);
+    }
+
+    setDescription("time-aligned accelerometer, gyroscope and magnetometer frames");
+    addStandbyOverrideSource(gyroscopeAdaptor_);
+    addStandbyOverrideSource(accelerometerChain_);
+    if (magChain_)
+        addStandbyOverrideSource(magChain_);
+    setIntervalSource(gyroscopeAdaptor_);
+}
+
+ImuSensorChannel::~ImuSensorChannel()
+{
+    SensorManager& sm = SensorManager::instance();
+
+    disconnectFromSource(gyroscopeAdaptor_, "gyroscope", gyroscopeReader_);
+    disconnectFromSource(accelerometerChain_, "accelerometer", accelerometerReader_);
+    if (magChain_) {
+        disconnectFromSource(magChain_, "calibratedmagnetometerdata", magReader_);
+        sm.releaseChain("magcalibrationchain");
+    }
+
+    sm.releaseDeviceAdaptor("gyroscopeadaptor");
+    sm.releaseChain("accelerometerchain");
+
+    delete gyroscopeReader_;
+    delete accelerometerReader_;
+    delete magReader_;
+    delete syncFilter_;
+    delete outputSink_;
+    delete filterBin_;
+}
+
+bool ImuSensorChannel::start()
+{
+    sensordLogD() << "Starting ImuSensorChannel";
+
+    if (AbstractSensorChannel::start()) {
+        static_cast<ImuSyncFilter*>(syncFilter_)->reset();
+        filterBin_->start();
+        gyroscopeAdaptor_->acquireSensor();
+        accelerometerChain_->start();
+        if (magChain_)
+            magChain_->start();
+    }
+    return true;
+}
+
+bool ImuSensorChannel::stop()
+{
+    sensordLogD() << "Stopping ImuSensorChannel";
+
+    if (AbstractSensorChannel::stop()) {
+        if (magChain_)
+            magChain_->stop();
+        accelerometerChain_->stop();
+        gyroscopeAdaptor_->releaseSensor();
+        filterBin_->stop();
+    }
+    return true;
+}
+
+Imu ImuSensorChannel::get() const
+{
+    QMutexLocker locker(&mutex_);
+    return Imu(previousSample_);
+}
+
+void ImuSensorChannel::emitData(const TimedImuData& value)
+{
+    {
+        QMutexLocker locker(&mutex_);
+        previousSample_ = value;
+    }
+    writeToClients((const void*)&value, sizeof(value));
+}
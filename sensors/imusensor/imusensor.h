@@ -0,0 +1,109 @@
+/**
+   @file imusensor.h
+   @brief ImuSensorChannel
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef IMU_SENSOR_CHANNEL_H
+#define IMU_SENSOR_CHANNEL_H
+
+#include <QMutex>
+
+#include "abstractsensor.h"
+#include "abstractchain.h"
+#include "deviceadaptor.h"
+#include "imusensor_a.h"
+#include "dataemitter.h"
+#include "datatypes/orientationdata.h"
+#include "datatypes/imudata.h"
+#include "datatypes/imu.h"
+
+class Bin;
+template <class TYPE> class BufferReader;
+class FilterBase;
+
+/**
+ * @brief Sensor for time-aligned accelerometer, gyroscope and
+ * magnetometer frames.
+ *
+ * IMU clients get all three sensors in one TimedImuData frame per
+ * gyroscope sample (see ImuSyncFilter), with one socket write per
+ * frame, instead of opening three sessions and realigning them.
+ * Gyroscope sets the output rate, so interval requests are passed to
+ * the gyroscope adaptor. The magnetometer is left out when
+ * <tt>imu/magnetometer</tt> is false.
+ */
+class ImuSensorChannel :
+        public AbstractSensorChannel,
+        public DataEmitter<TimedImuData>
+{
+    Q_OBJECT;
+    Q_PROPERTY(Imu value READ get);
+
+public:
+    /**
+     * Factory method for ImuSensorChannel.
+     * @return new ImuSensorChannel as AbstractSensorChannel*.
+     */
+    static AbstractSensorChannel* factoryMethod(const QString& id)
+    {
+        ImuSensorChannel* sc = new ImuSensorChannel(id);
+        new ImuSensorChannelAdaptor(sc);
+
+        return sc;
+    }
+
+    /**
+     * Latest frame.
+     *
+     * @return latest frame.
+     */
+    Imu get() const;
+
+public Q_SLOTS:
+    bool start();
+    bool stop();
+
+signals:
+    void dataAvailable(const Imu& data);
+
+protected:
+    ImuSensorChannel(const QString& id);
+    ~ImuSensorChannel();
+
+private:
+    Bin*                                       filterBin_;
+
+    DeviceAdaptor*                             gyroscopeAdaptor_;
+    AbstractChain*                             accelerometerChain_;
+    AbstractChain*                             magChain_;
+    BufferReader<TimedXyzData>*                gyroscopeReader_;
+    BufferReader<AccelerationData>*            accelerometerReader_;
+    BufferReader<CalibratedMagneticFieldData>* magReader_;
+    FilterBase*                                syncFilter_;
+    EmitterSink<TimedImuData>*                 outputSink_;
+
+    TimedImuData                               previousSample_;
+    mutable QMutex                             mutex_;
+
+    void emitData(const TimedImuData& value);
+};
+
+#endif // IMU_SENSOR_CHANNEL_H
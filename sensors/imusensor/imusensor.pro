@@ -0,0 +1,13 @@
+TARGET       = imusensor
+
+HEADERS += imusensor.h   \
+           imusensor_a.h \
+           imusyncfilter.h \
+           imuplugin.h
+
+SOURCES += imusensor.cpp   \
+           imusensor_a.cpp \
+           imusyncfilter.cpp \
+           imuplugin.cpp
+
+include( ../sensor-config.pri )
@@ -0,0 +1,116 @@
+/**
+   @file imusyncfilter.cpp
+   @brief ImuSyncFilter
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "imusyncfilter.h"
+#include "config.h"
+
+ImuSyncFilter::ImuSyncFilter() :
+    gyroSink_(this, &ImuSyncFilter::gyroDataAvailable),
+    accelSink_(this, &ImuSyncFilter::accelDataAvailable),
+    magSink_(this, &ImuSyncFilter::magDataAvailable)
+{
+    addSink(&gyroSink_, "gyrosink");
+    addSink(&accelSink_, "accsink");
+    addSink(&magSink_, "magsink");
+    addSource(&source_, "imu");
+
+    maxSkew_ = (quint64)Config::configuration()->value<unsigned int>("imu/max_skew", 50) * 1000;
+    magMaxAge_ = (quint64)Config::configuration()->value<unsigned int>("imu/magnetometer_max_age", 500) * 1000;
+    reset();
+}
+
+void ImuSyncFilter::reset()
+{
+    QMutexLocker locker(&mutex_);
+    accelCount_ = 0;
+    hasMag_ = false;
+}
+
+void ImuSyncFilter::accelDataAvailable(unsigned n, const AccelerationData* data)
+{
+    QMutexLocker locker(&mutex_);
+    for (unsigned i = 0; i < n; ++i) {
+        accel_[0] = accel_[1];
+        accel_[1] = data[i];
+        if (accelCount_ < 2)
+            ++accelCount_;
+    }
+}
+
+void ImuSyncFilter::magDataAvailable(unsigned n, const CalibratedMagneticFieldData* data)
+{
+    if (!n)
+        return;
+    QMutexLocker locker(&mutex_);
+    mag_ = data[n - 1];
+    hasMag_ = true;
+}
+
+void ImuSyncFilter::alignAccel(TimedImuData& frame) const
+{
+    const AccelerationData& latest = accel_[1];
+    const AccelerationData& previous = accel_[0];
+    quint64 t = frame.timestamp_;
+    if (accelCount_ > 1 && t >= previous.timestamp_ && t < latest.timestamp_) {
+        qint64 span = latest.timestamp_ - previous.timestamp_;
+        qint64 offset = t - previous.timestamp_;
+        frame.ax_ = previous.x_ + (int)((qint64)(latest.x_ - previous.x_) * offset / span);
+        frame.ay_ = previous.y_ + (int)((qint64)(latest.y_ - previous.y_) * offset / span);
+        frame.az_ = previous.z_ + (int)((qint64)(latest.z_ - previous.z_) * offset / span);
+    } else {
+        frame.ax_ = latest.x_;
+        frame.ay_ = latest.y_;
+        frame.az_ = latest.z_;
+    }
+}
+
+void ImuSyncFilter::gyroDataAvailable(unsigned n, const TimedXyzData* data)
+{
+    frames_.resize(0);
+    {
+        QMutexLocker locker(&mutex_);
+        for (unsigned i = 0; i < n; ++i) {
+            quint64 t = data[i].timestamp_;
+            // Nothing to align to, or the accelerometer has stalled.
+            if (!accelCount_ || (t > accel_[1].timestamp_ && t - accel_[1].timestamp_ > maxSkew_))
+                continue;
+
+            TimedImuData frame;
+            frame.timestamp_ = t;
+            frame.gx_ = data[i].x_;
+            frame.gy_ = data[i].y_;
+            frame.gz_ = data[i].z_;
+            alignAccel(frame);
+            if (hasMag_ && (t <= mag_.timestamp_ || t - mag_.timestamp_ <= magMaxAge_)) {
+                // Hard iron corrected, like FusionFilter uses it.
+                frame.mx_ = mag_.rx_ - mag_.x_;
+                frame.my_ = mag_.ry_ - mag_.y_;
+                frame.mz_ = mag_.rz_ - mag_.z_;
+                frame.flags_ |= TimedImuData::HasMagnetometer;
+            }
+            frames_.append(frame);
+        }
+    }
+    if (!frames_.isEmpty())
+        source_.propagate(frames_.size(), frames_.constData());
+}
@@ -0,0 +1,94 @@
+/**
+   @file imusyncfilter.h
+   @brief ImuSyncFilter
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef IMUSYNCFILTER_H
+#define IMUSYNCFILTER_H
+
+#include <QMutex>
+#include <QVector>
+#include "filter.h"
+#include "orientationdata.h"
+#include "datatypes/imudata.h"
+
+/**
+ * Synchronizer combining accelerometer, gyroscope and magnetometer
+ * streams into TimedImuData frames.
+ *
+ * Gyroscope samples drive the output: each one produces a frame with
+ * its own timestamp. The accelerometer is linearly interpolated between
+ * the two samples around the gyroscope timestamp, or held when the
+ * gyroscope is ahead. The magnetometer is slow and held. Frames are
+ * dropped until the accelerometer has delivered, and while its latest
+ * sample is older than the allowed skew. Sinks may be called from
+ * different adaptor threads.
+ *
+ * Configuration, group \c imu:
+ * - \c max_skew oldest accelerometer sample used for a frame, relative
+ *   to the gyroscope sample, milliseconds. Default 50.
+ * - \c magnetometer_max_age oldest magnetometer sample included,
+ *   milliseconds. Default 500.
+ */
+class ImuSyncFilter : public FilterBase
+{
+public:
+    static FilterBase* factoryMethod()
+    {
+        return new ImuSyncFilter;
+    }
+
+    /**
+     * Forget held samples.
+     */
+    void reset();
+
+protected:
+    ImuSyncFilter();
+
+private:
+    void gyroDataAvailable(unsigned n, const TimedXyzData* data);
+    void accelDataAvailable(unsigned n, const AccelerationData* data);
+    void magDataAvailable(unsigned n, const CalibratedMagneticFieldData* data);
+
+    /**
+     * Fill accelerometer fields of a frame for its timestamp.
+     *
+     * @param frame frame with the gyroscope timestamp set.
+     */
+    void alignAccel(TimedImuData& frame) const;
+
+    Sink<ImuSyncFilter, TimedXyzData>                gyroSink_;
+    Sink<ImuSyncFilter, AccelerationData>            accelSink_;
+    Sink<ImuSyncFilter, CalibratedMagneticFieldData> magSink_;
+    Source<TimedImuData>                             source_;
+
+    QMutex           mutex_;          /**< protects the held samples */
+    AccelerationData accel_[2];       /**< previous and latest accelerometer sample */
+    unsigned         accelCount_;     /**< number of valid entries in accel_ */
+    CalibratedMagneticFieldData mag_; /**< latest magnetometer sample */
+    bool             hasMag_;         /**< has magnetometer data arrived */
+    quint64          maxSkew_;        /**< accelerometer age limit, microseconds */
+    quint64          magMaxAge_;      /**< magnetometer age limit, microseconds */
+    QVector<TimedImuData> frames_;    /**< frames of a gyroscope batch, gyroscope thread only */
+};
+
+#endif // IMUSYNCFILTER_H
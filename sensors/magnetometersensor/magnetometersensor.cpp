@@ -34,8 +34,7 @@
 
 MagnetometerSensorChannel::MagnetometerSensorChannel(const QString& id) :
         AbstractSensorChannel(id),
-        DataEmitter<CalibratedMagneticFieldData>(1),
-        scaleFilter_(NULL),
+        DataEmitter<CalibratedMagneticFieldData>(32),
         prevMeasurement_()
 {
     SensorManager& sm = SensorManager::instance();
@@ -44,47 +43,28 @@ MagnetometerSensorChannel::MagnetometerSensorChannel(const QString& id) :
     Q_ASSERT( compassChain_ );
     setValid(compassChain_->isValid());
 
-    magnetometerReader_ = new BufferReader<CalibratedMagneticFieldData>(1);
+    magnetometerReader_ = new BufferReader<CalibratedMagneticFieldData>(32);
 
     scaleCoefficient_ = Config::configuration()->value("magnetometer/scale_coefficient", QVariant(300)).toInt();
 
-    if (scaleCoefficient_ != 1)
-    {
-        scaleFilter_ = sm.instantiateFilter("magnetometerscalefilter");
-        if (scaleFilter_ == NULL)
-        {
-            sensordLogW() << "Failed to initialise scaling filter for magnetometer.";
-        }
-    }
+    // The calibration filter scales as part of calibrating, scaled
+    // output comes from its own buffer.
+    outputName_ = scaleCoefficient_ != 1 ? "scaledmagnetometerdata" : "calibratedmagnetometerdata";
 
-    outputBuffer_ = new RingBuffer<CalibratedMagneticFieldData>(1);
+    outputSink_ = new EmitterSink<CalibratedMagneticFieldData>(this);
 
     // Create buffers for filter chain
-    filterBin_ = new Bin;
+    filterBin_ = Bin::create(id);
 
     filterBin_->add(magnetometerReader_, "magnetometer");
-    filterBin_->add(outputBuffer_, "buffer");
-
-    if (scaleFilter_)
-    {
-        filterBin_->add(scaleFilter_, "filter");
-        filterBin_->join("magnetometer", "source", "filter", "sink");
-        filterBin_->join("filter", "source", "buffer", "sink");
-    } else
-    {
-        filterBin_->join("magnetometer", "source", "buffer", "sink");
-    }
+    filterBin_->add(outputSink_, "buffer");
+    filterBin_->join("magnetometer", "source", "buffer", "sink");
 
     // Join datasources to the chain
-    connectToSource(compassChain_, "calibratedmagnetometerdata", magnetometerReader_);
-
-    marshallingBin_ = new Bin;
-    marshallingBin_->add(this, "sensorchannel");
-
-    outputBuffer_->join(this);
+    connectToSource(compassChain_, outputName_, magnetometerReader_);
 
     // AK897X requires scaling, which affects available ranges
-    if (scaleFilter_)
+    if (scaleCoefficient_ != 1)
     {
         // Get available ranges and introduce modified ones
         QList<DataRange> rangeList = compassChain_->getAvailableDataRanges();
@@ -106,14 +86,11 @@ MagnetometerSensorChannel::~MagnetometerSensorChannel()
 {
     SensorManager& sm = SensorManager::instance();
 
-    disconnectFromSource(compassChain_, "calibratedmagnetometerdata", magnetometerReader_);
+    disconnectFromSource(compassChain_, outputName_, magnetometerReader_);
     sm.releaseChain("magcalibrationchain");
 
-    if (scaleFilter_) delete scaleFilter_;
-
     delete magnetometerReader_;
-    delete outputBuffer_;
-    delete marshallingBin_;
+    delete outputSink_;
     delete filterBin_;
 }
 
@@ -122,7 +99,6 @@ bool MagnetometerSensorChannel::start()
     sensordLogD() << "Starting MagnetometerSensorChannel";
 
     if (AbstractSensorChannel::start()) {
-        marshallingBin_->start();
         filterBin_->start();
         compassChain_->start();
     }
@@ -136,7 +112,6 @@ bool MagnetometerSensorChannel::stop()
     if (AbstractSensorChannel::stop()) {
         compassChain_->stop();
         filterBin_->stop();
-        marshallingBin_->stop();
     }
     return true;
 }
@@ -148,6 +123,14 @@ void MagnetometerSensorChannel::emitData(const CalibratedMagneticFieldData& valu
     emit internalData(value);
 }
 
+void MagnetometerSensorChannel::emitBatch(const CalibratedMagneticFieldData* values, unsigned n)
+{
+    prevMeasurement_ = values[n - 1];
+    downsampleAndPropagate(values, n, downsampleBuffer_);
+    for (unsigned i = 0; i < n; ++i)
+        emit internalData(values[i]);
+}
+
 void MagnetometerSensorChannel::resetCalibration()
 {
     if (!compassChain_)
@@ -166,13 +149,20 @@ bool MagnetometerSensorChannel::setDataRange(const DataRange& range, int session
     return true;
 }
 
-void MagnetometerSensorChannel::removeSession(int sessionId)
+bool MagnetometerSensorChannel::downsamplingSupported() const
 {
-    downsampleBuffer_.remove(sessionId);
-    AbstractSensorChannel::removeSession(sessionId);
+    return true;
 }
 
-bool MagnetometerSensorChannel::downsamplingSupported() const
+int MagnetometerSensorChannel::predicateAxes() const
 {
-    return true;
+    return 3;
+}
+
+void MagnetometerSensorChannel::sampleAxes(const void* source, double* axes) const
+{
+    const CalibratedMagneticFieldData* sample = (const CalibratedMagneticFieldData*)source;
+    axes[0] = sample->x_;
+    axes[1] = sample->y_;
+    axes[2] = sample->z_;
 }
@@ -37,7 +37,6 @@
 
 class Bin;
 template <class TYPE> class BufferReader;
-class FilterBase;
 
 /**
  * @brief Sensor providing magnetic field measurements.
@@ -69,8 +68,6 @@ public:
         return MagneticField(prevMeasurement_);
     }
 
-    virtual void removeSession(int sessionId);
-
     virtual bool downsamplingSupported() const;
 
 public Q_SLOTS:
@@ -89,20 +86,23 @@ protected:
     MagnetometerSensorChannel(const QString& id);
     virtual ~MagnetometerSensorChannel();
 
+    virtual int predicateAxes() const;
+    virtual void sampleAxes(const void* source, double* axes) const;
+
     virtual bool setDataRange(const DataRange& range, int sessionId);
 
 private:
     Bin*                                       filterBin_;
-    Bin*                                       marshallingBin_;
     AbstractChain*                             compassChain_;
-    FilterBase*                                scaleFilter_;
     BufferReader<CalibratedMagneticFieldData>* magnetometerReader_;
-    RingBuffer<CalibratedMagneticFieldData>*   outputBuffer_;
+    EmitterSink<CalibratedMagneticFieldData>*  outputSink_;
     CalibratedMagneticFieldData                prevMeasurement_;
     int                                        scaleCoefficient_;
+    QString                                    outputName_;
     MagneticFieldDownsampleBuffer              downsampleBuffer_;
 
     void emitData(const CalibratedMagneticFieldData& value);
+    void emitBatch(const CalibratedMagneticFieldData* values, unsigned n);
 };
 
 #endif // MAGNETOMETER_SENSOR_CHANNEL_H
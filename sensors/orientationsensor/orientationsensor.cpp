@@ -28,7 +28,6 @@
 
 #include "sensormanager.h"
 #include "bin.h"
-#include "bufferreader.h"
 
 OrientationSensorChannel::OrientationSensorChannel(const QString& id) :
         AbstractSensorChannel(id),
@@ -41,27 +40,12 @@ OrientationSensorChannel::OrientationSensorChannel(const QString& id) :
     Q_ASSERT( orientationChain_ );
     setValid(orientationChain_->isValid());
 
-    orientationReader_ = new BufferReader<PoseData>(1);
-
-    outputBuffer_ = new RingBuffer<PoseData>(1);
-
-    // Create buffers for filter chain
-    filterBin_ = new Bin;
-
-    filterBin_->add(orientationReader_, "orientation");
-    filterBin_->add(outputBuffer_, "buffer");
-
-    // Join filterchain buffers
-    filterBin_->join("orientation", "source", "buffer", "sink");
-    filterBin_->join("face", "source", "buffer", "sink");
-
-    // Join datasources to the chain
-    connectToSource(orientationChain_, "orientation", orientationReader_);
-
-    marshallingBin_ = new Bin;
+    marshallingBin_ = Bin::create(id);
     marshallingBin_->add(this, "sensorchannel");
 
-    outputBuffer_->join(this);
+    // Chain output is passed on as is, so read it directly instead of
+    // copying it into a private buffer first.
+    connectToSource(orientationChain_, "orientation", this);
 
     setDescription("orientation of the device screen as 6 pre-defined positions");
     setRangeSource(orientationChain_);
@@ -73,14 +57,11 @@ OrientationSensorChannel::~OrientationSensorChannel()
 {
     SensorManager& sm = SensorManager::instance();
 
-    disconnectFromSource(orientationChain_, "orientation", orientationReader_);
+    disconnectFromSource(orientationChain_, "orientation", this);
 
     sm.releaseChain("orientationchain");
 
-    delete orientationReader_;
-    delete outputBuffer_;
     delete marshallingBin_;
-    delete filterBin_;
 }
 
 bool OrientationSensorChannel::start()
@@ -89,7 +70,6 @@ bool OrientationSensorChannel::start()
 
     if (AbstractSensorChannel::start()) {
         marshallingBin_->start();
-        filterBin_->start();
         orientationChain_->start();
     }
     return true;
@@ -101,7 +81,6 @@ bool OrientationSensorChannel::stop()
 
     if (AbstractSensorChannel::stop()) {
         orientationChain_->stop();
-        filterBin_->stop();
         marshallingBin_->stop();
     }
     return true;
@@ -115,3 +94,8 @@ void OrientationSensorChannel::emitData(const PoseData& value)
         writeToClients((const void *)&value, sizeof(value));
     }
 }
+
+bool OrientationSensorChannel::sampleChanged(const void* previous, const void* current, int, unsigned int) const
+{
+    return ((const PoseData*)previous)->orientation_ != ((const PoseData*)current)->orientation_;
+}
@@ -35,8 +35,6 @@
 #include "datatypes/unsigned.h"
 
 class Bin;
-template <class TYPE> class BufferReader;
-class FilterBase;
 
 /**
  * @brief Sensor for accessing device orientation.
@@ -44,6 +42,10 @@ class FilterBase;
  * Provides device orientation based on the direction of acceleration vector.
  * Threshold value (mG) is used to control the sensitivity of change from one
  * orientation into another. See #OrientationInterpreter for details on threshold.
+ *
+ * Sessions only get a sample when the orientation changes. Read the
+ * \c orientation property for the current state, for example right
+ * after starting.
  */
 class OrientationSensorChannel :
         public AbstractSensorChannel,
@@ -91,17 +93,14 @@ protected:
     OrientationSensorChannel(const QString& id);
     virtual ~OrientationSensorChannel();
 
+    virtual bool sampleChanged(const void* previous, const void* current, int size, unsigned int deadband) const;
+
 private:
     PoseData                         prevOrientation;
-    Bin*                             filterBin_;
     Bin*                             marshallingBin_;
 
     AbstractChain*                   orientationChain_;
 
-    BufferReader<PoseData>*   orientationReader_;
-
-    RingBuffer<PoseData>*            outputBuffer_;
-
     /**
      * Emits new device orientation through DBus.
      * @param value Orientation value to emit.
@@ -30,10 +30,12 @@
 #include "sensormanager.h"
 #include "bin.h"
 #include "bufferreader.h"
+#include "cpuboost.h"
 
 ProximitySensorChannel::ProximitySensorChannel(const QString& id) :
         AbstractSensorChannel(id),
-        DataEmitter<ProximityData>(1)
+        DataEmitter<ProximityData>(1),
+        previousValid_(false)
 {
     SensorManager& sm = SensorManager::instance();
 
@@ -42,24 +44,19 @@ ProximitySensorChannel::ProximitySensorChannel(const QString& id) :
 
     proximityReader_ = new BufferReader<ProximityData>(1);
 
-    outputBuffer_ = new RingBuffer<ProximityData>(1);
+    outputSink_ = new EmitterSink<ProximityData>(this);
 
     // Create buffers for filter chain
-    filterBin_ = new Bin;
+    filterBin_ = Bin::create(id);
 
     filterBin_->add(proximityReader_, "proximity");
-    filterBin_->add(outputBuffer_, "buffer");
+    filterBin_->add(outputSink_, "buffer");
 
     filterBin_->join("proximity", "source", "buffer", "sink");
 
     // Join datasources to the chain
     connectToSource(proximityAdaptor_, "proximity", proximityReader_);
 
-    marshallingBin_ = new Bin;
-    marshallingBin_->add(this, "sensorchannel");
-
-    outputBuffer_->join(this);
-
     setValid(true);
 
     setDescription("whether an object is close to device screen");
@@ -77,8 +74,7 @@ ProximitySensorChannel::~ProximitySensorChannel()
     sm.releaseDeviceAdaptor("proximityadaptor");
 
     delete proximityReader_;
-    delete outputBuffer_;
-    delete marshallingBin_;
+    delete outputSink_;
     delete filterBin_;
 }
 
@@ -87,9 +83,11 @@ bool ProximitySensorChannel::start()
     sensordLogD() << "Starting ProximitySensorChannel";
 
     if (AbstractSensorChannel::start()) {
-        marshallingBin_->start();
+        // The adaptor reports its current state on start, pass it on
+        // even if it is the same as before the last stop.
+        previousValid_ = false;
         filterBin_->start();
-        proximityAdaptor_->startSensor();
+        proximityAdaptor_->acquireSensor();
     }
     return true;
 }
@@ -99,9 +97,8 @@ bool ProximitySensorChannel::stop()
     sensordLogD() << "Stopping ProximitySensorChannel";
 
     if (AbstractSensorChannel::stop()) {
-        proximityAdaptor_->stopSensor();
+        proximityAdaptor_->releaseSensor();
         filterBin_->stop();
-        marshallingBin_->stop();
     }
     return true;
 }
@@ -110,11 +107,35 @@ void ProximitySensorChannel::emitData(const ProximityData& value)
 {
     previousValue_.timestamp_ = value.timestamp_;
 
-    if (value.value_ != previousValue_.value_ ||
+    if (!previousValid_ ||
+        value.value_ != previousValue_.value_ ||
         value.withinProximity_ != previousValue_.withinProximity_)
     {
+        // Something approached, the display is typically blanked next.
+        if (value.withinProximity_ && !previousValue_.withinProximity_)
+            CpuBoost::instance().request(CpuBoost::ProximityNear);
         previousValue_.value_ = value.value_;
         previousValue_.withinProximity_ = value.withinProximity_;
+        previousValid_ = true;
         writeToClients((const void *)&value, sizeof(ProximityData));
     }
 }
+
+bool ProximitySensorChannel::sampleChanged(const void* previous, const void* current, int, unsigned int deadband) const
+{
+    const ProximityData* from = (const ProximityData*)previous;
+    const ProximityData* to = (const ProximityData*)current;
+    if (from->withinProximity_ != to->withinProximity_)
+        return true;
+    return (from->value_ > to->value_ ? from->value_ - to->value_ : to->value_ - from->value_) > deadband;
+}
+
+int ProximitySensorChannel::predicateAxes() const
+{
+    return 1;
+}
+
+void ProximitySensorChannel::sampleAxes(const void* source, double* axes) const
+{
+    axes[0] = ((const ProximityData*)source)->value_;
+}
@@ -86,13 +86,18 @@ protected:
     ProximitySensorChannel(const QString& id);
     virtual ~ProximitySensorChannel();
 
+    virtual bool sampleChanged(const void* previous, const void* current, int size, unsigned int deadband) const;
+
+    virtual int predicateAxes() const;
+    virtual void sampleAxes(const void* source, double* axes) const;
+
 private:
     Bin*                         filterBin_;
-    Bin*                         marshallingBin_;
     DeviceAdaptor*               proximityAdaptor_;
     BufferReader<ProximityData>* proximityReader_;
-    RingBuffer<ProximityData>*   outputBuffer_;
+    EmitterSink<ProximityData>*  outputSink_;
     ProximityData                previousValue_;
+    bool                         previousValid_; /**< has previousValue_ been sent since start */
 
     void emitData(const ProximityData& value);
 };
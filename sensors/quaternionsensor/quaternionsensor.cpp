@@ -0,0 +1,125 @@
+/**
+   @file quaternionsensor.cpp
+   @brief QuaternionSensorChannel
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "quaternionsensor.h"
+
+#include <string.h>
+#include <QMutexLocker>
+#include "sensormanager.h"
+#include "bin.h"
+#include "bufferreader.h"
+
+QuaternionSensorChannel::QuaternionSensorChannel(const QString& id) :
+        AbstractSensorChannel(id),
+        DataEmitter<TimedQuaternionData>(10),
+        previousSample_()
+{
+    SensorManager& sm = SensorManager::instance();
+
+    fusionChain_ = sm.requestChain("fusionchain");
+    Q_ASSERT( fusionChain_ );
+    setValid(fusionChain_->isValid());
+
+    fusionReader_ = new BufferReader<TimedQuaternionData>(1);
+
+    outputSink_ = new EmitterSink<TimedQuaternionData>(this);
+
+    // Create buffers for filter chain
+    filterBin_ = Bin::create(id);
+    filterBin_->add(fusionReader_, "quaternion");
+    filterBin_->add(outputSink_, "output");
+
+    filterBin_->join("quaternion", "source", "output", "sink");
+
+    // Join datasources to the chain
+    connectToSource(fusionChain_, "quaternion", fusionReader_);
+
+    setDescription("device attitude as unit quaternion (w, x, y, z)");
+    introduceAvailableDataRange(DataRange(-1, 1, 0));
+    addStandbyOverrideSource(fusionChain_);
+    setIntervalSource(fusionChain_);
+}
+
+QuaternionSensorChannel::~QuaternionSensorChannel()
+{
+    SensorManager& sm = SensorManager::instance();
+
+    disconnectFromSource(fusionChain_, "quaternion", fusionReader_);
+
+    sm.releaseChain("fusionchain");
+
+    delete fusionReader_;
+    delete outputSink_;
+    delete filterBin_;
+}
+
+bool QuaternionSensorChannel::start()
+{
+    sensordLogD() << "Starting QuaternionSensorChannel";
+
+    if (AbstractSensorChannel::start()) {
+        filterBin_->start();
+        fusionChain_->start();
+    }
+    return true;
+}
+
+bool QuaternionSensorChannel::stop()
+{
+    sensordLogD() << "Stopping QuaternionSensorChannel";
+
+    if (AbstractSensorChannel::stop()) {
+        fusionChain_->stop();
+        filterBin_->stop();
+    }
+    return true;
+}
+
+Quaternion QuaternionSensorChannel::get() const
+{
+    QMutexLocker locker(&mutex_);
+    return Quaternion(previousSample_);
+}
+
+void QuaternionSensorChannel::emitData(const TimedQuaternionData& value)
+{
+    {
+        QMutexLocker locker(&mutex_);
+        previousSample_ = value;
+    }
+    writeToClients((const void*)&value, sizeof(value));
+}
+
+bool QuaternionSensorChannel::packedFormatSupported() const
+{
+    return true;
+}
+
+int QuaternionSensorChannel::packSample(const void* source, int size, void* target) const
+{
+    if (size != sizeof(TimedQuaternionData))
+        return 0;
+    PackedQuaternionData packed(*(const TimedQuaternionData*)source);
+    memcpy(target, &packed, sizeof(packed));
+    return sizeof(packed);
+}
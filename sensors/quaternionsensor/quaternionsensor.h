@@ -0,0 +1,101 @@
+/**
+   @file quaternionsensor.h
+   @brief QuaternionSensorChannel
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef QUATERNION_SENSOR_CHANNEL_H
+#define QUATERNION_SENSOR_CHANNEL_H
+
+#include <QMutex>
+
+#include "abstractsensor.h"
+#include "abstractchain.h"
+#include "quaternionsensor_a.h"
+#include "dataemitter.h"
+#include "datatypes/quaterniondata.h"
+#include "datatypes/quaternion.h"
+
+class Bin;
+template <class TYPE> class BufferReader;
+
+/**
+ * @brief Sensor for device attitude as a unit quaternion.
+ *
+ * Streams the output of FusionChain, so clients get the full attitude
+ * in one channel instead of recombining rotation and compass data.
+ * Sessions can select PackedQuaternionData as their wire format.
+ */
+class QuaternionSensorChannel :
+        public AbstractSensorChannel,
+        public DataEmitter<TimedQuaternionData>
+{
+    Q_OBJECT;
+    Q_PROPERTY(Quaternion value READ get);
+
+public:
+    /**
+     * Factory method for QuaternionSensorChannel.
+     * @return new QuaternionSensorChannel as AbstractSensorChannel*.
+     */
+    static AbstractSensorChannel* factoryMethod(const QString& id)
+    {
+        QuaternionSensorChannel* sc = new QuaternionSensorChannel(id);
+        new QuaternionSensorChannelAdaptor(sc);
+
+        return sc;
+    }
+
+    /**
+     * Latest attitude.
+     *
+     * @return latest attitude.
+     */
+    Quaternion get() const;
+
+    virtual bool packedFormatSupported() const;
+
+public Q_SLOTS:
+    bool start();
+    bool stop();
+
+signals:
+    void dataAvailable(const Quaternion& data);
+
+protected:
+    QuaternionSensorChannel(const QString& id);
+    ~QuaternionSensorChannel();
+
+    virtual int packSample(const void* source, int size, void* target) const;
+
+private:
+    Bin*                              filterBin_;
+
+    AbstractChain*                    fusionChain_;
+    BufferReader<TimedQuaternionData>* fusionReader_;
+    EmitterSink<TimedQuaternionData>* outputSink_;
+
+    TimedQuaternionData               previousSample_;
+    mutable QMutex                    mutex_;
+
+    void emitData(const TimedQuaternionData& value);
+};
+
+#endif // QUATERNION_SENSOR_CHANNEL_H
@@ -0,0 +1,11 @@
+TARGET       = quaternionsensor
+
+HEADERS += quaternionsensor.h   \
+           quaternionsensor_a.h \
+           quaternionplugin.h
+
+SOURCES += quaternionsensor.cpp   \
+           quaternionsensor_a.cpp \
+           quaternionplugin.cpp
+
+include( ../sensor-config.pri )
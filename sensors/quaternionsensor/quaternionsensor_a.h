@@ -0,0 +1,49 @@
+/**
+   @file quaternionsensor_a.h
+   @brief QuaternionSensorChannelAdaptor
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef QUATERNION_SENSOR_H
+#define QUATERNION_SENSOR_H
+
+#include <QtDBus/QtDBus>
+
+#include "abstractsensor_a.h"
+#include "datatypes/quaternion.h"
+
+class QuaternionSensorChannelAdaptor : public AbstractSensorChannelAdaptor
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(QuaternionSensorChannelAdaptor)
+    Q_CLASSINFO("D-Bus Interface", "local.QuaternionSensor")
+    Q_PROPERTY(Quaternion value READ value)
+
+public:
+    QuaternionSensorChannelAdaptor(QObject* parent);
+
+public Q_SLOTS:
+    Quaternion value() const;
+
+Q_SIGNALS:
+    void dataAvailable(const Quaternion& data);
+};
+
+#endif
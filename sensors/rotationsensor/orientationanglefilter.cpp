@@ -0,0 +1,70 @@
+/**
+   @file orientationanglefilter.cpp
+   @brief OrientationAngleFilter
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "orientationanglefilter.h"
+#include <math.h>
+
+OrientationAngleFilter::OrientationAngleFilter() :
+    sink_(this, &OrientationAngleFilter::interpret)
+{
+    addSink(&sink_, "sink");
+    addSource(&source_, "source");
+}
+
+void OrientationAngleFilter::interpret(unsigned n, const TimedXyzData* data)
+{
+    const float DEGREES_TO_RADIANS = (float)M_PI / 180000.0f; // from millidegrees
+    const float RADIANS_TO_DEGREES = 180.0f / (float)M_PI;
+
+    if (!source_.hasDemand())
+        return;
+
+    if ((unsigned)output_.size() < n)
+        output_.resize(n);
+
+    for (unsigned i = 0; i < n; ++i) {
+        float pitch = data[i].y_ * DEGREES_TO_RADIANS;
+        float roll = data[i].z_ * DEGREES_TO_RADIANS;
+
+        // Gravity as the accelerometer chain reports it. Android pitch
+        // is positive when z moves toward y, roll when x moves toward z.
+        float x = -sinf(roll);
+        float y = sinf(pitch) * cosf(roll);
+        float z = -cosf(pitch) * cosf(roll);
+
+        TimedXyzData& rotation = output_[i];
+        rotation.timestamp_ = data[i].timestamp_;
+        rotation.x_ = -(int)lroundf(atan2f(y, sqrtf(x * x + z * z)) * RADIANS_TO_DEGREES);
+        rotation.y_ = lroundf(atan2f(x, sqrtf(y * y + z * z)) * RADIANS_TO_DEGREES);
+        if (z >= 0) {
+            if (rotation.y_ >= 0)
+                rotation.y_ = 180 - rotation.y_;
+            else
+                rotation.y_ = -180 - rotation.y_;
+        }
+        // Azimuth is [0, 360), rotation is (-180, 180]
+        rotation.z_ = -1 * ((int)lroundf(data[i].x_ / 1000.0f) - 180);
+    }
+
+    source_.propagate(n, output_.constData());
+}
@@ -0,0 +1,59 @@
+/**
+   @file orientationanglefilter.h
+   @brief OrientationAngleFilter
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef ORIENTATIONANGLEFILTER_H
+#define ORIENTATIONANGLEFILTER_H
+
+#include <QVector>
+#include "filter.h"
+#include "orientationdata.h"
+
+/**
+ * Converts azimuth, pitch and roll computed by the sensor hub (Android
+ * orientation sensor, in millidegrees) to the rotation angles of
+ * RotationFilter, so clients get the same values from either path.
+ *
+ * Pitch and roll give the direction of gravity, from which X and Y
+ * rotation are derived as RotationFilter does from the accelerometer.
+ * Z rotation is the azimuth as RotationFilter uses the compass heading.
+ */
+class OrientationAngleFilter : public FilterBase
+{
+public:
+    static FilterBase* factoryMethod()
+    {
+        return new OrientationAngleFilter;
+    }
+
+protected:
+    OrientationAngleFilter();
+
+private:
+    void interpret(unsigned n, const TimedXyzData* data);
+
+    Sink<OrientationAngleFilter, TimedXyzData> sink_;
+    Source<TimedXyzData>                       source_;
+    QVector<TimedXyzData>                      output_;
+};
+
+#endif // ORIENTATIONANGLEFILTER_H
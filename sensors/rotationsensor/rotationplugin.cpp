@@ -25,6 +25,7 @@
 
 #include "rotationplugin.h"
 #include "rotationsensor.h"
+#include "orientationanglefilter.h"
 #include "sensormanager.h"
 #include "logging.h"
 
@@ -33,10 +34,14 @@ void RotationPlugin::Register(class Loader&)
     sensordLogD() << "registering rotationsensor";
     SensorManager& sm = SensorManager::instance();
     sm.registerSensor<RotationSensorChannel>("rotationsensor");
+    sm.registerFilter<OrientationAngleFilter>("orientationanglefilter");
 }
 
 QStringList RotationPlugin::Dependencies() {
-    return QString("accelerometerchain:rotationfilter").split(":", QString::SkipEmptyParts);
+    QStringList dependencies(QString("accelerometerchain:rotationfilter").split(":", QString::SkipEmptyParts));
+    if (SensorManager::hasHardwareAdaptor("orientationadaptor"))
+        dependencies << "orientationadaptor";
+    return dependencies;
 }
 
 #if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
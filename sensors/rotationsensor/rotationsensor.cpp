@@ -30,68 +30,150 @@
 #include "sensormanager.h"
 #include "bin.h"
 #include "bufferreader.h"
+#include "deviceadaptor.h"
+#include "datatypes/utils.h"
+#include <math.h>
+
+GyroscopeRateTracker::GyroscopeRateTracker() :
+    sink_(this, &GyroscopeRateTracker::collect),
+    valid_(false)
+{
+    addSink(&sink_, "sink");
+}
+
+bool GyroscopeRateTracker::latest(TimedXyzData& rate) const
+{
+    QMutexLocker locker(&mutex_);
+    rate = rate_;
+    return valid_;
+}
+
+void GyroscopeRateTracker::clear()
+{
+    QMutexLocker locker(&mutex_);
+    valid_ = false;
+}
+
+void GyroscopeRateTracker::collect(unsigned n, const TimedXyzData* data)
+{
+    if (!n)
+        return;
+    QMutexLocker locker(&mutex_);
+    rate_ = data[n - 1];
+    valid_ = true;
+}
+
+/**
+ * Wrap angle into (-180, 180].
+ */
+static int wrapDegrees(int degrees)
+{
+    degrees %= 360;
+    if (degrees > 180)
+        degrees -= 360;
+    else if (degrees <= -180)
+        degrees += 360;
+    return degrees;
+}
 
 RotationSensorChannel::RotationSensorChannel(const QString& id) :
         AbstractSensorChannel(id),
         DataEmitter<TimedXyzData>(1),
+        accelerometerChain_(NULL),
+        compassChain_(NULL),
+        accelerometerReader_(NULL),
         compassReader_(NULL),
-        prevRotation_(0,0,0,0)
+        rotationFilter_(NULL),
+        prevRotation_(0,0,0,0),
+        gyroscopeReader_(NULL),
+        running_(false),
+        gyroscopeRunning_(false),
+        orientationReader_(NULL)
 {
     SensorManager& sm = SensorManager::instance();
 
-    accelerometerChain_ = sm.requestChain("accelerometerchain");
-    Q_ASSERT( accelerometerChain_ );
-    setValid(accelerometerChain_->isValid());
+    outputSink_ = new EmitterSink<TimedXyzData>(this);
 
-    accelerometerReader_ = new BufferReader<AccelerationData>(1);
-
-    compassChain_ = sm.requestChain("compasschain");
-    if (compassChain_ && compassChain_->isValid()) {
-        compassReader_ = new BufferReader<CompassData>(1);
+    // Create buffers for filter chain
+    filterBin_ = Bin::create(id);
+    filterBin_->add(outputSink_, "buffer");
+
+    // Sensor hub computing the angles replaces accelerometer and compass.
+    orientationAdaptor_ = sm.requestHardwareAdaptor("orientationadaptor");
+    if (orientationAdaptor_) {
+        setValid(true);
+        orientationReader_ = new BufferReader<TimedXyzData>(1);
+        rotationFilter_ = sm.instantiateFilter("orientationanglefilter");
+        Q_ASSERT(rotationFilter_);
+
+        filterBin_->add(orientationReader_, "orientation");
+        filterBin_->add(rotationFilter_, "rotationfilter");
+        filterBin_->join("orientation", "source", "rotationfilter", "sink");
+        filterBin_->join("rotationfilter", "source", "buffer", "sink");
+
+        connectToSource(orientationAdaptor_, "orientation", orientationReader_);
+        addStandbyOverrideSource(orientationAdaptor_);
     } else {
-        sensordLogW() << "Unable to use compass for z-axis rotation.";
-    }
+        accelerometerChain_ = sm.requestChain("accelerometerchain");
+        Q_ASSERT( accelerometerChain_ );
+        setValid(accelerometerChain_->isValid());
 
-    rotationFilter_ = sm.instantiateFilter("rotationfilter");
-    Q_ASSERT(rotationFilter_);
+        accelerometerReader_ = new BufferReader<AccelerationData>(1);
 
-    outputBuffer_ = new RingBuffer<TimedXyzData>(1);
+        compassChain_ = sm.requestChain("compasschain");
+        if (compassChain_ && compassChain_->isValid()) {
+            compassReader_ = new BufferReader<CompassData>(1);
+        } else {
+            sensordLogW() << "Unable to use compass for z-axis rotation.";
+        }
 
-    // Create buffers for filter chain
-    filterBin_ = new Bin;
+        rotationFilter_ = sm.instantiateFilter("rotationfilter");
+        Q_ASSERT(rotationFilter_);
 
-    filterBin_->add(accelerometerReader_, "accelerometer");
-    filterBin_->add(rotationFilter_, "rotationfilter");
-    filterBin_->add(outputBuffer_, "buffer");
+        filterBin_->add(accelerometerReader_, "accelerometer");
+        filterBin_->add(rotationFilter_, "rotationfilter");
 
-    if (hasZ())
-    {
-        filterBin_->add(compassReader_, "compass");
-        filterBin_->join("compass", "source", "rotationfilter", "compasssink");
-    }
+        if (hasZ())
+        {
+            filterBin_->add(compassReader_, "compass");
+            filterBin_->join("compass", "source", "rotationfilter", "compasssink");
+        }
 
-    filterBin_->join("accelerometer", "source", "rotationfilter", "accelerometersink");
-    filterBin_->join("rotationfilter", "source", "buffer", "sink");
+        filterBin_->join("accelerometer", "source", "rotationfilter", "accelerometersink");
+        filterBin_->join("rotationfilter", "source", "buffer", "sink");
 
-    connectToSource(accelerometerChain_, "accelerometer", accelerometerReader_);
+        connectToSource(accelerometerChain_, "accelerometer", accelerometerReader_);
+        addStandbyOverrideSource(accelerometerChain_);
 
-    if (hasZ())
-    {
-        connectToSource(compassChain_, "truenorth", compassReader_);
-        addStandbyOverrideSource(compassChain_);
+        if (hasZ())
+        {
+            connectToSource(compassChain_, "truenorth", compassReader_);
+            addStandbyOverrideSource(compassChain_);
+        }
     }
 
-    marshallingBin_ = new Bin;
-    marshallingBin_->add(this, "sensorchannel");
-
-    outputBuffer_->join(this);
+    // Gyroscope is optional, it is only used to extrapolate rotations
+    // for sessions with a prediction horizon.
+    gyroscopeAdaptor_ = sm.requestDeviceAdaptor("gyroscopeadaptor");
+    if (gyroscopeAdaptor_) {
+        gyroscopeReader_ = new BufferReader<TimedXyzData>(1);
+        filterBin_->add(gyroscopeReader_, "gyroscope");
+        filterBin_->add(&gyroscopeRate_, "gyroscoperate");
+        filterBin_->join("gyroscope", "source", "gyroscoperate", "sink");
+        connectToSource(gyroscopeAdaptor_, "gyroscope", gyroscopeReader_);
+    } else {
+        sensordLogD() << "No gyroscope, rotation prediction not supported.";
+    }
 
     setDescription("x, y, and z axes rotation in degrees");
     introduceAvailableDataRange(DataRange(-179, 180, 1));
-    addStandbyOverrideSource(accelerometerChain_);
 
     // Provide interval value from acc, but range depends on sane compass
-    if (hasZ())
+    if (orientationAdaptor_)
+    {
+        setIntervalSource(orientationAdaptor_);
+    }
+    else if (compassReader_)
     {
         // No less than 5hz allowed for compass
         int ranges[] = {10, 20, 25, 40, 50, 100, 200};
@@ -110,20 +192,35 @@ RotationSensorChannel::~RotationSensorChannel()
 {
     SensorManager& sm = SensorManager::instance();
 
-    disconnectFromSource(accelerometerChain_, "accelerometer", accelerometerReader_);
-    sm.releaseChain("accelerometerchain");
+    if (orientationAdaptor_)
+    {
+        disconnectFromSource(orientationAdaptor_, "orientation", orientationReader_);
+        sm.releaseDeviceAdaptor("orientationadaptor");
+        delete orientationReader_;
+    }
+    else
+    {
+        disconnectFromSource(accelerometerChain_, "accelerometer", accelerometerReader_);
+        sm.releaseChain("accelerometerchain");
+    }
 
-    if (hasZ())
+    if (compassReader_)
     {
         disconnectFromSource(compassChain_, "truenorth", compassReader_);
         sm.releaseChain("compasschain");
         delete compassReader_;
     }
 
+    if (gyroscopeAdaptor_)
+    {
+        disconnectFromSource(gyroscopeAdaptor_, "gyroscope", gyroscopeReader_);
+        sm.releaseDeviceAdaptor("gyroscopeadaptor");
+        delete gyroscopeReader_;
+    }
+
     delete accelerometerReader_;
     delete rotationFilter_;
-    delete outputBuffer_;
-    delete marshallingBin_;
+    delete outputSink_;
     delete filterBin_;
 }
 
@@ -132,14 +229,20 @@ bool RotationSensorChannel::start()
     sensordLogD() << "Starting RotationSensorChannel";
 
     if (AbstractSensorChannel::start()) {
-        marshallingBin_->start();
         filterBin_->start();
-        accelerometerChain_->start();
-        if (hasZ())
+        // Accelerometer, magnetometer and gyroscope power up together.
+        AdaptorStartBatch batch;
+        if (orientationAdaptor_)
+            orientationAdaptor_->acquireSensor();
+        else
+            accelerometerChain_->start();
+        if (compassReader_)
         {
             compassChain_->setProperty("compassEnabled", true);
             compassChain_->start();
         }
+        running_ = true;
+        updateGyroscope();
     }
     return true;
 }
@@ -149,14 +252,18 @@ bool RotationSensorChannel::stop()
     sensordLogD() << "Stopping RotationSensorChannel";
 
     if (AbstractSensorChannel::stop()) {
-        accelerometerChain_->stop();
+        running_ = false;
+        updateGyroscope();
+        if (orientationAdaptor_)
+            orientationAdaptor_->releaseSensor();
+        else
+            accelerometerChain_->stop();
         filterBin_->stop();
-        if (hasZ())
+        if (compassReader_)
         {
             compassChain_->stop();
             compassChain_->setProperty("compassEnabled", false);
         }
-        marshallingBin_->stop();
     }
     return true;
 }
@@ -171,14 +278,19 @@ void RotationSensorChannel::emitData(const TimedXyzData& value)
 
 unsigned int RotationSensorChannel::interval() const
 {
+    if (orientationAdaptor_)
+        return orientationAdaptor_->getInterval();
     // Just provide accelerometer rate for now.
     return accelerometerChain_->getInterval();
 }
 
 bool RotationSensorChannel::setInterval(unsigned int value, int sessionId)
 {
+    if (orientationAdaptor_)
+        return orientationAdaptor_->setIntervalRequest(sessionId, value);
+
     bool success = accelerometerChain_->setIntervalRequest(sessionId, value);
-    if (hasZ())
+    if (compassReader_)
     {
         success = compassChain_->setIntervalRequest(sessionId, value) && success;
     }
@@ -186,13 +298,71 @@ bool RotationSensorChannel::setInterval(unsigned int value, int sessionId)
     return success;
 }
 
+bool RotationSensorChannel::downsamplingSupported() const
+{
+    return true;
+}
+
+bool RotationSensorChannel::predictionSupported() const
+{
+    return gyroscopeAdaptor_;
+}
+
+bool RotationSensorChannel::setPredictionHorizon(int sessionId, unsigned int horizon)
+{
+    bool ok = AbstractSensorChannel::setPredictionHorizon(sessionId, horizon);
+    updateGyroscope();
+    return ok;
+}
+
 void RotationSensorChannel::removeSession(int sessionId)
 {
-    downsampleBuffer_.remove(sessionId);
     AbstractSensorChannel::removeSession(sessionId);
+    updateGyroscope();
 }
 
-bool RotationSensorChannel::downsamplingSupported() const
+void RotationSensorChannel::updateGyroscope()
 {
-    return true;
+    bool wanted = gyroscopeAdaptor_ && running_ && hasPredictingSessions();
+    if (wanted == gyroscopeRunning_)
+        return;
+
+    if (wanted) {
+        gyroscopeRunning_ = gyroscopeAdaptor_->acquireSensor();
+    } else {
+        gyroscopeAdaptor_->releaseSensor();
+        gyroscopeRate_.clear();
+        gyroscopeRunning_ = false;
+    }
+}
+
+int RotationSensorChannel::predictSample(const void* source, int size, unsigned int horizon, void* target) const
+{
+    if (size != sizeof(TimedXyzData))
+        return 0;
+
+    TimedXyzData rate;
+    if (!gyroscopeRate_.latest(rate))
+        return 0;
+
+    TimedXyzData rotation(*(const TimedXyzData*)source);
+    if (rate.timestamp_ + MAX_RATE_AGE < rotation.timestamp_)
+        return 0;
+
+    // Rotation is stale by the time since it was sampled, and the client
+    // wants it at horizon from now.
+    quint64 now = Utils::getTimeStamp();
+    quint64 ahead = (now > rotation.timestamp_ ? now - rotation.timestamp_ : 0) + horizon;
+
+    // Rates are in mdps.
+    double seconds = ahead / 1000000.0;
+    int x = rotation.x_ + (int)lround(rate.x_ * seconds / 1000);
+    rotation.x_ = qBound(-90, x, 90);
+    rotation.y_ = wrapDegrees(rotation.y_ + (int)lround(rate.y_ * seconds / 1000));
+    if (hasZ())
+        rotation.z_ = wrapDegrees(rotation.z_ + (int)lround(rate.z_ * seconds / 1000));
+    rotation.timestamp_ = now + horizon;
+
+    *(TimedXyzData*)target = rotation;
+    return sizeof(TimedXyzData);
 }
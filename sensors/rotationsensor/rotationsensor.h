@@ -32,14 +32,56 @@
 #include "abstractchain.h"
 #include "rotationsensor_a.h"
 #include "dataemitter.h"
+#include "consumer.h"
+#include "sink.h"
 #include "datatypes/orientationdata.h"
 
 class Bin;
 template <class TYPE> class BufferReader;
 class FilterBase;
+class DeviceAdaptor;
+
+/**
+ * Keeps the latest gyroscope rate for extrapolating rotations. Written
+ * from the chain thread, read from the main thread when samples are
+ * delivered to predicting sessions.
+ */
+class GyroscopeRateTracker : public Consumer
+{
+public:
+    /**
+     * Constructor.
+     */
+    GyroscopeRateTracker();
+
+    /**
+     * Latest rate.
+     *
+     * @param rate set to the latest rate in mdps.
+     * @return false if no rate has been received.
+     */
+    bool latest(TimedXyzData& rate) const;
+
+    /**
+     * Forget the latest rate.
+     */
+    void clear();
+
+private:
+    void collect(unsigned n, const TimedXyzData* data);
+
+    Sink<GyroscopeRateTracker, TimedXyzData> sink_;
+    mutable QMutex mutex_;  /**< protects rate_ and valid_ */
+    TimedXyzData   rate_;   /**< latest rate */
+    bool           valid_;  /**< has rate been received */
+};
 
 /**
  * @brief Sensor providing device rotation around axes.
+ *
+ * Rotation is computed by RotationFilter from the accelerometer and
+ * compass chains, or taken from the sensor hub when a hardware
+ * \c orientationadaptor is configured, see OrientationAngleFilter.
  */
 class RotationSensorChannel :
         public AbstractSensorChannel,
@@ -69,16 +111,18 @@ public:
 
     bool hasZ() const
     {
-        return compassReader_;
+        return compassReader_ || orientationAdaptor_;
     }
 
     virtual unsigned int interval() const;
     virtual bool setInterval(unsigned int value, int sessionId);
 
-    virtual void removeSession(int sessionId);
-
     virtual bool downsamplingSupported() const;
 
+    virtual bool setPredictionHorizon(int sessionId, unsigned int horizon);
+    virtual bool predictionSupported() const;
+    virtual void removeSession(int sessionId);
+
 public Q_SLOTS:
     bool start();
     bool stop();
@@ -94,20 +138,41 @@ protected:
     RotationSensorChannel(const QString& id);
     virtual ~RotationSensorChannel();
 
+    /**
+     * Extrapolate rotation by the gyroscope rate. Only used when the
+     * gyroscope rate is at most #MAX_RATE_AGE older than the rotation.
+     */
+    virtual int predictSample(const void* source, int size, unsigned int horizon, void* target) const;
+
 private:
     Bin*                         filterBin_;
-    Bin*                         marshallingBin_;
     AbstractChain*               accelerometerChain_;
     AbstractChain*               compassChain_;
     BufferReader<TimedXyzData>*  accelerometerReader_;
     BufferReader<CompassData>*   compassReader_;
     FilterBase*                  rotationFilter_;
-    RingBuffer<TimedXyzData>*    outputBuffer_;
+    EmitterSink<TimedXyzData>*   outputSink_;
     TimedXyzData                 prevRotation_;
     TimedXyzDownsampleBuffer     downsampleBuffer_;
     QMutex                       mutex_;
+    DeviceAdaptor*               gyroscopeAdaptor_;
+    BufferReader<TimedXyzData>*  gyroscopeReader_;
+    GyroscopeRateTracker         gyroscopeRate_;
+    bool                         running_;            /**< is channel started */
+    bool                         gyroscopeRunning_;   /**< is gyroscope started for prediction */
+    DeviceAdaptor*               orientationAdaptor_; /**< hardware angles replacing accelerometer and compass */
+    BufferReader<TimedXyzData>*  orientationReader_;
+
+    /** Oldest usable gyroscope rate relative to a rotation, microseconds. */
+    static const quint64 MAX_RATE_AGE = 200000;
 
     void emitData(const TimedXyzData& value);
+
+    /**
+     * Run the gyroscope while the channel is started and some session
+     * is predicting.
+     */
+    void updateGyroscope();
 };
 
 #endif // ROTATION_SENSOR_CHANNEL_H
@@ -2,10 +2,12 @@ TARGET       = rotationsensor
 
 HEADERS += rotationsensor.h   \
            rotationsensor_a.h \
-           rotationplugin.h
+           rotationplugin.h \
+           orientationanglefilter.h
 
 SOURCES += rotationsensor.cpp   \
            rotationsensor_a.cpp \
-           rotationplugin.cpp
+           rotationplugin.cpp \
+           orientationanglefilter.cpp
 
 include( ../sensor-config.pri )
@@ -11,6 +11,10 @@ SUBDIRS  = accelerometersensor \
            compasssensor \
            rotationsensor \
            magnetometersensor \
-           gyroscopesensor
+           gyroscopesensor \
+           quaternionsensor \
+           imusensor \
+           gesturesensor \
+           stepcountersensor
 
 contextprovider:SUBDIRS += contextplugin
@@ -0,0 +1,112 @@
+/**
+   @file stepcountersensor.cpp
+   @brief StepCounterSensorChannel
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "stepcountersensor.h"
+
+#include <QMutexLocker>
+#include "sensormanager.h"
+#include "bin.h"
+#include "bufferreader.h"
+
+StepCounterSensorChannel::StepCounterSensorChannel(const QString& id) :
+        AbstractSensorChannel(id),
+        DataEmitter<TimedUnsigned>(1),
+        previousSample_()
+{
+    SensorManager& sm = SensorManager::instance();
+
+    stepCounterChain_ = sm.requestChain("stepcounterchain");
+    Q_ASSERT( stepCounterChain_ );
+    setValid(stepCounterChain_ && stepCounterChain_->isValid());
+
+    stepCounterReader_ = new BufferReader<TimedUnsigned>(1);
+
+    outputSink_ = new EmitterSink<TimedUnsigned>(this);
+
+    // Create buffers for filter chain
+    filterBin_ = Bin::create(id);
+    filterBin_->add(stepCounterReader_, "stepcounter");
+    filterBin_->add(outputSink_, "buffer");
+
+    filterBin_->join("stepcounter", "source", "buffer", "sink");
+
+    // Join datasources to the chain
+    connectToSource(stepCounterChain_, "stepcounter", stepCounterReader_);
+
+    setDescription("cumulative step count");
+    setIntervalSource(stepCounterChain_);
+
+    // Steps are counted with display off
+    addStandbyOverrideSource(stepCounterChain_);
+}
+
+StepCounterSensorChannel::~StepCounterSensorChannel()
+{
+    SensorManager& sm = SensorManager::instance();
+
+    disconnectFromSource(stepCounterChain_, "stepcounter", stepCounterReader_);
+    sm.releaseChain("stepcounterchain");
+
+    delete stepCounterReader_;
+    delete outputSink_;
+    delete filterBin_;
+}
+
+bool StepCounterSensorChannel::start()
+{
+    sensordLogD() << "Starting StepCounterSensorChannel";
+
+    if (AbstractSensorChannel::start()) {
+        filterBin_->start();
+        stepCounterChain_->start();
+    }
+    return true;
+}
+
+bool StepCounterSensorChannel::stop()
+{
+    sensordLogD() << "Stopping StepCounterSensorChannel";
+
+    if (AbstractSensorChannel::stop()) {
+        stepCounterChain_->stop();
+        filterBin_->stop();
+    }
+    return true;
+}
+
+Unsigned StepCounterSensorChannel::steps() const
+{
+    QMutexLocker locker(&mutex_);
+    return Unsigned(previousSample_);
+}
+
+void StepCounterSensorChannel::emitData(const TimedUnsigned& value)
+{
+    {
+        QMutexLocker locker(&mutex_);
+        if (value.value_ == previousSample_.value_ && previousSample_.timestamp_)
+            return;
+        previousSample_ = value;
+    }
+    writeToClients((const void*)&value, sizeof(value));
+}
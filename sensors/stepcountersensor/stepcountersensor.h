@@ -0,0 +1,98 @@
+/**
+   @file stepcountersensor.h
+   @brief StepCounterSensorChannel
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef STEPCOUNTER_SENSOR_CHANNEL_H
+#define STEPCOUNTER_SENSOR_CHANNEL_H
+
+#include <QMutex>
+
+#include "abstractsensor.h"
+#include "abstractchain.h"
+#include "stepcountersensor_a.h"
+#include "dataemitter.h"
+#include "datatypes/timedunsigned.h"
+#include "datatypes/unsigned.h"
+
+class Bin;
+template <class TYPE> class BufferReader;
+
+/**
+ * @brief Sensor for the cumulative step count.
+ *
+ * Counts come from StepCounterChain, from the hardware step counter
+ * when there is one. Samples are only sent when the count changes, and
+ * then infrequently, so pedometer clients can stay asleep while the
+ * user walks.
+ */
+class StepCounterSensorChannel :
+        public AbstractSensorChannel,
+        public DataEmitter<TimedUnsigned>
+{
+    Q_OBJECT;
+    Q_PROPERTY(Unsigned steps READ steps);
+
+public:
+    /**
+     * Factory method for StepCounterSensorChannel.
+     * @return new StepCounterSensorChannel as AbstractSensorChannel*.
+     */
+    static AbstractSensorChannel* factoryMethod(const QString& id)
+    {
+        StepCounterSensorChannel* sc = new StepCounterSensorChannel(id);
+        new StepCounterSensorChannelAdaptor(sc);
+
+        return sc;
+    }
+
+    /**
+     * Latest step count.
+     *
+     * @return cumulative steps.
+     */
+    Unsigned steps() const;
+
+public Q_SLOTS:
+    bool start();
+    bool stop();
+
+signals:
+    void stepsChanged(const Unsigned& value);
+
+protected:
+    StepCounterSensorChannel(const QString& id);
+    ~StepCounterSensorChannel();
+
+private:
+    Bin*                          filterBin_;
+
+    AbstractChain*                stepCounterChain_;
+    BufferReader<TimedUnsigned>*  stepCounterReader_;
+    EmitterSink<TimedUnsigned>*   outputSink_;
+
+    TimedUnsigned                 previousSample_;
+    mutable QMutex                mutex_;
+
+    void emitData(const TimedUnsigned& value);
+};
+
+#endif // STEPCOUNTER_SENSOR_CHANNEL_H
@@ -0,0 +1,11 @@
+TARGET       = stepcountersensor
+
+HEADERS += stepcountersensor.h   \
+           stepcountersensor_a.h \
+           stepcounterplugin.h
+
+SOURCES += stepcountersensor.cpp   \
+           stepcountersensor_a.cpp \
+           stepcounterplugin.cpp
+
+include( ../sensor-config.pri )
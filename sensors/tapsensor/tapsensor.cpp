@@ -28,6 +28,7 @@
 #include "sensormanager.h"
 #include "bin.h"
 #include "bufferreader.h"
+#include "cpuboost.h"
 #include "datatypes/tap.h"
 
 TapSensorChannel::TapSensorChannel(const QString& id) :
@@ -41,24 +42,19 @@ TapSensorChannel::TapSensorChannel(const QString& id) :
 
     tapReader_ = new BufferReader<TapData>(1);
 
-    outputBuffer_ = new RingBuffer<TapData>(1);
+    outputSink_ = new EmitterSink<TapData>(this);
 
     // Create buffers for filter chain
-    filterBin_ = new Bin;
+    filterBin_ = Bin::create(id);
 
     filterBin_->add(tapReader_, "tap");
-    filterBin_->add(outputBuffer_, "buffer");
+    filterBin_->add(outputSink_, "buffer");
 
     filterBin_->join("tap", "source", "buffer", "sink");
 
     // Join datasources to the chain
     connectToSource(tapAdaptor_, "tap", tapReader_);
 
-    marshallingBin_ = new Bin;
-    marshallingBin_->add(this, "sensorchannel");
-
-    outputBuffer_->join(this);
-
     setValid(true);
 
     setDescription("either single or double device taps, and tap axis");
@@ -77,8 +73,7 @@ TapSensorChannel::~TapSensorChannel()
     sm.releaseDeviceAdaptor("tapadaptor");
 
     delete tapReader_;
-    delete outputBuffer_;
-    delete marshallingBin_;
+    delete outputSink_;
     delete filterBin_;
 }
 
@@ -87,9 +82,8 @@ bool TapSensorChannel::start()
     sensordLogD() << "Starting TapSensorChannel";
 
     if (AbstractSensorChannel::start()) {
-        marshallingBin_->start();
         filterBin_->start();
-        tapAdaptor_->startSensor();
+        tapAdaptor_->acquireSensor();
     }
     return true;
 }
@@ -99,14 +93,14 @@ bool TapSensorChannel::stop()
     sensordLogD() << "Stopping TapSensorChannel";
 
     if (AbstractSensorChannel::stop()) {
-        tapAdaptor_->stopSensor();
+        tapAdaptor_->releaseSensor();
         filterBin_->stop();
-        marshallingBin_->stop();
     }
     return true;
 }
 
 void TapSensorChannel::emitData(const TapData& tapData)
 {
+    CpuBoost::instance().request(CpuBoost::Tap);
     writeToClients((const void *)&tapData, sizeof(TapData));
 }
@@ -84,10 +84,9 @@ protected:
 
 private:
     Bin*                   filterBin_;
-    Bin*                   marshallingBin_;
     DeviceAdaptor*         tapAdaptor_;
     BufferReader<TapData>* tapReader_;
-    RingBuffer<TapData>*   outputBuffer_;
+    EmitterSink<TapData>*  outputSink_;
 
     void emitData(const TapData& tapData);
 };
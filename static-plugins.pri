@@ -0,0 +1,34 @@
+#
+# Plugins linked statically into sensord when configured with
+# CONFIG+=static_plugins (Qt 5 only). Each entry is the plugin name,
+# its directory relative to the source root and its plugin class.
+# Plugins not listed here are still built and loaded as files.
+#
+
+SENSORFW_STATIC_PLUGINS = \
+    accelerometeradaptor:adaptors/accelerometeradaptor:AccelerometerAdaptorPlugin \
+    magnetometeradaptor:adaptors/magnetometeradaptor:MagnetometerAdaptorPlugin \
+    alsadaptor:adaptors/alsadaptor:ALSAdaptorPlugin \
+    proximityadaptor:adaptors/proximityadaptor:ProximityAdaptorPlugin \
+    gyroscopeadaptor:adaptors/gyroscopeadaptor:GyroscopeAdaptorPlugin \
+    tapadaptor:adaptors/tapadaptor:TapAdaptorPlugin \
+    coordinatealignfilter:filters/coordinatealignfilter:CoordinateAlignFilterPlugin \
+    orientationinterpreter:filters/orientationinterpreter:OrientationInterpreterPlugin \
+    rotationfilter:filters/rotationfilter:RotationFilterPlugin \
+    downsamplefilter:filters/downsamplefilter:DownsampleFilterPlugin \
+    avgaccfilter:filters/avgaccfilter:AvgAccFilterPlugin \
+    declinationfilter:filters/declinationfilter:DeclinationFilterPlugin \
+    accelerometerchain:chains/accelerometerchain:AccelerometerChainPlugin \
+    orientationchain:chains/orientationchain:OrientationChainPlugin \
+    magcalibrationchain:chains/magcalibrationchain:MagCalibrationChainPlugin \
+    compasschain:chains/compasschain:CompassChainPlugin \
+    gyroscopechain:chains/gyroscopechain:GyroscopeChainPlugin \
+    accelerometersensor:sensors/accelerometersensor:AccelerometerPlugin \
+    orientationsensor:sensors/orientationsensor:OrientationPlugin \
+    alssensor:sensors/alssensor:ALSPlugin \
+    proximitysensor:sensors/proximitysensor:ProximityPlugin \
+    magnetometersensor:sensors/magnetometersensor:MagnetometerPlugin \
+    compasssensor:sensors/compasssensor:CompassPlugin \
+    rotationsensor:sensors/rotationsensor:RotationPlugin \
+    tapsensor:sensors/tapsensor:TapPlugin \
+    gyroscopesensor:sensors/gyroscopesensor:GyroscopePlugin
@@ -0,0 +1,79 @@
+/**
+   @file allocationcounter.cpp
+   @brief Heap allocation counting for the benchmarks
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#include "allocationcounter.h"
+#include <stddef.h>
+#include <malloc.h>
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+}
+
+static volatile int counting = 0;
+static volatile unsigned int allocations = 0;
+
+static inline void countAllocation()
+{
+    if (counting)
+        __sync_fetch_and_add(&allocations, 1);
+}
+
+extern "C" void* malloc(size_t size)
+{
+    countAllocation();
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t nmemb, size_t size)
+{
+    countAllocation();
+    return __libc_calloc(nmemb, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size)
+{
+    countAllocation();
+    return __libc_realloc(ptr, size);
+}
+
+void AllocationCounter::start()
+{
+    __sync_lock_test_and_set(&allocations, 0);
+    __sync_synchronize();
+    counting = 1;
+}
+
+unsigned int AllocationCounter::stop()
+{
+    counting = 0;
+    __sync_synchronize();
+    return allocations;
+}
+
+long AllocationCounter::heapInUse()
+{
+    struct mallinfo info = mallinfo();
+    return (unsigned int)info.uordblks + (unsigned int)info.hblkhd;
+}
@@ -0,0 +1,58 @@
+/**
+   @file allocationcounter.h
+   @brief Heap allocation counting for the benchmarks
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+ */
+
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+/**
+ * Counts heap allocations of the benchmark process. The benchmark
+ * binary replaces malloc(), calloc() and realloc() with wrappers around
+ * the glibc implementations, so allocations through operator new and
+ * Qt containers are counted too.
+ */
+class AllocationCounter
+{
+public:
+    /**
+     * Reset the count and start counting.
+     */
+    static void start();
+
+    /**
+     * Stop counting.
+     *
+     * @return allocations since #start().
+     */
+    static unsigned int stop();
+
+    /**
+     * Bytes of heap currently allocated by the process, from the
+     * allocator statistics. Taken before and after creating objects it
+     * gives the heap they hold.
+     *
+     * @return heap in use.
+     */
+    static long heapInUse();
+};
+
+#endif // ALLOCATIONCOUNTER_H
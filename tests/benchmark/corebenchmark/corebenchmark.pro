@@ -0,0 +1,52 @@
+QT += dbus network
+
+include(../../common-install.pri)
+
+TEMPLATE = app
+TARGET = sensorcorebenchmark-test
+
+CONFIG += testcase link_pkgconfig
+
+PKGCONFIG += gconf-2.0 gobject-2.0
+
+HEADERS += corebenchmarks.h \
+    allocationcounter.h \
+    ../../../chains/magcalibrationchain/calibrationfilter.h \
+    ../../../chains/compasschain/compassfilter.h \
+    ../../../chains/compasschain/headingsmoothfilter.h \
+    ../../../filters/coordinatealignfilter/coordinatealignfilter.h \
+    ../../../filters/avgaccfilter/avgaccfilter.h \
+    ../../../filters/downsamplefilter/downsamplefilter.h \
+    ../../../filters/orientationinterpreter/orientationinterpreter.h \
+    ../../../filters/declinationfilter/declinationfilter.h \
+    ../../../filters/rotationfilter/rotationfilter.h
+
+SOURCES += corebenchmarks.cpp \
+    allocationcounter.cpp \
+    ../../../chains/magcalibrationchain/calibrationfilter.cpp \
+    ../../../chains/compasschain/compassfilter.cpp \
+    ../../../chains/compasschain/headingsmoothfilter.cpp \
+    ../../../filters/coordinatealignfilter/coordinatealignfilter.cpp \
+    ../../../filters/avgaccfilter/avgaccfilter.cpp \
+    ../../../filters/downsamplefilter/downsamplefilter.cpp \
+    ../../../filters/orientationinterpreter/orientationinterpreter.cpp \
+    ../../../filters/declinationfilter/declinationfilter.cpp \
+    ../../../filters/rotationfilter/rotationfilter.cpp
+
+INCLUDEPATH += ../../../include \
+    ../../.. \
+    ../../../filters/coordinatealignfilter \
+    ../../../filters/avgaccfilter \
+    ../../../filters/downsamplefilter \
+    ../../../filters/orientationinterpreter \
+    ../../../filters/declinationfilter \
+    ../../../filters/rotationfilter \
+    ../../../chains/magcalibrationchain \
+    ../../../chains/compasschain \
+    ../../../core \
+    ../../../datatypes
+
+QMAKE_LIBDIR_FLAGS += -L../../../datatypes
+QMAKE_LIBDIR_FLAGS += -L../../../builddir/core -L../../../core/
+
+include(../../../common.pri)
@@ -0,0 +1,565 @@
+/**
+   @file corebenchmarks.cpp
+   @brief Microbenchmarks for core dataflow primitives
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+*/
+
+
+#include <QtDebug>
+#include <QVector>
+#include <QLocalSocket>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "corebenchmarks.h"
+#include "bin.h"
+#include "bufferreader.h"
+#include "ringbuffer.h"
+#include "deviceadaptorringbuffer.h"
+#include "nodestatistics.h"
+#include "filter.h"
+#include "config.h"
+#include "logging.h"
+#include "sockethandler.h"
+#include "orientationdata.h"
+#include "posedata.h"
+#include "coordinatealignfilter.h"
+#include "avgaccfilter.h"
+#include "downsamplefilter.h"
+#include "orientationinterpreter.h"
+#include "declinationfilter.h"
+#include "rotationfilter.h"
+#include "calibrationfilter.h"
+#include "compassfilter.h"
+#include "headingsmoothfilter.h"
+#include "allocationcounter.h"
+
+static QVector<TimedXyzData> xyzSamples(int n)
+{
+    QVector<TimedXyzData> samples(n);
+    for (int i = 0; i < n; ++i)
+        samples[i] = TimedXyzData(1000 * i, i % 200 - 100, 50 - i % 100, 980);
+    return samples;
+}
+
+static QVector<CompassData> compassSamples(int n)
+{
+    QVector<CompassData> samples(n);
+    for (int i = 0; i < n; ++i)
+        samples[i] = CompassData(1000 * i, i % 360, 3);
+    return samples;
+}
+
+template <class TYPE>
+static RingBuffer<TYPE>* createRingBuffer()
+{
+    return new RingBuffer<TYPE>(1024);
+}
+
+template <class TYPE>
+static BufferReader<TYPE>* createBufferReader()
+{
+    return new BufferReader<TYPE>(128);
+}
+
+/**
+ * Heap held by one node of a type, averaged over a number of nodes so
+ * allocator rounding evens out.
+ */
+template <class NODE>
+static long nodeHeap(NODE* (*create)())
+{
+    const int COUNT = 64;
+    QVector<NODE*> nodes(COUNT);
+    long before = AllocationCounter::heapInUse();
+    for (int i = 0; i < COUNT; ++i)
+        nodes[i] = create();
+    long after = AllocationCounter::heapInUse();
+    qDeleteAll(nodes);
+    return (after - before) / COUNT;
+}
+
+static void addBatchRows()
+{
+    QTest::addColumn<int>("batch");
+    QTest::newRow("1") << 1;
+    QTest::newRow("32") << 32;
+    QTest::newRow("256") << 256;
+}
+
+/**
+ * Push input through a single filter into a counting sink.
+ */
+template <class IN, class OUT>
+static void benchmarkFilterInput(FilterBase* filter, const QString& sinkName, const QString& sourceName, const QVector<IN>& input)
+{
+    Bin bin;
+    SyntheticSource<IN> source;
+    CountingSink<OUT> output;
+    bin.add(&source, "input");
+    bin.add(filter, "filter");
+    bin.add(&output, "output");
+    QVERIFY(bin.join("input", "source", "filter", sinkName));
+    QVERIFY(bin.join("filter", sourceName, "output", "sink"));
+    bin.start();
+
+    QBENCHMARK {
+        source.push(input.size(), input.constData());
+    }
+
+    bin.stop();
+}
+
+void CoreBenchmark::initTestCase()
+{
+    Config::loadConfig(CONFIG_FILE_PATH, CONFIG_DIR_PATH);
+    SensordLogger::init(1, "/tmp/test.log", "CoreBenchmark");
+    // Trace output would dominate the measurements.
+    SensordLogger::setOutputLevel(SensordLogWarning);
+}
+
+void CoreBenchmark::benchmarkSourcePropagate_data()
+{
+    QTest::addColumn<int>("batch");
+    QTest::addColumn<int>("sinks");
+    QTest::newRow("1 sample, 1 sink") << 1 << 1;
+    QTest::newRow("1 sample, 4 sinks") << 1 << 4;
+    QTest::newRow("32 samples, 1 sink") << 32 << 1;
+    QTest::newRow("32 samples, 4 sinks") << 32 << 4;
+}
+
+void CoreBenchmark::benchmarkSourcePropagate()
+{
+    QFETCH(int, batch);
+    QFETCH(int, sinks);
+
+    Bin bin;
+    SyntheticSource<TimedXyzData> source;
+    QVector<CountingSink<TimedXyzData>*> outputs;
+    bin.add(&source, "input");
+    for (int i = 0; i < sinks; ++i) {
+        outputs << new CountingSink<TimedXyzData>;
+        bin.add(outputs.last(), QString("output%1").arg(i));
+        QVERIFY(bin.join("input", "source", QString("output%1").arg(i), "sink"));
+    }
+    QVector<TimedXyzData> input = xyzSamples(batch);
+
+    QBENCHMARK {
+        source.push(input.size(), input.constData());
+    }
+
+    QVERIFY(outputs.first()->count() > 0);
+    qDeleteAll(outputs);
+}
+
+void CoreBenchmark::benchmarkRingBufferWrite_data()
+{
+    addBatchRows();
+}
+
+void CoreBenchmark::benchmarkRingBufferWrite()
+{
+    QFETCH(int, batch);
+
+    Bin bin;
+    SyntheticSource<TimedXyzData> source;
+    RingBuffer<TimedXyzData> buffer(1024);
+    bin.add(&source, "input");
+    bin.add(&buffer, "buffer");
+    QVERIFY(bin.join("input", "source", "buffer", "sink"));
+    QVector<TimedXyzData> input = xyzSamples(batch);
+
+    QBENCHMARK {
+        source.push(input.size(), input.constData());
+    }
+}
+
+void CoreBenchmark::benchmarkRingBufferRead_data()
+{
+    addBatchRows();
+}
+
+void CoreBenchmark::benchmarkRingBufferRead()
+{
+    QFETCH(int, batch);
+
+    // Every write wakes up the reader, which drains the buffer.
+    Bin bin;
+    SyntheticSource<TimedXyzData> source;
+    RingBuffer<TimedXyzData> buffer(1024);
+    BufferReader<TimedXyzData> reader(128);
+    CountingSink<TimedXyzData> output;
+    bin.add(&source, "input");
+    bin.add(&buffer, "buffer");
+    bin.add(&reader, "reader");
+    bin.add(&output, "output");
+    QVERIFY(bin.join("input", "source", "buffer", "sink"));
+    QVERIFY(buffer.join(&reader));
+    QVERIFY(bin.join("reader", "source", "output", "sink"));
+    QVector<TimedXyzData> input = xyzSamples(batch);
+
+    QBENCHMARK {
+        source.push(input.size(), input.constData());
+    }
+
+    QVERIFY(output.count() > 0);
+    buffer.unjoin(&reader);
+}
+
+void CoreBenchmark::benchmarkAdaptorCommit_data()
+{
+    QTest::addColumn<bool>("statistics");
+    QTest::newRow("statistics disabled") << false;
+    QTest::newRow("statistics enabled") << true;
+}
+
+void CoreBenchmark::benchmarkAdaptorCommit()
+{
+    QFETCH(bool, statistics);
+
+    // Commit cost as seen by adaptor threads, with the rate and jitter
+    // tracking on and off.
+    DeviceAdaptorRingBuffer<TimedXyzData> buffer(1024);
+    buffer.statistics().setName("benchmark/adaptor");
+    NodeStatistics::setEnabled(statistics);
+    quint64 timestamp = 0;
+
+    QBENCHMARK {
+        TimedXyzData* slot = buffer.nextSlot();
+        *slot = TimedXyzData(timestamp += 10000, 1, 2, 3);
+        buffer.commit();
+    }
+
+    NodeStatistics::setEnabled(false);
+}
+
+void CoreBenchmark::benchmarkChain_data()
+{
+    addBatchRows();
+}
+
+void CoreBenchmark::benchmarkChain()
+{
+    QFETCH(int, batch);
+
+    // Same shape as AccelerometerChain: adaptor buffer, reader,
+    // coordinate alignment and the chain output buffer.
+    Bin bin;
+    SyntheticSource<TimedXyzData> source;
+    RingBuffer<TimedXyzData> adaptorBuffer(1024);
+    BufferReader<TimedXyzData> adaptorReader(128);
+    FilterBase* coordinateAlign = CoordinateAlignFilter::factoryMethod();
+    RingBuffer<TimedXyzData> chainBuffer(1024);
+    BufferReader<TimedXyzData> chainReader(128);
+    CountingSink<TimedXyzData> output;
+
+    double matrix[3][3] = { { 0, 1, 0 }, { -1, 0, 0 }, { 0, 0, 1 } };
+    ((CoordinateAlignFilter*)coordinateAlign)->setProperty("transMatrix", QVariant::fromValue(TMatrix(matrix)));
+
+    bin.add(&source, "input");
+    bin.add(&adaptorBuffer, "adaptorbuffer");
+    bin.add(&adaptorReader, "adaptorreader");
+    bin.add(coordinateAlign, "coordinatealign");
+    bin.add(&chainBuffer, "chainbuffer");
+    bin.add(&chainReader, "chainreader");
+    bin.add(&output, "output");
+    QVERIFY(bin.join("input", "source", "adaptorbuffer", "sink"));
+    QVERIFY(adaptorBuffer.join(&adaptorReader));
+    QVERIFY(bin.join("adaptorreader", "source", "coordinatealign", "sink"));
+    QVERIFY(bin.join("coordinatealign", "source", "chainbuffer", "sink"));
+    QVERIFY(chainBuffer.join(&chainReader));
+    QVERIFY(bin.join("chainreader", "source", "output", "sink"));
+    bin.start();
+    QVector<TimedXyzData> input = xyzSamples(batch);
+
+    QBENCHMARK {
+        source.push(input.size(), input.constData());
+    }
+
+    QVERIFY(output.count() > 0);
+    bin.stop();
+    chainBuffer.unjoin(&chainReader);
+    adaptorBuffer.unjoin(&adaptorReader);
+    delete coordinateAlign;
+}
+
+void CoreBenchmark::benchmarkFilter_data()
+{
+    QTest::addColumn<QString>("filter");
+    QTest::addColumn<int>("batch");
+    QStringList filters;
+    filters << "coordinatealign" << "avgacc" << "downsample" << "orientationinterpreter" << "declination" << "rotation";
+    foreach (const QString& filter, filters) {
+        QTest::newRow(qPrintable(filter + " 1")) << filter << 1;
+        QTest::newRow(qPrintable(filter + " 32")) << filter << 32;
+    }
+}
+
+void CoreBenchmark::benchmarkFilter()
+{
+    QFETCH(QString, filter);
+    QFETCH(int, batch);
+
+    QVector<TimedXyzData> xyz = xyzSamples(batch);
+
+    if (filter == "coordinatealign") {
+        FilterBase* f = CoordinateAlignFilter::factoryMethod();
+        double matrix[3][3] = { { 0, 1, 0 }, { -1, 0, 0 }, { 0, 0, 1 } };
+        ((CoordinateAlignFilter*)f)->setProperty("transMatrix", QVariant::fromValue(TMatrix(matrix)));
+        benchmarkFilterInput<TimedXyzData, TimedXyzData>(f, "sink", "source", xyz);
+        delete f;
+    } else if (filter == "avgacc") {
+        FilterBase* f = AvgAccFilter::factoryMethod();
+        benchmarkFilterInput<TimedXyzData, TimedXyzData>(f, "sink", "source", xyz);
+        delete f;
+    } else if (filter == "downsample") {
+        FilterBase* f = DownsampleFilter::factoryMethod();
+        ((DownsampleFilter*)f)->setBufferSize(4);
+        benchmarkFilterInput<TimedXyzData, TimedXyzData>(f, "sink", "source", xyz);
+        delete f;
+    } else if (filter == "orientationinterpreter") {
+        FilterBase* f = OrientationInterpreter::factoryMethod();
+        benchmarkFilterInput<AccelerationData, PoseData>(f, "accsink", "orientation", xyz);
+        delete f;
+    } else if (filter == "declination") {
+        FilterBase* f = DeclinationFilter::factoryMethod();
+        benchmarkFilterInput<CompassData, CompassData>(f, "sink", "source", compassSamples(batch));
+        delete f;
+    } else if (filter == "rotation") {
+        // Rotation needs a heading before it produces output.
+        FilterBase* f = RotationFilter::factoryMethod();
+        Bin bin;
+        SyntheticSource<CompassData> compass;
+        bin.add(&compass, "compass");
+        bin.add(f, "rotation");
+        QVERIFY(bin.join("compass", "source", "rotation", "compasssink"));
+        QVector<CompassData> heading = compassSamples(1);
+        compass.push(heading.size(), heading.constData());
+        benchmarkFilterInput<TimedXyzData, TimedXyzData>(f, "accelerometersink", "source", xyz);
+        delete f;
+    }
+}
+
+void CoreBenchmark::benchmarkSessionDataWrite_data()
+{
+    QTest::addColumn<int>("batch");
+    QTest::newRow("1") << 1;
+    QTest::newRow("10") << 10;
+    QTest::newRow("100") << 100;
+}
+
+void CoreBenchmark::benchmarkSessionDataWrite()
+{
+    QFETCH(int, batch);
+
+    int fds[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == 0);
+    QLocalSocket* socket = new QLocalSocket;
+    QVERIFY(socket->setSocketDescriptor(fds[0]));
+
+    SessionData session(socket);
+    session.setBufferSize(batch);
+    QVector<TimedXyzData> input = xyzSamples(batch);
+    char drain[65536];
+
+    QBENCHMARK {
+        for (int i = 0; i < batch; ++i)
+            session.write(&input[i], sizeof(TimedXyzData));
+        session.flush();
+        // Play the client so that the socket never fills up.
+        while (::read(fds[1], drain, sizeof(drain)) > 0)
+            ;
+    }
+
+    QCOMPARE(session.getDropped(), 0u);
+    close(fds[1]);
+}
+
+void CoreBenchmark::testSteadyStateAllocations_data()
+{
+    QTest::addColumn<QString>("path");
+    QTest::newRow("accelerometer") << "accelerometer";
+    QTest::newRow("magnetometer") << "magnetometer";
+    QTest::newRow("compass") << "compass";
+}
+
+void CoreBenchmark::testSteadyStateAllocations()
+{
+    QFETCH(QString, path);
+
+    // Chain and delivery shapes of the sensors, from the adaptor buffer
+    // to the client socket. The first samples may size buffers, after
+    // that no sample may touch the heap.
+    const int WARMUP = 1000;
+    const int SAMPLES = 1000;
+
+    int fds[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) == 0);
+    QLocalSocket* socket = new QLocalSocket;
+    QVERIFY(socket->setSocketDescriptor(fds[0]));
+    SessionData session(socket);
+    session.setBufferSize(1);
+
+    Bin bin;
+    SyntheticSource<TimedXyzData> source;
+    RingBuffer<TimedXyzData> adaptorBuffer(1024);
+    BufferReader<TimedXyzData> adaptorReader(128);
+    bin.add(&source, "input");
+    bin.add(&adaptorBuffer, "adaptorbuffer");
+    bin.add(&adaptorReader, "adaptorreader");
+    QVERIFY(bin.join("input", "source", "adaptorbuffer", "sink"));
+    QVERIFY(adaptorBuffer.join(&adaptorReader));
+
+    // Compass also needs the accelerometer.
+    SyntheticSource<TimedXyzData> accelerometer;
+    bin.add(&accelerometer, "accelerometer");
+
+    QList<FilterBase*> filters;
+    RingBufferBase* chainBuffer = NULL;
+    RingBufferReaderBase* chainReader = NULL;
+    Consumer* writer = NULL;
+    if (path == "accelerometer") {
+        filters << CoordinateAlignFilter::factoryMethod();
+        double matrix[3][3] = { { 0, 1, 0 }, { -1, 0, 0 }, { 0, 0, 1 } };
+        ((CoordinateAlignFilter*)filters[0])->setProperty("transMatrix", QVariant::fromValue(TMatrix(matrix)));
+        bin.add(filters[0], "coordinatealign");
+        RingBuffer<TimedXyzData>* buffer = new RingBuffer<TimedXyzData>(1024);
+        BufferReader<TimedXyzData>* reader = new BufferReader<TimedXyzData>(128);
+        QVERIFY(buffer->join(reader));
+        chainBuffer = buffer;
+        chainReader = reader;
+        writer = new SessionWriter<TimedXyzData>(&session, fds[1]);
+        bin.add(chainBuffer, "chainbuffer");
+        bin.add(chainReader, "chainreader");
+        bin.add(writer, "writer");
+        QVERIFY(bin.join("adaptorreader", "source", "coordinatealign", "sink"));
+        QVERIFY(bin.join("coordinatealign", "source", "chainbuffer", "sink"));
+    } else if (path == "magnetometer") {
+        filters << CalibrationFilter::factoryMethod();
+        bin.add(filters[0], "calibration");
+        RingBuffer<CalibratedMagneticFieldData>* buffer = new RingBuffer<CalibratedMagneticFieldData>(1024);
+        BufferReader<CalibratedMagneticFieldData>* reader = new BufferReader<CalibratedMagneticFieldData>(128);
+        QVERIFY(buffer->join(reader));
+        chainBuffer = buffer;
+        chainReader = reader;
+        writer = new SessionWriter<CalibratedMagneticFieldData>(&session, fds[1]);
+        bin.add(chainBuffer, "chainbuffer");
+        bin.add(chainReader, "chainreader");
+        bin.add(writer, "writer");
+        QVERIFY(bin.join("adaptorreader", "source", "calibration", "magsink"));
+        QVERIFY(bin.join("calibration", "calibratedmagneticfield", "chainbuffer", "sink"));
+    } else {
+        filters << CalibrationFilter::factoryMethod() << CompassFilter::factoryMethod()
+                << HeadingSmoothFilter::factoryMethod() << DeclinationFilter::factoryMethod();
+        bin.add(filters[0], "calibration");
+        bin.add(filters[1], "compass");
+        bin.add(filters[2], "headingsmooth");
+        bin.add(filters[3], "declination");
+        RingBuffer<CompassData>* buffer = new RingBuffer<CompassData>(1024);
+        BufferReader<CompassData>* reader = new BufferReader<CompassData>(128);
+        QVERIFY(buffer->join(reader));
+        chainBuffer = buffer;
+        chainReader = reader;
+        writer = new SessionWriter<CompassData>(&session, fds[1]);
+        bin.add(chainBuffer, "chainbuffer");
+        bin.add(chainReader, "chainreader");
+        bin.add(writer, "writer");
+        QVERIFY(bin.join("adaptorreader", "source", "calibration", "magsink"));
+        QVERIFY(bin.join("calibration", "calibratedmagneticfield", "compass", "magsink"));
+        QVERIFY(bin.join("accelerometer", "source", "compass", "accsink"));
+        QVERIFY(bin.join("compass", "magnorthangle", "headingsmooth", "sink"));
+        QVERIFY(bin.join("headingsmooth", "source", "declination", "sink"));
+        QVERIFY(bin.join("declination", "source", "chainbuffer", "sink"));
+    }
+    QVERIFY(bin.join("chainreader", "source", "writer", "sink"));
+    bin.start();
+
+    QVector<TimedXyzData> input = xyzSamples(WARMUP + SAMPLES);
+    for (int i = 0; i < WARMUP; ++i) {
+        accelerometer.push(1, &input[i]);
+        source.push(1, &input[i]);
+    }
+
+    AllocationCounter::start();
+    for (int i = WARMUP; i < WARMUP + SAMPLES; ++i) {
+        accelerometer.push(1, &input[i]);
+        source.push(1, &input[i]);
+    }
+    unsigned int allocations = AllocationCounter::stop();
+
+    bin.stop();
+    chainBuffer->unjoin(chainReader);
+    adaptorBuffer.unjoin(&adaptorReader);
+    delete writer;
+    delete chainReader;
+    delete chainBuffer;
+    qDeleteAll(filters);
+    close(fds[1]);
+
+    QCOMPARE(allocations, 0u);
+}
+
+void CoreBenchmark::benchmarkNodeMemory_data()
+{
+    QTest::addColumn<QString>("node");
+    QStringList nodes;
+    nodes << "ringbuffer" << "bufferreader" << "coordinatealign" << "avgacc" << "downsample"
+          << "orientationinterpreter" << "declination" << "rotation" << "calibration"
+          << "compass" << "headingsmooth";
+    foreach (const QString& node, nodes)
+        QTest::newRow(qPrintable(node)) << node;
+}
+
+void CoreBenchmark::benchmarkNodeMemory()
+{
+    QFETCH(QString, node);
+
+    // Heap held by an idle node of each type, as created by the chains.
+    // Reported in bytes per node.
+    long bytes = 0;
+    if (node == "ringbuffer")
+        bytes = nodeHeap(createRingBuffer<TimedXyzData>);
+    else if (node == "bufferreader")
+        bytes = nodeHeap(createBufferReader<TimedXyzData>);
+    else if (node == "coordinatealign")
+        bytes = nodeHeap(CoordinateAlignFilter::factoryMethod);
+    else if (node == "avgacc")
+        bytes = nodeHeap(AvgAccFilter::factoryMethod);
+    else if (node == "downsample")
+        bytes = nodeHeap(DownsampleFilter::factoryMethod);
+    else if (node == "orientationinterpreter")
+        bytes = nodeHeap(OrientationInterpreter::factoryMethod);
+    else if (node == "declination")
+        bytes = nodeHeap(DeclinationFilter::factoryMethod);
+    else if (node == "rotation")
+        bytes = nodeHeap(RotationFilter::factoryMethod);
+    else if (node == "calibration")
+        bytes = nodeHeap(CalibrationFilter::factoryMethod);
+    else if (node == "compass")
+        bytes = nodeHeap(CompassFilter::factoryMethod);
+    else if (node == "headingsmooth")
+        bytes = nodeHeap(HeadingSmoothFilter::factoryMethod);
+
+    QVERIFY(bytes > 0);
+    QTest::setBenchmarkResult(bytes, QTest::BytesAllocated);
+}
+
+QTEST_MAIN(CoreBenchmark)
@@ -0,0 +1,161 @@
+/**
+   @file corebenchmarks.h
+   @brief Microbenchmarks for core dataflow primitives
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+*/
+
+
+#ifndef COREBENCHMARKS_H
+#define COREBENCHMARKS_H
+
+#define CONFIG_FILE_PATH     "/etc/sensorfw/sensord.conf"
+#define CONFIG_DIR_PATH      "/etc/sensorfw/sensord.conf.d/"
+
+#include <QTest>
+#include "pusher.h"
+#include "consumer.h"
+#include "source.h"
+#include "sink.h"
+#include "sockethandler.h"
+#include <unistd.h>
+
+/**
+ * Pusher propagating synthetic samples given to #push().
+ */
+template <class TYPE>
+class SyntheticSource : public Pusher
+{
+public:
+    SyntheticSource()
+    {
+        addSource(&source_, "source");
+    }
+
+    void push(int n, const TYPE* values)
+    {
+        source_.propagate(n, values);
+    }
+
+    void pushNewData() {}
+
+private:
+    Source<TYPE> source_;
+};
+
+/**
+ * Consumer counting the samples it receives.
+ */
+template <class TYPE>
+class CountingSink : public Consumer
+{
+public:
+    CountingSink() :
+        sink_(this, &CountingSink::collect),
+        count_(0)
+    {
+        addSink(&sink_, "sink");
+    }
+
+    unsigned int count() const { return count_; }
+
+private:
+    void collect(unsigned n, const TYPE*)
+    {
+        count_ += n;
+    }
+
+    Sink<CountingSink, TYPE> sink_;
+    unsigned int             count_;
+};
+
+/**
+ * Consumer writing the samples it receives to a session, like the
+ * delivery of a sensor channel, and reading them on the client side of
+ * the socket.
+ */
+template <class TYPE>
+class SessionWriter : public Consumer
+{
+public:
+    SessionWriter(SessionData* session, int clientFd) :
+        sink_(this, &SessionWriter::write),
+        session_(session),
+        clientFd_(clientFd)
+    {
+        addSink(&sink_, "sink");
+    }
+
+private:
+    void write(unsigned n, const TYPE* values)
+    {
+        for (unsigned i = 0; i < n; ++i)
+            session_->write(&values[i], sizeof(TYPE));
+        session_->flush();
+        while (::read(clientFd_, drain_, sizeof(drain_)) > 0)
+            ;
+    }
+
+    Sink<SessionWriter, TYPE> sink_;
+    SessionData*              session_;
+    int                       clientFd_;
+    char                      drain_[4096];
+};
+
+/**
+ * In-process benchmarks of the dataflow primitives with synthetic
+ * data. Each benchmark has rows for the batch sizes seen in practice:
+ * single samples from polled adaptors and batches from buffered ones.
+ */
+class CoreBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void benchmarkSourcePropagate_data();
+    void benchmarkSourcePropagate();
+
+    void benchmarkRingBufferWrite_data();
+    void benchmarkRingBufferWrite();
+
+    void benchmarkRingBufferRead_data();
+    void benchmarkRingBufferRead();
+
+    void benchmarkAdaptorCommit_data();
+    void benchmarkAdaptorCommit();
+
+    void benchmarkChain_data();
+    void benchmarkChain();
+
+    void benchmarkFilter_data();
+    void benchmarkFilter();
+
+    void benchmarkSessionDataWrite_data();
+    void benchmarkSessionDataWrite();
+
+    void testSteadyStateAllocations_data();
+    void testSteadyStateAllocations();
+
+    void benchmarkNodeMemory_data();
+    void benchmarkNodeMemory();
+};
+
+#endif // COREBENCHMARKS_H
@@ -29,9 +29,11 @@
 int main(int argc, char** argv)
 {
     QCoreApplication app(argc, argv);
-    DummyClient dc;
-    
-    QTimer::singleShot(1500, &dc, SLOT(closeSession()));
+    DummyClientOptions options;
+    options.parse(app.arguments());
+    DummyClient dc(options);
+
+    QTimer::singleShot(options.duration, &dc, SLOT(closeSession()));
     QObject::connect(&dc, SIGNAL(sessionClosed()), &app, SLOT(quit()));
 
     return app.exec();
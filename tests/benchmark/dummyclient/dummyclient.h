@@ -24,28 +24,114 @@
 */
 
 #include <QObject>
+#include <QStringList>
+#include <QTextStream>
+#include <QElapsedTimer>
 #include "sensormanagerinterface.h"
+#include "alssensor_i.h"
+#include "accelerometersensor_i.h"
+#include "magnetometersensor_i.h"
+#include "gyroscopesensor_i.h"
+#include "proximitysensor_i.h"
 #include "orientationsensor_i.h"
+#include "rotationsensor_i.h"
 
 #ifndef DUMMYCLIENT_H
 #define DUMMYCLIENT_H
 
+/**
+ * Session settings of the dummy client.
+ */
+struct DummyClientOptions
+{
+    DummyClientOptions() :
+        sensor("orientationsensor"),
+        interval(0),
+        bufferSize(1),
+        bufferInterval(0),
+        downsampling(true),
+        standbyOverride(false),
+        trace(false),
+        duration(1500)
+    {}
+
+    /**
+     * Parse options of form <tt>--name=value</tt>.
+     *
+     * @param arguments command line arguments.
+     */
+    void parse(const QStringList& arguments)
+    {
+        foreach (const QString& argument, arguments) {
+            QString name = argument.section('=', 0, 0);
+            QString value = argument.section('=', 1);
+            if (name == "--sensor")
+                sensor = value;
+            else if (name == "--interval")
+                interval = value.toInt();
+            else if (name == "--buffersize")
+                bufferSize = value.toUInt();
+            else if (name == "--bufferinterval")
+                bufferInterval = value.toUInt();
+            else if (name == "--downsampling")
+                downsampling = value.toInt();
+            else if (name == "--standbyoverride")
+                standbyOverride = true;
+            else if (name == "--trace")
+                trace = true;
+            else if (name == "--duration")
+                duration = value.toInt();
+        }
+    }
+
+    QString      sensor;         /**< sensor ID */
+    int          interval;       /**< interval in milliseconds, 0 for default */
+    unsigned int bufferSize;     /**< buffer size */
+    unsigned int bufferInterval; /**< buffer interval in milliseconds */
+    bool         downsampling;   /**< is downsampling enabled */
+    bool         standbyOverride; /**< keep running while the display is off */
+    bool         trace;          /**< enable latency tracing */
+    int          duration;       /**< session length in milliseconds */
+};
+
+/**
+ * Client opening a single session. When the session is closed a
+ * summary is printed to stdout as <tt>key=value</tt> pairs on one line,
+ * the latency histogram uses the buckets of LatencyStatistics. Open and
+ * close latencies cover the calls from loading the plugin to starting
+ * the session and from stopping it to releasing it.
+ */
 class DummyClient : public QObject
 {
     Q_OBJECT;
 public:
-    DummyClient(QObject* parent=0) : QObject(parent), sensor(NULL)
+    DummyClient(const DummyClientOptions& options = DummyClientOptions(), QObject* parent=0) :
+        QObject(parent),
+        options_(options),
+        sensor(NULL),
+        received(0),
+        openUs(0)
     {
+        QElapsedTimer timer;
+        timer.start();
         SensorManagerInterface& sm = SensorManagerInterface::instance();
 
-        sm.loadPlugin("orientationsensor");
-        sm.registerSensorInterface<OrientationSensorChannelInterface>("orientationsensor");
-
-        sensor = OrientationSensorChannelInterface::interface("orientationsensor");
+        sm.loadPlugin(options_.sensor);
+        sensor = openSensor(sm, options_.sensor);
         if (sensor == NULL || !sensor->isValid()) {
             qDebug() << "[DummyClient] Unable to get session:" << sm.errorString();
         } else {
+            if (options_.interval)
+                sensor->setInterval(options_.interval);
+            sensor->setBufferSize(options_.bufferSize);
+            sensor->setBufferInterval(options_.bufferInterval);
+            sensor->setDownsampling(options_.downsampling);
+            if (options_.standbyOverride)
+                sensor->setStandbyOverride(true);
+            if (options_.trace)
+                sensor->setLatencyTracing(true);
             sensor->start();
+            openUs = timer.nsecsElapsed() / 1000;
         }
     }
 
@@ -55,15 +141,91 @@ signals:
 public slots:
     void closeSession() {
         if (sensor) {
+            QElapsedTimer timer;
+            timer.start();
             sensor->stop();
+            qint64 stopUs = timer.nsecsElapsed() / 1000;
+            QString line = summary();
+            timer.restart();
             delete sensor;
+            sensor = NULL;
+            qint64 closeUs = stopUs + timer.nsecsElapsed() / 1000;
+            QTextStream(stdout) << line << " open_us=" << openUs << " close_us=" << closeUs << endl;
         }
         emit sessionClosed();
     }
-    
+
+private slots:
+    void sampleReceived() { ++received; }
+    void frameReceived(const QVector<XYZ>& frame) { received += frame.size(); }
+    void magneticFrameReceived(const QVector<MagneticField>& frame) { received += frame.size(); }
 
 private:
-    OrientationSensorChannelInterface* sensor;
+    AbstractSensorChannelInterface* openSensor(SensorManagerInterface& sm, const QString& id)
+    {
+        AbstractSensorChannelInterface* ifc = NULL;
+        if (id == "alssensor") {
+            sm.registerSensorInterface<ALSSensorChannelInterface>(id);
+            ifc = ALSSensorChannelInterface::interface(id);
+            connect(ifc, SIGNAL(ALSChanged(const Unsigned&)), this, SLOT(sampleReceived()));
+        } else if (id == "accelerometersensor") {
+            sm.registerSensorInterface<AccelerometerSensorChannelInterface>(id);
+            ifc = AccelerometerSensorChannelInterface::interface(id);
+            connect(ifc, SIGNAL(dataAvailable(const XYZ&)), this, SLOT(sampleReceived()));
+            connect(ifc, SIGNAL(frameAvailable(const QVector<XYZ>&)), this, SLOT(frameReceived(const QVector<XYZ>&)));
+        } else if (id == "magnetometersensor") {
+            sm.registerSensorInterface<MagnetometerSensorChannelInterface>(id);
+            ifc = MagnetometerSensorChannelInterface::interface(id);
+            connect(ifc, SIGNAL(dataAvailable(const MagneticField&)), this, SLOT(sampleReceived()));
+            connect(ifc, SIGNAL(frameAvailable(const QVector<MagneticField>&)), this, SLOT(magneticFrameReceived(const QVector<MagneticField>&)));
+        } else if (id == "gyroscopesensor") {
+            sm.registerSensorInterface<GyroscopeSensorChannelInterface>(id);
+            ifc = GyroscopeSensorChannelInterface::interface(id);
+            connect(ifc, SIGNAL(dataAvailable(const XYZ&)), this, SLOT(sampleReceived()));
+            connect(ifc, SIGNAL(frameAvailable(const QVector<XYZ>&)), this, SLOT(frameReceived(const QVector<XYZ>&)));
+        } else if (id == "proximitysensor") {
+            sm.registerSensorInterface<ProximitySensorChannelInterface>(id);
+            ifc = ProximitySensorChannelInterface::interface(id);
+            connect(ifc, SIGNAL(dataAvailable(const Unsigned&)), this, SLOT(sampleReceived()));
+        } else if (id == "rotationsensor") {
+            sm.registerSensorInterface<RotationSensorChannelInterface>(id);
+            ifc = RotationSensorChannelInterface::interface(id);
+            connect(ifc, SIGNAL(dataAvailable(const XYZ&)), this, SLOT(sampleReceived()));
+            connect(ifc, SIGNAL(frameAvailable(const QVector<XYZ>&)), this, SLOT(frameReceived(const QVector<XYZ>&)));
+        } else {
+            sm.registerSensorInterface<OrientationSensorChannelInterface>(id);
+            ifc = OrientationSensorChannelInterface::interface(id);
+            connect(ifc, SIGNAL(orientationChanged(const Unsigned&)), this, SLOT(sampleReceived()));
+        }
+        return ifc;
+    }
+
+    QString summary() const
+    {
+        const LatencyStatistics& latency = sensor->latencyStatistics();
+        QStringList histogram;
+        for (int i = 0; i < LatencyStatistics::BUCKETS; ++i)
+            histogram << QString::number(latency.histogram(LatencyStatistics::TotalStage, i));
+
+        QString line;
+        QTextStream out(&line);
+        out << "sensor=" << options_.sensor
+            << " interval=" << options_.interval
+            << " buffersize=" << options_.bufferSize
+            << " downsampling=" << (options_.downsampling ? 1 : 0)
+            << " received=" << received
+            << " dropped=" << sensor->samplesDropped()
+            << " latency_count=" << latency.count()
+            << " latency_max=" << latency.maximum(LatencyStatistics::TotalStage)
+            << " latency_histogram=" << histogram.join(",");
+        out.flush();
+        return line;
+    }
+
+    DummyClientOptions options_;
+    AbstractSensorChannelInterface* sensor;
+    unsigned int received;
+    qint64 openUs;
 };
 
 #endif
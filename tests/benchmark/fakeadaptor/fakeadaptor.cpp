@@ -25,34 +25,23 @@
 
 #include <QtDebug>
 #include <QFile>
+#include <QSettings>
 #include "fakeadaptor.h"
 #include <errno.h>
+#include <time.h>
 #include "datatypes/utils.h"
 
-FakeAdaptor::FakeAdaptor(const QString& id) : DeviceAdaptor(id), interval_(1)
+FakeAdaptor::FakeAdaptor(const QString& id, const QString& sensorName) :
+    DeviceAdaptor(id),
+    interval_(1000),
+    batch_(1),
+    sensorName_(sensorName)
 {
     t = new FakeAdaptorThread(this);
-
-    buffer_ = new DeviceAdaptorRingBuffer<TimedUnsigned>(1024);
-    setAdaptedSensor("als", "Internal ambient light sensor lux values", buffer_);
 }
 
 bool FakeAdaptor::startAdaptor()
 {
-    QFile file("/tmp/sensorTestSampleRate");
-
-    if (!file.exists() || !file.open(QIODevice::ReadOnly)) {
-        qDebug() << "Failed to get rate from" << file.fileName() << "- using 1000Hz (open)";
-        return true;
-    }
-
-    interval_ = atoi(file.readLine().data());
-    if (interval_ <= 0) {
-        qDebug() << "Failed to get rate from" << file.fileName() << "- using 1000Hz (readline)";
-        return true;
-    }
-
-    file.close();
     return true;
 }
 
@@ -62,7 +51,25 @@ void FakeAdaptor::stopAdaptor()
 
 bool FakeAdaptor::startSensor()
 {
-    qDebug() << "Pushing fake ALS data with" << interval_ << " msec interval";
+    interval_ = 1000;
+    batch_ = 1;
+
+    if (sensorName_ == "als") {
+        QFile file("/tmp/sensorTestSampleRate");
+        if (file.open(QIODevice::ReadOnly)) {
+            int interval = atoi(file.readLine().data());
+            if (interval > 0)
+                interval_ = interval * 1000;
+        }
+    }
+
+    QSettings settings("/tmp/sensorTestConfig", QSettings::IniFormat);
+    settings.beginGroup(sensorName_);
+    interval_ = qMax(1u, settings.value("interval_us", interval_).toUInt());
+    batch_ = qMax(1u, settings.value("batch", batch_).toUInt());
+    settings.endGroup();
+
+    qDebug() << "Pushing fake" << sensorName_ << "data with" << interval_ << "usec interval in batches of" << batch_;
     // Start pushing data
     t->running = true;
     t->start();
@@ -77,16 +84,11 @@ void FakeAdaptor::stopSensor()
     qDebug() << "sensor stopped";
 }
 
-
-void FakeAdaptor::pushNewData(int& data)
+void FakeAdaptor::pushNewData(unsigned int& counter, quint64 timestamp)
 {
-    TimedUnsigned* lux = buffer_->nextSlot();
-
-    lux->timestamp_ = Utils::getTimeStamp();
-    lux->value_ = data;
-
-    buffer_->commit();
-    buffer_->wakeUpReaders();
+    for (unsigned int i = 0; i < batch_; ++i)
+        writeSample(counter++, timestamp - (quint64)(batch_ - 1 - i) * interval_);
+    wakeUpReaders();
 }
 
 void FakeAdaptor::init()
@@ -95,15 +97,23 @@ void FakeAdaptor::init()
 
 FakeAdaptorThread::FakeAdaptorThread(FakeAdaptor *parent) : running(false), parent_(parent)
 {
-    qDebug() << "Data pusher for ALS";
 }
 
 void FakeAdaptorThread::run()
 {
-    int i = 0;
+    unsigned int counter = 0;
+    quint64 period = (quint64)parent_->interval_ * parent_->batch_;
+
+    // Sleep to absolute deadlines so that the rate does not drift with
+    // the time spent pushing.
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
     while(running) {
-        QThread::msleep(parent_->interval_);
-        parent_->pushNewData(i);
-        i++;
+        quint64 ns = deadline.tv_nsec + period * 1000;
+        deadline.tv_sec += ns / 1000000000;
+        deadline.tv_nsec = ns % 1000000000;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR)
+            ;
+        parent_->pushNewData(counter, Utils::getTimeStamp());
     }
 }
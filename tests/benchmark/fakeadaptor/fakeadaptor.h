@@ -29,6 +29,7 @@
 #include "deviceadaptor.h"
 #include "deviceadaptorringbuffer.h"
 #include "datatypes/timedunsigned.h"
+#include "datatypes/orientationdata.h"
 #include <QTime>
 #include <QThread>
 
@@ -40,7 +41,7 @@ class FakeAdaptorThread : public QThread
 public:
     FakeAdaptorThread(FakeAdaptor *parent);
     void run();
-    bool running;
+    volatile bool running;
 
 private:
     FakeAdaptor *parent_;
@@ -48,34 +49,130 @@ private:
 
 /**
  * @brief Adaptor faking another adaptor input with generated data
+ *
+ * Rate and batch size are read from <tt>/tmp/sensorTestConfig</tt> every
+ * time the sensor is started, so a running sensord can be driven with
+ * different loads:
+ *
+ * <pre>
+ * [accelerometer]
+ * interval_us = 10000
+ * batch = 4
+ * </pre>
+ *
+ * The group is the name of the adapted sensor. With a batch of n the
+ * thread wakes up every n intervals and pushes n samples at once, like
+ * a driver with a hardware FIFO. For ALS the interval in milliseconds
+ * is also read from <tt>/tmp/sensorTestSampleRate</tt>.
  */
 class FakeAdaptor : public DeviceAdaptor
 {
     Q_OBJECT;
 public:
-    static DeviceAdaptor* factoryMethod(const QString& id)
-    {
-        return new FakeAdaptor(id);
-    }
-
     bool startAdaptor();
     void stopAdaptor();
 
     bool startSensor();
     void stopSensor();
 
-    void pushNewData(int& data);
-
     void init();
 
-    unsigned int interval_;
+    /**
+     * Push a batch of generated samples and wake up readers.
+     *
+     * @param counter running sample counter.
+     * @param timestamp timestamp of the newest sample.
+     */
+    void pushNewData(unsigned int& counter, quint64 timestamp);
+
+    unsigned int interval_; /**< interval between samples in microseconds */
+    unsigned int batch_;    /**< samples pushed per wakeup */
 
 protected:
-    FakeAdaptor(const QString& id);
+    FakeAdaptor(const QString& id, const QString& sensorName);
+
+    /**
+     * Write a single generated sample into the output buffer.
+     *
+     * @param counter sample counter, used as the value.
+     * @param timestamp sample timestamp.
+     */
+    virtual void writeSample(unsigned int counter, quint64 timestamp) = 0;
+
+    /**
+     * Wake up readers of the output buffer.
+     */
+    virtual void wakeUpReaders() = 0;
 
 private:
     FakeAdaptorThread* t;
-    DeviceAdaptorRingBuffer<TimedUnsigned>* buffer_;
+    QString sensorName_;
+};
+
+/**
+ * Generated values for the fake sample types.
+ */
+inline void fakeSample(TimedUnsigned& data, unsigned int counter, quint64 timestamp)
+{
+    data = TimedUnsigned(timestamp, counter);
+}
+
+inline void fakeSample(TimedXyzData& data, unsigned int counter, quint64 timestamp)
+{
+    int value = counter % 2000 - 1000;
+    data = TimedXyzData(timestamp, value, -value, 1000);
+}
+
+inline void fakeSample(ProximityData& data, unsigned int counter, quint64 timestamp)
+{
+    data = ProximityData(timestamp, counter % 2, counter % 2);
+}
+
+/**
+ * @brief Fake adaptor producing samples of given type
+ */
+template <class TYPE>
+class FakeTypedAdaptor : public FakeAdaptor
+{
+public:
+    static DeviceAdaptor* factoryMethod(const QString& id)
+    {
+        return new FakeTypedAdaptor<TYPE>(id);
+    }
+
+protected:
+    FakeTypedAdaptor(const QString& id) : FakeAdaptor(id, sensorName(id))
+    {
+        buffer_ = new DeviceAdaptorRingBuffer<TYPE>(1024);
+        setAdaptedSensor(sensorName(id), "Fake " + sensorName(id) + " for benchmarks", buffer_);
+    }
+
+    ~FakeTypedAdaptor()
+    {
+        stopSensor();
+        delete buffer_;
+    }
+
+    void writeSample(unsigned int counter, quint64 timestamp)
+    {
+        TYPE* data = buffer_->nextSlot();
+        fakeSample(*data, counter, timestamp);
+        buffer_->commit();
+    }
+
+    void wakeUpReaders()
+    {
+        buffer_->wakeUpReaders();
+    }
+
+private:
+    static QString sensorName(const QString& id)
+    {
+        // accelerometeradaptor -> accelerometer
+        return id.endsWith("adaptor") ? id.left(id.length() - 7) : id;
+    }
+
+    DeviceAdaptorRingBuffer<TYPE>* buffer_;
 };
 
 #endif
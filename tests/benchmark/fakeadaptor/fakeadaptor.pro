@@ -24,3 +24,7 @@ include(../../../common-install.pri)
 target.path = $$PLUGINPATH/testing
 
 INSTALLS += target
+
+fakeconfig.files = 99-fakeadaptor.conf
+fakeconfig.path = /usr/share/sensorfw-tests
+INSTALLS += fakeconfig
@@ -30,9 +30,15 @@
 
 void FakeAdaptorPlugin::Register(class Loader&)
 {
-    qDebug() << "registering FAKE adaptor";
+    qDebug() << "registering FAKE adaptors";
     SensorManager& sm = SensorManager::instance();
-    sm.registerDeviceAdaptor<FakeAdaptor>("alsadaptor");
+    sm.registerDeviceAdaptor<FakeTypedAdaptor<TimedUnsigned> >("alsadaptor");
+    // Other adaptors are only used when mapped to this plugin in the
+    // configuration, see 99-fakeadaptor.conf.
+    sm.registerDeviceAdaptor<FakeTypedAdaptor<AccelerationData> >("accelerometeradaptor");
+    sm.registerDeviceAdaptor<FakeTypedAdaptor<TimedXyzData> >("magnetometeradaptor");
+    sm.registerDeviceAdaptor<FakeTypedAdaptor<TimedXyzData> >("gyroscopeadaptor");
+    sm.registerDeviceAdaptor<FakeTypedAdaptor<ProximityData> >("proximityadaptor");
 }
 
 #if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
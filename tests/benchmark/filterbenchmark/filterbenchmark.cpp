@@ -0,0 +1,562 @@
+/**
+   @file filterbenchmark.cpp
+   @brief Golden trace benchmarks of the filters
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+*/
+
+#include <QtDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QList>
+
+#include "filterbenchmark.h"
+#include "bin.h"
+#include "filter.h"
+#include "config.h"
+#include "logging.h"
+#include "coordinatealignfilter.h"
+#include "avgaccfilter.h"
+#include "downsamplefilter.h"
+#include "orientationinterpreter.h"
+#include "declinationfilter.h"
+#include "rotationfilter.h"
+#include "accelerometerchainfilter.h"
+#include "accelerometerfloatfilter.h"
+#include "compassfilter.h"
+#include "headingsmoothfilter.h"
+#include "fusionfilter.h"
+#include "gyroscopebiasfilter.h"
+#include "calibrationfilter.h"
+#include "stepdetectorfilter.h"
+#include "normalizerfilter.h"
+#include "avgvarfilter.h"
+#include "cutterfilter.h"
+
+#define GOLDEN_DIR_PATH "/usr/share/sensorfw-tests/golden"
+
+static QString goldenDir()
+{
+    QByteArray dir = qgetenv("SENSORFW_GOLDEN_DIR");
+    return dir.isEmpty() ? QString(GOLDEN_DIR_PATH) : QString::fromLocal8Bit(dir);
+}
+
+static bool recordMode()
+{
+    return !qgetenv("SENSORFW_GOLDEN_RECORD").isEmpty();
+}
+
+/**
+ * Deterministic noise, so that synthesized traces are the same on
+ * every run and architecture.
+ */
+class Noise
+{
+public:
+    Noise(quint32 seed) : state_(seed) {}
+
+    /**
+     * Next value, uniform in [-amplitude, amplitude].
+     */
+    int next(int amplitude)
+    {
+        state_ = state_ * 1664525u + 1013904223u;
+        return (int)((state_ >> 8) % (quint32)(2 * amplitude + 1)) - amplitude;
+    }
+
+private:
+    quint32 state_;
+};
+
+static const quint64 TRACE_START = 1000000;  /**< timestamp of the first sample */
+static const int     TRACE_SECONDS = 60;     /**< length of the traces */
+static const int     POSE_SECONDS = 6;       /**< time spent in each pose */
+static const int     TURN_SECONDS = 2;       /**< end of each pose spent turning to the next */
+
+/**
+ * Gravity in milli-G at the start of each pose: face up, the four
+ * edges up, face down, then walking with the device held tilted.
+ */
+static const int POSES[][3] = {
+    { 0, 0, 980 },
+    { 0, -980, 0 },
+    { 980, 0, 0 },
+    { 0, 980, 0 },
+    { -980, 0, 0 },
+    { 0, 0, -980 },
+    { 0, -700, 700 },
+    { 0, -700, 700 },
+    { 0, 0, 980 },
+    { 0, 0, 980 },
+    { 0, 0, 980 }
+};
+
+static const int WALK_START = 36;  /**< walking from this second */
+static const int WALK_END = 48;    /**< until this second */
+
+/**
+ * Is the device turning from one pose to the next.
+ */
+static bool turning(double seconds)
+{
+    return fmod(seconds, POSE_SECONDS) >= POSE_SECONDS - TURN_SECONDS;
+}
+
+static QVector<TimedXyzData> accelerometerTrace()
+{
+    const int RATE = 100;
+    Noise noise(1);
+    QVector<TimedXyzData> trace(TRACE_SECONDS * RATE);
+    for (int i = 0; i < trace.size(); ++i) {
+        double seconds = (double)i / RATE;
+        int pose = (int)seconds / POSE_SECONDS;
+        double turn = qMax(0.0, fmod(seconds, POSE_SECONDS) - (POSE_SECONDS - TURN_SECONDS)) / TURN_SECONDS;
+        double g[3], norm = 0;
+        for (int axis = 0; axis < 3; ++axis) {
+            g[axis] = POSES[pose][axis] * (1 - turn) + POSES[pose + 1][axis] * turn;
+            norm += g[axis] * g[axis];
+        }
+        double scale = 980 / qMax(1.0, sqrt(norm));
+        if (seconds >= WALK_START && seconds < WALK_END)
+            scale *= 1 + 0.3 * sin(2 * M_PI * 2 * seconds);
+        trace[i] = TimedXyzData(TRACE_START + (quint64)i * 1000000 / RATE,
+                                (int)(g[0] * scale) + noise.next(12),
+                                (int)(g[1] * scale) + noise.next(12),
+                                (int)(g[2] * scale) + noise.next(12));
+    }
+    return trace;
+}
+
+static QVector<TimedXyzFloatData> accelerometerFloatTrace()
+{
+    QVector<TimedXyzData> milliG = accelerometerTrace();
+    QVector<TimedXyzFloatData> trace(milliG.size());
+    for (int i = 0; i < trace.size(); ++i) {
+        const TimedXyzData& s = milliG.at(i);
+        trace[i] = TimedXyzFloatData(s.timestamp_, s.x_ * 0.00980665f, s.y_ * 0.00980665f, s.z_ * 0.00980665f);
+    }
+    return trace;
+}
+
+static QVector<double> accelerometerNormTrace()
+{
+    QVector<TimedXyzData> milliG = accelerometerTrace();
+    QVector<double> trace(milliG.size());
+    for (int i = 0; i < trace.size(); ++i) {
+        const TimedXyzData& s = milliG.at(i);
+        trace[i] = sqrt((double)s.x_ * s.x_ + (double)s.y_ * s.y_ + (double)s.z_ * s.z_);
+    }
+    return trace;
+}
+
+/**
+ * Heading in degrees, a full turn every half a minute.
+ */
+static double heading(double seconds)
+{
+    return fmod(seconds * 12, 360);
+}
+
+static QVector<TimedXyzData> magnetometerTrace()
+{
+    const int RATE = 50;
+    const int OFFSET[3] = { 30, -20, 15 };  // hard iron offset
+    Noise noise(2);
+    QVector<TimedXyzData> trace(TRACE_SECONDS * RATE);
+    for (int i = 0; i < trace.size(); ++i) {
+        double angle = heading((double)i / RATE) * M_PI / 180;
+        trace[i] = TimedXyzData(TRACE_START + (quint64)i * 1000000 / RATE,
+                                (int)(200 * cos(angle)) + OFFSET[0] + noise.next(3),
+                                (int)(-200 * sin(angle)) + OFFSET[1] + noise.next(3),
+                                400 + OFFSET[2] + noise.next(3));
+    }
+    return trace;
+}
+
+static QVector<CalibratedMagneticFieldData> calibratedMagnetometerTrace()
+{
+    const int OFFSET[3] = { 30, -20, 15 };
+    QVector<TimedXyzData> raw = magnetometerTrace();
+    QVector<CalibratedMagneticFieldData> trace(raw.size());
+    for (int i = 0; i < trace.size(); ++i) {
+        const TimedXyzData& s = raw.at(i);
+        trace[i] = CalibratedMagneticFieldData(s.timestamp_, s.x_ - OFFSET[0], s.y_ - OFFSET[1], s.z_ - OFFSET[2],
+                                               s.x_, s.y_, s.z_, 3);
+    }
+    return trace;
+}
+
+static QVector<CompassData> compassTrace()
+{
+    const int RATE = 10;
+    QVector<CompassData> trace(TRACE_SECONDS * RATE);
+    for (int i = 0; i < trace.size(); ++i)
+        trace[i] = CompassData(TRACE_START + (quint64)i * 1000000 / RATE, (int)heading((double)i / RATE), 3);
+    return trace;
+}
+
+static QVector<TimedXyzData> gyroscopeTrace()
+{
+    const int RATE = 100;
+    const int BIAS[3] = { 120, -80, 40 };  // milli-degrees per second
+    Noise noise(3);
+    QVector<TimedXyzData> trace(TRACE_SECONDS * RATE);
+    for (int i = 0; i < trace.size(); ++i) {
+        double seconds = (double)i / RATE;
+        int rate = turning(seconds) ? 45000 : 0;
+        trace[i] = TimedXyzData(TRACE_START + (quint64)i * 1000000 / RATE,
+                                rate + BIAS[0] + noise.next(30),
+                                BIAS[1] + noise.next(30),
+                                BIAS[2] + noise.next(30));
+    }
+    return trace;
+}
+
+/**
+ * Feed of a trace, read from <tt>&lt;name&gt;.input</tt> in the golden
+ * directory if it holds a recording of the type, otherwise synthesized.
+ */
+template <class TYPE>
+static TraceFeed* traceFeed(const QString& name, QVector<TYPE> (*synthesize)(), quint32 interval)
+{
+    QString path = goldenDir() + "/" + name + ".input";
+    QVector<TYPE> trace;
+    if (!loadRecording(path, trace)) {
+        trace = synthesize();
+        if (recordMode() && !QFile::exists(path) && !saveRecording(path, trace, interval))
+            qWarning() << "Failed to store trace" << path;
+    }
+    return new TypedTraceFeed<TYPE>(trace);
+}
+
+static TraceFeed* createFeed(const QString& trace)
+{
+    if (trace == "accelerometer")
+        return traceFeed(trace, accelerometerTrace, 10000);
+    if (trace == "accelerometerfloat")
+        return traceFeed(trace, accelerometerFloatTrace, 10000);
+    if (trace == "accelerometernorm")
+        return traceFeed(trace, accelerometerNormTrace, 10000);
+    if (trace == "magnetometer")
+        return traceFeed(trace, magnetometerTrace, 20000);
+    if (trace == "calibratedmagnetometer")
+        return traceFeed(trace, calibratedMagnetometerTrace, 20000);
+    if (trace == "compass")
+        return traceFeed(trace, compassTrace, 100000);
+    if (trace == "gyroscope")
+        return traceFeed(trace, gyroscopeTrace, 10000);
+    return NULL;
+}
+
+template <class TYPE>
+static TraceOutput* createOutput()
+{
+    return new TypedTraceOutput<TYPE>;
+}
+
+static double ALIGN_MATRIX[3][3] = { { 0, 1, 0 }, { -1, 0, 0 }, { 0, 0, 1 } };
+
+static FilterBase* createCoordinateAlign()
+{
+    CoordinateAlignFilter* filter = (CoordinateAlignFilter*)CoordinateAlignFilter::factoryMethod();
+    filter->setMatrix(TMatrix(ALIGN_MATRIX));
+    return filter;
+}
+
+static FilterBase* createDownsample()
+{
+    DownsampleFilter* filter = (DownsampleFilter*)DownsampleFilter::factoryMethod();
+    filter->setBufferSize(4);
+    return filter;
+}
+
+static FilterBase* createAccelerometerChain()
+{
+    AccelerometerChainFilter* filter = (AccelerometerChainFilter*)AccelerometerChainFilter::factoryMethod();
+    filter->setMatrix(ALIGN_MATRIX);
+    filter->setOffset(10, -20, 5);
+    filter->setSmoothing(0.2);
+    return filter;
+}
+
+static FilterBase* createAccelerometerFloat()
+{
+    AccelerometerFloatFilter* filter = (AccelerometerFloatFilter*)AccelerometerFloatFilter::factoryMethod();
+    filter->setMatrix(ALIGN_MATRIX);
+    filter->setOffset(10, -20, 5);
+    filter->setSmoothing(0.2);
+    return filter;
+}
+
+static FilterBase* createNormalizer() { return new NormalizerFilter; }
+static FilterBase* createAvgVar() { return new AvgVarFilter(60); }
+static FilterBase* createAvgVarWelford() { return new AvgVarFilter(60, true); }
+static FilterBase* createCutter() { return new CutterFilter(4.0); }
+
+/**
+ * Trace fed into a sink of the filter.
+ */
+struct GoldenInput
+{
+    const char* trace; /**< trace name, NULL ends the inputs */
+    const char* sink;  /**< sink of the filter */
+};
+
+/**
+ * Filter with its inputs and the output checked.
+ */
+struct GoldenCase
+{
+    const char*  name;              /**< case name, also of the golden output */
+    FilterBase*  (*create)();       /**< creates the configured filter */
+    const char*  source;            /**< source of the filter checked */
+    TraceOutput* (*createOutput)(); /**< creates output of the source type */
+    GoldenInput  inputs[4];         /**< inputs of the filter */
+};
+
+static const GoldenCase CASES[] = {
+    { "coordinatealign", createCoordinateAlign, "source", createOutput<TimedXyzData>,
+      { { "accelerometer", "sink" }, { NULL, NULL } } },
+    { "avgacc", AvgAccFilter::factoryMethod, "source", createOutput<TimedXyzData>,
+      { { "accelerometer", "sink" }, { NULL, NULL } } },
+    { "downsample", createDownsample, "source", createOutput<TimedXyzData>,
+      { { "accelerometer", "sink" }, { NULL, NULL } } },
+    { "orientationinterpreter", OrientationInterpreter::factoryMethod, "orientation", createOutput<PoseData>,
+      { { "accelerometer", "accsink" }, { NULL, NULL } } },
+    { "declination", DeclinationFilter::factoryMethod, "source", createOutput<CompassData>,
+      { { "compass", "sink" }, { NULL, NULL } } },
+    { "rotation", RotationFilter::factoryMethod, "source", createOutput<TimedXyzData>,
+      { { "accelerometer", "accelerometersink" }, { "compass", "compasssink" }, { NULL, NULL } } },
+    { "accelerometerchain", createAccelerometerChain, "source", createOutput<TimedXyzData>,
+      { { "accelerometer", "sink" }, { NULL, NULL } } },
+    { "accelerometerfloat", createAccelerometerFloat, "source", createOutput<TimedXyzFloatData>,
+      { { "accelerometerfloat", "sink" }, { NULL, NULL } } },
+    { "compass", CompassFilter::factoryMethod, "magnorthangle", createOutput<CompassData>,
+      { { "calibratedmagnetometer", "magsink" }, { "accelerometer", "accsink" }, { NULL, NULL } } },
+    { "headingsmooth", HeadingSmoothFilter::factoryMethod, "source", createOutput<CompassData>,
+      { { "compass", "sink" }, { NULL, NULL } } },
+    { "fusion", FusionFilter::factoryMethod, "quaternion", createOutput<TimedQuaternionData>,
+      { { "gyroscope", "gyrosink" }, { "accelerometer", "accsink" }, { "calibratedmagnetometer", "magsink" }, { NULL, NULL } } },
+    { "gyroscopebias", GyroscopeBiasFilter::factoryMethod, "source", createOutput<TimedXyzData>,
+      { { "gyroscope", "sink" }, { NULL, NULL } } },
+    { "calibration", CalibrationFilter::factoryMethod, "calibratedmagneticfield", createOutput<CalibratedMagneticFieldData>,
+      { { "magnetometer", "magsink" }, { NULL, NULL } } },
+    { "stepdetector", StepDetectorFilter::factoryMethod, "source", createOutput<TimedUnsigned>,
+      { { "accelerometer", "sink" }, { NULL, NULL } } },
+    { "contextnormalizer", createNormalizer, "source", createOutput<double>,
+      { { "accelerometer", "sink" }, { NULL, NULL } } },
+    { "contextavgvar", createAvgVar, "source", createOutput<QPair<double, double> >,
+      { { "accelerometernorm", "sink" }, { NULL, NULL } } },
+    { "contextavgvarwelford", createAvgVarWelford, "source", createOutput<QPair<double, double> >,
+      { { "accelerometernorm", "sink" }, { NULL, NULL } } },
+    { "contextcutter", createCutter, "source", createOutput<double>,
+      { { "accelerometernorm", "sink" }, { NULL, NULL } } }
+};
+
+static const int CASE_COUNT = sizeof(CASES) / sizeof(CASES[0]);
+
+/**
+ * Filter of a case joined to the feeds of its traces and an output.
+ */
+class GoldenGraph
+{
+public:
+    /**
+     * Run of consecutive samples of one feed, pushed together.
+     */
+    struct Run
+    {
+        int feed;  /**< index of the feed */
+        int first; /**< first sample */
+        int count; /**< number of samples */
+    };
+
+    GoldenGraph(const GoldenCase& goldenCase) :
+        filter_(goldenCase.create()),
+        output_(goldenCase.createOutput()),
+        valid_(true)
+    {
+        bin_.add(filter_, "filter");
+        bin_.add(output_, "output");
+        valid_ = bin_.join("filter", goldenCase.source, "output", "sink");
+        for (int i = 0; goldenCase.inputs[i].trace; ++i) {
+            TraceFeed* feed = createFeed(goldenCase.inputs[i].trace);
+            QString name = QString("input%1").arg(i);
+            feeds_ << feed;
+            bin_.add(feed, name);
+            valid_ = valid_ && bin_.join(name, "source", "filter", goldenCase.inputs[i].sink);
+        }
+        bin_.start();
+    }
+
+    ~GoldenGraph()
+    {
+        bin_.stop();
+        qDeleteAll(feeds_);
+        delete output_;
+        delete filter_;
+    }
+
+    /**
+     * Were all nodes joined.
+     */
+    bool isValid() const { return valid_; }
+
+    /**
+     * Split the traces into runs in timestamp order. Samples of
+     * different feeds with equal timestamps go in the order of the
+     * inputs.
+     *
+     * @param batch maximum samples in a run.
+     * @return runs covering all samples.
+     */
+    QVector<Run> runs(int batch) const
+    {
+        QVector<Run> runs;
+        QVector<int> next(feeds_.size(), 0);
+        forever {
+            int feed = -1;
+            for (int i = 0; i < feeds_.size(); ++i) {
+                if (next[i] < feeds_[i]->size() &&
+                    (feed == -1 || feeds_[i]->timestamp(next[i]) < feeds_[feed]->timestamp(next[feed])))
+                    feed = i;
+            }
+            if (feed == -1)
+                return runs;
+            if (!runs.isEmpty() && runs.last().feed == feed && runs.last().count < batch) {
+                ++runs.last().count;
+            } else {
+                Run run = { feed, next[feed], 1 };
+                runs << run;
+            }
+            ++next[feed];
+        }
+    }
+
+    /**
+     * Push the runs through the filter.
+     *
+     * @param runs runs from #runs().
+     */
+    void push(const QVector<Run>& runs)
+    {
+        foreach (const Run& run, runs)
+            feeds_[run.feed]->push(run.first, run.count);
+    }
+
+    /**
+     * Number of input samples.
+     */
+    int inputSamples() const
+    {
+        int samples = 0;
+        foreach (const TraceFeed* feed, feeds_)
+            samples += feed->size();
+        return samples;
+    }
+
+    const TraceOutput& output() const { return *output_; }
+
+private:
+    Bin               bin_;
+    FilterBase*       filter_;
+    TraceOutput*      output_;
+    QList<TraceFeed*> feeds_;
+    bool              valid_;
+};
+
+void FilterBenchmark::initTestCase()
+{
+    Config::loadConfig(goldenDir() + "/golden.conf", "");
+    SensordLogger::init(1, "/tmp/test.log", "FilterBenchmark");
+    // Trace output would dominate the measurements.
+    SensordLogger::setOutputLevel(SensordLogWarning);
+    if (recordMode())
+        QVERIFY(QDir().mkpath(goldenDir()));
+}
+
+void FilterBenchmark::testGolden_data()
+{
+    QTest::addColumn<int>("index");
+    for (int i = 0; i < CASE_COUNT; ++i)
+        QTest::newRow(CASES[i].name) << i;
+}
+
+void FilterBenchmark::testGolden()
+{
+    QFETCH(int, index);
+    const GoldenCase& goldenCase = CASES[index];
+
+    GoldenGraph single(goldenCase);
+    QVERIFY(single.isValid());
+    single.push(single.runs(1));
+    QVERIFY(single.output().count() > 0);
+
+    GoldenGraph batch(goldenCase);
+    batch.push(batch.runs(BATCH));
+    QString difference = single.output().compare(batch.output());
+    QVERIFY2(difference.isEmpty(), qPrintable("batch mode: " + difference));
+
+    QString path = goldenDir() + "/" + goldenCase.name + ".golden";
+    if (recordMode()) {
+        QVERIFY(single.output().save(path));
+        return;
+    }
+    if (!QFile::exists(path)) {
+        QWARN(qPrintable("No golden output " + path + ", record it with SENSORFW_GOLDEN_RECORD=1"));
+        return;
+    }
+    difference = single.output().compareFile(path);
+    QVERIFY2(difference.isEmpty(), qPrintable(difference));
+}
+
+void FilterBenchmark::benchmarkTrace_data()
+{
+    QTest::addColumn<int>("index");
+    QTest::addColumn<int>("batch");
+    for (int i = 0; i < CASE_COUNT; ++i) {
+        QTest::newRow(qPrintable(QString(CASES[i].name) + " single")) << i << 1;
+        QTest::newRow(qPrintable(QString(CASES[i].name) + " batch")) << i << (int)BATCH;
+    }
+}
+
+void FilterBenchmark::benchmarkTrace()
+{
+    QFETCH(int, index);
+    QFETCH(int, batch);
+
+    // Each pass needs a fresh filter, as the traces cannot be replayed
+    // into one that has seen their later timestamps.
+    const qint64 MIN_NSECS = 200000000;
+    qint64 nsecs = 0;
+    qint64 samples = 0;
+    while (nsecs < MIN_NSECS) {
+        GoldenGraph graph(CASES[index]);
+        QVector<GoldenGraph::Run> runs = graph.runs(batch);
+        QElapsedTimer timer;
+        timer.start();
+        graph.push(runs);
+        nsecs += timer.nsecsElapsed();
+        samples += graph.inputSamples();
+    }
+    qDebug("%s %s: %.1f ns/sample", CASES[index].name, batch == 1 ? "single" : "batch",
+           (double)nsecs / samples);
+}
+
+QTEST_MAIN(FilterBenchmark)
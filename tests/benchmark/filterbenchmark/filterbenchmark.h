@@ -0,0 +1,349 @@
+/**
+   @file filterbenchmark.h
+   @brief Golden trace benchmarks of the filters
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+*/
+
+#ifndef FILTERBENCHMARK_H
+#define FILTERBENCHMARK_H
+
+#include <QTest>
+#include <QVector>
+#include <QString>
+#include <QFile>
+#include <qmath.h>
+#include "pusher.h"
+#include "consumer.h"
+#include "source.h"
+#include "sink.h"
+#include "samplerecording.h"
+#include "samplerecorder.h"
+#include "genericdata.h"
+#include "orientationdata.h"
+#include "posedata.h"
+#include "timedunsigned.h"
+#include "quaterniondata.h"
+
+/**
+ * Input of a filter under test: a trace fed into one sink of the
+ * filter.
+ */
+class TraceFeed : public Pusher
+{
+public:
+    virtual ~TraceFeed() {}
+
+    /**
+     * Number of samples in the trace.
+     *
+     * @return sample count.
+     */
+    virtual int size() const = 0;
+
+    /**
+     * Timestamp of a sample, used to interleave the traces of a filter
+     * with several inputs.
+     *
+     * @param i sample index.
+     * @return timestamp in microseconds.
+     */
+    virtual quint64 timestamp(int i) const = 0;
+
+    /**
+     * Propagate a run of samples to the filter.
+     *
+     * @param first index of the first sample.
+     * @param count number of samples.
+     */
+    virtual void push(int first, int count) = 0;
+
+    void pushNewData() {}
+};
+
+/**
+ * Feed of a trace of a given sample type.
+ */
+template <class TYPE>
+class TypedTraceFeed : public TraceFeed
+{
+public:
+    TypedTraceFeed(const QVector<TYPE>& trace) :
+        trace_(trace)
+    {
+        addSource(&source_, "source");
+    }
+
+    int size() const { return trace_.size(); }
+    quint64 timestamp(int i) const { return trace_.at(i).timestamp_; }
+    void push(int first, int count) { source_.propagate(count, trace_.constData() + first); }
+
+private:
+    QVector<TYPE> trace_;
+    Source<TYPE>  source_;
+};
+
+/**
+ * Values without a timestamp, like the magnitudes passed between the
+ * context filters, are fed in their original order.
+ */
+template <>
+inline quint64 TypedTraceFeed<double>::timestamp(int i) const { return i; }
+
+/**
+ * Output of a filter under test, kept for comparison against another
+ * run and the golden output.
+ */
+class TraceOutput : public Consumer
+{
+public:
+    virtual ~TraceOutput() {}
+
+    /**
+     * Number of samples received.
+     *
+     * @return sample count.
+     */
+    virtual int count() const = 0;
+
+    /**
+     * Compare received samples with the output of another run.
+     *
+     * @param other output of the same type.
+     * @return description of the first difference, empty if equivalent.
+     */
+    virtual QString compare(const TraceOutput& other) const = 0;
+
+    /**
+     * Compare received samples with a golden output file.
+     *
+     * @param path golden output.
+     * @return description of the first difference, empty if equivalent.
+     */
+    virtual QString compareFile(const QString& path) const = 0;
+
+    /**
+     * Store received samples as the golden output.
+     *
+     * @param path golden output.
+     * @return was the file written.
+     */
+    virtual bool save(const QString& path) const = 0;
+};
+
+/**
+ * Read a trace or golden output stored as a sample recording.
+ *
+ * @param path recording.
+ * @param samples set to the samples of the recording.
+ * @return was the recording of the expected type.
+ */
+template <class TYPE>
+bool loadRecording(const QString& path, QVector<TYPE>& samples)
+{
+    QFile file(path);
+    SampleRecordingHeader header;
+    if (!file.open(QIODevice::ReadOnly) ||
+        file.read((char*)&header, sizeof(header)) != sizeof(header) ||
+        header.magic != SAMPLE_RECORDING_MAGIC ||
+        header.version != SAMPLE_RECORDING_VERSION ||
+        header.type != SampleRecordingType<TYPE>::TYPE_ID ||
+        header.sampleSize != sizeof(TYPE))
+        return false;
+    samples.resize(header.count);
+    qint64 bytes = (qint64)header.count * sizeof(TYPE);
+    return file.read((char*)samples.data(), bytes) == bytes;
+}
+
+/**
+ * Store samples as a sample recording, replacing an existing file.
+ * Types without a SampleRecordingType are stored with
+ * RecordingUnknown.
+ *
+ * @param path recording.
+ * @param samples samples to store.
+ * @param interval nominal interval in microseconds, 0 if unknown.
+ * @return was the recording written.
+ */
+template <class TYPE>
+bool saveRecording(const QString& path, const QVector<TYPE>& samples, quint32 interval)
+{
+    QFile::remove(path);
+    SampleRecorder recorder;
+    if (!recorder.open(path, SampleRecordingType<TYPE>::TYPE_ID, sizeof(TYPE), interval))
+        return false;
+    if (!samples.isEmpty() && !recorder.append(samples.constData(), samples.size()))
+        return false;
+    recorder.close();
+    return true;
+}
+
+/**
+ * Floating point values match if they differ by rounding only, so
+ * that vectorized and reordered arithmetic passes. Integer values and
+ * timestamps must match exactly.
+ */
+inline bool sameValue(double a, double b)
+{
+    return qAbs(a - b) <= 1e-4 * qMax(1.0, qAbs(a));
+}
+
+inline bool sameSample(const TimedXyzData& a, const TimedXyzData& b)
+{
+    return a.timestamp_ == b.timestamp_ && a.x_ == b.x_ && a.y_ == b.y_ && a.z_ == b.z_;
+}
+
+inline bool sameSample(const TimedXyzFloatData& a, const TimedXyzFloatData& b)
+{
+    return a.timestamp_ == b.timestamp_ && sameValue(a.x_, b.x_) && sameValue(a.y_, b.y_) && sameValue(a.z_, b.z_);
+}
+
+inline bool sameSample(const CalibratedMagneticFieldData& a, const CalibratedMagneticFieldData& b)
+{
+    return a.timestamp_ == b.timestamp_ && a.x_ == b.x_ && a.y_ == b.y_ && a.z_ == b.z_ &&
+           a.rx_ == b.rx_ && a.ry_ == b.ry_ && a.rz_ == b.rz_ && a.level_ == b.level_;
+}
+
+inline bool sameSample(const CompassData& a, const CompassData& b)
+{
+    return a.timestamp_ == b.timestamp_ && a.degrees_ == b.degrees_ && a.rawDegrees_ == b.rawDegrees_ &&
+           a.correctedDegrees_ == b.correctedDegrees_ && a.level_ == b.level_;
+}
+
+inline bool sameSample(const PoseData& a, const PoseData& b)
+{
+    return a.timestamp_ == b.timestamp_ && a.orientation_ == b.orientation_;
+}
+
+inline bool sameSample(const TimedUnsigned& a, const TimedUnsigned& b)
+{
+    return a.timestamp_ == b.timestamp_ && a.value_ == b.value_;
+}
+
+inline bool sameSample(const TimedQuaternionData& a, const TimedQuaternionData& b)
+{
+    return a.timestamp_ == b.timestamp_ && sameValue(a.w_, b.w_) && sameValue(a.x_, b.x_) &&
+           sameValue(a.y_, b.y_) && sameValue(a.z_, b.z_);
+}
+
+inline bool sameSample(double a, double b)
+{
+    return sameValue(a, b);
+}
+
+inline bool sameSample(const QPair<double, double>& a, const QPair<double, double>& b)
+{
+    return sameValue(a.first, b.first) && sameValue(a.second, b.second);
+}
+
+/**
+ * Output collecting the samples of a given type.
+ */
+template <class TYPE>
+class TypedTraceOutput : public TraceOutput
+{
+public:
+    TypedTraceOutput() :
+        sink_(this, &TypedTraceOutput::collect)
+    {
+        addSink(&sink_, "sink");
+    }
+
+    int count() const { return samples_.size(); }
+
+    QString compare(const TraceOutput& other) const
+    {
+        return compareSamples(static_cast<const TypedTraceOutput&>(other).samples_);
+    }
+
+    QString compareFile(const QString& path) const
+    {
+        QVector<TYPE> golden;
+        if (!loadRecording(path, golden))
+            return QString("%1 is not a recording of the output type").arg(path);
+        return compareSamples(golden);
+    }
+
+    bool save(const QString& path) const
+    {
+        return saveRecording(path, samples_, 0);
+    }
+
+private:
+    QString compareSamples(const QVector<TYPE>& expected) const
+    {
+        int n = qMin(expected.size(), samples_.size());
+        for (int i = 0; i < n; ++i) {
+            if (!sameSample(expected.at(i), samples_.at(i)))
+                return QString("output %1 of %2 differs").arg(i).arg(expected.size());
+        }
+        if (expected.size() != samples_.size())
+            return QString("%1 outputs instead of %2").arg(samples_.size()).arg(expected.size());
+        return QString();
+    }
+
+    void collect(unsigned n, const TYPE* values)
+    {
+        for (unsigned i = 0; i < n; ++i)
+            samples_.append(values[i]);
+    }
+
+    Sink<TypedTraceOutput, TYPE> sink_;
+    QVector<TYPE>                samples_;
+};
+
+/**
+ * Runs every filter of filters/, the chains and the computational
+ * filters of the context plugin over golden traces. The heading,
+ * screen and stability filters of the context plugin only publish
+ * context properties and are left out.
+ *
+ * Each case is run with single samples and with batches of up to
+ * #BATCH samples per input. Both runs must produce equivalent outputs,
+ * which must also match the golden output of the case,
+ * <tt>&lt;case&gt;.golden</tt> in the golden directory. The
+ * benchmarks report nanoseconds per input sample in both modes.
+ *
+ * Traces are synthesized deterministically unless a recording
+ * <tt>&lt;trace&gt;.input</tt> of the same type is in the golden
+ * directory, for example one captured with the StartRecording DBus
+ * call. With SENSORFW_GOLDEN_RECORD set, traces and outputs of the
+ * current build are stored in the golden directory instead of being
+ * checked; do that with a build known to be correct before changing a
+ * filter. SENSORFW_GOLDEN_DIR overrides the golden directory. Filter
+ * settings are read from <tt>golden.conf</tt> in it.
+ */
+class FilterBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int BATCH = 32; /**< batch size of the batch mode */
+
+private slots:
+    void initTestCase();
+
+    void testGolden_data();
+    void testGolden();
+
+    void benchmarkTrace_data();
+    void benchmarkTrace();
+};
+
+#endif // FILTERBENCHMARK_H
@@ -0,0 +1,75 @@
+QT += dbus network
+
+include(../../common-install.pri)
+
+TEMPLATE = app
+TARGET = sensorfilterbenchmark-test
+
+CONFIG += testcase link_pkgconfig
+
+PKGCONFIG += gconf-2.0 gobject-2.0
+
+HEADERS += filterbenchmark.h \
+    ../../../filters/coordinatealignfilter/coordinatealignfilter.h \
+    ../../../filters/avgaccfilter/avgaccfilter.h \
+    ../../../filters/downsamplefilter/downsamplefilter.h \
+    ../../../filters/orientationinterpreter/orientationinterpreter.h \
+    ../../../filters/declinationfilter/declinationfilter.h \
+    ../../../filters/rotationfilter/rotationfilter.h \
+    ../../../chains/accelerometerchain/accelerometerchainfilter.h \
+    ../../../chains/accelerometerchain/accelerometerfloatfilter.h \
+    ../../../chains/compasschain/compassfilter.h \
+    ../../../chains/compasschain/headingsmoothfilter.h \
+    ../../../chains/fusionchain/fusionfilter.h \
+    ../../../chains/gyroscopechain/gyroscopebiasfilter.h \
+    ../../../chains/magcalibrationchain/calibrationfilter.h \
+    ../../../chains/stepcounterchain/stepdetectorfilter.h \
+    ../../../sensors/contextplugin/normalizerfilter.h \
+    ../../../sensors/contextplugin/avgvarfilter.h \
+    ../../../sensors/contextplugin/cutterfilter.h
+
+SOURCES += filterbenchmark.cpp \
+    ../../../filters/coordinatealignfilter/coordinatealignfilter.cpp \
+    ../../../filters/avgaccfilter/avgaccfilter.cpp \
+    ../../../filters/downsamplefilter/downsamplefilter.cpp \
+    ../../../filters/orientationinterpreter/orientationinterpreter.cpp \
+    ../../../filters/declinationfilter/declinationfilter.cpp \
+    ../../../filters/rotationfilter/rotationfilter.cpp \
+    ../../../chains/accelerometerchain/accelerometerchainfilter.cpp \
+    ../../../chains/accelerometerchain/accelerometerfloatfilter.cpp \
+    ../../../chains/compasschain/compassfilter.cpp \
+    ../../../chains/compasschain/headingsmoothfilter.cpp \
+    ../../../chains/fusionchain/fusionfilter.cpp \
+    ../../../chains/gyroscopechain/gyroscopebiasfilter.cpp \
+    ../../../chains/magcalibrationchain/calibrationfilter.cpp \
+    ../../../chains/stepcounterchain/stepdetectorfilter.cpp \
+    ../../../sensors/contextplugin/normalizerfilter.cpp \
+    ../../../sensors/contextplugin/avgvarfilter.cpp \
+    ../../../sensors/contextplugin/cutterfilter.cpp
+
+INCLUDEPATH += ../../../include \
+    ../../.. \
+    ../../../filters/coordinatealignfilter \
+    ../../../filters/avgaccfilter \
+    ../../../filters/downsamplefilter \
+    ../../../filters/orientationinterpreter \
+    ../../../filters/declinationfilter \
+    ../../../filters/rotationfilter \
+    ../../../chains/accelerometerchain \
+    ../../../chains/compasschain \
+    ../../../chains/fusionchain \
+    ../../../chains/gyroscopechain \
+    ../../../chains/magcalibrationchain \
+    ../../../chains/stepcounterchain \
+    ../../../sensors/contextplugin \
+    ../../../core \
+    ../../../datatypes
+
+QMAKE_LIBDIR_FLAGS += -L../../../datatypes
+QMAKE_LIBDIR_FLAGS += -L../../../builddir/core -L../../../core/
+
+golden.path = /usr/share/sensorfw-tests/golden
+golden.files = golden/*
+INSTALLS += golden
+
+include(../../../common.pri)
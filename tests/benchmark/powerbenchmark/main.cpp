@@ -0,0 +1,40 @@
+/**
+   @file main.cpp
+   @brief Wakeup and power benchmark for sensord
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+*/
+
+#include <QCoreApplication>
+#include <QDebug>
+#include "powerbenchmark.h"
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    PowerBenchmark benchmark;
+
+    if (!benchmark.parse(app.arguments())) {
+        qWarning() << "Usage: sensorpowerbenchmark [--sensor=ID] [--duration=SECONDS]"
+                   << "[--scenarios=NAME,...] [--output=FILE]";
+        qWarning() << "Scenarios:" << PowerBenchmark::scenarioNames().join(",");
+        return 2;
+    }
+    return benchmark.run() ? 0 : 1;
+}
@@ -0,0 +1,443 @@
+/**
+   @file powerbenchmark.cpp
+   @brief Wakeup and power benchmark for sensord
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+*/
+
+#include "powerbenchmark.h"
+#include <QDir>
+#include <QFile>
+#include <QProcess>
+#include <QTextStream>
+#include <QTime>
+#include <QTimer>
+#include <QEventLoop>
+#include <QDBusMessage>
+#include <QDebug>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+
+/**
+ * Time given to sensord to settle after a session or display change,
+ * in milliseconds.
+ */
+static const int SETTLE_TIME = 1000;
+
+/**
+ * Names on the system bus used by MceWatcher, see mce/dbus-names.h.
+ */
+static const char* const MCE_SERVICE_NAME = "com.nokia.mce";
+static const char* const MCE_SIGNAL_PATH_NAME = "/com/nokia/mce/signal";
+static const char* const MCE_SIGNAL_INTERFACE = "com.nokia.mce.signal";
+static const char* const MCE_DISPLAY_SIGNAL = "display_status_ind";
+
+/**
+ * Run the event loop for given time.
+ *
+ * @param msecs time in milliseconds.
+ */
+static void wait(int msecs)
+{
+    QEventLoop loop;
+    QTimer::singleShot(msecs, &loop, SLOT(quit()));
+    loop.exec();
+}
+
+/**
+ * Open a perf counter for a thread.
+ *
+ * @param tid thread ID.
+ * @param type event type.
+ * @param config event.
+ * @return counter descriptor or -1.
+ */
+static int openPerfCounter(int tid, unsigned int type, unsigned long long config)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    return syscall(__NR_perf_event_open, &attr, tid, -1, -1, 0);
+}
+
+/**
+ * Get tracepoint ID of hrtimer_start.
+ *
+ * @return tracepoint ID or -1 if tracefs is not available.
+ */
+static long long hrtimerStartId()
+{
+    static const char* const paths[] = {
+        "/sys/kernel/tracing/events/timer/hrtimer_start/id",
+        "/sys/kernel/debug/tracing/events/timer/hrtimer_start/id"
+    };
+    for (unsigned int i = 0; i < sizeof(paths) / sizeof(paths[0]); ++i) {
+        QFile file(paths[i]);
+        if (file.open(QIODevice::ReadOnly))
+            return file.readAll().trimmed().toLongLong();
+    }
+    return -1;
+}
+
+PerfCounters::PerfCounters()
+{
+}
+
+PerfCounters::~PerfCounters()
+{
+    close();
+}
+
+bool PerfCounters::open(int pid)
+{
+    close();
+    long long timerId = hrtimerStartId();
+    QStringList threads = QDir(QString("/proc/%1/task").arg(pid)).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    foreach (const QString& thread, threads) {
+        int fd = openPerfCounter(thread.toInt(), PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES);
+        if (fd != -1)
+            switchFds_ << fd;
+        if (timerId >= 0) {
+            fd = openPerfCounter(thread.toInt(), PERF_TYPE_TRACEPOINT, timerId);
+            if (fd != -1)
+                timerFds_ << fd;
+        }
+    }
+    return !switchFds_.isEmpty();
+}
+
+void PerfCounters::close()
+{
+    foreach (int fd, switchFds_)
+        ::close(fd);
+    foreach (int fd, timerFds_)
+        ::close(fd);
+    switchFds_.clear();
+    timerFds_.clear();
+}
+
+long long PerfCounters::sum(const QList<int>& fds)
+{
+    if (fds.isEmpty())
+        return -1;
+    long long total = 0;
+    foreach (int fd, fds) {
+        unsigned long long count = 0;
+        if (::read(fd, &count, sizeof(count)) == sizeof(count))
+            total += count;
+    }
+    return total;
+}
+
+void PerfCounters::read(ProcessCounters& counters) const
+{
+    counters.perfSwitches = sum(switchFds_);
+    counters.perfTimers = sum(timerFds_);
+}
+
+PowerBenchmark::PowerBenchmark(QObject* parent) :
+    QObject(parent),
+    sensor_("accelerometersensor"),
+    duration_(10),
+    pid_(0),
+    stubMce_(false),
+    bus_(QDBusConnection::systemBus())
+{
+    scenarios_ = builtinScenarios();
+}
+
+PowerBenchmark::~PowerBenchmark()
+{
+    if (pid_)
+        setDisplay(true);
+    if (stubMce_)
+        bus_.unregisterService(MCE_SERVICE_NAME);
+}
+
+QList<PowerScenario> PowerBenchmark::builtinScenarios()
+{
+    static const struct { const char* name; bool client; bool display; unsigned int bufferSize; unsigned int bufferInterval; bool standbyOverride; } table[] = {
+        { "idle",                           false, true,  1,  0,    false },
+        { "display_off_idle",               false, false, 1,  0,    false },
+        { "display_on",                     true,  true,  1,  0,    false },
+        { "display_on_buffered",            true,  true,  32, 1000, false },
+        { "display_off",                    true,  false, 1,  0,    false },
+        { "display_off_override",           true,  false, 1,  0,    true  },
+        { "display_off_override_buffered",  true,  false, 32, 1000, true  }
+    };
+
+    QList<PowerScenario> scenarios;
+    for (unsigned int i = 0; i < sizeof(table) / sizeof(table[0]); ++i) {
+        PowerScenario scenario;
+        scenario.name = table[i].name;
+        scenario.client = table[i].client;
+        scenario.display = table[i].display;
+        scenario.bufferSize = table[i].bufferSize;
+        scenario.bufferInterval = table[i].bufferInterval;
+        scenario.standbyOverride = table[i].standbyOverride;
+        scenarios << scenario;
+    }
+    return scenarios;
+}
+
+QStringList PowerBenchmark::scenarioNames()
+{
+    QStringList names;
+    foreach (const PowerScenario& scenario, builtinScenarios())
+        names << scenario.name;
+    return names;
+}
+
+bool PowerBenchmark::parse(const QStringList& arguments)
+{
+    for (int i = 1; i < arguments.size(); ++i) {
+        QString name = arguments.at(i).section('=', 0, 0);
+        QString value = arguments.at(i).section('=', 1);
+        if (name == "--sensor") {
+            sensor_ = value;
+        } else if (name == "--duration") {
+            duration_ = value.toInt();
+        } else if (name == "--output") {
+            output_ = value;
+        } else if (name == "--scenarios") {
+            QList<PowerScenario> all = builtinScenarios();
+            scenarios_.clear();
+            foreach (const QString& wanted, value.split(',', QString::SkipEmptyParts)) {
+                int found = -1;
+                for (int j = 0; j < all.size() && found < 0; ++j) {
+                    if (all.at(j).name == wanted)
+                        found = j;
+                }
+                if (found < 0)
+                    return false;
+                scenarios_ << all.at(found);
+            }
+        } else {
+            return false;
+        }
+    }
+    return duration_ > 0 && !sensor_.isEmpty() && !scenarios_.isEmpty();
+}
+
+bool PowerBenchmark::findSensord()
+{
+    QProcess process;
+    process.start("pidof sensord");
+    process.waitForFinished(1000);
+    pid_ = atoi(process.readAllStandardOutput().constData());
+    return pid_ > 0;
+}
+
+void PowerBenchmark::setDisplay(bool on)
+{
+    if (stubMce_) {
+        QDBusMessage signal = QDBusMessage::createSignal(MCE_SIGNAL_PATH_NAME, MCE_SIGNAL_INTERFACE, MCE_DISPLAY_SIGNAL);
+        signal << QString(on ? "on" : "off");
+        bus_.send(signal);
+    } else {
+        QProcess::execute(on ? "mcetool --unblank-screen" : "mcetool --blank-screen");
+    }
+}
+
+ProcessCounters PowerBenchmark::counters(int pid)
+{
+    ProcessCounters result;
+    if (pid <= 0)
+        return result;
+
+    QFile stat(QString("/proc/%1/stat").arg(pid));
+    if (stat.open(QIODevice::ReadOnly)) {
+        // Process name may contain spaces, fields are counted after it.
+        QByteArray line = stat.readAll();
+        QList<QByteArray> fields = line.mid(line.lastIndexOf(')') + 2).split(' ');
+        if (fields.size() >= 13) {
+            unsigned long long ticks = fields.at(11).toULongLong() + fields.at(12).toULongLong();
+            result.cpuUs = ticks * 1000000 / sysconf(_SC_CLK_TCK);
+        }
+    }
+
+    // Process status shows the switches of the main thread only.
+    QString taskDir = QString("/proc/%1/task").arg(pid);
+    foreach (const QString& thread, QDir(taskDir).entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        QFile status(taskDir + "/" + thread + "/status");
+        if (!status.open(QIODevice::ReadOnly))
+            continue;
+        QByteArray line = status.readLine();
+        while (!line.isEmpty()) {
+            if (line.startsWith("voluntary_ctxt_switches:"))
+                result.voluntary += line.section(':', 1).trimmed().toULongLong();
+            else if (line.startsWith("nonvoluntary_ctxt_switches:"))
+                result.involuntary += line.section(':', 1).trimmed().toULongLong();
+            line = status.readLine();
+        }
+    }
+    return result;
+}
+
+/**
+ * Format counters of a process over the measurement window.
+ *
+ * @param start counters at the start of the window.
+ * @param end counters at the end of the window, perf counts included.
+ * @param seconds length of the window.
+ * @return JSON object.
+ */
+static QString countersJson(const ProcessCounters& start, const ProcessCounters& end, double seconds)
+{
+    unsigned long long wakeups = end.voluntary - start.voluntary;
+    QString result;
+    QTextStream out(&result);
+    out << "{ \"cpu_us\": " << (end.cpuUs - start.cpuUs)
+        << ", \"wakeups\": " << wakeups
+        << ", \"wakeups_per_s\": " << (seconds > 0 ? wakeups / seconds : 0)
+        << ", \"involuntary_switches\": " << (end.involuntary - start.involuntary);
+    if (end.perfSwitches >= 0)
+        out << ", \"perf_context_switches\": " << end.perfSwitches;
+    if (end.perfTimers >= 0)
+        out << ", \"perf_timers_armed\": " << end.perfTimers
+            << ", \"perf_timers_armed_per_s\": " << (seconds > 0 ? end.perfTimers / seconds : 0);
+    out << " }";
+    out.flush();
+    return result;
+}
+
+bool PowerBenchmark::runScenario(const PowerScenario& scenario, QString& result)
+{
+    // Sessions are set up with the display on, as clients usually are.
+    setDisplay(true);
+    wait(SETTLE_TIME);
+
+    QProcess client;
+    int clientPid = 0;
+    if (scenario.client) {
+        QStringList arguments;
+        arguments << "--sensor=" + sensor_
+                  << QString("--buffersize=%1").arg(scenario.bufferSize)
+                  << QString("--bufferinterval=%1").arg(scenario.bufferInterval)
+                  << QString("--duration=%1").arg(duration_ * 1000 + 3 * SETTLE_TIME);
+        if (scenario.standbyOverride)
+            arguments << "--standbyoverride";
+        client.start("sensordummyclient", arguments);
+        if (!client.waitForStarted()) {
+            qWarning() << "Failed to start sensordummyclient";
+            return false;
+        }
+        clientPid = client.pid();
+        wait(SETTLE_TIME);
+    }
+
+    setDisplay(scenario.display);
+    wait(SETTLE_TIME);
+
+    PerfCounters sensordPerf;
+    PerfCounters clientPerf;
+    sensordPerf.open(pid_);
+    if (clientPid)
+        clientPerf.open(clientPid);
+    ProcessCounters sensordStart = counters(pid_);
+    ProcessCounters clientStart = counters(clientPid);
+    QTime timer;
+    timer.start();
+
+    wait(duration_ * 1000);
+
+    ProcessCounters sensordEnd = counters(pid_);
+    ProcessCounters clientEnd = counters(clientPid);
+    sensordPerf.read(sensordEnd);
+    clientPerf.read(clientEnd);
+    double seconds = timer.elapsed() / 1000.0;
+
+    QString received = "null";
+    if (scenario.client) {
+        client.waitForFinished(2 * SETTLE_TIME + 10000);
+        QString line = QString::fromLocal8Bit(client.readAllStandardOutput()).trimmed();
+        foreach (const QString& pair, line.split(' ', QString::SkipEmptyParts)) {
+            if (pair.section('=', 0, 0) == "received")
+                received = pair.section('=', 1);
+        }
+    }
+
+    QTextStream out(&result);
+    out << "    {\n"
+        << "      \"name\": \"" << scenario.name << "\",\n"
+        << "      \"display\": " << (scenario.display ? "true" : "false") << ",\n"
+        << "      \"buffer_size\": " << scenario.bufferSize << ",\n"
+        << "      \"buffer_interval_ms\": " << scenario.bufferInterval << ",\n"
+        << "      \"standby_override\": " << (scenario.standbyOverride ? "true" : "false") << ",\n"
+        << "      \"duration_s\": " << seconds << ",\n"
+        << "      \"session_samples_received\": " << received << ",\n"
+        << "      \"sensord\": " << countersJson(sensordStart, sensordEnd, seconds) << ",\n"
+        << "      \"client\": " << (clientPid ? countersJson(clientStart, clientEnd, seconds) : QString("null")) << "\n"
+        << "    }";
+    out.flush();
+    return true;
+}
+
+bool PowerBenchmark::run()
+{
+    if (!findSensord()) {
+        qWarning() << "sensord is not running";
+        return false;
+    }
+
+    // Act as MCE unless the real one is running.
+    stubMce_ = bus_.isConnected() && bus_.registerService(MCE_SERVICE_NAME);
+    if (!stubMce_)
+        qWarning() << "MCE service is taken, changing display state with mcetool";
+
+    QStringList results;
+    bool ok = true;
+    foreach (const PowerScenario& scenario, scenarios_) {
+        QString result;
+        if (runScenario(scenario, result)) {
+            results << result;
+        } else {
+            qWarning() << "Scenario" << scenario.name << "failed";
+            ok = false;
+        }
+    }
+    setDisplay(true);
+
+    QString json;
+    QTextStream out(&json);
+    out << "{\n"
+        << "  \"sensor\": \"" << sensor_ << "\",\n"
+        << "  \"stub_mce\": " << (stubMce_ ? "true" : "false") << ",\n"
+        << "  \"scenarios\": [\n" << results.join(",\n") << "\n  ]\n"
+        << "}\n";
+    out.flush();
+
+    if (output_.isEmpty()) {
+        QTextStream(stdout) << json;
+    } else {
+        QFile file(output_);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qWarning() << "Failed to write" << output_;
+            return false;
+        }
+        file.write(json.toUtf8());
+    }
+    return ok;
+}
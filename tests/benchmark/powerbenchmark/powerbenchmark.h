@@ -0,0 +1,170 @@
+/**
+   @file powerbenchmark.h
+   @brief Wakeup and power benchmark for sensord
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+*/
+
+#ifndef POWERBENCHMARK_H
+#define POWERBENCHMARK_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QDBusConnection>
+
+/**
+ * Scripted session scenario.
+ */
+struct PowerScenario
+{
+    QString      name;            /**< scenario name */
+    bool         client;          /**< is a session open */
+    bool         display;         /**< is the display on while measuring */
+    unsigned int bufferSize;      /**< session buffer size */
+    unsigned int bufferInterval;  /**< session buffer interval in milliseconds */
+    bool         standbyOverride; /**< does the session override standby */
+};
+
+/**
+ * Energy relevant counters of one process.
+ */
+struct ProcessCounters
+{
+    ProcessCounters() :
+        cpuUs(0), voluntary(0), involuntary(0), perfSwitches(-1), perfTimers(-1) {}
+
+    unsigned long long cpuUs;        /**< user and system CPU time */
+    unsigned long long voluntary;    /**< voluntary context switches, i.e. wakeups */
+    unsigned long long involuntary;  /**< involuntary context switches */
+    long long          perfSwitches; /**< context switches counted by perf, -1 if unavailable */
+    long long          perfTimers;   /**< hrtimers armed counted by perf, -1 if unavailable */
+};
+
+/**
+ * Per thread perf counters of a process. Counts context switches and
+ * the hrtimer_start tracepoint. Every poll timeout, Qt timer and
+ * timerfd of the process arms an hrtimer, so the latter tracks the
+ * timer driven wakeups. Needs perf_event_paranoid to allow it, or root.
+ * Threads started after #open() are not counted.
+ */
+class PerfCounters
+{
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    /**
+     * Start counting.
+     *
+     * @param pid process ID.
+     * @return were the counters opened for any thread.
+     */
+    bool open(int pid);
+
+    /**
+     * Stop counting.
+     */
+    void close();
+
+    /**
+     * Add the current counts to given counters. Counters unavailable
+     * are left at -1.
+     *
+     * @param counters counters to update.
+     */
+    void read(ProcessCounters& counters) const;
+
+private:
+    static long long sum(const QList<int>& fds);
+
+    QList<int> switchFds_; /**< context switch counters, one per thread */
+    QList<int> timerFds_;  /**< hrtimer_start counters, one per thread */
+};
+
+/**
+ * Runs scripted session scenarios against sensord and counts the
+ * wakeups, context switches, timers and CPU time of sensord and of the
+ * client during each of them. Display state is changed by acting as a
+ * stub MCE on the system bus, so that the MceWatcher of sensord sees
+ * display_status_ind signals; when the real MCE is running mcetool is
+ * used instead. Results are written as JSON:
+ *
+ * <pre>
+ * sensorpowerbenchmark --sensor=accelerometersensor --duration=10
+ *     --scenarios=idle,display_on,display_on_buffered,display_off,display_off_override
+ *     --output=result.json
+ * </pre>
+ */
+class PowerBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * Constructor.
+     *
+     * @param parent parent object.
+     */
+    PowerBenchmark(QObject* parent = 0);
+
+    /**
+     * Destructor. Turns the display back on.
+     */
+    ~PowerBenchmark();
+
+    /**
+     * Parse command line options.
+     *
+     * @param arguments command line arguments.
+     * @return were the options valid.
+     */
+    bool parse(const QStringList& arguments);
+
+    /**
+     * Run the scenarios and write the results.
+     *
+     * @return did all scenarios run.
+     */
+    bool run();
+
+    /**
+     * Names of the built in scenarios.
+     *
+     * @return scenario names.
+     */
+    static QStringList scenarioNames();
+
+private:
+    static QList<PowerScenario> builtinScenarios();
+    bool findSensord();
+    void setDisplay(bool on);
+    static ProcessCounters counters(int pid);
+    bool runScenario(const PowerScenario& scenario, QString& result);
+
+    QString              sensor_;    /**< sensor ID of the sessions */
+    int                  duration_;  /**< measurement window in seconds */
+    QList<PowerScenario> scenarios_; /**< scenarios to run */
+    QString              output_;    /**< output file, stdout if empty */
+    int                  pid_;       /**< sensord PID */
+    bool                 stubMce_;   /**< do we own the MCE service name */
+    QDBusConnection      bus_;       /**< system bus */
+};
+
+#endif
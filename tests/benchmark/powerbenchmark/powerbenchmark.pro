@@ -0,0 +1,10 @@
+QT += dbus network
+QT -= gui
+
+include(../../common-install.pri)
+
+TEMPLATE = app
+TARGET = sensorpowerbenchmark
+HEADERS += powerbenchmark.h
+SOURCES += main.cpp \
+           powerbenchmark.cpp
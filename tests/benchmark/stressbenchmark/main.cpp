@@ -0,0 +1,42 @@
+/**
+   @file main.cpp
+   @brief Parameterized load benchmark for sensord
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+*/
+
+#include <QCoreApplication>
+#include <QDebug>
+#include "stressbenchmark.h"
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    StressBenchmark benchmark;
+
+    if (!benchmark.parse(app.arguments())) {
+        qWarning() << "Usage: sensorstressbenchmark [--clients=N] [--duration=SECONDS]"
+                   << "[--sensors=ID,...] [--adaptor=SENSOR:INTERVAL_US[:BATCH]]..."
+                   << "[--intervals=MS,...] [--buffersizes=N,...] [--downsampling=0|1,...]"
+                   << "[--notrace] [--output=FILE]"
+                   << "[--ramp=N,...] [--baseline=FILE] [--save-baseline=FILE] [--tolerance=PERCENT]";
+        return 2;
+    }
+    return benchmark.run() ? 0 : 1;
+}
@@ -0,0 +1,482 @@
+/**
+   @file stressbenchmark.cpp
+   @brief Parameterized load benchmark for sensord
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+*/
+
+#include "stressbenchmark.h"
+#include <QFile>
+#include <QProcess>
+#include <QSettings>
+#include <QTextStream>
+#include <QTime>
+#include <QDebug>
+#include <QtAlgorithms>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+/**
+ * Number of latency histogram buckets reported by sensordummyclient.
+ */
+static const int LATENCY_BUCKETS = 16;
+
+/**
+ * How often sensord memory use is sampled, in milliseconds.
+ */
+static const int RSS_SAMPLE_INTERVAL = 500;
+
+StressBenchmark::StressBenchmark(QObject* parent) :
+    QObject(parent),
+    clients_(8),
+    duration_(10),
+    trace_(true),
+    tolerance_(25),
+    pid_(0)
+{
+    sensors_ << "accelerometersensor" << "alssensor" << "magnetometersensor" << "gyroscopesensor";
+    intervals_ << "0" << "20" << "100";
+    bufferSizes_ << "1" << "1" << "10";
+    downsampling_ << "1" << "0";
+}
+
+bool StressBenchmark::parse(const QStringList& arguments)
+{
+    for (int i = 1; i < arguments.size(); ++i) {
+        QString name = arguments.at(i).section('=', 0, 0);
+        QString value = arguments.at(i).section('=', 1);
+        if (name == "--clients") {
+            clients_ = value.toInt();
+        } else if (name == "--duration") {
+            duration_ = value.toInt();
+        } else if (name == "--sensors") {
+            sensors_ = value.split(',', QString::SkipEmptyParts);
+        } else if (name == "--intervals") {
+            intervals_ = value.split(',', QString::SkipEmptyParts);
+        } else if (name == "--buffersizes") {
+            bufferSizes_ = value.split(',', QString::SkipEmptyParts);
+        } else if (name == "--downsampling") {
+            downsampling_ = value.split(',', QString::SkipEmptyParts);
+        } else if (name == "--notrace") {
+            trace_ = false;
+        } else if (name == "--output") {
+            output_ = value;
+        } else if (name == "--ramp") {
+            ramp_.clear();
+            foreach (const QString& step, value.split(',', QString::SkipEmptyParts)) {
+                if (step.toInt() <= 0)
+                    return false;
+                ramp_ << step.toInt();
+            }
+        } else if (name == "--baseline") {
+            baseline_ = value;
+        } else if (name == "--save-baseline") {
+            saveBaseline_ = value;
+        } else if (name == "--tolerance") {
+            tolerance_ = value.toDouble();
+        } else if (name == "--adaptor") {
+            QStringList parts = value.split(':');
+            FakeAdaptorLoad load;
+            load.sensor = parts.at(0);
+            load.interval = parts.size() > 1 ? parts.at(1).toUInt() : 0;
+            load.batch = parts.size() > 2 ? parts.at(2).toUInt() : 1;
+            if (load.sensor.isEmpty() || !load.interval || !load.batch)
+                return false;
+            loads_ << load;
+        } else {
+            return false;
+        }
+    }
+    return clients_ > 0 && duration_ > 0 &&
+           !sensors_.isEmpty() && !intervals_.isEmpty() &&
+           !bufferSizes_.isEmpty() && !downsampling_.isEmpty();
+}
+
+bool StressBenchmark::writeAdaptorConfig() const
+{
+    // Read by the fake adaptors whenever a sensor is started.
+    QFile::remove("/tmp/sensorTestConfig");
+    QSettings settings("/tmp/sensorTestConfig", QSettings::IniFormat);
+    foreach (const FakeAdaptorLoad& load, loads_) {
+        settings.beginGroup(load.sensor);
+        settings.setValue("interval_us", load.interval);
+        settings.setValue("batch", load.batch);
+        settings.endGroup();
+    }
+    settings.sync();
+    return settings.status() == QSettings::NoError;
+}
+
+bool StressBenchmark::findSensord()
+{
+    QProcess process;
+    process.start("pidof sensord");
+    process.waitForFinished(1000);
+    pid_ = atoi(process.readAllStandardOutput().constData());
+    return pid_ > 0;
+}
+
+unsigned long long StressBenchmark::cpuTime() const
+{
+    QFile file(QString("/proc/%1/stat").arg(pid_));
+    if (!file.open(QIODevice::ReadOnly))
+        return 0;
+
+    // Process name may contain spaces, fields are counted after it.
+    QByteArray line = file.readAll();
+    QList<QByteArray> fields = line.mid(line.lastIndexOf(')') + 2).split(' ');
+    if (fields.size() < 13)
+        return 0;
+    unsigned long long ticks = fields.at(11).toULongLong() + fields.at(12).toULongLong();
+    return ticks * 1000000 / sysconf(_SC_CLK_TCK);
+}
+
+unsigned int StressBenchmark::residentSize() const
+{
+    QFile file(QString("/proc/%1/status").arg(pid_));
+    if (!file.open(QIODevice::ReadOnly))
+        return 0;
+
+    QByteArray line = file.readLine();
+    while (!line.isEmpty()) {
+        if (line.startsWith("VmRSS:"))
+            return line.mid(6).trimmed().split(' ').at(0).toUInt();
+        line = file.readLine();
+    }
+    return 0;
+}
+
+bool StressBenchmark::parseSession(const QString& line, SessionResult& result) const
+{
+    result.summary = line;
+    result.received = 0;
+    result.dropped = 0;
+    result.latencyMax = 0;
+    result.histogram.fill(0, LATENCY_BUCKETS);
+    result.openUs = 0;
+    result.closeUs = 0;
+
+    bool found = false;
+    foreach (const QString& pair, line.split(' ', QString::SkipEmptyParts)) {
+        QString key = pair.section('=', 0, 0);
+        QString value = pair.section('=', 1);
+        if (key == "received") {
+            result.received = value.toUInt();
+            found = true;
+        } else if (key == "dropped") {
+            result.dropped = value.toUInt();
+        } else if (key == "latency_max") {
+            result.latencyMax = value.toULongLong();
+        } else if (key == "open_us") {
+            result.openUs = value.toULongLong();
+        } else if (key == "close_us") {
+            result.closeUs = value.toULongLong();
+        } else if (key == "latency_histogram") {
+            QStringList buckets = value.split(',');
+            for (int i = 0; i < buckets.size() && i < LATENCY_BUCKETS; ++i)
+                result.histogram[i] = buckets.at(i).toUInt();
+        }
+    }
+    return found;
+}
+
+unsigned long long StressBenchmark::percentile(const QVector<unsigned int>& histogram, unsigned long long max, int percent) const
+{
+    // Same estimate as LatencyStatistics::percentile(): upper bound of
+    // the bucket containing the requested sample.
+    unsigned long long count = 0;
+    foreach (unsigned int n, histogram)
+        count += n;
+    if (!count)
+        return 0;
+
+    unsigned long long wanted = (count * percent + 99) / 100;
+    unsigned long long seen = 0;
+    for (int bucket = 0; bucket < histogram.size() - 1; ++bucket) {
+        seen += histogram.at(bucket);
+        if (seen >= wanted)
+            return qMin(1ULL << bucket, max);
+    }
+    return max;
+}
+
+QString StressBenchmark::json(const StepResult& step) const
+{
+    const QList<SessionResult>& sessions = step.sessions;
+    unsigned long long cpuUs = step.cpuUs;
+    double seconds = step.seconds;
+    unsigned long long received = 0;
+    unsigned long long dropped = 0;
+    unsigned long long latencyMax = 0;
+    QVector<unsigned int> histogram(LATENCY_BUCKETS, 0);
+    foreach (const SessionResult& session, sessions) {
+        received += session.received;
+        dropped += session.dropped;
+        latencyMax = qMax(latencyMax, session.latencyMax);
+        for (int i = 0; i < LATENCY_BUCKETS; ++i)
+            histogram[i] += session.histogram.at(i);
+    }
+
+    // CPU time covers only the measurement window, scale the samples
+    // received during the whole session to it.
+    double windowSamples = received * seconds / duration_;
+    double cpuPerSample = windowSamples > 0 ? cpuUs / windowSamples : 0;
+
+    unsigned int rssMax = 0;
+    foreach (unsigned int rss, step.rss)
+        rssMax = qMax(rssMax, rss);
+
+    QString result;
+    QTextStream out(&result);
+    out << "{\n"
+        << "  \"clients\": " << step.clients << ",\n"
+        << "  \"sessions_reported\": " << sessions.size() << ",\n"
+        << "  \"duration_s\": " << seconds << ",\n"
+        << "  \"samples_received\": " << received << ",\n"
+        << "  \"samples_dropped\": " << dropped << ",\n"
+        << "  \"sensord_cpu_percent\": " << (seconds > 0 ? cpuUs / (seconds * 10000) : 0) << ",\n"
+        << "  \"sensord_cpu_us_per_sample\": " << cpuPerSample << ",\n"
+        << "  \"sensord_rss_kb_start\": " << (step.rss.isEmpty() ? 0 : step.rss.first()) << ",\n"
+        << "  \"sensord_rss_kb_max\": " << rssMax << ",\n"
+        << "  \"sensord_rss_kb_end\": " << (step.rss.isEmpty() ? 0 : step.rss.last()) << ",\n"
+        << "  \"latency_us_p50\": " << percentile(histogram, latencyMax, 50) << ",\n"
+        << "  \"latency_us_p90\": " << percentile(histogram, latencyMax, 90) << ",\n"
+        << "  \"latency_us_p99\": " << percentile(histogram, latencyMax, 99) << ",\n"
+        << "  \"latency_us_max\": " << latencyMax << ",\n"
+        << "  \"sessions\": [\n";
+    for (int i = 0; i < sessions.size(); ++i)
+        out << "    \"" << sessions.at(i).summary << "\"" << (i + 1 < sessions.size() ? "," : "") << "\n";
+    out << "  ]\n"
+        << "}\n";
+    out.flush();
+    return result;
+}
+
+bool StressBenchmark::runStep(int clients, StepResult& step)
+{
+    step.clients = clients;
+    step.sessions.clear();
+    step.rss.clear();
+
+    QList<QProcess*> processes;
+    for (int i = 0; i < clients; ++i) {
+        QStringList arguments;
+        arguments << "--sensor=" + sensors_.at(i % sensors_.size())
+                  << "--interval=" + intervals_.at(i % intervals_.size())
+                  << "--buffersize=" + bufferSizes_.at(i % bufferSizes_.size())
+                  << "--downsampling=" + downsampling_.at(i % downsampling_.size())
+                  << QString("--duration=%1").arg(duration_ * 1000);
+        if (trace_)
+            arguments << "--trace";
+        QProcess* process = new QProcess(this);
+        process->start("sensordummyclient", arguments);
+        processes << process;
+    }
+
+    // Measure only while all sessions are running.
+    foreach (QProcess* process, processes)
+        process->waitForStarted();
+    usleep(RSS_SAMPLE_INTERVAL * 1000);
+
+    QTime timer;
+    timer.start();
+    unsigned long long cpuStart = cpuTime();
+    step.rss << residentSize();
+    int measureTime = duration_ * 1000 - 2 * RSS_SAMPLE_INTERVAL;
+    while (timer.elapsed() < measureTime) {
+        usleep(RSS_SAMPLE_INTERVAL * 1000);
+        step.rss << residentSize();
+    }
+    step.cpuUs = cpuTime() - cpuStart;
+    step.seconds = timer.elapsed() / 1000.0;
+
+    bool ok = true;
+    foreach (QProcess* process, processes) {
+        process->waitForFinished(duration_ * 1000 + 10000);
+        SessionResult result;
+        QString line = QString::fromLocal8Bit(process->readAllStandardOutput()).trimmed();
+        if (parseSession(line, result) && result.received) {
+            step.sessions << result;
+        } else {
+            qWarning() << "Session" << process->arguments() << "did not receive samples";
+            ok = false;
+        }
+        delete process;
+    }
+    step.rss << residentSize();
+    return ok;
+}
+
+bool StressBenchmark::writeOutput(const QString& result) const
+{
+    if (output_.isEmpty()) {
+        QTextStream(stdout) << result;
+        return true;
+    }
+    QFile file(output_);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Failed to write" << output_;
+        return false;
+    }
+    file.write(result.toUtf8());
+    return true;
+}
+
+QMap<QString, double> StressBenchmark::stepMetrics(const StepResult& step) const
+{
+    unsigned long long received = 0;
+    QVector<unsigned long long> opens;
+    QVector<unsigned long long> closes;
+    foreach (const SessionResult& session, step.sessions) {
+        received += session.received;
+        opens << session.openUs;
+        closes << session.closeUs;
+    }
+    qSort(opens);
+    qSort(closes);
+    unsigned int rssMax = 0;
+    foreach (unsigned int rss, step.rss)
+        rssMax = qMax(rssMax, rss);
+    double windowSamples = received * step.seconds / duration_;
+
+    QMap<QString, double> metrics;
+    metrics["cpu_us_per_sample"] = windowSamples > 0 ? step.cpuUs / windowSamples : 0;
+    metrics["open_us_p50"] = opens.isEmpty() ? 0 : opens.at(opens.size() / 2);
+    metrics["open_us_max"] = opens.isEmpty() ? 0 : opens.last();
+    metrics["close_us_p50"] = closes.isEmpty() ? 0 : closes.at(closes.size() / 2);
+    metrics["close_us_max"] = closes.isEmpty() ? 0 : closes.last();
+    metrics["rss_kb_max"] = rssMax;
+    return metrics;
+}
+
+bool StressBenchmark::compareBaseline(const QList<StepResult>& steps, QStringList& regressions) const
+{
+    // Baselines are specific to the device; the first run records one.
+    if (!QFile::exists(baseline_)) {
+        qWarning() << "Baseline" << baseline_ << "does not exist, record it with --save-baseline";
+        return true;
+    }
+    QSettings baseline(baseline_, QSettings::IniFormat);
+    foreach (const StepResult& step, steps) {
+        QString group = QString("clients_%1").arg(step.clients);
+        QMap<QString, double> metrics = stepMetrics(step);
+        for (QMap<QString, double>::const_iterator it = metrics.constBegin(); it != metrics.constEnd(); ++it) {
+            QVariant stored = baseline.value(group + "/" + it.key());
+            // Nothing to scale the tolerance by.
+            if (!stored.isValid() || stored.toDouble() <= 0)
+                continue;
+            double limit = stored.toDouble() * (1 + tolerance_ / 100);
+            if (it.value() > limit) {
+                regressions << QString("%1 sessions: %2 %3 exceeds baseline %4 by more than %5%")
+                               .arg(step.clients).arg(it.key()).arg(it.value()).arg(stored.toDouble()).arg(tolerance_);
+            }
+        }
+    }
+    return regressions.isEmpty();
+}
+
+bool StressBenchmark::saveBaseline(const QList<StepResult>& steps) const
+{
+    QFile::remove(saveBaseline_);
+    QSettings baseline(saveBaseline_, QSettings::IniFormat);
+    foreach (const StepResult& step, steps) {
+        baseline.beginGroup(QString("clients_%1").arg(step.clients));
+        QMap<QString, double> metrics = stepMetrics(step);
+        for (QMap<QString, double>::const_iterator it = metrics.constBegin(); it != metrics.constEnd(); ++it)
+            baseline.setValue(it.key(), it.value());
+        baseline.endGroup();
+    }
+    baseline.sync();
+    return baseline.status() == QSettings::NoError;
+}
+
+QString StressBenchmark::rampJson(const QList<StepResult>& steps, const QStringList& regressions) const
+{
+    QString result;
+    QTextStream out(&result);
+    out << "{\n"
+        << "  \"duration_s\": " << duration_ << ",\n"
+        << "  \"steps\": [\n";
+    for (int i = 0; i < steps.size(); ++i) {
+        const StepResult& step = steps.at(i);
+        QMap<QString, double> metrics = stepMetrics(step);
+        out << "    { \"clients\": " << step.clients
+            << ", \"sessions_reported\": " << step.sessions.size();
+        for (QMap<QString, double>::const_iterator it = metrics.constBegin(); it != metrics.constEnd(); ++it)
+            out << ", \"" << it.key() << "\": " << it.value();
+        out << " }" << (i + 1 < steps.size() ? "," : "") << "\n";
+    }
+    out << "  ],\n"
+        << "  \"regressions\": [\n";
+    for (int i = 0; i < regressions.size(); ++i)
+        out << "    \"" << regressions.at(i) << "\"" << (i + 1 < regressions.size() ? "," : "") << "\n";
+    out << "  ]\n"
+        << "}\n";
+    out.flush();
+    return result;
+}
+
+bool StressBenchmark::run()
+{
+    if (!findSensord()) {
+        qWarning() << "sensord is not running";
+        return false;
+    }
+    if (!writeAdaptorConfig()) {
+        qWarning() << "Failed to write fake adaptor configuration";
+        return false;
+    }
+
+    if (ramp_.isEmpty()) {
+        StepResult step;
+        bool ok = runStep(clients_, step);
+        return writeOutput(json(step)) && ok;
+    }
+
+    // Every client holds three pipes to us.
+    struct rlimit files;
+    if (getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur < files.rlim_max) {
+        files.rlim_cur = files.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &files);
+    }
+
+    QList<StepResult> steps;
+    bool ok = true;
+    foreach (int clients, ramp_) {
+        StepResult step;
+        if (!runStep(clients, step))
+            ok = false;
+        steps << step;
+        // Let sensord release the sessions before the next step.
+        usleep(RSS_SAMPLE_INTERVAL * 1000);
+    }
+
+    QStringList regressions;
+    if (!baseline_.isEmpty() && !compareBaseline(steps, regressions)) {
+        foreach (const QString& regression, regressions)
+            qWarning() << regression;
+        ok = false;
+    }
+    if (!saveBaseline_.isEmpty() && !saveBaseline(steps)) {
+        qWarning() << "Failed to write baseline" << saveBaseline_;
+        ok = false;
+    }
+    return writeOutput(rampJson(steps, regressions)) && ok;
+}
@@ -0,0 +1,153 @@
+/**
+   @file stressbenchmark.h
+   @brief Parameterized load benchmark for sensord
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+*/
+
+#ifndef STRESSBENCHMARK_H
+#define STRESSBENCHMARK_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QVector>
+#include <QMap>
+
+/**
+ * Load generated by a fake adaptor.
+ */
+struct FakeAdaptorLoad
+{
+    QString      sensor;   /**< adapted sensor name, e.g. accelerometer */
+    unsigned int interval; /**< interval in microseconds */
+    unsigned int batch;    /**< samples per wakeup */
+};
+
+/**
+ * Result reported by a single sensordummyclient session.
+ */
+struct SessionResult
+{
+    QString              summary;   /**< summary line of the client */
+    unsigned int         received;  /**< samples received */
+    unsigned int         dropped;   /**< samples lost */
+    unsigned long long   latencyMax; /**< largest traced latency */
+    QVector<unsigned int> histogram; /**< traced latency histogram */
+    unsigned long long   openUs;    /**< session open latency */
+    unsigned long long   closeUs;   /**< session close latency */
+};
+
+/**
+ * Measurements of one run of concurrent sessions.
+ */
+struct StepResult
+{
+    int                  clients;  /**< number of sessions started */
+    QList<SessionResult> sessions; /**< sessions which received samples */
+    unsigned long long   cpuUs;    /**< sensord CPU time during the window */
+    double               seconds;  /**< length of the window */
+    QList<unsigned int>  rss;      /**< sampled sensord RSS in kB */
+};
+
+/**
+ * Runs sessions of sensordummyclient with mixed settings against a
+ * sensord using the fake adaptors, and measures the CPU time and
+ * memory of sensord and the latencies seen by the clients. Results are
+ * written as JSON:
+ *
+ * <pre>
+ * sensorstressbenchmark --clients=16 --duration=10
+ *     --sensors=accelerometersensor,alssensor
+ *     --adaptor=accelerometer:5000:4 --adaptor=als:100000
+ *     --intervals=0,20,100 --buffersizes=1,10 --downsampling=1,0
+ *     --output=result.json
+ * </pre>
+ *
+ * List options are cycled over the clients, so that client n uses the
+ * n:th entry of each list modulo its length.
+ *
+ * With <tt>--ramp=1,10,100,1000</tt> the run is repeated with each
+ * number of concurrent sessions instead, and per step sensord CPU time
+ * per sample, session open and close latency and RSS are reported.
+ * <tt>--save-baseline=FILE</tt> stores these, <tt>--baseline=FILE</tt>
+ * compares against stored ones and fails when any of them has grown by
+ * more than <tt>--tolerance=PERCENT</tt>, catching bookkeeping which
+ * scales worse than linearly with the number of sessions. Baselines
+ * depend on the device and are not shipped; a missing one is skipped.
+ */
+class StressBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * Constructor.
+     *
+     * @param parent parent object.
+     */
+    StressBenchmark(QObject* parent = 0);
+
+    /**
+     * Parse command line options.
+     *
+     * @param arguments command line arguments.
+     * @return were the options valid.
+     */
+    bool parse(const QStringList& arguments);
+
+    /**
+     * Run the benchmark and write the results.
+     *
+     * @return did all sessions receive samples.
+     */
+    bool run();
+
+private:
+    bool writeAdaptorConfig() const;
+    bool runStep(int clients, StepResult& step);
+    bool writeOutput(const QString& result) const;
+    QMap<QString, double> stepMetrics(const StepResult& step) const;
+    bool compareBaseline(const QList<StepResult>& steps, QStringList& regressions) const;
+    bool saveBaseline(const QList<StepResult>& steps) const;
+    QString rampJson(const QList<StepResult>& steps, const QStringList& regressions) const;
+    bool findSensord();
+    unsigned long long cpuTime() const;
+    unsigned int residentSize() const;
+    bool parseSession(const QString& line, SessionResult& result) const;
+    unsigned long long percentile(const QVector<unsigned int>& histogram, unsigned long long max, int percent) const;
+    QString json(const StepResult& step) const;
+
+    int                     clients_;       /**< number of sessions */
+    int                     duration_;      /**< session length in seconds */
+    QStringList             sensors_;       /**< sensor IDs */
+    QStringList             intervals_;     /**< session intervals */
+    QStringList             bufferSizes_;   /**< session buffer sizes */
+    QStringList             downsampling_;  /**< session downsampling */
+    bool                    trace_;         /**< request latency tracing */
+    QList<FakeAdaptorLoad>  loads_;         /**< fake adaptor loads */
+    QString                 output_;        /**< output file, stdout if empty */
+    QList<int>              ramp_;          /**< session counts of the ramp steps */
+    QString                 baseline_;      /**< baseline to compare against */
+    QString                 saveBaseline_;  /**< file to store the baseline in */
+    double                  tolerance_;     /**< allowed growth over baseline in percent */
+    int                     pid_;           /**< sensord PID */
+};
+
+#endif
@@ -0,0 +1,10 @@
+QT += dbus network
+QT -= gui
+
+include(../../common-install.pri)
+
+TEMPLATE = app
+TARGET = sensorstressbenchmark
+HEADERS += stressbenchmark.h
+SOURCES += main.cpp \
+           stressbenchmark.cpp
@@ -513,6 +513,30 @@ void ClientApiTest::testSessionInitiation()
     QVERIFY2(orientation && orientation->isValid(), "Could not get orientation sensor channel");
 }
 
+void ClientApiTest::testSensorInfo()
+{
+    SensorManagerInterface& sm = SensorManagerInterface::instance();
+    QVERIFY( sm.isValid() );
+
+    QDBusReply<QVariantMap> reply = sm.sensorInfo(QStringList() << "accelerometersensor");
+    QVERIFY(reply.isValid());
+    QVERIFY(reply.value().contains("accelerometersensor"));
+
+    QVariantMap info = qdbus_cast<QVariantMap>(reply.value().value("accelerometersensor"));
+    QVERIFY(info.value("valid").toBool());
+
+    // Same metadata as through the sensor interface.
+    AccelerometerSensorChannelInterface* sensorIfc = AccelerometerSensorChannelInterface::interface("accelerometersensor");
+    QScopedPointer<AbstractSensorChannelInterface> sensorTmp(sensorIfc);
+    QVERIFY2(sensorIfc && sensorIfc->isValid(), "Failed to get control session");
+
+    QCOMPARE(info.value("description").toString(), sensorIfc->description());
+    QCOMPARE(qdbus_cast<DataRangeList>(info.value("intervals")).size(), sensorIfc->getAvailableIntervals().size());
+    QCOMPARE(qdbus_cast<DataRangeList>(info.value("dataRanges")).size(), sensorIfc->getAvailableDataRanges().size());
+    QCOMPARE(qdbus_cast<IntegerRangeList>(info.value("bufferSizes")), sensorIfc->getAvailableBufferSizes());
+    QCOMPARE(info.value("hwBuffering").toBool(), sensorIfc->hwBuffering());
+}
+
 void ClientApiTest::testBuffering()
 {
     foreach(const QString& sensorName, bufferingSensors)
@@ -72,6 +72,7 @@ private slots:
     // Special cases
     void testCommonAdaptorPipeline();
     void testSessionInitiation();
+    void testSensorInfo();
 
     // Buffering
     void testBuffering();
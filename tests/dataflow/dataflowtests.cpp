@@ -38,13 +38,134 @@
 #include "dataflowtests.h"
 #include "loader.h"
 #include "plugin.h"
+#include "deviceadaptorringbuffer.h"
+#include "sessiontable.h"
+#include "flushwheel.h"
+#include "datatypes/timedunsigned.h"
 #include <accelerometeradaptor/accelerometeradaptor.h>
 #include <accelerometerchain/accelerometerchain.h>
 #include <coordinatealignfilter/coordinatealignfilter.h>
 
+#include <QThread>
+#include <QElapsedTimer>
+#include <QAtomicInt>
 #include <stdio.h>
 #include <stdlib.h>
 
+/**
+ * Ring buffer reader which is read by the test instead of pushing.
+ */
+class TestReader : public RingBufferReader<TimedUnsigned>
+{
+public:
+    void pushNewData() {}
+
+    using RingBufferReader<TimedUnsigned>::read;
+    using RingBufferReader<TimedUnsigned>::peek;
+    using RingBufferReader<TimedUnsigned>::commitRead;
+};
+
+/**
+ * Write values first, first + 1, ... into the buffer one by one.
+ */
+static void writeValues(DeviceAdaptorRingBuffer<TimedUnsigned>& buffer, unsigned first, unsigned count)
+{
+    for (unsigned i = 0; i < count; ++i) {
+        *buffer.nextSlot() = TimedUnsigned(first + i, first + i);
+        buffer.commit();
+    }
+}
+
+/**
+ * Reader which drains the buffer when woken up by the writer and checks
+ * that it sees consecutive values.
+ */
+class DrainingReader : public TestReader
+{
+public:
+    DrainingReader() :
+        callback_(this, &DrainingReader::drain),
+        wakeups(0),
+        gaps(0),
+        started(false),
+        last(0)
+    {
+        setReadyCallback(&callback_);
+    }
+
+    void drain()
+    {
+        wakeups.fetchAndAddOrdered(1);
+        TimedUnsigned values[16];
+        unsigned n;
+        while ((n = read(16, values))) {
+            for (unsigned i = 0; i < n; ++i) {
+                if (started && values[i].value_ != last + 1)
+                    ++gaps;
+                last = values[i].value_;
+                started = true;
+            }
+        }
+    }
+
+    Callback<DrainingReader> callback_;
+    QAtomicInt wakeups;
+    int gaps;
+    bool started;
+    unsigned last;
+};
+
+/**
+ * Writes consecutive values in staged batches.
+ */
+class StagedWriter : public QThread
+{
+public:
+    StagedWriter(DeviceAdaptorRingBuffer<TimedUnsigned>& buffer, unsigned count) :
+        buffer_(buffer), count_(count) {}
+
+    void run()
+    {
+        unsigned value = 0;
+        while (value < count_) {
+            for (int i = 0; i < 4; ++i, ++value)
+                *buffer_.stageSlot() = TimedUnsigned(value, value);
+            buffer_.commitStaged();
+            buffer_.wakeUpReaders();
+        }
+    }
+
+private:
+    DeviceAdaptorRingBuffer<TimedUnsigned>& buffer_;
+    unsigned count_;
+};
+
+/**
+ * Wheel entry which records when it expired, and optionally schedules
+ * itself again with the same delay.
+ */
+class RecordingEntry : public FlushWheel::Entry
+{
+public:
+    RecordingEntry(const QElapsedTimer& clock, FlushWheel* wheel = NULL, unsigned int period = 0, int repeats = 0) :
+        clock_(clock), wheel_(wheel), period_(period), repeats_(repeats) {}
+
+    void expired()
+    {
+        expiries.append(clock_.elapsed());
+        if (wheel_ && expiries.size() <= repeats_)
+            wheel_->schedule(this, period_);
+    }
+
+    QList<qint64> expiries;
+
+private:
+    const QElapsedTimer& clock_;
+    FlushWheel* wheel_;
+    unsigned int period_;
+    int repeats_;
+};
+
 void DataFlowTest::initTestCase()
 {
     Config::loadConfig("/etc/sensorfw/sensord.conf", "/etc/sensorfw/sensord.conf.d");
@@ -188,6 +309,205 @@ void DataFlowTest::testChainSharing()
     sm.releaseChain("accelerometerchain");
     // check that does not exist
 }
+
+void DataFlowTest::testRingBufferWrap()
+{
+    DeviceAdaptorRingBuffer<TimedUnsigned> buffer(8);
+    TestReader reader;
+    QVERIFY(buffer.join(&reader));
+
+    TimedUnsigned values[8];
+    writeValues(buffer, 0, 6);
+    QCOMPARE(reader.read(8, values), 6u);
+
+    // Slots 6, 7, 0, 1 and 2: the read span wraps the end of the buffer.
+    writeValues(buffer, 6, 5);
+    QCOMPARE(reader.read(8, values), 5u);
+    for (unsigned i = 0; i < 5; ++i)
+        QCOMPARE(values[i].value_, 6 + i);
+
+    // Slots 3 to 7 in the first span, 0 and 1 in the wrapped one.
+    writeValues(buffer, 11, 7);
+    const TimedUnsigned* first;
+    const TimedUnsigned* second;
+    unsigned firstCount;
+    QCOMPARE(reader.peek(8, first, firstCount, second), 7u);
+    QCOMPARE(firstCount, 5u);
+    for (unsigned i = 0; i < firstCount; ++i)
+        QCOMPARE(first[i].value_, 11 + i);
+    for (unsigned i = 0; i < 7 - firstCount; ++i)
+        QCOMPARE(second[i].value_, 11 + firstCount + i);
+    QCOMPARE(reader.commitRead(7), 0u);
+
+    QCOMPARE(reader.read(8, values), 0u);
+    QCOMPARE(reader.overruns(), 0u);
+    QVERIFY(buffer.unjoin(&reader));
+}
+
+void DataFlowTest::testRingBufferOverrun()
+{
+    DeviceAdaptorRingBuffer<TimedUnsigned> buffer(8);
+    TestReader reader;
+    QVERIFY(buffer.join(&reader));
+
+    // Lapped by the writer, the reader skips to the oldest valid slot.
+    TimedUnsigned values[16];
+    writeValues(buffer, 0, 20);
+    QCOMPARE(reader.read(16, values), 8u);
+    for (unsigned i = 0; i < 8; ++i)
+        QCOMPARE(values[i].value_, 12 + i);
+    QCOMPARE(reader.overruns(), 12u);
+
+    // Same through peek, the overrun adds up.
+    writeValues(buffer, 20, 10);
+    const TimedUnsigned* first;
+    const TimedUnsigned* second;
+    unsigned firstCount;
+    QCOMPARE(reader.peek(16, first, firstCount, second), 8u);
+    QCOMPARE(first[0].value_, 22u);
+    QCOMPARE(reader.commitRead(8), 0u);
+    QCOMPARE(reader.overruns(), 14u);
+
+    // A reader which keeps up does not count more.
+    writeValues(buffer, 30, 3);
+    QCOMPARE(reader.read(16, values), 3u);
+    QCOMPARE(values[0].value_, 30u);
+    QCOMPARE(reader.overruns(), 14u);
+    QVERIFY(buffer.unjoin(&reader));
+}
+
+void DataFlowTest::testRingBufferJoinWhileWriting()
+{
+    DeviceAdaptorRingBuffer<TimedUnsigned> buffer(64);
+    DrainingReader steady;
+    DrainingReader joining[3];
+    QVERIFY(buffer.join(&steady));
+
+    StagedWriter writer(buffer, 400000);
+    writer.start();
+    for (int round = 0; writer.isRunning(); ++round) {
+        DrainingReader& reader = joining[round % 3];
+        reader.started = false;
+        QVERIFY(buffer.join(&reader));
+        QThread::yieldCurrentThread();
+        QVERIFY(buffer.unjoin(&reader));
+
+        // Once unjoin has returned the writer does not call the reader.
+        int wakeups = reader.wakeups.fetchAndAddOrdered(0);
+        QThread::yieldCurrentThread();
+        QCOMPARE(reader.wakeups.fetchAndAddOrdered(0), wakeups);
+    }
+    writer.wait();
+
+    QVERIFY(steady.wakeups.fetchAndAddOrdered(0) > 0);
+    QCOMPARE(steady.gaps, 0);
+    QCOMPARE(steady.last, 399999u);
+    for (int i = 0; i < 3; ++i)
+        QCOMPARE(joining[i].gaps, 0);
+    QVERIFY(buffer.unjoin(&steady));
+}
+
+void DataFlowTest::testSessionTableCollisions()
+{
+    // 3, 19, 35 and 51 share the home slot of a 16 slot table, and 4
+    // and 20 are pushed out of theirs by the probe sequence.
+    const int ids[] = { 3, 19, 35, 51, 4, 20, 7 };
+    const int count = sizeof(ids) / sizeof(ids[0]);
+    int values[count];
+
+    SessionTable<int> table;
+    for (int i = 0; i < count; ++i) {
+        values[i] = ids[i];
+        table.insert(ids[i], &values[i]);
+    }
+    QCOMPARE(table.size(), count);
+
+    // Take from the middle of the probe sequence, the entries behind
+    // it shift back and still have to be found.
+    QCOMPARE(table.take(19), &values[1]);
+    QVERIFY(!table.contains(19));
+    QCOMPARE(table.take(19), (int*)NULL);
+    QCOMPARE(table.size(), count - 1);
+    for (int i = 0; i < count; ++i) {
+        if (ids[i] != 19)
+            QCOMPARE(table.value(ids[i]), &values[i]);
+    }
+
+    // The dense array holds every remaining session once.
+    QList<int> seen;
+    for (int i = 0; i < table.size(); ++i) {
+        QCOMPARE(*table.at(i), table.idAt(i));
+        QVERIFY(!seen.contains(table.idAt(i)));
+        seen.append(table.idAt(i));
+    }
+    QCOMPARE(seen.size(), count - 1);
+
+    // Empty the table in another order, checking the rest each time.
+    const int order[] = { 3, 51, 7, 4, 35, 20 };
+    for (int n = 0; n < count - 1; ++n) {
+        QVERIFY(table.take(order[n]));
+        for (int i = 0; i < count; ++i) {
+            bool taken = ids[i] == 19;
+            for (int j = 0; j <= n; ++j)
+                taken = taken || ids[i] == order[j];
+            QCOMPARE(table.value(ids[i]), taken ? (int*)NULL : &values[i]);
+        }
+    }
+    QCOMPARE(table.size(), 0);
+}
+
+void DataFlowTest::testFlushWheelDeadlines()
+{
+    // With 1 ms ticks the 256 slot wheel turns over every 256 ms, so
+    // the 300 and 600 ms deadlines share slots with earlier ticks.
+    const unsigned int delays[] = { 10, 44, 100, 300, 600 };
+    const int count = sizeof(delays) / sizeof(delays[0]);
+    const qint64 lateness = 200;
+
+    QElapsedTimer clock;
+    clock.start();
+    FlushWheel wheel(1);
+    QList<RecordingEntry*> entries;
+    for (int i = 0; i < count; ++i) {
+        entries.append(new RecordingEntry(clock));
+        wheel.schedule(entries.last(), delays[i]);
+    }
+
+    // Periodic session rescheduled from its expiry, across the wrap.
+    RecordingEntry periodic(clock, &wheel, 70, 7);
+    wheel.schedule(&periodic, 70);
+
+    // A cancelled entry never expires.
+    RecordingEntry cancelled(clock);
+    wheel.schedule(&cancelled, 50);
+    wheel.cancel(&cancelled);
+    QVERIFY(!FlushWheel::isScheduled(&cancelled));
+
+    for (int waited = 0; waited < 3000 && periodic.expiries.size() < 8; waited += 10)
+        QTest::qWait(10);
+    QTest::qWait(50);
+
+    // Never early, never a revolution late, and in deadline order.
+    for (int i = 0; i < count; ++i) {
+        QCOMPARE(entries[i]->expiries.size(), 1);
+        qint64 at = entries[i]->expiries.first();
+        QVERIFY2(at >= (qint64)delays[i], qPrintable(QString("%1 ms deadline expired at %2 ms").arg(delays[i]).arg(at)));
+        QVERIFY2(at < (qint64)delays[i] + lateness, qPrintable(QString("%1 ms deadline expired at %2 ms").arg(delays[i]).arg(at)));
+        if (i)
+            QVERIFY(at >= entries[i - 1]->expiries.first());
+        QVERIFY(!FlushWheel::isScheduled(entries[i]));
+    }
+
+    QCOMPARE(periodic.expiries.size(), 8);
+    for (int i = 1; i < periodic.expiries.size(); ++i) {
+        qint64 period = periodic.expiries[i] - periodic.expiries[i - 1];
+        QVERIFY2(period >= 69 && period < 70 + lateness, qPrintable(QString("period %1 ms").arg(period)));
+    }
+    QVERIFY(!FlushWheel::isScheduled(&periodic));
+    QVERIFY(cancelled.expiries.isEmpty());
+    qDeleteAll(entries);
+}
+
 QList<QString> DataFlowTest::getKeys(const SensorManager &that)
 {
     return that.getAdaptorTypes();
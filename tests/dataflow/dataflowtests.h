@@ -45,6 +45,11 @@ private slots:
 
     void testAdaptorSharing();
     void testChainSharing();
+    void testRingBufferWrap();
+    void testRingBufferOverrun();
+    void testRingBufferJoinWhileWriting();
+    void testSessionTableCollisions();
+    void testFlushWheelDeadlines();
 
     void cleanup() {};
     void cleanupTestCase();
@@ -38,6 +38,7 @@
 #include "orientationinterpreter.h"
 #include "declinationfilter.h"
 #include "rotationfilter.h"
+#include "downsamplewindow.h"
 #include "filtertests.h"
 #include "config.h"
 
@@ -130,6 +131,70 @@ void FilterApiTest::testCoordinateAlignFilter()
     delete coordAlignFilter;
 }
 
+void FilterApiTest::testCoordinateAlignFilterLiveMatrix()
+{
+    double hconv[3][3] = {
+        { 0, 0,-1},
+        {-1, 0, 0},
+        { 0, 1, 0}
+    };
+
+    TimedXyzData inputData[] = {
+        TimedXyzData(0, 1, 2, 3),
+        TimedXyzData(0, 4, 5, 6),
+        TimedXyzData(0, 1, 2, 3),
+        TimedXyzData(0, 4, 5, 6)
+    };
+
+    // Identity until the matrix is changed between the batches.
+    TimedXyzData expectedResult[] = {
+        TimedXyzData(0, 1, 2, 3),
+        TimedXyzData(0, 4, 5, 6),
+        TimedXyzData(0,-3,-1, 2),
+        TimedXyzData(0,-6,-4, 5)
+    };
+
+    int numInputs = (sizeof(inputData) / sizeof(TimedXyzData));
+
+    Bin filterBin;
+    DummyAdaptor<TimedXyzData> dummyAdaptor;
+
+    FilterBase* coordAlignFilter = CoordinateAlignFilter::factoryMethod();
+
+    RingBuffer<TimedXyzData> outputBuffer(10);
+    filterBin.add(&dummyAdaptor, "adapter");
+    filterBin.add(coordAlignFilter, "coordfilter");
+    filterBin.add(&outputBuffer, "buffer");
+
+    filterBin.join("adapter", "source", "coordfilter", "sink");
+    filterBin.join("coordfilter", "source", "buffer", "sink");
+
+    DummyDataEmitter<TimedXyzData> dbusEmitter;
+    Bin marshallingBin;
+    marshallingBin.add(&dbusEmitter, "testdataemitter");
+    outputBuffer.join(&dbusEmitter);
+
+    dummyAdaptor.setTestData(numInputs, inputData);
+    dbusEmitter.setExpectedData(numInputs, expectedResult);
+
+    marshallingBin.start();
+    filterBin.start();
+
+    dummyAdaptor.pushNewData();
+    dummyAdaptor.pushNewData();
+    ((CoordinateAlignFilter*)coordAlignFilter)->setProperty("transMatrix", QVariant::fromValue(TMatrix(hconv)));
+    QCOMPARE(((CoordinateAlignFilter*)coordAlignFilter)->matrixString(), QString("0,0,-1,-1,0,0,0,1,0"));
+    dummyAdaptor.pushNewData();
+    dummyAdaptor.pushNewData();
+
+    filterBin.stop();
+    marshallingBin.stop();
+
+    QCOMPARE (dummyAdaptor.getDataCount(), dbusEmitter.numSamplesReceived());
+
+    delete coordAlignFilter;
+}
+
 // TODO: Add some state changes to verify functionality of threshold setting.
 void FilterApiTest::testTopEdgeInterpretationFilter()
 {
@@ -487,4 +552,80 @@ void FilterApiTest::testRotationFilter()
     delete rotationFilter;
 }
 
+/**
+ * Average of the samples, computed directly over the list the way
+ * downsampling did before the running sums.
+ */
+static TimedXyzData directAverage(const QList<TimedXyzData>& samples)
+{
+    long x = 0;
+    long y = 0;
+    long z = 0;
+    foreach (const TimedXyzData& data, samples) {
+        x += data.x_;
+        y += data.y_;
+        z += data.z_;
+    }
+    return TimedXyzData(samples.last().timestamp_,
+                        x / samples.count(),
+                        y / samples.count(),
+                        z / samples.count());
+}
+
+void FilterApiTest::testDownsampleWindow()
+{
+    const int capacity = 5;
+    const quint64 maxAge = 2000000;
+
+    DownsampleWindow<TimedXyzData> window;
+    window.setCapacity(capacity);
+    QCOMPARE(window.capacity(), (unsigned int)capacity);
+
+    QList<TimedXyzData> reference;
+    quint64 timestamp = 0;
+    qsrand(4);
+    for (int i = 0; i < 60; ++i) {
+        if (i == 30) {
+            // Reset in the middle of the stream, like a session restart.
+            window.clear();
+            reference.clear();
+            QCOMPARE(window.count(), 0u);
+        }
+
+        // Gap of more than maxAge expires the whole window.
+        timestamp += (i == 17) ? 2500000 : 100000;
+        TimedXyzData data(timestamp,
+                          qrand() % 2001 - 1000,
+                          qrand() % 2001 - 1000,
+                          qrand() % 2001 - 1000);
+
+        window.dropOlderThan(timestamp, maxAge);
+        window.push(data);
+        while (!reference.isEmpty() && timestamp - reference.first().timestamp_ > maxAge)
+            reference.removeFirst();
+        reference.append(data);
+        if (reference.count() > capacity)
+            reference.removeFirst();
+
+        QCOMPARE(window.count(), (unsigned int)reference.count());
+        QCOMPARE(window.isFull(), reference.count() == capacity);
+
+        TimedXyzData expected = directAverage(reference);
+        TimedXyzData result = window.result();
+        QCOMPARE(result.timestamp_, expected.timestamp_);
+        QCOMPARE(result.x_, expected.x_);
+        QCOMPARE(result.y_, expected.y_);
+        QCOMPARE(result.z_, expected.z_);
+    }
+
+    // Changing the capacity starts over, sums included.
+    window.setCapacity(3);
+    QCOMPARE(window.count(), 0u);
+    TimedXyzData single(timestamp, 7, -8, 9);
+    window.push(single);
+    QCOMPARE(window.result().x_, 7);
+    QCOMPARE(window.result().y_, -8);
+    QCOMPARE(window.result().z_, 9);
+}
+
 QTEST_MAIN(FilterApiTest)
@@ -46,11 +46,13 @@ private slots:
     void init() {}
 
     void testCoordinateAlignFilter();
+    void testCoordinateAlignFilterLiveMatrix();
     void testTopEdgeInterpretationFilter();
     void testFaceInterpretationFilter();
     void testDeclinationFilter();
     void testOrientationInterpretationFilter();
     void testRotationFilter();
+    void testDownsampleWindow();
 
     void cleanup() {}
     void cleanupTestCase() {}
@@ -0,0 +1,42 @@
+/**
+   @file main.cpp
+   @brief Live pipeline statistics of sensord
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+*/
+
+#include <QCoreApplication>
+#include <QDebug>
+#include "sensordstat.h"
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    SensordStat stat;
+
+    if (!stat.parse(app.arguments())) {
+        qWarning() << "Usage: sensordstat [--interval=MS] [--count=N]"
+                   << "[--sort=cpu|rate|drops|queue|name] [--filter=TEXT] [--batch] [--off]";
+        return 2;
+    }
+    QObject::connect(&stat, SIGNAL(finished()), &app, SLOT(quit()));
+    if (!stat.start())
+        return 1;
+    return app.exec();
+}
@@ -0,0 +1,309 @@
+/**
+   @file sensordstat.cpp
+   @brief Live pipeline statistics of sensord
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+*/
+
+#include "sensordstat.h"
+#include "serviceinfo.h"
+#include <QDBusInterface>
+#include <QDBusReply>
+#include <QDateTime>
+#include <QTextStream>
+#include <QMap>
+#include <QDebug>
+
+/**
+ * Interface of SensorManager on the bus.
+ */
+static const char* const MANAGER_INTERFACE = "local.SensorManager";
+
+StatLine::StatLine() :
+    session(false), in(0), out(0), drops(0), queue(0), queuePeak(0), socketBytes(0), rate(0),
+    histogram(BUCKETS, 0)
+{
+}
+
+/**
+ * Bucket of a histogram entry formatted by NodeStatistics, like
+ * <tt><8:3</tt> or <tt>>=16384:1</tt>.
+ *
+ * @param entry histogram entry.
+ * @param count receives the count.
+ * @return bucket, -1 if the entry is not valid.
+ */
+static int histogramBucket(const QString& entry, unsigned long long& count)
+{
+    count = entry.section(':', 1).toULongLong();
+    if (entry.startsWith(">="))
+        return StatLine::BUCKETS - 1;
+    if (!entry.startsWith("<"))
+        return -1;
+    unsigned int bound = entry.mid(1).section(':', 0, 0).toUInt();
+    int bucket = 0;
+    while (bucket < StatLine::BUCKETS - 1 && (1u << bucket) < bound)
+        ++bucket;
+    return bucket;
+}
+
+bool StatLine::parse(const QString& line)
+{
+    int colon = line.indexOf(": ");
+    if (colon <= 0)
+        return false;
+    name = line.left(colon);
+    session = name.contains("session ");
+
+    bool valid = false;
+    foreach (const QString& field, line.mid(colon + 2).split(", ")) {
+        QStringList words = field.split(' ', QString::SkipEmptyParts);
+        if (words.size() < 2)
+            continue;
+        const QString& key = words.at(0);
+        if (key == "in") {
+            in = words.at(1).toULongLong();
+        } else if (key == "out") {
+            out = words.at(1).toULongLong();
+            valid = true;
+        } else if (key == "drops") {
+            drops = words.at(1).toULongLong();
+        } else if (key == "queue") {
+            queue = words.at(1).toUInt();
+            queuePeak = words.size() >= 4 ? words.at(3).toUInt() : queue;
+        } else if (key == "socket" && words.size() >= 3) {
+            socketBytes = words.at(2).toULongLong();
+        } else if (key == "rate") {
+            rate = words.at(1).toDouble();
+        } else if (key == "time") {
+            for (int i = 2; i < words.size(); ++i) {
+                unsigned long long count;
+                int bucket = histogramBucket(words.at(i), count);
+                if (bucket >= 0)
+                    histogram[bucket] = count;
+            }
+        }
+    }
+    return valid;
+}
+
+/**
+ * Estimated time spent in a bucket per sample: the middle of its range.
+ *
+ * @param bucket bucket.
+ * @return time in microseconds.
+ */
+static double bucketTime(int bucket)
+{
+    if (bucket == 0)
+        return 0.5;
+    if (bucket == StatLine::BUCKETS - 1)
+        return 1u << (bucket - 1);
+    return 0.75 * (1u << bucket);
+}
+
+/**
+ * Percentile of a processing time histogram, as the upper bound of the
+ * bucket holding the wanted sample like LatencyStatistics does.
+ *
+ * @param histogram histogram.
+ * @param percent percentile.
+ * @return formatted time in microseconds, "-" if empty.
+ */
+static QString percentile(const QVector<unsigned long long>& histogram, int percent)
+{
+    unsigned long long total = 0;
+    foreach (unsigned long long count, histogram)
+        total += count;
+    if (!total)
+        return "-";
+
+    unsigned long long wanted = (total * percent + 99) / 100;
+    unsigned long long seen = 0;
+    for (int bucket = 0; bucket < histogram.size() - 1; ++bucket) {
+        seen += histogram.at(bucket);
+        if (seen >= wanted)
+            return QString::number(1u << bucket);
+    }
+    return QString(">%1").arg(1u << (histogram.size() - 2));
+}
+
+SensordStat::SensordStat(QObject* parent) :
+    QObject(parent),
+    manager_(NULL),
+    interval_(1000),
+    count_(-1),
+    sort_("cpu"),
+    batch_(false),
+    off_(false),
+    fetched_(0)
+{
+    connect(&timer_, SIGNAL(timeout()), this, SLOT(refresh()));
+}
+
+SensordStat::~SensordStat()
+{
+    delete manager_;
+}
+
+bool SensordStat::parse(const QStringList& arguments)
+{
+    for (int i = 1; i < arguments.size(); ++i) {
+        QString name = arguments.at(i).section('=', 0, 0);
+        QString value = arguments.at(i).section('=', 1);
+        if (name == "--interval") {
+            interval_ = value.toInt();
+        } else if (name == "--count") {
+            count_ = value.toInt();
+        } else if (name == "--sort") {
+            sort_ = value;
+        } else if (name == "--filter") {
+            filter_ = value;
+        } else if (name == "--batch") {
+            batch_ = true;
+        } else if (name == "--off") {
+            off_ = true;
+        } else {
+            return false;
+        }
+    }
+    static const QStringList columns = QStringList() << "cpu" << "rate" << "drops" << "queue" << "name";
+    return interval_ > 0 && count_ != 0 && columns.contains(sort_);
+}
+
+bool SensordStat::start()
+{
+    manager_ = new QDBusInterface(SERVICE_NAME, OBJECT_PATH, MANAGER_INTERFACE, QDBusConnection::systemBus());
+    if (!manager_->isValid()) {
+        qWarning() << "sensord is not reachable:" << manager_->lastError().message();
+        return false;
+    }
+
+    // Enabling resets the counters only when they were off.
+    QDBusReply<void> reply = manager_->call("setNodeStatisticsEnabled", !off_);
+    if (!reply.isValid()) {
+        qWarning() << "Failed to toggle node statistics:" << reply.error().message();
+        return false;
+    }
+    if (off_) {
+        QTimer::singleShot(0, this, SIGNAL(finished()));
+        return true;
+    }
+
+    refresh();
+    timer_.start(interval_);
+    return true;
+}
+
+QString SensordStat::row(const StatLine& current, const StatLine* previous, double seconds, double& sortKey) const
+{
+    // Counters restart when a node is recreated or counting re-enabled.
+    bool delta = previous && previous->out <= current.out && previous->drops <= current.drops;
+    unsigned long long out = current.out - (delta ? previous->out : 0);
+    unsigned long long drops = current.drops - (delta ? previous->drops : 0);
+    QVector<unsigned long long> histogram(StatLine::BUCKETS, 0);
+    double cpuUs = 0;
+    for (int i = 0; i < StatLine::BUCKETS; ++i) {
+        unsigned long long before = delta ? previous->histogram.at(i) : 0;
+        histogram[i] = current.histogram.at(i) >= before ? current.histogram.at(i) - before : current.histogram.at(i);
+        cpuUs += histogram.at(i) * bucketTime(i);
+    }
+
+    double rate = seconds > 0 ? out / seconds : 0;
+    double dropRate = seconds > 0 ? drops / seconds : 0;
+    double cpu = seconds > 0 ? cpuUs / seconds / 1000 : 0;
+    QString queue = current.session
+        ? QString("%1/%2B").arg(current.queue).arg(current.socketBytes)
+        : (current.queuePeak ? QString("%1/%2").arg(current.queue).arg(current.queuePeak) : QString("-"));
+
+    if (sort_ == "rate")
+        sortKey = rate;
+    else if (sort_ == "drops")
+        sortKey = dropRate;
+    else if (sort_ == "queue")
+        sortKey = current.session ? current.queue + current.socketBytes : current.queue;
+    else
+        sortKey = cpu;
+
+    return QString("%1 %2 %3 %4 %5 %6 %7 %8")
+        .arg(current.name.left(44), -44)
+        .arg(QString::number(rate, 'f', 1), 9)
+        .arg(current.rate > 0 ? QString::number(current.rate, 'f', 1) : QString("-"), 8)
+        .arg(QString::number(dropRate, 'f', 1), 8)
+        .arg(queue, 11)
+        .arg(QString::number(cpu, 'f', 2), 9)
+        .arg(percentile(histogram, 50), 7)
+        .arg(percentile(histogram, 99), 7);
+}
+
+void SensordStat::refresh()
+{
+    QDBusReply<QStringList> reply = manager_->call("nodeStatistics");
+    if (!reply.isValid()) {
+        qWarning() << "Failed to fetch statistics:" << reply.error().message();
+        return;
+    }
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    double seconds = fetched_ ? (now - fetched_) / 1000.0 : 0;
+
+    QHash<QString, StatLine> current;
+    QMultiMap<double, QString> rows;
+    QStringList names;
+    foreach (const QString& line, reply.value()) {
+        StatLine stat;
+        if (!stat.parse(line) || (!filter_.isEmpty() && !stat.name.contains(filter_)))
+            continue;
+        current.insert(stat.name, stat);
+        QHash<QString, StatLine>::const_iterator previous = previous_.constFind(stat.name);
+        double key = 0;
+        QString text = row(stat, previous != previous_.constEnd() ? &previous.value() : NULL, seconds, key);
+        if (sort_ == "name")
+            names << text;
+        else
+            rows.insert(key, text);
+    }
+    previous_ = current;
+    fetched_ = now;
+
+    QTextStream out(stdout);
+    if (!batch_)
+        out << "\033[H\033[2J";
+    out << "sensord pipeline, " << current.size() << " nodes and sessions, "
+        << (seconds > 0 ? QString("last %1 s").arg(seconds, 0, 'f', 1) : QString("totals since enabled")) << "\n"
+        << QString("%1 %2 %3 %4 %5 %6 %7 %8\n")
+           .arg("NODE", -44).arg("OUT/s", 9).arg("DEV Hz", 8).arg("DROPS/s", 8)
+           .arg("QUEUE", 11).arg("CPU ms/s", 9).arg("P50 us", 7).arg("P99 us", 7);
+    if (sort_ == "name") {
+        names.sort();
+        foreach (const QString& text, names)
+            out << text << "\n";
+    } else {
+        QMapIterator<double, QString> it(rows);
+        it.toBack();
+        while (it.hasPrevious())
+            out << it.previous().value() << "\n";
+    }
+    out << "\n";
+    out.flush();
+
+    if (count_ > 0 && --count_ == 0) {
+        timer_.stop();
+        emit finished();
+    }
+}
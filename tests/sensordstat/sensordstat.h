@@ -0,0 +1,141 @@
+/**
+   @file sensordstat.h
+   @brief Live pipeline statistics of sensord
+
+   <p>
+   Copyright (C) 2013 Jolla Ltd
+
+   This file is part of Sensord.
+
+   Sensord is free software; you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License
+   version 2.1 as published by the Free Software Foundation.
+
+   Sensord is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with Sensord.  If not, see <http://www.gnu.org/licenses/>.
+   </p>
+*/
+
+#ifndef SENSORDSTAT_H
+#define SENSORDSTAT_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QTimer>
+#include <QVector>
+
+class QDBusInterface;
+
+/**
+ * Counters of one node or session parsed from a statistics line of
+ * SensorManager::nodeStatistics().
+ */
+struct StatLine
+{
+    StatLine();
+
+    /**
+     * Number of processing time buckets, see NodeStatistics::BUCKETS.
+     */
+    static const int BUCKETS = 16;
+
+    /**
+     * Parse a line. Node lines look like
+     * <tt>name: in 10, out 10, drops 0, queue 1 peak 3, time us <2:4 <4:6, rate 50.0 Hz, ...</tt>
+     * and session lines like
+     * <tt>sensor/session 5: out 10, drops 0, queue 0, socket bytes 0, congested 0, client 123</tt>.
+     *
+     * @param line statistics line.
+     * @return was the line a node or session line.
+     */
+    bool parse(const QString& line);
+
+    QString            name;        /**< node or session name */
+    bool               session;     /**< is this a session */
+    unsigned long long in;          /**< samples in */
+    unsigned long long out;         /**< samples out */
+    unsigned long long drops;       /**< samples dropped */
+    unsigned int       queue;       /**< latest queue depth */
+    unsigned int       queuePeak;   /**< largest queue depth */
+    unsigned long long socketBytes; /**< bytes waiting in the session socket */
+    double             rate;        /**< measured device rate in Hz, 0 if not known */
+    QVector<unsigned long long> histogram; /**< processing times */
+};
+
+/**
+ * Polls the statistics of sensord and shows per adaptor buffer, filter,
+ * chain, channel and session the output rate, drops, queue depth,
+ * estimated CPU time and processing time percentiles over each refresh
+ * interval. Counting is enabled in sensord when the tool starts.
+ *
+ * <pre>
+ * sensordstat [--interval=MS] [--count=N] [--sort=cpu|rate|drops|queue|name]
+ *             [--filter=TEXT] [--batch] [--off]
+ * </pre>
+ */
+class SensordStat : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * Constructor.
+     *
+     * @param parent parent object.
+     */
+    SensordStat(QObject* parent = 0);
+
+    /**
+     * Destructor.
+     */
+    ~SensordStat();
+
+    /**
+     * Parse command line options.
+     *
+     * @param arguments command line arguments.
+     * @return were the options valid.
+     */
+    bool parse(const QStringList& arguments);
+
+    /**
+     * Connect to sensord and start polling.
+     *
+     * @return was sensord reachable.
+     */
+    bool start();
+
+Q_SIGNALS:
+    /**
+     * Emitted when the requested number of refreshes is done.
+     */
+    void finished();
+
+private Q_SLOTS:
+    /**
+     * Fetch statistics and show the difference to the previous fetch.
+     */
+    void refresh();
+
+private:
+    QString row(const StatLine& current, const StatLine* previous, double seconds, double& sortKey) const;
+
+    QDBusInterface*          manager_;  /**< SensorManager of sensord */
+    QTimer                   timer_;    /**< refresh timer */
+    int                      interval_; /**< refresh interval in milliseconds */
+    int                      count_;    /**< refreshes left, negative for no limit */
+    QString                  sort_;     /**< sort column */
+    QString                  filter_;   /**< shown names must contain this */
+    bool                     batch_;    /**< append instead of redrawing the screen */
+    bool                     off_;      /**< only turn counting off */
+    QHash<QString, StatLine> previous_; /**< lines of the previous fetch */
+    qint64                   fetched_;  /**< time of the previous fetch, ms */
+};
+
+#endif
@@ -0,0 +1,11 @@
+QT += dbus
+QT -= gui
+
+include(../common-install.pri)
+
+TEMPLATE = app
+TARGET = sensordstat
+HEADERS += sensordstat.h
+SOURCES += main.cpp \
+           sensordstat.cpp
+INCLUDEPATH += ../../include
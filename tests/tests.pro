@@ -12,7 +12,8 @@ SUBDIRS = filters\
           deadclient \
           powermanagement \
           metadata \
-          external
+          external \
+          sensordstat
 contextprovider {
     SUBDIRS += contextfw
 }